@@ -2,15 +2,17 @@
 #define GBUFFER_HLSL
 
 #include "Library/Common.hlsli"
+#include "Library/PackedVertex.hlsli"
+#include "Library/Bindless.hlsli"
 
-Texture2D BaseTexture   : register(t5);
-Texture2D MRATexture    : register(t6);
-Texture2D NormalTexture : register(t7);
-
-SamplerState BaseTextureSampler     : register(s5);
-SamplerState MRATextureSampler      : register(s6);
-SamplerState NormalTextureSampler   : register(s7);
-
+#if USE_PACKED_VERTEX
+struct VSInput
+{
+    float4 positionOS       : POSITION;
+    float4 normalTangentOS  : NORMAL;
+    float2 texCoord         : TEXCOORD;
+};
+#else
 struct VSInput
 {
     float4 positionOS   : POSITION;
@@ -19,6 +21,7 @@ struct VSInput
     float2 texCoord     : TEXCOORD;
     float4 color        : COLOR;
 };
+#endif
 
 struct PSInput
 {
@@ -35,16 +38,27 @@ PSInput VSMain(VSInput input)
 {
     PSInput result;
 
-    input.positionOS.w = 1;
-    result.positionWS = mul(ObjectToWorldMatrix, input.positionOS);
+#if USE_PACKED_VERTEX
+    float4 positionOS = float4(DequantizePosition(input.positionOS.xyz, PositionScale, PositionOffset), 1);
+    float3 normalOS = DecodeOctahedral(input.normalTangentOS.xy);
+    float4 tangentOS = float4(DecodeOctahedral(input.normalTangentOS.zw), input.positionOS.w);
+    float4 color = 1;
+#else
+    float4 positionOS = float4(input.positionOS.xyz, 1);
+    float3 normalOS = input.normalOS;
+    float4 tangentOS = input.tangentOS;
+    float4 color = input.color;
+#endif
+
+    result.positionWS = mul(ObjectToWorldMatrix, positionOS);
     result.positionCS = mul(WorldToProjectionMatrix, result.positionWS);
     result.texCoord = input.texCoord;
 
-    result.normalWS = normalize(GetWorldSpaceNormal(input.normalOS));
-    result.tangentWS = float4(normalize(GetWorldSpaceTangent(input.tangentOS.xyz)), input.tangentOS.w);
+    result.normalWS = normalize(GetWorldSpaceNormal(normalOS));
+    result.tangentWS = float4(normalize(GetWorldSpaceTangent(tangentOS.xyz)), tangentOS.w);
     result.viewDirWS = normalize(GetWorldSpaceViewDir(result.positionWS));
 
-    result.color = input.color;
+    result.color = color;
 
     return result;
 }
@@ -55,10 +69,13 @@ void PSMain(PSInput input,
     out float4 GBuffer2 : SV_TARGET2,
     out float4 GBuffer3 : SV_TARGET3)
 {
-    GBuffer0 = BaseTexture.Sample(BaseTextureSampler, input.texCoord);
-    GBuffer1 = MRATexture.Sample(MRATextureSampler, input.texCoord);
+    GBuffer0 = SampleMaterialTexture(BASE_TEXTURE_SLOT, input.texCoord);
+    GBuffer1 = SampleMaterialTexture(MRA_TEXTURE_SLOT, input.texCoord);
 
-    float3 normalTS = NormalTexture.Sample(NormalTextureSampler, input.texCoord).xyz * 2.0f - 1.0f;
+    // Normal maps are cooked to two channels, rebuild z from x and y.
+    float3 normalTS;
+    normalTS.xy = SampleMaterialTexture(NORMAL_TEXTURE_SLOT, input.texCoord).xy * 2.0f - 1.0f;
+    normalTS.z = sqrt(saturate(1.0f - dot(normalTS.xy, normalTS.xy)));
     float sgn = input.tangentWS.w > 0.0f ? 1.0f : -1.0f;
     float3 bitangentWS = sgn * cross(input.normalWS.xyz, input.tangentWS.xyz);
     float3 normalWS = mul(normalTS, float3x3(input.tangentWS.xyz, bitangentWS.xyz, input.normalWS.xyz));
@@ -0,0 +1,31 @@
+#ifndef BINDLESS_HLSLI
+#define BINDLESS_HLSLI
+
+// The texture slots of the descriptor heap, and the samplers, which textures with the same sampler share.
+Texture2D BindlessTextures[] : register(t0, space1);
+TextureCube BindlessCubeTextures[] : register(t0, space2);
+SamplerState BindlessSamplers[] : register(s0, space1);
+
+// See MaterialConstant in SharedTypes.h.
+cbuffer MaterialConstants : register(b2)
+{
+    uint MaterialTextureID;
+    uint3 MaterialSamplerIDs;
+};
+
+// The textures of a lit material follow the slot of the material in this order.
+#define BASE_TEXTURE_SLOT 0
+#define MRA_TEXTURE_SLOT 1
+#define NORMAL_TEXTURE_SLOT 2
+
+inline float4 SampleMaterialTexture(uint slot, float2 texCoord)
+{
+    return BindlessTextures[MaterialTextureID + slot].Sample(BindlessSamplers[MaterialSamplerIDs[slot]], texCoord);
+}
+
+inline float4 SampleMaterialCubeTexture(float3 direction)
+{
+    return BindlessCubeTextures[MaterialTextureID].Sample(BindlessSamplers[MaterialSamplerIDs.x], direction);
+}
+
+#endif
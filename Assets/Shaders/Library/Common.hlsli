@@ -17,6 +17,8 @@ SamplerState StaticLinearClampSampler : register(s0);
 cbuffer PerObjectConstants : register(b1)
 {
     float4x4 ObjectToWorldMatrix;
+    float4 PositionScale;
+    float4 PositionOffset;
 };
 
 inline float3 GetWorldSpaceNormal(float3 normalOS)
@@ -0,0 +1,36 @@
+#ifndef PACKED_VERTEX_HLSLI
+#define PACKED_VERTEX_HLSLI
+
+#ifndef HLSL
+#define HLSL
+#endif
+
+#include "../../../Sources/Shared/SharedPrimitives.h"
+
+// Decoders of PackedVertex, see SharedTypes.h for the layout.
+inline float2 UnpackSnorm16x2(uint value)
+{
+    int2 signedValue = int2(value << 16, value) >> 16;
+    return max(signedValue / 32767.0f, -1.0f);
+}
+
+inline float2 UnpackHalf2(uint value)
+{
+    return f16tof32(uint2(value, value >> 16));
+}
+
+inline float3 DecodeOctahedral(float2 encoded)
+{
+    float3 direction = float3(encoded, 1.0f - abs(encoded.x) - abs(encoded.y));
+    float t = saturate(-direction.z);
+    direction.xy -= (step(0.0f, direction.xy) * 2.0f - 1.0f) * t;
+
+    return normalize(direction);
+}
+
+inline float3 DequantizePosition(float3 position, float4 scale, float4 offset)
+{
+    return position * scale.xyz + offset.xyz;
+}
+
+#endif
@@ -2,15 +2,17 @@
 #define LIT_HLSL
 
 #include "Library/Common.hlsli"
+#include "Library/PackedVertex.hlsli"
+#include "Library/Bindless.hlsli"
 
-Texture2D BaseTexture   : register(t5);
-Texture2D MRATexture    : register(t6);
-Texture2D NormalTexture : register(t7);
-
-SamplerState BaseTextureSampler     : register(s5);
-SamplerState MRATextureSampler      : register(s6);
-SamplerState NormalTextureSampler   : register(s7);
-
+#if USE_PACKED_VERTEX
+struct VSInput
+{
+    float4 positionOS       : POSITION;
+    float4 normalTangentOS  : NORMAL;
+    float2 texCoord         : TEXCOORD;
+};
+#else
 struct VSInput
 {
     float4 positionOS   : POSITION;
@@ -19,6 +21,7 @@ struct VSInput
     float2 texCoord     : TEXCOORD;
     float4 color        : COLOR;
 };
+#endif
 
 struct PSInput
 {
@@ -35,32 +38,46 @@ PSInput VSMain(VSInput input)
 {
     PSInput result;
 
-    input.positionOS.w = 1;
-    result.positionWS = mul(ObjectToWorldMatrix, input.positionOS);
+#if USE_PACKED_VERTEX
+    float4 positionOS = float4(DequantizePosition(input.positionOS.xyz, PositionScale, PositionOffset), 1);
+    float3 normalOS = DecodeOctahedral(input.normalTangentOS.xy);
+    float4 tangentOS = float4(DecodeOctahedral(input.normalTangentOS.zw), input.positionOS.w);
+    float4 color = 1;
+#else
+    float4 positionOS = float4(input.positionOS.xyz, 1);
+    float3 normalOS = input.normalOS;
+    float4 tangentOS = input.tangentOS;
+    float4 color = input.color;
+#endif
+
+    result.positionWS = mul(ObjectToWorldMatrix, positionOS);
     result.positionCS = mul(WorldToProjectionMatrix, result.positionWS);
     result.texCoord = input.texCoord;
 
-    result.normalWS = normalize(GetWorldSpaceNormal(input.normalOS));
-    result.tangentWS = float4(normalize(GetWorldSpaceTangent(input.tangentOS.xyz)), input.tangentOS.w);
+    result.normalWS = normalize(GetWorldSpaceNormal(normalOS));
+    result.tangentWS = float4(normalize(GetWorldSpaceTangent(tangentOS.xyz)), tangentOS.w);
     result.viewDirWS = normalize(GetWorldSpaceViewDir(result.positionWS));
 
-    result.color = input.color;
+    result.color = color;
 
     return result;
 }
 
 float4 PSMain(PSInput input) : SV_TARGET
 {
-    float3 normalTS = NormalTexture.Sample(NormalTextureSampler, input.texCoord).xyz * 2.0f - 1.0f;
+    // Normal maps are cooked to two channels, rebuild z from x and y.
+    float3 normalTS;
+    normalTS.xy = SampleMaterialTexture(NORMAL_TEXTURE_SLOT, input.texCoord).xy * 2.0f - 1.0f;
+    normalTS.z = sqrt(saturate(1.0f - dot(normalTS.xy, normalTS.xy)));
 
     float sgn = input.tangentWS.w > 0.0f ? -1.0f : 1.0f;
     float3 bitangentWS = sgn * cross(input.normalWS.xyz, input.tangentWS.xyz);
     float3 normalWS = mul(normalTS, float3x3(input.tangentWS.xyz, bitangentWS.xyz, input.normalWS.xyz));
 
-    float roughness = MRATexture.Sample(MRATextureSampler, input.texCoord).g;
+    float roughness = SampleMaterialTexture(MRA_TEXTURE_SLOT, input.texCoord).g;
     float roughness2 = roughness * roughness;
 
-    float3 diffuse = BaseTexture.Sample(BaseTextureSampler, input.texCoord).rgb;
+    float3 diffuse = SampleMaterialTexture(BASE_TEXTURE_SLOT, input.texCoord).rgb;
     float3 specular = diffuse;
 
     float3 lightDirWS = float3(1.0f, 1.0f, 0.0f);
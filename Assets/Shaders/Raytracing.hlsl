@@ -5,6 +5,7 @@
 
 #include "Library/CommonRayTracing.hlsli"
 #include "Library/Random.hlsli"
+#include "Library/PackedVertex.hlsli"
 #include "../../Sources/Shared/SharedPrimitives.h"
 #include "../../Sources/Shared/SharedTypes.h"
 #include "../../Sources/Shared/SharedConstants.h"
@@ -12,13 +13,40 @@
 RaytracingAccelerationStructure Scene : register(t0);
 RWTexture2D<float4> Result : register(u0);
 
-StructuredBuffer<uint16_t> Indices : register(t1);
-StructuredBuffer<Vertex> Vertices : register(t2);
-StructuredBuffer<uint> Offsets : register(t3);
+StructuredBuffer<uint> Indices : register(t1);
+StructuredBuffer<SceneVertex> Vertices : register(t2);
+StructuredBuffer<uint2> Offsets : register(t3); // The first index and the first vertex of each geometry.
 
 TextureCube SkyboxCube  : register(t4);
 Texture2D DepthTexture : register(t5);
 
+// Get the vertex ids of the hit triangle through the index buffer.
+uint3 GetTriangleVertexIds()
+{
+    uint2 offset = Offsets[GeometryIndex()];
+    uint indexId = 3 * PrimitiveIndex() + offset.x;
+
+    return uint3(Indices[indexId], Indices[indexId + 1], Indices[indexId + 2]) + offset.y;
+}
+
+float3 GetVertexNormalOS(uint vertexId)
+{
+#if USE_PACKED_VERTEX
+    return DecodeOctahedral(UnpackSnorm16x2(Vertices[vertexId].normalTangentOS[0]));
+#else
+    return Vertices[vertexId].normalOS;
+#endif
+}
+
+float2 GetVertexTexCoord(uint vertexId)
+{
+#if USE_PACKED_VERTEX
+    return UnpackHalf2(Vertices[vertexId].texCoord);
+#else
+    return Vertices[vertexId].texCoord;
+#endif
+}
+
 RayPayload TraceRadianceRay(float3 origin, float3 direction, in uint currentRayRecursionDepth)
 {
     RayPayload payload =
@@ -139,15 +167,15 @@ void ClosestHitShader(inout RayPayload payload, in BuiltInTriangleIntersectionAt
 {
     payload.depth += 1;
     float3 barycentrics = GetBarycentrics(attr.barycentrics);
-    uint vertId = 3 * PrimitiveIndex() + Offsets[GeometryIndex()];
+    uint3 vertIds = GetTriangleVertexIds();
 
     float3 hitPosition = HitWorldPosition();
-    float3 normalOS = Vertices[vertId + 0].normalOS * barycentrics.x +
-        Vertices[vertId + 1].normalOS * barycentrics.y +
-        Vertices[vertId + 2].normalOS * barycentrics.z;
-    float2 uv = Vertices[vertId + 0].texCoord * barycentrics.x +
-        Vertices[vertId + 1].texCoord * barycentrics.y +
-        Vertices[vertId + 2].texCoord * barycentrics.z;
+    float3 normalOS = GetVertexNormalOS(vertIds.x) * barycentrics.x +
+        GetVertexNormalOS(vertIds.y) * barycentrics.y +
+        GetVertexNormalOS(vertIds.z) * barycentrics.z;
+    float2 uv = GetVertexTexCoord(vertIds.x) * barycentrics.x +
+        GetVertexTexCoord(vertIds.y) * barycentrics.y +
+        GetVertexTexCoord(vertIds.z) * barycentrics.z;
 
     const float3 lightDirWS = float3(1.0f, 1.0f, 0.0f);
 
@@ -198,15 +226,15 @@ void GIClosestHitShader(inout GIRayPayload payload, in BuiltInTriangleIntersecti
 {
     payload.depth += 1;
     float3 barycentrics = GetBarycentrics(attr.barycentrics);
-    uint vertId = 3 * PrimitiveIndex() + Offsets[GeometryIndex()];
+    uint3 vertIds = GetTriangleVertexIds();
 
     float4 hitPosition = float4(HitWorldPosition(), 1.0f);
-    float3 normalOS = Vertices[vertId + 0].normalOS * barycentrics.x +
-        Vertices[vertId + 1].normalOS * barycentrics.y +
-        Vertices[vertId + 2].normalOS * barycentrics.z;
-    float2 uv = Vertices[vertId + 0].texCoord * barycentrics.x +
-        Vertices[vertId + 1].texCoord * barycentrics.y +
-        Vertices[vertId + 2].texCoord * barycentrics.z;
+    float3 normalOS = GetVertexNormalOS(vertIds.x) * barycentrics.x +
+        GetVertexNormalOS(vertIds.y) * barycentrics.y +
+        GetVertexNormalOS(vertIds.z) * barycentrics.z;
+    float2 uv = GetVertexTexCoord(vertIds.x) * barycentrics.x +
+        GetVertexTexCoord(vertIds.y) * barycentrics.y +
+        GetVertexTexCoord(vertIds.z) * barycentrics.z;
 
     float4 positionCS = mul(WorldToProjectionMatrix, hitPosition);
     float3 positionNDC = positionCS.xyz / positionCS.w;
@@ -2,9 +2,7 @@
 #define SKYBOX_HLSL
 
 #include "Library/Common.hlsli"
-
-TextureCube SkyboxCube : register(t5);
-SamplerState SkyboxSampler : register(s5);
+#include "Library/Bindless.hlsli"
 
 struct VSInput
 {
@@ -30,7 +28,7 @@ PSInput VSMain(VSInput input)
 
 float4 PSMain(PSInput input) : SV_TARGET
 {
-    return SkyboxCube.Sample(SkyboxSampler, input.texCoord);
+    return SampleMaterialCubeTexture(input.texCoord);
 }
 
 #endif
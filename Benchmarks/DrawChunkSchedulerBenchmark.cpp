@@ -0,0 +1,82 @@
+#include "stdafx.h"
+#include "DrawChunkScheduler.h"
+#include "TestHelper.h"
+
+// The CPU time to record a pass of 1k, 10k and 100k draws, split as DrawRecorder splits them, on one thread,
+// four and one per hardware thread of a job system. Recording a draw stands in for the commands written and
+// the per draw work, such as culling the meshlets of the model.
+// Usage: DrawChunkSchedulerBenchmark [passes at 1k draws, fewer for more draws]
+namespace
+{
+    typedef std::chrono::high_resolution_clock Clock;
+
+    const UINT kChunksPerThread = 2;
+    const UINT64 kMinChunkCost = 128;
+    const UINT kWarmUpPassesNum = 5;
+
+    void RecordDraw(std::vector<UINT64>& commands, UINT draw)
+    {
+        FLOAT cost = 0.0f;
+        for (UINT i = 0; i < 64; i++)
+        {
+            cost += static_cast<FLOAT>((draw * 2654435761u + i) & 1023) * 0.001f;
+        }
+        const UINT64 drawCommands[] = { draw, 1, 2, 3, static_cast<UINT64>(cost), 5 };
+        commands.insert(commands.end(), drawCommands, drawCommands + 6);
+    }
+
+    double GetMicroseconds(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const UINT passesNum = max(argc > 1 ? static_cast<UINT>(atoi(argv[1])) : 200, 1u);
+    std::vector<UINT> threadCounts = { 1, 4 };
+    const UINT hardwareThreadCount = max(std::thread::hardware_concurrency(), 1u);
+    if (std::find(threadCounts.begin(), threadCounts.end(), hardwareThreadCount) == threadCounts.end())
+    {
+        threadCounts.push_back(hardwareThreadCount);
+    }
+
+    for (UINT drawsNum : { 1000u, 10000u, 100000u })
+    {
+        const std::vector<UINT> costs(drawsNum, 1);
+        const UINT drawsPassesNum = max(passesNum * 1000 / drawsNum, 10u);
+        for (UINT threadCount : threadCounts)
+        {
+            // One thread records the pass as a single chunk, on the calling thread.
+            JobSystem jobSystem(max(threadCount - 1, 1u));
+            DrawChunkScheduler scheduler(&jobSystem);
+            std::vector<DrawChunk> chunks;
+            std::vector<std::vector<UINT64>> commandLists(threadCount * kChunksPerThread);
+            double recordingTime = 0.0;
+            for (UINT i = 0; i < drawsPassesNum + kWarmUpPassesNum; i++)
+            {
+                Clock::time_point start = Clock::now();
+                DrawChunkScheduler::Split(costs.data(), drawsNum, threadCount > 1 ? threadCount * kChunksPerThread : 1,
+                    kMinChunkCost, chunks);
+                scheduler.Run(static_cast<UINT>(chunks.size()), [&chunks, &commandLists](UINT, UINT chunk)
+                {
+                    std::vector<UINT64>& commands = commandLists[chunk];
+                    commands.clear();
+                    for (UINT draw = chunks[chunk].begin; draw < chunks[chunk].end; draw++)
+                    {
+                        RecordDraw(commands, draw);
+                    }
+                });
+                if (i >= kWarmUpPassesNum)
+                {
+                    recordingTime += GetMicroseconds(start);
+                }
+            }
+
+            printf("%6u draws, %2u threads: %8.1f us per pass in %2u chunks\n", drawsNum, threadCount,
+                recordingTime / drawsPassesNum, static_cast<UINT>(chunks.size()));
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,74 @@
+#include "stdafx.h"
+#include "FBXImportPool.h"
+#include "TestHelper.h"
+
+// Scaling of FBXImportPool with its thread count: the meshes of the sample scene, copies times over, each
+// imported and cooked as the engine does when the mesh cache misses, on 1, 2, 4... threads up to the largest
+// count. Every thread count runs with importers of its own, so the SDK setup of the threads is included.
+// Only built where the FBX SDK is found.
+// Usage: FBXImportPoolBenchmark [copies] [largest thread count, 0 for one per hardware thread]
+namespace
+{
+    typedef std::chrono::high_resolution_clock Clock;
+
+    const LPCWSTR kMeshNames[] = { L"ground.fbx", L"plane.fbx", L"test.fbx", L"wall.fbx" };
+
+    double GetMilliseconds(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const UINT copiesNum = max(argc > 1 ? static_cast<UINT>(atoi(argv[1])) : 8, 1u);
+    UINT maxThreadCount = argc > 2 ? static_cast<UINT>(atoi(argv[2])) : 0;
+    if (maxThreadCount == 0)
+    {
+        maxThreadCount = max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    std::vector<std::wstring> paths;
+    for (UINT i = 0; i < copiesNum; i++)
+    {
+        for (LPCWSTR meshName : kMeshNames)
+        {
+            paths.push_back(GetAssetPath(meshName));
+        }
+    }
+    const UINT meshesNum = static_cast<UINT>(paths.size());
+
+    printf("%u meshes, %u hardware threads\n", meshesNum, std::thread::hardware_concurrency());
+    double singleThreadTime = 0.0;
+    for (UINT threadCount = 1; ; threadCount = min(threadCount * 2, maxThreadCount))
+    {
+        std::vector<UINT64> indicesSizes(meshesNum);
+        Clock::time_point start = Clock::now();
+        FBXImportPool pool(threadCount);
+        pool.Run(meshesNum, [&paths, &indicesSizes](unique_ptr<FBXImporter>& importer, UINT i)
+        {
+            MeshData mesh;
+            CHECK(importer->ImportFBX(paths[i]));
+            importer->LoadFBX(&mesh);
+            indicesSizes[i] = mesh.GetIndicesSize();
+        });
+        const double time = GetMilliseconds(start);
+        singleThreadTime = threadCount == 1 ? time : singleThreadTime;
+
+        // Every copy of a mesh cooks to the same size, whichever thread imported it.
+        for (UINT i = static_cast<UINT>(_countof(kMeshNames)); i < meshesNum; i++)
+        {
+            CHECK(indicesSizes[i] == indicesSizes[i % _countof(kMeshNames)]);
+        }
+
+        printf("%2u threads %10.2f ms  %7.1f meshes/s  %4.2fx\n", threadCount, time,
+            meshesNum / time * 1000.0, singleThreadTime / time);
+
+        if (threadCount == maxThreadCount)
+        {
+            break;
+        }
+    }
+
+    return 0;
+}
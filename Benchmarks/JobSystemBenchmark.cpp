@@ -0,0 +1,95 @@
+#include "stdafx.h"
+#include "JobSystem.h"
+#include "TestHelper.h"
+#include <future>
+
+// The cost of a job against a task of std::async, and ParallelFor against a serial loop over 2k, 20k and
+// 200k transforms, each a few dozen multiply-adds, as SceneManager::UpdateTransforms runs them.
+// Usage: JobSystemBenchmark [workers, 0 for one per hardware thread but one]
+namespace
+{
+    typedef std::chrono::high_resolution_clock Clock;
+
+    const UINT kJobsNum = 200000;
+    const UINT kChildJobsNum = 1000;
+    const UINT kAsyncTasksNum = 20000;
+    const UINT kMinRangeSize = 256;
+
+    volatile FLOAT sResult;
+
+    void UpdateTransforms(std::vector<FLOAT>& transforms, UINT begin, UINT end)
+    {
+        for (UINT i = begin; i < end; i++)
+        {
+            FLOAT transform = transforms[i];
+            for (UINT j = 0; j < 64; j++)
+            {
+                transform = transform * 0.999f + 0.001f;
+            }
+            transforms[i] = transform;
+        }
+    }
+
+    double GetMicroseconds(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const UINT workerCount = argc > 1 ? static_cast<UINT>(atoi(argv[1])) : 0;
+    JobSystem jobSystem(workerCount);
+    printf("%u threads\n", jobSystem.GetThreadCount());
+
+    // Empty jobs, as the children of a root job that is waited for.
+    Clock::time_point start = Clock::now();
+    for (UINT i = 0; i < kJobsNum; i += kChildJobsNum)
+    {
+        Job* pRoot = jobSystem.CreateJob(nullptr);
+        for (UINT j = 0; j < kChildJobsNum; j++)
+        {
+            jobSystem.Run(jobSystem.CreateChildJob(pRoot, [](UINT) {}));
+        }
+        jobSystem.Run(pRoot);
+        jobSystem.Wait(pRoot);
+    }
+    printf("job:        %8.3f us\n", GetMicroseconds(start) / kJobsNum);
+
+    start = Clock::now();
+    for (UINT i = 0; i < kAsyncTasksNum; i++)
+    {
+        std::async(std::launch::async, []() {}).get();
+    }
+    printf("std::async: %8.3f us\n", GetMicroseconds(start) / kAsyncTasksNum);
+
+    for (UINT transformsNum : { 2000u, 20000u, 200000u })
+    {
+        std::vector<FLOAT> transforms(transformsNum, 1.0f);
+        const UINT passesNum = kJobsNum / transformsNum * 5;
+
+        start = Clock::now();
+        for (UINT i = 0; i < passesNum; i++)
+        {
+            UpdateTransforms(transforms, 0, transformsNum);
+        }
+        const double serialTime = GetMicroseconds(start) / passesNum;
+
+        const UINT64 stealsNum = jobSystem.GetStealsNum();
+        start = Clock::now();
+        for (UINT i = 0; i < passesNum; i++)
+        {
+            jobSystem.ParallelFor(transformsNum, kMinRangeSize, [&transforms](UINT, UINT begin, UINT end)
+            {
+                UpdateTransforms(transforms, begin, end);
+            });
+        }
+        const double parallelTime = GetMicroseconds(start) / passesNum;
+
+        printf("%6u transforms: serial %8.1f us, ParallelFor %8.1f us, %.1f steals per pass\n", transformsNum,
+            serialTime, parallelTime, static_cast<double>(jobSystem.GetStealsNum() - stealsNum) / passesNum);
+        sResult = transforms[transformsNum / 2];
+    }
+
+    return 0;
+}
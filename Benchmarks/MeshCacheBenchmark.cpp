@@ -0,0 +1,169 @@
+#include "stdafx.h"
+#include "MappedFile.h"
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "MeshletBuilder.h"
+#include "TestHelper.h"
+#if USE_FBX_SDK
+#include "FBXImporter.h"
+#endif
+
+// Startup time of a scene of grid meshes: cooking them the way the FBX importer does after parsing, loading
+// the cooked files with cold file pages, and loading them again with warm ones. Where the FBX SDK is found,
+// the meshes of the sample scene are also imported from FBX, as a model does when the cache misses, against
+// loading them from the files cooked from that import.
+// Usage: MeshCacheBenchmark [meshes] [grid size]
+namespace
+{
+    typedef std::chrono::high_resolution_clock Clock;
+
+    double GetMilliseconds(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    void RemoveFile(const std::wstring& path)
+    {
+#ifdef _WIN32
+        _wremove(path.c_str());
+#else
+        remove(MappedFile::ToUTF8(path).c_str());
+#endif
+    }
+
+    void Cook(MeshData& mesh, std::vector<Vertex>& vertices, std::vector<UINT>& indices)
+    {
+        const UINT verticesNum = static_cast<UINT>(vertices.size());
+        const UINT indicesNum = static_cast<UINT>(indices.size());
+        MeshOptimizer::OptimizeVertexCache(indices.data(), indicesNum, verticesNum);
+        MeshOptimizer::OptimizeOverdraw(indices.data(), indicesNum, vertices.data(), verticesNum, OVERDRAW_THRESHOLD);
+        MeshOptimizer::OptimizeVertexFetch(vertices.data(), indices.data(), indicesNum, verticesNum);
+
+        // The LODs follow LOD 0 in the same index buffer, each simplified from the one before.
+        std::vector<D3D12MeshLod> lods = { { 0, indicesNum, 0.0f } };
+        std::vector<UINT> lodIndices = indices;
+        std::vector<UINT> allIndices = indices;
+        for (FLOAT ratio : MESH_LOD_RATIOS)
+        {
+            std::vector<UINT> result;
+            const UINT targetNum = static_cast<UINT>(indicesNum * ratio) / 3 * 3;
+            const FLOAT error = MeshSimplifier::Simplify(vertices.data(), verticesNum,
+                lodIndices.data(), static_cast<UINT>(lodIndices.size()), targetNum, result);
+            MeshOptimizer::OptimizeVertexCache(result.data(), static_cast<UINT>(result.size()), verticesNum);
+            lods.push_back({ static_cast<UINT>(allIndices.size()), static_cast<UINT>(result.size()), error });
+            allIndices.insert(allIndices.end(), result.begin(), result.end());
+            lodIndices.swap(result);
+        }
+
+        mesh.SetVertices(vertices.data(), verticesNum * sizeof(Vertex));
+        mesh.SetIndices(allIndices.data(), static_cast<UINT>(allIndices.size() * sizeof(UINT)));
+        mesh.AddSubmesh({ 0, indicesNum, 0, verticesNum });
+        mesh.SetLods(lods.data(), static_cast<UINT>(lods.size()));
+        MeshletBuilder::BuildMeshlets(&mesh);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const UINT meshesNum = argc > 1 ? static_cast<UINT>(atoi(argv[1])) : 16;
+    const UINT gridSize = argc > 2 ? static_cast<UINT>(atoi(argv[2])) : 128;
+    const D3D12_RAYTRACING_AABB boundingBox = { -1.0f, -1.0f, 0.0f, 1.0f, 1.0f, 0.0f };
+
+    std::vector<std::wstring> paths;
+    for (UINT i = 0; i < meshesNum; i++)
+    {
+        paths.push_back(L"MeshCacheBenchmark" + std::to_wstring(i) + L".mesh");
+    }
+
+    Clock::time_point start = Clock::now();
+    UINT64 cacheSize = 0;
+    for (UINT i = 0; i < meshesNum; i++)
+    {
+        std::vector<Vertex> vertices;
+        std::vector<UINT> indices;
+        CreateGrid(gridSize, vertices, indices);
+
+        MeshData mesh;
+        Cook(mesh, vertices, indices);
+        CHECK(MeshCache::SaveMesh(paths[i], i + 1, &mesh, boundingBox));
+        cacheSize += mesh.GetVerticesSize() + mesh.GetIndicesSize();
+    }
+    const double cookTime = GetMilliseconds(start);
+
+    // Cold pages only drop where the platform allows it, see MappedFile::Evict.
+    for (const std::wstring& path : paths)
+    {
+        MappedFile::Evict(path);
+    }
+
+    double loadTimes[2] = {};
+    for (double& loadTime : loadTimes)
+    {
+        start = Clock::now();
+        for (UINT i = 0; i < meshesNum; i++)
+        {
+            MeshData mesh;
+            D3D12_RAYTRACING_AABB loadedBox = {};
+            CHECK(MeshCache::LoadMesh(paths[i], i + 1, &mesh, loadedBox));
+        }
+        loadTime = GetMilliseconds(start);
+    }
+
+    printf("%u meshes of %u triangles, %.1f MB cooked\n",
+        meshesNum, gridSize * gridSize * 2, cacheSize / (1024.0 * 1024.0));
+    printf("cook:           %10.2f ms\n", cookTime);
+    printf("load, cold:     %10.2f ms\n", loadTimes[0]);
+    printf("load, warm:     %10.2f ms\n", loadTimes[1]);
+
+    for (const std::wstring& path : paths)
+    {
+        RemoveFile(path);
+    }
+
+#if USE_FBX_SDK
+    const LPCWSTR fbxNames[] = { L"ground.fbx", L"plane.fbx", L"test.fbx", L"wall.fbx" };
+    unique_ptr<FBXImporter> importer = std::make_unique<FBXImporter>();
+    importer->InitializeSdkObjects();
+
+    double importTime = 0.0;
+    std::vector<std::wstring> fbxCachePaths;
+    for (LPCWSTR fbxName : fbxNames)
+    {
+        MeshData mesh;
+        start = Clock::now();
+        CHECK(importer->ImportFBX(GetAssetPath(fbxName)));
+        importer->LoadFBX(&mesh);
+        importTime += GetMilliseconds(start);
+
+        fbxCachePaths.push_back(L"MeshCacheBenchmark" + EraseSuffix(fbxName) + L".mesh");
+        CHECK(MeshCache::SaveMesh(fbxCachePaths.back(), 1, &mesh, mesh.ComputeBoundingBox()));
+        MappedFile::Evict(fbxCachePaths.back());
+    }
+
+    double fbxLoadTimes[2] = {};
+    for (double& loadTime : fbxLoadTimes)
+    {
+        start = Clock::now();
+        for (const std::wstring& path : fbxCachePaths)
+        {
+            MeshData mesh;
+            D3D12_RAYTRACING_AABB loadedBox = {};
+            CHECK(MeshCache::LoadMesh(path, 1, &mesh, loadedBox));
+        }
+        loadTime = GetMilliseconds(start);
+    }
+
+    printf("%u meshes of the sample scene\n", static_cast<UINT>(_countof(fbxNames)));
+    printf("FBX import:     %10.2f ms\n", importTime);
+    printf("load, cold:     %10.2f ms\n", fbxLoadTimes[0]);
+    printf("load, warm:     %10.2f ms\n", fbxLoadTimes[1]);
+
+    for (const std::wstring& path : fbxCachePaths)
+    {
+        RemoveFile(path);
+    }
+#endif
+
+    return 0;
+}
@@ -0,0 +1,148 @@
+#include "stdafx.h"
+#include "MeshletBuilder.h"
+#include "MeshOptimizer.h"
+#include "TestHelper.h"
+
+// The triangles meshlet culling rejects on a sphere seen from cameras around it, by the frustum and by the
+// normal cones, with the time to test a meshlet. Half the cameras look past the sphere, so the frustum cuts
+// part of it off. The sphere is cooked as the FBX importer cooks meshes, so the meshlets follow the vertex
+// cache order.
+// Usage: MeshletCullingBenchmark [grid size of the sphere] [cameras]
+namespace
+{
+    typedef std::chrono::high_resolution_clock Clock;
+
+    const FLOAT kHalfFieldOfView = XM_PI / 6.0f;
+    const FLOAT kNearZ = 0.1f;
+    const FLOAT kFarZ = 100.0f;
+
+    double GetNanoseconds(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    }
+
+    XMFLOAT4 GetPlane(FXMVECTOR normal, FXMVECTOR point, FLOAT offset)
+    {
+        const XMVECTOR unitNormal = XMVector3Normalize(normal);
+        XMFLOAT4 plane;
+        XMStoreFloat4(&plane, unitNormal);
+        plane.w = offset - XMVectorGetX(XMVector3Dot(unitNormal, point));
+        return plane;
+    }
+
+    // The inward facing planes of a square frustum at the position, looking along the forward direction.
+    void GetFrustumPlanes(FXMVECTOR position, FXMVECTOR forward, XMFLOAT4 planes[6])
+    {
+        const XMVECTOR up = fabsf(XMVectorGetY(forward)) < 0.99f ? XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f) : XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f);
+        const XMVECTOR right = XMVector3Normalize(XMVector3Cross(up, forward));
+        const XMVECTOR cameraUp = XMVector3Cross(forward, right);
+        const FLOAT s = sinf(kHalfFieldOfView);
+        const FLOAT c = cosf(kHalfFieldOfView);
+        planes[0] = GetPlane(forward * s + right * c, position, 0.0f);
+        planes[1] = GetPlane(forward * s - right * c, position, 0.0f);
+        planes[2] = GetPlane(forward * s + cameraUp * c, position, 0.0f);
+        planes[3] = GetPlane(forward * s - cameraUp * c, position, 0.0f);
+        planes[4] = GetPlane(forward, position, -kNearZ);
+        planes[5] = GetPlane(-forward, position, kFarZ);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const UINT gridSize = max(argc > 1 ? static_cast<UINT>(atoi(argv[1])) : 256, 2u);
+    const UINT camerasNum = max(argc > 2 ? static_cast<UINT>(atoi(argv[2])) : 64, 1u);
+
+    // Wrap the grid around a unit sphere, with the triangles facing out.
+    std::vector<Vertex> vertices;
+    std::vector<UINT> indices;
+    CreateGrid(gridSize, vertices, indices);
+    for (Vertex& vertex : vertices)
+    {
+        const FLOAT theta = vertex.texCoord.x * XM_PI * 2.0f;
+        const FLOAT phi = vertex.texCoord.y * XM_PI;
+        vertex.positionOS = XMFLOAT3(sinf(phi) * cosf(theta), -cosf(phi), sinf(phi) * sinf(theta));
+    }
+    for (UINT i = 0; i < indices.size(); i += 3)
+    {
+        std::swap(indices[i + 1], indices[i + 2]);
+    }
+    const UINT verticesNum = static_cast<UINT>(vertices.size());
+    const UINT indicesNum = static_cast<UINT>(indices.size());
+    MeshOptimizer::OptimizeVertexCache(indices.data(), indicesNum, verticesNum);
+    MeshOptimizer::OptimizeOverdraw(indices.data(), indicesNum, vertices.data(), verticesNum, OVERDRAW_THRESHOLD);
+
+    MeshData mesh;
+    mesh.SetVertices(vertices.data(), verticesNum * sizeof(Vertex));
+    mesh.SetIndices(indices.data(), indicesNum * sizeof(UINT));
+    mesh.AddSubmesh({ 0, indicesNum, 0, verticesNum });
+    const D3D12MeshLod lod = { 0, indicesNum, 0.0f };
+    mesh.SetLods(&lod, 1);
+    MeshletBuilder::BuildMeshlets(&mesh);
+    const std::vector<D3D12Meshlet>& meshlets = mesh.GetMeshlets();
+
+    std::mt19937 random(1);
+    std::uniform_real_distribution<FLOAT> distribution(-1.0f, 1.0f);
+    UINT64 trianglesNum = 0;
+    UINT64 frustumCulledNum = 0;
+    UINT64 coneCulledNum = 0;
+    double time = 0.0;
+    XMFLOAT4 allPlanes[6];
+    for (UINT i = 0; i < camerasNum; i++)
+    {
+        XMVECTOR direction;
+        do
+        {
+            direction = XMVectorSet(distribution(random), distribution(random), distribution(random), 0.0f);
+        } while (XMVectorGetX(XMVector3LengthSq(direction)) < 0.01f);
+        direction = XMVector3Normalize(direction);
+        const XMVECTOR position = XMVectorSetW(direction * 3.0f, 1.0f);
+        XMVECTOR forward = -direction;
+        if (i % 2 == 1)
+        {
+            const XMVECTOR side = XMVector3Normalize(XMVector3Cross(forward, XMVectorSet(0.3f, 1.0f, 0.2f, 0.0f)));
+            forward = XMVector3Normalize(forward + side * 0.5f);
+        }
+        XMFLOAT4 planes[6];
+        GetFrustumPlanes(position, forward, planes);
+        std::copy(planes, planes + 6, allPlanes);
+        for (UINT j = 0; j < 6; j++)
+        {
+            allPlanes[j].w = 100.0f;
+        }
+
+        Clock::time_point start = Clock::now();
+        UINT visibleTrianglesNum = 0;
+        for (const D3D12Meshlet& meshlet : meshlets)
+        {
+            if (MeshletBuilder::IsMeshletVisible(planes, XMVectorSetW(XMLoadFloat3(&meshlet.center), 1.0f),
+                meshlet.radius, XMLoadFloat3(&meshlet.coneAxis), meshlet.coneCutoff, position))
+            {
+                visibleTrianglesNum += meshlet.trianglesNum;
+            }
+        }
+        time += GetNanoseconds(start);
+
+        // The cones alone, against planes that hold the whole sphere.
+        UINT coneVisibleTrianglesNum = 0;
+        for (const D3D12Meshlet& meshlet : meshlets)
+        {
+            if (MeshletBuilder::IsMeshletVisible(allPlanes, XMVectorSetW(XMLoadFloat3(&meshlet.center), 1.0f),
+                meshlet.radius, XMLoadFloat3(&meshlet.coneAxis), meshlet.coneCutoff, position))
+            {
+                coneVisibleTrianglesNum += meshlet.trianglesNum;
+            }
+        }
+
+        trianglesNum += indicesNum / 3;
+        coneCulledNum += indicesNum / 3 - coneVisibleTrianglesNum;
+        frustumCulledNum += coneVisibleTrianglesNum - min(visibleTrianglesNum, coneVisibleTrianglesNum);
+    }
+
+    printf("%u triangles in %u meshlets, %u cameras\n", indicesNum / 3, static_cast<UINT>(meshlets.size()), camerasNum);
+    printf("rejected by the cones:   %5.1f%%\n", 100.0 * coneCulledNum / trianglesNum);
+    printf("rejected by the frustum: %5.1f%%\n", 100.0 * frustumCulledNum / trianglesNum);
+    printf("rejected in total:       %5.1f%%\n", 100.0 * (coneCulledNum + frustumCulledNum) / trianglesNum);
+    printf("%.1f ns per meshlet\n", time / (static_cast<double>(meshlets.size()) * camerasNum));
+
+    return 0;
+}
@@ -0,0 +1,72 @@
+#include "stdafx.h"
+#include "MipGenerator.h"
+#include "MipGeneratorReference.h"
+#include "TestHelper.h"
+
+// Mip chain generation of random images in each filter mode: the vectorized filters on one thread and on
+// all of them, against the per pixel reference, in megapixels read per second.
+// Usage: MipGeneratorBenchmark [size] [chains]
+namespace
+{
+    typedef std::chrono::high_resolution_clock Clock;
+
+    double GetSeconds(Clock::time_point start)
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const UINT size = max(argc > 1 ? static_cast<UINT>(atoi(argv[1])) : 2048, 1u);
+    const UINT chainsNum = max(argc > 2 ? static_cast<UINT>(atoi(argv[2])) : 6, 1u);
+    const UINT levelsNum = MipGenerator::GetMipLevelsNum(size, size);
+
+    std::mt19937 random(1);
+    std::vector<std::vector<BYTE>> levels(chainsNum * levelsNum);
+    std::vector<BYTE*> pLevels(chainsNum * levelsNum);
+    for (UINT i = 0; i < levels.size(); i++)
+    {
+        levels[i].resize(MipGenerator::GetLevelSize(size, size, i % levelsNum));
+        pLevels[i] = levels[i].data();
+    }
+    for (UINT chain = 0; chain < chainsNum; chain++)
+    {
+        for (BYTE& value : levels[chain * levelsNum])
+        {
+            value = static_cast<BYTE>(random());
+        }
+    }
+
+    // Every level reads the one above it.
+    double pixelsNum = 0.0;
+    for (UINT level = 1; level < levelsNum; level++)
+    {
+        pixelsNum += MipGenerator::GetLevelSize(size, size, level - 1) / 4.0 * chainsNum;
+    }
+
+    printf("%u chains of %ux%u, %u hardware threads\n", chainsNum, size, size, std::thread::hardware_concurrency());
+    const MipFilterMode modes[] = { MipFilterMode::Color, MipFilterMode::Linear, MipFilterMode::Normal };
+    const char* modeNames[] = { "Color", "Linear", "Normal" };
+    for (UINT i = 0; i < _countof(modes); i++)
+    {
+        Clock::time_point start = Clock::now();
+        MipGenerator::Generate(pLevels.data(), chainsNum, levelsNum, size, size, modes[i], nullptr, 1);
+        const double singleTime = GetSeconds(start);
+
+        start = Clock::now();
+        MipGenerator::Generate(pLevels.data(), chainsNum, levelsNum, size, size, modes[i]);
+        const double allTime = GetSeconds(start);
+
+        // The reference only filters the second level of the first chain, it is slow enough as it is.
+        std::vector<BYTE> reference(MipGenerator::GetLevelSize(size, size, 1));
+        start = Clock::now();
+        MipGeneratorReference::FilterLevel(pLevels[0], size, size, reference.data(), modes[i]);
+        const double referenceTime = GetSeconds(start);
+
+        printf("%-6s  1 thread %8.1f MPix/s  all threads %8.1f MPix/s  reference %6.1f MPix/s\n", modeNames[i],
+            pixelsNum / singleTime / 1e6, pixelsNum / allTime / 1e6, size * static_cast<double>(size) / referenceTime / 1e6);
+    }
+
+    return 0;
+}
@@ -0,0 +1,89 @@
+#include "stdafx.h"
+#include "PNGDecoder.h"
+#include "MappedFile.h"
+#include "TestHelper.h"
+
+// PNG decoding throughput on the textures of the sample scene, in megapixels written and megabytes of the
+// files read per second: each texture on its own on one thread, then all of them with ImageDecoder::DecodeAll
+// on 1, 2, 4... threads, as the texture loader decodes the slices of a texture. The files are mapped and
+// paged in first, so only the decoding is timed.
+// Usage: PNGDecoderBenchmark [repeats]
+namespace
+{
+    typedef std::chrono::high_resolution_clock Clock;
+
+    const LPCWSTR kTextureNames[] =
+    {
+        L"ground.png", L"ground_mra.png", L"ground_n.png",
+        L"test.png", L"test_mra.png", L"test_n.png",
+        L"wall.png", L"wall_mra.png", L"wall_n.png",
+    };
+
+    double GetSeconds(Clock::time_point start)
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const UINT repeatsNum = max(argc > 1 ? static_cast<UINT>(atoi(argv[1])) : 3, 1u);
+
+    std::vector<MappedFile> files(_countof(kTextureNames));
+    std::vector<std::vector<BYTE>> pixels(files.size());
+    std::vector<ImageDecodeJob> jobs;
+    double totalPixelsNum = 0.0;
+    double totalFileSize = 0.0;
+    for (UINT i = 0; i < files.size(); i++)
+    {
+        if (!files[i].Open(GetAssetPath(kTextureNames[i])))
+        {
+            fprintf(stderr, "Can not open %ls.\n", GetAssetPath(kTextureNames[i]).c_str());
+            return 1;
+        }
+        const ImageDecoder* pDecoder = ImageDecoder::GetDecoder(files[i].GetData(), files[i].GetSize());
+        ImageInfo info = {};
+        CHECK(pDecoder != nullptr && pDecoder->ReadInfo(files[i].GetData(), files[i].GetSize(), info));
+        pixels[i].resize(static_cast<size_t>(info.width) * info.height * 4);
+        jobs.push_back({ files[i].GetData(), files[i].GetSize(), pixels[i].data(), info.width * 4 });
+
+        // Decode once to page in the file and the destination, then keep the fastest of the repeats.
+        CHECK(pDecoder->Decode(files[i].GetData(), files[i].GetSize(), pixels[i].data(), info.width * 4));
+        double time = DBL_MAX;
+        for (UINT repeat = 0; repeat < repeatsNum; repeat++)
+        {
+            Clock::time_point start = Clock::now();
+            pDecoder->Decode(files[i].GetData(), files[i].GetSize(), pixels[i].data(), info.width * 4);
+            time = min(time, GetSeconds(start));
+        }
+
+        const double pixelsNum = static_cast<double>(info.width) * info.height;
+        totalPixelsNum += pixelsNum;
+        totalFileSize += static_cast<double>(files[i].GetSize());
+        printf("%-16ls %4ux%-4u %6.2f MB  %7.1f MPix/s  %6.1f MB/s\n", kTextureNames[i], info.width, info.height,
+            files[i].GetSize() / 1048576.0, pixelsNum / time / 1e6, files[i].GetSize() / 1048576.0 / time);
+    }
+
+    const UINT hardwareThreadsNum = max(std::thread::hardware_concurrency(), 1u);
+    printf("%u textures, %.1f MPix, %u hardware threads\n", static_cast<UINT>(files.size()), totalPixelsNum / 1e6,
+        hardwareThreadsNum);
+    for (UINT threadCount = 1; ; threadCount = min(threadCount * 2, hardwareThreadsNum))
+    {
+        double time = DBL_MAX;
+        for (UINT repeat = 0; repeat < repeatsNum; repeat++)
+        {
+            Clock::time_point start = Clock::now();
+            CHECK(ImageDecoder::DecodeAll(jobs.data(), static_cast<UINT>(jobs.size()), threadCount));
+            time = min(time, GetSeconds(start));
+        }
+        printf("DecodeAll %2u threads %8.2f ms  %7.1f MPix/s  %6.1f MB/s\n", threadCount, time * 1000.0,
+            totalPixelsNum / time / 1e6, totalFileSize / 1048576.0 / time);
+
+        if (threadCount == hardwareThreadsNum)
+        {
+            break;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,87 @@
+#include "stdafx.h"
+#include "RingAllocator.h"
+#include "TestHelper.h"
+
+// The per object constants of a frame: sub-allocated from a ring over one block that the frames in flight
+// share, against a separate heap allocation per object that is freed once its frame is done.
+// Usage: RingAllocatorBenchmark [objects] [frames]
+namespace
+{
+    typedef std::chrono::high_resolution_clock Clock;
+
+    const UINT kFramesInFlight = 3;
+    const UINT64 kConstantsAlignment = 256;
+
+    struct Constants
+    {
+        FLOAT objectToWorld[16];
+        FLOAT positionScale[4];
+        FLOAT positionOffset[4];
+    };
+
+    double GetNanoseconds(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const UINT objectsNum = max(argc > 1 ? static_cast<UINT>(atoi(argv[1])) : 100000, 1u);
+    const UINT framesNum = max(argc > 2 ? static_cast<UINT>(atoi(argv[2])) : 50, 1u);
+
+    Constants constants = {};
+    constants.objectToWorld[0] = constants.objectToWorld[5] = constants.objectToWorld[10] = constants.objectToWorld[15] = 1.0f;
+
+    // Room for the frames in flight and the one being recorded.
+    const UINT64 capacity = (kFramesInFlight + 1) * Align(sizeof(Constants), kConstantsAlignment) * objectsNum;
+    std::vector<BYTE> block(capacity);
+    RingAllocator ring(capacity);
+    double ringTime = 1e30;
+    for (UINT frame = 1; frame <= framesNum; frame++)
+    {
+        ring.Release(frame > kFramesInFlight ? frame - kFramesInFlight : 0);
+        Clock::time_point start = Clock::now();
+        for (UINT i = 0; i < objectsNum; i++)
+        {
+            UINT64 offset = 0;
+            CHECK(ring.Allocate(sizeof(Constants), kConstantsAlignment, offset));
+            memcpy(block.data() + offset, &constants, sizeof(Constants));
+        }
+        ring.Retire(frame);
+        ringTime = min(ringTime, GetNanoseconds(start) / objectsNum);
+    }
+
+    std::vector<std::vector<void*>> frameAllocations(kFramesInFlight);
+    double heapTime = 1e30;
+    for (UINT frame = 1; frame <= framesNum; frame++)
+    {
+        std::vector<void*>& allocations = frameAllocations[frame % kFramesInFlight];
+        Clock::time_point start = Clock::now();
+        for (void* pAllocation : allocations)
+        {
+            free(pAllocation);
+        }
+        allocations.clear();
+        for (UINT i = 0; i < objectsNum; i++)
+        {
+            void* pAllocation = malloc(Align(sizeof(Constants), kConstantsAlignment));
+            memcpy(pAllocation, &constants, sizeof(Constants));
+            allocations.push_back(pAllocation);
+        }
+        heapTime = min(heapTime, GetNanoseconds(start) / objectsNum);
+    }
+    for (std::vector<void*>& allocations : frameAllocations)
+    {
+        for (void* pAllocation : allocations)
+        {
+            free(pAllocation);
+        }
+    }
+
+    printf("%u objects, %u frames in flight\n", objectsNum, kFramesInFlight);
+    printf("ring:               %6.1f ns per object\n", ringTime);
+    printf("heap per object:    %6.1f ns per object\n", heapTime);
+
+    return 0;
+}
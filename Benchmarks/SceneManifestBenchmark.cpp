@@ -0,0 +1,144 @@
+#include "stdafx.h"
+#include "MappedFile.h"
+#include "SceneManifest.h"
+#include "TestHelper.h"
+
+// Scene loading with many entries: converting the text scene, loading the manifest when no asset changed,
+// when some did and have to be hashed again, and parsing the text scene the way the engine used to.
+// Usage: SceneManifestBenchmark [objects] [meshes] [materials] [changed assets]
+namespace
+{
+    typedef std::chrono::high_resolution_clock Clock;
+
+    double GetMilliseconds(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    std::wstring GetAssetName(LPCWSTR kind, UINT index)
+    {
+        return L"SceneManifestBenchmark" + std::wstring(kind) + std::to_wstring(index);
+    }
+
+    void RemoveFile(const std::wstring& path)
+    {
+#ifdef _WIN32
+        _wremove(path.c_str());
+#else
+        remove(MappedFile::ToUTF8(path).c_str());
+#endif
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const UINT objectsNum = argc > 1 ? static_cast<UINT>(atoi(argv[1])) : 10000;
+    const UINT meshesNum = max(argc > 2 ? static_cast<UINT>(atoi(argv[2])) : 1000, 1u);
+    const UINT materialsNum = max(argc > 3 ? static_cast<UINT>(atoi(argv[3])) : 100, 1u);
+    const UINT changedNum = min(argc > 4 ? static_cast<UINT>(atoi(argv[4])) : 10, meshesNum);
+    const std::wstring scenePath = L"SceneManifestBenchmark";
+    const std::wstring manifestPath = SceneManifest::GetManifestPath(scenePath);
+
+    // Small assets, so the hashing does not hide the cost of looking at every asset.
+    std::vector<std::wstring> assetNames;
+    std::string text = std::to_string(materialsNum) + "\n";
+    for (UINT i = 0; i < materialsNum; i++)
+    {
+        assetNames.push_back(GetAssetName(L"Material", i) + L".png");
+    }
+    for (UINT i = 0; i < meshesNum; i++)
+    {
+        assetNames.push_back(GetAssetName(L"Mesh", i) + L".fbx");
+    }
+    for (UINT i = 0; i < assetNames.size(); i++)
+    {
+        const std::string name = MappedFile::ToUTF8(assetNames[i]);
+        const std::string content(1024, static_cast<char>(i));
+        CHECK(MappedFile::Write(assetNames[i], content.data(), content.size()));
+        text += name + "\n";
+        if (i + 1 == materialsNum)
+        {
+            text += std::to_string(meshesNum) + "\n";
+        }
+    }
+    text += std::to_string(objectsNum) + "\n";
+    for (UINT i = 0; i < objectsNum; i++)
+    {
+        char line[128];
+        snprintf(line, sizeof(line), "%u %u %.2f 0 %.2f 10 45 0 1 1 1\n",
+            i % meshesNum, (i * 7) % materialsNum, i * 0.5f, i * -0.25f);
+        text += line;
+    }
+    CHECK(MappedFile::Write(scenePath, text.data(), text.size()));
+
+    Clock::time_point start = Clock::now();
+    CHECK(SceneManifest::Convert(scenePath, manifestPath, 1));
+    const double convertTime = GetMilliseconds(start);
+
+    SceneManifest manifest;
+    double loadTime = 1e9;
+    for (UINT i = 0; i < 10; i++)
+    {
+        start = Clock::now();
+        CHECK(manifest.Load(manifestPath, 1));
+        loadTime = min(loadTime, GetMilliseconds(start));
+        CHECK(manifest.GetRehashedAssetsNum() == 0);
+    }
+
+    // Growing a file changes its size, so it is hashed again whatever the resolution of the timestamps.
+    for (UINT i = 0; i < changedNum; i++)
+    {
+        const std::string content(2048, static_cast<char>(i));
+        CHECK(MappedFile::Write(assetNames[materialsNum + i], content.data(), content.size()));
+    }
+    start = Clock::now();
+    CHECK(manifest.Load(manifestPath, 1));
+    const double changedLoadTime = GetMilliseconds(start);
+    CHECK(manifest.GetRehashedAssetsNum() == changedNum);
+
+    // The text scene parsed with a wide file stream, as the engine did before the manifest.
+    start = Clock::now();
+    {
+        std::wistringstream inFile(std::wstring(text.begin(), text.end()));
+        UINT count = 0;
+        std::wstring name;
+        inFile >> count;
+        for (UINT i = 0; i < count; i++)
+        {
+            inFile >> name;
+        }
+        inFile >> count;
+        for (UINT i = 0; i < count; i++)
+        {
+            inFile >> name;
+        }
+        inFile >> count;
+        UINT index = 0;
+        FLOAT value = 0.0f;
+        for (UINT i = 0; i < count; i++)
+        {
+            inFile >> index >> index;
+            for (UINT j = 0; j < 9; j++)
+            {
+                inFile >> value;
+            }
+        }
+        CHECK(!inFile.fail());
+    }
+    const double parseTime = GetMilliseconds(start);
+
+    printf("%u objects, %u meshes, %u materials\n", objectsNum, meshesNum, materialsNum);
+    printf("convert:                %10.3f ms\n", convertTime);
+    printf("load:                   %10.3f ms\n", loadTime);
+    printf("load, %4u changed:     %10.3f ms\n", changedNum, changedLoadTime);
+    printf("parse the text scene:   %10.3f ms\n", parseTime);
+
+    for (const std::wstring& name : assetNames)
+    {
+        RemoveFile(name);
+    }
+    RemoveFile(scenePath);
+    RemoveFile(manifestPath);
+
+    return 0;
+}
@@ -0,0 +1,85 @@
+#include "stdafx.h"
+#include "TLSFAllocator.h"
+#include "TestHelper.h"
+
+// Placed resource churn in a heap block at 64KB granularity: buffers and textures of 64KB to 8MB, log
+// distributed, an eighth of them with MSAA alignment, with the block kept about three quarters full.
+// Usage: TLSFAllocatorBenchmark [block MB] [operations]
+namespace
+{
+    typedef std::chrono::high_resolution_clock Clock;
+
+    const UINT64 kGranularity = 64 << 10;
+    const UINT64 kMSAAAlignment = 4 << 20;
+
+    double GetNanoseconds(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const UINT64 capacity = static_cast<UINT64>(max(argc > 1 ? atoi(argv[1]) : 64, 1)) << 20;
+    const UINT operationsNum = max(argc > 2 ? static_cast<UINT>(atoi(argv[2])) : 2000000, 1u);
+
+    std::mt19937_64 random(3);
+    std::uniform_real_distribution<double> sizeExponent(16.0, 23.0);
+    TLSFAllocator allocator(capacity, kGranularity);
+    std::vector<TLSFAllocation> allocations;
+    double allocateTime = 0.0;
+    double freeTime = 0.0;
+    UINT allocationsNum = 0;
+    UINT failedAllocationsNum = 0;
+    UINT freesNum = 0;
+    double fragmentation = 0.0;
+    UINT fragmentationSamplesNum = 0;
+    for (UINT i = 0; i < operationsNum; i++)
+    {
+        if (allocations.empty() || (allocator.GetUsedSize() < capacity * 3 / 4 && random() % 2 == 0))
+        {
+            const UINT64 size = static_cast<UINT64>(pow(2.0, sizeExponent(random)));
+            const UINT64 alignment = random() % 8 == 0 ? kMSAAAlignment : kGranularity;
+            TLSFAllocation allocation;
+            Clock::time_point start = Clock::now();
+            const BOOL isAllocated = allocator.Allocate(size, alignment, allocation);
+            allocateTime += GetNanoseconds(start);
+            allocationsNum++;
+            if (isAllocated)
+            {
+                allocations.push_back(allocation);
+            }
+            else
+            {
+                failedAllocationsNum++;
+            }
+        }
+        else
+        {
+            const UINT index = static_cast<UINT>(random() % allocations.size());
+            const TLSFAllocation allocation = allocations[index];
+            allocations[index] = allocations.back();
+            allocations.pop_back();
+            Clock::time_point start = Clock::now();
+            allocator.Free(allocation);
+            freeTime += GetNanoseconds(start);
+            freesNum++;
+        }
+
+        // The share of the free memory that is not in the largest free range.
+        const UINT64 freeSize = capacity - allocator.GetUsedSize();
+        if (i % 1000 == 0 && freeSize > 0)
+        {
+            fragmentation += 1.0 - static_cast<double>(allocator.GetLargestFreeSize()) / freeSize;
+            fragmentationSamplesNum++;
+        }
+    }
+
+    printf("%llu MB block, %u operations\n", static_cast<unsigned long long>(capacity >> 20), operationsNum);
+    printf("allocate:           %6.1f ns\n", allocateTime / allocationsNum);
+    printf("free:               %6.1f ns\n", freeTime / max(freesNum, 1u));
+    printf("failed allocations: %6.2f%%\n", 100.0 * failedAllocationsNum / allocationsNum);
+    printf("mean fragmentation: %6.1f%%\n", 100.0 * fragmentation / max(fragmentationSamplesNum, 1u));
+
+    return 0;
+}
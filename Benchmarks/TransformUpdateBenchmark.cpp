@@ -0,0 +1,130 @@
+#include "stdafx.h"
+#include "JobSystem.h"
+#include "RingAllocator.h"
+#include "TestHelper.h"
+
+// The write path of SceneManager::UpdateTransforms over 1k, 10k and 100k objects: a block of the constant
+// arena per frame, retired with the frame and released FRAMES_IN_FLIGHT frames later, with the matrix of
+// every object composed and copied to its 256 byte slot, on one thread and with ParallelFor. System memory
+// stands in for the upload heap, and the LOD selection the engine does on the way is left out.
+// Usage: TransformUpdateBenchmark [largest object count] [frames] [workers, 0 for one per hardware thread but one]
+namespace
+{
+    typedef std::chrono::high_resolution_clock Clock;
+
+    // D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT, and TRANSFORM_UPDATE_MIN_RANGE_SIZE of SceneManager.
+    const UINT64 kConstantAlignment = 256;
+    const UINT kMinRangeSize = 256;
+
+    // As TransformConstant and the placement of a Transform.
+    struct TransformConstant
+    {
+        XMFLOAT4X4 ObjectToWorldMatrix;
+        XMFLOAT4 PositionScale;
+        XMFLOAT4 PositionOffset;
+    };
+
+    struct Object
+    {
+        XMVECTOR position;
+        XMVECTOR rotation;
+        XMVECTOR scale;
+        TransformConstant transformConstant;
+    };
+
+    const UINT64 kStride = (sizeof(TransformConstant) + kConstantAlignment - 1) & ~(kConstantAlignment - 1);
+
+    void WriteConstants(Object& object, BYTE* pConstant)
+    {
+        const XMMATRIX m = XMMatrixScalingFromVector(object.scale)
+            * XMMatrixRotationQuaternion(object.rotation)
+            * XMMatrixTranslationFromVector(object.position);
+        XMStoreFloat4x4(&object.transformConstant.ObjectToWorldMatrix, m);
+        memcpy(pConstant, &object.transformConstant, sizeof(TransformConstant));
+    }
+
+    // Run the frames and return the nanoseconds per object, with the arena holding the frames in flight.
+    double UpdateFrames(std::vector<Object>& objects, UINT framesNum, JobSystem* pJobSystem, std::vector<BYTE>& arena)
+    {
+        const UINT objectsNum = static_cast<UINT>(objects.size());
+        RingAllocator ring(kStride * objectsNum * (FRAMES_IN_FLIGHT + 1));
+        arena.resize(static_cast<size_t>(ring.GetCapacity()));
+
+        Clock::time_point start = Clock::now();
+        for (UINT frame = 1; frame <= framesNum; frame++)
+        {
+            if (frame > FRAMES_IN_FLIGHT)
+            {
+                ring.Release(frame - FRAMES_IN_FLIGHT);
+            }
+            UINT64 offset = 0;
+            CHECK(ring.Allocate(kStride * objectsNum, kConstantAlignment, offset));
+            BYTE* pConstants = arena.data() + offset;
+
+            if (pJobSystem == nullptr)
+            {
+                for (UINT i = 0; i < objectsNum; i++)
+                {
+                    WriteConstants(objects[i], pConstants + kStride * i);
+                }
+            }
+            else
+            {
+                pJobSystem->ParallelFor(objectsNum, kMinRangeSize, [&objects, pConstants](UINT, UINT begin, UINT end)
+                {
+                    for (UINT i = begin; i < end; i++)
+                    {
+                        WriteConstants(objects[i], pConstants + kStride * i);
+                    }
+                });
+            }
+            ring.Retire(frame);
+        }
+
+        return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / framesNum / objectsNum;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const UINT maxObjectsNum = max(argc > 1 ? static_cast<UINT>(atoi(argv[1])) : 100000, 1u);
+    const UINT framesNum = max(argc > 2 ? static_cast<UINT>(atoi(argv[2])) : 100, 1u);
+    const UINT workerCount = argc > 3 ? static_cast<UINT>(atoi(argv[3])) : 0;
+    JobSystem jobSystem(workerCount);
+    printf("%u threads, %u frames, %u bytes per object\n", jobSystem.GetThreadCount(), framesNum,
+        static_cast<UINT>(kStride));
+
+    std::mt19937 random(1);
+    std::uniform_real_distribution<FLOAT> distribution(-1.0f, 1.0f);
+    for (UINT objectsNum = min(1000u, maxObjectsNum); ; objectsNum = min(objectsNum * 10, maxObjectsNum))
+    {
+        std::vector<Object> objects(objectsNum);
+        for (Object& object : objects)
+        {
+            object.position = XMVectorSet(distribution(random) * 100.0f, distribution(random) * 10.0f,
+                distribution(random) * 100.0f, 1.0f);
+            object.rotation = XMQuaternionRotationRollPitchYaw(distribution(random) * XM_PI,
+                distribution(random) * XM_PI, distribution(random) * XM_PI);
+            object.scale = XMVectorReplicate(1.0f + distribution(random) * 0.5f);
+            object.transformConstant.PositionScale = XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+            object.transformConstant.PositionOffset = XMFLOAT4(0.0f, 0.0f, 0.0f, 0.0f);
+        }
+
+        // Both write the same constants, to the same offsets of their arenas.
+        std::vector<BYTE> serialArena;
+        std::vector<BYTE> parallelArena;
+        const double serialTime = UpdateFrames(objects, framesNum, nullptr, serialArena);
+        const double parallelTime = UpdateFrames(objects, framesNum, &jobSystem, parallelArena);
+        CHECK(serialArena == parallelArena);
+
+        printf("%6u objects  serial %6.1f ns  ParallelFor %6.1f ns per object, %4.2fx\n", objectsNum,
+            serialTime, parallelTime, serialTime / parallelTime);
+
+        if (objectsNum == maxObjectsNum)
+        {
+            break;
+        }
+    }
+
+    return 0;
+}
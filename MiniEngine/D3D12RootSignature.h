@@ -5,13 +5,14 @@ enum class eRootIndex
 {
     ConstantBufferViewGlobal = 0,
     ConstantBufferViewPerObject,
+    MaterialConstants,
     ShaderResourceViewGlobal0,
     ShaderResourceViewGlobal1,
     ShaderResourceViewGlobal2,
-    ShaderResourceViewPerObject,
+    ShaderResourceViewBindless,
     ShaderResourceViewGBuffer,
     UnorderedAccessViewGlobal,
-    Sampler,
+    SamplerBindless,
     Count,
 };
 
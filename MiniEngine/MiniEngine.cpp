@@ -5,7 +5,19 @@ using namespace Microsoft::WRL;
 
 MiniEngine::MiniEngine(UINT width, UINT height, std::wstring name) :
     Window(width, height, name),
-    isDXR(TRUE)
+    isDXR(TRUE),
+    isFirstFramePresented(FALSE),
+    isSceneLoaded(FALSE),
+    renderGraphFramesNum(0),
+    renderGraphCompileTime(0.0),
+    frameRing(FRAMES_IN_FLIGHT),
+    releasedFenceValue(0),
+    pacingFramesNum(0),
+    timedFramesNum(0),
+    framesInFlightNum(0),
+    cpuFrameTime(0.0),
+    waitTime(0.0),
+    gpuFrameTime(0.0)
 {
 
 }
@@ -18,6 +30,7 @@ MiniEngine::~MiniEngine()
 
 void MiniEngine::OnInit()
 {
+    initTime = std::chrono::high_resolution_clock::now();
     LoadPipeline();
     LoadAssets();
 }
@@ -31,6 +44,9 @@ void MiniEngine::LoadPipeline()
     pDevice->CreateDescriptorHeapManager();
     pDevice->CreateBufferManager();
 
+    // Create the job system, with the window thread as its thread 0.
+    pJobSystem = std::make_shared<JobSystem>();
+
     // Create and init the view manager.
     pViewManager = make_shared<ViewManager>(pDevice, width, height);
 
@@ -46,7 +62,8 @@ void MiniEngine::LoadPipeline()
 // Load the sample assets.
 void MiniEngine::LoadAssets()
 {
-    // Create synchronization objects and wait until assets have been uploaded to the GPU.
+    // Create synchronization objects and wait until the static assets have been uploaded to the GPU.
+    // The assets of the scene keep loading in the background and join it frame by frame.
     ThrowIfFailed(pDevice->GetDevice()->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence)));
     fenceValue = 1;
 
@@ -57,8 +74,18 @@ void MiniEngine::LoadAssets()
         ThrowIfFailed(HRESULT_FROM_WIN32(GetLastError()));
     }
 
+    // Create the timestamp queries, two for each frame in flight.
+    D3D12_QUERY_HEAP_DESC queryHeapDesc = {};
+    queryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+    queryHeapDesc.Count = 2 * FRAMES_IN_FLIGHT;
+    ThrowIfFailed(pDevice->GetDevice()->CreateQueryHeap(&queryHeapDesc, IID_PPV_ARGS(&pTimestampQueryHeap)));
+    pTimestampBuffer = new D3D12ReadbackBuffer();
+    pDevice->GetBufferManager()->AllocateReadbackBuffer(pTimestampBuffer, queryHeapDesc.Count * sizeof(UINT64),
+        L"TimestampBuffer");
+    ThrowIfFailed(pDevice->GetCommandQueue()->GetTimestampFrequency(&timestampFrequency));
+
     // Create scene objects.
-    pSceneManager = make_shared<SceneManager>(pDevice, isDXR);
+    pSceneManager = make_shared<SceneManager>(pDevice, pJobSystem, isDXR);
     pSceneManager->InitFBXImporter();
     pSceneManager->LoadScene(pCommandList);
     pSceneManager->CreateCamera(width, height);
@@ -95,6 +122,13 @@ void MiniEngine::LoadAssets()
 
     pCommandList->ExecuteCommandList();
     WaitForGPU();
+
+    // Alias the transient targets for the frame with every pass, which the frames with fewer fit in.
+    DeclareRenderGraph(TRUE);
+    ThrowIfFalse(renderGraph.Compile());
+    pViewManager->PlaceTransientTargets(renderGraph);
+
+    frameTime = std::chrono::high_resolution_clock::now();
 }
 
 void MiniEngine::OnKeyDown(UINT8 key)
@@ -157,14 +191,32 @@ void MiniEngine::OnRender()
     // Present the frame.
     ThrowIfFailed(pViewManager->GetSwapChain()->Present(1, 0));
 
-    WaitForPreviousFrame();
+    WCHAR message[256];
+    if (!isFirstFramePresented)
+    {
+        isFirstFramePresented = TRUE;
+        std::chrono::duration<double, std::milli> duration = std::chrono::high_resolution_clock::now() - initTime;
+        swprintf_s(message, L"Time to first frame: %.2f ms.\n", duration.count());
+        OutputDebugStringW(message);
+    }
+
+    MoveToNextFrame();
+
+    if (!isSceneLoaded && pSceneManager->IsSceneLoaded())
+    {
+        isSceneLoaded = TRUE;
+        std::chrono::duration<double, std::milli> duration = std::chrono::high_resolution_clock::now() - initTime;
+        swprintf_s(message, L"Time to fully loaded: %.2f ms, %u objects.\n",
+            duration.count(), static_cast<UINT>(pSceneManager->GetObjects().size()));
+        OutputDebugStringW(message);
+    }
 }
 
 void MiniEngine::OnDestroy()
 {
     // Ensure that the GPU is no longer referencing resources that are about to be
     // cleaned up by the destructor.
-    WaitForPreviousFrame();
+    WaitForGPU();
 
     CloseHandle(fenceEvent);
 }
@@ -172,77 +224,283 @@ void MiniEngine::OnDestroy()
 void MiniEngine::PopulateCommandList()
 {
     // Command list allocators can only be reset when the associated 
-    // command lists have finished execution on the GPU; apps should use 
-    // fences to determine GPU execution progress.
+    // command lists have finished execution on the GPU. The allocator of
+    // this frame was last used FRAMES_IN_FLIGHT frames ago, which is done.
     ThrowIfFailed(pDevice->GetCommandAllocator()->Reset());
 
     // However, when ExecuteCommandList() is called on a particular command 
     // list, that command list can then be reset at any time and must be before 
     // re-recording.
     pCommandList->Reset(pDevice->GetCommandAllocator());
+    const UINT timestamp = 2 * pDevice->GetFrameIndex();
+    pCommandList->EndQuery(pTimestampQueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, timestamp);
+
+    // Upload the assets loaded since the last frame, and write the views of the textures they and the
+    // streamed mips changed to the texture slots of this frame, which the GPU is done with.
+    pSceneManager->CommitLoadedAssets(pCommandList);
+    pDevice->GetDescriptorHeapManager()->CommitStagedViews(pDevice->GetDevice(), pDevice->GetFrameIndex());
+
+    // Culling and tracing wait for the first objects of the scene.
+    auto start = std::chrono::high_resolution_clock::now();
+    DeclareRenderGraph(pSceneManager->IsRayTracingSceneReady());
+    ThrowIfFalse(renderGraph.Compile());
+    std::chrono::duration<double, std::micro> duration = std::chrono::high_resolution_clock::now() - start;
+    renderGraphCompileTime += duration.count();
+
+    // The passes of the frame must not use the transient targets that share memory at the same time.
+    ThrowIfFalse(renderGraph.IsAliasingValid(pViewManager->GetTransientOffsets()));
+    for (UINT pass : renderGraph.GetOrder())
+    {
+        RecordRenderGraphBarriers(renderGraph.GetBarriers(pass));
+        renderGraphPasses[pass]();
+    }
+    RecordRenderGraphBarriers(renderGraph.GetFinalBarriers());
 
-    // Indicate that the back buffer will be used as a render target.
-    pCommandList->AddTransitionResourceBarriers(pViewManager->GetCurrentBackBuffer(),
-        D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET);
-    pCommandList->FlushResourceBarriers();
-
-    pCommandList->SetComputeRootSignature(pRootSignature->GetDRXRootSignature());
-    pCommandList->SetComputeRootConstantBufferView(
-        (UINT)eDXRRootIndex::ConstantBufferViewGlobal,
-        pDevice->GetBufferManager()->GetGlobalConstantBuffer()->GetResource()->GetGPUVirtualAddress());
-    pFrustumCullingPass->Execute(pCommandList);
-
-    pCommandList->SetRootSignature(pRootSignature->GetRootSignature());
-    pCommandList->SetRootConstantBufferView(
-        (UINT)eRootIndex::ConstantBufferViewGlobal,
-        pDevice->GetBufferManager()->GetGlobalConstantBuffer()->GetResource()->GetGPUVirtualAddress());
-    pGBufferPass->Execute(pCommandList);
-
-    pCommandList->SetComputeRootSignature(pRootSignature->GetRootSignature());
-    pCommandList->SetComputeRootConstantBufferView(
-        (UINT)eRootIndex::ConstantBufferViewGlobal,
-        pDevice->GetBufferManager()->GetGlobalConstantBuffer()->GetResource()->GetGPUVirtualAddress());
-    pDeferredLightingPass->Execute(pCommandList);
-
-    pCommandList->SetComputeRootSignature(pRootSignature->GetDRXRootSignature());
-    pRayTracingPass->Execute(pCommandList);
-
-    pCommandList->SetRootSignature(pRootSignature->GetRootSignature());
-    pTemporalAAPass->Execute(pCommandList);
-    pBlitPass->Execute(pCommandList);
-
-    // Indicate that the back buffer will now be used to present.
-    pCommandList->AddTransitionResourceBarriers(pViewManager->GetCurrentBackBuffer(),
-        D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
-    pCommandList->FlushResourceBarriers();
-
+    pCommandList->EndQuery(pTimestampQueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, timestamp + 1);
+    pCommandList->ResolveQueryData(pTimestampQueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, timestamp, 2,
+        pTimestampBuffer->ResourceLocation.Resource.Get(), timestamp * sizeof(UINT64));
     pCommandList->ExecuteCommandList();
+
+    if (++renderGraphFramesNum >= RENDER_GRAPH_LOG_INTERVAL)
+    {
+        ReportRenderGraph();
+    }
 }
 
-void MiniEngine::WaitForPreviousFrame()
+void MiniEngine::DeclareRenderGraph(BOOL isRayTracingSceneReady)
 {
-    // WAITING FOR THE FRAME TO COMPLETE BEFORE CONTINUING IS NOT BEST PRACTICE.
-    // This is code implemented as such for simplicity. The D3D12HelloFrameBuffering
-    // sample illustrates how to use fences for efficient resource usage and to
-    // maximize GPU utilization.
+    renderGraph.Reset();
+    renderGraphPasses.clear();
+    pViewManager->DeclareTargets(renderGraph);
+
+    const UINT backBuffer = pViewManager->GetBackBufferResource();
+    const UINT depth = pViewManager->GetDepthResource();
+    const UINT uavColor = pViewManager->GetUAVColorResource();
+    const UINT color = pViewManager->GetRenderTargetResource(pViewManager->GetColorHandle());
+    const UINT taaColor = pViewManager->GetRenderTargetResource(pViewManager->GetTAAColorHandle());
+    const UINT taaHistory = pViewManager->GetRenderTargetResource(pTemporalAAPass->GetTAAHistoryHandle());
+    const D3D12_GPU_VIRTUAL_ADDRESS globalConstants = pSceneManager->GetCameraConstantsAddress();
+
+    UINT pass;
+    if (isRayTracingSceneReady)
+    {
+        // The culling reads its results back, and writes the visibility to the UAV to debug it.
+        pass = AddRenderGraphPass(TRUE, [this, globalConstants]()
+        {
+            pCommandList->SetComputeRootSignature(pRootSignature->GetDRXRootSignature());
+            pCommandList->SetComputeRootConstantBufferView((UINT)eDXRRootIndex::ConstantBufferViewGlobal, globalConstants);
+            pFrustumCullingPass->Execute(pCommandList);
+        });
+        renderGraph.Write(pass, uavColor, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    }
 
-    // Signal and increment the fence value.
-    const UINT64 value = UpdateFence();
+    pass = AddRenderGraphPass(FALSE, [this, globalConstants]()
+    {
+        pCommandList->SetRootSignature(pRootSignature->GetRootSignature());
+        pCommandList->SetRootConstantBufferView((UINT)eRootIndex::ConstantBufferViewGlobal, globalConstants);
+        pGBufferPass->Execute(pCommandList);
+    });
+    for (UINT i = 0; i < pViewManager->GetGBufferCount(); i++)
+    {
+        renderGraph.Write(pass, pViewManager->GetRenderTargetResource(pViewManager->GetGBufferHandle(i)),
+            D3D12_RESOURCE_STATE_RENDER_TARGET);
+    }
+    renderGraph.Write(pass, depth, D3D12_RESOURCE_STATE_DEPTH_WRITE);
 
-    // Wait until the previous frame is finished.
-    if (fence->GetCompletedValue() < value)
+    pass = AddRenderGraphPass(FALSE, [this, globalConstants]()
     {
-        ThrowIfFailed(fence->SetEventOnCompletion(value, fenceEvent));
-        WaitForSingleObject(fenceEvent, INFINITE);
+        pCommandList->SetComputeRootSignature(pRootSignature->GetRootSignature());
+        pCommandList->SetComputeRootConstantBufferView((UINT)eRootIndex::ConstantBufferViewGlobal, globalConstants);
+        pDeferredLightingPass->Execute(pCommandList);
+    });
+    for (UINT i = 0; i < pViewManager->GetGBufferCount(); i++)
+    {
+        renderGraph.Read(pass, pViewManager->GetRenderTargetResource(pViewManager->GetGBufferHandle(i)),
+            D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    }
+    renderGraph.Write(pass, uavColor, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+
+    if (isRayTracingSceneReady)
+    {
+        pass = AddRenderGraphPass(FALSE, [this]()
+        {
+            pCommandList->SetComputeRootSignature(pRootSignature->GetDRXRootSignature());
+            pRayTracingPass->Execute(pCommandList);
+        });
+        renderGraph.Read(pass, depth, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+        renderGraph.Read(pass, uavColor, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+        renderGraph.Write(pass, uavColor, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
     }
 
-    // Update the frame index.
+    // Copy the lit color out of the UAV, for TAA to sample.
+    pass = AddRenderGraphPass(FALSE, [this, color, uavColor]()
+    {
+        pCommandList->CopyResource(pViewManager->GetTargetResource(color), pViewManager->GetTargetResource(uavColor));
+    });
+    renderGraph.Read(pass, uavColor, D3D12_RESOURCE_STATE_COPY_SOURCE);
+    renderGraph.Write(pass, color, D3D12_RESOURCE_STATE_COPY_DEST);
+
+    pass = AddRenderGraphPass(FALSE, [this]()
+    {
+        pCommandList->SetRootSignature(pRootSignature->GetRootSignature());
+        pTemporalAAPass->Execute(pCommandList);
+    });
+    renderGraph.Read(pass, color, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    renderGraph.Read(pass, taaHistory, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    renderGraph.Read(pass, depth, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    renderGraph.Write(pass, taaColor, D3D12_RESOURCE_STATE_RENDER_TARGET);
+
+    pass = AddRenderGraphPass(FALSE, [this, taaHistory, taaColor]()
+    {
+        pCommandList->CopyResource(pViewManager->GetTargetResource(taaHistory), pViewManager->GetTargetResource(taaColor));
+    });
+    renderGraph.Read(pass, taaColor, D3D12_RESOURCE_STATE_COPY_SOURCE);
+    renderGraph.Write(pass, taaHistory, D3D12_RESOURCE_STATE_COPY_DEST);
+
+    pass = AddRenderGraphPass(FALSE, [this]()
+    {
+        pBlitPass->Execute(pCommandList);
+    });
+    renderGraph.Read(pass, taaColor, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    renderGraph.Write(pass, backBuffer, D3D12_RESOURCE_STATE_RENDER_TARGET);
+}
+
+UINT MiniEngine::AddRenderGraphPass(BOOL hasSideEffects, const std::function<void()>& execute)
+{
+    renderGraphPasses.push_back(execute);
+    return renderGraph.AddPass(hasSideEffects);
+}
+
+void MiniEngine::RecordRenderGraphBarriers(const std::vector<RenderGraphBarrier>& barriers)
+{
+    for (const RenderGraphBarrier& barrier : barriers)
+    {
+        ID3D12Resource* pResource = pViewManager->GetTargetResource(barrier.resource);
+        switch (barrier.type)
+        {
+        case RenderGraphBarrierType::Transition:
+            pCommandList->TransitionResource(pResource, barrier.stateAfter);
+            break;
+        case RenderGraphBarrierType::BeginTransition:
+            pCommandList->BeginTransitionResource(pResource, barrier.stateAfter);
+            break;
+        case RenderGraphBarrierType::Aliasing:
+            pCommandList->AddAliasingBarrier(pResource);
+            break;
+        case RenderGraphBarrierType::UnorderedAccess:
+            pCommandList->AddUAVBarrier(pResource);
+            break;
+        }
+    }
+
+    // An aliased render target holds garbage, and has to be discarded if the pass does not clear it.
+    for (const RenderGraphBarrier& barrier : barriers)
+    {
+        if (barrier.type == RenderGraphBarrierType::Aliasing
+            && barrier.stateAfter == D3D12_RESOURCE_STATE_RENDER_TARGET)
+        {
+            pCommandList->DiscardResource(pViewManager->GetTargetResource(barrier.resource));
+        }
+    }
+}
+
+void MiniEngine::ReportRenderGraph()
+{
+    UINT culledPassesNum = renderGraph.GetPassesNum() - static_cast<UINT>(renderGraph.GetOrder().size());
+
+    WCHAR message[256];
+    swprintf_s(message, L"Render graph: %u passes, %u culled, %.1f us to compile per frame, "
+        L"%.2f MB of transient targets in %.2f MB.\n",
+        renderGraph.GetPassesNum(), culledPassesNum, renderGraphCompileTime / renderGraphFramesNum,
+        renderGraph.GetTransientSize() / 1048576.0, renderGraph.GetAliasedSize() / 1048576.0);
+    OutputDebugStringW(message);
+
+    renderGraphFramesNum = 0;
+    renderGraphCompileTime = 0.0;
+}
+
+void MiniEngine::ReadTimestamps()
+{
+    // The slot of the frame being recorded holds the timestamps of the last frame the GPU finished in it.
+    UINT64 timestamps[2 * FRAMES_IN_FLIGHT];
+    pTimestampBuffer->ReadbackData(timestamps, sizeof(timestamps));
+
+    const UINT timestamp = 2 * frameRing.GetFrameIndex();
+    if (timestamps[timestamp + 1] > timestamps[timestamp])
+    {
+        gpuFrameTime += 1000.0 * (timestamps[timestamp + 1] - timestamps[timestamp]) / timestampFrequency;
+        timedFramesNum++;
+    }
+}
+
+void MiniEngine::ReportFramePacing()
+{
+    // The CPU and the GPU overlap for the part of the frame the CPU does not wait.
+    const double frameTimeMs = cpuFrameTime / pacingFramesNum;
+    const double waitTimeMs = waitTime / pacingFramesNum;
+
+    WCHAR message[256];
+    swprintf_s(message, L"Frame pacing: %.2f ms per frame, %.2f ms waiting for the GPU (%.1f%% overlapped), "
+        L"%.2f ms on the GPU, %.2f of %u frames in flight.\n",
+        frameTimeMs, waitTimeMs, frameTimeMs > 0.0 ? 100.0 * (1.0 - waitTimeMs / frameTimeMs) : 0.0,
+        timedFramesNum > 0 ? gpuFrameTime / timedFramesNum : 0.0,
+        static_cast<double>(framesInFlightNum) / pacingFramesNum, frameRing.GetFramesNum());
+    OutputDebugStringW(message);
+
+    pacingFramesNum = 0;
+    timedFramesNum = 0;
+    framesInFlightNum = 0;
+    cpuFrameTime = 0.0;
+    waitTime = 0.0;
+    gpuFrameTime = 0.0;
+}
+
+void MiniEngine::MoveToNextFrame()
+{
+    // Signal the end of the frame, and move on to the slot of the next one.
+    const UINT64 value = UpdateFence();
+    ThrowIfFalse(frameRing.EndFrame(value));
     pViewManager->UpdateFrameIndex();
 
-    // Release upload buffers from last frame.
-    pDevice->GetBufferManager()->ReleaseTempUploadBuffer();
-    // TODO: Add a event system to handle event.
-    pSceneManager->Release();
+    // Wait until the GPU has finished the last frame of the slot, which leaves it the frames after that one
+    // to work on while the next frame is recorded.
+    auto start = std::chrono::high_resolution_clock::now();
+    const UINT64 waitFenceValue = frameRing.GetWaitFenceValue();
+    if (fence->GetCompletedValue() < waitFenceValue)
+    {
+        ThrowIfFailed(fence->SetEventOnCompletion(waitFenceValue, fenceEvent));
+        WaitForSingleObject(fenceEvent, INFINITE);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    pDevice->SetFrameIndex(frameRing.GetFrameIndex());
+
+    const UINT64 completedFenceValue = fence->GetCompletedValue();
+    std::chrono::duration<double, std::milli> duration = end - start;
+    waitTime += duration.count();
+    duration = end - frameTime;
+    cpuFrameTime += duration.count();
+    frameTime = end;
+    framesInFlightNum += frameRing.GetFramesInFlight(completedFenceValue);
+    if (waitFenceValue > 0)
+    {
+        ReadTimestamps();
+    }
+    if (++pacingFramesNum >= FRAME_PACING_LOG_INTERVAL)
+    {
+        ReportFramePacing();
+    }
+
+    // Release the upload buffers, texture slots and buffers of the frames the GPU has finished since the
+    // last time, if it has finished any.
+    if (completedFenceValue > releasedFenceValue)
+    {
+        releasedFenceValue = completedFenceValue;
+        pDevice->GetBufferManager()->ReleaseTempUploadBuffer(completedFenceValue);
+        pDevice->GetDescriptorHeapManager()->ReleaseTextureSlots(completedFenceValue);
+        // TODO: Add a event system to handle event.
+        pSceneManager->ResolveLoadedAssets(completedFenceValue);
+        pSceneManager->Release(completedFenceValue);
+    }
 }
 
 // Wait for pending GPU work to complete.
@@ -264,5 +522,14 @@ UINT64 MiniEngine::UpdateFence()
     ThrowIfFailed(pDevice->GetCommandQueue()->Signal(fence.Get(), value));
     fenceValue++;
 
+    // The upload buffers, the texture slots and the buffers freed by the work submitted so far, and the
+    // assets it uploads, can be reused or join the scene once the GPU reaches the fence.
+    pDevice->GetBufferManager()->RetireTempUploadBuffer(value);
+    pDevice->GetDescriptorHeapManager()->RetireTextureSlots(value);
+    if (pSceneManager != nullptr)
+    {
+        pSceneManager->Retire(value);
+    }
+
     return value;
 }
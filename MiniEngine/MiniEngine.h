@@ -10,6 +10,14 @@
 #include "BlitPass.h"
 #include "TemporalAAPass.h"
 #include "RayTracingPass.h"
+#include "FrameRing.h"
+#include <chrono>
+#include <functional>
+
+// Frames between two reports of the render graph.
+#define RENDER_GRAPH_LOG_INTERVAL 600
+// Frames between two reports of the frame pacing.
+#define FRAME_PACING_LOG_INTERVAL 600
 
 using namespace DirectX;
 using Microsoft::WRL::ComPtr;
@@ -23,6 +31,8 @@ private:
 
     // Pipeline objects.
     shared_ptr<D3D12Device> pDevice;
+    // The task runtime, whose thread 0 is the window thread.
+    shared_ptr<JobSystem> pJobSystem;
     D3D12RootSignature* pRootSignature;
     D3D12CommandList* pCommandList;
 
@@ -35,19 +45,55 @@ private:
     shared_ptr<BlitPass> pBlitPass;
     shared_ptr<RayTracingPass> pRayTracingPass;
 
-    // Synchronization objects.
+    // The passes of the frame and the targets they use, with what each pass records.
+    RenderGraph renderGraph;
+    std::vector<std::function<void()>> renderGraphPasses;
+
+    // Render graph metrics since the last report.
+    UINT renderGraphFramesNum;
+    double renderGraphCompileTime;
+
+    // Synchronization objects. The frames in flight take the slots of the ring in turn.
     HANDLE fenceEvent;
     ComPtr<ID3D12Fence> fence;
     UINT64 fenceValue;
+    FrameRing frameRing;
+    // The completed fence value the resources of the finished frames were last released at.
+    UINT64 releasedFenceValue;
+
+    // GPU timestamps at the start and the end of the frame of each slot, read once the GPU is done with it.
+    ComPtr<ID3D12QueryHeap> pTimestampQueryHeap;
+    D3D12ReadbackBuffer* pTimestampBuffer;
+    UINT64 timestampFrequency;
+
+    // Frame pacing metrics since the last report.
+    std::chrono::high_resolution_clock::time_point frameTime;
+    UINT pacingFramesNum;
+    UINT timedFramesNum;
+    UINT64 framesInFlightNum;
+    double cpuFrameTime;
+    double waitTime;
+    double gpuFrameTime;
 
     // Scene objects
     shared_ptr<SceneManager> pSceneManager;
     shared_ptr<ViewManager> pViewManager;
 
+    // Loading metrics, measured from OnInit.
+    std::chrono::high_resolution_clock::time_point initTime;
+    BOOL isFirstFramePresented;
+    BOOL isSceneLoaded;
+
     void LoadPipeline();
     void LoadAssets();
     void PopulateCommandList();
-    void WaitForPreviousFrame();
+    void DeclareRenderGraph(BOOL isRayTracingSceneReady);
+    UINT AddRenderGraphPass(BOOL hasSideEffects, const std::function<void()>& execute);
+    void RecordRenderGraphBarriers(const std::vector<RenderGraphBarrier>& barriers);
+    void ReportRenderGraph();
+    void ReadTimestamps();
+    void ReportFramePacing();
+    void MoveToNextFrame();
     void WaitForGPU();
     UINT64 UpdateFence();
 
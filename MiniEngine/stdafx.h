@@ -5,7 +5,6 @@
 #endif
 
 #include <windows.h>
-#include <wincodec.h>
 
 // dxguid.lib
 #include <d3d12.h>
@@ -1,6 +1,16 @@
 #include "stdafx.h"
 #include "D3D12DefaultBuffer.h"
 
+D3D12DefaultBuffer::D3D12DefaultBuffer() :
+    D3D12Buffer(),
+    isPlaced(FALSE),
+    heapType(0),
+    heapBlock(0),
+    heapAllocation({})
+{
+
+}
+
 void D3D12DefaultBuffer::CreateBuffer(
     ID3D12Device* device,
     const D3D12_RESOURCE_DESC* desc,
@@ -16,6 +26,78 @@ void D3D12DefaultBuffer::CreateBuffer(
         clearValue,
         IID_PPV_ARGS(ResourceLocation.Resource.GetAddressOf())));
 
+    if (name)
+    {
+        ResourceLocation.Resource->SetName(name);
+    }
+}
+
+void D3D12DefaultBuffer::CreatePlacedBuffer(
+    ID3D12Device* device,
+    ID3D12Heap* heap,
+    UINT inHeapType,
+    UINT inHeapBlock,
+    const TLSFAllocation& allocation,
+    const D3D12_RESOURCE_DESC* desc,
+    D3D12_RESOURCE_STATES state,
+    const wchar_t* name)
+{
+    ThrowIfFailed(device->CreatePlacedResource(
+        heap,
+        allocation.offset,
+        desc,
+        state,
+        nullptr,
+        IID_PPV_ARGS(ResourceLocation.Resource.GetAddressOf())));
+
+    isPlaced = TRUE;
+    heapType = inHeapType;
+    heapBlock = inHeapBlock;
+    heapAllocation = allocation;
+
+    if (name)
+    {
+        ResourceLocation.Resource->SetName(name);
+    }
+}
+
+void D3D12DefaultBuffer::CreateAliasedBuffer(
+    ID3D12Device* device,
+    ID3D12Heap* heap,
+    UINT64 offset,
+    const D3D12_RESOURCE_DESC* desc,
+    D3D12_RESOURCE_STATES state,
+    const wchar_t* name,
+    const D3D12_CLEAR_VALUE* clearValue)
+{
+    ThrowIfFailed(device->CreatePlacedResource(
+        heap,
+        offset,
+        desc,
+        state,
+        clearValue,
+        IID_PPV_ARGS(ResourceLocation.Resource.GetAddressOf())));
+
+    if (name)
+    {
+        ResourceLocation.Resource->SetName(name);
+    }
+}
+
+void D3D12DefaultBuffer::CreateReservedBuffer(
+    ID3D12Device* device,
+    const D3D12_RESOURCE_DESC* desc,
+    D3D12_RESOURCE_STATES state,
+    const wchar_t* name)
+{
+    D3D12_RESOURCE_DESC reservedDesc = *desc;
+    reservedDesc.Layout = D3D12_TEXTURE_LAYOUT_64KB_UNDEFINED_SWIZZLE;
+    ThrowIfFailed(device->CreateReservedResource(
+        &reservedDesc,
+        state,
+        nullptr,
+        IID_PPV_ARGS(ResourceLocation.Resource.GetAddressOf())));
+
     if (name)
     {
         ResourceLocation.Resource->SetName(name);
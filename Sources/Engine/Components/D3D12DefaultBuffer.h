@@ -1,12 +1,52 @@
 #pragma once
+#include "TLSFAllocator.h"
 
 class D3D12DefaultBuffer : public D3D12Buffer
 {
+private:
+	// Placed buffers live in a range of a heap block of the buffer manager, which frees it.
+	BOOL isPlaced;
+	UINT heapType;
+	UINT heapBlock;
+	TLSFAllocation heapAllocation;
+
 public:
+	D3D12DefaultBuffer();
+
 	void CreateBuffer(
 		ID3D12Device* device,
 		const D3D12_RESOURCE_DESC* desc,
 		D3D12_RESOURCE_STATES state,
 		const wchar_t* name,
 		const D3D12_CLEAR_VALUE* clearValue);
+	void CreatePlacedBuffer(
+		ID3D12Device* device,
+		ID3D12Heap* heap,
+		UINT inHeapType,
+		UINT inHeapBlock,
+		const TLSFAllocation& allocation,
+		const D3D12_RESOURCE_DESC* desc,
+		D3D12_RESOURCE_STATES state,
+		const wchar_t* name);
+	// Create a texture at an offset of a heap whose memory it shares with other resources. The owner of the
+	// heap frees it, so the buffer is not placed like the others.
+	void CreateAliasedBuffer(
+		ID3D12Device* device,
+		ID3D12Heap* heap,
+		UINT64 offset,
+		const D3D12_RESOURCE_DESC* desc,
+		D3D12_RESOURCE_STATES state,
+		const wchar_t* name,
+		const D3D12_CLEAR_VALUE* clearValue);
+	// Create a texture without memory, its 64KB tiles are mapped to heaps later.
+	void CreateReservedBuffer(
+		ID3D12Device* device,
+		const D3D12_RESOURCE_DESC* desc,
+		D3D12_RESOURCE_STATES state,
+		const wchar_t* name);
+
+	inline const BOOL IsPlaced() const { return isPlaced; }
+	inline const UINT GetHeapType() const { return heapType; }
+	inline const UINT GetHeapBlock() const { return heapBlock; }
+	inline const TLSFAllocation& GetHeapAllocation() const { return heapAllocation; }
 };
\ No newline at end of file
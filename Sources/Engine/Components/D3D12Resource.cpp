@@ -1,9 +1,13 @@
 #include "stdafx.h"
 #include "D3D12Resource.h"
 
+// Resources are only placed on the render thread.
+static UINT64 sNextResourceID = 1;
+
 D3D12Resource::D3D12Resource(const D3D12_RESOURCE_DESC& desc) :
 	resourceState(D3D12_RESOURCE_STATE_GENERIC_READ),
-	resourceDesc(desc)
+	resourceDesc(desc),
+	resourceID(0)
 {
 
 }
@@ -16,4 +20,5 @@ D3D12Resource::~D3D12Resource()
 void D3D12Resource::SetResourceLoaction(const ComPtr<ID3D12Resource>& resource)
 {
 	resourceLocation.Resource = resource;
+	resourceID = sNextResourceID++;
 }
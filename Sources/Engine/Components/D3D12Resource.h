@@ -8,6 +8,9 @@ protected:
 	D3D12_RESOURCE_STATES resourceState;
 	D3D12ResourceLocation resourceLocation;
 	const D3D12_RESOURCE_DESC resourceDesc;
+	// A new ID each time the resource location is set. Views are keyed on it rather than on the address of
+	// the resource, which a resource created after this one is released may reuse.
+	UINT64 resourceID;
 
 public:
 	D3D12Resource() = delete;
@@ -17,6 +20,8 @@ public:
 	void SetResourceLoaction(const ComPtr<ID3D12Resource>&);
 	// TODO: Check nullptr.
 	virtual void CreateView(const ComPtr<ID3D12Device>& device, const D3D12_CPU_DESCRIPTOR_HANDLE& handle) = 0;
+	// The bytes that identify the view CreateView writes, or FALSE if the view can not be told apart by them.
+	virtual BOOL GetViewKey(std::string& key) const { return FALSE; }
 
 	inline const D3D12_RESOURCE_DESC& GetResourceDesc() const { return resourceDesc; }
 	inline const ComPtr<ID3D12Resource>& GetResource() const { return resourceLocation.Resource; }
@@ -54,4 +59,17 @@ public:
 			delete view;
 		}
 	}
+
+	// A view is the resource by its ID, at its GPU virtual address for buffers, and the description of the view.
+	virtual BOOL GetViewKey(std::string& key) const override
+	{
+		ID3D12Resource* pResource = resourceLocation.Resource.Get();
+		const D3D12_GPU_VIRTUAL_ADDRESS address = pResource != nullptr && resourceDesc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER
+			? pResource->GetGPUVirtualAddress()
+			: 0;
+		key.append(reinterpret_cast<const char*>(&resourceID), sizeof(resourceID));
+		key.append(reinterpret_cast<const char*>(&address), sizeof(address));
+		key.append(reinterpret_cast<const char*>(&viewDesc), sizeof(viewDesc));
+		return pResource != nullptr;
+	}
 };
@@ -4,5 +4,6 @@ class D3D12Sampler
 {
 public:
 	D3D12_SAMPLER_DESC SamplerDesc;
-	CD3DX12_CPU_DESCRIPTOR_HANDLE CPUHandle;
+	// The descriptor in the sampler heap, which the samplers with the same description share.
+	UINT ID;
 };
@@ -2,14 +2,16 @@
 #include "D3D12UploadBuffer.h"
 
 D3D12UploadBuffer::D3D12UploadBuffer() :
-	D3D12Buffer()
+	D3D12Buffer(),
+	resourceOffset(0),
+	isSubBuffer(FALSE)
 {
 
 }
 
 D3D12UploadBuffer::~D3D12UploadBuffer()
 {
-	if (ResourceLocation.Resource != nullptr)
+	if (ResourceLocation.Resource != nullptr && !isSubBuffer)
 	{
 		ResourceLocation.Resource->Unmap(0, nullptr);
 	}
@@ -64,6 +66,44 @@ void D3D12UploadBuffer::CreateBuffer(
 	}
 }
 
+void D3D12UploadBuffer::CreateStagingBuffer(
+	ID3D12Device* device,
+	UINT64 size,
+	const wchar_t* name)
+{
+	bufferSize = size;
+	D3D12_RESOURCE_DESC resourceDesc = CD3DX12_RESOURCE_DESC::Buffer(bufferSize);
+
+	// The upload heap is write-combined, which makes every read of the CPU miss the cache.
+	ThrowIfFailed(device->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_CPU_PAGE_PROPERTY_WRITE_BACK, D3D12_MEMORY_POOL_L0),
+		D3D12_HEAP_FLAG_NONE,
+		&resourceDesc,
+		D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		IID_PPV_ARGS(ResourceLocation.Resource.GetAddressOf())));
+
+	CD3DX12_RANGE readRange(0, 0);
+	ThrowIfFailed(ResourceLocation.Resource->Map(0, &readRange, reinterpret_cast<void**>(&startLocation)));
+
+	if (name)
+	{
+		ResourceLocation.Resource->SetName(name);
+	}
+}
+
+void D3D12UploadBuffer::CreateSubBuffer(
+	D3D12UploadBuffer* pParent,
+	UINT64 offset,
+	UINT64 size)
+{
+	bufferSize = size;
+	resourceOffset = offset;
+	isSubBuffer = TRUE;
+	ResourceLocation.Resource = pParent->ResourceLocation.Resource;
+	startLocation = static_cast<BYTE*>(pParent->GetStartLocation()) + offset;
+}
+
 void D3D12UploadBuffer::CopyData(void const* source, UINT64 size)
 {
 	memcpy(startLocation, source, size);
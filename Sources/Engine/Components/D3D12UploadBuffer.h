@@ -7,6 +7,9 @@ class D3D12CBV;
 class D3D12UploadBuffer : public D3D12Buffer
 {
 private:
+	// Sub-buffers are a range of the resource of another upload buffer, which maps it.
+	UINT64 resourceOffset;
+	BOOL isSubBuffer;
 
 public:
 	D3D12UploadBuffer();
@@ -22,7 +25,25 @@ public:
 		const D3D12_RESOURCE_DESC& desc,
 		D3D12_RESOURCE_STATES state,
 		const wchar_t* name);
+	// Upload memory in write-back pages, for data the CPU reads again while it builds it, like the mips
+	// filtered from the level above. The GPU reads it over the bus like the upload heap.
+	void CreateStagingBuffer(
+		ID3D12Device* device,
+		UINT64 size,
+		const wchar_t* name);
+	// Place the buffer at an offset into the resource of a parent buffer, which must outlive it.
+	void CreateSubBuffer(
+		D3D12UploadBuffer* pParent,
+		UINT64 offset,
+		UINT64 size);
 
 	void CopyData(void const* source, UINT64 size);
 	void CopyData(void const* source, UINT64 size, UINT64 offset);
+
+	// The start of the buffer in its resource, which copies and GPU addresses must add.
+	inline const UINT64 GetResourceOffset() const { return resourceOffset; }
+	inline D3D12_GPU_VIRTUAL_ADDRESS GetGPUVirtualAddress() const
+	{
+		return ResourceLocation.Resource->GetGPUVirtualAddress() + resourceOffset;
+	}
 };
\ No newline at end of file
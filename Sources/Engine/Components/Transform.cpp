@@ -5,9 +5,12 @@ Transform::Transform(UINT index) :
 	worldPosition(DefaultWorldPosition),
 	forwardDirction(DefaultForwardDirction),
 	upDirction(DefaultUpDirction),
+    rotation(XMQuaternionIdentity()),
+    scale(XMVectorSet(1.0f, 1.0f, 1.0f, 0.0f)),
     id(index)
 {
-
+    transformConstant.PositionScale = XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+    transformConstant.PositionOffset = XMFLOAT4(0.0f, 0.0f, 0.0f, 0.0f);
 }
 
 Transform::~Transform()
@@ -27,9 +30,18 @@ void Transform::CopyWorldPosition(const Transform& other)
     this->worldPosition = other.worldPosition;
 }
 
+void Transform::SetTransform(const XMFLOAT3& position, const XMFLOAT4& rotation, const XMFLOAT3& scale)
+{
+    this->worldPosition = XMVectorSetW(XMLoadFloat3(&position), 1.0f);
+    this->rotation = XMLoadFloat4(&rotation);
+    this->scale = XMLoadFloat3(&scale);
+}
+
 void Transform::SetObjectToWorldMatrix()
 {
-    XMMATRIX m = XMMatrixTranslationFromVector(worldPosition);
+    XMMATRIX m = XMMatrixScalingFromVector(scale)
+        * XMMatrixRotationQuaternion(rotation)
+        * XMMatrixTranslationFromVector(worldPosition);
     XMStoreFloat4x4(&transformConstant.ObjectToWorldMatrix, m);
 }
 
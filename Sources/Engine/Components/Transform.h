@@ -11,6 +11,9 @@ using std::shared_ptr;
 struct TransformConstant
 {
     XMFLOAT4X4 ObjectToWorldMatrix;
+    // Dequantization of packed vertex positions, identity for unpacked meshes.
+    XMFLOAT4 PositionScale;
+    XMFLOAT4 PositionOffset;
 };
 
 class Transform
@@ -24,6 +27,10 @@ protected:
     XMVECTOR forwardDirction;
     XMVECTOR upDirction;
 
+    // Placement of the object itself, the camera only moves its position and directions.
+    XMVECTOR rotation;
+    XMVECTOR scale;
+
     UINT id;
     TransformConstant transformConstant;
 
@@ -32,6 +39,7 @@ public:
     virtual ~Transform();
     
     void CopyWorldPosition(const Transform &other);
+    void SetTransform(const XMFLOAT3& position, const XMFLOAT4& rotation, const XMFLOAT3& scale);
     void SetObjectToWorldMatrix();
 
     virtual void ResetTransform();
@@ -1,13 +1,24 @@
 #include "stdafx.h"
 #include "D3D12BufferManager.h"
+#include <chrono>
 
-D3D12BufferManager::D3D12BufferManager(ComPtr<ID3D12Device>& device) :
-    pDevice(device)
+D3D12BufferManager::D3D12BufferManager(ComPtr<ID3D12Device>& device, ResourceStateTracker* resourceStateTracker) :
+    pDevice(device),
+    pResourceStateTracker(resourceStateTracker),
+    uploadRing(UPLOAD_RING_SIZE),
+    dedicatedUploadSize(0),
+    constantArena(CONSTANT_ARENA_SIZE),
+    framesNum(0),
+    allocationsNum(0),
+    dedicatedAllocationsNum(0),
+    peakUploadSize(0),
+    placedAllocationsNum(0),
+    placedAllocationTime(0.0)
 {
-    for (int i = 0; i < MAX_TEMP_UPLOAD_BUFFER_COUNT; i++)
-    {
-        tempUploadBufferPool[i] = nullptr;
-    }
+    pUploadRingBuffer = new D3D12UploadBuffer();
+    pUploadRingBuffer->CreateBuffer(pDevice.Get(), UPLOAD_RING_SIZE, D3D12_RESOURCE_STATE_GENERIC_READ, L"UploadRingBuffer");
+    CreateConstantArena(CONSTANT_ARENA_SIZE);
+
     for (int i = 0; i < MAX_UPLOAD_BUFFER_COUNT; i++)
     {
         uploadBufferPool[i] = nullptr;
@@ -21,7 +32,9 @@ D3D12BufferManager::D3D12BufferManager(ComPtr<ID3D12Device>& device) :
 D3D12BufferManager::~D3D12BufferManager()
 {
     // Release buffers in pools.
-    ReleaseTempUploadBuffer();
+    ReleaseTempUploadBuffer(UINT64_MAX);
+    delete pUploadRingBuffer;
+    delete pConstantArenaBuffer;
     for (int i = 0; i < MAX_READBACK_BUFFER_COUNT; i++)
     {
         if (readbackBufferPool[i] != nullptr)
@@ -46,47 +59,109 @@ D3D12BufferManager::~D3D12BufferManager()
             it->second = nullptr;
         }
     }
-
-    delete globalConstantBuffer;
-    for (auto it = perObjectConstantBuffers.begin(); it != perObjectConstantBuffers.end(); it++)
-    {
-        if (it->second != nullptr)
-        {
-            delete it->second;
-            it->second = nullptr;
-        }
-    }
 }
 
 void D3D12BufferManager::AllocateTempUploadBuffer(
     D3D12UploadBuffer* pBuffer,
     UINT64 size,
-    const wchar_t* name)
+    const wchar_t* name,
+    UINT64 alignment)
 {
-    D3D12UploadBuffer** ppBuffer = tempUploadBufferPool;
+    UINT64 offset = 0;
+    BOOL isDedicated = size > UPLOAD_RING_MAX_ALLOCATION_SIZE || !uploadRing.Allocate(size, alignment, offset);
+    if (isDedicated)
+    {
+        // Also taken when the ring is full, rather than waiting for the GPU.
+        pBuffer->CreateBuffer(pDevice.Get(), size, D3D12_RESOURCE_STATE_GENERIC_READ, name);
+        dedicatedUploadSize += size;
+        dedicatedAllocationsNum++;
+    }
+    else
+    {
+        pBuffer->CreateSubBuffer(pUploadRingBuffer, offset, size);
+    }
+    tempUploadBuffers.push_back({ pBuffer, UINT64_MAX, isDedicated });
 
-    for (UINT i = 0; i < MAX_TEMP_UPLOAD_BUFFER_COUNT; i++, ppBuffer++)
+    allocationsNum++;
+    peakUploadSize = max(peakUploadSize, GetUploadSize());
+}
+
+void* D3D12BufferManager::AllocateConstants(UINT64 size, D3D12_GPU_VIRTUAL_ADDRESS& gpuAddress)
+{
+    UINT64 offset = 0;
+    if (!constantArena.Allocate(size, UPLOAD_BUFFER_ALIGNMENT, offset))
     {
-        if (*ppBuffer != nullptr)
-        {
-            continue;
-        }
+        // Grow rather than wait for the GPU. The old arena is freed like a dedicated temp upload buffer,
+        // once the frames that read it are done.
+        tempUploadBuffers.push_back({ pConstantArenaBuffer, UINT64_MAX, TRUE });
+        dedicatedUploadSize += pConstantArenaBuffer->GetBufferSize();
+        CreateConstantArena(max(constantArena.GetCapacity(), size) * 2);
+        constantArena.Allocate(size, UPLOAD_BUFFER_ALIGNMENT, offset);
+    }
+    peakUploadSize = max(peakUploadSize, GetUploadSize());
 
-        *ppBuffer = pBuffer;
-        pBuffer->CreateBuffer(pDevice.Get(), size, D3D12_RESOURCE_STATE_GENERIC_READ, name);
-        break;
+    gpuAddress = pConstantArenaBuffer->GetGPUVirtualAddress() + offset;
+    return static_cast<BYTE*>(pConstantArenaBuffer->GetStartLocation()) + offset;
+}
+
+void D3D12BufferManager::RetireTempUploadBuffer(UINT64 fenceValue)
+{
+    uploadRing.Retire(fenceValue);
+    constantArena.Retire(fenceValue);
+    for (auto it = tempUploadBuffers.rbegin(); it != tempUploadBuffers.rend() && it->fenceValue == UINT64_MAX; it++)
+    {
+        it->fenceValue = fenceValue;
+    }
+    for (auto it = retiredDefaultBuffers.rbegin(); it != retiredDefaultBuffers.rend() && it->fenceValue == UINT64_MAX; it++)
+    {
+        it->fenceValue = fenceValue;
+    }
+    for (auto it = retiredReadbackBuffers.rbegin(); it != retiredReadbackBuffers.rend() && it->fenceValue == UINT64_MAX; it++)
+    {
+        it->fenceValue = fenceValue;
+    }
+
+    if (++framesNum % UPLOAD_RING_LOG_INTERVAL == 0)
+    {
+        WCHAR message[256];
+        swprintf_s(message, L"Upload memory: %.1f allocations per frame, %u dedicated, %.2f MB peak with a %.2f MB ring.\n",
+            static_cast<double>(allocationsNum) / UPLOAD_RING_LOG_INTERVAL, dedicatedAllocationsNum,
+            peakUploadSize / 1048576.0, uploadRing.GetCapacity() / 1048576.0);
+        OutputDebugStringW(message);
+        ReportDefaultHeaps();
+
+        allocationsNum = 0;
+        dedicatedAllocationsNum = 0;
+        peakUploadSize = GetUploadSize();
     }
 }
 
-void D3D12BufferManager::ReleaseTempUploadBuffer()
+void D3D12BufferManager::ReleaseTempUploadBuffer(UINT64 completedFenceValue)
 {
-    for (int i = 0; i < MAX_TEMP_UPLOAD_BUFFER_COUNT; i++)
+    uploadRing.Release(completedFenceValue);
+    constantArena.Release(completedFenceValue);
+    while (!tempUploadBuffers.empty() && tempUploadBuffers.front().fenceValue <= completedFenceValue)
     {
-        if (tempUploadBufferPool[i] != nullptr)
+        TempUploadBuffer& buffer = tempUploadBuffers.front();
+        if (buffer.isDedicated)
         {
-            delete tempUploadBufferPool[i];
-            tempUploadBufferPool[i] = nullptr;
+            dedicatedUploadSize -= buffer.pBuffer->GetBufferSize();
         }
+        delete buffer.pBuffer;
+        tempUploadBuffers.pop_front();
+    }
+
+    while (!retiredDefaultBuffers.empty() && retiredDefaultBuffers.front().fenceValue <= completedFenceValue)
+    {
+        FreePlacedBuffer(retiredDefaultBuffers.front().pBuffer);
+        delete retiredDefaultBuffers.front().pBuffer;
+        retiredDefaultBuffers.pop_front();
+    }
+
+    while (!retiredReadbackBuffers.empty() && retiredReadbackBuffers.front().fenceValue <= completedFenceValue)
+    {
+        delete retiredReadbackBuffers.front().pBuffer;
+        retiredReadbackBuffers.pop_front();
     }
 }
 
@@ -141,50 +216,266 @@ void D3D12BufferManager::AllocateDefaultBuffer(
         || defaultBufferPool.find(pResource) == defaultBufferPool.end())
     {
         D3D12DefaultBuffer* pbuffer = new D3D12DefaultBuffer();
-        pbuffer->CreateBuffer(pDevice.Get(), &pResource->GetResourceDesc(), state, name, clearValue);
+        if (!AllocatePlacedBuffer(pbuffer, pResource->GetResourceDesc(), state, name, clearValue))
+        {
+            pbuffer->CreateBuffer(pDevice.Get(), &pResource->GetResourceDesc(), state, name, clearValue);
+        }
         defaultBufferPool.insert(std::make_pair(pResource, pbuffer));
         pResource->SetResourceState(state);
         pResource->SetResourceLoaction(pbuffer->ResourceLocation.Resource);
+        TrackResourceState(pResource, state);
+    }
+}
+
+void D3D12BufferManager::AllocateReservedBuffer(
+    D3D12Resource* pResource,
+    D3D12_RESOURCE_STATES state,
+    const wchar_t* name)
+{
+    if (pResource->GetResource().Get() == nullptr
+        || defaultBufferPool.find(pResource) == defaultBufferPool.end())
+    {
+        D3D12DefaultBuffer* pbuffer = new D3D12DefaultBuffer();
+        pbuffer->CreateReservedBuffer(pDevice.Get(), &pResource->GetResourceDesc(), state, name);
+        defaultBufferPool.insert(std::make_pair(pResource, pbuffer));
+        pResource->SetResourceState(state);
+        pResource->SetResourceLoaction(pbuffer->ResourceLocation.Resource);
+        TrackResourceState(pResource, state);
+    }
+}
+
+void D3D12BufferManager::CreateAliasedHeap(UINT64 size)
+{
+    // Render targets can only be placed in heaps of their own on resource heap tier 1.
+    pAliasedHeap.Reset();
+    ThrowIfFailed(pDevice->CreateHeap(
+        &CD3DX12_HEAP_DESC(
+            size,
+            D3D12_HEAP_TYPE_DEFAULT,
+            D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT,
+            D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES),
+        IID_PPV_ARGS(&pAliasedHeap)));
+    pAliasedHeap->SetName(L"AliasedRenderTargetHeap");
+}
+
+void D3D12BufferManager::AllocateAliasedBuffer(
+    D3D12Resource* pResource,
+    UINT64 offset,
+    D3D12_RESOURCE_STATES state,
+    const wchar_t* name,
+    const D3D12_CLEAR_VALUE* clearValue)
+{
+    ReleaseDefaultBuffer(pResource);
+
+    D3D12DefaultBuffer* pbuffer = new D3D12DefaultBuffer();
+    pbuffer->CreateAliasedBuffer(pDevice.Get(), pAliasedHeap.Get(), offset, &pResource->GetResourceDesc(),
+        state, name, clearValue);
+    defaultBufferPool.insert(std::make_pair(pResource, pbuffer));
+    pResource->SetResourceState(state);
+    pResource->SetResourceLoaction(pbuffer->ResourceLocation.Resource);
+    TrackResourceState(pResource, state);
+}
+
+void D3D12BufferManager::ReleaseDefaultBuffer(D3D12Resource* pResource)
+{
+    auto it = defaultBufferPool.find(pResource);
+    if (it != defaultBufferPool.end())
+    {
+        // The placed memory is not reused before the GPU is done with the frames that use the buffer.
+        pResourceStateTracker->Unregister(it->second->ResourceLocation.Resource.Get());
+        retiredDefaultBuffers.push_back({ it->second, UINT64_MAX });
+        defaultBufferPool.erase(it);
     }
 }
 
-// Overflow case and Initialization problem.
-void D3D12BufferManager::AllocateGlobalConstantBuffer()
+void D3D12BufferManager::ReleaseUploadBuffer(D3D12UploadBuffer* pBuffer)
 {
-    const UINT size = 1024;
-    D3D12_RESOURCE_DESC desc = CD3DX12_RESOURCE_DESC::Buffer(size, D3D12_RESOURCE_FLAG_NONE);
-    globalConstantBuffer = new D3D12ConstantBuffer(desc, size);
+    for (UINT i = 0; i < MAX_UPLOAD_BUFFER_COUNT; i++)
+    {
+        if (uploadBufferPool[i] == pBuffer)
+        {
+            // Freed like a dedicated temp upload buffer.
+            uploadBufferPool[i] = nullptr;
+            tempUploadBuffers.push_back({ pBuffer, UINT64_MAX, TRUE });
+            dedicatedUploadSize += pBuffer->GetBufferSize();
+            break;
+        }
+    }
+}
+
+void D3D12BufferManager::ReleaseReadbackBuffer(D3D12ReadbackBuffer* pBuffer)
+{
+    for (UINT i = 0; i < MAX_READBACK_BUFFER_COUNT; i++)
+    {
+        if (readbackBufferPool[i] == pBuffer)
+        {
+            readbackBufferPool[i] = nullptr;
+            retiredReadbackBuffers.push_back({ pBuffer, UINT64_MAX });
+            break;
+        }
+    }
+}
+
+// Helper functions.
+void D3D12BufferManager::CreateConstantArena(UINT64 size)
+{
+    pConstantArenaBuffer = new D3D12UploadBuffer();
+    pConstantArenaBuffer->CreateBuffer(pDevice.Get(), size, D3D12_RESOURCE_STATE_GENERIC_READ, L"ConstantArena");
+    constantArena = RingAllocator(size);
+}
+
+BOOL D3D12BufferManager::AllocatePlacedBuffer(
+    D3D12DefaultBuffer* pBuffer,
+    const D3D12_RESOURCE_DESC& desc,
+    D3D12_RESOURCE_STATES state,
+    const wchar_t* name,
+    const D3D12_CLEAR_VALUE* clearValue)
+{
+    // Render targets, depth stencils and UAV textures stay committed, as placed memory does not
+    // start cleared and they are not always written before they are read.
+    const BOOL isBuffer = desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER;
+    const D3D12_RESOURCE_FLAGS committedFlags = D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET
+        | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL
+        | D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+    if (clearValue != nullptr || (!isBuffer && (desc.Flags & committedFlags) != 0))
+    {
+        return FALSE;
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    // Small textures can be 4KB aligned, when the device returns that alignment for them.
+    D3D12_RESOURCE_DESC placedDesc = desc;
+    D3D12_RESOURCE_ALLOCATION_INFO info = {};
+    if (!isBuffer)
+    {
+        placedDesc.Alignment = D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT;
+        info = pDevice->GetResourceAllocationInfo(0, 1, &placedDesc);
+    }
+    if (isBuffer || info.Alignment != D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT)
+    {
+        placedDesc.Alignment = 0;
+        info = pDevice->GetResourceAllocationInfo(0, 1, &placedDesc);
+    }
+    if (info.SizeInBytes > DEFAULT_HEAP_MAX_ALLOCATION_SIZE)
+    {
+        return FALSE;
+    }
+
+    const UINT heapType = (UINT)(isBuffer ? DefaultHeapType::Buffer : DefaultHeapType::Texture);
+    std::vector<DefaultHeapBlock>& heapBlocks = defaultHeapBlocks[heapType];
+    TLSFAllocation allocation = {};
+    UINT i = 0;
+    for (; i < heapBlocks.size(); i++)
+    {
+        if (heapBlocks[i].pHeap != nullptr && heapBlocks[i].allocator.Allocate(info.SizeInBytes, info.Alignment, allocation))
+        {
+            break;
+        }
+    }
 
-    D3D12UploadBuffer* uploadBuffer = new D3D12UploadBuffer();
-    AllocateUploadBuffer(uploadBuffer, size, D3D12_RESOURCE_STATE_GENERIC_READ, L"GlobalConstantBuffer");
-    globalConstantBuffer->SetResourceState(D3D12_RESOURCE_STATE_GENERIC_READ);
-    globalConstantBuffer->SetResourceLoaction(uploadBuffer->ResourceLocation.Resource);
-    globalConstantBuffer->SetStartLocation(uploadBuffer->GetStartLocation());
+    if (i == heapBlocks.size() || heapBlocks[i].pHeap == nullptr)
+    {
+        // Texture heaps are aligned for MSAA textures, which are placed at 4MB.
+        ComPtr<ID3D12Heap> pHeap;
+        ThrowIfFailed(pDevice->CreateHeap(
+            &CD3DX12_HEAP_DESC(
+                DEFAULT_HEAP_BLOCK_SIZE,
+                D3D12_HEAP_TYPE_DEFAULT,
+                isBuffer ? D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT : D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT,
+                isBuffer ? D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS : D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES),
+            IID_PPV_ARGS(&pHeap)));
+        pHeap->SetName(isBuffer ? L"DefaultBufferHeap" : L"DefaultTextureHeap");
+
+        DefaultHeapBlock block = { pHeap, TLSFAllocator(DEFAULT_HEAP_BLOCK_SIZE,
+            isBuffer ? D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT : D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT) };
+        i = 0;
+        while (i < heapBlocks.size() && heapBlocks[i].pHeap != nullptr)
+        {
+            i++;
+        }
+        if (i == heapBlocks.size())
+        {
+            heapBlocks.push_back(block);
+        }
+        else
+        {
+            heapBlocks[i] = block;
+        }
+        heapBlocks[i].allocator.Allocate(info.SizeInBytes, info.Alignment, allocation);
+    }
+
+    pBuffer->CreatePlacedBuffer(pDevice.Get(), heapBlocks[i].pHeap.Get(), heapType, i, allocation, &placedDesc, state, name);
+
+    std::chrono::duration<double, std::micro> duration = std::chrono::high_resolution_clock::now() - start;
+    placedAllocationTime += duration.count();
+    placedAllocationsNum++;
+    return TRUE;
 }
 
-void D3D12BufferManager::AllocatePerObjectConstantBuffers(UINT offset)
+void D3D12BufferManager::FreePlacedBuffer(D3D12DefaultBuffer* pBuffer)
 {
-    if (perObjectConstantBuffers[offset] != nullptr)
+    if (!pBuffer->IsPlaced())
     {
-        delete perObjectConstantBuffers[offset];
+        return;
     }
 
-    const UINT size = 1024;
-    D3D12_RESOURCE_DESC desc = CD3DX12_RESOURCE_DESC::Buffer(size, D3D12_RESOURCE_FLAG_NONE);
-    perObjectConstantBuffers[offset] = new D3D12ConstantBuffer(desc, size);
+    // Keep the first block of each type, and release the others once they are empty.
+    DefaultHeapBlock& block = defaultHeapBlocks[pBuffer->GetHeapType()][pBuffer->GetHeapBlock()];
+    block.allocator.Free(pBuffer->GetHeapAllocation());
+    if (block.allocator.IsEmpty() && pBuffer->GetHeapBlock() > 0)
+    {
+        block.pHeap.Reset();
+    }
+}
 
-    D3D12UploadBuffer* uploadBuffer = new D3D12UploadBuffer();
-    AllocateUploadBuffer(uploadBuffer, size, D3D12_RESOURCE_STATE_GENERIC_READ, L"PerObjectConstantBuffer");
-    perObjectConstantBuffers[offset]->SetResourceState(D3D12_RESOURCE_STATE_GENERIC_READ);
-    perObjectConstantBuffers[offset]->SetResourceLoaction(uploadBuffer->ResourceLocation.Resource);
-    perObjectConstantBuffers[offset]->SetStartLocation(uploadBuffer->GetStartLocation());
+void D3D12BufferManager::TrackResourceState(D3D12Resource* pResource, D3D12_RESOURCE_STATES state)
+{
+    const D3D12_RESOURCE_DESC& desc = pResource->GetResourceDesc();
+    UINT subresourcesNum = 1;
+    if (desc.Dimension != D3D12_RESOURCE_DIMENSION_BUFFER)
+    {
+        subresourcesNum = desc.MipLevels
+            * (desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D ? 1 : desc.DepthOrArraySize);
+    }
+
+    pResourceStateTracker->Register(pResource->GetResource().Get(), state, subresourcesNum);
 }
 
-D3D12ConstantBuffer* D3D12BufferManager::GetPerObjectConstantBufferAtIndex(UINT index)
+void D3D12BufferManager::ReportDefaultHeaps()
 {
-    if (perObjectConstantBuffers[index] != nullptr)
+    const wchar_t* typeNames[(UINT)DefaultHeapType::Count] = { L"Buffer", L"Texture" };
+    WCHAR message[256];
+    for (UINT i = 0; i < (UINT)DefaultHeapType::Count; i++)
+    {
+        // Fragmentation is the share of the free memory outside the largest free range.
+        UINT blocksNum = 0;
+        UINT64 usedSize = 0;
+        UINT64 freeSize = 0;
+        UINT64 largestFreeSize = 0;
+        for (const DefaultHeapBlock& block : defaultHeapBlocks[i])
+        {
+            if (block.pHeap != nullptr)
+            {
+                blocksNum++;
+                usedSize += block.allocator.GetUsedSize();
+                freeSize += block.allocator.GetCapacity() - block.allocator.GetUsedSize();
+                largestFreeSize = max(largestFreeSize, block.allocator.GetLargestFreeSize());
+            }
+        }
+
+        swprintf_s(message, L"%s heaps: %u blocks, %.2f MB used, %.2f MB free, %.1f%% fragmented.\n",
+            typeNames[i], blocksNum, usedSize / 1048576.0, freeSize / 1048576.0,
+            freeSize > 0 ? 100.0 * (freeSize - largestFreeSize) / freeSize : 0.0);
+        OutputDebugStringW(message);
+    }
+
+    if (placedAllocationsNum > 0)
     {
-        return perObjectConstantBuffers[index];
+        swprintf_s(message, L"Placed %u resources in %.1f us on average.\n",
+            placedAllocationsNum, placedAllocationTime / placedAllocationsNum);
+        OutputDebugStringW(message);
     }
-    return nullptr;
+    placedAllocationsNum = 0;
+    placedAllocationTime = 0.0;
 }
@@ -1,9 +1,31 @@
 #pragma once
+#include "RingAllocator.h"
+#include "TLSFAllocator.h"
+#include "ResourceStateTracker.h"
 
-#define MAX_TEMP_UPLOAD_BUFFER_COUNT 100
+// Temp upload buffers are sub-allocated from one persistently mapped ring of this size.
+#define UPLOAD_RING_SIZE (64 * 1024 * 1024)
+// Larger temp upload buffers get a committed resource of their own, so they do not stall the ring.
+#define UPLOAD_RING_MAX_ALLOCATION_SIZE (UPLOAD_RING_SIZE / 4)
+// Constants of the frames in flight are sub-allocated from one persistently mapped ring, which starts
+// at this size and doubles when a frame needs more.
+#define CONSTANT_ARENA_SIZE (4 * 1024 * 1024)
+// Frames between two reports of the upload memory.
+#define UPLOAD_RING_LOG_INTERVAL 600
+// Default buffers and textures are placed in heap blocks of this size. Larger ones are committed.
+#define DEFAULT_HEAP_BLOCK_SIZE (64 * 1024 * 1024)
+#define DEFAULT_HEAP_MAX_ALLOCATION_SIZE (DEFAULT_HEAP_BLOCK_SIZE / 2)
 #define MAX_READBACK_BUFFER_COUNT 10
 #define MAX_UPLOAD_BUFFER_COUNT 10
 
+// The heaps of resource heap tier 1 only hold one kind of resource each.
+enum class DefaultHeapType
+{
+	Buffer = 0,
+	Texture = 1,
+	Count = 2,
+};
+
 enum class UploadBufferType
 {
 	Constant = 0,
@@ -18,23 +40,98 @@ class D3D12DescriptorHeapManager;
 class D3D12BufferManager
 {
 private:
+	struct TempUploadBuffer
+	{
+		D3D12UploadBuffer* pBuffer;
+		UINT64 fenceValue;
+		BOOL isDedicated;
+	};
+
+	// A default buffer released while the frames in flight may still use it.
+	struct RetiredDefaultBuffer
+	{
+		D3D12DefaultBuffer* pBuffer;
+		UINT64 fenceValue;
+	};
+
+	// A readback buffer released while the frames in flight may still copy to it.
+	struct RetiredReadbackBuffer
+	{
+		D3D12ReadbackBuffer* pBuffer;
+		UINT64 fenceValue;
+	};
+
+	struct DefaultHeapBlock
+	{
+		ComPtr<ID3D12Heap> pHeap;
+		TLSFAllocator allocator;
+	};
+
 	ComPtr<ID3D12Device> pDevice;
-	D3D12UploadBuffer* tempUploadBufferPool[MAX_TEMP_UPLOAD_BUFFER_COUNT];
+	ResourceStateTracker* pResourceStateTracker;
+	D3D12UploadBuffer* pUploadRingBuffer;
+	RingAllocator uploadRing;
+	// Temp upload buffers in the order they were allocated. The ones not retired yet are at the back,
+	// with a fence value of UINT64_MAX.
+	std::deque<TempUploadBuffer> tempUploadBuffers;
+	UINT64 dedicatedUploadSize;
+	D3D12UploadBuffer* pConstantArenaBuffer;
+	RingAllocator constantArena;
+
+	// Upload metrics since the last report.
+	UINT framesNum;
+	UINT allocationsNum;
+	UINT dedicatedAllocationsNum;
+	UINT64 peakUploadSize;
+
 	D3D12UploadBuffer* uploadBufferPool[MAX_UPLOAD_BUFFER_COUNT];
 	D3D12ReadbackBuffer* readbackBufferPool[MAX_READBACK_BUFFER_COUNT];
 	std::unordered_map<const void*, D3D12DefaultBuffer*> defaultBufferPool;
-	D3D12ConstantBuffer* globalConstantBuffer;
-	std::map<UINT, D3D12ConstantBuffer*> perObjectConstantBuffers;
+	// Released default buffers in the order they were released, the ones not retired yet at the back.
+	std::deque<RetiredDefaultBuffer> retiredDefaultBuffers;
+	std::deque<RetiredReadbackBuffer> retiredReadbackBuffers;
+	// Blocks whose heap has been released are reused for the next heap of their type.
+	std::vector<DefaultHeapBlock> defaultHeapBlocks[(UINT)DefaultHeapType::Count];
+	// The heap the transient render targets of the frame are aliased in.
+	ComPtr<ID3D12Heap> pAliasedHeap;
+	UINT placedAllocationsNum;
+	double placedAllocationTime;
+
+	void CreateConstantArena(UINT64 size);
+	// Place a default buffer in a heap block. Returns FALSE if it has to be a committed resource.
+	BOOL AllocatePlacedBuffer(
+		D3D12DefaultBuffer* pBuffer,
+		const D3D12_RESOURCE_DESC& desc,
+		D3D12_RESOURCE_STATES state,
+		const wchar_t* name,
+		const D3D12_CLEAR_VALUE* clearValue);
+	void FreePlacedBuffer(D3D12DefaultBuffer* pBuffer);
+	// Track the state of each subresource of a default buffer, from the state it is created in.
+	void TrackResourceState(D3D12Resource* pResource, D3D12_RESOURCE_STATES state);
+	void ReportDefaultHeaps();
+	inline const UINT64 GetUploadSize() const
+	{
+		return uploadRing.GetUsedSize() + constantArena.GetUsedSize() + dedicatedUploadSize;
+	}
 
 public:
-	D3D12BufferManager(ComPtr<ID3D12Device>& device);
+	D3D12BufferManager(ComPtr<ID3D12Device>& device, ResourceStateTracker* resourceStateTracker);
 	~D3D12BufferManager();
 
+	// Allocate an upload buffer that lives until the GPU has read it, and take ownership of it.
 	void AllocateTempUploadBuffer(
 		D3D12UploadBuffer* pBuffer,
 		UINT64 size,
-		const wchar_t* name = nullptr);
-	void ReleaseTempUploadBuffer();
+		const wchar_t* name = nullptr,
+		UINT64 alignment = UPLOAD_BUFFER_ALIGNMENT);
+	// Allocate constants for the frame being recorded, aligned for constant buffer views. They are written
+	// at the returned address and live until the GPU has read them, like temp upload buffers.
+	void* AllocateConstants(UINT64 size, D3D12_GPU_VIRTUAL_ADDRESS& gpuAddress);
+	// The temp upload buffers and constants allocated so far, and the buffers released so far, are used by
+	// the GPU work submitted before fenceValue is signaled.
+	void RetireTempUploadBuffer(UINT64 fenceValue);
+	// Free the temp upload buffers, constants and released buffers the GPU is done with.
+	void ReleaseTempUploadBuffer(UINT64 completedFenceValue);
 
 	void AllocateUploadBuffer(
 		D3D12UploadBuffer* pBuffer,
@@ -50,10 +147,26 @@ public:
 		D3D12_RESOURCE_STATES state = D3D12_RESOURCE_STATE_COPY_DEST,
 		const wchar_t* name = nullptr,
 		const D3D12_CLEAR_VALUE* clearValue = nullptr);
-
-	void AllocateGlobalConstantBuffer();
-	void AllocatePerObjectConstantBuffers(UINT offset);
-
-	inline D3D12ConstantBuffer* GetGlobalConstantBuffer() const { return globalConstantBuffer; }
-	D3D12ConstantBuffer* GetPerObjectConstantBufferAtIndex(UINT);
+	// Allocate a reserved texture, which has no memory until its tiles are mapped.
+	void AllocateReservedBuffer(
+		D3D12Resource* pResource,
+		D3D12_RESOURCE_STATES state = D3D12_RESOURCE_STATE_COPY_DEST,
+		const wchar_t* name = nullptr);
+	// Create the heap that transient render targets are aliased in, which replaces the one before.
+	void CreateAliasedHeap(UINT64 size);
+	// Allocate a render target at an offset of the aliased heap. Only one of the targets that overlap can
+	// hold data at a time, the one an aliasing barrier was last recorded for.
+	void AllocateAliasedBuffer(
+		D3D12Resource* pResource,
+		UINT64 offset,
+		D3D12_RESOURCE_STATES state,
+		const wchar_t* name = nullptr,
+		const D3D12_CLEAR_VALUE* clearValue = nullptr);
+	// Take the buffer away from the resource. Its memory is freed once the GPU has finished the frames in
+	// flight, which may still use it.
+	void ReleaseDefaultBuffer(D3D12Resource* pResource);
+	// Take an upload or a readback buffer out of its pool, and delete it once the GPU has finished the
+	// frames in flight, which may still use it.
+	void ReleaseUploadBuffer(D3D12UploadBuffer* pBuffer);
+	void ReleaseReadbackBuffer(D3D12ReadbackBuffer* pBuffer);
 };
@@ -1,69 +1,48 @@
 #include "stdafx.h"
 #include "D3D12DescriptorHeapManager.h"
 
-D3D12DescriptorHeapManager::D3D12DescriptorHeapManager(ComPtr<ID3D12Device> &device, BOOL isDXR)
+D3D12DescriptorHeapManager::D3D12DescriptorHeapManager(ComPtr<ID3D12Device> &device, BOOL isDXR) :
+    textureSlotAllocator(TEXTURE_SLOTS_NUM),
+    samplersNum(0),
+    frameIndex(0)
 {
-    // Describe and create constant buffer view (CBV) descriptor heaps.
-    D3D12_DESCRIPTOR_HEAP_DESC cbvHeapDesc = {};
-    cbvHeapDesc.NumDescriptors = 1;
-    cbvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-    cbvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-    ThrowIfFailed(device->CreateDescriptorHeap(&cbvHeapDesc, IID_PPV_ARGS(&heapTable[CONSTANT_BUFFER_VIEW_GLOBAL])));
-
-    cbvHeapDesc.NumDescriptors = 10;
-    ThrowIfFailed(device->CreateDescriptorHeap(&cbvHeapDesc, IID_PPV_ARGS(&heapTable[CONSTANT_BUFFER_VIEW_PEROBJECT])));
-
-    sizeTable[CONSTANT_BUFFER_VIEW_GLOBAL] = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-    sizeTable[CONSTANT_BUFFER_VIEW_PEROBJECT] = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-
-    // Describe and create a shader resource view (SRV) descriptor heap.
-    D3D12_DESCRIPTOR_HEAP_DESC srvHeapDesc = {};
-    srvHeapDesc.NumDescriptors = 10;
-    srvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-    srvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-    ThrowIfFailed(device->CreateDescriptorHeap(&srvHeapDesc, IID_PPV_ARGS(&heapTable[SHADER_RESOURCE_VIEW_PEROBJECT])));
-
-    srvHeapDesc.NumDescriptors = 10;
-    ThrowIfFailed(device->CreateDescriptorHeap(&srvHeapDesc, IID_PPV_ARGS(&heapTable[SHADER_RESOURCE_VIEW_GLOBAL])));
-
-    sizeTable[SHADER_RESOURCE_VIEW_PEROBJECT] = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-    sizeTable[SHADER_RESOURCE_VIEW_GLOBAL] = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-
-    // Describe and create a unordered access view (UAV) descriptor heap.
-    D3D12_DESCRIPTOR_HEAP_DESC uavHeapDesc = {};
-    uavHeapDesc.NumDescriptors = 2;
-    uavHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-    uavHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-    ThrowIfFailed(device->CreateDescriptorHeap(&uavHeapDesc, IID_PPV_ARGS(&heapTable[UNORDERED_ACCESS_VIEW])));
-
-    sizeTable[UNORDERED_ACCESS_VIEW] = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-
-    // Describe and create a sampler descriptor heap.
-    D3D12_DESCRIPTOR_HEAP_DESC samplerHeapDesc = {};
-    samplerHeapDesc.NumDescriptors = 10;
-    samplerHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER;
-    samplerHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-    ThrowIfFailed(device->CreateDescriptorHeap(&samplerHeapDesc, IID_PPV_ARGS(&heapTable[SAMPLER])));
-
-    sizeTable[SAMPLER] = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    // Describe and create the shader visible CBV/SRV/UAV heap, with the global views first and the
+    // copies of the texture slots of the frames after them.
+    const UINT resourceRegions[] =
+    {
+        CONSTANT_BUFFER_VIEW_GLOBAL,
+        SHADER_RESOURCE_VIEW_GLOBAL,
+        UNORDERED_ACCESS_VIEW,
+        SHADER_RESOURCE_VIEW_PEROBJECT,
+    };
+    const UINT resourceRegionSizes[] = { 1, 16, 2, TEXTURE_SLOTS_NUM * FRAMES_IN_FLIGHT };
+    CreateHeap(device, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, TRUE,
+        resourceRegions, resourceRegionSizes, _countof(resourceRegions));
+
+    // Describe and create the staging heap of the texture slots, which only the CPU sees.
+    D3D12_DESCRIPTOR_HEAP_DESC stagingHeapDesc = {};
+    stagingHeapDesc.NumDescriptors = TEXTURE_SLOTS_NUM;
+    stagingHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+    stagingHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+    ThrowIfFailed(device->CreateDescriptorHeap(&stagingHeapDesc, IID_PPV_ARGS(&pStagingHeap)));
+
+    // Describe and create the shader visible sampler heap.
+    const UINT samplerRegions[] = { SAMPLER };
+    const UINT samplerRegionSizes[] = { SAMPLERS_NUM };
+    CreateHeap(device, D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER, TRUE,
+        samplerRegions, samplerRegionSizes, _countof(samplerRegions));
 
     // Describe and create a render target view (RTV) descriptor heap.
-    D3D12_DESCRIPTOR_HEAP_DESC rtvHeapDesc = {};
-    rtvHeapDesc.NumDescriptors = FRAME_COUNT + 10;
-    rtvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
-    rtvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
-    ThrowIfFailed(device->CreateDescriptorHeap(&rtvHeapDesc, IID_PPV_ARGS(&heapTable[RENDER_TARGET_VIEW])));
-
-    sizeTable[RENDER_TARGET_VIEW] = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
+    const UINT rtvRegions[] = { RENDER_TARGET_VIEW };
+    const UINT rtvRegionSizes[] = { FRAME_COUNT + 10 };
+    CreateHeap(device, D3D12_DESCRIPTOR_HEAP_TYPE_RTV, FALSE,
+        rtvRegions, rtvRegionSizes, _countof(rtvRegions));
 
     // Describe and create a depth stencil view (DSV) descriptor heap.
-    D3D12_DESCRIPTOR_HEAP_DESC dsvHeapDesc = {};
-    dsvHeapDesc.NumDescriptors = 1;
-    dsvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_DSV;
-    dsvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
-    ThrowIfFailed(device->CreateDescriptorHeap(&dsvHeapDesc, IID_PPV_ARGS(&heapTable[DEPTH_STENCIL_VIEW])));
-
-    sizeTable[DEPTH_STENCIL_VIEW] = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_DSV);
+    const UINT dsvRegions[] = { DEPTH_STENCIL_VIEW };
+    const UINT dsvRegionSizes[] = { 1 };
+    CreateHeap(device, D3D12_DESCRIPTOR_HEAP_TYPE_DSV, FALSE,
+        dsvRegions, dsvRegionSizes, _countof(dsvRegions));
 }
 
 D3D12DescriptorHeapManager::~D3D12DescriptorHeapManager()
@@ -74,24 +53,29 @@ D3D12DescriptorHeapManager::~D3D12DescriptorHeapManager()
 D3D12_CPU_DESCRIPTOR_HANDLE D3D12DescriptorHeapManager::GetHandle(UINT index, INT offset)
 {
     CD3DX12_CPU_DESCRIPTOR_HANDLE handle(heapTable[index]->GetCPUDescriptorHandleForHeapStart());
-    handle.Offset(offset, sizeTable[index]);
+    handle.Offset(startTable[index] + offset, sizeTable[index]);
 
     return handle;
 }
 
+void D3D12DescriptorHeapManager::SetDescriptorHeaps(ComPtr<ID3D12GraphicsCommandList>& commandList)
+{
+    ID3D12DescriptorHeap* heaps[] =
+    {
+        heapTable[SHADER_RESOURCE_VIEW_PEROBJECT].Get(),
+        heapTable[SAMPLER].Get(),
+    };
+    commandList->SetDescriptorHeaps(_countof(heaps), heaps);
+}
+
 void D3D12DescriptorHeapManager::SetViews(
     ComPtr<ID3D12GraphicsCommandList>& commandList,
     UINT index,
     UINT rootIndex,
     INT offset)
 {
-    ID3D12DescriptorHeap* heap[] = { heapTable[index].Get() };
-    
-    CD3DX12_GPU_DESCRIPTOR_HANDLE handle(heapTable[index]->GetGPUDescriptorHandleForHeapStart());
-    handle.Offset(offset, sizeTable[index]);
-
-    commandList->SetDescriptorHeaps(_countof(heap), heap);
-    commandList->SetGraphicsRootDescriptorTable(rootIndex, handle);
+    offset = index == SHADER_RESOURCE_VIEW_PEROBJECT ? GetFrameOffset(offset) : offset;
+    commandList->SetGraphicsRootDescriptorTable(rootIndex, GetGPUHandle(index, offset));
 }
 
 void D3D12DescriptorHeapManager::SetComputeViews(
@@ -100,11 +84,168 @@ void D3D12DescriptorHeapManager::SetComputeViews(
     UINT rootIndex,
     INT offset)
 {
-    ID3D12DescriptorHeap* heap[] = { heapTable[index].Get() };
+    offset = index == SHADER_RESOURCE_VIEW_PEROBJECT ? GetFrameOffset(offset) : offset;
+    commandList->SetComputeRootDescriptorTable(rootIndex, GetGPUHandle(index, offset));
+}
+
+UINT D3D12DescriptorHeapManager::AllocateTextureSlots(UINT count)
+{
+    UINT id;
+    ThrowIfFalse(textureSlotAllocator.Allocate(count, id));
+
+    return id;
+}
+
+void D3D12DescriptorHeapManager::FreeTextureSlots(UINT id, UINT count)
+{
+    textureSlotAllocator.Free(id, count);
+}
 
+void D3D12DescriptorHeapManager::RetireTextureSlots(UINT64 fenceValue)
+{
+    textureSlotAllocator.Retire(fenceValue);
+}
+
+void D3D12DescriptorHeapManager::ReleaseTextureSlots(UINT64 completedFenceValue)
+{
+    textureSlotAllocator.Release(completedFenceValue);
+}
+
+void D3D12DescriptorHeapManager::CreateView(
+    const ComPtr<ID3D12Device>& device,
+    D3D12Resource* pBuffer,
+    UINT index,
+    INT offset)
+{
+    DescriptorCache& viewCache = viewCaches[index];
+    std::string key;
+    if (!pBuffer->GetViewKey(key))
+    {
+        viewCache.Remove(offset);
+        pBuffer->CreateView(device, GetHandle(index, offset));
+        return;
+    }
+
+    if (viewCache.Contains(key, offset))
+    {
+        return;
+    }
+
+    pBuffer->CreateView(device, GetHandle(index, offset));
+    viewCache.Insert(key, offset);
+}
+
+void D3D12DescriptorHeapManager::StageView(const ComPtr<ID3D12Device>& device, D3D12Resource* pBuffer, INT offset)
+{
+    // The cache holds what the slot holds once the staged views are committed.
+    DescriptorCache& viewCache = viewCaches[SHADER_RESOURCE_VIEW_PEROBJECT];
+    std::string key;
+    const BOOL isKeyed = pBuffer->GetViewKey(key);
+    if (isKeyed && viewCache.Contains(key, offset))
+    {
+        return;
+    }
+
+    CD3DX12_CPU_DESCRIPTOR_HANDLE handle(pStagingHeap->GetCPUDescriptorHandleForHeapStart(),
+        offset, sizeTable[SHADER_RESOURCE_VIEW_PEROBJECT]);
+    pBuffer->CreateView(device, handle);
+    if (isKeyed)
+    {
+        viewCache.Insert(key, offset);
+    }
+    else
+    {
+        viewCache.Remove(offset);
+    }
+    for (UINT i = 0; i < FRAMES_IN_FLIGHT; i++)
+    {
+        stagedViews[i].push_back(offset);
+    }
+}
+
+void D3D12DescriptorHeapManager::CommitStagedViews(const ComPtr<ID3D12Device>& device, UINT inFrameIndex)
+{
+    // A slot staged again before the frame commits is copied with the view it holds last.
+    frameIndex = inFrameIndex;
+    for (INT offset : stagedViews[frameIndex])
+    {
+        CD3DX12_CPU_DESCRIPTOR_HANDLE handle(pStagingHeap->GetCPUDescriptorHandleForHeapStart(),
+            offset, sizeTable[SHADER_RESOURCE_VIEW_PEROBJECT]);
+        device->CopyDescriptorsSimple(1, GetHandle(SHADER_RESOURCE_VIEW_PEROBJECT, GetFrameOffset(offset)), handle,
+            D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    }
+    stagedViews[frameIndex].clear();
+}
+
+UINT D3D12DescriptorHeapManager::CreateSampler(const ComPtr<ID3D12Device>& device, const D3D12_SAMPLER_DESC& desc)
+{
+    std::string key;
+    DescriptorCache::AppendKey(key, desc);
+
+    UINT id;
+    if (samplerCache.Find(key, id))
+    {
+        return id;
+    }
+
+    ThrowIfFalse(samplersNum < SAMPLERS_NUM);
+    id = samplersNum++;
+    device->CreateSampler(&desc, GetHandle(SAMPLER, id));
+    samplerCache.Insert(key, id);
+
+    return id;
+}
+
+void D3D12DescriptorHeapManager::ReportDescriptorCaches()
+{
+    UINT64 viewHitsNum = 0;
+    UINT64 viewLookupsNum = 0;
+    for (auto it = viewCaches.begin(); it != viewCaches.end(); it++)
+    {
+        viewHitsNum += it->second.GetHitsNum();
+        viewLookupsNum += it->second.GetHitsNum() + it->second.GetMissesNum();
+    }
+    const UINT64 samplerLookupsNum = samplerCache.GetHitsNum() + samplerCache.GetMissesNum();
+
+    WCHAR message[256];
+    swprintf_s(message, L"Descriptor cache: %.1f%% of %llu views reused, %u samplers for %llu textures.\n",
+        viewLookupsNum > 0 ? 100.0 * viewHitsNum / viewLookupsNum : 0.0, viewLookupsNum,
+        samplersNum, samplerLookupsNum);
+    OutputDebugStringW(message);
+}
+
+// Helper functions.
+void D3D12DescriptorHeapManager::CreateHeap(
+    ComPtr<ID3D12Device>& device,
+    D3D12_DESCRIPTOR_HEAP_TYPE type,
+    BOOL isShaderVisible,
+    const UINT* pRegions,
+    const UINT* pRegionSizes,
+    UINT regionsNum)
+{
+    D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
+    heapDesc.NumDescriptors = 0;
+    heapDesc.Type = type;
+    heapDesc.Flags = isShaderVisible ? D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE : D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+    for (UINT i = 0; i < regionsNum; i++)
+    {
+        startTable[pRegions[i]] = heapDesc.NumDescriptors;
+        sizeTable[pRegions[i]] = device->GetDescriptorHandleIncrementSize(type);
+        heapDesc.NumDescriptors += pRegionSizes[i];
+    }
+
+    ComPtr<ID3D12DescriptorHeap> pHeap;
+    ThrowIfFailed(device->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(&pHeap)));
+    for (UINT i = 0; i < regionsNum; i++)
+    {
+        heapTable[pRegions[i]] = pHeap;
+    }
+}
+
+D3D12_GPU_DESCRIPTOR_HANDLE D3D12DescriptorHeapManager::GetGPUHandle(UINT index, INT offset)
+{
     CD3DX12_GPU_DESCRIPTOR_HANDLE handle(heapTable[index]->GetGPUDescriptorHandleForHeapStart());
-    handle.Offset(offset, sizeTable[index]);
+    handle.Offset(startTable[index] + offset, sizeTable[index]);
 
-    commandList->SetDescriptorHeaps(_countof(heap), heap);
-    commandList->SetComputeRootDescriptorTable(rootIndex, handle);
+    return handle;
 }
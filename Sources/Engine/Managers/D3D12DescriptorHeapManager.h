@@ -1,26 +1,87 @@
 #pragma once
+#include "DescriptorAllocator.h"
+#include "DescriptorCache.h"
 
+// Regions of the descriptor heaps.
 #define CONSTANT_BUFFER_VIEW_GLOBAL 0
-#define CONSTANT_BUFFER_VIEW_PEROBJECT 1
-#define SHADER_RESOURCE_VIEW_GLOBAL 2
+#define SHADER_RESOURCE_VIEW_GLOBAL 1
+#define UNORDERED_ACCESS_VIEW 2
 #define SHADER_RESOURCE_VIEW_PEROBJECT 3
-#define UNORDERED_ACCESS_VIEW 4
-#define SAMPLER 5
-#define RENDER_TARGET_VIEW 6
-#define DEPTH_STENCIL_VIEW 7
+#define SAMPLER 4
+#define RENDER_TARGET_VIEW 5
+#define DEPTH_STENCIL_VIEW 6
+
+// Bindless texture slots, which shaders index with the slot of the draw. The shader visible heap holds a copy
+// of them for each frame in flight.
+#define TEXTURE_SLOTS_NUM 65536
+// Samplers are shared by description, shaders index them with the sampler IDs of the draw.
+#define SAMPLERS_NUM D3D12_MAX_SHADER_VISIBLE_SAMPLER_HEAP_SIZE
+#define DESCRIPTOR_CACHE_LOG_INTERVAL 600
 
 class D3D12DescriptorHeapManager
 {
 private:
+	// The heap, the first descriptor and the descriptor size of each region. The shader visible regions
+	// share one CBV/SRV/UAV heap and one sampler heap.
 	std::map<UINT, ComPtr<ID3D12DescriptorHeap>> heapTable;
+	std::map<UINT, UINT> startTable;
 	std::map<UINT, UINT> sizeTable;
 
+	DescriptorAllocator textureSlotAllocator;
+	DescriptorCache samplerCache;
+	UINT samplersNum;
+	// The views each region holds, by the offset of their descriptor.
+	std::map<UINT, DescriptorCache> viewCaches;
+	// A copy of the texture slots the CPU writes views to, and the slots written since each frame last
+	// committed them to its copy in the shader visible heap.
+	ComPtr<ID3D12DescriptorHeap> pStagingHeap;
+	std::vector<INT> stagedViews[FRAMES_IN_FLIGHT];
+	// The frame whose copy of the texture slots the views are bound from.
+	UINT frameIndex;
+
+	// Helper functions.
+	void CreateHeap(
+		ComPtr<ID3D12Device>& device,
+		D3D12_DESCRIPTOR_HEAP_TYPE type,
+		BOOL isShaderVisible,
+		const UINT* pRegions,
+		const UINT* pRegionSizes,
+		UINT regionsNum);
+	D3D12_GPU_DESCRIPTOR_HANDLE GetGPUHandle(UINT index, INT offset);
+	// The offset of a texture slot in the copy of the frame the views are bound from.
+	inline const INT GetFrameOffset(INT offset) const { return offset + static_cast<INT>(frameIndex * TEXTURE_SLOTS_NUM); }
+
 public:
 	D3D12DescriptorHeapManager(ComPtr<ID3D12Device>& device, BOOL isDXR);
 	~D3D12DescriptorHeapManager();
 
 	D3D12_CPU_DESCRIPTOR_HANDLE GetHandle(UINT index, INT offset);
 
+	// Bind the shader visible heaps, once per command list.
+	void SetDescriptorHeaps(ComPtr<ID3D12GraphicsCommandList>&);
 	void SetViews(ComPtr<ID3D12GraphicsCommandList>&, UINT index, UINT rootIndex, INT offset);
 	void SetComputeViews(ComPtr<ID3D12GraphicsCommandList>&, UINT index, UINT rootIndex, INT offset);
-};
\ No newline at end of file
+
+	// Reserve count consecutive texture slots, for the views and the samplers of textures.
+	UINT AllocateTextureSlots(UINT count);
+	// Free texture slots, which are reused after the GPU has finished the work submitted so far.
+	void FreeTextureSlots(UINT id, UINT count);
+	void RetireTextureSlots(UINT64 fenceValue);
+	void ReleaseTextureSlots(UINT64 completedFenceValue);
+
+	// Write the view of a buffer to a descriptor, unless the descriptor already holds that view. The views
+	// written to a region must all go through here, or the region must not be cached.
+	void CreateView(const ComPtr<ID3D12Device>&, D3D12Resource* pBuffer, UINT index, INT offset);
+	// Write the view of a buffer to the staging copy of a texture slot, unless the slot already holds that
+	// view, and copy it to the copy of every frame as it commits the staged views. Views of the texture
+	// slots go through here, as they are rewritten while the frames in flight read them.
+	void StageView(const ComPtr<ID3D12Device>&, D3D12Resource* pBuffer, INT offset);
+	// Copy the views staged since a frame last committed to its copy of the texture slots, which the views
+	// are bound from until the next commit. The GPU must have finished the last frame of the slot.
+	void CommitStagedViews(const ComPtr<ID3D12Device>&, UINT inFrameIndex);
+	// Get the ID of the sampler with a description, which is created the first time it is asked for.
+	UINT CreateSampler(const ComPtr<ID3D12Device>&, const D3D12_SAMPLER_DESC& desc);
+	void ReportDescriptorCaches();
+
+	inline const UINT GetSamplersNum() const { return samplersNum; }
+};
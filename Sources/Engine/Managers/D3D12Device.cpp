@@ -4,7 +4,8 @@
 
 D3D12Device::D3D12Device(BOOL isDXR) :
     useWarpDevice(false),
-    isDXR(isDXR)
+    isDXR(isDXR),
+    frameIndex(0)
 {
 
 }
@@ -14,6 +15,7 @@ D3D12Device::~D3D12Device()
     pDevice->Release();
 
     delete pBufferManager;
+    delete pResourceStateTracker;
     delete pDescriptorHeapManager;
 }
 
@@ -74,8 +76,11 @@ void D3D12Device::CreateDevice()
 
     ThrowIfFailed(pDevice->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&pCommandQueue)));
 
-    // Create the command allocator.
-    ThrowIfFailed(pDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&pCommandAllocator)));
+    // Create a command allocator for each frame in flight.
+    for (UINT i = 0; i < FRAMES_IN_FLIGHT; i++)
+    {
+        ThrowIfFailed(pDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&pCommandAllocators[i])));
+    }
 }
 
 // Helper function for acquiring the first available hardware adapter that supports Direct3D 12.
@@ -153,5 +158,7 @@ void D3D12Device::CreateDescriptorHeapManager()
 
 void D3D12Device::CreateBufferManager()
 {
-    pBufferManager = new D3D12BufferManager(pDevice);
+    // The buffer manager tracks the states of the resources it creates, from creation to release.
+    pResourceStateTracker = new ResourceStateTracker();
+    pBufferManager = new D3D12BufferManager(pDevice, pResourceStateTracker);
 }
@@ -11,13 +11,16 @@ protected:
     ComPtr<ID3D12Device> pDevice;
     ComPtr<IDXGIFactory4> pFactory;
     ComPtr<ID3D12CommandQueue> pCommandQueue;
-    ComPtr<ID3D12CommandAllocator> pCommandAllocator;
+    ComPtr<ID3D12CommandAllocator> pCommandAllocators[FRAMES_IN_FLIGHT];
+    // The slot of the per-frame resources of the frame being recorded.
+    UINT frameIndex;
 
     // DirectX Raytracing (DXR) attributes
     ComPtr<ID3D12Device5> pDXRDevice;
 
     D3D12DescriptorHeapManager* pDescriptorHeapManager;
     D3D12BufferManager* pBufferManager;
+    ResourceStateTracker* pResourceStateTracker;
 
     void GetHardwareAdapter(
         _In_ IDXGIFactory1* pFactory,
@@ -36,8 +39,12 @@ public:
     inline ComPtr<ID3D12Device5> GetDXRDevice() const { return pDXRDevice; }
     inline ComPtr<IDXGIFactory4> GetFactory() const { return pFactory; }
     inline ComPtr<ID3D12CommandQueue> GetCommandQueue() const { return pCommandQueue; }
-    inline ComPtr<ID3D12CommandAllocator> GetCommandAllocator() const { return pCommandAllocator; }
+    // The command allocator of the frame being recorded.
+    inline ComPtr<ID3D12CommandAllocator> GetCommandAllocator() const { return pCommandAllocators[frameIndex]; }
+    inline const UINT GetFrameIndex() const { return frameIndex; }
+    inline void SetFrameIndex(UINT index) { frameIndex = index; }
 
     inline D3D12DescriptorHeapManager* GetDescriptorHeapManager() const { return pDescriptorHeapManager; }
     inline D3D12BufferManager* GetBufferManager() const { return pBufferManager; }
+    inline ResourceStateTracker* GetResourceStateTracker() const { return pResourceStateTracker; }
 };
@@ -0,0 +1,112 @@
+#include "stdafx.h"
+#include "DrawRecorder.h"
+#include "ViewManager.h"
+#include <chrono>
+
+DrawRecorder::DrawRecorder(shared_ptr<D3D12Device>& device, JobSystem* jobSystem) :
+    pDevice(device),
+    scheduler(jobSystem),
+    recordingFrame(UINT_MAX),
+    recordedChunksNum(0),
+    passesNum(0),
+    drawsNum(0),
+    chunksNum(0),
+    recordingTime(0.0)
+{
+
+}
+
+DrawRecorder::~DrawRecorder()
+{
+
+}
+
+void DrawRecorder::Record(
+    D3D12CommandList* pCommandList,
+    const UINT* pCosts,
+    UINT inDrawsNum,
+    const std::function<void(D3D12CommandList*, UINT thread, UINT begin, UINT end)>& record)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    const UINT threadCount = scheduler.GetThreadCount();
+    DrawChunkScheduler::Split(pCosts, inDrawsNum, threadCount > 1 ? threadCount * DRAW_CHUNKS_PER_THREAD : 1,
+        DRAW_CHUNK_MIN_COST, chunks);
+
+    if (chunks.size() <= 1)
+    {
+        if (chunks.empty() == FALSE)
+        {
+            record(pCommandList, 0, 0, inDrawsNum);
+        }
+    }
+    else
+    {
+        // The passes of a frame record into lists of their own, which are submitted with the frame.
+        if (recordingFrame != ViewManager::sFrameCount)
+        {
+            recordingFrame = ViewManager::sFrameCount;
+            recordedChunksNum = 0;
+        }
+        const UINT firstChunk = recordedChunksNum;
+        recordedChunksNum += static_cast<UINT>(chunks.size());
+
+        // Lists are created closed, and kept for the next passes.
+        for (UINT i = static_cast<UINT>(pCommandLists.size()); i < recordedChunksNum; i++)
+        {
+            for (UINT j = 0; j < FRAMES_IN_FLIGHT; j++)
+            {
+                pCommandAllocators[j].emplace_back();
+                ThrowIfFailed(pDevice->GetDevice()->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT,
+                    IID_PPV_ARGS(&pCommandAllocators[j][i])));
+            }
+            pCommandLists.push_back(std::make_unique<D3D12CommandList>(pDevice, pCommandAllocators[0][i]));
+            pCommandLists[i]->Close();
+        }
+
+        std::vector<ComPtr<ID3D12CommandAllocator>>& pFrameCommandAllocators = pCommandAllocators[pDevice->GetFrameIndex()];
+        scheduler.Run(static_cast<UINT>(chunks.size()),
+            [this, pCommandList, &record, &pFrameCommandAllocators, firstChunk](UINT thread, UINT chunk)
+        {
+            ThrowIfFailed(pFrameCommandAllocators[firstChunk + chunk]->Reset());
+            D3D12CommandList* pChunkCommandList = pCommandLists[firstChunk + chunk].get();
+            pChunkCommandList->Reset(pFrameCommandAllocators[firstChunk + chunk]);
+            pChunkCommandList->InheritGraphicsState(*pCommandList);
+            record(pChunkCommandList, thread, chunks[chunk].begin, chunks[chunk].end);
+            pChunkCommandList->Close();
+        });
+
+        pRecordedCommandLists.clear();
+        for (UINT i = firstChunk; i < recordedChunksNum; i++)
+        {
+            pRecordedCommandLists.push_back(pCommandLists[i].get());
+        }
+        pCommandList->InsertCommandLists(pRecordedCommandLists.data(), static_cast<UINT>(pRecordedCommandLists.size()));
+    }
+
+    std::chrono::duration<double, std::micro> duration = std::chrono::high_resolution_clock::now() - start;
+    recordingTime += duration.count();
+    drawsNum += inDrawsNum;
+    chunksNum += chunks.size();
+    if (++passesNum >= DRAW_RECORDING_LOG_INTERVAL)
+    {
+        ReportDrawRecording();
+    }
+}
+
+// Helper functions.
+void DrawRecorder::ReportDrawRecording()
+{
+    WCHAR message[256];
+    swprintf_s(message, L"Draw recording per pass: %.1f draws in %.1f chunks on %u threads, %.1f us.\n",
+        static_cast<double>(drawsNum) / passesNum,
+        static_cast<double>(chunksNum) / passesNum,
+        scheduler.GetThreadCount(),
+        recordingTime / passesNum);
+    OutputDebugStringW(message);
+
+    passesNum = 0;
+    drawsNum = 0;
+    chunksNum = 0;
+    recordingTime = 0.0;
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include "DrawChunkScheduler.h"
+
+// Chunks a recording thread is given, so one that records slowly holds the others up less.
+#define DRAW_CHUNKS_PER_THREAD 2
+// Draws cost less than this are recorded into the command list of the pass, as a list of their own
+// would cost more to submit than it saves.
+#define DRAW_CHUNK_MIN_COST 128
+// Passes between two reports of the parallel recording.
+#define DRAW_RECORDING_LOG_INTERVAL 600
+
+// Records the draws of a pass in chunks on the threads of the job system. Every chunk is recorded
+// into a command list and allocator of its own, which start in the graphics state of the command list of
+// the pass, and are inserted into it in chunk order to be submitted with it in one batch.
+class DrawRecorder
+{
+private:
+	shared_ptr<D3D12Device> pDevice;
+	DrawChunkScheduler scheduler;
+	std::vector<DrawChunk> chunks;
+	// A list for each chunk, and an allocator for each chunk of every frame in flight. A list can be
+	// recorded again as soon as it is submitted, but an allocator only once the GPU is done with its frame.
+	std::vector<ComPtr<ID3D12CommandAllocator>> pCommandAllocators[FRAMES_IN_FLIGHT];
+	std::vector<unique_ptr<D3D12CommandList>> pCommandLists;
+	std::vector<D3D12CommandList*> pRecordedCommandLists;
+	// The frame being recorded, and the lists its passes have used so far.
+	UINT recordingFrame;
+	UINT recordedChunksNum;
+
+	// Recording metrics since the last report.
+	UINT passesNum;
+	UINT64 drawsNum;
+	UINT64 chunksNum;
+	double recordingTime;
+
+	void ReportDrawRecording();
+
+public:
+	DrawRecorder(shared_ptr<D3D12Device>&, JobSystem* jobSystem);
+	~DrawRecorder();
+
+	// Record the draws of a pass, in order, and return when all are recorded. The record function is called
+	// with each chunk of draws, the list to record it into, and the thread it runs on, below GetThreadCount.
+	// pCosts are the relative costs of recording the draws.
+	void Record(D3D12CommandList* pCommandList, const UINT* pCosts, UINT inDrawsNum,
+		const std::function<void(D3D12CommandList*, UINT thread, UINT begin, UINT end)>& record);
+
+	inline const UINT GetThreadCount() const { return scheduler.GetThreadCount(); }
+};
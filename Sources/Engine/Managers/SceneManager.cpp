@@ -1,36 +1,61 @@
 #include "stdafx.h"
 #include "SceneManager.h"
-#include "LitMaterial.h"
 #include "SkyboxMaterial.h"
+#include "ViewManager.h"
+#include "MeshCache.h"
+#include "SceneManifest.h"
+#include <algorithm>
+#include <chrono>
 
-UINT SceneManager::sTextureID = 0;
-
-SceneManager::SceneManager(shared_ptr<D3D12Device>& device, BOOL isDXR) :
+SceneManager::SceneManager(shared_ptr<D3D12Device>& device, shared_ptr<JobSystem>& jobSystem, BOOL isDXR) :
     pDevice(device),
-    objectID(0)
+    pJobSystem(jobSystem),
+    objectID(0),
+    transformConstantsAddress(0),
+    cameraConstantsAddress(0),
+    transformUpdateTime(0.0),
+    residentAssetsNum(0),
+    isTextureDataPending(FALSE),
+    isRayTracingSceneDirty(FALSE),
+    pFrustumCullingData(nullptr),
+    pUploadBuffer(nullptr),
+    visDataCapacity(0),
+    visDataObjectsNum(0),
+    pVertexBuffer(nullptr),
+    pIndexBuffer(nullptr),
+    pOffsetBuffer(nullptr)
 {
-    pTempVertexBuffer = new D3D12UploadBuffer();
-    pDevice->GetBufferManager()->AllocateTempUploadBuffer(pTempVertexBuffer, 1024 * 1024);
-    pTempIndexBuffer = new D3D12UploadBuffer();
-    pDevice->GetBufferManager()->AllocateTempUploadBuffer(pTempIndexBuffer, 1024 * 1024);
-    pTempOffsetBuffer = new D3D12UploadBuffer();
-    pDevice->GetBufferManager()->AllocateTempUploadBuffer(pTempOffsetBuffer, 1024);
-    pTempBoundingBoxBuffer = new D3D12UploadBuffer();
-    pDevice->GetBufferManager()->AllocateTempUploadBuffer(pTempBoundingBoxBuffer, 1024);
+    pTextureCache = std::make_unique<TextureCache>(pDevice);
+    pTextureStreamer = std::make_unique<TextureStreamer>(pDevice);
+    pDrawRecorder = std::make_unique<DrawRecorder>(pDevice, pJobSystem.get());
+    drawThreads.resize(pDrawRecorder->GetThreadCount());
+    for (UINT i = 0; i < LIT_MATERIAL_TEXTURES_NUM; i++)
+    {
+        pPlaceholderTextures[i] = nullptr;
+    }
+    for (UINT i = 0; i < FRAMES_IN_FLIGHT; i++)
+    {
+        pReadbackBuffers[i] = nullptr;
+        readbackObjectsNum[i] = 0;
+    }
 }
 
 SceneManager::~SceneManager()
 {
     UnloadScene();
+    ReleaseRayTracingScene();
 
+    pSkyboxMaterial->FreeTextureIDs(pDevice->GetDescriptorHeapManager());
     delete pSkyboxMaterial;
     delete pSkyboxMesh;
     // delete pFullScreenMesh;
     delete pCamera;
 
-    delete pVertexBuffer;
-    delete pIndexBuffer;
-    delete pOffsetBuffer;
+    for (UINT i = 0; i < LIT_MATERIAL_TEXTURES_NUM; i++)
+    {
+        pDevice->GetDescriptorHeapManager()->FreeTextureSlots(pPlaceholderTextures[i]->GetTextureID(), 1);
+        pTextureCache->Release(pPlaceholderTextures[i]);
+    }
     delete pFrustumCullingData;
 }
 
@@ -44,105 +69,117 @@ void SceneManager::InitFBXImporter()
 void SceneManager::ParseScene(D3D12CommandList* pCommandList)
 {
     LPCWSTR sceneName = L"scene";
-    std::wifstream inFile(GetAssetPath(sceneName));
-
-    // Parse textures from the scene file to materials.
-    UINT numMaterials = 0;
-    inFile >> numMaterials;
-    for (UINT i = 0; i < numMaterials; i++)
+    std::wstring scenePath = GetAssetPath(sceneName);
+    std::wstring manifestPath = SceneManifest::GetManifestPath(scenePath);
+    UINT64 sceneTimestamp = MeshCache::GetSourceTimestamp(scenePath);
+
+    // Prefer the binary manifest, and convert it from the text scene when it is missing or stale.
+    auto start = std::chrono::high_resolution_clock::now();
+    SceneManifest manifest;
+    BOOL isConverted = FALSE;
+    if (!manifest.Load(manifestPath, sceneTimestamp))
     {
-        WCHAR materialName[32];
-        inFile >> materialName;
-        LitMaterial* material = new LitMaterial(materialName);
-        material->LoadTexture();
-
-        LoadTextureBufferAndSampler(pCommandList, material->GetTexture());
-        LoadTextureBufferAndSampler(pCommandList, material->GetMRATexture());
-        LoadTextureBufferAndSampler(pCommandList, material->GetNormalTexture());
-        pMaterialPool[EraseSuffix(materialName)] = material;
+        isConverted = TRUE;
+        if (!SceneManifest::Convert(scenePath, manifestPath, sceneTimestamp)
+            || !manifest.Load(manifestPath, sceneTimestamp))
+        {
+            OutputDebugStringW(L"Failed to convert the scene into a scene manifest.\n");
+            return;
+        }
     }
 
-    // Parse FBX from the scene file.
-    UINT numModels = 0, offset = 0;
-    inFile >> numModels;
+    std::chrono::duration<double, std::milli> duration = std::chrono::high_resolution_clock::now() - start;
+    WCHAR message[256];
+    swprintf_s(message, L"Loaded the scene manifest with %u objects%s in %.3f ms, %u changed assets hashed again.\n",
+        manifest.GetObjectsNum(), isConverted ? L" converted from the text scene" : L"", duration.count(),
+        manifest.GetRehashedAssetsNum());
+    OutputDebugStringW(message);
 
-    for (UINT i = 0; i < numModels; i++)
+    // Create the materials of the scene, which show the placeholders until their textures are loaded.
+    std::vector<LitMaterial*> materials;
+    for (UINT i = 0; i < manifest.GetMaterialsNum(); i++)
     {
-        WCHAR fileName[32];
-        inFile >> fileName;
-
-        Model* model = new Model(objectID++, fileName);
-        model->LoadModel(pFBXImporter);
-        model->SetMaterial(pMaterialPool[EraseSuffix(fileName)]);
-        AddObject(model);
-
-        LoadObjectVertexBufferAndIndexBufferDXR(pCommandList, model, offset);
-        LoadObjectVertexBufferAndIndexBuffer(pCommandList, model);
+        LitMaterial* material = new LitMaterial(manifest.GetName(manifest.GetMaterial(i)), pTextureCache.get());
+        material->ReserveTextureIDs(pDevice->GetDescriptorHeapManager());
+        BindPlaceholderTextures(material);
+        materials.push_back(material);
     }
 
-    // Create the SRV of indices and vertices.
-    D3D12_RESOURCE_DESC resourceDesc = CD3DX12_RESOURCE_DESC::Buffer(pTempIndexBuffer->GetBufferSize());
-    D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-    srvDesc.Format = DXGI_FORMAT_UNKNOWN;
-    srvDesc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
-    srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-    srvDesc.Buffer.NumElements = pTempIndexBuffer->GetBufferUsage() / sizeof(UINT16);
-    srvDesc.Buffer.StructureByteStride = sizeof(Vertex);
-    srvDesc.Buffer.Flags = D3D12_BUFFER_SRV_FLAG_NONE;
-
-    pIndexBuffer = new D3D12ShaderResourceBuffer(resourceDesc, srvDesc);
-    pDevice->GetBufferManager()->AllocateDefaultBuffer(pIndexBuffer);
-    pIndexBuffer->CreateView(pDevice->GetDevice(),
-        pDevice->GetDescriptorHeapManager()->GetHandle(SHADER_RESOURCE_VIEW_GLOBAL, 1));
-    pCommandList->CopyBufferRegion(pIndexBuffer->GetResource().Get(),
-        pTempIndexBuffer->ResourceLocation.Resource.Get(),
-        pTempIndexBuffer->GetBufferUsage());
-
-    resourceDesc = CD3DX12_RESOURCE_DESC::Buffer(pTempVertexBuffer->GetBufferSize());
-    srvDesc = {};
-    srvDesc.Format = DXGI_FORMAT_UNKNOWN;
-    srvDesc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
-    srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-    srvDesc.Buffer.NumElements = pTempVertexBuffer->GetBufferUsage() / sizeof(Vertex);
-    srvDesc.Buffer.StructureByteStride = sizeof(UINT16);
-    srvDesc.Buffer.Flags = D3D12_BUFFER_SRV_FLAG_NONE;
+    // Create a model for every object, placed and bound to its material by the manifest. The first object
+    // of a mesh loads it and the others share it, the ticket of an asset is its index in loadingAssets.
+    std::vector<UINT> meshTickets(manifest.GetMeshesNum(), UINT_MAX);
+    UINT modelsNum = 0;
+    for (UINT i = 0; i < manifest.GetObjectsNum(); i++)
+    {
+        const SceneManifestObject& object = manifest.GetSceneObject(i);
+        const SceneManifestAsset& mesh = manifest.GetMesh(object.meshIndex);
 
-    pVertexBuffer = new D3D12ShaderResourceBuffer(resourceDesc, srvDesc);
-    pDevice->GetBufferManager()->AllocateDefaultBuffer(pVertexBuffer);
-    pVertexBuffer->CreateView(pDevice->GetDevice(),
-        pDevice->GetDescriptorHeapManager()->GetHandle(SHADER_RESOURCE_VIEW_GLOBAL, 2));
-    pCommandList->CopyBufferRegion(pVertexBuffer->GetResource().Get(),
-        pTempVertexBuffer->ResourceLocation.Resource.Get(),
-        pTempVertexBuffer->GetBufferUsage());
+        Model* model = new Model(objectID++, manifest.GetName(mesh));
+        model->SetSourceHash(mesh.contentHash);
+        model->SetTransform(object.position, object.rotation, object.scale);
+        model->SetObjectToWorldMatrix();
+        model->SetMaterial(materials[object.materialIndex]);
+        modelsNum++;
 
-    resourceDesc = CD3DX12_RESOURCE_DESC::Buffer(pTempOffsetBuffer->GetBufferSize());
-    srvDesc = {};
-    srvDesc.Format = DXGI_FORMAT_UNKNOWN;
-    srvDesc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
-    srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-    srvDesc.Buffer.NumElements = numModels;
-    srvDesc.Buffer.StructureByteStride = sizeof(UINT);
-    srvDesc.Buffer.Flags = D3D12_BUFFER_SRV_FLAG_NONE;
-
-    pOffsetBuffer = new D3D12ShaderResourceBuffer(resourceDesc, srvDesc);
-    pDevice->GetBufferManager()->AllocateDefaultBuffer(pOffsetBuffer);
-    pOffsetBuffer->CreateView(pDevice->GetDevice(),
-        pDevice->GetDescriptorHeapManager()->GetHandle(SHADER_RESOURCE_VIEW_GLOBAL, 3));
-    pCommandList->CopyBufferRegion(pOffsetBuffer->GetResource().Get(),
-        pTempOffsetBuffer->ResourceLocation.Resource.Get(),
-        pTempOffsetBuffer->GetBufferUsage());
+        if (meshTickets[object.meshIndex] == UINT_MAX)
+        {
+            meshTickets[object.meshIndex] = static_cast<UINT>(loadingAssets.size());
+            loadingAssets.push_back({ model, nullptr, FALSE });
+        }
+        else
+        {
+            loadingAssets[meshTickets[object.meshIndex]].sharingModels.push_back(model);
+        }
+    }
 
-    BuildBottomLevelAS(pCommandList, GeometryType::Triangle);
-    BuildBottomLevelAS(pCommandList, GeometryType::AABB);
-    BuildTopLevelAS(pCommandList, GeometryType::Triangle);
-    BuildTopLevelAS(pCommandList, GeometryType::AABB);
+    // Import the meshes and decode the textures on loader threads. Meshes go first, since an object is not
+    // drawn before its mesh is resident.
+    pAsyncLoader = std::make_unique<AsyncLoader>(pJobSystem.get());
+    loaderImporters.resize(pJobSystem->GetThreadCount());
+    const UINT meshesNum = static_cast<UINT>(loadingAssets.size());
+    for (UINT i = 0; i < meshesNum; i++)
+    {
+        Model* model = loadingAssets[i].pModel;
+        pAsyncLoader->Submit([this, model](UINT thread)
+        {
+            unique_ptr<FBXImporter>& importer = loaderImporters[thread];
+            if (importer == nullptr)
+            {
+                importer = std::make_unique<FBXImporter>();
+                importer->InitializeSdkObjects();
+            }
+            model->LoadModel(importer);
+#if USE_PACKED_VERTEX
+            model->PackVertices();
+#endif
+        });
+    }
+    for (LitMaterial* material : materials)
+    {
+        loadingAssets.push_back({ nullptr, material, FALSE });
+        pAsyncLoader->Submit([material](UINT)
+        {
+            material->LoadTexture();
+        });
+    }
 
-    inFile.close();
+    swprintf_s(message, L"Loading %u meshes for %u models and %u materials on %u threads.\n",
+        meshesNum, modelsNum, static_cast<UINT>(materials.size()), pAsyncLoader->GetThreadCount());
+    OutputDebugStringW(message);
 }
 
 void SceneManager::LoadScene(D3D12CommandList* pCommandList)
 {
-    // Parse the scene file.
+    // Create the placeholders, before the materials of the scene bind them.
+    for (UINT i = 0; i < LIT_MATERIAL_TEXTURES_NUM; i++)
+    {
+        std::wstring texturePath = GetAssetPath(LitMaterial::kPlaceholderTextureNames[i]);
+        pPlaceholderTextures[i] = pTextureCache->Acquire(texturePath,
+            pDevice->GetDescriptorHeapManager()->AllocateTextureSlots(1));
+        LoadTextureBufferAndSampler(pCommandList, pPlaceholderTextures[i]);
+    }
+
+    // Parse the scene file and start loading its assets.
     ParseScene(pCommandList);
 
     // Create static data.
@@ -152,67 +189,48 @@ void SceneManager::LoadScene(D3D12CommandList* pCommandList)
 
     // Create assets of the skybox.
     std::wstring skyboxName = L"Skybox\\sky01";
-    SkyboxMaterial* material = new SkyboxMaterial(skyboxName);
+    SkyboxMaterial* material = new SkyboxMaterial(skyboxName, pDevice);
+    material->ReserveTextureIDs(pDevice->GetDescriptorHeapManager());
     material->LoadTexture();
     LoadTextureBufferAndSampler(pCommandList, material->GetTexture());
+    BindTexture(material->GetTexture(), material, 0);
     pSkyboxMaterial = material;
+    isTextureDataPending = TRUE;
 
     pSkyboxMesh = new Model(objectID++, L"Skybox\\skybox.fbx");
     pSkyboxMesh->LoadModel(pFBXImporter);
     LoadObjectVertexBufferAndIndexBuffer(pCommandList, pSkyboxMesh);
 
-    // Create the global constant buffer.
-    pDevice->GetBufferManager()->AllocateGlobalConstantBuffer();
-    pDevice->GetBufferManager()->GetGlobalConstantBuffer()->CreateView(pDevice->GetDevice(),
-        pDevice->GetDescriptorHeapManager()->GetHandle(CONSTANT_BUFFER_VIEW_GLOBAL, 0));
-
-
-    // Create a UAV for keeping frustum culling data.
-    D3D12_RESOURCE_DESC desc;
-
-    desc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
-    desc.Alignment = 0;
-    desc.Width = GlobalConstants::kMaxNumObject;
-    desc.Height = 1;
-    desc.DepthOrArraySize = 1;
-    desc.MipLevels = 1;
-    desc.Format = DXGI_FORMAT_UNKNOWN;
-    desc.SampleDesc.Count = 1;
-    desc.SampleDesc.Quality = 0;
-    desc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
-    desc.Flags = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
-
-    D3D12_UNORDERED_ACCESS_VIEW_DESC viewDesc;
-    viewDesc.Format = DXGI_FORMAT_UNKNOWN;
-    viewDesc.ViewDimension = D3D12_UAV_DIMENSION_BUFFER;
-    viewDesc.Buffer.FirstElement = 0;
-    viewDesc.Buffer.NumElements = GlobalConstants::kVisDataSize;
-    viewDesc.Buffer.StructureByteStride = GlobalConstants::kSizeOfUint;
-    viewDesc.Buffer.CounterOffsetInBytes = 0;
-    viewDesc.Buffer.Flags = D3D12_BUFFER_UAV_FLAG_NONE;
-
-    pFrustumCullingData = new D3D12UnorderedAccessBuffer(desc, viewDesc);
-    pDevice->GetBufferManager()->AllocateDefaultBuffer(
-        pFrustumCullingData,
-        D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
-        L"FrustumCullingData");
-    pFrustumCullingData->CreateView(pDevice->GetDevice(),
-        pDevice->GetDescriptorHeapManager()->GetHandle(UNORDERED_ACCESS_VIEW, 1));
-
-    // Create a upload buffer to upload and reset the vis data.
-    pUploadBuffer = new D3D12UploadBuffer();
-    pDevice->GetBufferManager()->AllocateUploadBuffer(pUploadBuffer, desc.Width);
-    ResetVisData(pCommandList);
-
-    // Create a readback buffer to read data back.
-    pReadbackBuffer = new D3D12ReadbackBuffer();
-    pDevice->GetBufferManager()->AllocateReadbackBuffer(pReadbackBuffer, desc.Width);
+    // Create the frustum culling buffers, they grow as objects join the DXR scene.
+    ReserveVisData(pCommandList, GlobalConstants::kMaxNumObject);
 }
 
 void SceneManager::UnloadScene()
 {
+    // Stop the loader first, its threads write to the assets that have not joined the scene.
+    pAsyncLoader.reset();
+    for (const LoadingAsset& asset : loadingAssets)
+    {
+        if (!asset.isResident)
+        {
+            delete asset.pModel;
+            for (Model* model : asset.sharingModels)
+            {
+                delete model;
+            }
+            if (asset.pMaterial != nullptr)
+            {
+                asset.pMaterial->FreeTextureIDs(pDevice->GetDescriptorHeapManager());
+                delete asset.pMaterial;
+            }
+        }
+    }
+    loaderImporters.clear();
+    loadingAssets.clear();
+    residentAssetsNum = 0;
+    pTextureStreamer->Clear();
+
     objectID = 0;
-    sTextureID = 0;
 
     for (auto it = pObjects.begin(); it != pObjects.end(); it++)
     {
@@ -220,13 +238,138 @@ void SceneManager::UnloadScene()
     }
     pObjects.clear();
 
+    // The slots of the materials are reused once the GPU has finished the frames that drew them.
     for (auto it = pMaterialPool.begin(); it != pMaterialPool.end(); it++)
     {
+        it->second->FreeTextureIDs(pDevice->GetDescriptorHeapManager());
         delete it->second;
     }
     pMaterialPool.clear();
 }
 
+void SceneManager::CommitLoadedAssets(D3D12CommandList* pCommandList)
+{
+    // The objects that joined after the last frame are traced and culled from this frame on.
+    if (isRayTracingSceneDirty)
+    {
+        BuildRayTracingScene(pCommandList);
+    }
+
+    // Stream the mips for the sizes the last frame drew the materials at.
+    if (ViewManager::sFrameCount > 0)
+    {
+        pTextureStreamer->Update(pCommandList, ViewManager::sFrameCount - 1);
+    }
+
+    if (pAsyncLoader == nullptr)
+    {
+        return;
+    }
+
+    std::vector<UINT> committedTickets;
+    pAsyncLoader->Poll(committedTickets, ASYNC_LOAD_COMMITS_PER_FRAME);
+    for (UINT ticket : committedTickets)
+    {
+        const LoadingAsset& asset = loadingAssets[ticket];
+        if (asset.pModel != nullptr)
+        {
+            // The buffers are uploaded once for all the objects of the mesh.
+            LoadObjectVertexBufferAndIndexBuffer(pCommandList, asset.pModel);
+            for (Model* model : asset.sharingModels)
+            {
+                model->ShareMesh(asset.pModel);
+            }
+        }
+        else
+        {
+            // Replace the placeholders in the slots of the material. A shared texture is uploaded
+            // by the first material that commits it, and the others only bind it.
+            D3D12Texture* textures[LIT_MATERIAL_TEXTURES_NUM] =
+            {
+                asset.pMaterial->GetTexture(),
+                asset.pMaterial->GetMRATexture(),
+                asset.pMaterial->GetNormalTexture(),
+            };
+            for (UINT j = 0; j < LIT_MATERIAL_TEXTURES_NUM; j++)
+            {
+                if (textures[j]->GetTextureBuffer()->GetResource() == nullptr)
+                {
+                    LoadTextureBufferAndSampler(pCommandList, textures[j]);
+                }
+                BindTexture(textures[j], asset.pMaterial, j);
+            }
+        }
+    }
+}
+
+void SceneManager::ResolveLoadedAssets(UINT64 completedFenceValue)
+{
+    if (pAsyncLoader == nullptr)
+    {
+        return;
+    }
+
+    std::vector<UINT> resolvedTickets;
+    const UINT resolvedAssetsNum = pAsyncLoader->Release(completedFenceValue, resolvedTickets);
+    UINT firstInsertedObject = UINT_MAX;
+    for (UINT ticket : resolvedTickets)
+    {
+        LoadingAsset& asset = loadingAssets[ticket];
+        asset.isResident = TRUE;
+
+        if (asset.pModel != nullptr)
+        {
+            // Keep the objects in objectID order, whichever loader thread finished first.
+            auto insertObject = [this, &firstInsertedObject](Model* model)
+            {
+                auto it = std::upper_bound(pObjects.begin(), pObjects.end(), model,
+                    [](const Model* a, const Model* b) { return a->GetObjectID() < b->GetObjectID(); });
+                firstInsertedObject = min(firstInsertedObject, static_cast<UINT>(it - pObjects.begin()));
+                pObjects.insert(it, model);
+            };
+            insertObject(asset.pModel);
+            for (Model* model : asset.sharingModels)
+            {
+                insertObject(model);
+            }
+            isRayTracingSceneDirty = TRUE;
+        }
+        else
+        {
+            pMaterialPool[EraseSuffix(asset.pMaterial->GetName().c_str())] = asset.pMaterial;
+            isTextureDataPending = TRUE;
+        }
+    }
+    residentAssetsNum += resolvedAssetsNum;
+
+    // The vis data read back so far, and the copies still in flight, follow the order the objects had when
+    // they were traced. The objects from the first one inserted on have moved, so they are drawn until the
+    // vis data of the new order is read back.
+    if (firstInsertedObject != UINT_MAX)
+    {
+        visDataObjectsNum = min(visDataObjectsNum, firstInsertedObject);
+        for (UINT i = 0; i < FRAMES_IN_FLIGHT; i++)
+        {
+            readbackObjectsNum[i] = min(readbackObjectsNum[i], firstInsertedObject);
+        }
+    }
+
+    // Stop the loader threads once every asset is resident.
+    if (residentAssetsNum == loadingAssets.size())
+    {
+        WCHAR message[256];
+        swprintf_s(message, L"Texture cache: %u hits, %u misses, %.2f MB saved.\n",
+            pTextureCache->GetHitsNum(), pTextureCache->GetMissesNum(), pTextureCache->GetSavedBytes() / 1048576.0);
+        OutputDebugStringW(message);
+        pDevice->GetDescriptorHeapManager()->ReportDescriptorCaches();
+
+        pAsyncLoader.reset();
+        loaderImporters.clear();
+        loadingAssets.clear();
+        residentAssetsNum = 0;
+    }
+}
+
 void SceneManager::CreateCamera(UINT width, UINT height)
 {
     pCamera = new Camera(0, static_cast<FLOAT>(width), static_cast<FLOAT>(height));
@@ -241,35 +384,60 @@ void SceneManager::AddObject(Model* object)
 
 void SceneManager::DrawObjects(D3D12CommandList* pCommandList)
 {
+    // Pick the visible objects and ask for their mips on this thread, as the streamer is not thread safe.
+    drawObjects.clear();
+    drawCosts.clear();
     for (UINT i = 0; i < pObjects.size(); i++)
     {
         Model* model = pObjects[i];
-        UINT id = pObjects[i]->GetObjectID();
-        if (visData[id] == 0) continue;
-
-        // Set the per object views.
-        pCommandList->SetRootConstantBufferView((UINT)eRootIndex::ConstantBufferViewPerObject,
-            pDevice->GetBufferManager()->GetPerObjectConstantBufferAtIndex(id)->GetResource()->GetGPUVirtualAddress());
-
-        // Set the material relating views.
-        LitMaterial* litMaterial = dynamic_cast<LitMaterial*>(model->GetMaterial());
-
-        pDevice->GetDescriptorHeapManager()->SetViews(
-            pCommandList->GetCommandList(),
-            SHADER_RESOURCE_VIEW_PEROBJECT,
-            (UINT)eRootIndex::ShaderResourceViewPerObject,
-            litMaterial->GetTexture()->GetTextureID());
-        pDevice->GetDescriptorHeapManager()->SetViews(
-            pCommandList->GetCommandList(),
-            SAMPLER,
-            (UINT)eRootIndex::Sampler,
-            litMaterial->GetTexture()->GetTextureID());
-
-        // Set buffers and draw the instance.
-        pCommandList->SetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-        pCommandList->SetVertexBuffers(0, 1, &model->GetMesh()->GetVertexBuffer()->VertexBufferView);
-        pCommandList->SetIndexBuffer(&model->GetMesh()->GetIndexBuffer()->IndexBufferView);
-        pCommandList->DrawIndexedInstanced(model->GetMesh()->GetIndicesNum());
+        // The vis data is written by geometry index, which follows the order of pObjects up to visDataObjectsNum.
+        if (i < visDataObjectsNum && visData[i] == 0) continue;
+
+        // Ask for the mips of the material at the size the model is drawn at.
+        FLOAT uvsPerPixel = model->GetUVsPerPixel(pCamera);
+        for (UINT j = 0; j < LIT_MATERIAL_TEXTURES_NUM; j++)
+        {
+            pTextureStreamer->RequestMip(model->GetMaterial()->GetTextureID() + j, uvsPerPixel, ViewManager::sFrameCount);
+        }
+
+        const std::vector<D3D12Meshlet>& meshlets = model->GetMesh()->GetMeshlets();
+        const BOOL isCullingMeshlets = meshlets.empty() == FALSE && model->GetCurrentLod() == 0;
+        drawObjects.push_back(i);
+        drawCosts.push_back(1 + (isCullingMeshlets ? static_cast<UINT>(meshlets.size()) / MESHLETS_PER_DRAW_COST : 0));
+    }
+
+    for (DrawThreadData& threadData : drawThreads)
+    {
+        threadData.trianglesNum = 0;
+        threadData.visibleTrianglesNum = 0;
+    }
+
+    pDrawRecorder->Record(pCommandList, drawCosts.data(), static_cast<UINT>(drawObjects.size()),
+        [this](D3D12CommandList* pDrawCommandList, UINT thread, UINT begin, UINT end)
+    {
+        // Every material samples the texture slots, so they are bound once for all the draws of a list.
+        SetBindlessViews(pDrawCommandList);
+        for (UINT i = begin; i < end; i++)
+        {
+            DrawObject(pDrawCommandList, drawObjects[i], drawThreads[thread]);
+        }
+    });
+
+    UINT trianglesNum = 0;
+    UINT visibleTrianglesNum = 0;
+    for (const DrawThreadData& threadData : drawThreads)
+    {
+        trianglesNum += threadData.trianglesNum;
+        visibleTrianglesNum += threadData.visibleTrianglesNum;
+    }
+
+    if (ViewManager::sFrameCount % MESHLET_CULLING_LOG_INTERVAL == 0 && trianglesNum > 0)
+    {
+        WCHAR message[256];
+        swprintf_s(message, L"Meshlet culling rejected %u of %u triangles (%.1f%%).\n",
+            trianglesNum - visibleTrianglesNum, trianglesNum,
+            100.0f * (trianglesNum - visibleTrianglesNum) / trianglesNum);
+        OutputDebugStringW(message);
     }
 
     ResetVisData(pCommandList);
@@ -278,21 +446,13 @@ void SceneManager::DrawObjects(D3D12CommandList* pCommandList)
 void SceneManager::DrawSkybox(D3D12CommandList* pCommandList)
 {
     // Set the global CBV.
-    UINT id = pSkyboxMesh->GetObjectID();
-    pCommandList->SetRootConstantBufferView(CONSTANT_BUFFER_VIEW_PEROBJECT,
-        pDevice->GetBufferManager()->GetPerObjectConstantBufferAtIndex(id)->GetResource()->GetGPUVirtualAddress());
-    
-    // Set SRVs.
-    pDevice->GetDescriptorHeapManager()->SetViews(
-        pCommandList->GetCommandList(),
-        SHADER_RESOURCE_VIEW_PEROBJECT,
-        (UINT)eRootIndex::ShaderResourceViewPerObject,
-        pSkyboxMaterial->GetTexture()->GetTextureID());
-    pDevice->GetDescriptorHeapManager()->SetViews(
-        pCommandList->GetCommandList(),
-        SAMPLER,
-        (UINT)eRootIndex::Sampler,
-        pSkyboxMaterial->GetTexture()->GetTextureID());
+    pCommandList->SetRootConstantBufferView((UINT)eRootIndex::ConstantBufferViewPerObject, transformConstantsAddress);
+
+    // Set the slot and the sampler of the skybox texture.
+    SetBindlessViews(pCommandList);
+    const MaterialConstant materialConstant = pSkyboxMaterial->GetConstants();
+    pCommandList->SetRoot32BitConstant((UINT)eRootIndex::MaterialConstants,
+        sizeof(MaterialConstant) / sizeof(UINT), &materialConstant);
 
     pCommandList->SetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
@@ -325,17 +485,20 @@ void SceneManager::SetFrustumCullingResources(D3D12CommandList* pCommandList)
 
 void SceneManager::ReadbackFrustumCullingData(D3D12CommandList* pCommandList)
 {
-    pCommandList->AddTransitionResourceBarriers(pFrustumCullingData->GetResource().Get(),
-        pFrustumCullingData->GetResourceState(), D3D12_RESOURCE_STATE_COPY_SOURCE);
-    pCommandList->FlushResourceBarriers();
+    pCommandList->TransitionResource(pFrustumCullingData->GetResource().Get(), D3D12_RESOURCE_STATE_COPY_SOURCE);
+    // The readback buffer of this frame was last written FRAMES_IN_FLIGHT frames ago, by a frame the GPU has
+    // finished, so the vis data lags that many frames behind.
+    const UINT frameIndex = pDevice->GetFrameIndex();
+    D3D12ReadbackBuffer* pReadbackBuffer = pReadbackBuffers[frameIndex];
     pCommandList->CopyResource(
         pReadbackBuffer->ResourceLocation.Resource.Get(),
         pFrustumCullingData->GetResource().Get());
-    pCommandList->AddTransitionResourceBarriers(pFrustumCullingData->GetResource().Get(),
-        D3D12_RESOURCE_STATE_COPY_SOURCE, pFrustumCullingData->GetResourceState());
-    pCommandList->FlushResourceBarriers();
+    pCommandList->TransitionResource(pFrustumCullingData->GetResource().Get(), pFrustumCullingData->GetResourceState());
 
-    pReadbackBuffer->ReadbackData(visData, sizeof(visData));
+    // The data covers the objects that were traced when its copy was recorded.
+    visDataObjectsNum = readbackObjectsNum[frameIndex];
+    pReadbackBuffer->ReadbackData(visData.data(), visDataObjectsNum * GlobalConstants::kSizeOfUint);
+    readbackObjectsNum[frameIndex] = static_cast<UINT>(blas[GeometryType::AABB].geometryDescs.size());
 }
 
 void SceneManager::SetDXRResources(D3D12CommandList* pCommandList)
@@ -371,30 +534,84 @@ void SceneManager::UpdateScene()
 
 void SceneManager::UpdateTransforms()
 {
+    auto start = std::chrono::high_resolution_clock::now();
+
+    // All the constants of the frame are written in one pass to a block of the constant arena, which
+    // the GPU is not reading.
+    const UINT64 stride = GET_CONSTANT_BUFFER_SIZE(sizeof(TransformConstant));
+    BYTE* pConstants = static_cast<BYTE*>(pDevice->GetBufferManager()->AllocateConstants(
+        stride * (pObjects.size() + 1), transformConstantsAddress));
+
     // Set the transform of the skybox.
     pCamera->SetObjectToWorldMatrix();
     pSkyboxMesh->CopyWorldPosition(*pCamera);
     pSkyboxMesh->SetObjectToWorldMatrix();
-    pDevice->GetBufferManager()->GetPerObjectConstantBufferAtIndex(pSkyboxMesh->GetObjectID())
-        ->CopyData(&pSkyboxMesh->GetTransformConstant(), sizeof(TransformConstant));
+    memcpy(pConstants, &pSkyboxMesh->GetTransformConstant(), sizeof(TransformConstant));
 
-    // Set the transform of objects.
-    for (UINT i = 0; i < pObjects.size(); i++)
+    // Set the transform of objects. Every object writes its own constants, so ranges of them are set on
+    // the threads of the job system.
+    pConstants += stride;
+    pJobSystem->ParallelFor(static_cast<UINT>(pObjects.size()), TRANSFORM_UPDATE_MIN_RANGE_SIZE,
+        [this, pConstants, stride](UINT, UINT begin, UINT end)
     {
-        pObjects[i]->SetObjectToWorldMatrix();
-        pDevice->GetBufferManager()->GetPerObjectConstantBufferAtIndex(pObjects[i]->GetObjectID())
-            ->CopyData(&pObjects[i]->GetTransformConstant(), sizeof(TransformConstant));
+        for (UINT i = begin; i < end; i++)
+        {
+            pObjects[i]->SetObjectToWorldMatrix();
+            pObjects[i]->SelectLod(pCamera);
+            memcpy(pConstants + stride * i, &pObjects[i]->GetTransformConstant(), sizeof(TransformConstant));
+        }
+    });
+
+    std::chrono::duration<double, std::nano> duration = std::chrono::high_resolution_clock::now() - start;
+    transformUpdateTime += duration.count();
+    if (ViewManager::sFrameCount % TRANSFORM_UPDATE_LOG_INTERVAL == 0)
+    {
+        WCHAR message[256];
+        swprintf_s(message, L"Transform update: %.1f ns per object, %u objects.\n",
+            transformUpdateTime / TRANSFORM_UPDATE_LOG_INTERVAL / (pObjects.size() + 1),
+            static_cast<UINT>(pObjects.size()));
+        OutputDebugStringW(message);
+        transformUpdateTime = 0.0;
     }
 }
 
 void SceneManager::UpdateCamera()
 {
     pCamera->UpdateCameraConstant();
-    pDevice->GetBufferManager()->GetGlobalConstantBuffer()->CopyData(&pCamera->GetCameraConstant(), sizeof(CameraConstant));
+    void* pConstants = pDevice->GetBufferManager()->AllocateConstants(
+        GET_CONSTANT_BUFFER_SIZE(sizeof(CameraConstant)), cameraConstantsAddress);
+    memcpy(pConstants, &pCamera->GetCameraConstant(), sizeof(CameraConstant));
 }
 
-void SceneManager::Release()
+void SceneManager::Retire(UINT64 fenceValue)
 {
+    if (pAsyncLoader != nullptr)
+    {
+        pAsyncLoader->Retire(fenceValue);
+    }
+    pTextureStreamer->Retire(fenceValue);
+}
+
+void SceneManager::Release(UINT64 completedFenceValue)
+{
+    pTextureStreamer->Release(completedFenceValue);
+
+    // The texture data is copied to the upload buffers as it is recorded, and only the streamer reads it later.
+    if (!isTextureDataPending)
+    {
+        return;
+    }
+    isTextureDataPending = FALSE;
+    pSkyboxMaterial->ReleaseTextureData();
+
+    for (UINT i = 0; i < LIT_MATERIAL_TEXTURES_NUM; i++)
+    {
+        if (pPlaceholderTextures[i] != nullptr)
+        {
+            pPlaceholderTextures[i]->ReleaseTextureData();
+        }
+    }
+
     for (auto it = pMaterialPool.begin(); it != pMaterialPool.end(); it++)
     {
         if (it->second != nullptr)
@@ -407,17 +624,12 @@ void SceneManager::Release()
 // Helper functions.
 void SceneManager::LoadObjectVertexBufferAndIndexBuffer(D3D12CommandList* pCommandList, Model* object)
 {
-    // Create the perObject constant buffer and its view.
-    UINT id = object->GetObjectID();
-    pDevice->GetBufferManager()->AllocatePerObjectConstantBuffers(id);
-    pDevice->GetBufferManager()->GetPerObjectConstantBufferAtIndex(id)->CreateView(pDevice->GetDevice(),
-        pDevice->GetDescriptorHeapManager()->GetHandle(CONSTANT_BUFFER_VIEW_PEROBJECT, id));
-
     // Create the vertex buffer and index buffer and their view.
+    object->GetMesh()->CreateBuffers();
     D3D12UploadBuffer* tempVertexBuffer = new D3D12UploadBuffer();
-    pDevice->GetBufferManager()->AllocateTempUploadBuffer(tempVertexBuffer, object->GetMesh()->GetVerticesSize());
+    pDevice->GetBufferManager()->AllocateTempUploadBuffer(tempVertexBuffer, object->GetMesh()->GetVertexBufferSize());
     pDevice->GetBufferManager()->AllocateDefaultBuffer(object->GetMesh()->GetVertexBuffer());
-    tempVertexBuffer->CopyData(object->GetMesh()->GetVerticesData(), object->GetMesh()->GetVerticesSize());
+    tempVertexBuffer->CopyData(object->GetMesh()->GetVertexBufferData(), object->GetMesh()->GetVertexBufferSize());
 
     D3D12UploadBuffer* tempIndexBuffer = new D3D12UploadBuffer();
     pDevice->GetBufferManager()->AllocateTempUploadBuffer(tempIndexBuffer, object->GetMesh()->GetIndicesSize());
@@ -427,60 +639,93 @@ void SceneManager::LoadObjectVertexBufferAndIndexBuffer(D3D12CommandList* pComma
     object->GetMesh()->CreateView();
     pCommandList->CopyBufferRegion(object->GetMesh()->GetVertexBuffer()->GetResource().Get(),
         tempVertexBuffer->ResourceLocation.Resource.Get(),
-        object->GetMesh()->GetVerticesSize());
+        object->GetMesh()->GetVertexBufferSize(), 0, tempVertexBuffer->GetResourceOffset());
     pCommandList->CopyBufferRegion(object->GetMesh()->GetIndexBuffer()->GetResource().Get(),
         tempIndexBuffer->ResourceLocation.Resource.Get(),
-        object->GetMesh()->GetIndicesSize());
+        object->GetMesh()->GetIndicesSize(), 0, tempIndexBuffer->GetResourceOffset());
 
     // Setup transition barriers.
-    pCommandList->AddTransitionResourceBarriers(object->GetMesh()->GetVertexBuffer()->GetResource().Get(),
-        D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_GENERIC_READ);
-    pCommandList->AddTransitionResourceBarriers(object->GetMesh()->GetIndexBuffer()->GetResource().Get(),
-        D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_GENERIC_READ);
-    pCommandList->FlushResourceBarriers();
+    pCommandList->TransitionResource(object->GetMesh()->GetVertexBuffer()->GetResource().Get(),
+        D3D12_RESOURCE_STATE_GENERIC_READ);
+    pCommandList->TransitionResource(object->GetMesh()->GetIndexBuffer()->GetResource().Get(),
+        D3D12_RESOURCE_STATE_GENERIC_READ);
 }
 
-void SceneManager::LoadObjectVertexBufferAndIndexBufferDXR(D3D12CommandList* pCommandList, Model* object, UINT& offset)
+void SceneManager::LoadObjectVertexBufferAndIndexBufferDXR(D3D12CommandList* pCommandList, Model* object)
 {
-    // Create the perObject constant buffer and its view.
-    UINT id = object->GetObjectID();
-    pDevice->GetBufferManager()->AllocatePerObjectConstantBuffers(id);
-    pDevice->GetBufferManager()->GetPerObjectConstantBufferAtIndex(id)->CreateView(pDevice->GetDevice(),
-        pDevice->GetDescriptorHeapManager()->GetHandle(CONSTANT_BUFFER_VIEW_PEROBJECT, id));
-
     // Create the geometry desc for this object.
     D3D12_RAYTRACING_GEOMETRY_DESC geometryDesc = {};
     geometryDesc.Type = D3D12_RAYTRACING_GEOMETRY_TYPE_TRIANGLES;
     geometryDesc.Flags = D3D12_RAYTRACING_GEOMETRY_FLAG_OPAQUE;
 
-    geometryDesc.Triangles.Transform3x4 = 0;
-    geometryDesc.Triangles.IndexFormat = DXGI_FORMAT_R16_UINT;
-    geometryDesc.Triangles.VertexFormat = DXGI_FORMAT_R32G32B32_FLOAT;
-    geometryDesc.Triangles.IndexCount = object->GetMesh()->GetIndicesNum();
+    geometryDesc.Triangles.IndexFormat = DXGI_FORMAT_R32_UINT;
+    geometryDesc.Triangles.VertexFormat = object->GetMesh()->IsPacked()
+        ? DXGI_FORMAT_R16G16B16A16_SNORM
+        : DXGI_FORMAT_R32G32B32_FLOAT;
+
+    // Place the geometry with the object transform, after dequantizing the snorm positions of packed meshes.
+    const XMFLOAT4& scale = object->GetMesh()->GetPositionScale();
+    const XMFLOAT4& offset = object->GetMesh()->GetPositionOffset();
+    XMMATRIX objectToWorld = XMLoadFloat4x4(&object->GetTransformConstant().ObjectToWorldMatrix);
+    XMMATRIX geometryToWorld = XMMatrixScaling(scale.x, scale.y, scale.z)
+        * XMMatrixTranslation(offset.x, offset.y, offset.z)
+        * objectToWorld;
+
+    // The geometry transform is a row major 3x4 matrix for column vectors.
+    XMFLOAT4X4 transform;
+    XMStoreFloat4x4(&transform, XMMatrixTranspose(geometryToWorld));
+
+    geometryDesc.Triangles.Transform3x4 =
+        pTempGeometryTransformBuffer->GetGPUVirtualAddress() + pTempGeometryTransformBuffer->GetBufferUsage();
+    pTempGeometryTransformBuffer->CopyData(
+        &transform,
+        sizeof(FLOAT) * 12,
+        pTempGeometryTransformBuffer->GetBufferUsage());
+
+    // Rays are traced against LOD 0, which is the start of the index buffer.
+    const UINT indicesNum = object->GetMesh()->GetLod(0).indicesNum;
+    geometryDesc.Triangles.IndexCount = indicesNum;
     geometryDesc.Triangles.VertexCount = object->GetMesh()->GetVerticesNum();
     geometryDesc.Triangles.IndexBuffer =
-        pTempIndexBuffer->ResourceLocation.Resource->GetGPUVirtualAddress() + pTempIndexBuffer->GetBufferUsage();
+        pTempIndexBuffer->GetGPUVirtualAddress() + pTempIndexBuffer->GetBufferUsage();
     geometryDesc.Triangles.VertexBuffer.StartAddress =
-        pTempVertexBuffer->ResourceLocation.Resource->GetGPUVirtualAddress() + pTempVertexBuffer->GetBufferUsage();
-    geometryDesc.Triangles.VertexBuffer.StrideInBytes = sizeof(Vertex);
+        pTempVertexBuffer->GetGPUVirtualAddress() + pTempVertexBuffer->GetBufferUsage();
+    geometryDesc.Triangles.VertexBuffer.StrideInBytes = object->GetMesh()->GetVertexStride();
     blas[GeometryType::Triangle].geometryDescs.push_back(geometryDesc);
 
-    // Copy vertex and index data to a common buffer.
-    pTempVertexBuffer->CopyData(
-        object->GetMesh()->GetVerticesData(),
-        object->GetMesh()->GetVerticesSize(),
-        pTempVertexBuffer->GetBufferUsage());
-
-    pTempIndexBuffer->CopyData(
-        object->GetMesh()->GetIndicesData(),
-        object->GetMesh()->GetIndicesSize(),
-        pTempIndexBuffer->GetBufferUsage());
-
+    // Keep the offsets of the first index and the first vertex of this object in the common buffers.
+    XMUINT2 offset =
+    {
+        static_cast<UINT>(pTempIndexBuffer->GetBufferUsage() / sizeof(UINT)),
+        static_cast<UINT>(pTempVertexBuffer->GetBufferUsage() / sizeof(SceneVertex)),
+    };
     pTempOffsetBuffer->CopyData(
         &offset,
-        sizeof(UINT),
+        sizeof(XMUINT2),
         pTempOffsetBuffer->GetBufferUsage());
-    offset += object->GetMesh()->GetIndicesNum();
+
+    // Copy vertex and index data to a common buffer, the indices of which are always 32-bit.
+    pTempVertexBuffer->CopyData(
+        object->GetMesh()->GetVertexBufferData(),
+        object->GetMesh()->GetVertexBufferSize(),
+        pTempVertexBuffer->GetBufferUsage());
+
+    if (object->GetMesh()->GetIndexStride() == sizeof(UINT))
+    {
+        pTempIndexBuffer->CopyData(
+            object->GetMesh()->GetIndicesData(),
+            indicesNum * sizeof(UINT),
+            pTempIndexBuffer->GetBufferUsage());
+    }
+    else
+    {
+        const UINT16* pIndices = static_cast<const UINT16*>(object->GetMesh()->GetIndicesData());
+        std::vector<UINT> indices(pIndices, pIndices + indicesNum);
+        pTempIndexBuffer->CopyData(
+            indices.data(),
+            indices.size() * sizeof(UINT),
+            pTempIndexBuffer->GetBufferUsage());
+    }
 
     // Create the geomerty desc for the binding box of this object.
     geometryDesc = {};
@@ -488,12 +733,30 @@ void SceneManager::LoadObjectVertexBufferAndIndexBufferDXR(D3D12CommandList* pCo
     geometryDesc.Flags = D3D12_RAYTRACING_GEOMETRY_FLAG_OPAQUE;
     geometryDesc.AABBs.AABBCount = 1;
     geometryDesc.AABBs.AABBs.StartAddress =
-        pTempBoundingBoxBuffer->ResourceLocation.Resource->GetGPUVirtualAddress() + pTempBoundingBoxBuffer->GetBufferUsage();
+        pTempBoundingBoxBuffer->GetGPUVirtualAddress() + pTempBoundingBoxBuffer->GetBufferUsage();
     geometryDesc.AABBs.AABBs.StrideInBytes = sizeof(D3D12_RAYTRACING_AABB);
     blas[GeometryType::AABB].geometryDescs.push_back(geometryDesc);
 
+    // Bound the corners of the box in world space.
+    D3D12_RAYTRACING_AABB aabb = object->GetAABBBox()->GetData();
+    XMVECTOR minPosition = XMVectorReplicate(FLT_MAX);
+    XMVECTOR maxPosition = XMVectorReplicate(-FLT_MAX);
+    for (UINT i = 0; i < 8; i++)
+    {
+        XMVECTOR corner = XMVectorSet(
+            i & 1 ? aabb.MaxX : aabb.MinX,
+            i & 2 ? aabb.MaxY : aabb.MinY,
+            i & 4 ? aabb.MaxZ : aabb.MinZ,
+            1.0f);
+        corner = XMVector3Transform(corner, objectToWorld);
+        minPosition = XMVectorMin(minPosition, corner);
+        maxPosition = XMVectorMax(maxPosition, corner);
+    }
+    XMStoreFloat3(reinterpret_cast<XMFLOAT3*>(&aabb.MinX), minPosition);
+    XMStoreFloat3(reinterpret_cast<XMFLOAT3*>(&aabb.MaxX), maxPosition);
+
     pTempBoundingBoxBuffer->CopyData(
-        &object->GetAABBBox()->GetData(),
+        &aabb,
         sizeof(D3D12_RAYTRACING_AABB),
         pTempBoundingBoxBuffer->GetBufferUsage());
 }
@@ -502,39 +765,271 @@ void SceneManager::LoadTextureBufferAndSampler(D3D12CommandList* pCommandList, D
 {
     UINT id = texture->GetTextureID();
 
-    // Create the texture buffer.
-    pDevice->GetBufferManager()->AllocateDefaultBuffer(texture->GetTextureBuffer());
-    texture->GetTextureBuffer()->CreateView(pDevice->GetDevice(),
-        pDevice->GetDescriptorHeapManager()->GetHandle(SHADER_RESOURCE_VIEW_PEROBJECT, id));
-
-    // Init texture data.
-    for (UINT i = 0; i < texture->GetSubresourceNum(); i++)
+    // A streamed texture starts with its coarse mips, the others are streamed in once they are drawn.
+    if (!pTextureStreamer->AddTexture(pCommandList, texture))
     {
-        D3D12_SUBRESOURCE_DATA textureData;
-        UINT64 rowSizeInBytes, totalBytes;
-        pDevice->GetDevice()->GetCopyableFootprints(&texture->GetTextureBuffer()->GetResourceDesc(),
-            i, 1, 0, nullptr, nullptr, &rowSizeInBytes, &totalBytes);
-        textureData.pData = texture->GetTextureDataAt(i);
-        textureData.RowPitch = rowSizeInBytes;
-        textureData.SlicePitch = totalBytes;
+        // Create the texture buffer.
+        pDevice->GetBufferManager()->AllocateDefaultBuffer(texture->GetTextureBuffer());
 
-        D3D12UploadBuffer* tempBuffer = new D3D12UploadBuffer();
-        pDevice->GetBufferManager()->AllocateTempUploadBuffer(tempBuffer, totalBytes);
+        const UINT subresourceNum = texture->GetSubresourceNum();
+        if (texture->GetStagingBuffer() != nullptr)
+        {
+            // Decoded textures are already laid out like their subresources, so they are copied
+            // from where they were decoded.
+            ID3D12Resource* pStagingResource = texture->GetStagingBuffer()->ResourceLocation.Resource.Get();
+            for (UINT i = 0; i < subresourceNum; i++)
+            {
+                CD3DX12_TEXTURE_COPY_LOCATION destination(texture->GetTextureBuffer()->GetResource().Get(), i);
+                CD3DX12_TEXTURE_COPY_LOCATION source(pStagingResource, texture->GetFootprint(i));
+                pCommandList->CopyTexture(&destination, &source);
+            }
+        }
+        else
+        {
+            // Init texture data. All the subresources share one upload buffer, so a full mip chain
+            // takes a single slot of the temp upload buffer pool.
+            std::vector<D3D12_SUBRESOURCE_DATA> textureData(subresourceNum);
+            std::vector<UINT> numRows(subresourceNum);
+            std::vector<UINT64> rowSizesInBytes(subresourceNum);
+            UINT64 totalBytes;
+            pDevice->GetDevice()->GetCopyableFootprints(&texture->GetTextureBuffer()->GetResourceDesc(),
+                0, subresourceNum, 0, nullptr, numRows.data(), rowSizesInBytes.data(), &totalBytes);
+            for (UINT i = 0; i < subresourceNum; i++)
+            {
+                // Rows of block compressed textures are rows of 4x4 blocks.
+                textureData[i].pData = texture->GetTextureDataAt(i);
+                textureData[i].RowPitch = rowSizesInBytes[i];
+                textureData[i].SlicePitch = rowSizesInBytes[i] * numRows[i];
+            }
+
+            D3D12UploadBuffer* tempBuffer = new D3D12UploadBuffer();
+            pDevice->GetBufferManager()->AllocateTempUploadBuffer(tempBuffer, totalBytes, nullptr,
+                D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+
+            // Update texture data from upload buffer to gpu buffer.
+            pCommandList->CopyTextureBuffer(texture->GetTextureBuffer()->GetResource().Get(),
+                tempBuffer->ResourceLocation.Resource.Get(), tempBuffer->GetResourceOffset(),
+                0, subresourceNum, textureData.data());
+        }
 
-        // Update texture data from upload buffer to gpu buffer.
-        pCommandList->CopyTextureBuffer(texture->GetTextureBuffer()->GetResource().Get(),
-            tempBuffer->ResourceLocation.Resource.Get(), 0, i, 1, &textureData);
+        pCommandList->TransitionResource(texture->GetTextureBuffer()->GetResource().Get(),
+            D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
     }
 
-    pCommandList->AddTransitionResourceBarriers(texture->GetTextureBuffer()->GetResource().Get(),
-        D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-    pCommandList->FlushResourceBarriers();
+    pDevice->GetDescriptorHeapManager()->StageView(pDevice->GetDevice(), texture->GetTextureBuffer(), id);
 
-    // Create the sampler and its view.
+    // Create the sampler, or share the one of the textures with the same description.
     texture->CreateSampler();
-    texture->TextureSampler->CPUHandle = pDevice->GetDescriptorHeapManager()->GetHandle(SAMPLER, id);
-    pDevice->GetDevice()->CreateSampler(&texture->TextureSampler->SamplerDesc,
-        texture->TextureSampler->CPUHandle);
+    texture->TextureSampler->ID = pDevice->GetDescriptorHeapManager()->CreateSampler(pDevice->GetDevice(),
+        texture->TextureSampler->SamplerDesc);
+}
+
+void SceneManager::DrawObject(D3D12CommandList* pCommandList, UINT index, DrawThreadData& threadData)
+{
+    Model* model = pObjects[index];
+
+    // Set the per object views.
+    pCommandList->SetRootConstantBufferView((UINT)eRootIndex::ConstantBufferViewPerObject,
+        transformConstantsAddress + (index + 1) * GET_CONSTANT_BUFFER_SIZE(sizeof(TransformConstant)));
+
+    // Set the material relating views.
+    const MaterialConstant materialConstant = model->GetMaterial()->GetConstants();
+    pCommandList->SetRoot32BitConstant((UINT)eRootIndex::MaterialConstants,
+        sizeof(MaterialConstant) / sizeof(UINT), &materialConstant);
+
+    // Set buffers and draw the instance.
+    pCommandList->SetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    pCommandList->SetVertexBuffers(0, 1, &model->GetMesh()->GetVertexBuffer()->VertexBufferView);
+    pCommandList->SetIndexBuffer(&model->GetMesh()->GetIndexBuffer()->IndexBufferView);
+
+    // Meshlets are built for LOD 0, and the simplified LODs are drawn as a whole.
+    const std::vector<D3D12Meshlet>& meshlets = model->GetMesh()->GetMeshlets();
+    const D3D12MeshLod& lod = model->GetMesh()->GetLod(model->GetCurrentLod());
+    if (meshlets.empty() || model->GetCurrentLod() > 0)
+    {
+        pCommandList->DrawIndexedInstanced(lod.indicesNum, lod.indexStart);
+        return;
+    }
+
+    // Draw the visible meshlets, merging the ones that are next to each other in the index buffer.
+    std::vector<UINT>& visibleMeshlets = threadData.visibleMeshlets;
+    threadData.trianglesNum += lod.indicesNum / 3;
+    threadData.visibleTrianglesNum += model->CullMeshlets(pCamera, visibleMeshlets);
+    for (UINT j = 0; j < visibleMeshlets.size();)
+    {
+        const D3D12Meshlet& first = meshlets[visibleMeshlets[j]];
+        UINT indicesNum = first.trianglesNum * 3;
+        for (j++; j < visibleMeshlets.size() && meshlets[visibleMeshlets[j]].indexStart == first.indexStart + indicesNum; j++)
+        {
+            indicesNum += meshlets[visibleMeshlets[j]].trianglesNum * 3;
+        }
+        pCommandList->DrawIndexedInstanced(indicesNum, first.indexStart);
+    }
+}
+
+void SceneManager::SetBindlessViews(D3D12CommandList* pCommandList)
+{
+    pDevice->GetDescriptorHeapManager()->SetViews(
+        pCommandList->GetCommandList(),
+        SHADER_RESOURCE_VIEW_PEROBJECT,
+        (UINT)eRootIndex::ShaderResourceViewBindless,
+        0);
+    pDevice->GetDescriptorHeapManager()->SetViews(
+        pCommandList->GetCommandList(),
+        SAMPLER,
+        (UINT)eRootIndex::SamplerBindless,
+        0);
+}
+
+void SceneManager::BindPlaceholderTextures(LitMaterial* material)
+{
+    for (UINT i = 0; i < LIT_MATERIAL_TEXTURES_NUM; i++)
+    {
+        BindTexture(pPlaceholderTextures[i], material, i);
+    }
+}
+
+void SceneManager::BindTexture(D3D12Texture* texture, AbstractMaterial* material, UINT slot)
+{
+    const UINT id = material->GetTextureID() + slot;
+    material->SetSamplerID(slot, texture->TextureSampler->ID);
+    if (id == texture->GetTextureID())
+    {
+        return;
+    }
+
+    pDevice->GetDescriptorHeapManager()->StageView(pDevice->GetDevice(), texture->GetTextureBuffer(), id);
+    pTextureStreamer->AddSlot(texture, id);
+}
+
+void SceneManager::BuildRayTracingScene(D3D12CommandList* pCommandList)
+{
+    isRayTracingSceneDirty = FALSE;
+    ReleaseRayTracingScene();
+    if (pObjects.empty())
+    {
+        return;
+    }
+    ReserveVisData(pCommandList, static_cast<UINT>(pObjects.size()));
+
+    // Stage the common buffers for all objects again, as temp upload buffers are reused once the GPU has read them.
+    UINT64 verticesSize = 0;
+    UINT64 indicesSize = 0;
+    UINT numModels = pObjects.size();
+    for (Model* model : pObjects)
+    {
+        verticesSize += model->GetMesh()->GetVertexBufferSize();
+        indicesSize += model->GetMesh()->GetLod(0).indicesNum * sizeof(UINT);
+    }
+
+    pTempVertexBuffer = new D3D12UploadBuffer();
+    pDevice->GetBufferManager()->AllocateTempUploadBuffer(pTempVertexBuffer, verticesSize);
+    pTempIndexBuffer = new D3D12UploadBuffer();
+    pDevice->GetBufferManager()->AllocateTempUploadBuffer(pTempIndexBuffer, indicesSize);
+    pTempOffsetBuffer = new D3D12UploadBuffer();
+    pDevice->GetBufferManager()->AllocateTempUploadBuffer(pTempOffsetBuffer, numModels * sizeof(XMUINT2));
+    pTempBoundingBoxBuffer = new D3D12UploadBuffer();
+    pDevice->GetBufferManager()->AllocateTempUploadBuffer(pTempBoundingBoxBuffer, numModels * sizeof(D3D12_RAYTRACING_AABB));
+    pTempGeometryTransformBuffer = new D3D12UploadBuffer();
+    pDevice->GetBufferManager()->AllocateTempUploadBuffer(pTempGeometryTransformBuffer, numModels * sizeof(FLOAT) * 12);
+
+    for (Model* model : pObjects)
+    {
+        LoadObjectVertexBufferAndIndexBufferDXR(pCommandList, model);
+    }
+
+    // Create the SRV of indices and vertices.
+    D3D12_RESOURCE_DESC resourceDesc = CD3DX12_RESOURCE_DESC::Buffer(pTempIndexBuffer->GetBufferSize());
+    D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+    srvDesc.Format = DXGI_FORMAT_UNKNOWN;
+    srvDesc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
+    srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+    srvDesc.Buffer.NumElements = pTempIndexBuffer->GetBufferUsage() / sizeof(UINT);
+    srvDesc.Buffer.StructureByteStride = sizeof(UINT);
+    srvDesc.Buffer.Flags = D3D12_BUFFER_SRV_FLAG_NONE;
+
+    pIndexBuffer = new D3D12ShaderResourceBuffer(resourceDesc, srvDesc);
+    pDevice->GetBufferManager()->AllocateDefaultBuffer(pIndexBuffer);
+    pDevice->GetDescriptorHeapManager()->CreateView(pDevice->GetDevice(), pIndexBuffer, SHADER_RESOURCE_VIEW_GLOBAL, 1);
+    pCommandList->CopyBufferRegion(pIndexBuffer->GetResource().Get(),
+        pTempIndexBuffer->ResourceLocation.Resource.Get(),
+        pTempIndexBuffer->GetBufferUsage(), 0, pTempIndexBuffer->GetResourceOffset());
+
+    resourceDesc = CD3DX12_RESOURCE_DESC::Buffer(pTempVertexBuffer->GetBufferSize());
+    srvDesc = {};
+    srvDesc.Format = DXGI_FORMAT_UNKNOWN;
+    srvDesc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
+    srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+    srvDesc.Buffer.NumElements = pTempVertexBuffer->GetBufferUsage() / sizeof(SceneVertex);
+    srvDesc.Buffer.StructureByteStride = sizeof(SceneVertex);
+    srvDesc.Buffer.Flags = D3D12_BUFFER_SRV_FLAG_NONE;
+
+    pVertexBuffer = new D3D12ShaderResourceBuffer(resourceDesc, srvDesc);
+    pDevice->GetBufferManager()->AllocateDefaultBuffer(pVertexBuffer);
+    pDevice->GetDescriptorHeapManager()->CreateView(pDevice->GetDevice(), pVertexBuffer, SHADER_RESOURCE_VIEW_GLOBAL, 2);
+    pCommandList->CopyBufferRegion(pVertexBuffer->GetResource().Get(),
+        pTempVertexBuffer->ResourceLocation.Resource.Get(),
+        pTempVertexBuffer->GetBufferUsage(), 0, pTempVertexBuffer->GetResourceOffset());
+
+    resourceDesc = CD3DX12_RESOURCE_DESC::Buffer(pTempOffsetBuffer->GetBufferSize());
+    srvDesc = {};
+    srvDesc.Format = DXGI_FORMAT_UNKNOWN;
+    srvDesc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
+    srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+    srvDesc.Buffer.NumElements = numModels;
+    srvDesc.Buffer.StructureByteStride = sizeof(XMUINT2);
+    srvDesc.Buffer.Flags = D3D12_BUFFER_SRV_FLAG_NONE;
+
+    pOffsetBuffer = new D3D12ShaderResourceBuffer(resourceDesc, srvDesc);
+    pDevice->GetBufferManager()->AllocateDefaultBuffer(pOffsetBuffer);
+    pDevice->GetDescriptorHeapManager()->CreateView(pDevice->GetDevice(), pOffsetBuffer, SHADER_RESOURCE_VIEW_GLOBAL, 3);
+    pCommandList->CopyBufferRegion(pOffsetBuffer->GetResource().Get(),
+        pTempOffsetBuffer->ResourceLocation.Resource.Get(),
+        pTempOffsetBuffer->GetBufferUsage(), 0, pTempOffsetBuffer->GetResourceOffset());
+
+    BuildBottomLevelAS(pCommandList, GeometryType::Triangle);
+    BuildBottomLevelAS(pCommandList, GeometryType::AABB);
+    BuildTopLevelAS(pCommandList, GeometryType::Triangle);
+    BuildTopLevelAS(pCommandList, GeometryType::AABB);
+
+    WCHAR message[256];
+    swprintf_s(message, L"Built the DXR scene of %u objects.\n", numModels);
+    OutputDebugStringW(message);
+}
+
+void SceneManager::ReleaseRayTracingScene()
+{
+    // The frames in flight may still trace the last build, and the buffer manager keeps its memory until they are done.
+    D3D12BufferManager* pBufferManager = pDevice->GetBufferManager();
+    for (UINT i = 0; i < GeometryType::Count; i++)
+    {
+        blas[i].geometryDescs.clear();
+        if (blas[i].pBottomLevelAccelerationStructure != nullptr)
+        {
+            pBufferManager->ReleaseDefaultBuffer(blas[i].pScratchResource.get());
+            pBufferManager->ReleaseDefaultBuffer(blas[i].pBottomLevelAccelerationStructure.get());
+            blas[i].pScratchResource.reset();
+            blas[i].pBottomLevelAccelerationStructure.reset();
+        }
+        if (tlas[i].pTopLevelAccelerationStructure != nullptr)
+        {
+            pBufferManager->ReleaseDefaultBuffer(tlas[i].pScratchResource.get());
+            pBufferManager->ReleaseDefaultBuffer(tlas[i].pTopLevelAccelerationStructure.get());
+            tlas[i].pScratchResource.reset();
+            tlas[i].pTopLevelAccelerationStructure.reset();
+        }
+    }
+
+    D3D12ShaderResourceBuffer** ppBuffers[] = { &pIndexBuffer, &pVertexBuffer, &pOffsetBuffer };
+    for (D3D12ShaderResourceBuffer** ppBuffer : ppBuffers)
+    {
+        if (*ppBuffer != nullptr)
+        {
+            pBufferManager->ReleaseDefaultBuffer(*ppBuffer);
+            delete *ppBuffer;
+            *ppBuffer = nullptr;
+        }
+    }
 }
 
 void SceneManager::BuildBottomLevelAS(D3D12CommandList* pCommandList, UINT index)
@@ -579,9 +1074,8 @@ void SceneManager::BuildBottomLevelAS(D3D12CommandList* pCommandList, UINT index
     bottomLevelBuildDesc.ScratchAccelerationStructureData =
         blas[index].pScratchResource->GetResource()->GetGPUVirtualAddress();
 
-    pCommandList->GetDXRCommandList()->BuildRaytracingAccelerationStructure(&bottomLevelBuildDesc, 0, nullptr);
-    pCommandList->GetCommandList()->ResourceBarrier(1,
-        &CD3DX12_RESOURCE_BARRIER::UAV(blas[index].pBottomLevelAccelerationStructure->GetResource().Get()));
+    pCommandList->BuildRaytracingAccelerationStructure(&bottomLevelBuildDesc);
+    pCommandList->AddUAVBarrier(blas[index].pBottomLevelAccelerationStructure->GetResource().Get());
 }
 
 void SceneManager::BuildTopLevelAS(D3D12CommandList* pCommandList, UINT index)
@@ -606,7 +1100,7 @@ void SceneManager::BuildTopLevelAS(D3D12CommandList* pCommandList, UINT index)
     topLevelInputs.Flags = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE;
     topLevelInputs.NumDescs =  1;
     topLevelInputs.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
-    topLevelInputs.InstanceDescs = pInstanceDescBuffer->ResourceLocation.Resource->GetGPUVirtualAddress();
+    topLevelInputs.InstanceDescs = pInstanceDescBuffer->GetGPUVirtualAddress();
 
     D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO topLevelPrebuildInfo = {};
     pDevice->GetDXRDevice()->GetRaytracingAccelerationStructurePrebuildInfo(&topLevelInputs, &topLevelPrebuildInfo);
@@ -641,26 +1135,89 @@ void SceneManager::BuildTopLevelAS(D3D12CommandList* pCommandList, UINT index)
         tlas[index].pScratchResource->GetResource()->GetGPUVirtualAddress();
 
     // Build acceleration structure.
-    pCommandList->GetDXRCommandList()->BuildRaytracingAccelerationStructure(&topLevelBuildDesc, 0, nullptr);
+    pCommandList->BuildRaytracingAccelerationStructure(&topLevelBuildDesc);
 }
 
-void SceneManager::ResetVisData(D3D12CommandList* pCommandList)
+void SceneManager::ReserveVisData(D3D12CommandList* pCommandList, UINT objectsNum)
 {
-    // Reset VisData.
-    for (UINT i = 0; i < GlobalConstants::kVisDataSize; i++)
+    if (objectsNum <= visDataCapacity)
+    {
+        return;
+    }
+
+    // The frames in flight may still use the old buffers, and the buffer manager keeps them until they are done.
+    D3D12BufferManager* pBufferManager = pDevice->GetBufferManager();
+    if (pFrustumCullingData != nullptr)
     {
-        visData[i] = 0;
+        pBufferManager->ReleaseDefaultBuffer(pFrustumCullingData);
+        delete pFrustumCullingData;
+        pBufferManager->ReleaseUploadBuffer(pUploadBuffer);
+        for (UINT i = 0; i < FRAMES_IN_FLIGHT; i++)
+        {
+            pBufferManager->ReleaseReadbackBuffer(pReadbackBuffers[i]);
+        }
     }
+    visDataCapacity = max(objectsNum, visDataCapacity * 2);
+    visData.assign(visDataCapacity, 0);
+
+    // Create a UAV for keeping frustum culling data.
+    D3D12_RESOURCE_DESC desc;
+
+    desc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+    desc.Alignment = 0;
+    desc.Width = visDataCapacity * GlobalConstants::kSizeOfUint;
+    desc.Height = 1;
+    desc.DepthOrArraySize = 1;
+    desc.MipLevels = 1;
+    desc.Format = DXGI_FORMAT_UNKNOWN;
+    desc.SampleDesc.Count = 1;
+    desc.SampleDesc.Quality = 0;
+    desc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+    desc.Flags = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
 
-    pUploadBuffer->CopyData(visData, sizeof(visData));
+    D3D12_UNORDERED_ACCESS_VIEW_DESC viewDesc;
+    viewDesc.Format = DXGI_FORMAT_UNKNOWN;
+    viewDesc.ViewDimension = D3D12_UAV_DIMENSION_BUFFER;
+    viewDesc.Buffer.FirstElement = 0;
+    viewDesc.Buffer.NumElements = visDataCapacity;
+    viewDesc.Buffer.StructureByteStride = GlobalConstants::kSizeOfUint;
+    viewDesc.Buffer.CounterOffsetInBytes = 0;
+    viewDesc.Buffer.Flags = D3D12_BUFFER_UAV_FLAG_NONE;
+
+    pFrustumCullingData = new D3D12UnorderedAccessBuffer(desc, viewDesc);
+    pBufferManager->AllocateDefaultBuffer(
+        pFrustumCullingData,
+        D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+        L"FrustumCullingData");
+    // The culling pass binds the vis data by address, not through this view.
+    pFrustumCullingData->CreateView(pDevice->GetDevice(),
+        pDevice->GetDescriptorHeapManager()->GetHandle(UNORDERED_ACCESS_VIEW, 1));
+
+    // Create a upload buffer to upload and reset the vis data. It only ever holds zeros, so the frames in
+    // flight can all copy from it.
+    pUploadBuffer = new D3D12UploadBuffer();
+    pBufferManager->AllocateUploadBuffer(pUploadBuffer, desc.Width);
+    ResetVisData(pCommandList);
+    pUploadBuffer->CopyData(visData.data(), desc.Width);
+
+    // Create a readback buffer for each frame in flight to read data back. They hold no data until the
+    // frame copies to them.
+    for (UINT i = 0; i < FRAMES_IN_FLIGHT; i++)
+    {
+        readbackObjectsNum[i] = 0;
+        pReadbackBuffers[i] = new D3D12ReadbackBuffer();
+        pBufferManager->AllocateReadbackBuffer(pReadbackBuffers[i], desc.Width);
+    }
+}
+
+void SceneManager::ResetVisData(D3D12CommandList* pCommandList)
+{
+    // Reset VisData.
+    std::fill(visData.begin(), visData.end(), 0);
 
-    pCommandList->AddTransitionResourceBarriers(pFrustumCullingData->GetResource().Get(),
-        pFrustumCullingData->GetResourceState(), D3D12_RESOURCE_STATE_COPY_DEST);
-    pCommandList->FlushResourceBarriers();
+    pCommandList->TransitionResource(pFrustumCullingData->GetResource().Get(), D3D12_RESOURCE_STATE_COPY_DEST);
     pCommandList->CopyResource(
         pFrustumCullingData->GetResource().Get(),
         pUploadBuffer->ResourceLocation.Resource.Get());
-    pCommandList->AddTransitionResourceBarriers(pFrustumCullingData->GetResource().Get(),
-        D3D12_RESOURCE_STATE_COPY_DEST, pFrustumCullingData->GetResourceState());
-    pCommandList->FlushResourceBarriers();
+    pCommandList->TransitionResource(pFrustumCullingData->GetResource().Get(), pFrustumCullingData->GetResourceState());
 }
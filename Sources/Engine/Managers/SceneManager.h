@@ -2,7 +2,25 @@
 #include "FBXImporter.h"
 #include "Camera.h"
 #include "Model.h"
-#include "AbstractMaterial.h"
+#include "LitMaterial.h"
+#include "AsyncLoader.h"
+#include "TextureCache.h"
+#include "TextureStreamer.h"
+#include "DrawRecorder.h"
+
+// Frames between two reports of the meshlet culling rate.
+#define MESHLET_CULLING_LOG_INTERVAL 600
+
+// Frames between two reports of the cost of the transform updates.
+#define TRANSFORM_UPDATE_LOG_INTERVAL 600
+// Objects a job of the transform update sets at least, fewer cost more to schedule than they save.
+#define TRANSFORM_UPDATE_MIN_RANGE_SIZE 256
+
+// Meshlets culled in about the time a draw is recorded, which weighs the draws that cull theirs.
+#define MESHLETS_PER_DRAW_COST 16
+
+// Loaded assets uploaded in one frame, which bounds the upload work and temp upload buffers of a frame.
+#define ASYNC_LOAD_COMMITS_PER_FRAME 8
 
 struct BLAS
 {
@@ -17,10 +35,29 @@ struct TLAS
 	std::shared_ptr<D3D12UnorderedAccessBuffer> pTopLevelAccelerationStructure;
 };
 
+// A model or the textures of a material, loaded by the ticket of the same index.
+struct LoadingAsset
+{
+	Model* pModel;
+	LitMaterial* pMaterial;
+	BOOL isResident;
+	// The other objects of the mesh of the model, which share it once it is loaded.
+	std::vector<Model*> sharingModels;
+};
+
+// The meshlet scratch and the culling counters of a thread that records draws.
+struct DrawThreadData
+{
+	std::vector<UINT> visibleMeshlets;
+	UINT trianglesNum;
+	UINT visibleTrianglesNum;
+};
+
 class SceneManager
 {
 private:
 	shared_ptr<D3D12Device> pDevice;
+	shared_ptr<JobSystem> pJobSystem;
 	unique_ptr<FBXImporter> pFBXImporter;
 
 	std::vector<Model*> pObjects;
@@ -32,13 +69,46 @@ private:
 
 	UINT objectID;
 
-	// Frustum Culling data.
+	// The transform constants of the frame, the one of the skybox and then the ones of pObjects in order.
+	D3D12_GPU_VIRTUAL_ADDRESS transformConstantsAddress;
+	// The camera constants of the frame, which the root CBV of the passes points at.
+	D3D12_GPU_VIRTUAL_ADDRESS cameraConstantsAddress;
+	double transformUpdateTime;
+
+	// Async loading data. Assets are committed in completion order, and join the scene after the frame
+	// that uploaded them has finished, the loader retires the tickets with the fence value of the frame.
+	// Importers by the thread of the job system, created by the first mesh loaded there. Like
+	// FBXImportPool, every thread owns an importer since the FBX SDK objects are not thread safe.
+	std::vector<unique_ptr<FBXImporter>> loaderImporters;
+	unique_ptr<AsyncLoader> pAsyncLoader;
+	std::vector<LoadingAsset> loadingAssets;
+	UINT residentAssetsNum;
+	// Materials whose texture data has been uploaded have joined the scene.
+	BOOL isTextureDataPending;
+	unique_ptr<TextureCache> pTextureCache;
+	unique_ptr<TextureStreamer> pTextureStreamer;
+	D3D12Texture* pPlaceholderTextures[LIT_MATERIAL_TEXTURES_NUM];
+
+	// Frustum Culling data, a UINT per object of the DXR scene in the order of pObjects. The buffers grow
+	// with the scene, and hold room for visDataCapacity objects.
 	D3D12UnorderedAccessBuffer* pFrustumCullingData;
 	D3D12UploadBuffer* pUploadBuffer;
-	D3D12ReadbackBuffer* pReadbackBuffer;
-	UINT visData[GlobalConstants::kVisDataSize];
+	D3D12ReadbackBuffer* pReadbackBuffers[FRAMES_IN_FLIGHT];
+	UINT visDataCapacity;
+	// The objects the copy to each readback buffer covers, and the objects visData covers. The objects
+	// after them are drawn.
+	UINT readbackObjectsNum[FRAMES_IN_FLIGHT];
+	UINT visDataObjectsNum;
+	std::vector<UINT> visData;
+
+	// The visible objects of the pass, by index in pObjects, and what recording each of them costs.
+	unique_ptr<DrawRecorder> pDrawRecorder;
+	std::vector<UINT> drawObjects;
+	std::vector<UINT> drawCosts;
+	std::vector<DrawThreadData> drawThreads;
 
 	// DXR member variables.
+	BOOL isRayTracingSceneDirty;
 	BLAS blas[GeometryType::Count];
 	TLAS tlas[GeometryType::Count];
 
@@ -50,27 +120,42 @@ private:
 	D3D12UploadBuffer* pTempIndexBuffer;
 	D3D12UploadBuffer* pTempOffsetBuffer;
 	D3D12UploadBuffer* pTempBoundingBoxBuffer;
+	D3D12UploadBuffer* pTempGeometryTransformBuffer;
 	D3D12UploadBuffer* pInstanceDescBuffer;
 
 	// Helper functions.
 	void LoadObjectVertexBufferAndIndexBuffer(D3D12CommandList*, Model* object);
-	void LoadObjectVertexBufferAndIndexBufferDXR(D3D12CommandList*, Model* object, UINT& offset);
+	void LoadObjectVertexBufferAndIndexBufferDXR(D3D12CommandList*, Model* object);
 	void LoadTextureBufferAndSampler(D3D12CommandList*, D3D12Texture* texture);
+	// Record the draws of an object of pObjects, on one of the recording threads.
+	void DrawObject(D3D12CommandList*, UINT index, DrawThreadData& threadData);
+	// Bind the texture slots and the samplers, which draws index with the IDs of their material.
+	void SetBindlessViews(D3D12CommandList*);
+	void BindPlaceholderTextures(LitMaterial* material);
+	// Write the view of a texture into a slot of a material, and use the sampler of the texture there.
+	void BindTexture(D3D12Texture* texture, AbstractMaterial* material, UINT slot);
+	void BuildRayTracingScene(D3D12CommandList* pCommandList);
+	void ReleaseRayTracingScene();
 	void BuildBottomLevelAS(D3D12CommandList* pCommandList, UINT index);
 	void BuildTopLevelAS(D3D12CommandList* pCommandList, UINT index);
 
+	// Make room in the frustum culling buffers for objectsNum objects.
+	void ReserveVisData(D3D12CommandList* pCommandList, UINT objectsNum);
 	void ResetVisData(D3D12CommandList* pCommandList);
 
 public:
-	SceneManager(shared_ptr<D3D12Device>&, BOOL isDXR);
+	SceneManager(shared_ptr<D3D12Device>&, shared_ptr<JobSystem>&, BOOL isDXR);
 	~SceneManager();
 
-	static UINT sTextureID;
-
 	void InitFBXImporter();
 	void ParseScene(D3D12CommandList*);
 	void LoadScene(D3D12CommandList*);
 	void UnloadScene();
+	// Upload the assets finished by the loader since the last frame and the texture mips requested by it,
+	// and rebuild the DXR scene when objects have joined it.
+	void CommitLoadedAssets(D3D12CommandList*);
+	// Add the committed assets to the scene, once the GPU has finished the frame that uploaded them.
+	void ResolveLoadedAssets(UINT64 completedFenceValue);
 	void CreateCamera(UINT width, UINT height);
 	void AddObject(Model* object);
 	void DrawObjects(D3D12CommandList*);
@@ -84,9 +169,17 @@ public:
 	void UpdateTransforms();
 	void UpdateCamera();
 
-	void Release();
+	// The assets committed and the mips streamed so far are uploaded by the GPU work submitted before
+	// fenceValue is signaled.
+	void Retire(UINT64 fenceValue);
+	// Release what the GPU is done with, and the texture data of the materials that joined the scene.
+	void Release(UINT64 completedFenceValue);
 
 	inline const std::vector<Model*>& GetObjects() const { return pObjects; }
 	inline Camera* GetCamera() const { return pCamera; }
+	inline const D3D12_GPU_VIRTUAL_ADDRESS GetCameraConstantsAddress() const { return cameraConstantsAddress; }
 	inline Model* GetSkybox() const { return pSkyboxMesh; }
+	// Every asset is resident and the DXR scene includes all objects.
+	inline const BOOL IsSceneLoaded() const { return pAsyncLoader == nullptr && !isRayTracingSceneDirty; }
+	inline const BOOL IsRayTracingSceneReady() const { return tlas[GeometryType::Triangle].pTopLevelAccelerationStructure != nullptr; }
 };
@@ -0,0 +1,145 @@
+#include "stdafx.h"
+#include "TextureCache.h"
+#include "MeshCache.h"
+#include "SceneManifest.h"
+#include <algorithm>
+
+TextureCache::TextureCache(shared_ptr<D3D12Device>& device) :
+    pDevice(device),
+    hitsNum(0),
+    missesNum(0),
+    savedBytes(0)
+{
+
+}
+
+TextureCache::~TextureCache()
+{
+    for (auto it = entries.begin(); it != entries.end(); it++)
+    {
+        delete it->second.pTexture;
+    }
+}
+
+D3D12Texture* TextureCache::Acquire(const std::wstring& texturePath, UINT srvID)
+{
+    // The block format and the filter follow the name, so two names of the same image can differ in both.
+    TextureCacheKey key = {};
+    key.contentHash = GetContentHash(texturePath);
+    key.blockFormat = TextureCooker::GetBlockFormat(texturePath);
+    key.mipFilterMode = TextureCooker::GetMipFilterMode(key.blockFormat);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    auto it = entries.find(key);
+    if (it != entries.end())
+    {
+        TextureCacheEntry& entry = it->second;
+        entry.refCount++;
+        loadedCondition.wait(lock, [&entry]() { return entry.isLoaded; });
+
+        D3D12Texture* pTexture = entry.pTexture;
+        if (pTexture == nullptr)
+        {
+            if (--entry.refCount == 0)
+            {
+                entries.erase(key);
+            }
+            throw std::exception();
+        }
+
+        hitsNum++;
+        savedBytes += pTexture->GetDataSize();
+        return pTexture;
+    }
+
+    // Load the texture outside of the lock, the other threads wait on this entry only.
+    missesNum++;
+    TextureCacheEntry& entry = entries[key];
+    entry = { new D3D12Texture(srvID), 1, FALSE };
+    lock.unlock();
+
+    D3D12Texture* pTexture = entry.pTexture;
+    std::exception_ptr exception = nullptr;
+    try
+    {
+        std::wstring path = texturePath;
+        pTexture->LoadTexture(pDevice->GetDevice().Get(), path);
+        pTexture->CreateTextureResource();
+    }
+    catch (...)
+    {
+        exception = std::current_exception();
+    }
+
+    lock.lock();
+    entry.isLoaded = TRUE;
+    if (exception == nullptr)
+    {
+        keys[pTexture] = key;
+    }
+    else
+    {
+        delete pTexture;
+        entry.pTexture = nullptr;
+        if (--entry.refCount == 0)
+        {
+            entries.erase(key);
+        }
+    }
+    lock.unlock();
+    loadedCondition.notify_all();
+
+    if (exception != nullptr)
+    {
+        std::rethrow_exception(exception);
+    }
+    return pTexture;
+}
+
+void TextureCache::Release(D3D12Texture* pTexture)
+{
+    if (pTexture == nullptr)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto key = keys.find(pTexture);
+    if (key == keys.end())
+    {
+        return;
+    }
+
+    auto it = entries.find(key->second);
+    if (--it->second.refCount == 0)
+    {
+        delete pTexture;
+        entries.erase(it);
+        keys.erase(key);
+    }
+}
+
+// Helper functions.
+UINT64 TextureCache::GetContentHash(const std::wstring& texturePath)
+{
+    // Different spellings of a path share the hash, which is only computed again when the file changes.
+    WCHAR fullPath[MAX_PATH];
+    std::wstring path = GetFullPathNameW(texturePath.c_str(), MAX_PATH, fullPath, nullptr) != 0 ? fullPath : texturePath;
+    std::transform(path.begin(), path.end(), path.begin(), towlower);
+    UINT64 timestamp = MeshCache::GetSourceTimestamp(path);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = contentHashes.find(path);
+        if (it != contentHashes.end() && it->second.first == timestamp)
+        {
+            return it->second.second;
+        }
+    }
+
+    UINT64 hash = SceneManifest::HashFile(path);
+    std::lock_guard<std::mutex> lock(mutex);
+    contentHashes[path] = { timestamp, hash };
+
+    return hash;
+}
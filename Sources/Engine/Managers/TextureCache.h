@@ -0,0 +1,73 @@
+#pragma once
+#include "D3D12Texture.h"
+#include <condition_variable>
+#include <mutex>
+
+// The same image cooked to another block format or filtered another way is another texture.
+struct TextureCacheKey
+{
+	UINT64 contentHash;
+	TextureBlockFormat blockFormat;
+	MipFilterMode mipFilterMode;
+};
+
+struct TextureCacheKeyHasher
+{
+	size_t operator()(const TextureCacheKey& key) const
+	{
+		return static_cast<size_t>(key.contentHash
+			^ (static_cast<UINT64>(key.blockFormat) << 56) ^ (static_cast<UINT64>(key.mipFilterMode) << 60));
+	}
+};
+
+struct TextureCacheKeyEqual
+{
+	bool operator()(const TextureCacheKey& a, const TextureCacheKey& b) const
+	{
+		return a.contentHash == b.contentHash && a.blockFormat == b.blockFormat && a.mipFilterMode == b.mipFilterMode;
+	}
+};
+
+// A texture shared by every material that references the same image.
+struct TextureCacheEntry
+{
+	D3D12Texture* pTexture;
+	UINT refCount;
+	// Set once the first owner has loaded the texture, or failed to and left pTexture null.
+	BOOL isLoaded;
+};
+
+// Textures keyed by the content hash of their source and how they are cooked, so identical images
+// are decoded, uploaded and kept once. Loader threads can acquire textures at the same time, a thread that asks for
+// a texture still being loaded waits for it.
+class TextureCache
+{
+private:
+	shared_ptr<D3D12Device> pDevice;
+	std::mutex mutex;
+	std::condition_variable loadedCondition;
+	std::unordered_map<TextureCacheKey, TextureCacheEntry, TextureCacheKeyHasher, TextureCacheKeyEqual> entries;
+	std::unordered_map<const D3D12Texture*, TextureCacheKey> keys;
+	// The content hash of a canonical path, and the timestamp it was hashed at.
+	std::unordered_map<std::wstring, std::pair<UINT64, UINT64>> contentHashes;
+
+	UINT hitsNum;
+	UINT missesNum;
+	UINT64 savedBytes;
+
+	UINT64 GetContentHash(const std::wstring& texturePath);
+
+public:
+	TextureCache(shared_ptr<D3D12Device>& device);
+	~TextureCache();
+
+	// Take a reference to the 2D texture of a file, and load it on this thread the first time.
+	// A new texture takes srvID, the ID of the slot that requested it.
+	D3D12Texture* Acquire(const std::wstring& texturePath, UINT srvID);
+	// Drop a reference, the texture is deleted with its last one.
+	void Release(D3D12Texture* pTexture);
+
+	inline const UINT GetHitsNum() const { return hitsNum; }
+	inline const UINT GetMissesNum() const { return missesNum; }
+	inline const UINT64 GetSavedBytes() const { return savedBytes; }
+};
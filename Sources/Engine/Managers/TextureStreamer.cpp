@@ -0,0 +1,316 @@
+#include "stdafx.h"
+#include "TextureStreamer.h"
+#include "ViewManager.h"
+
+TextureStreamer::TextureStreamer(shared_ptr<D3D12Device>& device, UINT64 budget) :
+    pDevice(device),
+    isSupported(FALSE),
+    policy(budget),
+    loadsNum(0),
+    evictionsNum(0)
+{
+    // Mips are mapped to the tiles of reserved resources, which the device may not support.
+    D3D12_FEATURE_DATA_D3D12_OPTIONS options = {};
+    if (SUCCEEDED(pDevice->GetDevice()->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS, &options, sizeof(options))))
+    {
+        isSupported = options.TiledResourcesTier != D3D12_TILED_RESOURCES_TIER_NOT_SUPPORTED;
+    }
+
+    if (!isSupported)
+    {
+        OutputDebugStringW(L"Tiled resources are not supported, textures are uploaded whole.\n");
+    }
+}
+
+TextureStreamer::~TextureStreamer()
+{
+    Clear();
+}
+
+BOOL TextureStreamer::AddTexture(D3D12CommandList* pCommandList, D3D12Texture* pTexture)
+{
+    if (!isSupported || !pTexture->IsStreamable()
+        || max(pTexture->GetWidth(), pTexture->GetHeight()) <= TEXTURE_STREAMING_RESIDENT_MIP_SIZE)
+    {
+        return FALSE;
+    }
+
+    D3D12Resource* pBuffer = pTexture->GetTextureBuffer();
+    pDevice->GetBufferManager()->AllocateReservedBuffer(pBuffer);
+    ID3D12Resource* pResource = pBuffer->GetResource().Get();
+
+    const UINT mipsNum = pTexture->GetMipLevelsNum();
+    UINT tilesNum = 0;
+    UINT subresourceTilingsNum = mipsNum;
+    D3D12_PACKED_MIP_INFO packedMipInfo = {};
+    D3D12_TILE_SHAPE tileShape = {};
+    std::vector<D3D12_SUBRESOURCE_TILING> subresourceTilings(mipsNum);
+    pDevice->GetDevice()->GetResourceTiling(pResource, &tilesNum, &packedMipInfo, &tileShape,
+        &subresourceTilingsNum, 0, subresourceTilings.data());
+
+    // A texture that fits in its packed mips has nothing to stream, and is uploaded whole instead.
+    const UINT standardMipsNum = packedMipInfo.NumStandardMips;
+    if (standardMipsNum == 0)
+    {
+        pDevice->GetBufferManager()->ReleaseDefaultBuffer(pBuffer);
+        pBuffer->SetResourceLoaction(nullptr);
+        return FALSE;
+    }
+
+    // The coarse mips are always resident, and at least the packed ones or the last mip.
+    UINT tailMip = packedMipInfo.NumPackedMips > 0 ? standardMipsNum : mipsNum - 1;
+    for (UINT i = 0; i < tailMip; i++)
+    {
+        if (max(pTexture->GetWidth() >> i, pTexture->GetHeight() >> i) <= TEXTURE_STREAMING_RESIDENT_MIP_SIZE)
+        {
+            tailMip = i;
+            break;
+        }
+    }
+
+    // A standard mip takes whole tiles, and the tiles of the packed mips are counted at the first of them.
+    std::vector<UINT> mipTilesNum(mipsNum, 0);
+    std::vector<UINT64> mipSizes(mipsNum, 0);
+    for (UINT i = 0; i < standardMipsNum; i++)
+    {
+        mipTilesNum[i] = subresourceTilings[i].WidthInTiles * subresourceTilings[i].HeightInTiles
+            * subresourceTilings[i].DepthInTiles;
+        mipSizes[i] = static_cast<UINT64>(mipTilesNum[i]) * D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES;
+    }
+    if (packedMipInfo.NumPackedMips > 0)
+    {
+        mipSizes[standardMipsNum] = static_cast<UINT64>(packedMipInfo.NumTilesForPackedMips) * D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES;
+    }
+
+    const UINT handle = policy.Register(mipSizes.data(), mipsNum, tailMip);
+    if (textures.size() <= handle)
+    {
+        textures.resize(handle + 1);
+    }
+
+    StreamedTexture& texture = textures[handle];
+    texture = {};
+    texture.pTexture = pTexture;
+    texture.mipTilesNum = mipTilesNum;
+    texture.pMipHeaps.resize(mipsNum);
+
+    // Map and upload the coarse mips, the rest stream in once they are requested.
+    for (UINT i = tailMip; i < standardMipsNum; i++)
+    {
+        texture.pMipHeaps[i] = CreateHeap(texture.mipTilesNum[i]);
+        MapTiles(pResource, i, texture.mipTilesNum[i], texture.pMipHeaps[i].Get());
+    }
+    if (packedMipInfo.NumPackedMips > 0)
+    {
+        texture.pTailHeap = CreateHeap(packedMipInfo.NumTilesForPackedMips);
+        MapTiles(pResource, standardMipsNum, packedMipInfo.NumTilesForPackedMips, texture.pTailHeap.Get());
+    }
+
+    UploadMips(pCommandList, pTexture, tailMip, mipsNum - tailMip);
+    pCommandList->TransitionResource(pResource, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+
+    pTexture->SetStreamed(TRUE);
+    pTexture->SetResidentMip(tailMip);
+    handles[pTexture] = handle;
+    slotHandles[pTexture->GetTextureID()] = handle;
+
+    return TRUE;
+}
+
+void TextureStreamer::AddSlot(D3D12Texture* pTexture, UINT id)
+{
+    auto it = handles.find(pTexture);
+    if (it == handles.end())
+    {
+        return;
+    }
+
+    slotHandles[id] = it->second;
+    if (id != pTexture->GetTextureID())
+    {
+        textures[it->second].slotIDs.push_back(id);
+    }
+}
+
+void TextureStreamer::RequestMip(UINT id, FLOAT uvsPerPixel, UINT64 frame)
+{
+    auto it = slotHandles.find(id);
+    if (it == slotHandles.end())
+    {
+        return;
+    }
+
+    // One pixel covers 2^mip texels of the mip the texture is sampled at.
+    const D3D12Texture* pTexture = textures[it->second].pTexture;
+    FLOAT texelsPerPixel = uvsPerPixel * max(pTexture->GetWidth(), pTexture->GetHeight());
+    UINT mip = texelsPerPixel > 1.0f ? static_cast<UINT>(log2f(texelsPerPixel)) : 0;
+    policy.Request(it->second, min(mip, pTexture->GetMipLevelsNum() - 1), frame);
+}
+
+void TextureStreamer::Update(D3D12CommandList* pCommandList, UINT64 frame)
+{
+    policy.Update(frame, actions);
+    for (const TextureStreamingAction& action : actions)
+    {
+        StreamedTexture& texture = textures[action.texture];
+        ID3D12Resource* pResource = texture.pTexture->GetTextureBuffer()->GetResource().Get();
+        const UINT tilesNum = texture.mipTilesNum[action.mip];
+
+        if (action.type == TextureStreamingActionType::Load)
+        {
+            // The tiles are mapped on the queue before the copy of this frame's command list runs.
+            texture.pMipHeaps[action.mip] = CreateHeap(tilesNum);
+            MapTiles(pResource, action.mip, tilesNum, texture.pMipHeaps[action.mip].Get());
+
+            // Only the mip being loaded leaves the state the draws sample the others in.
+            pCommandList->TransitionResource(pResource, D3D12_RESOURCE_STATE_COPY_DEST, action.mip);
+            UploadMips(pCommandList, texture.pTexture, action.mip, 1);
+            pCommandList->TransitionResource(pResource, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, action.mip);
+
+            PendingLoad load = { action.texture, action.mip, UINT64_MAX };
+            pendingLoads.push_back(load);
+            loadsNum++;
+        }
+        else
+        {
+            // The frames still in flight may sample the mip, but the unmap runs on the queue after them.
+            // A load of it that has not lowered the clamp yet never will.
+            for (PendingLoad& load : pendingLoads)
+            {
+                if (load.texture == action.texture && load.mip <= action.mip)
+                {
+                    load.mip = UINT_MAX;
+                }
+            }
+            if (texture.pTexture->GetResidentMip() <= action.mip)
+            {
+                SetResidentMip(texture, action.mip + 1);
+            }
+            MapTiles(pResource, action.mip, tilesNum, nullptr);
+            RetiredHeap heap = { texture.pMipHeaps[action.mip], UINT64_MAX };
+            retiredHeaps.push_back(heap);
+            texture.pMipHeaps[action.mip].Reset();
+            evictionsNum++;
+        }
+    }
+
+    if (ViewManager::sFrameCount % TEXTURE_STREAMING_LOG_INTERVAL == 0 && !handles.empty())
+    {
+        WCHAR message[256];
+        swprintf_s(message, L"Texture streaming: %.2f of %.2f MB resident, %u loads and %u evictions.\n",
+            policy.GetResidentBytes() / 1048576.0, policy.GetBudget() / 1048576.0, loadsNum, evictionsNum);
+        OutputDebugStringW(message);
+    }
+}
+
+void TextureStreamer::Retire(UINT64 fenceValue)
+{
+    for (auto it = pendingLoads.rbegin(); it != pendingLoads.rend() && it->fenceValue == UINT64_MAX; it++)
+    {
+        it->fenceValue = fenceValue;
+    }
+    for (auto it = retiredHeaps.rbegin(); it != retiredHeaps.rend() && it->fenceValue == UINT64_MAX; it++)
+    {
+        it->fenceValue = fenceValue;
+    }
+}
+
+void TextureStreamer::Release(UINT64 completedFenceValue)
+{
+    while (!pendingLoads.empty() && pendingLoads.front().fenceValue <= completedFenceValue)
+    {
+        const PendingLoad& load = pendingLoads.front();
+        if (load.mip != UINT_MAX && textures[load.texture].pTexture->GetResidentMip() > load.mip)
+        {
+            SetResidentMip(textures[load.texture], load.mip);
+        }
+        pendingLoads.pop_front();
+    }
+
+    while (!retiredHeaps.empty() && retiredHeaps.front().fenceValue <= completedFenceValue)
+    {
+        retiredHeaps.pop_front();
+    }
+}
+
+void TextureStreamer::Clear()
+{
+    for (auto it = handles.begin(); it != handles.end(); it++)
+    {
+        policy.Unregister(it->second);
+        textures[it->second].pTexture->SetStreamed(FALSE);
+        textures[it->second] = {};
+    }
+    handles.clear();
+    slotHandles.clear();
+    pendingLoads.clear();
+    retiredHeaps.clear();
+}
+
+void TextureStreamer::SetBudget(UINT64 budget)
+{
+    policy.SetBudget(budget);
+}
+
+// Helper functions.
+void TextureStreamer::MapTiles(ID3D12Resource* pResource, UINT subresource, UINT tilesNum, ID3D12Heap* pHeap)
+{
+    // Tiles without a heap are mapped to null.
+    D3D12_TILED_RESOURCE_COORDINATE coordinate = { 0, 0, 0, subresource };
+    D3D12_TILE_REGION_SIZE regionSize = {};
+    regionSize.NumTiles = tilesNum;
+    regionSize.UseBox = FALSE;
+    D3D12_TILE_RANGE_FLAGS rangeFlags = pHeap != nullptr ? D3D12_TILE_RANGE_FLAG_NONE : D3D12_TILE_RANGE_FLAG_NULL;
+    UINT heapStart = 0;
+
+    pDevice->GetCommandQueue()->UpdateTileMappings(pResource, 1, &coordinate, &regionSize,
+        pHeap, 1, &rangeFlags, &heapStart, &tilesNum, D3D12_TILE_MAPPING_FLAG_NONE);
+}
+
+ComPtr<ID3D12Heap> TextureStreamer::CreateHeap(UINT tilesNum)
+{
+    ComPtr<ID3D12Heap> pHeap;
+    ThrowIfFailed(pDevice->GetDevice()->CreateHeap(
+        &CD3DX12_HEAP_DESC(static_cast<UINT64>(tilesNum) * D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES,
+            D3D12_HEAP_TYPE_DEFAULT, 0, D3D12_HEAP_FLAG_DENY_BUFFERS | D3D12_HEAP_FLAG_DENY_RT_DS_TEXTURES),
+        IID_PPV_ARGS(&pHeap)));
+
+    return pHeap;
+}
+
+void TextureStreamer::UploadMips(D3D12CommandList* pCommandList, D3D12Texture* pTexture, UINT firstMip, UINT mipsNum)
+{
+    std::vector<D3D12_SUBRESOURCE_DATA> textureData(mipsNum);
+    std::vector<UINT> numRows(mipsNum);
+    std::vector<UINT64> rowSizesInBytes(mipsNum);
+    UINT64 totalBytes;
+    pDevice->GetDevice()->GetCopyableFootprints(&pTexture->GetTextureBuffer()->GetResourceDesc(),
+        firstMip, mipsNum, 0, nullptr, numRows.data(), rowSizesInBytes.data(), &totalBytes);
+    for (UINT i = 0; i < mipsNum; i++)
+    {
+        textureData[i].pData = pTexture->GetTextureDataAt(firstMip + i);
+        textureData[i].RowPitch = rowSizesInBytes[i];
+        textureData[i].SlicePitch = rowSizesInBytes[i] * numRows[i];
+    }
+
+    D3D12UploadBuffer* tempBuffer = new D3D12UploadBuffer();
+    pDevice->GetBufferManager()->AllocateTempUploadBuffer(tempBuffer, totalBytes, nullptr,
+        D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+    pCommandList->CopyTextureBuffer(pTexture->GetTextureBuffer()->GetResource().Get(),
+        tempBuffer->ResourceLocation.Resource.Get(), tempBuffer->GetResourceOffset(),
+        firstMip, mipsNum, textureData.data());
+}
+
+void TextureStreamer::SetResidentMip(StreamedTexture& texture, UINT mip)
+{
+    // The views are staged, and copied to the texture slots of each frame before it is recorded, once the GPU
+    // has finished the last frame of its slot. The clamp is only lowered to mips that are done uploading.
+    texture.pTexture->SetResidentMip(mip);
+    D3D12Resource* pBuffer = texture.pTexture->GetTextureBuffer();
+    D3D12DescriptorHeapManager* pDescriptorHeapManager = pDevice->GetDescriptorHeapManager();
+    pDescriptorHeapManager->StageView(pDevice->GetDevice(), pBuffer, texture.pTexture->GetTextureID());
+    for (UINT id : texture.slotIDs)
+    {
+        pDescriptorHeapManager->StageView(pDevice->GetDevice(), pBuffer, id);
+    }
+}
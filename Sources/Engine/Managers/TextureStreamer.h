@@ -0,0 +1,94 @@
+#pragma once
+#include "D3D12Texture.h"
+#include "TextureStreamingPolicy.h"
+#include <deque>
+
+// VRAM for the streamed textures, including the coarse mips they always keep.
+#define TEXTURE_STREAMING_BUDGET_MB 256
+// Mips at most this many texels wide are loaded with the texture and never evicted.
+#define TEXTURE_STREAMING_RESIDENT_MIP_SIZE 256
+// Frames between two reports of the streaming state.
+#define TEXTURE_STREAMING_LOG_INTERVAL 600
+
+// A texture whose mips are the 64KB tiles of a reserved resource. A finer mip is backed by a heap
+// of its own while it is resident, the coarse mips share one heap for the life of the texture.
+struct StreamedTexture
+{
+	D3D12Texture* pTexture;
+	std::vector<UINT> mipTilesNum;
+	std::vector<ComPtr<ID3D12Heap>> pMipHeaps;
+	ComPtr<ID3D12Heap> pTailHeap;
+	// Slots of other textures that view this one, and are rewritten with its own when its resident mip changes.
+	std::vector<UINT> slotIDs;
+};
+
+// Streams the mips of the textures in and out of VRAM, for the sizes the renderer draws them at.
+// The views of a texture are clamped to its finest resident mip with ResourceMinLODClamp.
+// A load maps and uploads a mip in one frame, and lowers the clamp once the GPU has finished it. An eviction
+// raises the clamp in the frame that unmaps the mip, whose heap is freed after the GPU finishes it. The views
+// are staged, and every frame binds its own copy of them, so a changed clamp only reaches the frames
+// recorded after it and never the descriptors the frames in flight read.
+class TextureStreamer
+{
+private:
+	// A mip loaded or a heap unmapped by the frames submitted before fenceValue is signaled, UINT64_MAX
+	// until they are retired.
+	struct PendingLoad
+	{
+		UINT texture;
+		UINT mip;
+		UINT64 fenceValue;
+	};
+
+	struct RetiredHeap
+	{
+		ComPtr<ID3D12Heap> pHeap;
+		UINT64 fenceValue;
+	};
+
+	shared_ptr<D3D12Device> pDevice;
+	BOOL isSupported;
+	TextureStreamingPolicy policy;
+	// Textures by their handle in the policy.
+	std::vector<StreamedTexture> textures;
+	std::unordered_map<const D3D12Texture*, UINT> handles;
+	// The texture of every slot that views a streamed texture.
+	std::unordered_map<UINT, UINT> slotHandles;
+	std::vector<TextureStreamingAction> actions;
+	// Loads and heaps in the order of their frames.
+	std::deque<PendingLoad> pendingLoads;
+	std::deque<RetiredHeap> retiredHeaps;
+
+	UINT loadsNum;
+	UINT evictionsNum;
+
+	void MapTiles(ID3D12Resource* pResource, UINT subresource, UINT tilesNum, ID3D12Heap* pHeap);
+	ComPtr<ID3D12Heap> CreateHeap(UINT tilesNum);
+	// Upload the mips of a texture in the copy destination state.
+	void UploadMips(D3D12CommandList* pCommandList, D3D12Texture* pTexture, UINT firstMip, UINT mipsNum);
+	void SetResidentMip(StreamedTexture& texture, UINT mip);
+
+public:
+	TextureStreamer(shared_ptr<D3D12Device>& device, UINT64 budget = TEXTURE_STREAMING_BUDGET_MB * 1048576ull);
+	~TextureStreamer();
+
+	// Create the reserved resource of a texture with its coarse mips uploaded. Returns FALSE if the device
+	// or the texture can not be streamed, and the texture is then uploaded whole.
+	BOOL AddTexture(D3D12CommandList* pCommandList, D3D12Texture* pTexture);
+	// Record a slot the view of a streamed texture was written to.
+	void AddSlot(D3D12Texture* pTexture, UINT id);
+	// Ask for the mip of the texture in a slot that samples uvsPerPixel UV units per pixel.
+	void RequestMip(UINT id, FLOAT uvsPerPixel, UINT64 frame);
+	// Map and upload the mips for the requests of a frame, and unmap the ones evicted for them.
+	void Update(D3D12CommandList* pCommandList, UINT64 frame);
+	// The loads and evictions so far are done by the GPU work submitted before fenceValue is signaled.
+	void Retire(UINT64 fenceValue);
+	// Lower the clamps of the loaded mips and free the heaps of the evicted ones, once the GPU has finished
+	// the frames that uploaded and unmapped them.
+	void Release(UINT64 completedFenceValue);
+	// Stop streaming every texture, the GPU must be idle.
+	void Clear();
+	void SetBudget(UINT64 budget);
+
+	inline const UINT64 GetResidentBytes() const { return policy.GetResidentBytes(); }
+};
@@ -6,7 +6,7 @@ ViewManager::ViewManager(std::shared_ptr<D3D12Device>& device, UINT inWidth, UIN
     pDevice(device),
     width(inWidth),
     height(inHeight),
-    globalSRVID(0),
+    globalSRVID(TARGET_SRV_START),
     rtvID(FRAME_COUNT),
     dsvID(0),
     uavID(0)
@@ -43,19 +43,17 @@ ViewManager::ViewManager(std::shared_ptr<D3D12Device>& device, UINT inWidth, UIN
     for (UINT n = 0; n < FRAME_COUNT; n++)
     {
         ThrowIfFailed(pSwapChain->GetBuffer(n, IID_PPV_ARGS(&pBackBuffers[n])));
+        pDevice->GetResourceStateTracker()->Register(pBackBuffers[n].Get(), D3D12_RESOURCE_STATE_PRESENT);
         pDevice->GetDevice()->CreateRenderTargetView(pBackBuffers[n].Get(), nullptr,
             pDevice->GetDescriptorHeapManager()->GetHandle(RENDER_TARGET_VIEW, n));
     }
 
-    // Create a render target for the color buffer.
-    colorHandles[0] = CreateRenderTarget();
-    colorHandles[1] = CreateRenderTarget();
-    useFirstHandle = TRUE;
-
-    // Create render targets for the GBuffer.
+    // Create render targets for the color buffers and the GBuffer, which only live during the frame.
+    colorHandle = CreateRenderTarget(TRUE);
+    taaColorHandle = CreateRenderTarget(TRUE);
     for (UINT i = 0; i < GetGBufferCount(); i++)
     {
-        gBufferHandle[i] = CreateRenderTarget();
+        gBufferHandle[i] = CreateRenderTarget(TRUE);
     }
 
     dsvHandle = CreateDepthStencilView();
@@ -72,6 +70,10 @@ ViewManager::~ViewManager()
     {
         delete it->second;
     }
+    for (auto it = pShaderResourceViews.begin(); it != pShaderResourceViews.end(); it++)
+    {
+        delete it->second;
+    }
 }
 
 UINT ViewManager::sFrameCount = 0;
@@ -80,14 +82,28 @@ void ViewManager::UpdateFrameIndex()
 {
     frameIndex = pSwapChain->GetCurrentBackBufferIndex();
     sFrameCount++;
+
+    if (sFrameCount % DESCRIPTOR_CACHE_LOG_INTERVAL == 0)
+    {
+        pDevice->GetDescriptorHeapManager()->ReportDescriptorCaches();
+    }
 }
 
-UINT ViewManager::CreateRenderTarget()
+UINT ViewManager::CreateRenderTarget(BOOL isTransient)
 {
     D3D12Texture* pRenderTarget = new D3D12Texture(globalSRVID++, rtvID++, width, height,
         D3D12TextureType::RenderTarget, DXGI_FORMAT_R16G16B16A16_FLOAT);
     pRenderTarget->CreateTextureResource();
 
+    const UINT rtvHandle = pRenderTarget->GetRTVHandle();
+    pRenderTargetViews[rtvHandle] = pRenderTarget;
+    if (isTransient)
+    {
+        transientTargets[rtvHandle] = pDevice->GetDevice()->GetResourceAllocationInfo(
+            0, 1, &pRenderTarget->GetTextureBuffer()->GetResourceDesc());
+        return rtvHandle;
+    }
+
     D3D12_CLEAR_VALUE renderTargetClearValue = {};
     renderTargetClearValue.Color[0] = 0.0f;
     renderTargetClearValue.Color[1] = 0.0f;
@@ -100,11 +116,9 @@ UINT ViewManager::CreateRenderTarget()
         L"RenderTargetView",
         &renderTargetClearValue);
 
-    const UINT rtvHandle = pRenderTarget->GetRTVHandle();
-    pRenderTarget->GetTextureBuffer()->CreateView(pDevice->GetDevice(),
-        pDevice->GetDescriptorHeapManager()->GetHandle(RENDER_TARGET_VIEW, rtvHandle));
-
-    pRenderTargetViews[rtvHandle] = pRenderTarget;
+    pDevice->GetDescriptorHeapManager()->CreateView(pDevice->GetDevice(),
+        pRenderTarget->GetTextureBuffer(), RENDER_TARGET_VIEW, rtvHandle);
+    CreateShaderResourceView(pRenderTarget, DXGI_FORMAT_R16G16B16A16_FLOAT);
 
     return rtvHandle;
 }
@@ -127,8 +141,9 @@ UINT ViewManager::CreateDepthStencilView()
         &depthOptimizedClearValue);
 
     const UINT dsvHandle = pDepthStencil->GetDSVHandle();
-    pDepthStencil->GetTextureBuffer()->CreateView(pDevice->GetDevice(),
-        pDevice->GetDescriptorHeapManager()->GetHandle(DEPTH_STENCIL_VIEW, dsvHandle));
+    pDevice->GetDescriptorHeapManager()->CreateView(pDevice->GetDevice(),
+        pDepthStencil->GetTextureBuffer(), DEPTH_STENCIL_VIEW, dsvHandle);
+    CreateShaderResourceView(pDepthStencil, DXGI_FORMAT_R32_TYPELESS);
 
     pDepthStencilViews[dsvHandle] = pDepthStencil;
     return dsvHandle;
@@ -155,71 +170,90 @@ UINT ViewManager::CreateUnorderedAccessView()
 
 const UINT ViewManager::GetRTVSRVHandle(UINT rtvHandle)
 {
-    if (pRenderTargetViews[rtvHandle] != nullptr
-        && pRenderTargetViews[rtvHandle]->GetType() == D3D12TextureType::ShaderResource)
-    {
-        return pRenderTargetViews[rtvHandle]->GetTextureID();
-    }
-    return 0;
+    return pRenderTargetViews[rtvHandle]->GetTextureID();
 }
 
 const UINT ViewManager::GetDSVSRVHandle(UINT dsvHandle)
 {
-    if (pDepthStencilViews[dsvHandle] != nullptr
-        && pDepthStencilViews[dsvHandle]->GetType() == D3D12TextureType::ShaderResource)
-    {
-        return pDepthStencilViews[dsvHandle]->GetTextureID();
-    }
-    return 0;
+    return pDepthStencilViews[dsvHandle]->GetTextureID();
 }
 
-const UINT ViewManager::GetNextColorHandle()
+void ViewManager::DeclareTargets(RenderGraph& renderGraph)
 {
-    useFirstHandle = !useFirstHandle;
-    return GetCurrentColorHandle();
+    targetResources.clear();
+    backBufferResource = ImportTarget(renderGraph, GetCurrentBackBuffer(), D3D12_RESOURCE_STATE_PRESENT);
+    depthResource = ImportTarget(renderGraph, pDepthStencilViews[dsvHandle]->GetTextureBuffer()->GetResource().Get(),
+        D3D12_RESOURCE_STATE_DEPTH_WRITE);
+    uavColorResource = ImportTarget(renderGraph,
+        pUnorderedAccessViews[uavColorHandle]->GetTextureBuffer()->GetResource().Get(),
+        D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+
+    for (auto it = pRenderTargetViews.begin(); it != pRenderTargetViews.end(); it++)
+    {
+        auto transientIt = transientTargets.find(it->first);
+        if (transientIt == transientTargets.end())
+        {
+            renderTargetResources[it->first] = ImportTarget(renderGraph,
+                it->second->GetTextureBuffer()->GetResource().Get(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+            continue;
+        }
+
+        renderTargetResources[it->first] = renderGraph.CreateTransientResource(
+            transientIt->second.SizeInBytes, transientIt->second.Alignment);
+        targetResources.push_back(it->second->GetTextureBuffer()->GetResource().Get());
+    }
 }
 
-void ViewManager::ConvertTextureType(
-    D3D12CommandList*& pCommandList,
-    UINT handleIndex,
-    D3D12TextureType type,
-    D3D12TextureType targetType,
-    BOOL isPixelShaderResource)
+void ViewManager::PlaceTransientTargets(const RenderGraph& renderGraph)
 {
-    UINT heapMapIndex = targetType == D3D12TextureType::ShaderResource ? SHADER_RESOURCE_VIEW_GLOBAL
-        : targetType == D3D12TextureType::DepthStencil ? DEPTH_STENCIL_VIEW
-        : RENDER_TARGET_VIEW;
+    D3D12BufferManager* pBufferManager = pDevice->GetBufferManager();
+    pBufferManager->CreateAliasedHeap(max(renderGraph.GetAliasedSize(), 1ull));
 
-    auto convert = [&](D3D12Texture*& resource)
+    D3D12_CLEAR_VALUE renderTargetClearValue = {};
+    renderTargetClearValue.Color[3] = 1.0f;
+    renderTargetClearValue.Format = DXGI_FORMAT_R16G16B16A16_FLOAT;
+    transientOffsets.assign(renderGraph.GetResourcesNum(), 0);
+    for (auto it = transientTargets.begin(); it != transientTargets.end(); it++)
     {
-        D3D12_RESOURCE_STATES stateBefore = GetResourceState(resource->GetType(), isPixelShaderResource);
-        UINT offset = targetType == D3D12TextureType::ShaderResource ? resource->GetTextureID()
-            : targetType == D3D12TextureType::DepthStencil ? 0
-            : handleIndex;
-
-        resource->ChangeTextureType(targetType);
-        resource->GetTextureBuffer()->CreateView(pDevice->GetDevice(),
-            pDevice->GetDescriptorHeapManager()->GetHandle(heapMapIndex, offset));
-        pCommandList->AddTransitionResourceBarriers(
-            resource->GetTextureBuffer()->GetResource().Get(),
-            stateBefore,
-            GetResourceState(targetType, isPixelShaderResource));
-    };
-
-    convert(type == D3D12TextureType::DepthStencil ? pDepthStencilViews[0] : pRenderTargetViews[handleIndex]);
-    pCommandList->FlushResourceBarriers();
+        const UINT resource = renderTargetResources[it->first];
+        D3D12Texture* pRenderTarget = pRenderTargetViews[it->first];
+        transientOffsets[resource] = renderGraph.GetOffset(resource);
+        pBufferManager->AllocateAliasedBuffer(
+            pRenderTarget->GetTextureBuffer(),
+            transientOffsets[resource],
+            D3D12_RESOURCE_STATE_RENDER_TARGET,
+            L"TransientRenderTarget",
+            &renderTargetClearValue);
+
+        pDevice->GetDescriptorHeapManager()->CreateView(pDevice->GetDevice(),
+            pRenderTarget->GetTextureBuffer(), RENDER_TARGET_VIEW, it->first);
+        delete pShaderResourceViews[pRenderTarget->GetTextureID()];
+        CreateShaderResourceView(pRenderTarget, DXGI_FORMAT_R16G16B16A16_FLOAT);
+    }
+
+    WCHAR message[256];
+    swprintf_s(message, L"Transient render targets: %.2f MB aliased in %.2f MB.\n",
+        renderGraph.GetTransientSize() / 1048576.0, renderGraph.GetAliasedSize() / 1048576.0);
+    OutputDebugStringW(message);
 }
 
 // Helper functions
-D3D12_RESOURCE_STATES ViewManager::GetResourceState(D3D12TextureType type, BOOL isPixelShaderResource)
+void ViewManager::CreateShaderResourceView(D3D12Texture* pTarget, DXGI_FORMAT format)
 {
-    switch (type)
-    {
-    case D3D12TextureType::ShaderResource:
-        return isPixelShaderResource ? D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE : D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
-    case D3D12TextureType::DepthStencil:
-        return D3D12_RESOURCE_STATE_DEPTH_WRITE;
-    case D3D12TextureType::RenderTarget:
-        return D3D12_RESOURCE_STATE_RENDER_TARGET;
-    }
+    // The view is written once, as the target is read in the same state every frame.
+    const UINT srvID = pTarget->GetTextureID();
+    D3D12Texture* pShaderResource = new D3D12Texture(srvID, -1, width, height,
+        D3D12TextureType::ShaderResource, format);
+    pShaderResource->CreateTextureResource();
+    pShaderResource->GetTextureBuffer()->SetResourceLoaction(pTarget->GetTextureBuffer()->GetResource());
+    pDevice->GetDescriptorHeapManager()->CreateView(pDevice->GetDevice(),
+        pShaderResource->GetTextureBuffer(), SHADER_RESOURCE_VIEW_GLOBAL, srvID);
+
+    pShaderResourceViews[srvID] = pShaderResource;
+}
+
+UINT ViewManager::ImportTarget(RenderGraph& renderGraph, ID3D12Resource* pResource, D3D12_RESOURCE_STATES state)
+{
+    targetResources.push_back(pResource);
+    return renderGraph.ImportResource(state);
 }
@@ -1,5 +1,9 @@
 #pragma once
 #include "D3D12Texture.h"
+#include "RenderGraph.h"
+
+// The first global SRVs hold the buffers of the ray tracing scene, the views of the targets follow them.
+#define TARGET_SRV_START 4
 
 class ViewManager
 {
@@ -12,13 +16,25 @@ private:
     std::map<UINT, D3D12Texture*> pRenderTargetViews;
     std::map<UINT, D3D12Texture*> pDepthStencilViews;
     std::map<UINT, D3D12Texture*> pUnorderedAccessViews;
+    // The shader resource views of the targets, by their IDs. They share the resources of the targets.
+    std::map<UINT, D3D12Texture*> pShaderResourceViews;
+    // Transient render targets get their memory where the render graph aliases them.
+    std::map<UINT, D3D12_RESOURCE_ALLOCATION_INFO> transientTargets;
+    std::vector<UINT64> transientOffsets;
 
     // Index of handles.
-    UINT colorHandles[2];
+    UINT colorHandle;
+    UINT taaColorHandle;
     UINT gBufferHandle[kGBufferCount];
     UINT dsvHandle;
     UINT uavColorHandle;
-    BOOL useFirstHandle;
+
+    // The resources of the targets in the render graph of the frame.
+    std::vector<ID3D12Resource*> targetResources;
+    std::map<UINT, UINT> renderTargetResources;
+    UINT backBufferResource;
+    UINT depthResource;
+    UINT uavColorResource;
 
     UINT frameIndex;
     UINT globalSRVID;
@@ -29,7 +45,8 @@ private:
     UINT height;
 
     // Helper functions
-    D3D12_RESOURCE_STATES GetResourceState(D3D12TextureType type, BOOL isPixelShaderResource);
+    void CreateShaderResourceView(D3D12Texture* pTarget, DXGI_FORMAT format);
+    UINT ImportTarget(RenderGraph& renderGraph, ID3D12Resource* pResource, D3D12_RESOURCE_STATES state);
 
 public:
     ViewManager(std::shared_ptr<D3D12Device>&, UINT inWidth, UINT inHeight);
@@ -38,21 +55,25 @@ public:
     static UINT sFrameCount;
 
     void UpdateFrameIndex();
-    UINT CreateRenderTarget();
+    // A transient render target has no memory until the render graph places it.
+    UINT CreateRenderTarget(BOOL isTransient = FALSE);
     UINT CreateDepthStencilView();
     UINT CreateUnorderedAccessView();
-    const UINT GetNextColorHandle();
     const UINT GetRTVSRVHandle(UINT rtvHandle);
     const UINT GetDSVSRVHandle(UINT dsvHandle);
-    void ConvertTextureType(
-        D3D12CommandList*& pCommandList,
-        UINT handleIndex,
-        D3D12TextureType type,
-        D3D12TextureType targetType,
-        BOOL isPixelShaderResource = TRUE);
+
+    // Add the targets to the render graph of a frame. The back buffer, the depth and the UAV start and end
+    // the frame in the states they are presented and cleared in, and the other persistent render targets
+    // rest as shader resources.
+    void DeclareTargets(RenderGraph& renderGraph);
+    // Place the transient render targets where a compiled render graph aliases them. The graph of the frame
+    // changes with the passes it runs, so this is done once for the graph with all of them.
+    void PlaceTransientTargets(const RenderGraph& renderGraph);
 
     inline IDXGISwapChain3* GetSwapChain() const { return pSwapChain.Get(); }
-    inline const UINT GetCurrentColorHandle() const { return useFirstHandle == TRUE ? colorHandles[0] : colorHandles[1]; }
+    // The lit color, and the color after TAA that is presented.
+    inline const UINT GetColorHandle() const { return colorHandle; }
+    inline const UINT GetTAAColorHandle() const { return taaColorHandle; }
     inline const UINT GetGBufferHandle(UINT index) const { return gBufferHandle[index]; }
     inline const UINT GetGBufferCount() const { return kGBufferCount; }
     inline const UINT GetCurrentDSVHandle() const { return dsvHandle; }
@@ -60,6 +81,12 @@ public:
     inline const UINT GetFrameIndex() const { return frameIndex; }
 
     inline ID3D12Resource* GetCurrentBackBuffer() const { return pBackBuffers[frameIndex].Get(); }
-    inline const D3D12Resource* GetCurrentRTVBuffer(UINT rtvHandle) { return pRenderTargetViews[rtvHandle]->GetTextureBuffer(); }
-    inline const D3D12Resource* GetUAVBuffer(UINT uavHandle) { return pUnorderedAccessViews[uavHandle]->GetTextureBuffer(); }
+
+    inline const UINT GetBackBufferResource() const { return backBufferResource; }
+    inline const UINT GetDepthResource() const { return depthResource; }
+    inline const UINT GetUAVColorResource() const { return uavColorResource; }
+    inline const UINT GetRenderTargetResource(UINT rtvHandle) { return renderTargetResources[rtvHandle]; }
+    inline ID3D12Resource* GetTargetResource(UINT resource) const { return targetResources[resource]; }
+    // The offsets the transient targets are placed at, by their resources in the render graph.
+    inline const UINT64* GetTransientOffsets() const { return transientOffsets.data(); }
 };
@@ -2,7 +2,10 @@
 #include "AbstractMaterial.h"
 
 AbstractMaterial::AbstractMaterial(std::wstring inName) :
-	name(inName)
+	name(inName),
+	pTexture(nullptr),
+	textureID(-1),
+	samplerIDs{}
 {
 
 }
@@ -1,18 +1,35 @@
 #pragma once
 #include "D3D12Texture.h"
 
+// The most textures a material has, as many as MaterialConstant has sampler IDs.
+#define MATERIAL_TEXTURES_MAX_NUM 3
+
 class AbstractMaterial
 {
 protected:
 	std::wstring name;
 	D3D12Texture* pTexture;
+	UINT textureID;
+	// The sampler of the texture bound to each slot of the material.
+	UINT samplerIDs[MATERIAL_TEXTURES_MAX_NUM];
 
 public:
 	AbstractMaterial(std::wstring inName);
 	virtual ~AbstractMaterial();
 
+	// Take the texture slots on the render thread, so that LoadTexture can run on a loader thread.
+	virtual void ReserveTextureIDs(D3D12DescriptorHeapManager* pDescriptorHeapManager) = 0;
+	// Give the texture slots back, once the material is no longer drawn.
+	virtual void FreeTextureIDs(D3D12DescriptorHeapManager* pDescriptorHeapManager) = 0;
 	virtual void LoadTexture() = 0;
 	virtual void ReleaseTextureData() = 0;
 
+	inline const std::wstring& GetName() const { return name; }
 	inline D3D12Texture* GetTexture() const { return pTexture; }
+	inline const UINT GetTextureID() const { return textureID; }
+	inline void SetSamplerID(UINT slot, UINT id) { samplerIDs[slot] = id; }
+	inline const MaterialConstant GetConstants() const
+	{
+		return { textureID, XMUINT3(samplerIDs[0], samplerIDs[1], samplerIDs[2]) };
+	}
 };
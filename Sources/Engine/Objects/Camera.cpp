@@ -54,6 +54,7 @@ void Camera::UpdateCameraConstant()
 {
     cameraConstant.PreviousWorldToProjectionMatrix = cameraConstant.WorldToProjectionMatrix;
     GetVPMatrix(cameraConstant.WorldToProjectionMatrix, cameraConstant.ProjectionToWorldMatrix);
+    UpdateFrustumPlanes(cameraConstant.WorldToProjectionMatrix);
     XMStoreFloat4(&cameraConstant.CameraWorldPosition, worldPosition);
     cameraConstant.TAAJitter.x = (GetHaltonSequence(((INT)ViewManager::sFrameCount & 511) + 1, 2) - 0.5f) / width;
     cameraConstant.TAAJitter.y = (GetHaltonSequence(((INT)ViewManager::sFrameCount & 511) + 1, 3) - 0.5f) / height;
@@ -74,6 +75,26 @@ void Camera::GetVPMatrix(XMMATRIX& worldToProjectionMatrix, XMMATRIX& projection
     projectionToWorldMatrix = XMMatrixInverse(nullptr, worldToProjectionMatrix);
 }
 
+void Camera::UpdateFrustumPlanes(const XMMATRIX& worldToProjectionMatrix)
+{
+    // Extract the planes from the columns of the matrix, the depth range is [0, 1].
+    XMMATRIX m = XMMatrixTranspose(worldToProjectionMatrix);
+    XMVECTOR planes[6] =
+    {
+        m.r[3] + m.r[0],
+        m.r[3] - m.r[0],
+        m.r[3] + m.r[1],
+        m.r[3] - m.r[1],
+        m.r[2],
+        m.r[3] - m.r[2],
+    };
+
+    for (UINT i = 0; i < 6; i++)
+    {
+        XMStoreFloat4(&frustumPlanes[i], XMPlaneNormalize(planes[i]));
+    }
+}
+
 float Camera::GetHaltonSequence(int index, int base)
 {
     float result = 0.0f;
@@ -20,6 +20,9 @@ private:
 
     CameraConstant cameraConstant;
 
+    // World space planes of the view frustum, pointing inwards.
+    XMFLOAT4 frustumPlanes[6];
+
     FLOAT width;
     FLOAT height;
     FLOAT fov;
@@ -29,6 +32,7 @@ private:
 
     // Helper functions
     float GetHaltonSequence(int index, int base);
+    void UpdateFrustumPlanes(const XMMATRIX& worldToProjectionMatrix);
 
 public:
     Camera(UINT id, FLOAT width, FLOAT height);
@@ -43,7 +47,10 @@ public:
 
     inline const FLOAT GetCameraWidth() const { return width; }
     inline const FLOAT GetCameraHeight() const { return height; }
+    inline const FLOAT GetFov() const { return fov; }
+    inline const FLOAT GetNearZ() const { return nearZ; }
     inline const D3D12_VIEWPORT* GetViewport() const { return pViewport; }
     inline const D3D12_RECT* GetScissorRect() const { return pScissorRect; }
     inline CameraConstant& GetCameraConstant() { return cameraConstant; }
+    inline const XMFLOAT4* GetFrustumPlanes() const { return frustumPlanes; }
 };
@@ -3,14 +3,40 @@
 
 D3D12CommandList::D3D12CommandList(std::shared_ptr<D3D12Device>& inDevice) :
     pDevice(inDevice),
-    barrierIndex(0)
+    segment(0),
+    pCommandAllocator(inDevice->GetCommandAllocator()),
+    graphicsState(),
+    pResourceStateTracker(inDevice->GetResourceStateTracker()),
+    framesNum(0),
+    batchesNum(0)
 {
+    pSegments.emplace_back();
     ThrowIfFailed(pDevice->GetDevice()->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT,
-        pDevice->GetCommandAllocator().Get(),
+        pCommandAllocator.Get(),
         nullptr,
-        IID_PPV_ARGS(&pCommandList)));
+        IID_PPV_ARGS(&pSegments[segment])));
+    BeginSegment();
+}
 
-    ThrowIfFailed(pCommandList->QueryInterface(IID_PPV_ARGS(&pDXRCommandList)));
+D3D12CommandList::D3D12CommandList(
+    std::shared_ptr<D3D12Device>& inDevice,
+    ComPtr<ID3D12CommandAllocator>& commandAllocator) :
+    pDevice(inDevice),
+    segment(0),
+    pCommandAllocator(commandAllocator),
+    graphicsState(),
+    pLocalResourceStateTracker(std::make_unique<ResourceStateTracker>()),
+    framesNum(0),
+    batchesNum(0)
+{
+    pResourceStateTracker = pLocalResourceStateTracker.get();
+
+    pSegments.emplace_back();
+    ThrowIfFailed(pDevice->GetDevice()->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT,
+        pCommandAllocator.Get(),
+        nullptr,
+        IID_PPV_ARGS(&pSegments[segment])));
+    BeginSegment();
 }
 
 D3D12CommandList::~D3D12CommandList()
@@ -18,11 +44,119 @@ D3D12CommandList::~D3D12CommandList()
 
 }
 
-void D3D12CommandList::ExecuteCommandList()
+void D3D12CommandList::Close()
 {
+    // Leave every resource in the state it was last requested in, for the next command list. Split
+    // barriers can not span command lists, so the ones begun in this list end here.
+    pResourceStateTracker->Finish(resourceBarriers);
+    SubmitResourceBarriers();
     ThrowIfFailed(pCommandList->Close());
+}
+
+void D3D12CommandList::ExecuteCommandList()
+{
+    Close();
+    pClosedCommandLists.push_back(pCommandList.Get());
+
+    // Execute the segments and the lists inserted between them.
+    pDevice->GetCommandQueue()->ExecuteCommandLists(
+        static_cast<UINT>(pClosedCommandLists.size()), pClosedCommandLists.data());
+    pClosedCommandLists.clear();
+
+    if (++framesNum >= RESOURCE_BARRIER_LOG_INTERVAL)
+    {
+        ReportResourceBarriers();
+    }
+}
+
+void D3D12CommandList::InsertCommandLists(D3D12CommandList* const* ppCommandLists, UINT commandListsNum)
+{
+    Close();
+    pClosedCommandLists.push_back(pCommandList.Get());
+    for (UINT i = 0; i < commandListsNum; i++)
+    {
+        pClosedCommandLists.push_back(ppCommandLists[i]->GetCommandList().Get());
+    }
+
+    // Only one list of an allocator can be recording at a time, and this segment has been closed.
+    if (++segment == pSegments.size())
+    {
+        pSegments.emplace_back();
+        ThrowIfFailed(pDevice->GetDevice()->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT,
+            pCommandAllocator.Get(),
+            nullptr,
+            IID_PPV_ARGS(&pSegments[segment])));
+    }
+    else
+    {
+        ThrowIfFailed(pSegments[segment]->Reset(pCommandAllocator.Get(), nullptr));
+    }
+    BeginSegment();
+    ApplyGraphicsState();
+}
+
+void D3D12CommandList::InheritGraphicsState(const D3D12CommandList& commandList)
+{
+    graphicsState = commandList.graphicsState;
+    ApplyGraphicsState();
+}
+
+// Helper functions.
+void D3D12CommandList::BeginSegment()
+{
+    pCommandList = pSegments[segment];
+    ThrowIfFailed(pCommandList->QueryInterface(IID_PPV_ARGS(&pDXRCommandList)));
+    pDevice->GetDescriptorHeapManager()->SetDescriptorHeaps(pCommandList);
+}
+
+void D3D12CommandList::ApplyGraphicsState()
+{
+    if (graphicsState.pPipelineState != nullptr)
+    {
+        pCommandList->SetPipelineState(graphicsState.pPipelineState);
+    }
+    if (graphicsState.pRootSignature != nullptr)
+    {
+        pCommandList->SetGraphicsRootSignature(graphicsState.pRootSignature);
+        for (UINT i = 0; i < graphicsState.rootConstantBufferViews.size(); i++)
+        {
+            if (graphicsState.rootConstantBufferViews[i] != 0)
+            {
+                pCommandList->SetGraphicsRootConstantBufferView(i, graphicsState.rootConstantBufferViews[i]);
+            }
+        }
+    }
+    if (graphicsState.viewports.empty() == FALSE)
+    {
+        pCommandList->RSSetViewports(static_cast<UINT>(graphicsState.viewports.size()), graphicsState.viewports.data());
+    }
+    if (graphicsState.scissorRects.empty() == FALSE)
+    {
+        pCommandList->RSSetScissorRects(static_cast<UINT>(graphicsState.scissorRects.size()),
+            graphicsState.scissorRects.data());
+    }
+    if (graphicsState.renderTargetsNum > 0 || graphicsState.depthStencil.ptr != 0)
+    {
+        pCommandList->OMSetRenderTargets(graphicsState.renderTargetsNum, &graphicsState.renderTargets, TRUE,
+            graphicsState.depthStencil.ptr != 0 ? &graphicsState.depthStencil : nullptr);
+    }
+    if (graphicsState.primitiveTopology != D3D_PRIMITIVE_TOPOLOGY_UNDEFINED)
+    {
+        pCommandList->IASetPrimitiveTopology(graphicsState.primitiveTopology);
+    }
+}
+
+void D3D12CommandList::ReportResourceBarriers()
+{
+    // Every transition requested used to be a barrier of its own.
+    WCHAR message[256];
+    swprintf_s(message, L"Resource barriers per frame: %.1f transitions requested, %.1f barriers in %.1f batches.\n",
+        static_cast<double>(pResourceStateTracker->GetRequestsNum()) / framesNum,
+        static_cast<double>(pResourceStateTracker->GetBarriersNum()) / framesNum,
+        static_cast<double>(batchesNum) / framesNum);
+    OutputDebugStringW(message);
 
-    // Execute the command list.
-    ID3D12CommandList* ppCommandLists[] = { pCommandList.Get() };
-    pDevice->GetCommandQueue()->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+    pResourceStateTracker->ResetCounters();
+    framesNum = 0;
+    batchesNum = 0;
 }
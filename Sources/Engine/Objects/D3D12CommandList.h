@@ -1,38 +1,107 @@
 #pragma once
 
-#define MAX_RESOURCE_BARRIER 16
+// Frames between two reports of the resource barriers.
+#define RESOURCE_BARRIER_LOG_INTERVAL 600
 
 class D3D12CommandList
 {
 private:
+    // The graphics state set through this class, which command lists recorded in parallel start with.
+    // Descriptor tables and root constants are not kept, the work that uses them sets its own.
+    struct GraphicsState
+    {
+        ID3D12PipelineState* pPipelineState;
+        ID3D12RootSignature* pRootSignature;
+        // Indexed by root parameter, 0 where none was set.
+        std::vector<D3D12_GPU_VIRTUAL_ADDRESS> rootConstantBufferViews;
+        std::vector<D3D12_VIEWPORT> viewports;
+        std::vector<D3D12_RECT> scissorRects;
+        UINT renderTargetsNum;
+        D3D12_CPU_DESCRIPTOR_HANDLE renderTargets;
+        D3D12_CPU_DESCRIPTOR_HANDLE depthStencil;
+        D3D12_PRIMITIVE_TOPOLOGY primitiveTopology;
+    };
+
     ComPtr<ID3D12GraphicsCommandList> pCommandList;
     ComPtr<ID3D12GraphicsCommandList4> pDXRCommandList;
     std::shared_ptr<D3D12Device> pDevice;
 
-    D3D12_RESOURCE_BARRIER resourceBarriers[MAX_RESOURCE_BARRIER];
-    UINT barrierIndex;
+    // Command lists recorded in parallel are submitted between segments of this one. The segments are
+    // recorded one after another from the same allocator, and submitted with the inserted lists in order.
+    std::vector<ComPtr<ID3D12GraphicsCommandList>> pSegments;
+    UINT segment;
+    ComPtr<ID3D12CommandAllocator> pCommandAllocator;
+    std::vector<ID3D12CommandList*> pClosedCommandLists;
+    GraphicsState graphicsState;
+
+    // Barriers are batched until the work that needs them is recorded, and the states they transition
+    // resources between come from the state tracker of the device. A list recorded on another thread has
+    // an empty tracker of its own, as the resources it uses are already in the states it needs.
+    ResourceStateTracker* pResourceStateTracker;
+    std::unique_ptr<ResourceStateTracker> pLocalResourceStateTracker;
+    std::vector<D3D12_RESOURCE_BARRIER> resourceBarriers;
+
+    // Barrier metrics since the last report.
+    UINT framesNum;
+    UINT64 batchesNum;
+
+    inline void SubmitResourceBarriers()
+    {
+        if (resourceBarriers.empty())
+        {
+            return;
+        }
+
+        pCommandList->ResourceBarrier(static_cast<UINT>(resourceBarriers.size()), resourceBarriers.data());
+        resourceBarriers.clear();
+        batchesNum++;
+    }
+
+    void BeginSegment();
+    void ApplyGraphicsState();
+    void ReportResourceBarriers();
 
 public:
     D3D12CommandList(std::shared_ptr<D3D12Device>&);
+    // A command list recorded on another thread, from an allocator of its own. It requests no transitions,
+    // and is inserted into a list of the device that has its resources in the states it needs.
+    D3D12CommandList(std::shared_ptr<D3D12Device>&, ComPtr<ID3D12CommandAllocator>& commandAllocator);
     ~D3D12CommandList();
 
+    // Close the list, which leaves every resource in the state it was last requested in.
+    void Close();
+    // Close the list and submit it, with the lists inserted into it, in one batch.
     void ExecuteCommandList();
+    // Submit closed lists after the work recorded so far, and go on recording after them in the same
+    // graphics state.
+    void InsertCommandLists(D3D12CommandList* const* ppCommandLists, UINT commandListsNum);
+    // Set the graphics state of another list, to go on with its work.
+    void InheritGraphicsState(const D3D12CommandList& commandList);
 
     inline ComPtr<ID3D12GraphicsCommandList>& GetCommandList() { return pCommandList; }
     inline ComPtr<ID3D12GraphicsCommandList4>& GetDXRCommandList() { return pDXRCommandList; }
 
     inline void Reset(ComPtr<ID3D12CommandAllocator>& commandAllocator)
     {
-        ThrowIfFailed(pCommandList->Reset(commandAllocator.Get(), nullptr));
+        pCommandAllocator = commandAllocator;
+        pClosedCommandLists.clear();
+        graphicsState = GraphicsState();
+        segment = 0;
+        ThrowIfFailed(pSegments[segment]->Reset(pCommandAllocator.Get(), nullptr));
+        BeginSegment();
     }
 
     inline void SetPipelineState(ID3D12PipelineState* pipelineState)
     {
+        graphicsState.pPipelineState = pipelineState;
         pCommandList->SetPipelineState(pipelineState);
     }
 
     inline void SetRootSignature(ComPtr<ID3D12RootSignature>& rootSignature)
     {
+        // Changing the root signature drops what was bound with the old one.
+        graphicsState.pRootSignature = rootSignature.Get();
+        graphicsState.rootConstantBufferViews.clear();
         pCommandList->SetGraphicsRootSignature(rootSignature.Get());
     }
 
@@ -43,9 +112,19 @@ public:
 
     inline void SetRootConstantBufferView(UINT index, D3D12_GPU_VIRTUAL_ADDRESS location)
     {
+        if (index >= graphicsState.rootConstantBufferViews.size())
+        {
+            graphicsState.rootConstantBufferViews.resize(index + 1, 0);
+        }
+        graphicsState.rootConstantBufferViews[index] = location;
         pCommandList->SetGraphicsRootConstantBufferView(index, location);
     }
 
+    inline void SetRoot32BitConstant(UINT index, UINT num, const void* pSrcData, UINT offset = 0)
+    {
+        pCommandList->SetGraphicsRoot32BitConstants(index, num, pSrcData, offset);
+    }
+
     inline void SetComputeRoot32BitConstant(UINT index, UINT num, const void* pSrcData, UINT offset = 0)
     {
         pCommandList->SetComputeRoot32BitConstants(index, num, pSrcData, offset);
@@ -68,11 +147,13 @@ public:
 
     inline void SetViewports(const D3D12_VIEWPORT* pViewports, UINT NumViewports = 1)
     {
+        graphicsState.viewports.assign(pViewports, pViewports + NumViewports);
         pCommandList->RSSetViewports(NumViewports, pViewports);
     }
 
     inline void SetScissorRects(const D3D12_RECT* pViewports, UINT NumViewports = 1)
     {
+        graphicsState.scissorRects.assign(pViewports, pViewports + NumViewports);
         pCommandList->RSSetScissorRects(NumViewports, pViewports);
     }
 
@@ -80,21 +161,28 @@ public:
         const D3D12_CPU_DESCRIPTOR_HANDLE* pRenderTargetDescriptors,
         const D3D12_CPU_DESCRIPTOR_HANDLE* pDepthStencilDescriptor)
     {
+        // The render targets are a range of descriptors from the first one.
+        graphicsState.renderTargetsNum = NumRenderTargetDescriptors;
+        graphicsState.renderTargets.ptr = NumRenderTargetDescriptors > 0 ? pRenderTargetDescriptors->ptr : 0;
+        graphicsState.depthStencil.ptr = pDepthStencilDescriptor != nullptr ? pDepthStencilDescriptor->ptr : 0;
         pCommandList->OMSetRenderTargets(NumRenderTargetDescriptors, pRenderTargetDescriptors, TRUE, pDepthStencilDescriptor);
     }
 
     inline void ClearColor(D3D12_CPU_DESCRIPTOR_HANDLE RenderTargetView, const FLOAT ColorRGBA[4])
     {
+        FlushResourceBarriers();
         pCommandList->ClearRenderTargetView(RenderTargetView, ColorRGBA, 0, nullptr);
     }
 
     inline void ClearDepth(D3D12_CPU_DESCRIPTOR_HANDLE DepthStencilView)
     {
+        FlushResourceBarriers();
         pCommandList->ClearDepthStencilView(DepthStencilView, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
     }
 
     inline void SetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY PrimitiveTopology)
     {
+        graphicsState.primitiveTopology = PrimitiveTopology;
         pCommandList->IASetPrimitiveTopology(PrimitiveTopology);
     }
 
@@ -110,50 +198,126 @@ public:
 
     inline void DrawIndexedInstanced(UINT IndexCountPerInstance)
     {
+        FlushResourceBarriers();
         pCommandList->DrawIndexedInstanced(IndexCountPerInstance, 1, 0, 0, 0);
     }
 
+    inline void DrawIndexedInstanced(UINT IndexCountPerInstance, UINT StartIndexLocation)
+    {
+        FlushResourceBarriers();
+        pCommandList->DrawIndexedInstanced(IndexCountPerInstance, 1, StartIndexLocation, 0, 0);
+    }
+
     inline void DispatchThreads(UINT ThreadGroupCountX, UINT ThreadGroupCountY, UINT ThreadGroupCountZ)
     {
+        FlushResourceBarriers();
         pCommandList->Dispatch(ThreadGroupCountX, ThreadGroupCountY, ThreadGroupCountZ);
     }
 
+    inline void DispatchRays(ID3D12StateObject* pStateObject, const D3D12_DISPATCH_RAYS_DESC* pDesc)
+    {
+        FlushResourceBarriers();
+        pDXRCommandList->SetPipelineState1(pStateObject);
+        pDXRCommandList->DispatchRays(pDesc);
+    }
+
+    inline void BuildRaytracingAccelerationStructure(const D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC* pDesc)
+    {
+        FlushResourceBarriers();
+        pDXRCommandList->BuildRaytracingAccelerationStructure(pDesc, 0, nullptr);
+    }
+
     inline void CopyBufferRegion(ID3D12Resource* pDstBuffer, ID3D12Resource* pSrcBuffer,
         UINT64 NumBytes, UINT64 DstOffset = 0, UINT64 SrcOffset = 0)
     {
+        ID3D12Resource* pResources[] = { pDstBuffer, pSrcBuffer };
+        FlushResourceBarriers(pResources, _countof(pResources));
         pCommandList->CopyBufferRegion(pDstBuffer, DstOffset, pSrcBuffer, SrcOffset, NumBytes);
     }
 
     inline void CopyTextureBuffer(ID3D12Resource* pDestinationResource, ID3D12Resource* pIntermediate,
         UINT64 IntermediateOffset, UINT FirstSubresource, UINT NumSubresources, const D3D12_SUBRESOURCE_DATA* pSrcData)
     {
+        ID3D12Resource* pResources[] = { pDestinationResource, pIntermediate };
+        FlushResourceBarriers(pResources, _countof(pResources));
         UpdateSubresources(pCommandList.Get(), pDestinationResource, pIntermediate,
             IntermediateOffset, FirstSubresource, NumSubresources, pSrcData);
     }
 
     inline void CopyResource(ID3D12Resource* pDstResource, ID3D12Resource* pSrcResource)
     {
+        ID3D12Resource* pResources[] = { pDstResource, pSrcResource };
+        FlushResourceBarriers(pResources, _countof(pResources));
         pCommandList->CopyResource(pDstResource, pSrcResource);
     }
 
     inline void CopyTexture(D3D12_TEXTURE_COPY_LOCATION* pDstResource, D3D12_TEXTURE_COPY_LOCATION* pSrcResource)
     {
+        ID3D12Resource* pResources[] = { pDstResource->pResource, pSrcResource->pResource };
+        FlushResourceBarriers(pResources, _countof(pResources));
         pCommandList->CopyTextureRegion(pDstResource, 0, 0, 0, pSrcResource, nullptr);
     }
 
-    inline void AddTransitionResourceBarriers(ID3D12Resource* pResource,
-        D3D12_RESOURCE_STATES stateBefore, D3D12_RESOURCE_STATES stateAfter)
+    // A timestamp is written once the work recorded before it, barriers included, is done.
+    inline void EndQuery(ID3D12QueryHeap* pQueryHeap, D3D12_QUERY_TYPE Type, UINT Index)
     {
-        resourceBarriers[barrierIndex].Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-        resourceBarriers[barrierIndex].Transition.pResource = pResource;
-        resourceBarriers[barrierIndex].Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
-        resourceBarriers[barrierIndex].Transition.StateBefore = stateBefore;
-        resourceBarriers[barrierIndex++].Transition.StateAfter = stateAfter;
+        FlushResourceBarriers();
+        pCommandList->EndQuery(pQueryHeap, Type, Index);
     }
 
+    // The destination is a readback buffer, which stays in the copy destination state.
+    inline void ResolveQueryData(ID3D12QueryHeap* pQueryHeap, D3D12_QUERY_TYPE Type, UINT StartIndex,
+        UINT NumQueries, ID3D12Resource* pDestinationBuffer, UINT64 AlignedDestinationBufferOffset)
+    {
+        pCommandList->ResolveQueryData(pQueryHeap, Type, StartIndex, NumQueries,
+            pDestinationBuffer, AlignedDestinationBufferOffset);
+    }
+
+    // Request a resource, or one of its subresources, in a state for the next work recorded.
+    inline void TransitionResource(ID3D12Resource* pResource, D3D12_RESOURCE_STATES state,
+        UINT subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES)
+    {
+        ThrowIfFalse(pResourceStateTracker->Transition(pResource, state, subresource));
+    }
+
+    // Request a resource in a state it is not used in until it is requested again, which splits the barrier
+    // and leaves the GPU the work in between to do the transition.
+    inline void BeginTransitionResource(ID3D12Resource* pResource, D3D12_RESOURCE_STATES state)
+    {
+        ThrowIfFalse(pResourceStateTracker->BeginTransition(pResource, state));
+    }
+
+    inline void AddUAVBarrier(ID3D12Resource* pResource)
+    {
+        resourceBarriers.push_back(CD3DX12_RESOURCE_BARRIER::UAV(pResource));
+    }
+
+    // A resource aliased with others takes over their memory. It is recorded before the transitions
+    // requested for the same work.
+    inline void AddAliasingBarrier(ID3D12Resource* pResource)
+    {
+        resourceBarriers.push_back(CD3DX12_RESOURCE_BARRIER::Aliasing(nullptr, pResource));
+    }
+
+    // Tell the GPU the content of a resource is not needed, which is how an aliased render target that is
+    // not cleared first is initialized.
+    inline void DiscardResource(ID3D12Resource* pResource)
+    {
+        FlushResourceBarriers(&pResource, 1);
+        pCommandList->DiscardResource(pResource, nullptr);
+    }
+
+    // Record the barriers requested so far. The work recorded through this class flushes them itself.
     inline void FlushResourceBarriers()
     {
-        pCommandList->ResourceBarrier(barrierIndex, &resourceBarriers[0]);
-        barrierIndex = 0;
+        pResourceStateTracker->Flush(resourceBarriers);
+        SubmitResourceBarriers();
+    }
+
+    // Record the barriers requested for the resources of a copy, the others wait for the work that needs them.
+    inline void FlushResourceBarriers(ID3D12Resource* const* ppResources, UINT resourcesNum)
+    {
+        pResourceStateTracker->Flush(resourceBarriers, ppResources, resourcesNum);
+        SubmitResourceBarriers();
     }
 };
@@ -1,21 +1,15 @@
 #pragma once
+#include "MeshData.h"
 #include "D3D12VertexBuffer.h"
 #include "D3D12IndexBuffer.h"
 #include "D3D12ShaderResourceBuffer.h"
 
 using namespace DirectX;
 
-class D3D12Mesh
+// The GPU buffers of a mesh, sized by its data when they are created.
+class D3D12Mesh : public MeshData
 {
 private:
-	XMVECTOR position;
-    Vertex* pVertices;
-    UINT16* pIndices;
-    UINT verticesSize;
-    UINT verticesNum;
-    UINT indicesSize;
-    UINT indicesNum;
-
     D3D12VertexBuffer* pVertexBuffer;
     D3D12IndexBuffer* pIndexBuffer;
 
@@ -23,19 +17,12 @@ public:
     D3D12Mesh();
     ~D3D12Mesh();
 
-    void SetVertices(Vertex* triangleVertices, UINT size);
-    void SetIndices(UINT16* triangleIndices, UINT size);
-    void CopyVertices(void* destination);
-    void CopyIndices(void* destination);
+    // Create the buffers for the current data, before they are allocated and filled.
+    void CreateBuffers();
     void CreateView();
 
-    inline const UINT GetVerticesSize() const { return verticesSize; }
-    inline const UINT GetVerticesNum() const { return verticesNum; }
-    inline const UINT GetIndicesSize() const { return indicesSize; }
-    inline const UINT GetIndicesNum() const { return indicesNum; }
-    inline const void* GetVerticesData() const { return pVertices; }
-    inline const void* GetIndicesData() const { return pIndices; }
+    inline const DXGI_FORMAT GetIndexFormat() const { return GetIndexStride() == sizeof(UINT) ? DXGI_FORMAT_R32_UINT : DXGI_FORMAT_R16_UINT; }
 
     inline D3D12VertexBuffer* GetVertexBuffer() const { return pVertexBuffer; }
     inline D3D12IndexBuffer* GetIndexBuffer() const { return pIndexBuffer; }
-};
\ No newline at end of file
+};
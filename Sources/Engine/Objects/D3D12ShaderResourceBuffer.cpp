@@ -14,8 +14,22 @@ D3D12ShaderResourceBuffer::~D3D12ShaderResourceBuffer()
 
 }
 
+void D3D12ShaderResourceBuffer::SetMinLODClamp(FLOAT clamp)
+{
+    if (viewDesc.ViewDimension == D3D12_SRV_DIMENSION_TEXTURECUBE)
+    {
+        viewDesc.TextureCube.ResourceMinLODClamp = clamp;
+    }
+    else
+    {
+        viewDesc.Texture2D.ResourceMinLODClamp = clamp;
+    }
+}
+
 void D3D12ShaderResourceBuffer::CreateView(const ComPtr<ID3D12Device>& device, const D3D12_CPU_DESCRIPTOR_HANDLE& handle)
 {
+    // A texture can be viewed from several descriptors, such as a placeholder bound to the slots of many materials.
+    delete view;
     view = new D3D12SRV(viewDesc);
     view->SetResource(resourceLocation.Resource.Get());
     view->CreateView(device, handle);
@@ -8,6 +8,8 @@ public:
 	D3D12ShaderResourceBuffer(const D3D12_RESOURCE_DESC&, const D3D12_SHADER_RESOURCE_VIEW_DESC&);
 	~D3D12ShaderResourceBuffer();
 
+	// Keep the views created from now on off the mips finer than clamp.
+	void SetMinLODClamp(FLOAT clamp);
 	virtual void CreateView(const ComPtr<ID3D12Device>& device, const D3D12_CPU_DESCRIPTOR_HANDLE& handle) override;
 };
 
@@ -1,5 +1,6 @@
 #include "stdafx.h"
 #include "D3D12Texture.h"
+#include "MeshCache.h"
 
 D3D12Texture::D3D12Texture(UINT inSRVID) :
     D3D12Texture(inSRVID, -1, 0, 0, D3D12TextureType::ShaderResource)
@@ -21,7 +22,11 @@ D3D12Texture::D3D12Texture(
     mipLevel(1),
     slice(1),
     srvDimension(D3D12_SRV_DIMENSION_TEXTURE2D),
-    dxgiFormat(format)
+    dxgiFormat(format),
+    dataSize(0),
+    residentMip(0),
+    isStreamed(FALSE),
+    pStagingBuffer(nullptr)
 {
     pTextureBuffer = nullptr;
     switch (inType)
@@ -36,51 +41,35 @@ D3D12Texture::D3D12Texture(
         uavHandle = inIndex;
         break;
     }
-
-    // Init the loader factory.
-    CoInitialize(NULL);
-    ThrowIfFailed(CoCreateInstance(
-        CLSID_WICImagingFactory,
-        NULL,
-        CLSCTX_INPROC_SERVER,
-        IID_PPV_ARGS(&pFactory)
-    ));
 }
 
 D3D12Texture::~D3D12Texture()
 {
-    ReleaseTextureData();
+    FreeTextureData();
     ReleaseTextureBuffer();
 }
 
-void D3D12Texture::LoadTexture(std::wstring& texturePath, UINT inMipLevel,
+void D3D12Texture::LoadTexture(ID3D12Device* pDevice, std::wstring& texturePath,
     D3D12_SRV_DIMENSION inSRVDimension, UINT inSlice)
 {
-    mipLevel = inMipLevel;
     srvDimension = inSRVDimension;
     slice = inSlice;
 
     if (srvDimension == D3D12_SRV_DIMENSION_TEXTURECUBE)
     {
-        mipLevel = 1;
         slice = 6;
 
-        std::wstring path = texturePath;
-        LoadSingleTexture(path.insert(texturePath.length(), kCubemapPX), 0);
-        path = texturePath;
-        LoadSingleTexture(path.insert(texturePath.length(), kCubemapNX), 1);
-        path = texturePath;
-        LoadSingleTexture(path.insert(texturePath.length(), kCubemapPY), 2);
-        path = texturePath;
-        LoadSingleTexture(path.insert(texturePath.length(), kCubemapNY), 3);
-        path = texturePath;
-        LoadSingleTexture(path.insert(texturePath.length(), kCubemapPZ), 4);
-        path = texturePath;
-        LoadSingleTexture(path.insert(texturePath.length(), kCubemapNZ), 5);
+        const std::wstring faceSuffixes[6] = { kCubemapPX, kCubemapNX, kCubemapPY, kCubemapNY, kCubemapPZ, kCubemapNZ };
+        std::vector<std::wstring> facePaths(slice);
+        for (UINT i = 0; i < slice; i++)
+        {
+            facePaths[i] = texturePath + faceSuffixes[i];
+        }
+        LoadImages(pDevice, facePaths, MipFilterMode::Color);
     }
     else
     {
-        LoadSingleTexture(texturePath, 0);
+        LoadCookedTexture(pDevice, texturePath);
     }
 }
 
@@ -103,7 +92,7 @@ void D3D12Texture::CreateTextureResource()
         desc.Format = dxgiFormat;
         desc.Flags = D3D12_RESOURCE_FLAG_NONE;
 
-        D3D12_SHADER_RESOURCE_VIEW_DESC viewDesc;
+        D3D12_SHADER_RESOURCE_VIEW_DESC viewDesc = {};
         viewDesc.Format = dxgiFormat == DXGI_FORMAT_R32_TYPELESS ? DXGI_FORMAT_R32_FLOAT : dxgiFormat;
         viewDesc.ViewDimension = srvDimension;
         viewDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
@@ -113,13 +102,13 @@ void D3D12Texture::CreateTextureResource()
             viewDesc.Texture2D.MostDetailedMip = 0;
             viewDesc.Texture2D.MipLevels = mipLevel;
             viewDesc.Texture2D.PlaneSlice = 0;
-            viewDesc.TextureCube.ResourceMinLODClamp = 0.0f;
+            viewDesc.Texture2D.ResourceMinLODClamp = static_cast<FLOAT>(residentMip);
         }
         else if (srvDimension == D3D12_SRV_DIMENSION_TEXTURECUBE)
         {
             viewDesc.TextureCube.MostDetailedMip = 0;
             viewDesc.TextureCube.MipLevels = mipLevel;
-            viewDesc.TextureCube.ResourceMinLODClamp = 0.0f;
+            viewDesc.TextureCube.ResourceMinLODClamp = static_cast<FLOAT>(residentMip);
         }
 
         pTextureBuffer = new D3D12ShaderResourceBuffer(desc, viewDesc);
@@ -134,7 +123,7 @@ void D3D12Texture::CreateTextureResource()
         desc.SampleDesc.Count = 1;
         desc.SampleDesc.Quality = 0;
 
-        D3D12_RENDER_TARGET_VIEW_DESC viewDesc;
+        D3D12_RENDER_TARGET_VIEW_DESC viewDesc = {};
         viewDesc.Format = dxgiFormat;
         viewDesc.ViewDimension = D3D12_RTV_DIMENSION_TEXTURE2D;
         viewDesc.Texture2D.MipSlice = 0;
@@ -152,7 +141,7 @@ void D3D12Texture::CreateTextureResource()
         desc.SampleDesc.Count = 1;
         desc.SampleDesc.Quality = 0;
 
-        D3D12_DEPTH_STENCIL_VIEW_DESC viewDesc;
+        D3D12_DEPTH_STENCIL_VIEW_DESC viewDesc = {};
         viewDesc.Format = DXGI_FORMAT_D32_FLOAT;
         viewDesc.ViewDimension = D3D12_DSV_DIMENSION_TEXTURE2D;
         viewDesc.Flags = D3D12_DSV_FLAG_NONE;
@@ -170,7 +159,7 @@ void D3D12Texture::CreateTextureResource()
         desc.SampleDesc.Count = 1;
         desc.SampleDesc.Quality = 0;
 
-        D3D12_UNORDERED_ACCESS_VIEW_DESC viewDesc;
+        D3D12_UNORDERED_ACCESS_VIEW_DESC viewDesc = {};
         viewDesc.Format = dxgiFormat;
         viewDesc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
         viewDesc.Texture2D.MipSlice = 0;
@@ -194,13 +183,26 @@ void D3D12Texture::ChangeTextureType(D3D12TextureType newType)
     }
 }
 
+void D3D12Texture::SetResidentMip(UINT mip)
+{
+    residentMip = mip;
+    if (type == D3D12TextureType::ShaderResource && pTextureBuffer != nullptr)
+    {
+        static_cast<D3D12ShaderResourceBuffer*>(pTextureBuffer)->SetMinLODClamp(static_cast<FLOAT>(mip));
+    }
+}
+
+void D3D12Texture::SetStreamed(BOOL streamed)
+{
+    isStreamed = streamed;
+}
+
 void D3D12Texture::ReleaseTextureData()
 {
-    for (auto it = pData.begin(); it != pData.end(); it++)
+    if (!isStreamed)
     {
-        delete it->second;
+        FreeTextureData();
     }
-    pData.clear();
 }
 
 void D3D12Texture::ReleaseTextureBuffer()
@@ -215,6 +217,8 @@ void D3D12Texture::CreateSampler()
         TextureSampler = std::make_unique<D3D12Sampler>();
     }
 
+    // Clear the fields that are not set below, so that equal samplers share one descriptor.
+    TextureSampler->SamplerDesc = {};
     TextureSampler->SamplerDesc.Filter = D3D12_FILTER_ANISOTROPIC;
     TextureSampler->SamplerDesc.AddressU = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
     TextureSampler->SamplerDesc.AddressV = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
@@ -227,77 +231,176 @@ void D3D12Texture::CreateSampler()
 }
 
 // Helper functions
-void D3D12Texture::LoadSingleTexture(std::wstring& texturePath, UINT index)
+BOOL D3D12Texture::MapImage(const std::wstring& imagePath, EncodedImage& image)
 {
-    UINT mipWidth = 0, mipHeight = 0, bytesPerRow = 0, indexOffset = index * mipLevel;
-    UINT64 size = 0;
-    for (int i = 0; i < mipLevel; i++)
+    image = {};
+    image.file = CreateFileW(imagePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (image.file == INVALID_HANDLE_VALUE)
     {
-        if (INVALID_FILE_ATTRIBUTES == GetFileAttributes(GetTexturePath(texturePath, i).c_str())
-            && GetLastError() == ERROR_FILE_NOT_FOUND)
-        {
-            ThrowIfFailed(pFactory->CreateDecoderFromFilename(GetDefaultMipTexturePath(texturePath, mipWidth).c_str(),
-                NULL, GENERIC_READ, WICDecodeMetadataCacheOnLoad, &pDecoder));
-        }
-        else
-        {
-            ThrowIfFailed(pFactory->CreateDecoderFromFilename(GetTexturePath(texturePath, i).c_str(),
-                NULL, GENERIC_READ, WICDecodeMetadataCacheOnLoad, &pDecoder));
-        }
-
-        ThrowIfFailed(pDecoder->GetFrame(0, &pFrameDecode));
-        ThrowIfFailed(pFrameDecode->GetSize(&mipWidth, &mipHeight));
-        if (i == 0)
-        {
-            width = mipWidth;
-            height = mipHeight;
-        }
+        image.file = nullptr;
+        return FALSE;
+    }
 
-        WICPixelFormatGUID pixelFormat;
-        ThrowIfFailed(pFrameDecode->GetPixelFormat(&pixelFormat));
-        WICPixelFormatGUID convertToPixelFormat = GUID_WICPixelFormat32bppRGBA;
-        ThrowIfFailed(pFactory->CreateFormatConverter(&pConverter));
+    LARGE_INTEGER fileSize = {};
+    GetFileSizeEx(image.file, &fileSize);
+    image.size = fileSize.QuadPart;
+    image.mapping = image.size > 0 ? CreateFileMappingW(image.file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+    image.pData = image.mapping != nullptr
+        ? static_cast<const BYTE*>(MapViewOfFile(image.mapping, FILE_MAP_READ, 0, 0, 0))
+        : nullptr;
+    image.pDecoder = image.pData != nullptr ? ImageDecoder::GetDecoder(image.pData, image.size) : nullptr;
 
-        BOOL canConvert = FALSE;
-        ThrowIfFailed(pConverter->CanConvert(pixelFormat, convertToPixelFormat, &canConvert));
-        ThrowIfFailed(pConverter->Initialize(pFrameDecode, convertToPixelFormat, WICBitmapDitherTypeErrorDiffusion, 0, 0, WICBitmapPaletteTypeCustom));
+    return image.pDecoder != nullptr && image.pDecoder->ReadInfo(image.pData, image.size, image.info);
+}
 
-        bytesPerRow = (mipWidth * 32) / 8;
-        size = bytesPerRow * mipHeight;
+void D3D12Texture::UnmapImage(EncodedImage& image)
+{
+    if (image.pData != nullptr)
+    {
+        UnmapViewOfFile(image.pData);
+    }
+    if (image.mapping != nullptr)
+    {
+        CloseHandle(image.mapping);
+    }
+    if (image.file != nullptr)
+    {
+        CloseHandle(image.file);
+    }
+    image = {};
+}
 
-        BYTE* bytes = new BYTE();
-        bytes = (BYTE*)malloc(size);
+BOOL D3D12Texture::DecodeToStagingBuffer(ID3D12Device* pDevice, const std::vector<EncodedImage>& images, MipFilterMode mode)
+{
+    width = images[0].info.width;
+    height = images[0].info.height;
+    mipLevel = MipGenerator::GetMipLevelsNum(width, height);
+
+    // The rows of every subresource are aligned like the GPU copies them, so the base levels are
+    // decoded and the mips filtered where the copy reads them.
+    const UINT subresourceNum = GetSubresourceNum();
+    D3D12_RESOURCE_DESC desc = CD3DX12_RESOURCE_DESC::Tex2D(dxgiFormat, width, height,
+        static_cast<UINT16>(slice), static_cast<UINT16>(mipLevel));
+    footprints.resize(subresourceNum);
+    pDevice->GetCopyableFootprints(&desc, 0, subresourceNum, 0, footprints.data(), nullptr, nullptr, &dataSize);
+
+    pStagingBuffer = new D3D12UploadBuffer();
+    pStagingBuffer->CreateStagingBuffer(pDevice, dataSize, L"TextureStagingBuffer");
+    BYTE* pStaging = static_cast<BYTE*>(pStagingBuffer->GetStartLocation());
+
+    std::vector<ImageDecodeJob> jobs(slice);
+    for (UINT i = 0; i < slice; i++)
+    {
+        const D3D12_PLACED_SUBRESOURCE_FOOTPRINT& footprint = footprints[i * mipLevel];
+        jobs[i] = { images[i].pData, images[i].size, pStaging + footprint.Offset, footprint.Footprint.RowPitch };
+    }
+    if (!ImageDecoder::DecodeAll(jobs.data(), slice))
+    {
+        return FALSE;
+    }
 
-        ThrowIfFailed(pConverter->CopyPixels(0, bytesPerRow, size, bytes));
+    std::vector<BYTE*> pLevels(subresourceNum);
+    for (UINT i = 0; i < subresourceNum; i++)
+    {
+        pLevels[i] = pStaging + footprints[i].Offset;
+    }
+    std::vector<UINT64> rowPitches(mipLevel);
+    for (UINT i = 0; i < mipLevel; i++)
+    {
+        rowPitches[i] = footprints[i].Footprint.RowPitch;
+    }
+    MipGenerator::Generate(pLevels.data(), slice, mipLevel, width, height, mode, rowPitches.data());
 
-        mipWidth /= 2;
-        mipHeight /= 2;
-        pData[i + indexOffset] = bytes;
+    return TRUE;
+}
 
-        if (mipWidth == 0) break;
+void D3D12Texture::LoadImages(ID3D12Device* pDevice, const std::vector<std::wstring>& imagePaths, MipFilterMode mode)
+{
+    std::vector<EncodedImage> images(imagePaths.size());
+    BOOL isValid = TRUE;
+    for (UINT i = 0; i < images.size() && isValid; i++)
+    {
+        // The slices of a texture share its size.
+        isValid = MapImage(imagePaths[i], images[i])
+            && images[i].info.width == images[0].info.width && images[i].info.height == images[0].info.height;
+    }
+    if (isValid)
+    {
+        isValid = DecodeToStagingBuffer(pDevice, images, mode);
     }
 
-    pFactory->Release();
+    for (EncodedImage& image : images)
+    {
+        UnmapImage(image);
+    }
+    if (!isValid)
+    {
+        throw std::exception();
+    }
 }
 
-std::wstring D3D12Texture::GetTexturePath(std::wstring texturePath, UINT mipIndex)
+void D3D12Texture::FreeTextureData()
 {
-    if (mipIndex != 0)
+    delete pStagingBuffer;
+    pStagingBuffer = nullptr;
+    footprints.clear();
+
+    if (cookedTexture.pView != nullptr)
     {
-        std::wstring suffix = kMipSuffix;
-        suffix.append(std::to_wstring(mipIndex));
-        texturePath.insert(texturePath.find_last_of(L'.'), suffix);
+        pData.clear();
+        TextureCooker::Unmap(cookedTexture);
     }
-
-    return texturePath;
 }
 
-std::wstring D3D12Texture::GetDefaultMipTexturePath(std::wstring texturePath, UINT mipSize)
+void D3D12Texture::LoadCookedTexture(ID3D12Device* pDevice, std::wstring& texturePath)
 {
-    std::wstring path = texturePath.find(L"_mra") == texturePath.size() - 8 ? kDefaultMRATexturePath :
-        texturePath.find(L"_n") == texturePath.size() - 6 ? kDefaultNormalTexturePath :
-        kDefaultTexturePath;
-    path.insert(path.find_last_of(L'.'), std::to_wstring(mipSize));
+    std::wstring cachePath = TextureCooker::GetCachePath(texturePath);
+    UINT64 sourceStamp = MeshCache::GetSourceTimestamp(texturePath);
+
+    if (!TextureCooker::Map(cachePath, sourceStamp, cookedTexture))
+    {
+        // Cook the texture on its first load. Sizes that can not be block compressed stay
+        // uncompressed, and are decoded straight into the staging buffer instead.
+        std::vector<EncodedImage> images(1);
+        TextureBlockFormat format = TextureCooker::GetBlockFormat(texturePath);
+        BOOL isValid = MapImage(texturePath, images[0]);
+        BOOL isCooked = FALSE;
+        if (isValid && TextureCooker::CanCook(images[0].info.width, images[0].info.height))
+        {
+            const ImageInfo& info = images[0].info;
+            std::vector<BYTE> pixels(MipGenerator::GetLevelSize(info.width, info.height, 0));
+            isValid = images[0].pDecoder->Decode(images[0].pData, images[0].size, pixels.data(), info.width * 4ull);
+            isCooked = isValid && TextureCooker::Cook(cachePath, sourceStamp, pixels.data(), info.width, info.height, format);
+        }
+        if (isValid && !isCooked)
+        {
+            isValid = DecodeToStagingBuffer(pDevice, images, TextureCooker::GetMipFilterMode(format));
+        }
+        UnmapImage(images[0]);
+
+        if (!isValid || (isCooked && !TextureCooker::Map(cachePath, sourceStamp, cookedTexture)))
+        {
+            throw std::exception();
+        }
+        if (!isCooked)
+        {
+            return;
+        }
+    }
+
+    width = cookedTexture.width;
+    height = cookedTexture.height;
+    mipLevel = static_cast<UINT>(cookedTexture.levels.size());
+    dxgiFormat = static_cast<DXGI_FORMAT>(cookedTexture.dxgiFormat);
+    dataSize = cookedTexture.file->GetSize() - sizeof(UINT) - sizeof(DDSHeader) - sizeof(DDSHeaderDXT10);
+    for (UINT i = 0; i < mipLevel; i++)
+    {
+        pData[i] = cookedTexture.levels[i];
+    }
 
-    return path;
+    WCHAR message[256];
+    swprintf_s(message, L"Cooked texture %ls: %ux%u, %u mips, %llu KB.\n",
+        cachePath.c_str(), width, height, mipLevel, dataSize / 1024);
+    OutputDebugStringW(message);
 }
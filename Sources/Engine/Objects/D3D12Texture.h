@@ -1,5 +1,7 @@
 #pragma once
 #include "D3D12ShaderResourceBuffer.h"
+#include "TextureCooker.h"
+#include "ImageDecoder.h"
 
 enum class D3D12TextureType
 {
@@ -9,6 +11,17 @@ enum class D3D12TextureType
 	UnorderedAccess = 3,
 };
 
+// An encoded image file mapped into memory, and the decoder of its format.
+struct EncodedImage
+{
+	HANDLE file;
+	HANDLE mapping;
+	const BYTE* pData;
+	UINT64 size;
+	const ImageDecoder* pDecoder;
+	ImageInfo info;
+};
+
 class D3D12Texture
 {
 private:
@@ -26,11 +39,13 @@ private:
 	D3D12_SRV_DIMENSION srvDimension;
 	DXGI_FORMAT dxgiFormat;
 	D3D12TextureType type;
+	// Bytes of all the subresources, as they are uploaded.
+	UINT64 dataSize;
+	// The finest mip the views can sample, the ones above it are not resident.
+	UINT residentMip;
+	// A streamed texture keeps its mapped file, to upload the mips it streams in again later.
+	BOOL isStreamed;
 
-	const std::wstring kMipSuffix = L"_mip";
-	const std::wstring kDefaultTexturePath = L"..\\Assets\\default_mip.png";
-	const std::wstring kDefaultMRATexturePath = L"..\\Assets\\default_mra_mip.png";
-	const std::wstring kDefaultNormalTexturePath = L"..\\Assets\\default_n_mip.png";
 	const std::wstring kCubemapPX = L"_px.png";
 	const std::wstring kCubemapNX = L"_nx.png";
 	const std::wstring kCubemapPY = L"_py.png";
@@ -38,18 +53,24 @@ private:
 	const std::wstring kCubemapPZ = L"_pz.png";
 	const std::wstring kCubemapNZ = L"_nz.png";
 
-	std::map<UINT, BYTE*> pData;
+	std::map<UINT, const BYTE*> pData;
 	D3D12Resource* pTextureBuffer;
+	// The subresources of a cooked texture point into its mapped file.
+	CookedTexture cookedTexture = {};
+	// Textures that are not block compressed are decoded into upload memory laid out like their
+	// subresources, and copied to the GPU from there.
+	D3D12UploadBuffer* pStagingBuffer;
+	std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> footprints;
 
 	// Helper functions
-	IWICImagingFactory* pFactory = NULL;
-	IWICBitmapDecoder* pDecoder = NULL;
-	IWICBitmapFrameDecode* pFrameDecode = NULL;
-	IWICFormatConverter* pConverter = NULL;
-
-	void LoadSingleTexture(std::wstring& texturePath, UINT index);
-	std::wstring GetTexturePath(std::wstring texturePath, UINT mipIndex);
-	std::wstring GetDefaultMipTexturePath(std::wstring texturePath, UINT mipSize);
+	// Map an image file and read its size. The image must be unmapped even if it fails.
+	BOOL MapImage(const std::wstring& imagePath, EncodedImage& image);
+	void UnmapImage(EncodedImage& image);
+	// Decode the images as the base levels of the slices, all at once on the threads, and build their mips.
+	BOOL DecodeToStagingBuffer(ID3D12Device* pDevice, const std::vector<EncodedImage>& images, MipFilterMode mode);
+	void LoadImages(ID3D12Device* pDevice, const std::vector<std::wstring>& imagePaths, MipFilterMode mode);
+	void LoadCookedTexture(ID3D12Device* pDevice, std::wstring& texturePath);
+	void FreeTextureData();
 
 public:
 	D3D12Texture(UINT inSRVID);
@@ -64,20 +85,37 @@ public:
 
 	inline const BYTE* GetTextureDataAt(UINT index) { return pData[index]; }
 	inline D3D12Resource* GetTextureBuffer() { return pTextureBuffer; }
+	inline D3D12UploadBuffer* GetStagingBuffer() { return pStagingBuffer; }
+	inline const D3D12_PLACED_SUBRESOURCE_FOOTPRINT& GetFootprint(UINT index) const { return footprints[index]; }
 	inline const UINT GetTextureID() const { return srvID; }
 	inline const UINT GetRTVHandle() const { return rtvHandle; }
 	inline const UINT GetDSVHandle() const { return dsvHandle; }
 	inline const UINT GetUAVHandle() const { return uavHandle; }
 	inline const UINT GetSubresourceNum() const { return mipLevel * slice; }
 	inline const D3D12TextureType GetType() const { return type; }
+	inline const UINT64 GetDataSize() const { return dataSize; }
+	inline const UINT GetWidth() const { return width; }
+	inline const UINT GetHeight() const { return height; }
+	inline const UINT GetMipLevelsNum() const { return mipLevel; }
+	inline const UINT GetResidentMip() const { return residentMip; }
+	inline const BOOL IsStreamed() const { return isStreamed; }
+	// Only cooked 2D textures can be streamed, their mips stay in the mapped file.
+	inline const BOOL IsStreamable() const
+	{
+		return type == D3D12TextureType::ShaderResource && slice == 1 && cookedTexture.pView != nullptr;
+	}
 
+	// The device only creates the staging buffer, so the texture can be loaded on any thread.
 	void LoadTexture(
+		ID3D12Device* pDevice,
 		std::wstring& texturePath,
-		UINT mipLevel = 1,
 		D3D12_SRV_DIMENSION srvDimension = D3D12_SRV_DIMENSION_TEXTURE2D,
 		UINT slice = 1);
 	void CreateTextureResource();
 	void ChangeTextureType(D3D12TextureType newType);
+	// Clamp the views created from now on to the finest resident mip.
+	void SetResidentMip(UINT mip);
+	void SetStreamed(BOOL streamed);
 	void ReleaseTextureData();
 	void ReleaseTextureBuffer();
 	void CreateSampler();
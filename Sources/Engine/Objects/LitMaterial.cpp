@@ -1,41 +1,60 @@
 #include "stdafx.h"
 #include "LitMaterial.h"
-#include "SceneManager.h"
 
-LitMaterial::LitMaterial(std::wstring inName) :
-	AbstractMaterial(inName)
+// In the order of the texture IDs of a material.
+const LPCWSTR LitMaterial::kPlaceholderTextureNames[LIT_MATERIAL_TEXTURES_NUM] =
+{
+	L"default_mip64.png",
+	L"default_mra_mip64.png",
+	L"default_n_mip64.png",
+};
+
+LitMaterial::LitMaterial(std::wstring inName, TextureCache* inTextureCache) :
+	AbstractMaterial(inName),
+	pMRATexture(nullptr),
+	pNormalTexture(nullptr),
+	pTextureCache(inTextureCache)
 {
 
 }
 
 LitMaterial::~LitMaterial()
 {
-	delete pTexture;
-	delete pMRATexture;
-	delete pNormalTexture;
+	pTextureCache->Release(pTexture);
+	pTextureCache->Release(pMRATexture);
+	pTextureCache->Release(pNormalTexture);
+}
+
+void LitMaterial::ReserveTextureIDs(D3D12DescriptorHeapManager* pDescriptorHeapManager)
+{
+	textureID = pDescriptorHeapManager->AllocateTextureSlots(LIT_MATERIAL_TEXTURES_NUM);
+}
+
+void LitMaterial::FreeTextureIDs(D3D12DescriptorHeapManager* pDescriptorHeapManager)
+{
+	pDescriptorHeapManager->FreeTextureSlots(textureID, LIT_MATERIAL_TEXTURES_NUM);
 }
 
 void LitMaterial::LoadTexture()
 {
 	std::wstring texturePath = GetAssetPath(name.c_str());
+	std::wstring texturePaths[LIT_MATERIAL_TEXTURES_NUM] =
+	{
+		texturePath,
+		GetMRATexturePath(texturePath),
+		GetNormalTexturePath(texturePath),
+	};
+	D3D12Texture** ppTextures[LIT_MATERIAL_TEXTURES_NUM] = { &pTexture, &pMRATexture, &pNormalTexture };
 
-	// Load the diffuse texture.
-	UINT id = SceneManager::sTextureID++;
-	pTexture = new D3D12Texture(id);
-	pTexture->LoadTexture(texturePath, 1);
-	pTexture->CreateTextureResource();
-
-	// Load the MRA texture.
-	id = SceneManager::sTextureID++;
-	pMRATexture = new D3D12Texture(id);
-	pMRATexture->LoadTexture(GetMRATexturePath(texturePath), 1);
-	pMRATexture->CreateTextureResource();
-
-	// Load the normal texture.
-	id = SceneManager::sTextureID++;
-	pNormalTexture = new D3D12Texture(id);
-	pNormalTexture->LoadTexture(GetNormalTexturePath(texturePath), 1);
-	pNormalTexture->CreateTextureResource();
+	// Load the diffuse, MRA and normal textures, or share them with the materials that use the same images.
+	for (UINT i = 0; i < LIT_MATERIAL_TEXTURES_NUM; i++)
+	{
+		if (GetFileAttributesW(texturePaths[i].c_str()) == INVALID_FILE_ATTRIBUTES)
+		{
+			texturePaths[i] = GetAssetPath(kPlaceholderTextureNames[i]);
+		}
+		*ppTextures[i] = pTextureCache->Acquire(texturePaths[i], textureID + i);
+	}
 }
 
 void LitMaterial::ReleaseTextureData()
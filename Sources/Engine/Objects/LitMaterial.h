@@ -1,5 +1,9 @@
 #pragma once
 #include "AbstractMaterial.h"
+#include "TextureCache.h"
+
+// Number of textures of a lit material, their IDs follow each other from the ID of the diffuse texture.
+#define LIT_MATERIAL_TEXTURES_NUM 3
 
 class LitMaterial : public AbstractMaterial
 {
@@ -9,15 +13,21 @@ private:
 
 	D3D12Texture* pMRATexture;
 	D3D12Texture* pNormalTexture;
+	TextureCache* pTextureCache;
 
 	//Helper functions
 	std::wstring GetMRATexturePath(std::wstring texturePath);
 	std::wstring GetNormalTexturePath(std::wstring texturePath);
 
 public:
-	LitMaterial(std::wstring inName);
+	// Textures shown until the textures of a material are loaded, and in place of the ones it lacks.
+	static const LPCWSTR kPlaceholderTextureNames[LIT_MATERIAL_TEXTURES_NUM];
+
+	LitMaterial(std::wstring inName, TextureCache* inTextureCache);
 	~LitMaterial();
 
+	virtual void ReserveTextureIDs(D3D12DescriptorHeapManager* pDescriptorHeapManager) override;
+	virtual void FreeTextureIDs(D3D12DescriptorHeapManager* pDescriptorHeapManager) override;
 	virtual void LoadTexture() override;
 	virtual void ReleaseTextureData() override;
 
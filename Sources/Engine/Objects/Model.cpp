@@ -1,29 +1,77 @@
 #include "stdafx.h"
 #include "Model.h"
+#include "MeshCache.h"
+#include "MeshletBuilder.h"
+#include "MappedFile.h"
+#include <chrono>
 
-Model::Model(UINT id, LPCWSTR meshPath) :
+Model::Model(UINT id, LPCWSTR path) :
     Transform(id),
-    pMeshPath(meshPath),
-    pBoundingBox(nullptr)
+    meshPath(path),
+    sourceHash(0),
+    pBoundingBox(nullptr),
+    currentLod(0)
 {
-    pMesh = new D3D12Mesh();
+    pMesh = std::make_shared<D3D12Mesh>();
 }
 
 Model::~Model()
 {
-    delete pMesh;
     delete pBoundingBox;
 }
 
 void Model::LoadModel(unique_ptr<FBXImporter>& importer)
 {
-    if ((pMeshPath != nullptr)
-        && importer->ImportFBX(GetAssetPath(pMeshPath)))
+    if (meshPath.empty())
     {
-        importer->LoadFBX(pMesh);
+        return;
     }
 
-    GenerateBoundingBox();
+    auto start = std::chrono::high_resolution_clock::now();
+    std::wstring sourcePath = GetAssetPath(meshPath.c_str());
+    std::wstring cachePath = MeshCache::GetCachePath(sourcePath);
+    // Key the cooked mesh by the content of the source when the scene manifest knows it.
+    UINT64 sourceStamp = sourceHash != 0 ? sourceHash : MeshCache::GetSourceTimestamp(sourcePath);
+    // Without a source the cooked mesh is all there is, whatever it was cooked from.
+    if (sourceStamp == 0 && !MappedFile::Exists(sourcePath))
+    {
+        sourceStamp = MESH_CACHE_ANY_SOURCE_STAMP;
+    }
+
+    // Prefer the cooked mesh, and cook it from the FBX when it is missing or stale.
+    D3D12_RAYTRACING_AABB aabb = {};
+    BOOL isCached = MeshCache::LoadMesh(cachePath, sourceStamp, pMesh.get(), aabb);
+    if (isCached)
+    {
+        delete pBoundingBox;
+        pBoundingBox = new AABBBox(aabb);
+    }
+    else if (importer->ImportFBX(sourcePath))
+    {
+        importer->LoadFBX(pMesh.get());
+        GenerateBoundingBox();
+        MeshCache::SaveMesh(cachePath, sourceStamp, pMesh.get(), pBoundingBox->GetData());
+    }
+
+    std::chrono::duration<double, std::milli> duration = std::chrono::high_resolution_clock::now() - start;
+    WCHAR message[256];
+    swprintf_s(message, L"Loaded %s from %s in %.2f ms.\n",
+        meshPath.c_str(), isCached ? L"the mesh cache" : L"FBX", duration.count());
+    OutputDebugStringW(message);
+}
+
+void Model::SetSourceHash(UINT64 hash)
+{
+    sourceHash = hash;
+}
+
+void Model::ShareMesh(const Model* pSource)
+{
+    pMesh = pSource->pMesh;
+    delete pBoundingBox;
+    pBoundingBox = pSource->pBoundingBox != nullptr ? new AABBBox(*pSource->pBoundingBox) : nullptr;
+    transformConstant.PositionScale = pSource->transformConstant.PositionScale;
+    transformConstant.PositionOffset = pSource->transformConstant.PositionOffset;
 }
 
 void Model::CreatePlane()
@@ -44,34 +92,124 @@ void Model::CreatePlane()
     GenerateBoundingBox();
 }
 
-void Model::SetMaterial(AbstractMaterial* material)
+void Model::PackVertices()
 {
-    pMaterial = material;
+    if (pBoundingBox == nullptr)
+    {
+        return;
+    }
+
+    pMesh->PackVertices(pBoundingBox->GetData());
+    transformConstant.PositionScale = pMesh->GetPositionScale();
+    transformConstant.PositionOffset = pMesh->GetPositionOffset();
 }
 
-void Model::GenerateBoundingBox()
+UINT Model::CullMeshlets(const Camera* pCamera, std::vector<UINT>& visibleMeshlets) const
 {
-    if (pBoundingBox != nullptr)
+    visibleMeshlets.clear();
+
+    // Scale the radius by the largest axis scale to stay conservative.
+    XMMATRIX objectToWorld = XMLoadFloat4x4(&transformConstant.ObjectToWorldMatrix);
+    FLOAT scale = max(max(
+        XMVectorGetX(XMVector3Length(objectToWorld.r[0])),
+        XMVectorGetX(XMVector3Length(objectToWorld.r[1]))),
+        XMVectorGetX(XMVector3Length(objectToWorld.r[2])));
+
+    const XMFLOAT4* pPlanes = pCamera->GetFrustumPlanes();
+    XMVECTOR cameraPosition = pCamera->GetWorldPosition();
+    const std::vector<D3D12Meshlet>& meshlets = pMesh->GetMeshlets();
+
+    UINT visibleTrianglesNum = 0;
+    for (UINT i = 0; i < meshlets.size(); i++)
     {
-        delete pBoundingBox;
+        const D3D12Meshlet& meshlet = meshlets[i];
+        XMVECTOR center = XMVector3Transform(XMLoadFloat3(&meshlet.center), objectToWorld);
+        XMVECTOR axis = meshlet.coneCutoff < 1.0f
+            ? XMVector3Normalize(XMVector3TransformNormal(XMLoadFloat3(&meshlet.coneAxis), objectToWorld))
+            : XMVectorZero();
+        if (MeshletBuilder::IsMeshletVisible(pPlanes, center, meshlet.radius * scale,
+            axis, meshlet.coneCutoff, cameraPosition))
+        {
+            visibleMeshlets.push_back(i);
+            visibleTrianglesNum += meshlet.trianglesNum;
+        }
+    }
+
+    return visibleTrianglesNum;
+}
+
+UINT Model::SelectLod(const Camera* pCamera)
+{
+    const std::vector<D3D12MeshLod>& lods = pMesh->GetLods();
+    if (lods.size() <= 1 || pBoundingBox == nullptr)
+    {
+        currentLod = 0;
+        return currentLod;
     }
 
-    const Vertex* pVertex = static_cast<const Vertex*>(pMesh->GetVerticesData());
+    FLOAT pixelsPerUnit = GetPixelsPerUnit(pCamera);
 
-    D3D12_RAYTRACING_AABB aabb = {};
-    aabb.MaxX = aabb.MinX = pVertex->positionOS.x;
-    aabb.MaxY = aabb.MinY = pVertex->positionOS.y;
-    aabb.MaxZ = aabb.MinZ = pVertex->positionOS.z;
+    // Switching to a coarser LOD needs a margin below the threshold, so that a model near
+    // the switch distance does not pop between two LODs every frame.
+    UINT lod = 0;
+    for (UINT i = 1; i < lods.size(); i++)
+    {
+        FLOAT threshold = i > currentLod
+            ? LOD_ERROR_THRESHOLD_PIXELS * (1.0f - LOD_HYSTERESIS)
+            : LOD_ERROR_THRESHOLD_PIXELS;
+        if (lods[i].error * pixelsPerUnit > threshold)
+        {
+            break;
+        }
+        lod = i;
+    }
+
+    currentLod = lod;
+    return currentLod;
+}
+
+FLOAT Model::GetUVsPerPixel(const Camera* pCamera) const
+{
+    if (pBoundingBox == nullptr)
+    {
+        return 0.0f;
+    }
+
+    return pMesh->GetUVDensity() / GetPixelsPerUnit(pCamera);
+}
+
+void Model::SetMaterial(AbstractMaterial* material)
+{
+    pMaterial = material;
+}
+
+// Helper functions.
+FLOAT Model::GetPixelsPerUnit(const Camera* pCamera) const
+{
+    XMMATRIX objectToWorld = XMLoadFloat4x4(&transformConstant.ObjectToWorldMatrix);
+    FLOAT scale = max(max(
+        XMVectorGetX(XMVector3Length(objectToWorld.r[0])),
+        XMVectorGetX(XMVector3Length(objectToWorld.r[1]))),
+        XMVectorGetX(XMVector3Length(objectToWorld.r[2])));
 
-    for (UINT i = 0; i < pMesh->GetVerticesNum(); i++)
+    // Project from the point of the bounding sphere closest to the camera.
+    D3D12_RAYTRACING_AABB aabb = pBoundingBox->GetData();
+    XMVECTOR minPosition = XMVectorSet(aabb.MinX, aabb.MinY, aabb.MinZ, 1.0f);
+    XMVECTOR maxPosition = XMVectorSet(aabb.MaxX, aabb.MaxY, aabb.MaxZ, 1.0f);
+    XMVECTOR center = XMVector3Transform((minPosition + maxPosition) * 0.5f, objectToWorld);
+    FLOAT radius = XMVectorGetX(XMVector3Length(maxPosition - minPosition)) * 0.5f * scale;
+    FLOAT distance = XMVectorGetX(XMVector3Length(center - pCamera->GetWorldPosition())) - radius;
+    distance = max(distance, pCamera->GetNearZ());
+
+    return scale * pCamera->GetCameraHeight() * 0.5f / (distance * tanf(pCamera->GetFov() * 0.5f));
+}
+
+void Model::GenerateBoundingBox()
+{
+    if (pBoundingBox != nullptr)
     {
-        aabb.MaxX = max(aabb.MaxX, (pVertex + i)->positionOS.x);
-        aabb.MaxY = max(aabb.MaxY, (pVertex + i)->positionOS.y);
-        aabb.MaxZ = max(aabb.MaxZ, (pVertex + i)->positionOS.z);
-        aabb.MinX = min(aabb.MinX, (pVertex + i)->positionOS.x);
-        aabb.MinY = min(aabb.MinY, (pVertex + i)->positionOS.y);
-        aabb.MinZ = min(aabb.MinZ, (pVertex + i)->positionOS.z);
+        delete pBoundingBox;
     }
 
-    pBoundingBox = new AABBBox(aabb);
+    pBoundingBox = new AABBBox(pMesh->ComputeBoundingBox());
 }
@@ -4,26 +4,49 @@
 #include "Transform.h"
 #include "AbstractMaterial.h"
 #include "AABBBox.h"
+#include "Camera.h"
+
+// Largest projected error of a LOD in pixels, and how much lower it has to be to switch to a coarser LOD.
+#define LOD_ERROR_THRESHOLD_PIXELS 1.0f
+#define LOD_HYSTERESIS 0.2f
 
 class Model : public Transform
 {
 private:
-    LPCWSTR pMeshPath;
-    D3D12Mesh* pMesh;
+    std::wstring meshPath;
+    UINT64 sourceHash;
+    // Models of the same source share the mesh and its buffers.
+    shared_ptr<D3D12Mesh> pMesh;
     AbstractMaterial* pMaterial;
     AABBBox* pBoundingBox;
+    UINT currentLod;
 
     void GenerateBoundingBox();
+    // Pixels covered by an object space unit at the point of the bounding sphere closest to the camera.
+    FLOAT GetPixelsPerUnit(const Camera* pCamera) const;
 
 public:
     Model(UINT id, LPCWSTR);
     ~Model();
 
     void LoadModel(unique_ptr<FBXImporter>&);
+    void SetSourceHash(UINT64 hash);
+    // Take the mesh of a loaded model of the same source, instead of loading it again.
+    void ShareMesh(const Model* pSource);
     void CreatePlane();
+    void PackVertices();
+
+    // Cull the meshlets against the frustum and by their normal cones, and return the visible triangles.
+    UINT CullMeshlets(const Camera* pCamera, std::vector<UINT>& visibleMeshlets) const;
+    // Pick the coarsest LOD whose error projects below the pixel threshold.
+    UINT SelectLod(const Camera* pCamera);
+    // UV units covered by a pixel of the model at its closest, from the UV density of its mesh.
+    FLOAT GetUVsPerPixel(const Camera* pCamera) const;
     void SetMaterial(AbstractMaterial*);
 
-    inline D3D12Mesh* GetMesh() const { return pMesh; }
+    inline const std::wstring& GetMeshPath() const { return meshPath; }
+    inline D3D12Mesh* GetMesh() const { return pMesh.get(); }
     inline AbstractMaterial* GetMaterial() const { return pMaterial; }
     inline const AABBBox* GetAABBBox() const { return pBoundingBox; }
+    inline const UINT GetCurrentLod() const { return currentLod; }
 };
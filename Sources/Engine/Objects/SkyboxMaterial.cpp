@@ -1,9 +1,9 @@
 #include "stdafx.h"
 #include "SkyboxMaterial.h"
-#include "SceneManager.h"
 
-SkyboxMaterial::SkyboxMaterial(std::wstring inName) :
-	AbstractMaterial(inName)
+SkyboxMaterial::SkyboxMaterial(std::wstring inName, std::shared_ptr<D3D12Device>& device) :
+	AbstractMaterial(inName),
+	pDevice(device)
 {
 
 }
@@ -14,14 +14,23 @@ SkyboxMaterial::~SkyboxMaterial()
 }
 
 
+void SkyboxMaterial::ReserveTextureIDs(D3D12DescriptorHeapManager* pDescriptorHeapManager)
+{
+	textureID = pDescriptorHeapManager->AllocateTextureSlots(1);
+}
+
+void SkyboxMaterial::FreeTextureIDs(D3D12DescriptorHeapManager* pDescriptorHeapManager)
+{
+	pDescriptorHeapManager->FreeTextureSlots(textureID, 1);
+}
+
 void SkyboxMaterial::LoadTexture()
 {
 	std::wstring texturePath = GetAssetPath(name.c_str());
 
 	// Load the diffuse texture.
-	UINT id = SceneManager::sTextureID++;
-	pTexture = new D3D12Texture(id);
-	pTexture->LoadTexture(texturePath, 1, D3D12_SRV_DIMENSION_TEXTURECUBE, 6);
+	pTexture = new D3D12Texture(textureID);
+	pTexture->LoadTexture(pDevice->GetDevice().Get(), texturePath, D3D12_SRV_DIMENSION_TEXTURECUBE, 6);
 	pTexture->CreateTextureResource();
 }
 
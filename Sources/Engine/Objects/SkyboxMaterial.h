@@ -4,11 +4,14 @@
 class SkyboxMaterial : public AbstractMaterial
 {
 private:
+	std::shared_ptr<D3D12Device> pDevice;
 
 public:
-	SkyboxMaterial(std::wstring inName);
+	SkyboxMaterial(std::wstring inName, std::shared_ptr<D3D12Device>& device);
 	~SkyboxMaterial();
 
+	virtual void ReserveTextureIDs(D3D12DescriptorHeapManager* pDescriptorHeapManager) override;
+	virtual void FreeTextureIDs(D3D12DescriptorHeapManager* pDescriptorHeapManager) override;
 	virtual void LoadTexture() override;
 	virtual void ReleaseTextureData() override;
 };
@@ -56,8 +56,7 @@ void BlitPass::Execute(D3D12CommandList* pCommandList)
 {
     pCommandList->SetPipelineState(pPipelineState.Get());
 
-    const UINT colorHandle = pViewManager->GetCurrentColorHandle();
-    pViewManager->ConvertTextureType(pCommandList, colorHandle, D3D12TextureType::RenderTarget, D3D12TextureType::ShaderResource);
+    const UINT colorHandle = pViewManager->GetTAAColorHandle();
     pDevice->GetDescriptorHeapManager()->SetViews(
         pCommandList->GetCommandList(),
         SHADER_RESOURCE_VIEW_GLOBAL,
@@ -73,5 +72,4 @@ void BlitPass::Execute(D3D12CommandList* pCommandList)
     pCommandList->SetRenderTargets(1, &rtvHandle, nullptr);
 
     pSceneManager->DrawFullScreenMesh(pCommandList);
-    pViewManager->ConvertTextureType(pCommandList, colorHandle, D3D12TextureType::RenderTarget, D3D12TextureType::RenderTarget);
 }
@@ -46,15 +46,6 @@ void DeferredLightingPass::Execute(D3D12CommandList* pCommandList)
     pCommandList->SetPipelineState(pPipelineState.Get());
 
     // Bind the SRVs using in the shading.
-    for (UINT i = 0; i < pViewManager->GetGBufferCount(); i++)
-    {
-        pViewManager->ConvertTextureType(
-            pCommandList,
-            pViewManager->GetGBufferHandle(i),
-            D3D12TextureType::RenderTarget,
-            D3D12TextureType::ShaderResource,
-            FALSE);
-    }
     pDevice->GetDescriptorHeapManager()->SetComputeViews(
         pCommandList->GetCommandList(),
         SHADER_RESOURCE_VIEW_GLOBAL,
@@ -72,19 +63,4 @@ void DeferredLightingPass::Execute(D3D12CommandList* pCommandList)
     UINT groupCountX = pSceneManager->GetCamera()->GetCameraWidth() / 10;
     UINT groupCountY = pSceneManager->GetCamera()->GetCameraHeight() / 10;
     pCommandList->DispatchThreads(groupCountX, groupCountY, 1);
-
-    for (UINT i = 0; i < pViewManager->GetGBufferCount(); i++)
-    {
-        pViewManager->ConvertTextureType(
-            pCommandList,
-            pViewManager->GetGBufferHandle(i),
-            D3D12TextureType::RenderTarget,
-            D3D12TextureType::RenderTarget,
-            FALSE);
-    }
-
-    // Copy the output to the color buffer.
-    //const D3D12Resource* pColorResource = pViewManager->GetCurrentRTVBuffer(pViewManager->GetCurrentColorHandle());
-    //const D3D12Resource* pOutputResource = pViewManager->GetUAVBuffer(pViewManager->GetUAVColorHandle());
-    //CopyBuffer(pCommandList, pColorResource, pOutputResource);
 }
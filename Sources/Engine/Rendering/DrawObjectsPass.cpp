@@ -22,10 +22,18 @@ void DrawObjectsPass::Setup(D3D12CommandList* pCommandList, ComPtr<ID3D12RootSig
     UINT compileFlags = 0;
 #endif
 
-    ThrowIfFailed(D3DCompileFromFile(GetShaderPath(L"Lit.hlsl").c_str(), nullptr, D3D_COMPILE_STANDARD_FILE_INCLUDE, "VSMain", "vs_5_0", compileFlags, 0, &vertexShader, nullptr));
-    ThrowIfFailed(D3DCompileFromFile(GetShaderPath(L"Lit.hlsl").c_str(), nullptr, D3D_COMPILE_STANDARD_FILE_INCLUDE, "PSMain", "ps_5_0", compileFlags, 0, &pixelShader, nullptr));
+    ThrowIfFailed(D3DCompileFromFile(GetShaderPath(L"Lit.hlsl").c_str(), nullptr, D3D_COMPILE_STANDARD_FILE_INCLUDE, "VSMain", "vs_5_1", compileFlags, 0, &vertexShader, nullptr));
+    ThrowIfFailed(D3DCompileFromFile(GetShaderPath(L"Lit.hlsl").c_str(), nullptr, D3D_COMPILE_STANDARD_FILE_INCLUDE, "PSMain", "ps_5_1", compileFlags, 0, &pixelShader, nullptr));
 
     // Define the vertex input layout.
+#if USE_PACKED_VERTEX
+    D3D12_INPUT_ELEMENT_DESC inputElementDescs[] =
+    {
+        { "POSITION", 0, DXGI_FORMAT_R16G16B16A16_SNORM, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+        { "NORMAL", 0, DXGI_FORMAT_R16G16B16A16_SNORM, 0, 8, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+        { "TEXCOORD", 0, DXGI_FORMAT_R16G16_FLOAT, 0, 16, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
+    };
+#else
     D3D12_INPUT_ELEMENT_DESC inputElementDescs[] =
     {
         { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
@@ -34,6 +42,7 @@ void DrawObjectsPass::Setup(D3D12CommandList* pCommandList, ComPtr<ID3D12RootSig
         { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 40, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
         { "COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 48, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
     };
+#endif
 
     // Describe and create the graphics pipeline state object (PSO).
     D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc = {};
@@ -66,7 +75,7 @@ void DrawObjectsPass::Execute(D3D12CommandList* pCommandList)
     pCommandList->SetScissorRects(pSceneManager->GetCamera()->GetScissorRect());
 
     // Set the rtv and the dsv.
-    UINT const colorHandle = pViewManager->GetCurrentColorHandle();
+    UINT const colorHandle = pViewManager->GetColorHandle();
     D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle =
         pDevice->GetDescriptorHeapManager()->GetHandle(RENDER_TARGET_VIEW, colorHandle);
     D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle =
@@ -142,8 +142,7 @@ void FrustumCullingPass::Execute(D3D12CommandList* pCommandList)
         dispatchDesc->Width = width;
         dispatchDesc->Height = height;
         dispatchDesc->Depth = 1;
-        commandList->SetPipelineState1(stateObject);
-        commandList->DispatchRays(dispatchDesc);
+        commandList->DispatchRays(stateObject, dispatchDesc);
     };
 
     // Bind resources for the frustum culling.
@@ -158,7 +157,7 @@ void FrustumCullingPass::Execute(D3D12CommandList* pCommandList)
 
     // Dispatch rays.    
     D3D12_DISPATCH_RAYS_DESC dispatchDesc = {};
-    DispatchRays(pCommandList->GetDXRCommandList().Get(), pDXRStateObject.Get(), &dispatchDesc);
+    DispatchRays(pCommandList, pDXRStateObject.Get(), &dispatchDesc);
 
     pSceneManager->ReadbackFrustumCullingData(pCommandList);
 }
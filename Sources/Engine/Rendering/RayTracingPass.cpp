@@ -187,15 +187,12 @@ void RayTracingPass::Execute(D3D12CommandList* pCommandList)
         dispatchDesc->Width = width;
         dispatchDesc->Height = height;
         dispatchDesc->Depth = 1;
-        commandList->SetPipelineState1(stateObject);
-        commandList->DispatchRays(dispatchDesc);
+        commandList->DispatchRays(stateObject, dispatchDesc);
     };
 
     // Bind resources for the raytracing.
     pSceneManager->SetDXRResources(pCommandList);
 
-    const UINT depthHandle = 0;
-    pViewManager->ConvertTextureType(pCommandList, depthHandle, D3D12TextureType::DepthStencil, D3D12TextureType::ShaderResource);
     pDevice->GetDescriptorHeapManager()->SetComputeViews(
         pCommandList->GetCommandList(),
         SHADER_RESOURCE_VIEW_GLOBAL,
@@ -211,12 +208,5 @@ void RayTracingPass::Execute(D3D12CommandList* pCommandList)
 
     // Dispatch rays.    
     D3D12_DISPATCH_RAYS_DESC dispatchDesc = {};
-    DispatchRays(pCommandList->GetDXRCommandList().Get(), pDXRStateObject.Get(), &dispatchDesc);
-
-    pViewManager->ConvertTextureType(pCommandList, depthHandle, D3D12TextureType::DepthStencil, D3D12TextureType::DepthStencil);
-
-    // Copy the output to the color buffer.
-    const D3D12Resource* pColorResource = pViewManager->GetCurrentRTVBuffer(pViewManager->GetCurrentColorHandle());
-    const D3D12Resource* pOutputResource = pViewManager->GetUAVBuffer(pViewManager->GetUAVColorHandle());
-    CopyBuffer(pCommandList, pColorResource, pOutputResource);
+    DispatchRays(pCommandList, pDXRStateObject.Get(), &dispatchDesc);
 }
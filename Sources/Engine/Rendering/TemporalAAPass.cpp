@@ -60,13 +60,8 @@ void TemporalAAPass::Execute(D3D12CommandList* pCommandList)
     pCommandList->SetPipelineState(pPipelineState.Get());
 
     // Set the color buffer and the TAA history to the SRVs.
-    const UINT colorHandle = pViewManager->GetCurrentColorHandle();
-    const UINT taaHandle = pViewManager->GetNextColorHandle();
-    const UINT depthHandle = 0;
-
-    pViewManager->ConvertTextureType(pCommandList, colorHandle, D3D12TextureType::RenderTarget, D3D12TextureType::ShaderResource);
-    pViewManager->ConvertTextureType(pCommandList, taaHistoryHandle, D3D12TextureType::RenderTarget, D3D12TextureType::ShaderResource);
-    pViewManager->ConvertTextureType(pCommandList, depthHandle, D3D12TextureType::DepthStencil, D3D12TextureType::ShaderResource);
+    const UINT colorHandle = pViewManager->GetColorHandle();
+    const UINT taaHandle = pViewManager->GetTAAColorHandle();
     pDevice->GetDescriptorHeapManager()->SetViews(
         pCommandList->GetCommandList(),
         SHADER_RESOURCE_VIEW_GLOBAL,
@@ -93,13 +88,4 @@ void TemporalAAPass::Execute(D3D12CommandList* pCommandList)
     pCommandList->SetScissorRects(pSceneManager->GetCamera()->GetScissorRect());
 
     pSceneManager->DrawFullScreenMesh(pCommandList);
-    pViewManager->ConvertTextureType(pCommandList, colorHandle, D3D12TextureType::RenderTarget, D3D12TextureType::RenderTarget);
-    pViewManager->ConvertTextureType(pCommandList, taaHistoryHandle, D3D12TextureType::RenderTarget, D3D12TextureType::RenderTarget);
-    pViewManager->ConvertTextureType(pCommandList, depthHandle, D3D12TextureType::DepthStencil, D3D12TextureType::DepthStencil);
-
-    // Copy the current TAA buffer to the history.
-    const D3D12Resource* pTAAHistoryResource = pViewManager->GetCurrentRTVBuffer(taaHistoryHandle);
-    const D3D12Resource* pTAAResource = pViewManager->GetCurrentRTVBuffer(taaHandle);
-
-    CopyBuffer(pCommandList, pTAAHistoryResource, pTAAResource);
 }
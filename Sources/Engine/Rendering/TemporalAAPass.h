@@ -12,4 +12,7 @@ public:
 
 	virtual void Setup(D3D12CommandList*, ComPtr<ID3D12RootSignature>&) override;
 	virtual void Execute(D3D12CommandList*) override;
+
+	// The TAA output of a frame is copied to the history, which the next frame reads.
+	inline const UINT GetTAAHistoryHandle() const { return taaHistoryHandle; }
 };
@@ -0,0 +1,161 @@
+#pragma once
+
+// The D3D12 and DXGI declarations the utilities use, for the platforms without d3d12.h. Values match the
+// Windows SDK, resources are only ever used as opaque pointers.
+struct ID3D12Object
+{
+};
+
+struct ID3D12Resource : public ID3D12Object
+{
+};
+
+struct D3D12_RAYTRACING_AABB
+{
+    FLOAT MinX;
+    FLOAT MinY;
+    FLOAT MinZ;
+    FLOAT MaxX;
+    FLOAT MaxY;
+    FLOAT MaxZ;
+};
+
+enum D3D12_RESOURCE_STATES
+{
+    D3D12_RESOURCE_STATE_COMMON = 0,
+    D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER = 0x1,
+    D3D12_RESOURCE_STATE_INDEX_BUFFER = 0x2,
+    D3D12_RESOURCE_STATE_RENDER_TARGET = 0x4,
+    D3D12_RESOURCE_STATE_UNORDERED_ACCESS = 0x8,
+    D3D12_RESOURCE_STATE_DEPTH_WRITE = 0x10,
+    D3D12_RESOURCE_STATE_DEPTH_READ = 0x20,
+    D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE = 0x40,
+    D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE = 0x80,
+    D3D12_RESOURCE_STATE_STREAM_OUT = 0x100,
+    D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT = 0x200,
+    D3D12_RESOURCE_STATE_COPY_DEST = 0x400,
+    D3D12_RESOURCE_STATE_COPY_SOURCE = 0x800,
+    D3D12_RESOURCE_STATE_RESOLVE_DEST = 0x1000,
+    D3D12_RESOURCE_STATE_RESOLVE_SOURCE = 0x2000,
+    D3D12_RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE = 0x400000,
+    D3D12_RESOURCE_STATE_GENERIC_READ = 0xac3,
+    D3D12_RESOURCE_STATE_PRESENT = 0,
+};
+
+inline D3D12_RESOURCE_STATES operator|(D3D12_RESOURCE_STATES a, D3D12_RESOURCE_STATES b)
+{
+    return static_cast<D3D12_RESOURCE_STATES>(static_cast<INT>(a) | static_cast<INT>(b));
+}
+
+inline D3D12_RESOURCE_STATES operator&(D3D12_RESOURCE_STATES a, D3D12_RESOURCE_STATES b)
+{
+    return static_cast<D3D12_RESOURCE_STATES>(static_cast<INT>(a) & static_cast<INT>(b));
+}
+
+inline D3D12_RESOURCE_STATES operator~(D3D12_RESOURCE_STATES a)
+{
+    return static_cast<D3D12_RESOURCE_STATES>(~static_cast<INT>(a));
+}
+
+inline D3D12_RESOURCE_STATES& operator|=(D3D12_RESOURCE_STATES& a, D3D12_RESOURCE_STATES b)
+{
+    return a = a | b;
+}
+
+inline D3D12_RESOURCE_STATES& operator&=(D3D12_RESOURCE_STATES& a, D3D12_RESOURCE_STATES b)
+{
+    return a = a & b;
+}
+
+enum D3D12_RESOURCE_BARRIER_TYPE
+{
+    D3D12_RESOURCE_BARRIER_TYPE_TRANSITION = 0,
+    D3D12_RESOURCE_BARRIER_TYPE_ALIASING = 1,
+    D3D12_RESOURCE_BARRIER_TYPE_UAV = 2,
+};
+
+enum D3D12_RESOURCE_BARRIER_FLAGS
+{
+    D3D12_RESOURCE_BARRIER_FLAG_NONE = 0,
+    D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY = 0x1,
+    D3D12_RESOURCE_BARRIER_FLAG_END_ONLY = 0x2,
+};
+
+#define D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES 0xffffffff
+
+struct D3D12_RESOURCE_TRANSITION_BARRIER
+{
+    ID3D12Resource* pResource;
+    UINT Subresource;
+    D3D12_RESOURCE_STATES StateBefore;
+    D3D12_RESOURCE_STATES StateAfter;
+};
+
+struct D3D12_RESOURCE_ALIASING_BARRIER
+{
+    ID3D12Resource* pResourceBefore;
+    ID3D12Resource* pResourceAfter;
+};
+
+struct D3D12_RESOURCE_UAV_BARRIER
+{
+    ID3D12Resource* pResource;
+};
+
+struct D3D12_RESOURCE_BARRIER
+{
+    D3D12_RESOURCE_BARRIER_TYPE Type;
+    D3D12_RESOURCE_BARRIER_FLAGS Flags;
+    union
+    {
+        D3D12_RESOURCE_TRANSITION_BARRIER Transition;
+        D3D12_RESOURCE_ALIASING_BARRIER Aliasing;
+        D3D12_RESOURCE_UAV_BARRIER UAV;
+    };
+};
+
+enum D3D12_FILTER
+{
+    D3D12_FILTER_MIN_MAG_MIP_POINT = 0,
+    D3D12_FILTER_MIN_MAG_MIP_LINEAR = 0x15,
+    D3D12_FILTER_ANISOTROPIC = 0x55,
+};
+
+enum D3D12_TEXTURE_ADDRESS_MODE
+{
+    D3D12_TEXTURE_ADDRESS_MODE_WRAP = 1,
+    D3D12_TEXTURE_ADDRESS_MODE_MIRROR = 2,
+    D3D12_TEXTURE_ADDRESS_MODE_CLAMP = 3,
+};
+
+enum D3D12_COMPARISON_FUNC
+{
+    D3D12_COMPARISON_FUNC_NEVER = 1,
+    D3D12_COMPARISON_FUNC_ALWAYS = 8,
+};
+
+#define D3D12_FLOAT32_MAX 3.402823466e+38f
+
+struct D3D12_SAMPLER_DESC
+{
+    D3D12_FILTER Filter;
+    D3D12_TEXTURE_ADDRESS_MODE AddressU;
+    D3D12_TEXTURE_ADDRESS_MODE AddressV;
+    D3D12_TEXTURE_ADDRESS_MODE AddressW;
+    FLOAT MipLODBias;
+    UINT MaxAnisotropy;
+    D3D12_COMPARISON_FUNC ComparisonFunc;
+    FLOAT BorderColor[4];
+    FLOAT MinLOD;
+    FLOAT MaxLOD;
+};
+
+enum DXGI_FORMAT
+{
+    DXGI_FORMAT_UNKNOWN = 0,
+    DXGI_FORMAT_R8G8B8A8_UNORM = 28,
+    DXGI_FORMAT_BC1_UNORM = 71,
+    DXGI_FORMAT_BC4_UNORM = 80,
+    DXGI_FORMAT_BC5_UNORM = 83,
+    DXGI_FORMAT_BC7_UNORM = 98,
+};
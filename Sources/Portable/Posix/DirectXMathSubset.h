@@ -0,0 +1,184 @@
+#pragma once
+#include <cmath>
+
+// A scalar implementation of the DirectXMath types and functions the utilities use, for the platforms
+// without DirectXMath.h. Results match DirectXMath up to rounding.
+namespace DirectX
+{
+    constexpr float XM_PI = 3.141592654f;
+
+    struct XMFLOAT2
+    {
+        float x;
+        float y;
+
+        XMFLOAT2() = default;
+        constexpr XMFLOAT2(float _x, float _y) : x(_x), y(_y) {}
+    };
+
+    struct XMFLOAT3
+    {
+        float x;
+        float y;
+        float z;
+
+        XMFLOAT3() = default;
+        constexpr XMFLOAT3(float _x, float _y, float _z) : x(_x), y(_y), z(_z) {}
+    };
+
+    struct XMFLOAT4
+    {
+        float x;
+        float y;
+        float z;
+        float w;
+
+        XMFLOAT4() = default;
+        constexpr XMFLOAT4(float _x, float _y, float _z, float _w) : x(_x), y(_y), z(_z), w(_w) {}
+    };
+
+    struct XMUINT2
+    {
+        uint32_t x;
+        uint32_t y;
+    };
+
+    struct XMUINT3
+    {
+        uint32_t x;
+        uint32_t y;
+        uint32_t z;
+    };
+
+    struct XMFLOAT4X4
+    {
+        float m[4][4];
+    };
+
+    struct XMVECTOR
+    {
+        float v[4];
+    };
+
+    typedef const XMVECTOR& FXMVECTOR;
+
+    struct XMMATRIX
+    {
+        XMVECTOR r[4];
+    };
+
+    constexpr float XMConvertToRadians(float degrees) { return degrees * (XM_PI / 180.0f); }
+    constexpr float XMConvertToDegrees(float radians) { return radians * (180.0f / XM_PI); }
+
+    inline XMVECTOR XMVectorSet(float x, float y, float z, float w) { return { { x, y, z, w } }; }
+    inline XMVECTOR XMVectorZero() { return { { 0.0f, 0.0f, 0.0f, 0.0f } }; }
+    inline XMVECTOR XMVectorReplicate(float value) { return { { value, value, value, value } }; }
+    inline float XMVectorGetX(FXMVECTOR v) { return v.v[0]; }
+    inline float XMVectorGetY(FXMVECTOR v) { return v.v[1]; }
+    inline float XMVectorGetZ(FXMVECTOR v) { return v.v[2]; }
+    inline float XMVectorGetW(FXMVECTOR v) { return v.v[3]; }
+    inline XMVECTOR XMVectorSetW(FXMVECTOR v, float w) { return { { v.v[0], v.v[1], v.v[2], w } }; }
+
+    inline XMVECTOR operator+(FXMVECTOR a, FXMVECTOR b) { return { { a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3] } }; }
+    inline XMVECTOR operator-(FXMVECTOR a, FXMVECTOR b) { return { { a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3] } }; }
+    inline XMVECTOR operator-(FXMVECTOR a) { return { { -a.v[0], -a.v[1], -a.v[2], -a.v[3] } }; }
+    inline XMVECTOR operator*(FXMVECTOR a, FXMVECTOR b) { return { { a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3] } }; }
+    inline XMVECTOR operator*(FXMVECTOR a, float s) { return { { a.v[0] * s, a.v[1] * s, a.v[2] * s, a.v[3] * s } }; }
+    inline XMVECTOR operator*(float s, FXMVECTOR a) { return a * s; }
+    inline XMVECTOR operator/(FXMVECTOR a, float s) { return a * (1.0f / s); }
+    inline XMVECTOR& operator+=(XMVECTOR& a, FXMVECTOR b) { return a = a + b; }
+    inline XMVECTOR& operator-=(XMVECTOR& a, FXMVECTOR b) { return a = a - b; }
+    inline XMVECTOR& operator*=(XMVECTOR& a, float s) { return a = a * s; }
+
+    inline XMVECTOR XMVectorMin(FXMVECTOR a, FXMVECTOR b)
+    {
+        return { { fminf(a.v[0], b.v[0]), fminf(a.v[1], b.v[1]), fminf(a.v[2], b.v[2]), fminf(a.v[3], b.v[3]) } };
+    }
+
+    inline XMVECTOR XMVectorMax(FXMVECTOR a, FXMVECTOR b)
+    {
+        return { { fmaxf(a.v[0], b.v[0]), fmaxf(a.v[1], b.v[1]), fmaxf(a.v[2], b.v[2]), fmaxf(a.v[3], b.v[3]) } };
+    }
+
+    inline XMVECTOR XMVector3Dot(FXMVECTOR a, FXMVECTOR b)
+    {
+        return XMVectorReplicate(a.v[0] * b.v[0] + a.v[1] * b.v[1] + a.v[2] * b.v[2]);
+    }
+
+    inline XMVECTOR XMVector3Cross(FXMVECTOR a, FXMVECTOR b)
+    {
+        return { { a.v[1] * b.v[2] - a.v[2] * b.v[1], a.v[2] * b.v[0] - a.v[0] * b.v[2], a.v[0] * b.v[1] - a.v[1] * b.v[0], 0.0f } };
+    }
+
+    inline XMVECTOR XMVector3LengthSq(FXMVECTOR v) { return XMVector3Dot(v, v); }
+    inline XMVECTOR XMVector3Length(FXMVECTOR v) { return XMVectorReplicate(sqrtf(XMVectorGetX(XMVector3Dot(v, v)))); }
+
+    inline XMVECTOR XMVector3Normalize(FXMVECTOR v)
+    {
+        const float length = XMVectorGetX(XMVector3Length(v));
+        return length > 0.0f ? v * (1.0f / length) : v;
+    }
+
+    // Rotate by roll around z first, then pitch around x, then yaw around y.
+    inline XMVECTOR XMQuaternionRotationRollPitchYaw(float pitch, float yaw, float roll)
+    {
+        const float sp = sinf(pitch * 0.5f), cp = cosf(pitch * 0.5f);
+        const float sy = sinf(yaw * 0.5f), cy = cosf(yaw * 0.5f);
+        const float sr = sinf(roll * 0.5f), cr = cosf(roll * 0.5f);
+        return { {
+            sp * cy * cr + cp * sy * sr,
+            cp * sy * cr - sp * cy * sr,
+            cp * cy * sr - sp * sy * cr,
+            cp * cy * cr + sp * sy * sr } };
+    }
+
+    // Matrices transform row vectors, so a * b applies a first.
+    inline XMMATRIX operator*(const XMMATRIX& a, const XMMATRIX& b)
+    {
+        XMMATRIX result;
+        for (int i = 0; i < 4; i++)
+        {
+            result.r[i] = b.r[0] * a.r[i].v[0] + b.r[1] * a.r[i].v[1] + b.r[2] * a.r[i].v[2] + b.r[3] * a.r[i].v[3];
+        }
+        return result;
+    }
+
+    inline XMMATRIX XMMatrixScalingFromVector(FXMVECTOR scale)
+    {
+        return { { { { scale.v[0], 0.0f, 0.0f, 0.0f } }, { { 0.0f, scale.v[1], 0.0f, 0.0f } },
+            { { 0.0f, 0.0f, scale.v[2], 0.0f } }, { { 0.0f, 0.0f, 0.0f, 1.0f } } } };
+    }
+
+    inline XMMATRIX XMMatrixTranslationFromVector(FXMVECTOR offset)
+    {
+        return { { { { 1.0f, 0.0f, 0.0f, 0.0f } }, { { 0.0f, 1.0f, 0.0f, 0.0f } },
+            { { 0.0f, 0.0f, 1.0f, 0.0f } }, { { offset.v[0], offset.v[1], offset.v[2], 1.0f } } } };
+    }
+
+    inline XMMATRIX XMMatrixRotationQuaternion(FXMVECTOR q)
+    {
+        const float x = q.v[0], y = q.v[1], z = q.v[2], w = q.v[3];
+        return { {
+            { { 1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y + z * w), 2.0f * (x * z - y * w), 0.0f } },
+            { { 2.0f * (x * y - z * w), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z + x * w), 0.0f } },
+            { { 2.0f * (x * z + y * w), 2.0f * (y * z - x * w), 1.0f - 2.0f * (x * x + y * y), 0.0f } },
+            { { 0.0f, 0.0f, 0.0f, 1.0f } } } };
+    }
+
+    inline XMVECTOR XMLoadFloat2(const XMFLOAT2* p) { return { { p->x, p->y, 0.0f, 0.0f } }; }
+    inline XMVECTOR XMLoadFloat3(const XMFLOAT3* p) { return { { p->x, p->y, p->z, 0.0f } }; }
+    inline XMVECTOR XMLoadFloat4(const XMFLOAT4* p) { return { { p->x, p->y, p->z, p->w } }; }
+    inline void XMStoreFloat2(XMFLOAT2* p, FXMVECTOR v) { p->x = v.v[0]; p->y = v.v[1]; }
+    inline void XMStoreFloat3(XMFLOAT3* p, FXMVECTOR v) { p->x = v.v[0]; p->y = v.v[1]; p->z = v.v[2]; }
+    inline void XMStoreFloat4(XMFLOAT4* p, FXMVECTOR v) { p->x = v.v[0]; p->y = v.v[1]; p->z = v.v[2]; p->w = v.v[3]; }
+    inline void XMStoreFloat4x4(XMFLOAT4X4* p, const XMMATRIX& m)
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            for (int j = 0; j < 4; j++)
+            {
+                p->m[i][j] = m.r[i].v[j];
+            }
+        }
+    }
+}
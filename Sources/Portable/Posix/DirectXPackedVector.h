@@ -0,0 +1,78 @@
+#pragma once
+
+// The half float conversions of DirectXPackedVector.h, rounding to nearest even like the SDK does.
+namespace DirectX
+{
+    namespace PackedVector
+    {
+        typedef uint16_t HALF;
+
+        inline HALF XMConvertFloatToHalf(float value)
+        {
+            UINT bits;
+            memcpy(&bits, &value, sizeof(bits));
+            const UINT sign = (bits >> 16) & 0x8000;
+            bits &= 0x7FFFFFFF;
+
+            UINT result;
+            if (bits > 0x7F800000)
+            {
+                // NaN.
+                result = 0x7E00;
+            }
+            else if (bits >= 0x47800000)
+            {
+                // Too large, or infinite.
+                result = 0x7C00;
+            }
+            else if (bits < 0x38800000)
+            {
+                // Denormalized, or flushed to 0.
+                const INT shift = 113 - static_cast<INT>(bits >> 23);
+                bits = shift < 24 ? (0x800000 | (bits & 0x7FFFFF)) >> shift : 0;
+                result = (bits + 0x0FFF + ((bits >> 13) & 1)) >> 13;
+            }
+            else
+            {
+                bits += 0xC8000000;
+                result = (bits + 0x0FFF + ((bits >> 13) & 1)) >> 13;
+            }
+
+            return static_cast<HALF>((result & 0x7FFF) | sign);
+        }
+
+        inline float XMConvertHalfToFloat(HALF value)
+        {
+            UINT mantissa = value & 0x03FF;
+            UINT exponent = value & 0x7C00;
+            if (exponent == 0x7C00)
+            {
+                exponent = 0x8F;
+            }
+            else if (exponent != 0)
+            {
+                exponent = (value >> 10) & 0x1F;
+            }
+            else if (mantissa != 0)
+            {
+                // Normalize the denormalized value.
+                exponent = 1;
+                do
+                {
+                    exponent--;
+                    mantissa <<= 1;
+                } while ((mantissa & 0x0400) == 0);
+                mantissa &= 0x03FF;
+            }
+            else
+            {
+                exponent = static_cast<UINT>(-112);
+            }
+
+            const UINT bits = ((value & 0x8000) << 16) | ((exponent + 112) << 23) | (mantissa << 13);
+            float result;
+            memcpy(&result, &bits, sizeof(result));
+            return result;
+        }
+    }
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <stdexcept>
+
+// The part of PathHelper.h that does not need Win32 or D3D12.
+inline void ThrowIfFalse(bool value)
+{
+    if (!value)
+    {
+        throw std::runtime_error("ThrowIfFalse");
+    }
+}
+
+// The tests define the Assets directory of the source tree, so they run from any build directory.
+#ifdef ASSET_ROOT_PATH
+constexpr LPCWSTR AssetRootPath = ASSET_ROOT_PATH;
+#else
+constexpr LPCWSTR AssetRootPath = L"../Assets/";
+#endif
+
+inline std::wstring GetAssetPath(LPCWSTR assetName)
+{
+    return AssetRootPath + (std::wstring)assetName;
+}
+
+inline std::wstring EraseSuffix(LPCWSTR assetName)
+{
+    std::wstring name = assetName;
+    size_t start = name.find(L'.');
+    name.erase(start, name.size() - start);
+
+    return name;
+}
+
+inline UINT Align(UINT size, UINT alignment)
+{
+    return (size + (alignment - 1)) & ~(alignment - 1);
+}
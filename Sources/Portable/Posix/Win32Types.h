@@ -0,0 +1,110 @@
+#pragma once
+#include <cfloat>
+#include <climits>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cwchar>
+
+// The Win32 types and calls the utilities use, for the platforms without windows.h.
+typedef uint8_t BYTE;
+typedef int8_t INT8;
+typedef uint8_t UINT8;
+typedef int16_t INT16;
+typedef uint16_t UINT16;
+typedef int32_t INT;
+typedef uint32_t UINT;
+typedef uint32_t UINT32;
+typedef int64_t INT64;
+typedef uint64_t UINT64;
+typedef uint32_t DWORD;
+typedef float FLOAT;
+typedef int BOOL;
+typedef size_t SIZE_T;
+typedef wchar_t WCHAR;
+typedef const wchar_t* LPCWSTR;
+typedef void* HANDLE;
+
+#define TRUE 1
+#define FALSE 0
+
+#ifndef min
+#define min(a, b) (((a) < (b)) ? (a) : (b))
+#endif
+#ifndef max
+#define max(a, b) (((a) > (b)) ? (a) : (b))
+#endif
+
+template <typename T, size_t N>
+constexpr size_t _countof(T (&)[N]) { return N; }
+
+template <size_t N>
+inline int swprintf_s(WCHAR (&buffer)[N], const WCHAR* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    const int result = vswprintf(buffer, N, format, args);
+    va_end(args);
+    return result;
+}
+
+template <size_t N>
+inline int sprintf_s(char (&buffer)[N], const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    const int result = vsnprintf(buffer, N, format, args);
+    va_end(args);
+    return result;
+}
+
+inline void OutputDebugStringW(const WCHAR* message)
+{
+    fputws(message, stderr);
+}
+
+inline void OutputDebugStringA(const char* message)
+{
+    fputs(message, stderr);
+}
+
+inline unsigned char _BitScanForward(unsigned long* index, unsigned long mask)
+{
+    if (mask == 0)
+    {
+        return 0;
+    }
+    *index = __builtin_ctzl(mask);
+    return 1;
+}
+
+inline unsigned char _BitScanReverse(unsigned long* index, unsigned long mask)
+{
+    if (mask == 0)
+    {
+        return 0;
+    }
+    *index = sizeof(unsigned long) * 8 - 1 - __builtin_clzl(mask);
+    return 1;
+}
+
+inline unsigned char _BitScanForward64(unsigned long* index, unsigned long long mask)
+{
+    if (mask == 0)
+    {
+        return 0;
+    }
+    *index = __builtin_ctzll(mask);
+    return 1;
+}
+
+inline unsigned char _BitScanReverse64(unsigned long* index, unsigned long long mask)
+{
+    if (mask == 0)
+    {
+        return 0;
+    }
+    *index = 63 - __builtin_clzll(mask);
+    return 1;
+}
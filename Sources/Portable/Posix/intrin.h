@@ -0,0 +1,4 @@
+#pragma once
+
+// The MSVC intrinsics header. The bit scans it declares are in Win32Types.h.
+#include <x86intrin.h>
@@ -0,0 +1,72 @@
+#pragma once
+
+// The precompiled header of the device-independent code in Sources/Utilities when it is built on its own,
+// for the tests, benchmarks and tools. On Windows it takes the real headers, elsewhere the Win32, D3D12 and
+// DirectXMath subsets in Posix/ that the utilities use.
+#ifdef _WIN32
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN             // Exclude rarely-used stuff from Windows headers.
+#endif
+
+#include <windows.h>
+
+#include <d3d12.h>
+#include <DirectXMath.h>
+
+#include <string>
+#include <wrl.h>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <unordered_map>
+
+#include "SharedPrimitives.h"
+#include "SharedConstants.h"
+#include "SharedTypes.h"
+
+#include "Macros.h"
+#include "PathHelper.h"
+
+#else
+
+// The standard headers go first, they do not build with the min and max macros of windows.h.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <queue>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <x86intrin.h>
+
+#include "Win32Types.h"
+#include "D3D12Types.h"
+#include "DirectXMathSubset.h"
+
+#include "SharedPrimitives.h"
+#include "SharedConstants.h"
+#include "SharedTypes.h"
+
+#include "Macros.h"
+#include "PathHelpers.h"
+
+#endif
+
+using std::unique_ptr;
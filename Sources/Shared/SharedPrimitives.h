@@ -3,6 +3,9 @@
 #ifndef SHARED_PRIMITIVES_H
 #define SHARED_PRIMITIVES_H
 
+// Store scene meshes in the PackedVertex layout instead of the Vertex layout.
+#define USE_PACKED_VERTEX 0
+
 #ifdef HLSL
 typedef float FLOAT;
 typedef float2 XMFLOAT2;
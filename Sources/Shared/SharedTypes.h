@@ -25,6 +25,31 @@ struct Vertex
     XMFLOAT4 color;
 };
 
+// Compact layout of Vertex, the color is dropped and is white when decoded.
+// positionOS: xyz as 16-bit snorm in the mesh bounds, w as the sign of the bitangent.
+// normalTangentOS: octahedral encoded normal and tangent as 16-bit snorm pairs.
+// texCoord: uv as two 16-bit floats.
+struct PackedVertex
+{
+    UINT positionOS[2];
+    UINT normalTangentOS[2];
+    UINT texCoord;
+};
+
+#if USE_PACKED_VERTEX
+typedef PackedVertex SceneVertex;
+#else
+typedef Vertex SceneVertex;
+#endif
+
+// Root constants of the draws of a material, laid out as MaterialConstants in Bindless.hlsli.
+// The first texture slot of the material, and the sampler ID of each of its textures.
+struct MaterialConstant
+{
+    UINT TextureID;
+    XMUINT3 SamplerIDs;
+};
+
 struct Ray
 {
     XMFLOAT3 origin;
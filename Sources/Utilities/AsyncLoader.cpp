@@ -0,0 +1,125 @@
+#include "stdafx.h"
+#include "AsyncLoader.h"
+
+AsyncLoader::AsyncLoader(JobSystem* jobSystem) :
+    pJobSystem(jobSystem),
+    exception(nullptr),
+    nextTicket(0),
+    pendingNum(0),
+    runningNum(0),
+    isStopping(FALSE)
+{
+
+}
+
+AsyncLoader::~AsyncLoader()
+{
+    // The tasks that have not started see the loader stopping and return right away.
+    isStopping = TRUE;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    completedCondition.wait(lock, [this]() { return runningNum == 0; });
+}
+
+UINT AsyncLoader::Submit(const std::function<void(UINT thread)>& task)
+{
+    UINT ticket;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ticket = nextTicket++;
+        runningNum++;
+    }
+    pendingNum++;
+
+    pJobSystem->RunBackground([this, ticket, task](UINT thread)
+    {
+        RunTask(thread, ticket, task);
+    });
+
+    return ticket;
+}
+
+UINT AsyncLoader::Poll(std::vector<UINT>& completed, UINT maxCount)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (exception != nullptr)
+    {
+        std::rethrow_exception(exception);
+    }
+
+    UINT count = 0;
+    for (; count < maxCount && !completedTickets.empty(); count++)
+    {
+        completed.push_back(completedTickets.front());
+        completedTickets.pop_front();
+    }
+    pendingNum -= count;
+    committedTickets.insert(committedTickets.end(), completed.end() - count, completed.end());
+
+    return count;
+}
+
+void AsyncLoader::Wait()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    completedCondition.wait(lock, [this]()
+    {
+        return runningNum == 0 || exception != nullptr;
+    });
+}
+
+void AsyncLoader::Retire(UINT64 fenceValue)
+{
+    for (UINT ticket : committedTickets)
+    {
+        RetiredTicket retiredTicket = { ticket, fenceValue };
+        retiredTickets.push_back(retiredTicket);
+    }
+    committedTickets.clear();
+}
+
+UINT AsyncLoader::Release(UINT64 completedFenceValue, std::vector<UINT>& released)
+{
+    UINT count = 0;
+    for (; count < retiredTickets.size() && retiredTickets[count].fenceValue <= completedFenceValue; count++)
+    {
+        released.push_back(retiredTickets[count].ticket);
+    }
+    retiredTickets.erase(retiredTickets.begin(), retiredTickets.begin() + count);
+
+    return count;
+}
+
+// Helper functions.
+void AsyncLoader::RunTask(UINT thread, UINT ticket, const std::function<void(UINT)>& task)
+{
+    // Keep the first exception for the polling thread, and skip the tasks that have not started.
+    std::exception_ptr taskException = nullptr;
+    if (!isStopping)
+    {
+        try
+        {
+            task(thread);
+        }
+        catch (...)
+        {
+            taskException = std::current_exception();
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    runningNum--;
+    if (taskException != nullptr)
+    {
+        if (exception == nullptr)
+        {
+            exception = taskException;
+        }
+        isStopping = TRUE;
+    }
+    else if (!isStopping)
+    {
+        completedTickets.push_back(ticket);
+    }
+    completedCondition.notify_all();
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include "JobSystem.h"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+// Runs load tasks in the background on a JobSystem, and hands back the ticket of every finished task
+// in completion order, so the render loop can commit a few assets per frame without waiting for the rest.
+// The tickets polled by a frame are retired with the fence value it signals, and released once that fence
+// value has completed, when the GPU is done uploading their assets.
+// The loader does not touch D3D, so it also runs without a device. A task gets the thread of the job system
+// it runs on, for the objects that are not thread safe, like the FBX importers of the scene loader.
+class AsyncLoader
+{
+private:
+    struct RetiredTicket
+    {
+        UINT ticket;
+        UINT64 fenceValue;
+    };
+
+    JobSystem* pJobSystem;
+    std::deque<UINT> completedTickets;
+    std::mutex mutex;
+    std::condition_variable completedCondition;
+    std::exception_ptr exception;
+
+    UINT nextTicket;
+    UINT pendingNum;
+    UINT runningNum;
+    std::atomic<BOOL> isStopping;
+
+    // The polling thread's tickets, polled since the last retirement and then waiting for their fence value.
+    std::vector<UINT> committedTickets;
+    std::deque<RetiredTicket> retiredTickets;
+
+    void RunTask(UINT thread, UINT ticket, const std::function<void(UINT)>& task);
+
+public:
+    AsyncLoader(JobSystem* jobSystem);
+    // Skip the tasks that have not started and wait for the running ones.
+    ~AsyncLoader();
+
+    // Queue a task and return its ticket. Tickets count up from 0 in submission order.
+    UINT Submit(const std::function<void(UINT thread)>& task);
+    // Move up to maxCount tickets of finished tasks into completed, and return how many were moved.
+    // An exception thrown by a task is rethrown here, on the polling thread.
+    UINT Poll(std::vector<UINT>& completed, UINT maxCount);
+    // Block until every submitted task has finished, without consuming the tickets.
+    void Wait();
+
+    // Retire the tickets polled since the last retirement, which the GPU is done with at fenceValue.
+    void Retire(UINT64 fenceValue);
+    // Move the tickets whose fence value has completed into released, in the order they were polled,
+    // and return how many were moved.
+    UINT Release(UINT64 completedFenceValue, std::vector<UINT>& released);
+
+    // Tasks that have been submitted but whose tickets have not been polled yet.
+    inline const UINT GetPendingNum() const { return pendingNum; }
+    inline const UINT GetThreadCount() const { return pJobSystem->GetWorkerCount(); }
+};
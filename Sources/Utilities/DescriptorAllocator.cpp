@@ -0,0 +1,92 @@
+#include "stdafx.h"
+#include "DescriptorAllocator.h"
+
+DescriptorAllocator::DescriptorAllocator(UINT inCapacity) :
+    capacity(inCapacity),
+    usedNum(0)
+{
+    if (capacity > 0)
+    {
+        freeRanges[0] = capacity;
+    }
+}
+
+BOOL DescriptorAllocator::Allocate(UINT count, UINT& index)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (auto it = freeRanges.begin(); it != freeRanges.end(); it++)
+    {
+        if (it->second < count)
+        {
+            continue;
+        }
+
+        // Take the start of the range, and keep the rest of it free.
+        index = it->first;
+        if (it->second > count)
+        {
+            freeRanges[index + count] = it->second - count;
+        }
+        freeRanges.erase(it);
+        usedNum += count;
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+void DescriptorAllocator::Free(UINT index, UINT count)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    pendingRanges.push_back({ index, count });
+}
+
+void DescriptorAllocator::Retire(UINT64 fenceValue)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (pendingRanges.empty())
+    {
+        return;
+    }
+
+    retiredBatches.push_back({ fenceValue, std::move(pendingRanges) });
+    pendingRanges.clear();
+}
+
+void DescriptorAllocator::Release(UINT64 completedFenceValue)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    while (!retiredBatches.empty() && retiredBatches.front().fenceValue <= completedFenceValue)
+    {
+        for (const Range& range : retiredBatches.front().ranges)
+        {
+            InsertFreeRange(range.index, range.count);
+            usedNum -= range.count;
+        }
+        retiredBatches.pop_front();
+    }
+}
+
+// Helper functions.
+void DescriptorAllocator::InsertFreeRange(UINT index, UINT count)
+{
+    auto next = freeRanges.lower_bound(index);
+    if (next != freeRanges.begin())
+    {
+        auto previous = std::prev(next);
+        if (previous->first + previous->second == index)
+        {
+            index = previous->first;
+            count += previous->second;
+            freeRanges.erase(previous);
+        }
+    }
+    if (next != freeRanges.end() && index + count == next->first)
+    {
+        count += next->second;
+        freeRanges.erase(next);
+    }
+
+    freeRanges[index] = count;
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <deque>
+#include <map>
+#include <mutex>
+#include <vector>
+
+// Hands out ranges of consecutive descriptors of a heap, first fit from a list of free ranges. It only
+// deals in indices, so it does not own the heap and does no GPU work, and it can be used from any thread.
+// Freed ranges may still be read by the frames in flight. The ranges freed since the last retirement are
+// retired together with the fence value the GPU signals after those frames, and are reused once it has completed.
+class DescriptorAllocator
+{
+private:
+    struct Range
+    {
+        UINT index;
+        UINT count;
+    };
+
+    struct Batch
+    {
+        UINT64 fenceValue;
+        std::vector<Range> ranges;
+    };
+
+    UINT capacity;
+    UINT usedNum;
+    // Free ranges by their first index, the ones that touch are merged.
+    std::map<UINT, UINT> freeRanges;
+    std::vector<Range> pendingRanges;
+    std::deque<Batch> retiredBatches;
+    mutable std::mutex mutex;
+
+    void InsertFreeRange(UINT index, UINT count);
+
+public:
+    DescriptorAllocator(UINT inCapacity);
+
+    // Allocate count consecutive descriptors. Returns FALSE if no free range is large enough.
+    BOOL Allocate(UINT count, UINT& index);
+    // Free a range, which is reused once the batch it is retired with has been released.
+    void Free(UINT index, UINT count);
+    // Close the batch of the ranges freed since the last retirement, which the GPU is done with at fenceValue.
+    void Retire(UINT64 fenceValue);
+    // Reuse the ranges of the batches whose fence value has completed.
+    void Release(UINT64 completedFenceValue);
+
+    inline const UINT GetCapacity() const { return capacity; }
+    // Descriptors allocated, or freed and waiting for the GPU.
+    inline const UINT GetUsedNum() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return usedNum;
+    }
+};
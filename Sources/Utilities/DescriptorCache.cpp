@@ -0,0 +1,61 @@
+#include "stdafx.h"
+#include "DescriptorCache.h"
+
+DescriptorCache::DescriptorCache() :
+    hitsNum(0),
+    missesNum(0)
+{
+
+}
+
+BOOL DescriptorCache::Find(const std::string& key, UINT& index)
+{
+    auto it = indices.find(key);
+    if (it == indices.end())
+    {
+        missesNum++;
+        return FALSE;
+    }
+
+    hitsNum++;
+    index = it->second;
+    return TRUE;
+}
+
+BOOL DescriptorCache::Contains(const std::string& key, UINT index)
+{
+    auto it = keys.find(index);
+    if (it == keys.end() || it->second != key)
+    {
+        missesNum++;
+        return FALSE;
+    }
+
+    hitsNum++;
+    return TRUE;
+}
+
+void DescriptorCache::Insert(const std::string& key, UINT index)
+{
+    Remove(index);
+
+    // A key written to another descriptor is looked up there from now on, the old one keeps it until rewritten.
+    indices[key] = index;
+    keys[index] = key;
+}
+
+void DescriptorCache::Remove(UINT index)
+{
+    auto it = keys.find(index);
+    if (it == keys.end())
+    {
+        return;
+    }
+
+    auto indexIt = indices.find(it->second);
+    if (indexIt != indices.end() && indexIt->second == index)
+    {
+        indices.erase(indexIt);
+    }
+    keys.erase(it);
+}
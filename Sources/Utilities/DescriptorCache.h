@@ -0,0 +1,41 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+
+// Descriptors keyed by the bytes they are created from, such as a sampler description, or a resource
+// and the description of its view. Creating a descriptor that already exists becomes a lookup.
+// It only deals in indices, so it does not own the heap and does no GPU work.
+// Keys are compared byte for byte, so descriptions must be zero initialized for their padding to match.
+class DescriptorCache
+{
+private:
+    std::unordered_map<std::string, UINT> indices;
+    // The key each descriptor holds, to forget it once the descriptor is written with another one.
+    std::unordered_map<UINT, std::string> keys;
+
+    UINT64 hitsNum;
+    UINT64 missesNum;
+
+public:
+    DescriptorCache();
+
+    // Append the bytes of a value to a key.
+    template<typename T>
+    static inline void AppendKey(std::string& key, const T& value)
+    {
+        key.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    // Find the descriptor that holds key, and count a hit or a miss.
+    BOOL Find(const std::string& key, UINT& index);
+    // Whether the descriptor at index holds key, counted as a hit or a miss.
+    BOOL Contains(const std::string& key, UINT index);
+    // The descriptor at index now holds key, in place of what it held before.
+    void Insert(const std::string& key, UINT index);
+    // Forget what the descriptor at index holds.
+    void Remove(UINT index);
+
+    inline const UINT GetSize() const { return static_cast<UINT>(indices.size()); }
+    inline const UINT64 GetHitsNum() const { return hitsNum; }
+    inline const UINT64 GetMissesNum() const { return missesNum; }
+};
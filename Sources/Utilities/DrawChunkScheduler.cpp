@@ -0,0 +1,69 @@
+#include "stdafx.h"
+#include "DrawChunkScheduler.h"
+
+DrawChunkScheduler::DrawChunkScheduler(JobSystem* jobSystem) :
+    pJobSystem(jobSystem)
+{
+
+}
+
+DrawChunkScheduler::~DrawChunkScheduler()
+{
+
+}
+
+void DrawChunkScheduler::Split(
+    const UINT* pCosts,
+    UINT drawsNum,
+    UINT maxChunksNum,
+    UINT64 minChunkCost,
+    std::vector<DrawChunk>& chunks)
+{
+    chunks.clear();
+    if (drawsNum == 0)
+    {
+        return;
+    }
+
+    UINT64 totalCost = 0;
+    for (UINT i = 0; i < drawsNum; i++)
+    {
+        totalCost += pCosts[i];
+    }
+
+    UINT64 count = minChunkCost > 0 ? totalCost / minChunkCost : drawsNum;
+    count = max(min(count, static_cast<UINT64>(min(maxChunksNum, drawsNum))), 1ull);
+    const UINT splitsNum = static_cast<UINT>(count);
+
+    // End each chunk where the cost so far reaches its share of the total, so rounding does not pile up on
+    // the last chunk, and leave at least one draw for each of the chunks after it.
+    UINT64 cost = 0;
+    UINT begin = 0;
+    for (UINT i = 0; i < splitsNum; i++)
+    {
+        const UINT64 targetCost = totalCost * (i + 1) / splitsNum;
+        const UINT lastEnd = i + 1 == splitsNum ? drawsNum : drawsNum - (splitsNum - i - 1);
+        UINT end = begin;
+        do
+        {
+            cost += pCosts[end++];
+        } while (end < lastEnd && (cost < targetCost || i + 1 == splitsNum));
+
+        DrawChunk chunk = { begin, end };
+        chunks.push_back(chunk);
+        begin = end;
+    }
+}
+
+void DrawChunkScheduler::Run(UINT chunksNum, const std::function<void(UINT thread, UINT chunk)>& task)
+{
+    // The chunks already balance the cost, and are fewer than the ranges ParallelFor makes, so each one is a
+    // range of its own.
+    pJobSystem->ParallelFor(chunksNum, 1, [&task](UINT thread, UINT begin, UINT end)
+    {
+        for (UINT i = begin; i < end; i++)
+        {
+            task(thread, i);
+        }
+    });
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include "JobSystem.h"
+#include <functional>
+#include <vector>
+
+// A run of draws, from begin up to but not including end, recorded into one command list.
+struct DrawChunk
+{
+    UINT begin;
+    UINT end;
+};
+
+// Splits the draws of a pass into chunks of about the same recording cost, and records them on the threads
+// of a JobSystem, so recording shares the threads of the frame rather than adding more. Chunks are handed
+// out as jobs that idle threads steal, and each one is recorded into a command list of its own that is
+// submitted in chunk order, so the draws keep their order however the threads interleave.
+// It only deals in draw indices and costs, so it records no GPU work and can be used without a device.
+class DrawChunkScheduler
+{
+private:
+    JobSystem* pJobSystem;
+
+public:
+    DrawChunkScheduler(JobSystem* jobSystem);
+    ~DrawChunkScheduler();
+
+    // Split the draws, in order, into up to maxChunksNum chunks of about the same cost. No chunk costs less
+    // than minChunkCost, unless all the draws together do.
+    static void Split(const UINT* pCosts, UINT drawsNum, UINT maxChunksNum, UINT64 minChunkCost,
+        std::vector<DrawChunk>& chunks);
+
+    // Call the task once for every chunk below chunksNum, with the thread of the job system it runs on, and
+    // return when all of them are done. The calling thread, which must be one of the job system or runs
+    // every chunk itself as thread 0, runs chunks too. An exception thrown by a task is rethrown here, after
+    // the other chunks that started have finished.
+    void Run(UINT chunksNum, const std::function<void(UINT thread, UINT chunk)>& task);
+
+    inline const UINT GetThreadCount() const { return pJobSystem->GetThreadCount(); }
+};
@@ -0,0 +1,66 @@
+#include "stdafx.h"
+#include "FBXImportPool.h"
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+FBXImportPool::FBXImportPool(UINT count) :
+    threadCount(count)
+{
+    if (threadCount == 0)
+    {
+        threadCount = max(std::thread::hardware_concurrency(), 1u);
+    }
+}
+
+FBXImportPool::~FBXImportPool()
+{
+
+}
+
+void FBXImportPool::Run(UINT taskCount, const std::function<void(unique_ptr<FBXImporter>&, UINT)>& task)
+{
+    std::atomic<UINT> nextTask(0);
+    std::exception_ptr exception = nullptr;
+    std::mutex exceptionMutex;
+
+    // Tasks are handed out one at a time so that a few large models do not stall a whole thread's share.
+    auto worker = [&]()
+    {
+        unique_ptr<FBXImporter> importer = std::make_unique<FBXImporter>();
+        importer->InitializeSdkObjects();
+
+        for (UINT i = nextTask++; i < taskCount; i = nextTask++)
+        {
+            try
+            {
+                task(importer, i);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(exceptionMutex);
+                if (exception == nullptr)
+                {
+                    exception = std::current_exception();
+                }
+                nextTask = taskCount;
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    UINT workersNum = min(threadCount, taskCount);
+    for (UINT i = 0; i < workersNum; i++)
+    {
+        workers.emplace_back(worker);
+    }
+    for (std::thread& thread : workers)
+    {
+        thread.join();
+    }
+
+    if (exception != nullptr)
+    {
+        std::rethrow_exception(exception);
+    }
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include "FBXImporter.h"
+#include <functional>
+
+// Number of import threads, 0 uses one per hardware thread.
+#define FBX_IMPORT_THREAD_COUNT 0
+
+// Runs import tasks on worker threads. The FBX SDK objects are not thread safe,
+// so every worker owns an FBXImporter and with it an FbxManager and an FbxScene.
+class FBXImportPool
+{
+private:
+    UINT threadCount;
+
+public:
+    FBXImportPool(UINT count = FBX_IMPORT_THREAD_COUNT);
+    ~FBXImportPool();
+
+    // Call the task once for every index below taskCount and return when all of them are done.
+    // An exception thrown by a task is rethrown here after the workers have joined.
+    void Run(UINT taskCount, const std::function<void(unique_ptr<FBXImporter>&, UINT)>& task);
+
+    inline const UINT GetThreadCount() const { return threadCount; }
+};
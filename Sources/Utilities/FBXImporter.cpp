@@ -1,6 +1,12 @@
 #include "stdafx.h"
 #include "FBXImporter.h"
+#include "MappedFile.h"
+#include "MeshOptimizer.h"
+#include "MeshletBuilder.h"
+#include "MeshSimplifier.h"
 #include <stdlib.h>
+#include <chrono>
+#include <emmintrin.h>
 
 #ifdef IOS_REF
 #undef  IOS_REF
@@ -50,11 +56,8 @@ void FBXImporter::InitializeSdkObjects()
 
 bool FBXImporter::ImportFBX(std::wstring path)
 {
-    char filePath[100];
-    size_t count = 0;
-    wcstombs_s(&count, filePath, 100, path.c_str(), path.length());
-
-    FbxString lfilePath(filePath);
+    // The FBX SDK takes UTF-8 file names on every platform.
+    FbxString lfilePath(MappedFile::ToUTF8(path).c_str());
 	if (lfilePath.IsEmpty())
 	{
         return false;
@@ -203,14 +206,156 @@ bool FBXImporter::ImportFBX(std::wstring path)
     return lStatus;
 }
 
-void FBXImporter::LoadFBX(D3D12Mesh* mesh)
+void FBXImporter::LoadFBX(MeshData* mesh)
 {
     FbxGeometryConverter converter(m_fbxManager);
     converter.Triangulate(m_fbxScene, true);
+
+    m_vertices.clear();
+    m_indices.clear();
     LoadContent(m_fbxScene, mesh);
+
+    if (m_vertices.size() == 0 || m_indices.size() == 0)
+    {
+        return;
+    }
+
+    OptimizeMesh(mesh);
+    mesh->SetUVDensity(ComputeUVDensity());
+
+    // The LOD indices are appended after LOD 0, so the counts below are of LOD 0 only.
+    UINT indicesNum = static_cast<UINT>(m_indices.size());
+    std::vector<D3D12MeshLod> lods;
+    GenerateLods(lods);
+
+    // Use 16-bit indices unless the welded vertices are out of their range.
+    UINT indexStride = sizeof(UINT);
+    if (m_vertices.size() <= 0x10000)
+    {
+        std::vector<UINT16> indices(m_indices.begin(), m_indices.end());
+        mesh->SetIndices(indices.data(), static_cast<UINT>(indices.size() * sizeof(UINT16)));
+        indexStride = sizeof(UINT16);
+    }
+    else
+    {
+        mesh->SetIndices(m_indices.data(), static_cast<UINT>(m_indices.size() * sizeof(UINT)));
+    }
+    mesh->SetLods(lods.data(), static_cast<UINT>(lods.size()));
+    mesh->SetVertices(m_vertices.data(), static_cast<UINT>(m_vertices.size() * sizeof(Vertex)));
+
+    // Report the memory saved against one vertex and one 16-bit index per corner.
+    UINT unweldedSize = static_cast<UINT>(indicesNum * (sizeof(Vertex) + sizeof(UINT16)));
+    UINT weldedSize = static_cast<UINT>(m_vertices.size() * sizeof(Vertex) + indicesNum * indexStride);
+    FBXSDK_printf("Welded %u corners into %u vertices with %u-bit indices, saved %u KB.\n",
+        indicesNum, static_cast<UINT>(m_vertices.size()), indexStride * 8,
+        unweldedSize > weldedSize ? (unweldedSize - weldedSize) / 1024 : 0);
+
+    MeshletBuilder::BuildMeshlets(mesh);
+    const std::vector<D3D12Meshlet>& meshlets = mesh->GetMeshlets();
+    if (meshlets.size() > 0)
+    {
+        FBXSDK_printf("Built %u meshlets with %.1f vertices and %.1f triangles on average.\n",
+            static_cast<UINT>(meshlets.size()),
+            static_cast<float>(mesh->GetMeshletVertices().size()) / meshlets.size(),
+            static_cast<float>(mesh->GetMeshletTriangles().size()) / meshlets.size());
+    }
 }
 
-void FBXImporter::LoadContent(FbxScene* pScene, D3D12Mesh* mesh)
+void FBXImporter::OptimizeMesh(MeshData* mesh)
+{
+    VertexCacheStatistics before = MeshOptimizer::AnalyzeVertexCache(m_indices.data(),
+        static_cast<UINT>(m_indices.size()), static_cast<UINT>(m_vertices.size()));
+
+    // Optimize each submesh on its own so that the submesh ranges stay valid.
+    for (const D3D12Submesh& submesh : mesh->GetSubmeshes())
+    {
+        UINT* pIndices = m_indices.data() + submesh.indexStart;
+        Vertex* pVertices = m_vertices.data() + submesh.vertexStart;
+        for (UINT i = 0; i < submesh.indicesNum; i++)
+        {
+            pIndices[i] -= submesh.vertexStart;
+        }
+
+        MeshOptimizer::OptimizeVertexCache(pIndices, submesh.indicesNum, submesh.verticesNum);
+        MeshOptimizer::OptimizeOverdraw(pIndices, submesh.indicesNum, pVertices, submesh.verticesNum, OVERDRAW_THRESHOLD);
+        // Welded vertices are all referenced, so no vertex is dropped here.
+        MeshOptimizer::OptimizeVertexFetch(pVertices, pIndices, submesh.indicesNum, submesh.verticesNum);
+
+        for (UINT i = 0; i < submesh.indicesNum; i++)
+        {
+            pIndices[i] += submesh.vertexStart;
+        }
+    }
+
+    VertexCacheStatistics after = MeshOptimizer::AnalyzeVertexCache(m_indices.data(),
+        static_cast<UINT>(m_indices.size()), static_cast<UINT>(m_vertices.size()));
+    FBXSDK_printf("Optimized the vertex cache, ACMR %.3f -> %.3f, ATVR %.3f -> %.3f.\n",
+        before.acmr, after.acmr, before.atvr, after.atvr);
+}
+
+void FBXImporter::GenerateLods(std::vector<D3D12MeshLod>& lods)
+{
+    const UINT verticesNum = static_cast<UINT>(m_vertices.size());
+    const UINT sourceIndicesNum = static_cast<UINT>(m_indices.size());
+    const FLOAT ratios[] = MESH_LOD_RATIOS;
+
+    lods.push_back(D3D12MeshLod{ 0, sourceIndicesNum, 0.0f });
+
+    std::vector<UINT> indices;
+    for (FLOAT ratio : ratios)
+    {
+        const D3D12MeshLod previous = lods.back();
+        UINT targetIndicesNum = static_cast<UINT>(sourceIndicesNum / 3 * ratio) * 3;
+        if (targetIndicesNum >= previous.indicesNum)
+        {
+            continue;
+        }
+
+        // Simplify the LOD before, and add up the errors to bound the deviation from LOD 0.
+        FLOAT error = MeshSimplifier::Simplify(m_vertices.data(), verticesNum,
+            m_indices.data() + previous.indexStart, previous.indicesNum, targetIndicesNum, indices);
+        if (indices.empty() || indices.size() > previous.indicesNum * (1.0f - MESH_LOD_MIN_REDUCTION))
+        {
+            break;
+        }
+
+        MeshOptimizer::OptimizeVertexCache(indices.data(), static_cast<UINT>(indices.size()), verticesNum);
+
+        D3D12MeshLod lod = { static_cast<UINT>(m_indices.size()), static_cast<UINT>(indices.size()), previous.error + error };
+        m_indices.insert(m_indices.end(), indices.begin(), indices.end());
+        lods.push_back(lod);
+
+        FBXSDK_printf("Generated LOD %u with %u triangles, %.1f%% of LOD 0, error %f.\n",
+            static_cast<UINT>(lods.size() - 1), lod.indicesNum / 3,
+            100.0f * lod.indicesNum / sourceIndicesNum, lod.error);
+    }
+}
+
+FLOAT FBXImporter::ComputeUVDensity() const
+{
+    double uvArea = 0.0;
+    double area = 0.0;
+    for (UINT i = 0; i + 2 < m_indices.size(); i += 3)
+    {
+        const Vertex& v0 = m_vertices[m_indices[i]];
+        const Vertex& v1 = m_vertices[m_indices[i + 1]];
+        const Vertex& v2 = m_vertices[m_indices[i + 2]];
+
+        XMVECTOR p0 = XMLoadFloat3(&v0.positionOS);
+        XMVECTOR edge = XMVector3Cross(XMLoadFloat3(&v1.positionOS) - p0, XMLoadFloat3(&v2.positionOS) - p0);
+        area += XMVectorGetX(XMVector3Length(edge)) * 0.5;
+
+        FLOAT u1 = v1.texCoord.x - v0.texCoord.x;
+        FLOAT w1 = v1.texCoord.y - v0.texCoord.y;
+        FLOAT u2 = v2.texCoord.x - v0.texCoord.x;
+        FLOAT w2 = v2.texCoord.y - v0.texCoord.y;
+        uvArea += fabsf(u1 * w2 - u2 * w1) * 0.5;
+    }
+
+    return area > 0.0 && uvArea > 0.0 ? static_cast<FLOAT>(sqrt(uvArea / area)) : 0.0f;
+}
+
+void FBXImporter::LoadContent(FbxScene* pScene, MeshData* mesh)
 {
     int i;
     FbxNode* lNode = pScene->GetRootNode();
@@ -224,7 +369,7 @@ void FBXImporter::LoadContent(FbxScene* pScene, D3D12Mesh* mesh)
     }
 }
 
-void FBXImporter::LoadContent(FbxNode* pNode, D3D12Mesh* mesh)
+void FBXImporter::LoadContent(FbxNode* pNode, MeshData* mesh)
 {
     FbxNodeAttribute::EType lAttributeType;
     int i;
@@ -254,163 +399,190 @@ void FBXImporter::LoadContent(FbxNode* pNode, D3D12Mesh* mesh)
     }
 }
 
-void FBXImporter::LoadMesh(FbxNode* pNode, D3D12Mesh* mesh)
+void FBXImporter::ConvertToFloat(const double* pSource, FLOAT* pDestination, UINT count)
+{
+    UINT i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 low = _mm_cvtpd_ps(_mm_loadu_pd(pSource + i));
+        __m128 high = _mm_cvtpd_ps(_mm_loadu_pd(pSource + i + 2));
+        _mm_storeu_ps(pDestination + i, _mm_movelh_ps(low, high));
+    }
+    for (; i < count; i++)
+    {
+        pDestination[i] = static_cast<FLOAT>(pSource[i]);
+    }
+}
+
+template <typename T>
+BOOL FBXImporter::GatherLayer(FbxLayerElementTemplate<T>* pElement, UINT componentsNum,
+    FLOAT* pDestination, UINT destinationStride)
+{
+    if (pElement == nullptr)
+    {
+        return FALSE;
+    }
+
+    const FbxLayerElement::EMappingMode mappingMode = pElement->GetMappingMode();
+    const FbxLayerElement::EReferenceMode referenceMode = pElement->GetReferenceMode();
+    if ((mappingMode != FbxLayerElement::eByControlPoint
+            && mappingMode != FbxLayerElement::eByPolygonVertex
+            && mappingMode != FbxLayerElement::eByPolygon
+            && mappingMode != FbxLayerElement::eAllSame)
+        || (referenceMode != FbxLayerElement::eDirect && referenceMode != FbxLayerElement::eIndexToDirect))
+    {
+        return FALSE;
+    }
+
+    // The direct array holds FbxVector2 or FbxVector4 elements, which are plain arrays of doubles.
+    const UINT elementSize = sizeof(T) / sizeof(double);
+    FbxLayerElementArrayTemplate<T>& directArray = pElement->GetDirectArray();
+    const UINT directNum = static_cast<UINT>(directArray.GetCount());
+    m_layerData.resize(directNum * elementSize);
+    T* pDirect = static_cast<T*>(directArray.GetLocked(FbxLayerElementArray::eReadLock));
+    if (pDirect == nullptr)
+    {
+        return FALSE;
+    }
+    ConvertToFloat(reinterpret_cast<const double*>(pDirect), m_layerData.data(), directNum * elementSize);
+    directArray.Release(reinterpret_cast<void**>(&pDirect));
+
+    int* pIndices = nullptr;
+    UINT indicesNum = 0;
+    if (referenceMode == FbxLayerElement::eIndexToDirect)
+    {
+        pIndices = static_cast<int*>(pElement->GetIndexArray().GetLocked(FbxLayerElementArray::eReadLock));
+        indicesNum = static_cast<UINT>(pElement->GetIndexArray().GetCount());
+    }
+
+    const UINT cornersNum = static_cast<UINT>(m_cornerControlPoints.size());
+    for (UINT i = 0; i < cornersNum; i++)
+    {
+        UINT id = mappingMode == FbxLayerElement::eByControlPoint ? static_cast<UINT>(m_cornerControlPoints[i])
+            : mappingMode == FbxLayerElement::eByPolygonVertex ? i
+            : mappingMode == FbxLayerElement::eByPolygon ? static_cast<UINT>(m_cornerPolygons[i])
+            : 0;
+        if (pIndices != nullptr)
+        {
+            id = id < indicesNum ? static_cast<UINT>(pIndices[id]) : UINT_MAX;
+        }
+
+        // Broken references leave the corner zeroed.
+        if (id < directNum)
+        {
+            memcpy(pDestination + i * destinationStride, m_layerData.data() + id * elementSize, componentsNum * sizeof(FLOAT));
+        }
+    }
+
+    if (pIndices != nullptr)
+    {
+        pElement->GetIndexArray().Release(reinterpret_cast<void**>(&pIndices));
+    }
+
+    return TRUE;
+}
+
+void FBXImporter::LoadMesh(FbxNode* pNode, MeshData* mesh)
 {
     FbxMesh* lMesh = (FbxMesh*)pNode->GetNodeAttribute();
-    UINT polygonSize = lMesh->GetPolygonCount();
+    auto start = std::chrono::high_resolution_clock::now();
+
+    // Gather the control point and the polygon of every corner in one pass over the polygons.
+    const int* pPolygonVertices = lMesh->GetPolygonVertices();
+    const UINT cornersNum = static_cast<UINT>(lMesh->GetPolygonVertexCount());
+    const UINT polygonsNum = static_cast<UINT>(lMesh->GetPolygonCount());
+    m_cornerControlPoints.assign(pPolygonVertices, pPolygonVertices + cornersNum);
+    m_cornerPolygons.resize(cornersNum);
+    for (UINT i = 0; i < polygonsNum; i++)
+    {
+        UINT polygonStart = static_cast<UINT>(lMesh->GetPolygonVertexIndex(i));
+        UINT polygonSize = static_cast<UINT>(lMesh->GetPolygonSize(i));
+        for (UINT j = 0; j < polygonSize; j++)
+        {
+            m_cornerPolygons[polygonStart + j] = i;
+        }
+    }
 
-    UINT indicesSize = polygonSize * 3 * sizeof(UINT16);
-    UINT16* pIndex = (UINT16*)malloc(indicesSize);
-    UINT16* iIndex = pIndex;
+    // Fill in the layers the file does not have, tangents need the UVs.
+    if (lMesh->GetElementNormal(0) == nullptr)
+    {
+        lMesh->GenerateNormals();
+    }
+    if (lMesh->GetElementTangent(0) == nullptr && lMesh->GetElementUV(0) != nullptr)
+    {
+        lMesh->GenerateTangentsData(0);
+    }
 
-    int lControlPointsCount = lMesh->GetControlPointsCount();
-    UINT verticesSize = polygonSize * 3 * sizeof(Vertex);
-    fbxsdk::FbxVector4* lControlPoints = lMesh->GetControlPoints();
+    // Attributes of each corner, in a stream per attribute.
+    std::vector<XMFLOAT3> positions(cornersNum, XMFLOAT3{ 0.0f, 0.0f, 0.0f });
+    std::vector<XMFLOAT3> normals(cornersNum, XMFLOAT3{ 0.0f, 0.0f, 1.0f });
+    std::vector<XMFLOAT4> tangents(cornersNum, XMFLOAT4{ 0.0f, 0.0f, 0.0f, 0.0f });
+    std::vector<XMFLOAT2> texCoords(cornersNum, XMFLOAT2{ 0.0f, 0.0f });
 
-    Vertex* pVertex = (Vertex*)malloc(verticesSize);
-    Vertex* iVertex = pVertex;
+    const UINT controlPointsNum = static_cast<UINT>(lMesh->GetControlPointsCount());
+    m_layerData.resize(controlPointsNum * 4);
+    ConvertToFloat(reinterpret_cast<const double*>(lMesh->GetControlPoints()), m_layerData.data(), controlPointsNum * 4);
+    for (UINT i = 0; i < cornersNum; i++)
+    {
+        UINT cpIndex = static_cast<UINT>(m_cornerControlPoints[i]);
+        if (cpIndex < controlPointsNum)
+        {
+            memcpy(&positions[i], m_layerData.data() + cpIndex * 4, sizeof(XMFLOAT3));
+        }
+    }
 
-    UINT index = 0;
-    fbxsdk::FbxVector4 pNormal;
-    if (pIndex && pVertex)
+    GatherLayer(lMesh->GetElementNormal(0), 3, reinterpret_cast<FLOAT*>(normals.data()), 3);
+    GatherLayer(lMesh->GetElementUV(0), 2, reinterpret_cast<FLOAT*>(texCoords.data()), 2);
+    if (!GatherLayer(lMesh->GetElementTangent(0), 4, reinterpret_cast<FLOAT*>(tangents.data()), 4))
     {
-        for (int i = 0; i < polygonSize; i++)
+        // Without tangents any direction perpendicular to the normal keeps the tangent frame valid.
+        for (UINT i = 0; i < cornersNum; i++)
         {
-            for (int j = 0; j < lMesh->GetPolygonSize(i); j++)
-            {
-                *(iIndex++) = i * 3 + j;
-                int cpIndex = lMesh->GetPolygonVertex(i, j);
-                iVertex->positionOS = XMFLOAT3
-                {
-                    static_cast<float>(lControlPoints[cpIndex].mData[0]),
-                    static_cast<float>(lControlPoints[cpIndex].mData[1]),
-                    static_cast<float>(lControlPoints[cpIndex].mData[2]),
-                };
-
-                FbxGeometryElementNormal* leNormal = lMesh->GetElementNormal(0);
-                switch (leNormal->GetReferenceMode())
-                {
-                case FbxGeometryElement::eDirect:
-                    lMesh->GetPolygonVertexNormal(i, j, pNormal);
-                    iVertex->normalOS = XMFLOAT3
-                    {
-                        static_cast<float>(pNormal.mData[0]),
-                        static_cast<float>(pNormal.mData[1]),
-                        static_cast<float>(pNormal.mData[2]),
-                    };
-                    break;
-                case FbxGeometryElement::eIndexToDirect:
-                {
-                    int id = leNormal->GetIndexArray().GetAt(cpIndex);
-                    iVertex->normalOS = XMFLOAT3
-                    {
-                        static_cast<float>(leNormal->GetDirectArray().GetAt(id).mData[0]),
-                        static_cast<float>(leNormal->GetDirectArray().GetAt(id).mData[1]),
-                        static_cast<float>(leNormal->GetDirectArray().GetAt(id).mData[2]),
-                    };
-                }
-                break;
-                default:
-                    break; // other reference modes not shown here!
-                }
-
-                FbxGeometryElementTangent* leTangent = lMesh->GetElementTangent(0);
-                switch (leTangent->GetReferenceMode())
-                {
-                case FbxGeometryElement::eDirect:
-                    iVertex->tangentOS = XMFLOAT4
-                    {
-                        static_cast<float>(leTangent->GetDirectArray().GetAt(index).mData[0]),
-                        static_cast<float>(leTangent->GetDirectArray().GetAt(index).mData[1]),
-                        static_cast<float>(leTangent->GetDirectArray().GetAt(index).mData[2]),
-                        static_cast<float>(leTangent->GetDirectArray().GetAt(index).mData[3]),
-                    };
-                    break;
-                case FbxGeometryElement::eIndexToDirect:
-                {
-                    int id = leTangent->GetIndexArray().GetAt(index);
-                    iVertex->tangentOS = XMFLOAT4
-                    {
-                        static_cast<float>(leTangent->GetDirectArray().GetAt(id).mData[0]),
-                        static_cast<float>(leTangent->GetDirectArray().GetAt(id).mData[1]),
-                        static_cast<float>(leTangent->GetDirectArray().GetAt(id).mData[2]),
-                        static_cast<float>(leTangent->GetDirectArray().GetAt(id).mData[3]),
-                    };
-                }
-                break;
-                default:
-                    break; // other reference modes not shown here!
-                }
-
-                FbxGeometryElementUV* leUV = lMesh->GetElementUV(0);
-                switch (leUV->GetMappingMode())
-                {
-                default:
-                    break;
-                case FbxGeometryElement::eByControlPoint:
-                    switch (leUV->GetReferenceMode())
-                    {
-                    case FbxGeometryElement::eDirect:
-                        iVertex->texCoord = XMFLOAT2
-                        {
-                            static_cast<float>(leUV->GetDirectArray().GetAt(index).mData[0]),
-                            static_cast<float>(leUV->GetDirectArray().GetAt(index).mData[1]),
-                        };
-                        break;
-                    case FbxGeometryElement::eIndexToDirect:
-                    {
-                        int id = leUV->GetIndexArray().GetAt(index);
-                        iVertex->texCoord = XMFLOAT2
-                        {
-                            static_cast<float>(leUV->GetDirectArray().GetAt(id).mData[0]),
-                            static_cast<float>(leUV->GetDirectArray().GetAt(id).mData[1]),
-                        };
-                    }
-                    break;
-                    default:
-                        break; // other reference modes not shown here!
-                    }
-                    break;
-
-                case FbxGeometryElement::eByPolygonVertex:
-                {
-                    int lTextureUVIndex = lMesh->GetTextureUVIndex(i, j);
-                    switch (leUV->GetReferenceMode())
-                    {
-                    case FbxGeometryElement::eDirect:
-                    case FbxGeometryElement::eIndexToDirect:
-                    {
-                        iVertex->texCoord = XMFLOAT2
-                        {
-                            static_cast<float>(leUV->GetDirectArray().GetAt(lTextureUVIndex).mData[0]),
-                            static_cast<float>(leUV->GetDirectArray().GetAt(lTextureUVIndex).mData[1]),
-                        };
-                    }
-                    break;
-                    default:
-                        break; // other reference modes not shown here!
-                    }
-                }
-                break;
-
-                case FbxGeometryElement::eByPolygon: // doesn't make much sense for UVs
-                case FbxGeometryElement::eAllSame:   // doesn't make much sense for UVs
-                case FbxGeometryElement::eNone:       // doesn't make much sense for UVs
-                    break;
-                }
-
-                (iVertex++)->color = XMFLOAT4
-                {
-                    1, 1, 1, 1
-                };
-                index++;
-            }
+            XMVECTOR normal = XMLoadFloat3(&normals[i]);
+            XMVECTOR axis = fabsf(normals[i].y) < 0.99f ? XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f) : XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f);
+            XMStoreFloat4(&tangents[i], XMVectorSetW(XMVector3Normalize(XMVector3Cross(axis, normal)), 1.0f));
         }
+    }
+
+    std::chrono::duration<double, std::milli> extractDuration = std::chrono::high_resolution_clock::now() - start;
 
-        mesh->SetIndices(pIndex, indicesSize);
-        mesh->SetVertices(pVertex, verticesSize);
+    // Append this node after the geometry of the nodes loaded before it.
+    D3D12Submesh submesh;
+    submesh.indexStart = static_cast<UINT>(m_indices.size());
+    submesh.indicesNum = cornersNum;
+    submesh.vertexStart = static_cast<UINT>(m_vertices.size());
+    submesh.verticesNum = 0;
 
-        delete pIndex;
-        delete pVertex;
+    m_indices.reserve(submesh.indexStart + cornersNum);
+    m_vertices.reserve(submesh.vertexStart + controlPointsNum);
+
+    // Interleave the corners, and weld the ones with identical attributes into one shared vertex.
+    std::unordered_map<Vertex, UINT, VertexHasher, VertexEqual> weldedVertices;
+    weldedVertices.reserve(controlPointsNum);
+    for (UINT i = 0; i < cornersNum; i++)
+    {
+        Vertex vertex = {};
+        vertex.positionOS = positions[i];
+        vertex.normalOS = normals[i];
+        vertex.tangentOS = tangents[i];
+        vertex.texCoord = texCoords[i];
+        vertex.color = XMFLOAT4{ 1, 1, 1, 1 };
+
+        auto it = weldedVertices.find(vertex);
+        if (it == weldedVertices.end())
+        {
+            it = weldedVertices.emplace(vertex, static_cast<UINT>(m_vertices.size())).first;
+            m_vertices.push_back(vertex);
+        }
+        m_indices.push_back(it->second);
     }
+
+    submesh.verticesNum = static_cast<UINT>(m_vertices.size()) - submesh.vertexStart;
+    mesh->AddSubmesh(submesh);
+
+    std::chrono::duration<double, std::milli> duration = std::chrono::high_resolution_clock::now() - start;
+    FBXSDK_printf("Extracted %u corners of %s in %.2f ms, %.2f M corners/s, welded them in %.2f ms.\n",
+        cornersNum, pNode->GetName(), extractDuration.count(),
+        extractDuration.count() > 0.0 ? cornersNum / extractDuration.count() / 1000.0 : 0.0,
+        duration.count() - extractDuration.count());
 }
@@ -1,10 +1,33 @@
 #pragma once
 #include <fbxsdk.h>
-#include "D3D12Mesh.h"
+#include "MeshData.h"
 
 using namespace std;
 using namespace fbxsdk;
 
+// Hashes the raw bytes of a vertex so identical corners can be welded.
+struct VertexHasher
+{
+    size_t operator()(const Vertex& vertex) const
+    {
+        const BYTE* pData = reinterpret_cast<const BYTE*>(&vertex);
+        size_t hash = 14695981039346656037ULL;
+        for (UINT i = 0; i < sizeof(Vertex); i++)
+        {
+            hash = (hash ^ pData[i]) * 1099511628211ULL;
+        }
+        return hash;
+    }
+};
+
+struct VertexEqual
+{
+    bool operator()(const Vertex& a, const Vertex& b) const
+    {
+        return memcmp(&a, &b, sizeof(Vertex)) == 0;
+    }
+};
+
 class FBXImporter
 {
 public:
@@ -12,15 +35,40 @@ public:
     ~FBXImporter();
     void InitializeSdkObjects();
     bool ImportFBX(std::wstring path);
-    void LoadFBX(D3D12Mesh* mesh);
-    void LoadContent(FbxScene* pScene, D3D12Mesh* mesh);
-    void LoadContent(FbxNode* pNode, D3D12Mesh* mesh);
+    void LoadFBX(MeshData* mesh);
+    void LoadContent(FbxScene* pScene, MeshData* mesh);
+    void LoadContent(FbxNode* pNode, MeshData* mesh);
 
     // Mesh
-    void LoadMesh(FbxNode* pNode, D3D12Mesh* mesh);
+    void LoadMesh(FbxNode* pNode, MeshData* mesh);
 
 private:
+    void OptimizeMesh(MeshData* mesh);
+    void GenerateLods(std::vector<D3D12MeshLod>& lods);
+    // Square root of the UV area over the object space area of the triangles, 0 if either is empty.
+    FLOAT ComputeUVDensity() const;
+
+    // Convert doubles to floats with SSE2, four at a time.
+    static void ConvertToFloat(const double* pSource, FLOAT* pDestination, UINT count);
+
+    // Resolve the mapping and reference modes of a layer element once, and gather its
+    // components of every corner into a stream with the given stride in floats.
+    // Returns false if the layer is missing or its mapping is not supported.
+    template <typename T>
+    BOOL GatherLayer(FbxLayerElementTemplate<T>* pElement, UINT componentsNum,
+        FLOAT* pDestination, UINT destinationStride);
+
     // FBX SDK objects
     FbxManager* m_fbxManager = nullptr;
     FbxScene* m_fbxScene = nullptr;
+
+    // Geometry of all mesh nodes in the scene, gathered before filling the mesh.
+    std::vector<Vertex> m_vertices;
+    std::vector<UINT> m_indices;
+
+    // The control point and the polygon of every corner of the mesh that is being loaded,
+    // and the floats of the layer that is being gathered.
+    std::vector<int> m_cornerControlPoints;
+    std::vector<int> m_cornerPolygons;
+    std::vector<FLOAT> m_layerData;
 };
\ No newline at end of file
@@ -0,0 +1,38 @@
+#include "stdafx.h"
+#include "FrameRing.h"
+
+FrameRing::FrameRing(UINT framesNum) :
+    fenceValues(max(framesNum, 1u), 0),
+    frameIndex(0),
+    lastFenceValue(0)
+{
+
+}
+
+BOOL FrameRing::EndFrame(UINT64 fenceValue)
+{
+    if (fenceValue <= lastFenceValue)
+    {
+        return FALSE;
+    }
+
+    fenceValues[frameIndex] = fenceValue;
+    lastFenceValue = fenceValue;
+    frameIndex = (frameIndex + 1) % fenceValues.size();
+
+    return TRUE;
+}
+
+UINT FrameRing::GetFramesInFlight(UINT64 completedFenceValue) const
+{
+    UINT framesInFlight = 0;
+    for (UINT64 fenceValue : fenceValues)
+    {
+        if (fenceValue > completedFenceValue)
+        {
+            framesInFlight++;
+        }
+    }
+
+    return framesInFlight;
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <vector>
+
+// The frames the CPU records ahead of the GPU. Each frame writes the per-frame resources of one slot, such
+// as a command allocator, and takes the slots in turn, so it reuses the ones of the frame framesNum frames
+// before it once the GPU has reached the fence value that frame signaled.
+// It only deals in fence values, so it does no GPU work and can be used without a device.
+class FrameRing
+{
+private:
+    // The fence value the last frame of each slot signaled, 0 while the slot is unused.
+    std::vector<UINT64> fenceValues;
+    UINT frameIndex;
+    UINT64 lastFenceValue;
+
+public:
+    FrameRing(UINT framesNum);
+
+    // End the current frame, which the GPU is done with at fenceValue, and move on to the slot of the next.
+    // Returns FALSE if fenceValue is not past the one of the last frame.
+    BOOL EndFrame(UINT64 fenceValue);
+    // Whether the GPU is done with the last frame of the current slot, so its resources can be written.
+    inline const BOOL IsFrameReady(UINT64 completedFenceValue) const
+    {
+        return fenceValues[frameIndex] <= completedFenceValue;
+    }
+    // Frames that have ended and that the GPU has not finished.
+    UINT GetFramesInFlight(UINT64 completedFenceValue) const;
+
+    inline const UINT GetFrameIndex() const { return frameIndex; }
+    inline const UINT GetFramesNum() const { return static_cast<UINT>(fenceValues.size()); }
+    // The fence value to wait for before the current frame writes the resources of its slot.
+    inline const UINT64 GetWaitFenceValue() const { return fenceValues[frameIndex]; }
+};
@@ -0,0 +1,54 @@
+#include "stdafx.h"
+#include "ImageDecoder.h"
+#include "PNGDecoder.h"
+#include <atomic>
+#include <thread>
+
+static const PNGDecoder kPNGDecoder;
+
+const ImageDecoder* ImageDecoder::GetDecoder(const BYTE* pData, UINT64 size)
+{
+    if (kPNGDecoder.CanDecode(pData, size))
+    {
+        return &kPNGDecoder;
+    }
+
+    return nullptr;
+}
+
+BOOL ImageDecoder::DecodeAll(const ImageDecodeJob* pJobs, UINT jobsNum, UINT threadCount)
+{
+    std::atomic<UINT> nextJob(0);
+    std::atomic<UINT> failedNum(0);
+    auto worker = [&]()
+    {
+        for (UINT i = nextJob++; i < jobsNum; i = nextJob++)
+        {
+            const ImageDecodeJob& job = pJobs[i];
+            const ImageDecoder* pDecoder = GetDecoder(job.pData, job.size);
+            if (pDecoder == nullptr || !pDecoder->Decode(job.pData, job.size, job.pDestination, job.rowPitch))
+            {
+                failedNum++;
+            }
+        }
+    };
+
+    if (threadCount == 0)
+    {
+        threadCount = max(std::thread::hardware_concurrency(), 1u);
+    }
+    threadCount = min(threadCount, jobsNum);
+
+    std::vector<std::thread> workers;
+    for (UINT i = 1; i < threadCount; i++)
+    {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : workers)
+    {
+        thread.join();
+    }
+
+    return failedNum == 0;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+// Number of decoding threads, 0 uses one per hardware thread.
+#define IMAGE_DECODER_THREAD_COUNT 0
+
+struct ImageInfo
+{
+    UINT width;
+    UINT height;
+};
+
+// An encoded image in memory, and the rows its pixels are decoded to.
+struct ImageDecodeJob
+{
+    const BYTE* pData;
+    UINT64 size;
+    BYTE* pDestination;
+    UINT64 rowPitch;
+};
+
+// Decodes images from memory to 32bpp RGBA, with no dependency on the platform. Decoders keep no state,
+// so one decoder can decode many images on many threads at once.
+class ImageDecoder
+{
+public:
+    virtual ~ImageDecoder() {}
+
+    // Whether the data starts like an image of the format of the decoder.
+    virtual BOOL CanDecode(const BYTE* pData, UINT64 size) const = 0;
+    // Read the size of an image. Returns FALSE if it is not in the format of the decoder.
+    virtual BOOL ReadInfo(const BYTE* pData, UINT64 size, ImageInfo& info) const = 0;
+    // Decode an image, row y goes to pDestination + y * rowPitch. The destination is only written, once
+    // per row, so it can be upload memory. Returns FALSE if the image is corrupt.
+    virtual BOOL Decode(const BYTE* pData, UINT64 size, BYTE* pDestination, UINT64 rowPitch) const = 0;
+
+    // The decoder for the format of an image, nullptr if no decoder can read it.
+    static const ImageDecoder* GetDecoder(const BYTE* pData, UINT64 size);
+    // Decode the images of the jobs on the threads, one image per job at a time.
+    // Returns FALSE if any of them can not be decoded.
+    static BOOL DecodeAll(const ImageDecodeJob* pJobs, UINT jobsNum, UINT threadCount = IMAGE_DECODER_THREAD_COUNT);
+};
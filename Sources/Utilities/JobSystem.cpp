@@ -0,0 +1,411 @@
+#include "stdafx.h"
+#include "JobSystem.h"
+
+namespace
+{
+    // The job system the calling thread belongs to, and its index there.
+    thread_local const JobSystem* tJobSystem = nullptr;
+    thread_local UINT tThreadIndex = UINT_MAX;
+}
+
+JobSystem::JobDeque::JobDeque(UINT size) :
+    jobs(size),
+    top(0),
+    bottom(0)
+{
+
+}
+
+BOOL JobSystem::JobDeque::Push(Job* pJob)
+{
+    const INT64 b = bottom.load(std::memory_order_relaxed);
+    const INT64 t = top.load(std::memory_order_acquire);
+    if (b - t >= static_cast<INT64>(jobs.size()))
+    {
+        return FALSE;
+    }
+
+    jobs[b & (jobs.size() - 1)].store(pJob, std::memory_order_relaxed);
+    bottom.store(b + 1, std::memory_order_release);
+
+    return TRUE;
+}
+
+Job* JobSystem::JobDeque::Pop()
+{
+    // Take the bottom job first, then check whether a thief took it too.
+    const INT64 b = bottom.load(std::memory_order_relaxed) - 1;
+    bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    INT64 t = top.load(std::memory_order_relaxed);
+
+    Job* pJob = nullptr;
+    if (t <= b)
+    {
+        pJob = jobs[b & (jobs.size() - 1)].load(std::memory_order_relaxed);
+        if (t == b)
+        {
+            // The last job goes to whichever of the owner and a thief moves the top first.
+            if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            {
+                pJob = nullptr;
+            }
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+    }
+    else
+    {
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    return pJob;
+}
+
+Job* JobSystem::JobDeque::Steal()
+{
+    INT64 t = top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const INT64 b = bottom.load(std::memory_order_acquire);
+    if (t >= b)
+    {
+        return nullptr;
+    }
+
+    Job* pJob = jobs[t & (jobs.size() - 1)].load(std::memory_order_relaxed);
+    if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+    {
+        return nullptr;
+    }
+
+    return pJob;
+}
+
+JobSystem::JobSystem(UINT threadCount) :
+    isStopping(FALSE),
+    backgroundTasksNum(0),
+    sleepingWorkersNum(0),
+    wakeGeneration(0),
+    jobsNum(0),
+    stealsNum(0)
+{
+    if (threadCount == 0)
+    {
+        UINT hardwareThreadCount = std::thread::hardware_concurrency();
+        threadCount = hardwareThreadCount > 1 ? hardwareThreadCount - 1 : 1;
+    }
+
+    for (UINT i = 0; i <= threadCount; i++)
+    {
+        threads.push_back(std::make_unique<ThreadData>());
+    }
+
+    tJobSystem = this;
+    tThreadIndex = 0;
+    for (UINT i = 1; i <= threadCount; i++)
+    {
+        workers.emplace_back(&JobSystem::RunWorker, this, i);
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        isStopping = TRUE;
+        wakeGeneration++;
+    }
+    wakeCondition.notify_all();
+
+    for (std::thread& thread : workers)
+    {
+        thread.join();
+    }
+
+    if (tJobSystem == this)
+    {
+        tJobSystem = nullptr;
+        tThreadIndex = UINT_MAX;
+    }
+}
+
+Job* JobSystem::CreateJob(const std::function<void(UINT thread)>& task)
+{
+    return CreateChildJob(nullptr, task);
+}
+
+Job* JobSystem::CreateChildJob(Job* pParent, const std::function<void(UINT thread)>& task)
+{
+    const UINT thread = GetThreadIndex();
+    ThrowIfFalse(thread != UINT_MAX);
+
+    // Only this thread takes jobs from its pool, and skips the ones a long job still holds.
+    ThreadData& threadData = *threads[thread];
+    Job* pJob = nullptr;
+    for (UINT i = 0; i < JOB_POOL_SIZE && pJob == nullptr; i++)
+    {
+        Job* pCandidate = &threadData.jobs[threadData.nextJob++ & (JOB_POOL_SIZE - 1)];
+        if (IsFinished(pCandidate))
+        {
+            pJob = pCandidate;
+        }
+    }
+    ThrowIfFalse(pJob != nullptr);
+
+    if (pParent != nullptr)
+    {
+        pParent->unfinishedJobsNum.fetch_add(1, std::memory_order_relaxed);
+    }
+    pJob->task = task;
+    pJob->pParent = pParent;
+    pJob->unfinishedJobsNum.store(1, std::memory_order_relaxed);
+
+    return pJob;
+}
+
+void JobSystem::Run(Job* pJob)
+{
+    const UINT thread = GetThreadIndex();
+    ThrowIfFalse(thread != UINT_MAX && threads[thread]->deque.Push(pJob));
+    WakeWorkers(1);
+}
+
+void JobSystem::RunBackground(const std::function<void(UINT thread)>& task)
+{
+    {
+        std::lock_guard<std::mutex> lock(backgroundMutex);
+        backgroundTasks.push_back(task);
+    }
+    backgroundTasksNum.fetch_add(1, std::memory_order_relaxed);
+    WakeWorkers(1);
+}
+
+void JobSystem::Wait(const Job* pJob)
+{
+    const UINT thread = GetThreadIndex();
+    ThrowIfFalse(thread != UINT_MAX);
+
+    while (!IsFinished(pJob))
+    {
+        if (!RunJob(thread, FALSE))
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void JobSystem::ParallelFor(
+    UINT count,
+    UINT minRangeSize,
+    const std::function<void(UINT thread, UINT begin, UINT end)>& task)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    const UINT maxRangesNum = GetThreadCount() * PARALLEL_FOR_RANGES_PER_THREAD;
+    const UINT rangesNum = max(min(count / max(minRangeSize, 1u), maxRangesNum), 1u);
+    const UINT thread = GetThreadIndex();
+    if (rangesNum == 1 || thread == UINT_MAX)
+    {
+        task(thread == UINT_MAX ? 0 : thread, 0, count);
+        return;
+    }
+
+    // Keep the first exception, and skip the ranges that have not started.
+    std::mutex exceptionMutex;
+    std::exception_ptr exception = nullptr;
+    std::atomic<BOOL> isFailed(FALSE);
+    auto runRange = [&](UINT rangeThread, UINT begin, UINT end)
+    {
+        if (isFailed.load(std::memory_order_relaxed))
+        {
+            return;
+        }
+
+        try
+        {
+            task(rangeThread, begin, end);
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(exceptionMutex);
+            if (exception == nullptr)
+            {
+                exception = std::current_exception();
+            }
+            isFailed = TRUE;
+        }
+    };
+
+    // The ranges are children of one job, and split the indices as evenly as they can.
+    Job* pRoot = CreateJob(nullptr);
+    ThreadData& threadData = *threads[thread];
+    for (UINT i = 0; i < rangesNum; i++)
+    {
+        const UINT begin = static_cast<UINT>(static_cast<UINT64>(count) * i / rangesNum);
+        const UINT end = static_cast<UINT>(static_cast<UINT64>(count) * (i + 1) / rangesNum);
+        Job* pJob = CreateChildJob(pRoot, [&runRange, begin, end](UINT rangeThread)
+        {
+            runRange(rangeThread, begin, end);
+        });
+        ThrowIfFalse(threadData.deque.Push(pJob));
+    }
+    WakeWorkers(rangesNum);
+
+    Finish(pRoot);
+    Wait(pRoot);
+    if (exception != nullptr)
+    {
+        std::rethrow_exception(exception);
+    }
+}
+
+UINT JobSystem::GetThreadIndex() const
+{
+    return tJobSystem == this ? tThreadIndex : UINT_MAX;
+}
+
+// Helper functions.
+void JobSystem::RunWorker(UINT thread)
+{
+    tJobSystem = this;
+    tThreadIndex = thread;
+
+    UINT idleNum = 0;
+    while (!isStopping.load(std::memory_order_relaxed))
+    {
+        if (RunJob(thread, TRUE))
+        {
+            idleNum = 0;
+            continue;
+        }
+
+        if (++idleNum < JOB_SPIN_COUNT)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        // Sleep unless a job was run after the worker looked. A thread that runs one either sees the worker
+        // sleeping, or the worker sees the job.
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        sleepingWorkersNum.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!HasJobs() && !isStopping.load(std::memory_order_relaxed))
+        {
+            const UINT64 generation = wakeGeneration;
+            wakeCondition.wait(lock, [this, generation]() { return wakeGeneration != generation; });
+        }
+        sleepingWorkersNum.fetch_sub(1, std::memory_order_relaxed);
+        idleNum = 0;
+    }
+}
+
+BOOL JobSystem::RunJob(UINT thread, BOOL isBackgroundAllowed)
+{
+    Job* pJob = threads[thread]->deque.Pop();
+
+    // Steal from the other threads in turn, starting after this one so thieves spread out.
+    for (UINT i = 1; i < threads.size() && pJob == nullptr; i++)
+    {
+        pJob = threads[(thread + i) % threads.size()]->deque.Steal();
+        if (pJob != nullptr)
+        {
+            stealsNum.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    if (pJob != nullptr)
+    {
+        Execute(thread, pJob);
+        return TRUE;
+    }
+
+    if (!isBackgroundAllowed || backgroundTasksNum.load(std::memory_order_relaxed) == 0)
+    {
+        return FALSE;
+    }
+
+    std::function<void(UINT thread)> task;
+    {
+        std::lock_guard<std::mutex> lock(backgroundMutex);
+        if (backgroundTasks.empty())
+        {
+            return FALSE;
+        }
+        task = std::move(backgroundTasks.front());
+        backgroundTasks.pop_front();
+        backgroundTasksNum.fetch_sub(1, std::memory_order_relaxed);
+    }
+    task(thread);
+    jobsNum.fetch_add(1, std::memory_order_relaxed);
+
+    return TRUE;
+}
+
+void JobSystem::Execute(UINT thread, Job* pJob)
+{
+    if (pJob->task)
+    {
+        pJob->task(thread);
+        pJob->task = nullptr;
+    }
+    jobsNum.fetch_add(1, std::memory_order_relaxed);
+    Finish(pJob);
+}
+
+void JobSystem::Finish(Job* pJob)
+{
+    // The job can be reused as soon as it is finished, so its parent is read first.
+    while (pJob != nullptr)
+    {
+        Job* pParent = pJob->pParent;
+        if (pJob->unfinishedJobsNum.fetch_sub(1, std::memory_order_acq_rel) != 1)
+        {
+            break;
+        }
+        pJob = pParent;
+    }
+}
+
+BOOL JobSystem::HasJobs() const
+{
+    if (backgroundTasksNum.load(std::memory_order_relaxed) > 0)
+    {
+        return TRUE;
+    }
+
+    for (const std::unique_ptr<ThreadData>& threadData : threads)
+    {
+        if (!threadData->deque.IsEmpty())
+        {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+void JobSystem::WakeWorkers(UINT count)
+{
+    // Only take the lock when a worker sleeps, see RunWorker.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleepingWorkersNum.load(std::memory_order_relaxed) == 0)
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        wakeGeneration++;
+    }
+    if (count == 1)
+    {
+        wakeCondition.notify_one();
+    }
+    else
+    {
+        wakeCondition.notify_all();
+    }
+}
@@ -0,0 +1,131 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Number of worker threads, 0 uses one per hardware thread but the one that creates the job system.
+#define JOB_SYSTEM_THREAD_COUNT 0
+// Jobs a thread can have created and not finished at a time, a power of two. Background tasks are not
+// jobs, and do not count.
+#define JOB_POOL_SIZE 4096
+// Ranges a thread is given by ParallelFor, so one that runs slowly holds the others up less.
+#define PARALLEL_FOR_RANGES_PER_THREAD 4
+// Times an idle worker looks for a job before it sleeps until one is run.
+#define JOB_SPIN_COUNT 64
+
+// A task and the jobs it waits for. A job is finished once its task has run and all its children are
+// finished. It is reused by a later job of the thread that created it once it is finished.
+struct Job
+{
+    std::function<void(UINT thread)> task;
+    Job* pParent;
+    // The job itself and its children that are not finished.
+    std::atomic<UINT> unfinishedJobsNum;
+
+    Job() : pParent(nullptr), unfinishedJobsNum(0) {}
+};
+
+// Runs jobs on worker threads that live as long as the job system. Every thread has a deque of the jobs it
+// runs: it pushes and pops them at the bottom, and idle threads steal them from the top, so the threads
+// only touch atomics to hand jobs out. The thread that creates the job system is thread 0, and helps run
+// jobs while it waits for them.
+// Long tasks, such as asset loads, are run in the background by the workers only, so waiting for a short job
+// never runs one. They wait in a queue of their own rather than in the job pools, so any number of them can
+// be waiting. The job system does not touch D3D, so it also runs without a device.
+class JobSystem
+{
+private:
+    // A Chase-Lev deque. Only the thread that owns it pushes and pops, any thread steals.
+    class JobDeque
+    {
+    private:
+        std::vector<std::atomic<Job*>> jobs;
+        std::atomic<INT64> top;
+        std::atomic<INT64> bottom;
+
+    public:
+        JobDeque(UINT size);
+
+        BOOL Push(Job* pJob);
+        Job* Pop();
+        Job* Steal();
+        inline const BOOL IsEmpty() const
+        {
+            return bottom.load(std::memory_order_relaxed) <= top.load(std::memory_order_relaxed);
+        }
+    };
+
+    struct ThreadData
+    {
+        JobDeque deque;
+        std::vector<Job> jobs;
+        UINT nextJob;
+
+        ThreadData() : deque(JOB_POOL_SIZE), jobs(JOB_POOL_SIZE), nextJob(0) {}
+    };
+
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<ThreadData>> threads;
+    std::atomic<BOOL> isStopping;
+
+    // Background tasks, which are long, so they share one queue.
+    std::mutex backgroundMutex;
+    std::deque<std::function<void(UINT thread)>> backgroundTasks;
+    std::atomic<UINT> backgroundTasksNum;
+
+    // Idle workers sleep until a job is run, or the generation changes.
+    std::mutex sleepMutex;
+    std::condition_variable wakeCondition;
+    std::atomic<UINT> sleepingWorkersNum;
+    UINT64 wakeGeneration;
+
+    // Metrics since the job system was created.
+    std::atomic<UINT64> jobsNum;
+    std::atomic<UINT64> stealsNum;
+
+    void RunWorker(UINT thread);
+    // Run a job of the deques, or a task of the background queue if isBackgroundAllowed. Returns FALSE if
+    // there was none.
+    BOOL RunJob(UINT thread, BOOL isBackgroundAllowed);
+    void Execute(UINT thread, Job* pJob);
+    void Finish(Job* pJob);
+    BOOL HasJobs() const;
+    void WakeWorkers(UINT count);
+
+public:
+    JobSystem(UINT threadCount = JOB_SYSTEM_THREAD_COUNT);
+    // Stop the workers. The jobs run must be finished.
+    ~JobSystem();
+
+    // Create a job on one of the threads of the job system. It runs once it is passed to Run, with the
+    // thread it runs on.
+    Job* CreateJob(const std::function<void(UINT thread)>& task);
+    // Create a job that its parent waits for. It must be created before the parent is finished.
+    Job* CreateChildJob(Job* pParent, const std::function<void(UINT thread)>& task);
+    // Run a job on the thread that created it or one that steals it.
+    void Run(Job* pJob);
+    // Run a task on a worker, after the background tasks run before it, from any thread.
+    void RunBackground(const std::function<void(UINT thread)>& task);
+    // Run the other jobs on the calling thread until the job is finished. Background tasks are left to the
+    // workers.
+    void Wait(const Job* pJob);
+    // Call the task for ranges of the indices below count, of at least minRangeSize indices each, and
+    // return when all of them are done. An exception thrown by the task is rethrown here, after the other
+    // ranges are done.
+    void ParallelFor(UINT count, UINT minRangeSize, const std::function<void(UINT thread, UINT begin, UINT end)>& task);
+
+    inline const BOOL IsFinished(const Job* pJob) const
+    {
+        return pJob->unfinishedJobsNum.load(std::memory_order_acquire) == 0;
+    }
+    // The index of the calling thread, below GetThreadCount, or UINT_MAX if it is not one of the job system.
+    UINT GetThreadIndex() const;
+    inline const UINT GetThreadCount() const { return static_cast<UINT>(threads.size()); }
+    inline const UINT GetWorkerCount() const { return static_cast<UINT>(workers.size()); }
+    inline const UINT64 GetJobsNum() const { return jobsNum.load(std::memory_order_relaxed); }
+    inline const UINT64 GetStealsNum() const { return stealsNum.load(std::memory_order_relaxed); }
+};
@@ -4,3 +4,6 @@
 
 // Rendering pipeline frame count
 #define FRAME_COUNT 2
+// Frames the CPU records while the GPU still works on the ones before, each with its own command
+// allocators and readback buffers.
+#define FRAMES_IN_FLIGHT 2
@@ -0,0 +1,245 @@
+#include "stdafx.h"
+#include "MappedFile.h"
+#include <thread>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile() :
+    pData(nullptr),
+    size(0),
+#ifdef _WIN32
+    file(INVALID_HANDLE_VALUE),
+    mapping(nullptr)
+#else
+    file(-1)
+#endif
+{
+
+}
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+BOOL MappedFile::Open(const std::wstring& path)
+{
+    Close();
+
+#ifdef _WIN32
+    file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return FALSE;
+    }
+
+    LARGE_INTEGER fileSize = {};
+    GetFileSizeEx(file, &fileSize);
+    mapping = fileSize.QuadPart > 0 ? CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+    pData = mapping != nullptr ? static_cast<const BYTE*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+    size = fileSize.QuadPart;
+#else
+    file = open(ToUTF8(path).c_str(), O_RDONLY);
+    if (file < 0)
+    {
+        return FALSE;
+    }
+
+    struct stat status = {};
+    void* pView = fstat(file, &status) == 0 && status.st_size > 0
+        ? mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, file, 0)
+        : MAP_FAILED;
+    pData = pView != MAP_FAILED ? static_cast<const BYTE*>(pView) : nullptr;
+    size = status.st_size;
+#endif
+
+    if (pData == nullptr)
+    {
+        Close();
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+void MappedFile::Close()
+{
+#ifdef _WIN32
+    if (pData != nullptr)
+    {
+        UnmapViewOfFile(pData);
+    }
+    if (mapping != nullptr)
+    {
+        CloseHandle(mapping);
+    }
+    if (file != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(file);
+    }
+    mapping = nullptr;
+    file = INVALID_HANDLE_VALUE;
+#else
+    if (pData != nullptr)
+    {
+        munmap(const_cast<BYTE*>(pData), size);
+    }
+    if (file >= 0)
+    {
+        close(file);
+    }
+    file = -1;
+#endif
+
+    pData = nullptr;
+    size = 0;
+}
+
+void MappedFile::Evict(const std::wstring& path)
+{
+#ifdef _WIN32
+    // Opening the file unbuffered flushes its cached pages on most file systems.
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_FLAG_NO_BUFFERING, nullptr);
+    if (file != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(file);
+    }
+#else
+    INT file = open(ToUTF8(path).c_str(), O_RDONLY);
+    if (file >= 0)
+    {
+        fdatasync(file);
+        posix_fadvise(file, 0, 0, POSIX_FADV_DONTNEED);
+        close(file);
+    }
+#endif
+}
+
+UINT64 MappedFile::GetLastWriteTime(const std::wstring& path)
+{
+    UINT64 size = 0;
+    UINT64 lastWriteTime = 0;
+    GetStatus(path, size, lastWriteTime);
+
+    return lastWriteTime;
+}
+
+BOOL MappedFile::GetStatus(const std::wstring& path, UINT64& size, UINT64& lastWriteTime)
+{
+    size = 0;
+    lastWriteTime = 0;
+#ifdef _WIN32
+    WIN32_FILE_ATTRIBUTE_DATA data = {};
+    if (!GetFileAttributesExW(path.c_str(), GetFileExInfoStandard, &data))
+    {
+        return FALSE;
+    }
+
+    size = (static_cast<UINT64>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+    lastWriteTime = (static_cast<UINT64>(data.ftLastWriteTime.dwHighDateTime) << 32) | data.ftLastWriteTime.dwLowDateTime;
+#else
+    struct stat status = {};
+    if (stat(ToUTF8(path).c_str(), &status) != 0)
+    {
+        return FALSE;
+    }
+
+    size = static_cast<UINT64>(status.st_size);
+    lastWriteTime = static_cast<UINT64>(status.st_mtim.tv_sec) * 1000000000ull + status.st_mtim.tv_nsec;
+#endif
+
+    return TRUE;
+}
+
+BOOL MappedFile::Exists(const std::wstring& path)
+{
+#ifdef _WIN32
+    return GetFileAttributesW(path.c_str()) != INVALID_FILE_ATTRIBUTES;
+#else
+    struct stat status = {};
+    return stat(ToUTF8(path).c_str(), &status) == 0;
+#endif
+}
+
+BOOL MappedFile::Write(const std::wstring& path, const void* pData, UINT64 size)
+{
+    // The file of this thread is written first, so threads that write the same path at the same time
+    // never leave a mix of both writes behind.
+    const size_t thread = std::hash<std::thread::id>()(std::this_thread::get_id());
+    std::wstring tempPath = path + L"." + std::to_wstring(thread) + L".tmp";
+#ifdef _WIN32
+    std::ofstream outFile(tempPath, std::ios::out | std::ios::binary | std::ios::trunc);
+#else
+    std::ofstream outFile(ToUTF8(tempPath), std::ios::out | std::ios::binary | std::ios::trunc);
+#endif
+    if (!outFile.is_open())
+    {
+        return FALSE;
+    }
+
+    outFile.write(static_cast<const char*>(pData), size);
+    outFile.close();
+
+#ifdef _WIN32
+    if (!outFile.good() || !MoveFileExW(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING))
+    {
+        DeleteFileW(tempPath.c_str());
+        return FALSE;
+    }
+#else
+    if (!outFile.good() || rename(ToUTF8(tempPath).c_str(), ToUTF8(path).c_str()) != 0)
+    {
+        unlink(ToUTF8(tempPath).c_str());
+        return FALSE;
+    }
+#endif
+
+    return TRUE;
+}
+
+std::string MappedFile::ToUTF8(const std::wstring& path)
+{
+    std::string result;
+    result.reserve(path.size());
+    for (size_t i = 0; i < path.size(); i++)
+    {
+        UINT code = static_cast<UINT>(path[i]);
+        // Join UTF-16 surrogate pairs, for the platforms with 16-bit wide characters.
+        if (code >= 0xD800 && code < 0xDC00 && i + 1 < path.size())
+        {
+            code = 0x10000 + ((code - 0xD800) << 10) + (static_cast<UINT>(path[++i]) - 0xDC00);
+        }
+
+        if (code < 0x80)
+        {
+            result += static_cast<char>(code);
+        }
+        else if (code < 0x800)
+        {
+            result += static_cast<char>(0xC0 | (code >> 6));
+            result += static_cast<char>(0x80 | (code & 0x3F));
+        }
+        else if (code < 0x10000)
+        {
+            result += static_cast<char>(0xE0 | (code >> 12));
+            result += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            result += static_cast<char>(0x80 | (code & 0x3F));
+        }
+        else
+        {
+            result += static_cast<char>(0xF0 | (code >> 18));
+            result += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+            result += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            result += static_cast<char>(0x80 | (code & 0x3F));
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <string>
+
+// A read-only view of a whole file, mapped with CreateFileMapping on Windows and mmap elsewhere,
+// so the caches that are read in place load the same way on every platform.
+class MappedFile
+{
+private:
+    const BYTE* pData;
+    UINT64 size;
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#else
+    INT file;
+#endif
+
+public:
+    MappedFile();
+    // Unmap the file.
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Map the file, after unmapping the one mapped before. Fails if the file is missing or empty.
+    BOOL Open(const std::wstring& path);
+    void Close();
+    // Drop the pages of the file from the file cache, so the next time it is mapped it is read from the
+    // disk. Only does so where the platform allows it, and is only meant for benchmarks.
+    static void Evict(const std::wstring& path);
+
+    // The last write time of a file in platform units, or 0 when it does not exist.
+    static UINT64 GetLastWriteTime(const std::wstring& path);
+    // The size and the last write time of a file with one call. Both are 0 when it does not exist.
+    static BOOL GetStatus(const std::wstring& path, UINT64& size, UINT64& lastWriteTime);
+    static BOOL Exists(const std::wstring& path);
+    // Write the data to a file next to the path first, then move it over the path, so readers and other
+    // writers never see a partial file.
+    static BOOL Write(const std::wstring& path, const void* pData, UINT64 size);
+    // The path in the encoding of the file APIs of the platform, UTF-8 outside of Windows.
+    static std::string ToUTF8(const std::wstring& path);
+
+    inline const BYTE* GetData() const { return pData; }
+    inline const UINT64 GetSize() const { return size; }
+};
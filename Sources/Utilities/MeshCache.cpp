@@ -0,0 +1,246 @@
+#include "stdafx.h"
+#include "MeshCache.h"
+#include "MappedFile.h"
+#include "MeshletBuilder.h"
+
+namespace
+{
+    // The largest of the indices, a reduction the compiler vectorizes.
+    template <typename T>
+    UINT GetMaxIndex(const T* pIndices, UINT indicesNum)
+    {
+        UINT maxIndex = 0;
+        for (UINT i = 0; i < indicesNum; i++)
+        {
+            maxIndex = max(maxIndex, static_cast<UINT>(pIndices[i]));
+        }
+        return maxIndex;
+    }
+
+    BOOL IsRangeValid(UINT start, UINT64 count, UINT64 total)
+    {
+        return start + count <= total;
+    }
+}
+
+std::wstring MeshCache::GetCachePath(const std::wstring& sourcePath)
+{
+    std::wstring path = sourcePath;
+    size_t start = path.find_last_of(L'.');
+    if (start != std::wstring::npos)
+    {
+        path.erase(start, path.size() - start);
+    }
+
+    return path + L".mesh";
+}
+
+UINT64 MeshCache::GetSourceTimestamp(const std::wstring& sourcePath)
+{
+    return MappedFile::GetLastWriteTime(sourcePath);
+}
+
+BOOL MeshCache::LoadMesh(const std::wstring& cachePath, UINT64 sourceStamp,
+    MeshData* pMesh, D3D12_RAYTRACING_AABB& boundingBox)
+{
+    MappedFile file;
+    if (sourceStamp == 0 || !file.Open(cachePath) || file.GetSize() < sizeof(MeshCacheHeader))
+    {
+        return FALSE;
+    }
+
+    const BYTE* pData = file.GetData();
+    BOOL result = FALSE;
+    {
+        const MeshCacheHeader* pHeader = reinterpret_cast<const MeshCacheHeader*>(pData);
+        const UINT64 size = file.GetSize();
+        const UINT64 verticesSize = static_cast<UINT64>(pHeader->verticesNum) * pHeader->vertexStride;
+        const UINT64 indicesSize = static_cast<UINT64>(pHeader->indicesNum) * pHeader->indexStride;
+        const UINT64 submeshesSize = static_cast<UINT64>(pHeader->submeshesNum) * sizeof(D3D12Submesh);
+        const UINT64 meshletsSize = static_cast<UINT64>(pHeader->meshletsNum) * sizeof(D3D12Meshlet);
+        const UINT64 meshletVerticesSize = static_cast<UINT64>(pHeader->meshletVerticesNum) * sizeof(UINT);
+        const UINT64 meshletTrianglesSize = static_cast<UINT64>(pHeader->meshletTrianglesNum) * sizeof(UINT);
+        const UINT64 lodsSize = static_cast<UINT64>(pHeader->lodsNum) * sizeof(D3D12MeshLod);
+
+        // A stale or foreign file is treated as a cache miss so the caller re-cooks it.
+        if (pHeader->magic == MESH_CACHE_MAGIC
+            && pHeader->version == MESH_CACHE_VERSION
+            && pHeader->vertexStride == sizeof(Vertex)
+            && (pHeader->indexStride == sizeof(UINT16) || pHeader->indexStride == sizeof(UINT))
+            && (sourceStamp == MESH_CACHE_ANY_SOURCE_STAMP || pHeader->sourceStamp == sourceStamp)
+            && pHeader->submeshesOffset + submeshesSize <= size
+            && pHeader->verticesOffset + verticesSize <= size
+            && pHeader->indicesOffset + indicesSize <= size
+            && pHeader->meshletsOffset + meshletsSize <= size
+            && pHeader->meshletVerticesOffset + meshletVerticesSize <= size
+            && pHeader->meshletTrianglesOffset + meshletTrianglesSize <= size
+            && pHeader->lodsOffset + lodsSize <= size
+            && verticesSize > 0 && indicesSize > 0
+            && IsContentValid(pHeader, pData))
+        {
+            pMesh->SetVertices(reinterpret_cast<const Vertex*>(pData + pHeader->verticesOffset),
+                static_cast<UINT>(verticesSize));
+            if (pHeader->indexStride == sizeof(UINT))
+            {
+                pMesh->SetIndices(reinterpret_cast<const UINT*>(pData + pHeader->indicesOffset),
+                    static_cast<UINT>(indicesSize));
+            }
+            else
+            {
+                pMesh->SetIndices(reinterpret_cast<const UINT16*>(pData + pHeader->indicesOffset),
+                    static_cast<UINT>(indicesSize));
+            }
+            pMesh->SetLods(reinterpret_cast<const D3D12MeshLod*>(pData + pHeader->lodsOffset), pHeader->lodsNum);
+
+            const D3D12Submesh* pSubmeshes = reinterpret_cast<const D3D12Submesh*>(pData + pHeader->submeshesOffset);
+            for (UINT i = 0; i < pHeader->submeshesNum; i++)
+            {
+                pMesh->AddSubmesh(pSubmeshes[i]);
+            }
+
+            pMesh->SetMeshlets(
+                reinterpret_cast<const D3D12Meshlet*>(pData + pHeader->meshletsOffset), pHeader->meshletsNum,
+                reinterpret_cast<const UINT*>(pData + pHeader->meshletVerticesOffset), pHeader->meshletVerticesNum,
+                reinterpret_cast<const UINT*>(pData + pHeader->meshletTrianglesOffset), pHeader->meshletTrianglesNum);
+
+            pMesh->SetUVDensity(pHeader->uvDensity);
+            boundingBox = pHeader->boundingBox;
+            result = TRUE;
+        }
+    }
+
+    return result;
+}
+
+BOOL MeshCache::IsContentValid(const MeshCacheHeader* pHeader, const BYTE* pData)
+{
+    const UINT verticesNum = pHeader->verticesNum;
+    const UINT indicesNum = pHeader->indicesNum;
+    const void* pIndices = pData + pHeader->indicesOffset;
+    const UINT maxIndex = pHeader->indexStride == sizeof(UINT)
+        ? GetMaxIndex(static_cast<const UINT*>(pIndices), indicesNum)
+        : GetMaxIndex(static_cast<const UINT16*>(pIndices), indicesNum);
+    if (maxIndex >= verticesNum)
+    {
+        return FALSE;
+    }
+
+    const D3D12Submesh* pSubmeshes = reinterpret_cast<const D3D12Submesh*>(pData + pHeader->submeshesOffset);
+    for (UINT i = 0; i < pHeader->submeshesNum; i++)
+    {
+        if (!IsRangeValid(pSubmeshes[i].indexStart, pSubmeshes[i].indicesNum, indicesNum)
+            || !IsRangeValid(pSubmeshes[i].vertexStart, pSubmeshes[i].verticesNum, verticesNum))
+        {
+            return FALSE;
+        }
+    }
+
+    const D3D12MeshLod* pLods = reinterpret_cast<const D3D12MeshLod*>(pData + pHeader->lodsOffset);
+    for (UINT i = 0; i < pHeader->lodsNum; i++)
+    {
+        if (!IsRangeValid(pLods[i].indexStart, pLods[i].indicesNum, indicesNum))
+        {
+            return FALSE;
+        }
+    }
+
+    // The meshlet vertices index the vertices, and the corners of the meshlet triangles the vertices of their
+    // meshlet, whose triangles are also a range of the indices.
+    const UINT* pMeshletVertices = reinterpret_cast<const UINT*>(pData + pHeader->meshletVerticesOffset);
+    const UINT* pMeshletTriangles = reinterpret_cast<const UINT*>(pData + pHeader->meshletTrianglesOffset);
+    if (pHeader->meshletVerticesNum > 0 && GetMaxIndex(pMeshletVertices, pHeader->meshletVerticesNum) >= verticesNum)
+    {
+        return FALSE;
+    }
+    const D3D12Meshlet* pMeshlets = reinterpret_cast<const D3D12Meshlet*>(pData + pHeader->meshletsOffset);
+    for (UINT i = 0; i < pHeader->meshletsNum; i++)
+    {
+        const D3D12Meshlet& meshlet = pMeshlets[i];
+        if (meshlet.verticesNum > MESHLET_MAX_VERTICES || meshlet.trianglesNum > MESHLET_MAX_TRIANGLES
+            || !IsRangeValid(meshlet.vertexOffset, meshlet.verticesNum, pHeader->meshletVerticesNum)
+            || !IsRangeValid(meshlet.triangleOffset, meshlet.trianglesNum, pHeader->meshletTrianglesNum)
+            || !IsRangeValid(meshlet.indexStart, static_cast<UINT64>(meshlet.trianglesNum) * 3, indicesNum))
+        {
+            return FALSE;
+        }
+
+        for (UINT j = 0; j < meshlet.trianglesNum; j++)
+        {
+            const UINT triangle = pMeshletTriangles[meshlet.triangleOffset + j];
+            for (UINT corner = 0; corner < 3; corner++)
+            {
+                if (MeshletBuilder::UnpackTriangleIndex(triangle, corner) >= meshlet.verticesNum)
+                {
+                    return FALSE;
+                }
+            }
+        }
+    }
+
+    return TRUE;
+}
+
+BOOL MeshCache::SaveMesh(const std::wstring& cachePath, UINT64 sourceStamp,
+    const MeshData* pMesh, const D3D12_RAYTRACING_AABB& boundingBox)
+{
+    if (sourceStamp == 0)
+    {
+        return FALSE;
+    }
+
+    const std::vector<D3D12Submesh>& submeshes = pMesh->GetSubmeshes();
+    const std::vector<D3D12Meshlet>& meshlets = pMesh->GetMeshlets();
+    const std::vector<UINT>& meshletVertices = pMesh->GetMeshletVertices();
+    const std::vector<UINT>& meshletTriangles = pMesh->GetMeshletTriangles();
+    const std::vector<D3D12MeshLod>& lods = pMesh->GetLods();
+
+    MeshCacheHeader header = {};
+    header.magic = MESH_CACHE_MAGIC;
+    header.version = MESH_CACHE_VERSION;
+    header.vertexStride = sizeof(Vertex);
+    header.indexStride = pMesh->GetIndexStride();
+    header.verticesNum = pMesh->GetVerticesNum();
+    header.indicesNum = pMesh->GetIndicesNum();
+    header.submeshesNum = static_cast<UINT>(submeshes.size());
+    header.submeshesOffset = Align(sizeof(MeshCacheHeader), MESH_CACHE_SECTION_ALIGNMENT);
+    header.verticesOffset = Align(header.submeshesOffset + header.submeshesNum * sizeof(D3D12Submesh),
+        MESH_CACHE_SECTION_ALIGNMENT);
+    header.indicesOffset = Align(header.verticesOffset + pMesh->GetVerticesSize(),
+        MESH_CACHE_SECTION_ALIGNMENT);
+    header.meshletsNum = static_cast<UINT>(meshlets.size());
+    header.meshletsOffset = Align(header.indicesOffset + pMesh->GetIndicesSize(),
+        MESH_CACHE_SECTION_ALIGNMENT);
+    header.meshletVerticesNum = static_cast<UINT>(meshletVertices.size());
+    header.meshletVerticesOffset = Align(header.meshletsOffset + header.meshletsNum * sizeof(D3D12Meshlet),
+        MESH_CACHE_SECTION_ALIGNMENT);
+    header.meshletTrianglesNum = static_cast<UINT>(meshletTriangles.size());
+    header.meshletTrianglesOffset = Align(header.meshletVerticesOffset + header.meshletVerticesNum * sizeof(UINT),
+        MESH_CACHE_SECTION_ALIGNMENT);
+    header.lodsNum = static_cast<UINT>(lods.size());
+    header.lodsOffset = Align(header.meshletTrianglesOffset + header.meshletTrianglesNum * sizeof(UINT),
+        MESH_CACHE_SECTION_ALIGNMENT);
+    header.sourceStamp = sourceStamp;
+    header.boundingBox = boundingBox;
+    header.uvDensity = pMesh->GetUVDensity();
+
+    std::vector<BYTE> data(header.lodsOffset + header.lodsNum * sizeof(D3D12MeshLod), 0);
+    memcpy(data.data(), &header, sizeof(MeshCacheHeader));
+    if (submeshes.size() > 0)
+    {
+        memcpy(data.data() + header.submeshesOffset, submeshes.data(), submeshes.size() * sizeof(D3D12Submesh));
+    }
+    memcpy(data.data() + header.verticesOffset, pMesh->GetVerticesData(), pMesh->GetVerticesSize());
+    memcpy(data.data() + header.indicesOffset, pMesh->GetIndicesData(), pMesh->GetIndicesSize());
+    if (meshlets.size() > 0)
+    {
+        memcpy(data.data() + header.meshletsOffset, meshlets.data(), meshlets.size() * sizeof(D3D12Meshlet));
+        memcpy(data.data() + header.meshletVerticesOffset, meshletVertices.data(), meshletVertices.size() * sizeof(UINT));
+        memcpy(data.data() + header.meshletTrianglesOffset, meshletTriangles.data(), meshletTriangles.size() * sizeof(UINT));
+    }
+    if (lods.size() > 0)
+    {
+        memcpy(data.data() + header.lodsOffset, lods.data(), lods.size() * sizeof(D3D12MeshLod));
+    }
+
+    return MappedFile::Write(cachePath, data.data(), data.size());
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include "MeshData.h"
+
+// Cooked mesh file layout:
+// MeshCacheHeader | D3D12Submesh[submeshesNum] | vertices | indices
+//     | D3D12Meshlet[meshletsNum] | meshlet vertices | meshlet triangles | D3D12MeshLod[lodsNum]
+// Sections are 16 bytes aligned so they can be read straight from a mapped view.
+#define MESH_CACHE_MAGIC 0x4853454D // "MESH"
+#define MESH_CACHE_VERSION 6
+#define MESH_CACHE_SECTION_ALIGNMENT 16
+// The source stamp of a mesh whose source is not shipped, which accepts whatever the file was cooked from.
+#define MESH_CACHE_ANY_SOURCE_STAMP UINT64_MAX
+
+struct MeshCacheHeader
+{
+    UINT magic;
+    UINT version;
+    UINT vertexStride;
+    UINT indexStride;
+    UINT verticesNum;
+    UINT indicesNum;
+    UINT submeshesNum;
+    UINT submeshesOffset;
+    UINT verticesOffset;
+    UINT indicesOffset;
+    UINT meshletsNum;
+    UINT meshletsOffset;
+    UINT meshletVerticesNum;
+    UINT meshletVerticesOffset;
+    UINT meshletTrianglesNum;
+    UINT meshletTrianglesOffset;
+    UINT lodsNum;
+    UINT lodsOffset;
+    // The content hash of the source, or its timestamp when the hash is unknown.
+    UINT64 sourceStamp;
+    D3D12_RAYTRACING_AABB boundingBox;
+    FLOAT uvDensity;
+};
+
+class MeshCache
+{
+private:
+    // Whether the indices, the meshlets and the ranges of the submeshes and LODs of a file whose sections
+    // are within its size stay within its vertices and indices, so a corrupt file is never drawn.
+    static BOOL IsContentValid(const MeshCacheHeader* pHeader, const BYTE* pData);
+
+public:
+    static std::wstring GetCachePath(const std::wstring& sourcePath);
+    static UINT64 GetSourceTimestamp(const std::wstring& sourcePath);
+
+    // Map a cooked mesh into the mesh. Fails if the file is missing, corrupted or cooked from another source
+    // stamp, where corrupted includes indices and ranges past the vertices and indices of the file. A stamp
+    // of 0 is unknown and always fails, so a source that can not be read is never taken for the one that was
+    // cooked.
+    static BOOL LoadMesh(const std::wstring& cachePath, UINT64 sourceStamp,
+        MeshData* pMesh, D3D12_RAYTRACING_AABB& boundingBox);
+
+    // Cook the mesh data into a binary file. Fails for a stamp of 0.
+    static BOOL SaveMesh(const std::wstring& cachePath, UINT64 sourceStamp,
+        const MeshData* pMesh, const D3D12_RAYTRACING_AABB& boundingBox);
+};
@@ -0,0 +1,169 @@
+#include "stdafx.h"
+#include "MeshData.h"
+#include "VertexPacker.h"
+
+MeshData::MeshData() :
+    pVertices(nullptr),
+    pPackedVertices(nullptr),
+    pIndices(nullptr),
+    verticesSize(0),
+    verticesNum(0),
+    indicesSize(0),
+    indicesNum(0),
+    indexStride(sizeof(UINT16)),
+    positionScale(1.0f, 1.0f, 1.0f, 1.0f),
+    positionOffset(0.0f, 0.0f, 0.0f, 0.0f),
+    uvDensity(0.0f)
+{
+
+}
+
+MeshData::~MeshData()
+{
+    free(pVertices);
+    free(pPackedVertices);
+    free(pIndices);
+
+    pVertices = nullptr;
+    pPackedVertices = nullptr;
+    pIndices = nullptr;
+}
+
+void MeshData::SetVertices(const Vertex* triangleVertices, UINT size)
+{
+    UINT strideSize = sizeof(Vertex);
+    verticesSize = size;
+    verticesNum = size / strideSize;
+    free(pPackedVertices);
+    pPackedVertices = nullptr;
+    free(pVertices);
+    pVertices = (Vertex*)malloc(size);
+    if (pVertices != nullptr)
+    {
+        memcpy(pVertices, triangleVertices, verticesSize);
+    }
+}
+
+void MeshData::SetIndices(const UINT16* triangleIndices, UINT size)
+{
+    SetIndexData(triangleIndices, size, sizeof(UINT16));
+}
+
+void MeshData::SetIndices(const UINT* triangleIndices, UINT size)
+{
+    SetIndexData(triangleIndices, size, sizeof(UINT));
+}
+
+void MeshData::SetIndexData(const void* triangleIndices, UINT size, UINT stride)
+{
+    indexStride = stride;
+    indicesSize = size;
+    indicesNum = size / stride;
+    free(pIndices);
+    pIndices = malloc(size);
+    if (pIndices != nullptr)
+    {
+        memcpy(pIndices, triangleIndices, indicesSize);
+    }
+
+    // Without simplified levels the whole index buffer is the only LOD.
+    lods.assign(1, D3D12MeshLod{ 0, indicesNum, 0.0f });
+}
+
+void MeshData::AddSubmesh(const D3D12Submesh& submesh)
+{
+    submeshes.push_back(submesh);
+}
+
+void MeshData::SetLods(const D3D12MeshLod* pLods, UINT lodsNum)
+{
+    if (lodsNum > 0)
+    {
+        lods.assign(pLods, pLods + lodsNum);
+    }
+}
+
+void MeshData::SetMeshlets(const D3D12Meshlet* pMeshlets, UINT meshletsNum,
+    const UINT* pVertices, UINT verticesNum, const UINT* pTriangles, UINT trianglesNum)
+{
+    meshlets.assign(pMeshlets, pMeshlets + meshletsNum);
+    meshletVertices.assign(pVertices, pVertices + verticesNum);
+    meshletTriangles.assign(pTriangles, pTriangles + trianglesNum);
+}
+
+void MeshData::PackVertices(const D3D12_RAYTRACING_AABB& aabb)
+{
+    if (pVertices == nullptr || verticesNum == 0)
+    {
+        return;
+    }
+
+    VertexPacker::GetPositionDequantization(aabb, positionScale, positionOffset);
+    free(pPackedVertices);
+    pPackedVertices = (PackedVertex*)malloc(verticesNum * sizeof(PackedVertex));
+    if (pPackedVertices == nullptr)
+    {
+        return;
+    }
+
+    // Keep track of the round trip error to catch bad bounds or broken tangents.
+    FLOAT maxPositionError = 0.0f;
+    FLOAT minNormalDot = 1.0f;
+    for (UINT i = 0; i < verticesNum; i++)
+    {
+        pPackedVertices[i] = VertexPacker::PackVertex(pVertices[i], positionScale, positionOffset);
+
+        Vertex vertex = VertexPacker::UnpackVertex(pPackedVertices[i], positionScale, positionOffset);
+        maxPositionError = max(maxPositionError, fabsf(vertex.positionOS.x - pVertices[i].positionOS.x));
+        maxPositionError = max(maxPositionError, fabsf(vertex.positionOS.y - pVertices[i].positionOS.y));
+        maxPositionError = max(maxPositionError, fabsf(vertex.positionOS.z - pVertices[i].positionOS.z));
+        XMVECTOR normal = XMVector3Normalize(XMLoadFloat3(&pVertices[i].normalOS));
+        minNormalDot = min(minNormalDot, XMVectorGetX(XMVector3Dot(normal, XMLoadFloat3(&vertex.normalOS))));
+    }
+
+    WCHAR message[256];
+    swprintf_s(message, L"Packed %u vertices from %u KB to %u KB, max position error %f, max normal error %.3f degrees.\n",
+        verticesNum, verticesSize / 1024, GetVertexBufferSize() / 1024,
+        maxPositionError, XMConvertToDegrees(acosf(min(max(minNormalDot, -1.0f), 1.0f))));
+    OutputDebugStringW(message);
+}
+
+void MeshData::SetUVDensity(FLOAT density)
+{
+    uvDensity = density;
+}
+
+void MeshData::CopyVertices(void* destination)
+{
+    memcpy(destination, GetVertexBufferData(), GetVertexBufferSize());
+}
+
+void MeshData::CopyIndices(void* destination)
+{
+    memcpy(destination, pIndices, indicesSize);
+}
+
+D3D12_RAYTRACING_AABB MeshData::ComputeBoundingBox() const
+{
+    D3D12_RAYTRACING_AABB aabb = {};
+    if (pVertices == nullptr || verticesNum == 0)
+    {
+        return aabb;
+    }
+
+    aabb.MaxX = aabb.MinX = pVertices->positionOS.x;
+    aabb.MaxY = aabb.MinY = pVertices->positionOS.y;
+    aabb.MaxZ = aabb.MinZ = pVertices->positionOS.z;
+
+    for (UINT i = 0; i < verticesNum; i++)
+    {
+        aabb.MaxX = max(aabb.MaxX, (pVertices + i)->positionOS.x);
+        aabb.MaxY = max(aabb.MaxY, (pVertices + i)->positionOS.y);
+        aabb.MaxZ = max(aabb.MaxZ, (pVertices + i)->positionOS.z);
+        aabb.MinX = min(aabb.MinX, (pVertices + i)->positionOS.x);
+        aabb.MinY = min(aabb.MinY, (pVertices + i)->positionOS.y);
+        aabb.MinZ = min(aabb.MinZ, (pVertices + i)->positionOS.z);
+    }
+
+    return aabb;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+// A range of the mesh that was imported from a single source mesh node.
+struct D3D12Submesh
+{
+    UINT indexStart;
+    UINT indicesNum;
+    UINT vertexStart;
+    UINT verticesNum;
+};
+
+// A cluster of at most MESHLET_MAX_VERTICES vertices and MESHLET_MAX_TRIANGLES triangles.
+// Meshlets follow the index order, so the triangles of a meshlet are also a range of the index buffer.
+struct D3D12Meshlet
+{
+    UINT vertexOffset;
+    UINT verticesNum;
+    UINT triangleOffset;
+    UINT trianglesNum;
+    UINT indexStart;
+
+    // Bounds in object space.
+    XMFLOAT3 center;
+    FLOAT radius;
+    D3D12_RAYTRACING_AABB aabb;
+
+    // Normal cone of the triangles, cut off at the sine of its spread, 1 if it can not be backface culled.
+    XMFLOAT3 coneAxis;
+    FLOAT coneCutoff;
+};
+
+// A level of detail of the whole mesh, stored as a range of the index buffer over the same vertices.
+// LOD 0 is the source mesh. Error is the geometric deviation from it in object space units.
+struct D3D12MeshLod
+{
+    UINT indexStart;
+    UINT indicesNum;
+    FLOAT error;
+};
+
+// The CPU side of a mesh: what is imported, cooked and uploaded. It does not touch D3D, so the importer
+// and the mesh cache also build without a device, see D3D12Mesh for the GPU buffers.
+class MeshData
+{
+private:
+    Vertex* pVertices;
+    PackedVertex* pPackedVertices;
+    void* pIndices;
+    UINT verticesSize;
+    UINT verticesNum;
+    UINT indicesSize;
+    UINT indicesNum;
+    UINT indexStride;
+    std::vector<D3D12Submesh> submeshes;
+    std::vector<D3D12MeshLod> lods;
+
+    // Meshlet vertices index the mesh vertices, and meshlet triangles pack three
+    // local vertex indices of 10 bits each.
+    std::vector<D3D12Meshlet> meshlets;
+    std::vector<UINT> meshletVertices;
+    std::vector<UINT> meshletTriangles;
+
+    // Dequantization of the packed positions.
+    XMFLOAT4 positionScale;
+    XMFLOAT4 positionOffset;
+
+    // UV units per object space unit over the triangles of LOD 0, 0 if the mesh has no UVs.
+    FLOAT uvDensity;
+
+    void SetIndexData(const void* triangleIndices, UINT size, UINT stride);
+
+public:
+    MeshData();
+    virtual ~MeshData();
+
+    MeshData(const MeshData&) = delete;
+    MeshData& operator=(const MeshData&) = delete;
+
+    void SetVertices(const Vertex* triangleVertices, UINT size);
+    void SetIndices(const UINT16* triangleIndices, UINT size);
+    void SetIndices(const UINT* triangleIndices, UINT size);
+    void AddSubmesh(const D3D12Submesh& submesh);
+    void SetLods(const D3D12MeshLod* pLods, UINT lodsNum);
+    void SetMeshlets(const D3D12Meshlet* pMeshlets, UINT meshletsNum,
+        const UINT* pVertices, UINT verticesNum, const UINT* pTriangles, UINT trianglesNum);
+    void PackVertices(const D3D12_RAYTRACING_AABB& aabb);
+    void SetUVDensity(FLOAT density);
+    void CopyVertices(void* destination);
+    void CopyIndices(void* destination);
+    // The bounds of the vertices in object space.
+    D3D12_RAYTRACING_AABB ComputeBoundingBox() const;
+
+    inline const UINT GetVerticesSize() const { return verticesSize; }
+    inline const UINT GetVerticesNum() const { return verticesNum; }
+    inline const UINT GetIndicesSize() const { return indicesSize; }
+    inline const UINT GetIndicesNum() const { return indicesNum; }
+    inline const UINT GetIndexStride() const { return indexStride; }
+    inline const void* GetVerticesData() const { return pVertices; }
+    inline const void* GetIndicesData() const { return pIndices; }
+    inline const std::vector<D3D12Submesh>& GetSubmeshes() const { return submeshes; }
+    inline const std::vector<D3D12MeshLod>& GetLods() const { return lods; }
+    inline const D3D12MeshLod& GetLod(UINT lod) const { return lods[min(lod, static_cast<UINT>(lods.size()) - 1)]; }
+    inline const std::vector<D3D12Meshlet>& GetMeshlets() const { return meshlets; }
+    inline const std::vector<UINT>& GetMeshletVertices() const { return meshletVertices; }
+    inline const std::vector<UINT>& GetMeshletTriangles() const { return meshletTriangles; }
+
+    // The data that is uploaded to the GPU, which is packed after PackVertices.
+    inline const BOOL IsPacked() const { return pPackedVertices != nullptr; }
+    inline const UINT GetVertexStride() const { return IsPacked() ? sizeof(PackedVertex) : sizeof(Vertex); }
+    inline const UINT GetVertexBufferSize() const { return verticesNum * GetVertexStride(); }
+    inline const void* GetVertexBufferData() const { return IsPacked() ? static_cast<const void*>(pPackedVertices) : pVertices; }
+    inline const XMFLOAT4& GetPositionScale() const { return positionScale; }
+    inline const XMFLOAT4& GetPositionOffset() const { return positionOffset; }
+    inline const FLOAT GetUVDensity() const { return uvDensity; }
+};
@@ -0,0 +1,424 @@
+#include "stdafx.h"
+#include "MeshOptimizer.h"
+#include <algorithm>
+
+FLOAT MeshOptimizer::GetVertexScore(INT cachePosition, UINT remainingValence)
+{
+    const FLOAT cacheDecayPower = 1.5f;
+    const FLOAT lastTriangleScore = 0.75f;
+    const FLOAT valenceBoostScale = 2.0f;
+    const FLOAT valenceBoostPower = 0.5f;
+
+    // A vertex without remaining triangles is never picked again.
+    if (remainingValence == 0)
+    {
+        return -1.0f;
+    }
+
+    FLOAT score = 0.0f;
+    if (cachePosition >= 0)
+    {
+        // The vertices of the last triangle get a fixed score so the next triangle doesn't reuse them all.
+        if (cachePosition < 3)
+        {
+            score = lastTriangleScore;
+        }
+        else
+        {
+            const FLOAT scaler = 1.0f / (VERTEX_CACHE_SIZE - 3);
+            score = powf(1.0f - (cachePosition - 3) * scaler, cacheDecayPower);
+        }
+    }
+
+    // Boost the vertices with few triangles left so they are finished off quickly.
+    score += valenceBoostScale * powf(static_cast<FLOAT>(remainingValence), -valenceBoostPower);
+
+    return score;
+}
+
+void MeshOptimizer::OptimizeVertexCache(UINT* indices, UINT indicesNum, UINT verticesNum)
+{
+    const UINT trianglesNum = indicesNum / 3;
+    if (trianglesNum == 0)
+    {
+        return;
+    }
+
+    // Build the triangle adjacency of each vertex.
+    std::vector<UINT> remainingValence(verticesNum, 0);
+    for (UINT i = 0; i < trianglesNum * 3; i++)
+    {
+        remainingValence[indices[i]]++;
+    }
+
+    std::vector<UINT> adjacencyOffsets(verticesNum + 1, 0);
+    for (UINT i = 0; i < verticesNum; i++)
+    {
+        adjacencyOffsets[i + 1] = adjacencyOffsets[i] + remainingValence[i];
+    }
+
+    std::vector<UINT> adjacency(trianglesNum * 3);
+    std::vector<UINT> adjacencyCursors(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+    for (UINT i = 0; i < trianglesNum * 3; i++)
+    {
+        adjacency[adjacencyCursors[indices[i]]++] = i / 3;
+    }
+
+    // Score all vertices and triangles.
+    std::vector<INT> cachePositions(verticesNum, -1);
+    std::vector<FLOAT> vertexScores(verticesNum);
+    for (UINT i = 0; i < verticesNum; i++)
+    {
+        vertexScores[i] = GetVertexScore(-1, remainingValence[i]);
+    }
+
+    std::vector<FLOAT> triangleScores(trianglesNum);
+    std::vector<BYTE> isEmitted(trianglesNum, 0);
+    UINT bestTriangle = 0;
+    for (UINT i = 0; i < trianglesNum; i++)
+    {
+        triangleScores[i] = vertexScores[indices[i * 3 + 0]]
+            + vertexScores[indices[i * 3 + 1]]
+            + vertexScores[indices[i * 3 + 2]];
+        if (triangleScores[i] > triangleScores[bestTriangle])
+        {
+            bestTriangle = i;
+        }
+    }
+
+    std::vector<UINT> result;
+    result.reserve(trianglesNum * 3);
+
+    UINT cache[VERTEX_CACHE_SIZE + 3];
+    UINT cacheNum = 0;
+    UINT scanCursor = 0;
+
+    while (result.size() < trianglesNum * 3)
+    {
+        // Emit the best triangle.
+        const UINT* triangle = indices + bestTriangle * 3;
+        result.push_back(triangle[0]);
+        result.push_back(triangle[1]);
+        result.push_back(triangle[2]);
+        isEmitted[bestTriangle] = 1;
+
+        // Push the vertices of the triangle to the front of the cache and remove the triangle from their adjacency.
+        UINT newCache[VERTEX_CACHE_SIZE + 3];
+        UINT newCacheNum = 0;
+        for (UINT i = 0; i < 3; i++)
+        {
+            UINT vertex = triangle[i];
+            UINT* pAdjacency = adjacency.data() + adjacencyOffsets[vertex];
+            UINT last = --remainingValence[vertex];
+            for (UINT j = 0; j <= last; j++)
+            {
+                if (pAdjacency[j] == bestTriangle)
+                {
+                    std::swap(pAdjacency[j], pAdjacency[last]);
+                    break;
+                }
+            }
+
+            if (std::find(newCache, newCache + newCacheNum, vertex) == newCache + newCacheNum)
+            {
+                newCache[newCacheNum++] = vertex;
+            }
+        }
+
+        const UINT triangleVerticesNum = newCacheNum;
+        for (UINT i = 0; i < cacheNum; i++)
+        {
+            if (std::find(newCache, newCache + triangleVerticesNum, cache[i]) == newCache + triangleVerticesNum)
+            {
+                newCache[newCacheNum++] = cache[i];
+            }
+        }
+
+        // Rescore the vertices in the cache, including the ones just pushed out of it.
+        for (UINT i = 0; i < newCacheNum; i++)
+        {
+            UINT vertex = newCache[i];
+            cachePositions[vertex] = i < VERTEX_CACHE_SIZE ? static_cast<INT>(i) : -1;
+            vertexScores[vertex] = GetVertexScore(cachePositions[vertex], remainingValence[vertex]);
+        }
+
+        // Rescore their triangles and pick the best one as the next.
+        FLOAT bestScore = -1.0f;
+        BOOL isFound = FALSE;
+        for (UINT i = 0; i < newCacheNum; i++)
+        {
+            UINT vertex = newCache[i];
+            const UINT* pAdjacency = adjacency.data() + adjacencyOffsets[vertex];
+            for (UINT j = 0; j < remainingValence[vertex]; j++)
+            {
+                UINT index = pAdjacency[j];
+                triangleScores[index] = vertexScores[indices[index * 3 + 0]]
+                    + vertexScores[indices[index * 3 + 1]]
+                    + vertexScores[indices[index * 3 + 2]];
+                if (triangleScores[index] > bestScore)
+                {
+                    bestScore = triangleScores[index];
+                    bestTriangle = index;
+                    isFound = TRUE;
+                }
+            }
+        }
+
+        cacheNum = min(newCacheNum, static_cast<UINT>(VERTEX_CACHE_SIZE));
+        memcpy(cache, newCache, cacheNum * sizeof(UINT));
+
+        // Restart from the next triangle in the input order when the cache has no candidate left.
+        if (!isFound && result.size() < trianglesNum * 3)
+        {
+            while (isEmitted[scanCursor])
+            {
+                scanCursor++;
+            }
+            bestTriangle = scanCursor;
+        }
+    }
+
+    memcpy(indices, result.data(), result.size() * sizeof(UINT));
+}
+
+void MeshOptimizer::GetClusterBoundaries(const UINT* indices, UINT indicesNum, UINT verticesNum,
+    FLOAT threshold, std::vector<UINT>& boundaries)
+{
+    const UINT trianglesNum = indicesNum / 3;
+    const UINT cacheSize = VERTEX_CACHE_ANALYZE_SIZE;
+
+    // Simulate a FIFO cache with timestamps, a vertex is in the cache if it was loaded within the last cacheSize loads.
+    std::vector<UINT> cacheTimestamps(verticesNum, 0);
+    UINT timestamp = cacheSize + 1;
+    auto getMisses = [&](UINT triangle) -> UINT
+    {
+        UINT misses = 0;
+        for (UINT i = 0; i < 3; i++)
+        {
+            UINT vertex = indices[triangle * 3 + i];
+            if (timestamp - cacheTimestamps[vertex] > cacheSize)
+            {
+                cacheTimestamps[vertex] = timestamp++;
+                misses++;
+            }
+        }
+        return misses;
+    };
+
+    // Hard boundaries are where the cache is flushed, i.e. a triangle misses all of its vertices.
+    std::vector<UINT> hardBoundaries(1, 0);
+    getMisses(0);
+    for (UINT i = 1; i < trianglesNum; i++)
+    {
+        if (getMisses(i) == 3)
+        {
+            hardBoundaries.push_back(i);
+        }
+    }
+    hardBoundaries.push_back(trianglesNum);
+
+    // Soft boundaries split a hard cluster wherever its running ACMR is within the threshold of the whole cluster.
+    boundaries.clear();
+    for (UINT i = 0; i + 1 < hardBoundaries.size(); i++)
+    {
+        UINT start = hardBoundaries[i];
+        UINT end = hardBoundaries[i + 1];
+
+        timestamp += cacheSize + 1;
+        UINT clusterMisses = 0;
+        for (UINT j = start; j < end; j++)
+        {
+            clusterMisses += getMisses(j);
+        }
+        FLOAT targetACMR = static_cast<FLOAT>(clusterMisses) / (end - start) * threshold;
+
+        timestamp += cacheSize + 1;
+        boundaries.push_back(start);
+        UINT runningMisses = 0;
+        UINT runningTriangles = 0;
+        for (UINT j = start; j < end; j++)
+        {
+            runningMisses += getMisses(j);
+            runningTriangles++;
+
+            if (j + 1 < end && runningMisses <= targetACMR * runningTriangles)
+            {
+                boundaries.push_back(j + 1);
+                runningMisses = 0;
+                runningTriangles = 0;
+                timestamp += cacheSize + 1;
+            }
+        }
+    }
+    boundaries.push_back(trianglesNum);
+}
+
+void MeshOptimizer::OptimizeOverdraw(UINT* indices, UINT indicesNum,
+    const Vertex* vertices, UINT verticesNum, FLOAT threshold)
+{
+    const UINT trianglesNum = indicesNum / 3;
+    if (trianglesNum == 0)
+    {
+        return;
+    }
+
+    std::vector<UINT> boundaries;
+    GetClusterBoundaries(indices, indicesNum, verticesNum, threshold, boundaries);
+    const UINT clustersNum = static_cast<UINT>(boundaries.size()) - 1;
+
+    // Get the area weighted centroid of the mesh.
+    FLOAT meshCentroid[3] = { 0.0f, 0.0f, 0.0f };
+    FLOAT meshArea = 0.0f;
+    std::vector<FLOAT> clusterData(clustersNum * 7, 0.0f);
+    for (UINT i = 0; i < clustersNum; i++)
+    {
+        FLOAT* pData = clusterData.data() + i * 7;
+        for (UINT j = boundaries[i]; j < boundaries[i + 1]; j++)
+        {
+            const XMFLOAT3& p0 = vertices[indices[j * 3 + 0]].positionOS;
+            const XMFLOAT3& p1 = vertices[indices[j * 3 + 1]].positionOS;
+            const XMFLOAT3& p2 = vertices[indices[j * 3 + 2]].positionOS;
+
+            FLOAT e0[3] = { p1.x - p0.x, p1.y - p0.y, p1.z - p0.z };
+            FLOAT e1[3] = { p2.x - p0.x, p2.y - p0.y, p2.z - p0.z };
+            FLOAT normal[3] =
+            {
+                e0[1] * e1[2] - e0[2] * e1[1],
+                e0[2] * e1[0] - e0[0] * e1[2],
+                e0[0] * e1[1] - e0[1] * e1[0],
+            };
+            FLOAT area = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+
+            // The first three are the area weighted centroid, then the normal and the area of the cluster.
+            pData[0] += (p0.x + p1.x + p2.x) / 3.0f * area;
+            pData[1] += (p0.y + p1.y + p2.y) / 3.0f * area;
+            pData[2] += (p0.z + p1.z + p2.z) / 3.0f * area;
+            pData[3] += normal[0];
+            pData[4] += normal[1];
+            pData[5] += normal[2];
+            pData[6] += area;
+        }
+
+        meshCentroid[0] += pData[0];
+        meshCentroid[1] += pData[1];
+        meshCentroid[2] += pData[2];
+        meshArea += pData[6];
+    }
+
+    if (meshArea > 0.0f)
+    {
+        meshCentroid[0] /= meshArea;
+        meshCentroid[1] /= meshArea;
+        meshCentroid[2] /= meshArea;
+    }
+
+    // Clusters facing away from the centroid are more likely to occlude the others, so draw them first.
+    std::vector<FLOAT> sortKeys(clustersNum, 0.0f);
+    for (UINT i = 0; i < clustersNum; i++)
+    {
+        const FLOAT* pData = clusterData.data() + i * 7;
+        if (pData[6] <= 0.0f)
+        {
+            continue;
+        }
+
+        FLOAT direction[3] =
+        {
+            pData[0] / pData[6] - meshCentroid[0],
+            pData[1] / pData[6] - meshCentroid[1],
+            pData[2] / pData[6] - meshCentroid[2],
+        };
+        FLOAT normalLength = sqrtf(pData[3] * pData[3] + pData[4] * pData[4] + pData[5] * pData[5]);
+        if (normalLength > 0.0f)
+        {
+            sortKeys[i] = (direction[0] * pData[3] + direction[1] * pData[4] + direction[2] * pData[5]) / normalLength;
+        }
+    }
+
+    std::vector<UINT> clusterOrder(clustersNum);
+    for (UINT i = 0; i < clustersNum; i++)
+    {
+        clusterOrder[i] = i;
+    }
+    std::stable_sort(clusterOrder.begin(), clusterOrder.end(),
+        [&sortKeys](UINT a, UINT b) { return sortKeys[a] > sortKeys[b]; });
+
+    std::vector<UINT> result;
+    result.reserve(trianglesNum * 3);
+    for (UINT i = 0; i < clustersNum; i++)
+    {
+        UINT cluster = clusterOrder[i];
+        result.insert(result.end(), indices + boundaries[cluster] * 3, indices + boundaries[cluster + 1] * 3);
+    }
+
+    memcpy(indices, result.data(), result.size() * sizeof(UINT));
+}
+
+UINT MeshOptimizer::OptimizeVertexFetch(Vertex* vertices, UINT* indices, UINT indicesNum, UINT verticesNum)
+{
+    std::vector<UINT> remap(verticesNum, UINT_MAX);
+    UINT newVerticesNum = 0;
+    for (UINT i = 0; i < indicesNum; i++)
+    {
+        UINT& newIndex = remap[indices[i]];
+        if (newIndex == UINT_MAX)
+        {
+            newIndex = newVerticesNum++;
+        }
+        indices[i] = newIndex;
+    }
+
+    std::vector<Vertex> result(newVerticesNum);
+    for (UINT i = 0; i < verticesNum; i++)
+    {
+        if (remap[i] != UINT_MAX)
+        {
+            result[remap[i]] = vertices[i];
+        }
+    }
+
+    if (newVerticesNum > 0)
+    {
+        memcpy(vertices, result.data(), newVerticesNum * sizeof(Vertex));
+    }
+
+    return newVerticesNum;
+}
+
+VertexCacheStatistics MeshOptimizer::AnalyzeVertexCache(const UINT* indices, UINT indicesNum,
+    UINT verticesNum, UINT cacheSize)
+{
+    VertexCacheStatistics statistics = {};
+    const UINT trianglesNum = indicesNum / 3;
+    if (trianglesNum == 0)
+    {
+        return statistics;
+    }
+
+    // Simulate a FIFO cache the same way as the cluster boundaries.
+    std::vector<UINT> cacheTimestamps(verticesNum, 0);
+    std::vector<BYTE> isReferenced(verticesNum, 0);
+    UINT timestamp = cacheSize + 1;
+    UINT misses = 0;
+    UINT referencedNum = 0;
+    for (UINT i = 0; i < trianglesNum * 3; i++)
+    {
+        UINT vertex = indices[i];
+        if (timestamp - cacheTimestamps[vertex] > cacheSize)
+        {
+            cacheTimestamps[vertex] = timestamp++;
+            misses++;
+        }
+
+        if (isReferenced[vertex] == 0)
+        {
+            isReferenced[vertex] = 1;
+            referencedNum++;
+        }
+    }
+
+    statistics.acmr = static_cast<FLOAT>(misses) / trianglesNum;
+    statistics.atvr = static_cast<FLOAT>(misses) / referencedNum;
+
+    return statistics;
+}
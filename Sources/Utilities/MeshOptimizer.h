@@ -0,0 +1,40 @@
+#pragma once
+
+// Size of the post-transform cache used to score and analyze triangle orders.
+#define VERTEX_CACHE_SIZE 32
+#define VERTEX_CACHE_ANALYZE_SIZE 16
+
+// How much worse than the vertex cache order the ACMR of a cluster may get for overdraw.
+#define OVERDRAW_THRESHOLD 1.05f
+
+struct VertexCacheStatistics
+{
+    // Average cache miss ratio, vertices transformed per triangle.
+    FLOAT acmr;
+    // Average transformed vertex ratio, vertices transformed per referenced vertex.
+    FLOAT atvr;
+};
+
+class MeshOptimizer
+{
+private:
+    static FLOAT GetVertexScore(INT cachePosition, UINT remainingValence);
+    static void GetClusterBoundaries(const UINT* indices, UINT indicesNum, UINT verticesNum,
+        FLOAT threshold, std::vector<UINT>& boundaries);
+
+public:
+    // Reorder triangles for post-transform cache locality with the Forsyth algorithm.
+    static void OptimizeVertexCache(UINT* indices, UINT indicesNum, UINT verticesNum);
+
+    // Split the triangles into clusters that keep the cache efficiency within the threshold,
+    // then draw the clusters facing away from the mesh center first to help early-Z.
+    static void OptimizeOverdraw(UINT* indices, UINT indicesNum,
+        const Vertex* vertices, UINT verticesNum, FLOAT threshold);
+
+    // Reorder vertices by the order they are first fetched and drop unused ones.
+    // Returns the number of vertices left.
+    static UINT OptimizeVertexFetch(Vertex* vertices, UINT* indices, UINT indicesNum, UINT verticesNum);
+
+    static VertexCacheStatistics AnalyzeVertexCache(const UINT* indices, UINT indicesNum,
+        UINT verticesNum, UINT cacheSize = VERTEX_CACHE_ANALYZE_SIZE);
+};
@@ -0,0 +1,317 @@
+#include "stdafx.h"
+#include "MeshSimplifier.h"
+#include <algorithm>
+
+struct Collapse
+{
+    UINT from;
+    UINT to;
+    FLOAT error;
+    FLOAT distanceError;
+};
+
+void MeshSimplifier::AddPlane(Quadric& quadric, const XMFLOAT3& normal, FLOAT distance, FLOAT weight)
+{
+    quadric.a00 += weight * normal.x * normal.x;
+    quadric.a01 += weight * normal.x * normal.y;
+    quadric.a02 += weight * normal.x * normal.z;
+    quadric.a11 += weight * normal.y * normal.y;
+    quadric.a12 += weight * normal.y * normal.z;
+    quadric.a22 += weight * normal.z * normal.z;
+    quadric.b0 += weight * normal.x * distance;
+    quadric.b1 += weight * normal.y * distance;
+    quadric.b2 += weight * normal.z * distance;
+    quadric.c += weight * distance * distance;
+    quadric.weight += weight;
+}
+
+void MeshSimplifier::AddQuadric(Quadric& quadric, const Quadric& other)
+{
+    quadric.a00 += other.a00;
+    quadric.a01 += other.a01;
+    quadric.a02 += other.a02;
+    quadric.a11 += other.a11;
+    quadric.a12 += other.a12;
+    quadric.a22 += other.a22;
+    quadric.b0 += other.b0;
+    quadric.b1 += other.b1;
+    quadric.b2 += other.b2;
+    quadric.c += other.c;
+    quadric.weight += other.weight;
+}
+
+FLOAT MeshSimplifier::GetError(const Quadric& quadric, const XMFLOAT3& position)
+{
+    double x = position.x;
+    double y = position.y;
+    double z = position.z;
+    double error = quadric.a00 * x * x + quadric.a11 * y * y + quadric.a22 * z * z
+        + 2.0 * (quadric.a01 * x * y + quadric.a02 * x * z + quadric.a12 * y * z)
+        + 2.0 * (quadric.b0 * x + quadric.b1 * y + quadric.b2 * z)
+        + quadric.c;
+
+    return quadric.weight > 0.0 ? static_cast<FLOAT>(max(error, 0.0) / quadric.weight) : 0.0f;
+}
+
+FLOAT MeshSimplifier::Simplify(const Vertex* vertices, UINT verticesNum, const UINT* indices, UINT indicesNum,
+    UINT targetIndicesNum, std::vector<UINT>& result)
+{
+    result.assign(indices, indices + indicesNum);
+    if (verticesNum == 0 || indicesNum <= targetIndicesNum)
+    {
+        return 0.0f;
+    }
+
+    // Work in the unit cube of the mesh so that the error and the attribute weights do not depend on its size.
+    XMVECTOR minPosition = XMLoadFloat3(&vertices[0].positionOS);
+    XMVECTOR maxPosition = minPosition;
+    for (UINT i = 1; i < verticesNum; i++)
+    {
+        minPosition = XMVectorMin(minPosition, XMLoadFloat3(&vertices[i].positionOS));
+        maxPosition = XMVectorMax(maxPosition, XMLoadFloat3(&vertices[i].positionOS));
+    }
+    XMFLOAT3 extent;
+    XMStoreFloat3(&extent, maxPosition - minPosition);
+    FLOAT scale = max(max(extent.x, extent.y), max(extent.z, 1e-6f));
+
+    std::vector<XMFLOAT3> positions(verticesNum);
+    for (UINT i = 0; i < verticesNum; i++)
+    {
+        XMStoreFloat3(&positions[i], (XMLoadFloat3(&vertices[i].positionOS) - minPosition) / scale);
+    }
+
+    // Vertices that share a position with another vertex sit on an attribute seam.
+    std::vector<UINT> positionIds(verticesNum);
+    std::vector<UINT> positionUsers(verticesNum, 0);
+    {
+        std::unordered_map<UINT64, UINT> positionMap;
+        positionMap.reserve(verticesNum);
+        for (UINT i = 0; i < verticesNum; i++)
+        {
+            const XMFLOAT3& position = vertices[i].positionOS;
+            UINT64 hash = 14695981039346656037ULL;
+            const BYTE* pData = reinterpret_cast<const BYTE*>(&position);
+            for (UINT j = 0; j < sizeof(XMFLOAT3); j++)
+            {
+                hash = (hash ^ pData[j]) * 1099511628211ULL;
+            }
+
+            // Collisions only merge a few unrelated positions, which locks more than needed.
+            auto it = positionMap.emplace(hash, i).first;
+            positionIds[i] = it->second;
+            positionUsers[it->second]++;
+        }
+    }
+
+    std::vector<BOOL> isLocked(verticesNum, FALSE);
+    for (UINT i = 0; i < verticesNum; i++)
+    {
+        isLocked[i] = positionUsers[positionIds[i]] > 1;
+    }
+
+    // An edge without its opposite edge is on the border of the mesh.
+    {
+        std::unordered_map<UINT64, UINT> edges;
+        edges.reserve(indicesNum);
+        for (UINT i = 0; i < indicesNum; i += 3)
+        {
+            for (UINT j = 0; j < 3; j++)
+            {
+                UINT a = positionIds[indices[i + j]];
+                UINT b = positionIds[indices[i + (j + 1) % 3]];
+                edges[(static_cast<UINT64>(a) << 32) | b]++;
+            }
+        }
+        for (UINT i = 0; i < indicesNum; i += 3)
+        {
+            for (UINT j = 0; j < 3; j++)
+            {
+                UINT a = positionIds[indices[i + j]];
+                UINT b = positionIds[indices[i + (j + 1) % 3]];
+                if (edges.find((static_cast<UINT64>(b) << 32) | a) == edges.end())
+                {
+                    isLocked[indices[i + j]] = TRUE;
+                    isLocked[indices[i + (j + 1) % 3]] = TRUE;
+                }
+            }
+        }
+    }
+
+    // Accumulate the area weighted planes of the triangles around each vertex.
+    std::vector<Quadric> quadrics(verticesNum, Quadric{});
+    for (UINT i = 0; i < indicesNum; i += 3)
+    {
+        XMVECTOR p0 = XMLoadFloat3(&positions[indices[i]]);
+        XMVECTOR p1 = XMLoadFloat3(&positions[indices[i + 1]]);
+        XMVECTOR p2 = XMLoadFloat3(&positions[indices[i + 2]]);
+        XMVECTOR normal = XMVector3Cross(p1 - p0, p2 - p0);
+        FLOAT area = XMVectorGetX(XMVector3Length(normal));
+        if (area <= 0.0f)
+        {
+            continue;
+        }
+
+        XMFLOAT3 planeNormal;
+        XMStoreFloat3(&planeNormal, normal / area);
+        FLOAT distance = -XMVectorGetX(XMVector3Dot(normal / area, p0));
+        for (UINT j = 0; j < 3; j++)
+        {
+            AddPlane(quadrics[indices[i + j]], planeNormal, distance, area);
+        }
+    }
+
+    std::vector<UINT> remap(verticesNum);
+    std::vector<BOOL> isTouched(verticesNum);
+    std::vector<UINT> triangleOffsets(verticesNum + 1);
+    std::vector<UINT> vertexTriangles;
+    std::vector<Collapse> collapses;
+    FLOAT maxError = 0.0f;
+
+    while (result.size() > targetIndicesNum)
+    {
+        UINT trianglesNum = static_cast<UINT>(result.size() / 3);
+
+        // Gather the triangles around every vertex.
+        std::fill(triangleOffsets.begin(), triangleOffsets.end(), 0);
+        for (UINT index : result)
+        {
+            triangleOffsets[index + 1]++;
+        }
+        for (UINT i = 0; i < verticesNum; i++)
+        {
+            triangleOffsets[i + 1] += triangleOffsets[i];
+        }
+        vertexTriangles.resize(result.size());
+        std::vector<UINT> cursors(triangleOffsets.begin(), triangleOffsets.end() - 1);
+        for (UINT i = 0; i < result.size(); i++)
+        {
+            vertexTriangles[cursors[result[i]]++] = i / 3;
+        }
+
+        // Every unlocked vertex may collapse into any of its neighbors.
+        collapses.clear();
+        for (UINT i = 0; i < result.size(); i += 3)
+        {
+            for (UINT j = 0; j < 3; j++)
+            {
+                for (UINT k = 1; k < 3; k++)
+                {
+                    UINT from = result[i + j];
+                    UINT to = result[i + (j + k) % 3];
+                    if (isLocked[from])
+                    {
+                        continue;
+                    }
+
+                    Quadric quadric = quadrics[from];
+                    AddQuadric(quadric, quadrics[to]);
+
+                    XMVECTOR normalDelta = XMLoadFloat3(&vertices[from].normalOS) - XMLoadFloat3(&vertices[to].normalOS);
+                    XMVECTOR texCoordDelta = XMLoadFloat2(&vertices[from].texCoord) - XMLoadFloat2(&vertices[to].texCoord);
+                    FLOAT distanceError = GetError(quadric, positions[to]);
+                    FLOAT error = distanceError
+                        + SIMPLIFY_NORMAL_WEIGHT * XMVectorGetX(XMVector3LengthSq(normalDelta))
+                        + SIMPLIFY_TEXCOORD_WEIGHT * XMVectorGetX(XMVector3LengthSq(texCoordDelta));
+                    collapses.push_back(Collapse{ from, to, error, distanceError });
+                }
+            }
+        }
+
+        if (collapses.empty())
+        {
+            break;
+        }
+        std::sort(collapses.begin(), collapses.end(),
+            [](const Collapse& a, const Collapse& b) { return a.error < b.error; });
+
+        for (UINT i = 0; i < verticesNum; i++)
+        {
+            remap[i] = i;
+        }
+        std::fill(isTouched.begin(), isTouched.end(), FALSE);
+
+        // Collapse the cheapest edges first, and touch every vertex at most once in a pass
+        // so that the triangles around each collapse are still the ones gathered above.
+        UINT removedTrianglesNum = 0;
+        UINT targetRemovedNum = trianglesNum - targetIndicesNum / 3;
+        UINT collapsesNum = 0;
+        for (const Collapse& collapse : collapses)
+        {
+            if (removedTrianglesNum >= targetRemovedNum)
+            {
+                break;
+            }
+            if (isTouched[collapse.from] || isTouched[collapse.to])
+            {
+                continue;
+            }
+
+            // Reject the collapse if it flips or folds one of the triangles that remain.
+            BOOL isValid = TRUE;
+            UINT collapsedTrianglesNum = 0;
+            for (UINT t = triangleOffsets[collapse.from]; t < triangleOffsets[collapse.from + 1] && isValid; t++)
+            {
+                const UINT* pTriangle = &result[vertexTriangles[t] * 3];
+                if (pTriangle[0] == collapse.to || pTriangle[1] == collapse.to || pTriangle[2] == collapse.to)
+                {
+                    collapsedTrianglesNum++;
+                    continue;
+                }
+
+                XMVECTOR p[3];
+                XMVECTOR q[3];
+                for (UINT j = 0; j < 3; j++)
+                {
+                    p[j] = XMLoadFloat3(&positions[pTriangle[j]]);
+                    q[j] = pTriangle[j] == collapse.from ? XMLoadFloat3(&positions[collapse.to]) : p[j];
+                }
+                XMVECTOR oldNormal = XMVector3Cross(p[1] - p[0], p[2] - p[0]);
+                XMVECTOR newNormal = XMVector3Cross(q[1] - q[0], q[2] - q[0]);
+                FLOAT lengths = XMVectorGetX(XMVector3Length(oldNormal)) * XMVectorGetX(XMVector3Length(newNormal));
+                isValid = XMVectorGetX(XMVector3Dot(oldNormal, newNormal)) > SIMPLIFY_MIN_NORMAL_COSINE * lengths;
+            }
+            if (!isValid)
+            {
+                continue;
+            }
+
+            remap[collapse.from] = collapse.to;
+            AddQuadric(quadrics[collapse.to], quadrics[collapse.from]);
+            maxError = max(maxError, collapse.distanceError);
+            removedTrianglesNum += collapsedTrianglesNum;
+            collapsesNum++;
+
+            for (UINT t = triangleOffsets[collapse.from]; t < triangleOffsets[collapse.from + 1]; t++)
+            {
+                const UINT* pTriangle = &result[vertexTriangles[t] * 3];
+                isTouched[pTriangle[0]] = TRUE;
+                isTouched[pTriangle[1]] = TRUE;
+                isTouched[pTriangle[2]] = TRUE;
+            }
+        }
+
+        if (collapsesNum == 0)
+        {
+            break;
+        }
+
+        // Apply the collapses and drop the triangles that became degenerate.
+        UINT writeIndex = 0;
+        for (UINT i = 0; i < result.size(); i += 3)
+        {
+            UINT a = remap[result[i]];
+            UINT b = remap[result[i + 1]];
+            UINT c = remap[result[i + 2]];
+            if (a != b && b != c && a != c)
+            {
+                result[writeIndex++] = a;
+                result[writeIndex++] = b;
+                result[writeIndex++] = c;
+            }
+        }
+        result.resize(writeIndex);
+    }
+
+    // The quadric error is a squared distance in the unit cube. The attribute terms only order the collapses.
+    return sqrtf(maxError) * scale;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+// Triangle ratios of the LODs that are generated on import, each simplified from the one before.
+#define MESH_LOD_RATIOS { 0.5f, 0.25f, 0.1f }
+
+// A LOD is dropped if it does not remove at least this ratio of the triangles of the LOD before.
+#define MESH_LOD_MIN_REDUCTION 0.1f
+
+// Weights of the attribute differences against the position error in the unit cube of the mesh.
+#define SIMPLIFY_NORMAL_WEIGHT 0.05f
+#define SIMPLIFY_TEXCOORD_WEIGHT 0.1f
+
+// Normals of the triangles around a collapse may not turn further than this cosine.
+#define SIMPLIFY_MIN_NORMAL_COSINE 0.25f
+
+// Symmetric 4x4 error quadric of a set of weighted planes.
+struct Quadric
+{
+    double a00, a01, a02, a11, a12, a22;
+    double b0, b1, b2;
+    double c;
+    double weight;
+};
+
+class MeshSimplifier
+{
+private:
+    static void AddPlane(Quadric& quadric, const XMFLOAT3& normal, FLOAT distance, FLOAT weight);
+    static void AddQuadric(Quadric& quadric, const Quadric& other);
+    // Returns the weighted mean of the squared distances to the planes.
+    static FLOAT GetError(const Quadric& quadric, const XMFLOAT3& position);
+
+public:
+    // Collapse edges by the quadric error until the indices reach the target count, and write the
+    // simplified indices over the same vertices. Vertices on borders and attribute seams such as UV
+    // seams are locked so that the silhouette and the texture mapping hold.
+    // Returns the error in object space units.
+    static FLOAT Simplify(const Vertex* vertices, UINT verticesNum, const UINT* indices, UINT indicesNum,
+        UINT targetIndicesNum, std::vector<UINT>& result);
+};
@@ -0,0 +1,207 @@
+#include "stdafx.h"
+#include "MeshletBuilder.h"
+
+void MeshletBuilder::BuildMeshlets(MeshData* pMesh)
+{
+    const Vertex* pVertices = static_cast<const Vertex*>(pMesh->GetVerticesData());
+    if (pVertices == nullptr || pMesh->GetIndicesNum() == 0)
+    {
+        return;
+    }
+
+    std::vector<UINT> indices(pMesh->GetIndicesNum());
+    if (pMesh->GetIndexStride() == sizeof(UINT))
+    {
+        memcpy(indices.data(), pMesh->GetIndicesData(), pMesh->GetIndicesSize());
+    }
+    else
+    {
+        const UINT16* pIndices = static_cast<const UINT16*>(pMesh->GetIndicesData());
+        indices.assign(pIndices, pIndices + pMesh->GetIndicesNum());
+    }
+
+    std::vector<INT> localIndices(pMesh->GetVerticesNum(), -1);
+    std::vector<D3D12Meshlet> meshlets;
+    std::vector<UINT> meshletVertices;
+    std::vector<UINT> meshletTriangles;
+
+    // Meshlets never cross submeshes, which keeps them spatially coherent.
+    // They are only built for LOD 0.
+    const std::vector<D3D12Submesh>& submeshes = pMesh->GetSubmeshes();
+    if (submeshes.empty())
+    {
+        BuildRange(pVertices, indices.data(), 0, pMesh->GetLod(0).indicesNum,
+            localIndices, meshlets, meshletVertices, meshletTriangles);
+    }
+    for (const D3D12Submesh& submesh : submeshes)
+    {
+        BuildRange(pVertices, indices.data(), submesh.indexStart, submesh.indicesNum,
+            localIndices, meshlets, meshletVertices, meshletTriangles);
+    }
+
+    pMesh->SetMeshlets(meshlets.data(), static_cast<UINT>(meshlets.size()),
+        meshletVertices.data(), static_cast<UINT>(meshletVertices.size()),
+        meshletTriangles.data(), static_cast<UINT>(meshletTriangles.size()));
+}
+
+BOOL MeshletBuilder::IsMeshletVisible(const XMFLOAT4* pPlanes, FXMVECTOR center, FLOAT radius,
+    FXMVECTOR coneAxis, FLOAT coneCutoff, FXMVECTOR cameraPosition)
+{
+    for (UINT i = 0; i < 6; i++)
+    {
+        if (XMVectorGetX(XMVector3Dot(XMLoadFloat4(&pPlanes[i]), center)) + pPlanes[i].w < -radius)
+        {
+            return FALSE;
+        }
+    }
+
+    // Every triangle faces away when the whole sphere is seen from inside the back of the cone.
+    if (coneCutoff < 1.0f)
+    {
+        XMVECTOR view = center - cameraPosition;
+        FLOAT distance = XMVectorGetX(XMVector3Length(view));
+        return XMVectorGetX(XMVector3Dot(view, coneAxis)) < coneCutoff * distance + radius * (1.0f + coneCutoff);
+    }
+
+    return TRUE;
+}
+
+void MeshletBuilder::BuildRange(const Vertex* vertices, const UINT* indices, UINT indexStart, UINT indicesNum,
+    std::vector<INT>& localIndices, std::vector<D3D12Meshlet>& meshlets,
+    std::vector<UINT>& meshletVertices, std::vector<UINT>& meshletTriangles)
+{
+    D3D12Meshlet meshlet = {};
+    meshlet.vertexOffset = static_cast<UINT>(meshletVertices.size());
+    meshlet.triangleOffset = static_cast<UINT>(meshletTriangles.size());
+    meshlet.indexStart = indexStart;
+
+    auto flush = [&]()
+    {
+        if (meshlet.trianglesNum == 0)
+        {
+            return;
+        }
+
+        ComputeBounds(vertices, meshletVertices, meshletTriangles, meshlet);
+        meshlets.push_back(meshlet);
+
+        // Forget the local indices of this meshlet before starting the next one.
+        for (UINT i = 0; i < meshlet.verticesNum; i++)
+        {
+            localIndices[meshletVertices[meshlet.vertexOffset + i]] = -1;
+        }
+
+        D3D12Meshlet next = {};
+        next.vertexOffset = static_cast<UINT>(meshletVertices.size());
+        next.triangleOffset = static_cast<UINT>(meshletTriangles.size());
+        next.indexStart = meshlet.indexStart + meshlet.trianglesNum * 3;
+        meshlet = next;
+    };
+
+    for (UINT i = indexStart; i + 2 < indexStart + indicesNum; i += 3)
+    {
+        UINT newVerticesNum = 0;
+        for (UINT j = 0; j < 3; j++)
+        {
+            newVerticesNum += localIndices[indices[i + j]] < 0 ? 1 : 0;
+        }
+        // A repeated new vertex is counted twice, which only closes the meshlet a little early.
+        if (meshlet.verticesNum + newVerticesNum > MESHLET_MAX_VERTICES
+            || meshlet.trianglesNum + 1 > MESHLET_MAX_TRIANGLES)
+        {
+            flush();
+        }
+
+        UINT localTriangle[3];
+        for (UINT j = 0; j < 3; j++)
+        {
+            INT& localIndex = localIndices[indices[i + j]];
+            if (localIndex < 0)
+            {
+                localIndex = static_cast<INT>(meshlet.verticesNum++);
+                meshletVertices.push_back(indices[i + j]);
+            }
+            localTriangle[j] = static_cast<UINT>(localIndex);
+        }
+
+        meshletTriangles.push_back(PackTriangle(localTriangle[0], localTriangle[1], localTriangle[2]));
+        meshlet.trianglesNum++;
+    }
+
+    flush();
+}
+
+void MeshletBuilder::ComputeBounds(const Vertex* vertices, const std::vector<UINT>& meshletVertices,
+    const std::vector<UINT>& meshletTriangles, D3D12Meshlet& meshlet)
+{
+    // The sphere is centered in the AABB, which is tight enough for the small extent of a meshlet.
+    const XMFLOAT3& first = vertices[meshletVertices[meshlet.vertexOffset]].positionOS;
+    D3D12_RAYTRACING_AABB aabb = { first.x, first.y, first.z, first.x, first.y, first.z };
+    for (UINT i = 0; i < meshlet.verticesNum; i++)
+    {
+        const XMFLOAT3& position = vertices[meshletVertices[meshlet.vertexOffset + i]].positionOS;
+        aabb.MinX = min(aabb.MinX, position.x);
+        aabb.MinY = min(aabb.MinY, position.y);
+        aabb.MinZ = min(aabb.MinZ, position.z);
+        aabb.MaxX = max(aabb.MaxX, position.x);
+        aabb.MaxY = max(aabb.MaxY, position.y);
+        aabb.MaxZ = max(aabb.MaxZ, position.z);
+    }
+
+    XMVECTOR center = XMVectorSet(
+        (aabb.MinX + aabb.MaxX) * 0.5f, (aabb.MinY + aabb.MaxY) * 0.5f, (aabb.MinZ + aabb.MaxZ) * 0.5f, 1.0f);
+    FLOAT radius = 0.0f;
+    for (UINT i = 0; i < meshlet.verticesNum; i++)
+    {
+        XMVECTOR position = XMLoadFloat3(&vertices[meshletVertices[meshlet.vertexOffset + i]].positionOS);
+        radius = max(radius, XMVectorGetX(XMVector3Length(position - center)));
+    }
+
+    // The cone axis is the average of the face normals, and its spread is the widest face normal.
+    std::vector<XMVECTOR> normals;
+    normals.reserve(meshlet.trianglesNum);
+    XMVECTOR axis = XMVectorZero();
+    for (UINT i = 0; i < meshlet.trianglesNum; i++)
+    {
+        UINT triangle = meshletTriangles[meshlet.triangleOffset + i];
+        XMVECTOR p0 = XMLoadFloat3(&vertices[meshletVertices[meshlet.vertexOffset + UnpackTriangleIndex(triangle, 0)]].positionOS);
+        XMVECTOR p1 = XMLoadFloat3(&vertices[meshletVertices[meshlet.vertexOffset + UnpackTriangleIndex(triangle, 1)]].positionOS);
+        XMVECTOR p2 = XMLoadFloat3(&vertices[meshletVertices[meshlet.vertexOffset + UnpackTriangleIndex(triangle, 2)]].positionOS);
+        XMVECTOR normal = XMVector3Cross(p1 - p0, p2 - p0);
+        if (XMVectorGetX(XMVector3LengthSq(normal)) <= 0.0f)
+        {
+            continue;
+        }
+
+        normal = XMVector3Normalize(normal);
+        normals.push_back(normal);
+        axis += normal;
+    }
+
+    FLOAT cutoff = 1.0f;
+    if (!normals.empty() && XMVectorGetX(XMVector3LengthSq(axis)) > 0.0f)
+    {
+        axis = XMVector3Normalize(axis);
+        FLOAT minDot = 1.0f;
+        for (const XMVECTOR& normal : normals)
+        {
+            minDot = min(minDot, XMVectorGetX(XMVector3Dot(axis, normal)));
+        }
+
+        // A cone wider than a hemisphere can always be seen from some side.
+        if (minDot > 0.0f)
+        {
+            cutoff = sqrtf(1.0f - minDot * minDot);
+        }
+    }
+    else
+    {
+        axis = XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f);
+    }
+
+    XMStoreFloat3(&meshlet.center, center);
+    meshlet.radius = radius;
+    meshlet.aabb = aabb;
+    XMStoreFloat3(&meshlet.coneAxis, axis);
+    meshlet.coneCutoff = cutoff;
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include "MeshData.h"
+
+// Limits of a meshlet, 124 triangles leave room for the meshlet header in 128 byte units.
+#define MESHLET_MAX_VERTICES 64
+#define MESHLET_MAX_TRIANGLES 124
+
+class MeshletBuilder
+{
+private:
+    static void BuildRange(const Vertex* vertices, const UINT* indices, UINT indexStart, UINT indicesNum,
+        std::vector<INT>& localIndices, std::vector<D3D12Meshlet>& meshlets,
+        std::vector<UINT>& meshletVertices, std::vector<UINT>& meshletTriangles);
+    static void ComputeBounds(const Vertex* vertices, const std::vector<UINT>& meshletVertices,
+        const std::vector<UINT>& meshletTriangles, D3D12Meshlet& meshlet);
+
+public:
+    // Split every submesh into meshlets in the order of its indices and store them in the mesh.
+    static void BuildMeshlets(MeshData* pMesh);
+
+    // Whether any triangle of a meshlet may be seen, with its bounds and cone in world space. The frustum
+    // planes face inwards, and the cone axis is normalized.
+    static BOOL IsMeshletVisible(const XMFLOAT4* pPlanes, FXMVECTOR center, FLOAT radius,
+        FXMVECTOR coneAxis, FLOAT coneCutoff, FXMVECTOR cameraPosition);
+
+    // Pack the local vertex indices of a meshlet triangle.
+    static inline UINT PackTriangle(UINT i0, UINT i1, UINT i2) { return i0 | (i1 << 10) | (i2 << 20); }
+    static inline UINT UnpackTriangleIndex(UINT triangle, UINT corner) { return (triangle >> (corner * 10)) & 0x3FF; }
+};
@@ -0,0 +1,249 @@
+#include "stdafx.h"
+#include "MipGenerator.h"
+#include <atomic>
+#include <condition_variable>
+#include <emmintrin.h>
+#include <mutex>
+#include <thread>
+
+// Steps of the linear to sRGB table, fine enough to stay within one step of the exact curve.
+static const UINT kLinearToSRGBSteps = 4096;
+
+// Conversion tables between 8-bit sRGB and linear values.
+struct SRGBTables
+{
+    FLOAT toLinear[256];
+    BYTE toSRGB[kLinearToSRGBSteps + 1];
+
+    SRGBTables()
+    {
+        for (UINT i = 0; i < 256; i++)
+        {
+            FLOAT value = i / 255.0f;
+            toLinear[i] = value <= 0.04045f ? value / 12.92f : powf((value + 0.055f) / 1.055f, 2.4f);
+        }
+        for (UINT i = 0; i <= kLinearToSRGBSteps; i++)
+        {
+            FLOAT value = static_cast<FLOAT>(i) / kLinearToSRGBSteps;
+            value = value <= 0.0031308f ? value * 12.92f : 1.055f * powf(value, 1.0f / 2.4f) - 0.055f;
+            toSRGB[i] = static_cast<BYTE>(value * 255.0f + 0.5f);
+        }
+    }
+};
+
+static const SRGBTables kSRGBTables;
+
+UINT MipGenerator::GetMipLevelsNum(UINT width, UINT height)
+{
+    UINT levelsNum = 1;
+    for (UINT size = max(width, height); size > 1; size >>= 1)
+    {
+        levelsNum++;
+    }
+
+    return levelsNum;
+}
+
+UINT64 MipGenerator::GetLevelSize(UINT width, UINT height, UINT level)
+{
+    return static_cast<UINT64>(max(width >> level, 1u)) * max(height >> level, 1u) * 4;
+}
+
+void MipGenerator::Generate(BYTE* const* ppLevels, UINT chainsNum, UINT levelsNum, UINT width, UINT height,
+    MipFilterMode mode, const UINT64* pRowPitches, UINT threadCount)
+{
+    struct Job
+    {
+        UINT level;
+        UINT chain;
+        UINT firstRow;
+        UINT rowsNum;
+    };
+
+    // Queue the rows level by level, so a job only waits for the level above it.
+    std::vector<Job> jobs;
+    std::vector<UINT> levelJobsNum(levelsNum, 0);
+    for (UINT level = 1; level < levelsNum; level++)
+    {
+        UINT levelHeight = max(height >> level, 1u);
+        for (UINT chain = 0; chain < chainsNum; chain++)
+        {
+            for (UINT row = 0; row < levelHeight; row += MIP_GENERATOR_ROWS_PER_JOB)
+            {
+                jobs.push_back({ level, chain, row, min(levelHeight - row, static_cast<UINT>(MIP_GENERATOR_ROWS_PER_JOB)) });
+                levelJobsNum[level]++;
+            }
+        }
+    }
+
+    std::vector<UINT> levelCompletedNum(levelsNum, 0);
+    std::mutex mutex;
+    std::condition_variable levelCondition;
+    std::atomic<UINT> nextJob(0);
+    auto worker = [&]()
+    {
+        for (UINT i = nextJob++; i < jobs.size(); i = nextJob++)
+        {
+            const Job& job = jobs[i];
+            if (job.level > 1)
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                levelCondition.wait(lock, [&]()
+                {
+                    return levelCompletedNum[job.level - 1] == levelJobsNum[job.level - 1];
+                });
+            }
+
+            const UINT sourceWidth = max(width >> (job.level - 1), 1u);
+            FilterRows(ppLevels[job.chain * levelsNum + job.level - 1],
+                sourceWidth, max(height >> (job.level - 1), 1u),
+                pRowPitches != nullptr ? pRowPitches[job.level - 1] : sourceWidth * 4ull,
+                ppLevels[job.chain * levelsNum + job.level],
+                pRowPitches != nullptr ? pRowPitches[job.level] : max(sourceWidth >> 1, 1u) * 4ull,
+                job.firstRow, job.rowsNum, mode);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                levelCompletedNum[job.level]++;
+            }
+            levelCondition.notify_all();
+        }
+    };
+
+    if (threadCount == 0)
+    {
+        threadCount = max(std::thread::hardware_concurrency(), 1u);
+    }
+    threadCount = min(threadCount, static_cast<UINT>(jobs.size()));
+
+    std::vector<std::thread> workers;
+    for (UINT i = 1; i < threadCount; i++)
+    {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : workers)
+    {
+        thread.join();
+    }
+}
+
+// Helper functions.
+void MipGenerator::FilterRows(const BYTE* pSource, UINT sourceWidth, UINT sourceHeight, UINT64 sourceRowPitch,
+    BYTE* pDestination, UINT64 rowPitch, UINT firstRow, UINT rowsNum, MipFilterMode mode)
+{
+    const UINT width = max(sourceWidth >> 1, 1u);
+    for (UINT y = firstRow; y < firstRow + rowsNum; y++)
+    {
+        const BYTE* pRow0 = pSource + min(y * 2, sourceHeight - 1) * sourceRowPitch;
+        const BYTE* pRow1 = pSource + min(y * 2 + 1, sourceHeight - 1) * sourceRowPitch;
+        BYTE* pRow = pDestination + y * rowPitch;
+
+        switch (mode)
+        {
+        case MipFilterMode::Color:
+            FilterRowColor(pRow0, pRow1, sourceWidth, pRow, width);
+            break;
+        case MipFilterMode::Linear:
+            FilterRowLinear(pRow0, pRow1, sourceWidth, pRow, width);
+            break;
+        case MipFilterMode::Normal:
+            FilterRowNormal(pRow0, pRow1, sourceWidth, pRow, width);
+            break;
+        }
+    }
+}
+
+void MipGenerator::FilterRowColor(const BYTE* pRow0, const BYTE* pRow1, UINT sourceWidth, BYTE* pDestination, UINT width)
+{
+    const FLOAT* pToLinear = kSRGBTables.toLinear;
+    auto load = [pToLinear](const BYTE* pPixel)
+    {
+        return _mm_setr_ps(pToLinear[pPixel[0]], pToLinear[pPixel[1]], pToLinear[pPixel[2]], pPixel[3] / 255.0f);
+    };
+
+    // Color channels index the sRGB table, and alpha goes back to 8 bits directly.
+    const __m128 scale = _mm_setr_ps(kLinearToSRGBSteps * 0.25f, kLinearToSRGBSteps * 0.25f,
+        kLinearToSRGBSteps * 0.25f, 255.0f * 0.25f);
+    for (UINT x = 0; x < width; x++)
+    {
+        const UINT x0 = min(x * 2, sourceWidth - 1) * 4;
+        const UINT x1 = min(x * 2 + 1, sourceWidth - 1) * 4;
+        __m128 sum = _mm_add_ps(_mm_add_ps(load(pRow0 + x0), load(pRow0 + x1)),
+            _mm_add_ps(load(pRow1 + x0), load(pRow1 + x1)));
+
+        INT values[4];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(values), _mm_cvtps_epi32(_mm_mul_ps(sum, scale)));
+        pDestination[x * 4] = kSRGBTables.toSRGB[values[0]];
+        pDestination[x * 4 + 1] = kSRGBTables.toSRGB[values[1]];
+        pDestination[x * 4 + 2] = kSRGBTables.toSRGB[values[2]];
+        pDestination[x * 4 + 3] = static_cast<BYTE>(values[3]);
+    }
+}
+
+void MipGenerator::FilterRowLinear(const BYTE* pRow0, const BYTE* pRow1, UINT sourceWidth, BYTE* pDestination, UINT width)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i rounding = _mm_set1_epi16(2);
+
+    // Both source pixels of a row are next to each other, so a 64-bit load reads them together.
+    const UINT pairsNum = min(width, sourceWidth / 2);
+    for (UINT x = 0; x < pairsNum; x++)
+    {
+        __m128i row0 = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(pRow0 + x * 8)), zero);
+        __m128i row1 = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(pRow1 + x * 8)), zero);
+        __m128i sum = _mm_add_epi16(row0, row1);
+        sum = _mm_add_epi16(sum, _mm_srli_si128(sum, 8));
+        sum = _mm_srli_epi16(_mm_add_epi16(sum, rounding), 2);
+
+        INT value = _mm_cvtsi128_si32(_mm_packus_epi16(sum, zero));
+        memcpy(pDestination + x * 4, &value, 4);
+    }
+
+    // A source of one pixel wide repeats it.
+    for (UINT x = pairsNum; x < width; x++)
+    {
+        const BYTE* pPixel0 = pRow0 + min(x * 2, sourceWidth - 1) * 4;
+        const BYTE* pPixel1 = pRow1 + min(x * 2, sourceWidth - 1) * 4;
+        for (UINT c = 0; c < 4; c++)
+        {
+            pDestination[x * 4 + c] = static_cast<BYTE>((pPixel0[c] + pPixel1[c] + 1) / 2);
+        }
+    }
+}
+
+void MipGenerator::FilterRowNormal(const BYTE* pRow0, const BYTE* pRow1, UINT sourceWidth, BYTE* pDestination, UINT width)
+{
+    const __m128i zero = _mm_setzero_si128();
+    auto load = [&zero](const BYTE* pPixel)
+    {
+        INT value;
+        memcpy(&value, pPixel, 4);
+        return _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(value), zero), zero);
+    };
+
+    const __m128 normalMask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+    const __m128 up = _mm_setr_ps(0.0f, 0.0f, 1.0f, 0.0f);
+    for (UINT x = 0; x < width; x++)
+    {
+        const UINT x0 = min(x * 2, sourceWidth - 1) * 4;
+        const UINT x1 = min(x * 2 + 1, sourceWidth - 1) * 4;
+        __m128 sum = _mm_cvtepi32_ps(_mm_add_epi32(_mm_add_epi32(load(pRow0 + x0), load(pRow0 + x1)),
+            _mm_add_epi32(load(pRow1 + x0), load(pRow1 + x1))));
+
+        // Unpack the sum of four texels to [-1, 1], and renormalize xyz.
+        __m128 normal = _mm_and_ps(_mm_sub_ps(_mm_mul_ps(sum, _mm_set1_ps(2.0f / 1020.0f)), _mm_set1_ps(1.0f)), normalMask);
+        __m128 lengthSquared = _mm_mul_ps(normal, normal);
+        lengthSquared = _mm_add_ps(lengthSquared, _mm_shuffle_ps(lengthSquared, lengthSquared, _MM_SHUFFLE(2, 3, 0, 1)));
+        lengthSquared = _mm_add_ps(lengthSquared, _mm_shuffle_ps(lengthSquared, lengthSquared, _MM_SHUFFLE(1, 0, 3, 2)));
+        normal = _mm_cvtss_f32(lengthSquared) > 1e-8f ? _mm_div_ps(normal, _mm_sqrt_ps(lengthSquared)) : up;
+
+        __m128 result = _mm_add_ps(_mm_mul_ps(normal, _mm_set1_ps(127.5f)), _mm_set1_ps(127.5f));
+        result = _mm_or_ps(_mm_and_ps(normalMask, result), _mm_andnot_ps(normalMask, _mm_mul_ps(sum, _mm_set1_ps(0.25f))));
+
+        __m128i values = _mm_cvtps_epi32(result);
+        values = _mm_packus_epi16(_mm_packs_epi32(values, zero), zero);
+        INT value = _mm_cvtsi128_si32(values);
+        memcpy(pDestination + x * 4, &value, 4);
+    }
+}
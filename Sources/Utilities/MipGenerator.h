@@ -0,0 +1,39 @@
+#pragma once
+
+// Number of filtering threads, 0 uses one per hardware thread.
+#define MIP_GENERATOR_THREAD_COUNT 0
+// Destination rows filtered by a thread at a time.
+#define MIP_GENERATOR_ROWS_PER_JOB 16
+
+enum class MipFilterMode
+{
+    // Color in sRGB, averaged in linear space. Alpha is averaged as it is.
+    Color = 0,
+    // Independent linear channels, like metallic, roughness and ambient occlusion.
+    Linear = 1,
+    // Tangent space normals in xyz, renormalized after averaging. Alpha is averaged as it is.
+    Normal = 2,
+};
+
+// Builds mip chains of 32bpp RGBA images with a 2x2 box filter, vectorized with SSE2.
+class MipGenerator
+{
+private:
+    static void FilterRowColor(const BYTE* pRow0, const BYTE* pRow1, UINT sourceWidth, BYTE* pDestination, UINT width);
+    static void FilterRowLinear(const BYTE* pRow0, const BYTE* pRow1, UINT sourceWidth, BYTE* pDestination, UINT width);
+    static void FilterRowNormal(const BYTE* pRow0, const BYTE* pRow1, UINT sourceWidth, BYTE* pDestination, UINT width);
+    static void FilterRows(const BYTE* pSource, UINT sourceWidth, UINT sourceHeight, UINT64 sourceRowPitch,
+        BYTE* pDestination, UINT64 rowPitch, UINT firstRow, UINT rowsNum, MipFilterMode mode);
+
+public:
+    static UINT GetMipLevelsNum(UINT width, UINT height);
+    static UINT64 GetLevelSize(UINT width, UINT height, UINT level);
+
+    // Fill levels 1 to levelsNum - 1 of chainsNum chains, like the faces of a cubemap. The levels are
+    // ordered like subresources, ppLevels[chain * levelsNum + level], and level 0 holds the source images.
+    // Levels of all the chains are split into rows and filtered on the threads, a level starts once
+    // the level above it is done. Odd sizes repeat their last row and column.
+    // pRowPitches holds the row pitch of every level when the rows are not tightly packed.
+    static void Generate(BYTE* const* ppLevels, UINT chainsNum, UINT levelsNum, UINT width, UINT height,
+        MipFilterMode mode, const UINT64* pRowPitches = nullptr, UINT threadCount = MIP_GENERATOR_THREAD_COUNT);
+};
@@ -0,0 +1,888 @@
+#include "stdafx.h"
+#include "PNGDecoder.h"
+
+static const BYTE kSignature[8] = { 0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A };
+
+// Codes up to this many bits are decoded with one table lookup, the longer ones a bit at a time.
+static const UINT kFastBits = 10;
+static const UINT kMaxCodeBits = 15;
+
+static const UINT16 kLengthBases[29] =
+{
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258,
+};
+static const BYTE kLengthExtraBits[29] =
+{
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0,
+};
+static const UINT16 kDistanceBases[30] =
+{
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769,
+    1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577,
+};
+static const BYTE kDistanceExtraBits[30] =
+{
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13,
+};
+static const BYTE kCodeLengthOrder[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+// The pixels of an Adam7 pass start at these offsets and step by these strides.
+static const UINT kAdam7StartX[7] = { 0, 4, 0, 2, 0, 1, 0 };
+static const UINT kAdam7StartY[7] = { 0, 0, 4, 0, 2, 0, 1 };
+static const UINT kAdam7StepX[7] = { 8, 8, 4, 4, 2, 2, 1 };
+static const UINT kAdam7StepY[7] = { 8, 8, 8, 4, 4, 2, 2 };
+
+static UINT ReadBigEndian(const BYTE* pData)
+{
+    return (static_cast<UINT>(pData[0]) << 24) | (pData[1] << 16) | (pData[2] << 8) | pData[3];
+}
+
+// A canonical Huffman code of deflate.
+struct HuffmanTable
+{
+    // The symbol in the low 9 bits and its code length above them, by the next kFastBits bits of
+    // the stream. 0 if the code is longer.
+    UINT16 fast[1 << kFastBits];
+    UINT16 counts[kMaxCodeBits + 1];
+    // Symbols in the order of their codes.
+    UINT16 symbols[288];
+
+    // Returns FALSE if the lengths give more codes than they have room for. Incomplete codes are valid.
+    BOOL Build(const BYTE* pLengths, UINT symbolsNum)
+    {
+        memset(counts, 0, sizeof(counts));
+        for (UINT i = 0; i < symbolsNum; i++)
+        {
+            counts[pLengths[i]]++;
+        }
+        counts[0] = 0;
+
+        INT left = 1;
+        for (UINT length = 1; length <= kMaxCodeBits; length++)
+        {
+            left = (left << 1) - counts[length];
+            if (left < 0)
+            {
+                return FALSE;
+            }
+        }
+
+        UINT16 offsets[kMaxCodeBits + 1] = {};
+        for (UINT length = 1; length < kMaxCodeBits; length++)
+        {
+            offsets[length + 1] = offsets[length] + counts[length];
+        }
+        for (UINT i = 0; i < symbolsNum; i++)
+        {
+            if (pLengths[i] != 0)
+            {
+                symbols[offsets[pLengths[i]]++] = static_cast<UINT16>(i);
+            }
+        }
+
+        // The stream starts a code with its first bit, so the table is indexed by the reversed codes.
+        memset(fast, 0, sizeof(fast));
+        UINT code = 0;
+        UINT index = 0;
+        for (UINT length = 1; length <= kFastBits; length++)
+        {
+            for (UINT i = 0; i < counts[length]; i++, code++, index++)
+            {
+                UINT reversed = 0;
+                for (UINT bit = 0; bit < length; bit++)
+                {
+                    reversed |= ((code >> bit) & 1) << (length - 1 - bit);
+                }
+                for (UINT entry = reversed; entry < (1u << kFastBits); entry += 1u << length)
+                {
+                    fast[entry] = static_cast<UINT16>((length << 9) | symbols[index]);
+                }
+            }
+            code <<= 1;
+        }
+
+        return TRUE;
+    }
+};
+
+// Unfilters the scanlines of the passes of an image as they are decompressed, and writes them to the
+// destination as RGBA.
+class ScanlineWriter
+{
+private:
+    const PNGImage& image;
+    BYTE* pDestination;
+    UINT64 rowPitch;
+    UINT bitsPerPixel;
+    // Bytes between a byte and the one of the previous pixel the filters use, at least one.
+    UINT filterStride;
+
+    UINT pass;
+    UINT passesNum;
+    UINT passWidth;
+    UINT passHeight;
+    UINT row;
+    // Bytes of a scanline of the pass, with its filter type.
+    UINT64 rowSize;
+    UINT64 filledNum;
+    // The scanline being filled, and the one above it.
+    std::vector<BYTE> rows[2];
+    UINT current;
+
+    void StartPass(UINT first)
+    {
+        for (pass = first; pass < passesNum; pass++)
+        {
+            const UINT startX = passesNum > 1 ? kAdam7StartX[pass] : 0;
+            const UINT startY = passesNum > 1 ? kAdam7StartY[pass] : 0;
+            const UINT stepX = passesNum > 1 ? kAdam7StepX[pass] : 1;
+            const UINT stepY = passesNum > 1 ? kAdam7StepY[pass] : 1;
+            passWidth = image.width > startX ? (image.width - startX + stepX - 1) / stepX : 0;
+            passHeight = image.height > startY ? (image.height - startY + stepY - 1) / stepY : 0;
+            if (passWidth > 0 && passHeight > 0)
+            {
+                break;
+            }
+        }
+
+        if (pass < passesNum)
+        {
+            rowSize = 1 + (static_cast<UINT64>(passWidth) * bitsPerPixel + 7) / 8;
+            row = 0;
+            filledNum = 0;
+            memset(rows[1 - current].data(), 0, rowSize);
+        }
+    }
+
+    BOOL Unfilter(BYTE* pRow, const BYTE* pPrevious)
+    {
+        BYTE* pData = pRow + 1;
+        const BYTE* pAbove = pPrevious + 1;
+        const UINT64 size = rowSize - 1;
+        const UINT stride = static_cast<UINT>(min(static_cast<UINT64>(filterStride), size));
+
+        switch (pRow[0])
+        {
+        case 0:
+            break;
+        case 1:
+            for (UINT64 i = stride; i < size; i++)
+            {
+                pData[i] += pData[i - stride];
+            }
+            break;
+        case 2:
+            for (UINT64 i = 0; i < size; i++)
+            {
+                pData[i] += pAbove[i];
+            }
+            break;
+        case 3:
+            for (UINT64 i = 0; i < stride; i++)
+            {
+                pData[i] += pAbove[i] >> 1;
+            }
+            for (UINT64 i = stride; i < size; i++)
+            {
+                pData[i] += static_cast<BYTE>((pData[i - stride] + pAbove[i]) >> 1);
+            }
+            break;
+        case 4:
+            // Without a pixel on the left, the Paeth predictor is the one above.
+            for (UINT64 i = 0; i < stride; i++)
+            {
+                pData[i] += pAbove[i];
+            }
+            for (UINT64 i = stride; i < size; i++)
+            {
+                const INT a = pData[i - stride];
+                const INT b = pAbove[i];
+                const INT c = pAbove[i - stride];
+                const INT distanceA = abs(b - c);
+                const INT distanceB = abs(a - c);
+                const INT distanceC = abs(a + b - 2 * c);
+                pData[i] += static_cast<BYTE>(distanceA <= distanceB && distanceA <= distanceC ? a : distanceB <= distanceC ? b : c);
+            }
+            break;
+        default:
+            return FALSE;
+        }
+
+        return TRUE;
+    }
+
+    UINT ReadSample(const BYTE* pData, UINT index) const
+    {
+        const UINT depth = image.bitDepth;
+        if (depth == 8)
+        {
+            return pData[index];
+        }
+        if (depth == 16)
+        {
+            return (pData[index * 2] << 8) | pData[index * 2 + 1];
+        }
+
+        const UINT bit = index * depth;
+        return (pData[bit >> 3] >> (8 - depth - (bit & 7))) & ((1u << depth) - 1);
+    }
+
+    BYTE ToByte(UINT sample) const
+    {
+        const UINT depth = image.bitDepth;
+        return static_cast<BYTE>(depth == 16 ? sample >> 8 : depth == 8 ? sample : sample * 255 / ((1u << depth) - 1));
+    }
+
+    void Convert(const BYTE* pData)
+    {
+        const UINT startX = passesNum > 1 ? kAdam7StartX[pass] : 0;
+        const UINT startY = passesNum > 1 ? kAdam7StartY[pass] : 0;
+        const UINT stepX = passesNum > 1 ? kAdam7StepX[pass] : 1;
+        const UINT stepY = passesNum > 1 ? kAdam7StepY[pass] : 1;
+        BYTE* pPixel = pDestination + static_cast<UINT64>(startY + row * stepY) * rowPitch + startX * 4;
+        const UINT pixelStride = stepX * 4;
+
+        // 8-bit RGBA rows are already in the layout of the destination, and 8-bit RGB ones only need alpha.
+        if (image.colorType == 6 && image.bitDepth == 8)
+        {
+            if (stepX == 1)
+            {
+                memcpy(pPixel, pData, static_cast<size_t>(passWidth) * 4);
+            }
+            else
+            {
+                for (UINT x = 0; x < passWidth; x++)
+                {
+                    memcpy(pPixel + x * pixelStride, pData + x * 4, 4);
+                }
+            }
+            return;
+        }
+
+        if (image.colorType == 2 && image.bitDepth == 8 && !image.hasColorKey)
+        {
+            for (UINT x = 0; x < passWidth; x++)
+            {
+                const BYTE pixel[4] = { pData[x * 3], pData[x * 3 + 1], pData[x * 3 + 2], 255 };
+                memcpy(pPixel + x * pixelStride, pixel, 4);
+            }
+            return;
+        }
+
+        for (UINT x = 0; x < passWidth; x++)
+        {
+            BYTE pixel[4];
+            switch (image.colorType)
+            {
+            case 0:
+            {
+                const UINT gray = ReadSample(pData, x);
+                pixel[0] = pixel[1] = pixel[2] = ToByte(gray);
+                pixel[3] = image.hasColorKey && gray == image.colorKey[0] ? 0 : 255;
+                break;
+            }
+            case 2:
+            {
+                const UINT red = ReadSample(pData, x * 3);
+                const UINT green = ReadSample(pData, x * 3 + 1);
+                const UINT blue = ReadSample(pData, x * 3 + 2);
+                pixel[0] = ToByte(red);
+                pixel[1] = ToByte(green);
+                pixel[2] = ToByte(blue);
+                pixel[3] = image.hasColorKey && red == image.colorKey[0] && green == image.colorKey[1]
+                    && blue == image.colorKey[2] ? 0 : 255;
+                break;
+            }
+            case 3:
+                memcpy(pixel, image.palette[ReadSample(pData, x)], 4);
+                break;
+            case 4:
+                pixel[0] = pixel[1] = pixel[2] = ToByte(ReadSample(pData, x * 2));
+                pixel[3] = ToByte(ReadSample(pData, x * 2 + 1));
+                break;
+            default:
+                for (UINT c = 0; c < 4; c++)
+                {
+                    pixel[c] = ToByte(ReadSample(pData, x * 4 + c));
+                }
+                break;
+            }
+            memcpy(pPixel + x * pixelStride, pixel, 4);
+        }
+    }
+
+public:
+    ScanlineWriter(const PNGImage& inImage, BYTE* inDestination, UINT64 inRowPitch) :
+        image(inImage),
+        pDestination(inDestination),
+        rowPitch(inRowPitch),
+        bitsPerPixel(inImage.channelsNum * inImage.bitDepth),
+        filterStride(max(inImage.channelsNum * inImage.bitDepth / 8, 1u)),
+        passesNum(inImage.interlaceMethod == 1 ? 7 : 1),
+        current(0)
+    {
+        // The first pass has the widest rows of an interlaced image.
+        const UINT64 maxRowSize = 1 + (static_cast<UINT64>(image.width) * bitsPerPixel + 7) / 8;
+        rows[0].resize(maxRowSize);
+        rows[1].resize(maxRowSize);
+        StartPass(0);
+    }
+
+    // Take the next bytes of the decompressed stream. Bytes past the end of the image are ignored.
+    BOOL Write(const BYTE* pData, UINT64 size)
+    {
+        while (size > 0 && pass < passesNum)
+        {
+            const UINT64 copySize = min(size, rowSize - filledNum);
+            memcpy(rows[current].data() + filledNum, pData, copySize);
+            filledNum += copySize;
+            pData += copySize;
+            size -= copySize;
+
+            if (filledNum == rowSize)
+            {
+                if (!Unfilter(rows[current].data(), rows[1 - current].data()))
+                {
+                    return FALSE;
+                }
+                Convert(rows[current].data() + 1);
+
+                current = 1 - current;
+                filledNum = 0;
+                if (++row == passHeight)
+                {
+                    StartPass(pass + 1);
+                }
+            }
+        }
+
+        return TRUE;
+    }
+
+    inline const BOOL IsComplete() const { return pass == passesNum; }
+};
+
+// Decompresses a zlib stream split over the IDAT chunks, and hands its output to a writer whenever
+// half of the window is new.
+class Inflater
+{
+private:
+    const std::vector<std::pair<const BYTE*, UINT64>>& chunks;
+    ScanlineWriter& writer;
+    UINT chunk;
+    UINT64 position;
+    // The next bits of the stream from the lowest one. The bytes above bitsNum are the next ones too.
+    UINT64 bits;
+    UINT bitsNum;
+    // Bytes read past the end of the stream, as zeros.
+    UINT overrunNum;
+
+    std::vector<BYTE> window;
+    UINT64 writtenNum;
+    UINT64 flushedNum;
+    HuffmanTable lengthTable;
+    HuffmanTable distanceTable;
+
+    // Fill the bit buffer to more than 56 bits.
+    void Refill()
+    {
+        while (bitsNum <= 56)
+        {
+            while (chunk < chunks.size() && position == chunks[chunk].second)
+            {
+                chunk++;
+                position = 0;
+            }
+            if (chunk == chunks.size())
+            {
+                overrunNum++;
+                bitsNum += 8;
+                continue;
+            }
+
+            // Read whole bytes 8 at a time, the ones that do not fit are read again next time.
+            if (chunks[chunk].second - position >= 8)
+            {
+                UINT64 value;
+                memcpy(&value, chunks[chunk].first + position, 8);
+                bits |= value << bitsNum;
+                const UINT bytesNum = (64 - bitsNum) >> 3;
+                position += bytesNum;
+                bitsNum += bytesNum * 8;
+            }
+            else
+            {
+                bits |= static_cast<UINT64>(chunks[chunk].first[position++]) << bitsNum;
+                bitsNum += 8;
+            }
+        }
+    }
+
+    inline void Consume(UINT bitsCount)
+    {
+        bits >>= bitsCount;
+        bitsNum -= bitsCount;
+    }
+
+    inline UINT ReadBits(UINT bitsCount)
+    {
+        const UINT value = static_cast<UINT>(bits & ((1ull << bitsCount) - 1));
+        Consume(bitsCount);
+        return value;
+    }
+
+    // Returns -1 for a code that is not in the table.
+    INT DecodeSymbol(const HuffmanTable& table)
+    {
+        const UINT entry = table.fast[bits & ((1u << kFastBits) - 1)];
+        if (entry != 0)
+        {
+            Consume(entry >> 9);
+            return entry & 511;
+        }
+
+        INT code = 0;
+        INT first = 0;
+        INT index = 0;
+        for (UINT length = 1; length <= kMaxCodeBits; length++)
+        {
+            code |= (bits >> (length - 1)) & 1;
+            const INT count = table.counts[length];
+            if (code - first < count)
+            {
+                Consume(length);
+                return table.symbols[index + code - first];
+            }
+            index += count;
+            first = (first + count) << 1;
+            code <<= 1;
+        }
+
+        return -1;
+    }
+
+    BOOL Flush()
+    {
+        while (flushedNum < writtenNum)
+        {
+            const UINT64 start = flushedNum & (PNG_DECODER_WINDOW_SIZE - 1);
+            const UINT64 size = min(writtenNum - flushedNum, PNG_DECODER_WINDOW_SIZE - start);
+            if (!writer.Write(window.data() + start, size))
+            {
+                return FALSE;
+            }
+            flushedNum += size;
+        }
+
+        return TRUE;
+    }
+
+    // Flush once half of the window is new, the other half holds the 32KB back references can reach.
+    inline BOOL FlushIfFull()
+    {
+        return writtenNum - flushedNum < PNG_DECODER_WINDOW_SIZE / 2 || Flush();
+    }
+
+    void CopyMatch(UINT distance, UINT length)
+    {
+        const UINT64 to = writtenNum & (PNG_DECODER_WINDOW_SIZE - 1);
+        const UINT64 from = (writtenNum - distance) & (PNG_DECODER_WINDOW_SIZE - 1);
+        BYTE* pWindow = window.data();
+        if (to + length + 8 <= PNG_DECODER_WINDOW_SIZE && from + length + 8 <= PNG_DECODER_WINDOW_SIZE)
+        {
+            // Copy 8 bytes at a time when they are all behind the ones written. The bytes written past
+            // the match were flushed long ago, and are overwritten before they are flushed again.
+            if (distance >= 8)
+            {
+                for (UINT i = 0; i < length; i += 8)
+                {
+                    memcpy(pWindow + to + i, pWindow + from + i, 8);
+                }
+                writtenNum += length;
+                return;
+            }
+            if (distance == 1)
+            {
+                memset(pWindow + to, pWindow[from], length);
+                writtenNum += length;
+                return;
+            }
+        }
+
+        // A short distance repeats the bytes the match is writing, and the window can wrap.
+        for (UINT i = 0; i < length; i++)
+        {
+            pWindow[(writtenNum + i) & (PNG_DECODER_WINDOW_SIZE - 1)] = pWindow[(writtenNum - distance + i) & (PNG_DECODER_WINDOW_SIZE - 1)];
+        }
+        writtenNum += length;
+    }
+
+    BOOL CopyStoredBlock()
+    {
+        Consume(bitsNum & 7);
+        Refill();
+        const UINT length = ReadBits(16);
+        if ((length ^ 0xFFFF) != ReadBits(16))
+        {
+            return FALSE;
+        }
+
+        for (UINT i = 0; i < length; i++)
+        {
+            Refill();
+            window[writtenNum++ & (PNG_DECODER_WINDOW_SIZE - 1)] = static_cast<BYTE>(ReadBits(8));
+            if (!FlushIfFull())
+            {
+                return FALSE;
+            }
+        }
+
+        return overrunNum <= 8;
+    }
+
+    BOOL BuildFixedTables()
+    {
+        BYTE lengths[288 + 30];
+        memset(lengths, 8, 144);
+        memset(lengths + 144, 9, 112);
+        memset(lengths + 256, 7, 24);
+        memset(lengths + 280, 8, 8);
+        memset(lengths + 288, 5, 30);
+
+        return lengthTable.Build(lengths, 288) && distanceTable.Build(lengths + 288, 30);
+    }
+
+    BOOL ReadDynamicTables()
+    {
+        Refill();
+        const UINT lengthsNum = ReadBits(5) + 257;
+        const UINT distancesNum = ReadBits(5) + 1;
+        const UINT codeLengthsNum = ReadBits(4) + 4;
+        if (lengthsNum > 286 || distancesNum > 30)
+        {
+            return FALSE;
+        }
+
+        BYTE codeLengths[19] = {};
+        for (UINT i = 0; i < codeLengthsNum; i++)
+        {
+            Refill();
+            codeLengths[kCodeLengthOrder[i]] = static_cast<BYTE>(ReadBits(3));
+        }
+        HuffmanTable codeLengthTable;
+        if (!codeLengthTable.Build(codeLengths, 19))
+        {
+            return FALSE;
+        }
+
+        // The lengths of both codes are one sequence, a repeat can cross from one to the other.
+        BYTE lengths[286 + 30];
+        const UINT totalNum = lengthsNum + distancesNum;
+        for (UINT i = 0; i < totalNum;)
+        {
+            Refill();
+            const INT symbol = DecodeSymbol(codeLengthTable);
+            if (symbol < 0)
+            {
+                return FALSE;
+            }
+            if (symbol < 16)
+            {
+                lengths[i++] = static_cast<BYTE>(symbol);
+                continue;
+            }
+
+            BYTE value = 0;
+            UINT repeatNum = 0;
+            if (symbol == 16)
+            {
+                if (i == 0)
+                {
+                    return FALSE;
+                }
+                value = lengths[i - 1];
+                repeatNum = 3 + ReadBits(2);
+            }
+            else if (symbol == 17)
+            {
+                repeatNum = 3 + ReadBits(3);
+            }
+            else
+            {
+                repeatNum = 11 + ReadBits(7);
+            }
+            if (i + repeatNum > totalNum)
+            {
+                return FALSE;
+            }
+            memset(lengths + i, value, repeatNum);
+            i += repeatNum;
+        }
+
+        return lengths[256] != 0 && overrunNum <= 8
+            && lengthTable.Build(lengths, lengthsNum) && distanceTable.Build(lengths + lengthsNum, distancesNum);
+    }
+
+    BOOL InflateBlock()
+    {
+        for (;;)
+        {
+            // A length and a distance with their extra bits take at most 48 bits.
+            Refill();
+            INT symbol = DecodeSymbol(lengthTable);
+            if (symbol < 0)
+            {
+                return FALSE;
+            }
+            if (symbol < 256)
+            {
+                window[writtenNum++ & (PNG_DECODER_WINDOW_SIZE - 1)] = static_cast<BYTE>(symbol);
+            }
+            else if (symbol == 256)
+            {
+                return TRUE;
+            }
+            else
+            {
+                symbol -= 257;
+                if (symbol >= 29)
+                {
+                    return FALSE;
+                }
+                const UINT length = kLengthBases[symbol] + ReadBits(kLengthExtraBits[symbol]);
+                const INT distanceSymbol = DecodeSymbol(distanceTable);
+                if (distanceSymbol < 0 || distanceSymbol >= 30)
+                {
+                    return FALSE;
+                }
+                const UINT distance = kDistanceBases[distanceSymbol] + ReadBits(kDistanceExtraBits[distanceSymbol]);
+                if (distance > writtenNum)
+                {
+                    return FALSE;
+                }
+
+                CopyMatch(distance, length);
+            }
+
+            // Zeros past the end of a corrupt stream can decode forever.
+            if (!FlushIfFull() || overrunNum > 8)
+            {
+                return FALSE;
+            }
+        }
+    }
+
+public:
+    Inflater(const std::vector<std::pair<const BYTE*, UINT64>>& inChunks, ScanlineWriter& inWriter) :
+        chunks(inChunks),
+        writer(inWriter),
+        chunk(0),
+        position(0),
+        bits(0),
+        bitsNum(0),
+        overrunNum(0),
+        window(PNG_DECODER_WINDOW_SIZE),
+        writtenNum(0),
+        flushedNum(0)
+    {
+
+    }
+
+    BOOL Inflate()
+    {
+        // Deflate with a window of at most 32KB, and no preset dictionary.
+        Refill();
+        const UINT method = ReadBits(8);
+        const UINT flags = ReadBits(8);
+        if ((method & 15) != 8 || (method >> 4) > 7 || ((method << 8) | flags) % 31 != 0 || (flags & 32) != 0)
+        {
+            return FALSE;
+        }
+
+        BOOL isFinal = FALSE;
+        while (!isFinal)
+        {
+            Refill();
+            isFinal = ReadBits(1);
+            const UINT type = ReadBits(2);
+
+            BOOL isValid = FALSE;
+            if (type == 0)
+            {
+                isValid = CopyStoredBlock();
+            }
+            else if (type == 1)
+            {
+                isValid = BuildFixedTables() && InflateBlock();
+            }
+            else if (type == 2)
+            {
+                isValid = ReadDynamicTables() && InflateBlock();
+            }
+            if (!isValid || overrunNum > 8)
+            {
+                return FALSE;
+            }
+        }
+
+        // The bit buffer can hold the zeros past the end, as long as the stream did not use them.
+        return overrunNum * 8 <= bitsNum && Flush();
+    }
+};
+
+BOOL PNGDecoder::CanDecode(const BYTE* pData, UINT64 size) const
+{
+    return size >= sizeof(kSignature) && memcmp(pData, kSignature, sizeof(kSignature)) == 0;
+}
+
+BOOL PNGDecoder::ReadInfo(const BYTE* pData, UINT64 size, ImageInfo& info) const
+{
+    PNGImage image;
+    if (!ReadChunks(pData, size, image, TRUE))
+    {
+        return FALSE;
+    }
+
+    info.width = image.width;
+    info.height = image.height;
+    return TRUE;
+}
+
+BOOL PNGDecoder::Decode(const BYTE* pData, UINT64 size, BYTE* pDestination, UINT64 rowPitch) const
+{
+    PNGImage image;
+    if (!ReadChunks(pData, size, image, FALSE))
+    {
+        return FALSE;
+    }
+
+    ScanlineWriter writer(image, pDestination, rowPitch);
+    Inflater inflater(image.dataChunks, writer);
+    return inflater.Inflate() && writer.IsComplete();
+}
+
+// Helper functions.
+BOOL PNGDecoder::ReadChunks(const BYTE* pData, UINT64 size, PNGImage& image, BOOL isHeaderOnly)
+{
+    if (size < sizeof(kSignature) || memcmp(pData, kSignature, sizeof(kSignature)) != 0)
+    {
+        return FALSE;
+    }
+
+    image = PNGImage();
+    for (UINT i = 0; i < 256; i++)
+    {
+        image.palette[i][3] = 255;
+    }
+
+    BOOL hasHeader = FALSE;
+    BOOL hasPalette = FALSE;
+    UINT64 offset = sizeof(kSignature);
+    while (offset + 12 <= size)
+    {
+        // Length, type, data and CRC.
+        const UINT length = ReadBigEndian(pData + offset);
+        const BYTE* pType = pData + offset + 4;
+        const BYTE* pChunk = pData + offset + 8;
+        if (length > size - offset - 12)
+        {
+            return FALSE;
+        }
+        offset += 12ull + length;
+
+        if (memcmp(pType, "IHDR", 4) == 0)
+        {
+            if (hasHeader || length != 13)
+            {
+                return FALSE;
+            }
+            image.width = ReadBigEndian(pChunk);
+            image.height = ReadBigEndian(pChunk + 4);
+            image.bitDepth = pChunk[8];
+            image.colorType = pChunk[9];
+            image.interlaceMethod = pChunk[12];
+
+            const UINT depth = image.bitDepth;
+            BOOL isValidDepth = FALSE;
+            switch (image.colorType)
+            {
+            case 0:
+                image.channelsNum = 1;
+                isValidDepth = depth == 1 || depth == 2 || depth == 4 || depth == 8 || depth == 16;
+                break;
+            case 3:
+                image.channelsNum = 1;
+                isValidDepth = depth == 1 || depth == 2 || depth == 4 || depth == 8;
+                break;
+            case 2:
+            case 4:
+            case 6:
+                image.channelsNum = image.colorType == 2 ? 3 : image.colorType == 4 ? 2 : 4;
+                isValidDepth = depth == 8 || depth == 16;
+                break;
+            }
+
+            // Compression and filter methods 0 are the only ones defined.
+            if (!isValidDepth || pChunk[10] != 0 || pChunk[11] != 0 || image.interlaceMethod > 1
+                || image.width == 0 || image.height == 0 || image.width > (1u << 24) || image.height > (1u << 24))
+            {
+                return FALSE;
+            }
+
+            hasHeader = TRUE;
+            if (isHeaderOnly)
+            {
+                return TRUE;
+            }
+        }
+        else if (!hasHeader)
+        {
+            return FALSE;
+        }
+        else if (memcmp(pType, "PLTE", 4) == 0)
+        {
+            if (length % 3 != 0 || length > 768)
+            {
+                return FALSE;
+            }
+            for (UINT i = 0; i < length / 3; i++)
+            {
+                memcpy(image.palette[i], pChunk + i * 3, 3);
+            }
+            hasPalette = TRUE;
+        }
+        else if (memcmp(pType, "tRNS", 4) == 0)
+        {
+            if (image.colorType == 3)
+            {
+                for (UINT i = 0; i < min(length, 256u); i++)
+                {
+                    image.palette[i][3] = pChunk[i];
+                }
+            }
+            else if ((image.colorType == 0 && length >= 2) || (image.colorType == 2 && length >= 6))
+            {
+                for (UINT i = 0; i < (image.colorType == 0 ? 1u : 3u); i++)
+                {
+                    image.colorKey[i] = static_cast<UINT16>((pChunk[i * 2] << 8) | pChunk[i * 2 + 1]);
+                }
+                image.hasColorKey = TRUE;
+            }
+        }
+        else if (memcmp(pType, "IDAT", 4) == 0)
+        {
+            image.dataChunks.push_back({ pChunk, length });
+        }
+        else if (memcmp(pType, "IEND", 4) == 0)
+        {
+            break;
+        }
+        else if ((pType[0] & 32) == 0)
+        {
+            // An unknown critical chunk changes how the image is decoded, ancillary ones can be skipped.
+            return FALSE;
+        }
+    }
+
+    return hasHeader && !image.dataChunks.empty() && (image.colorType != 3 || hasPalette);
+}
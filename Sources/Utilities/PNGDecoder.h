@@ -0,0 +1,40 @@
+#pragma once
+#include "ImageDecoder.h"
+
+// Bytes of decompressed scanlines kept for the back references of deflate, twice its 32KB window.
+#define PNG_DECODER_WINDOW_SIZE 65536
+
+// The chunks of a PNG file that are needed to decode it.
+struct PNGImage
+{
+    UINT width;
+    UINT height;
+    BYTE bitDepth;
+    BYTE colorType;
+    BYTE interlaceMethod;
+    UINT channelsNum;
+    // RGBA entries, with the alpha of the tRNS chunk.
+    BYTE palette[256][4];
+    // The color of the transparent pixels of gray and RGB images, as samples of the bit depth.
+    BOOL hasColorKey;
+    UINT16 colorKey[3];
+    // The compressed stream, split over the IDAT chunks.
+    std::vector<std::pair<const BYTE*, UINT64>> dataChunks;
+};
+
+// Decodes PNG images of every color type, bit depth and interlace method, with its own inflate.
+// The decompressed scanlines go through a window of PNG_DECODER_WINDOW_SIZE bytes and two rows,
+// and are converted to RGBA as they are unfiltered, so the whole image is never held twice.
+// CRCs and the Adler-32 are not checked. Gamma, color profiles and the other ancillary chunks are ignored,
+// and 16-bit samples keep their high byte.
+class PNGDecoder : public ImageDecoder
+{
+private:
+    // Parse the chunks up to the first IDAT one, or all of them when isHeaderOnly is not set.
+    static BOOL ReadChunks(const BYTE* pData, UINT64 size, PNGImage& image, BOOL isHeaderOnly);
+
+public:
+    virtual BOOL CanDecode(const BYTE* pData, UINT64 size) const override;
+    virtual BOOL ReadInfo(const BYTE* pData, UINT64 size, ImageInfo& info) const override;
+    virtual BOOL Decode(const BYTE* pData, UINT64 size, BYTE* pDestination, UINT64 rowPitch) const override;
+};
@@ -272,7 +272,11 @@ inline std::wstring GetAssetFullPath(LPCWSTR assetName)
     return AssetsPath + assetName;
 }
 
+#ifdef ASSET_ROOT_PATH
+constexpr LPCWSTR AssetRootPath = ASSET_ROOT_PATH;
+#else
 constexpr LPCWSTR AssetRootPath = L"..\\Assets\\";
+#endif
 constexpr LPCWSTR ShaderRootPath = L"..\\Assets\\Shaders\\";
 
 inline std::wstring GetAssetPath(LPCWSTR assetName)
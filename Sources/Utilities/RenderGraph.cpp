@@ -0,0 +1,365 @@
+#include "stdafx.h"
+#include "RenderGraph.h"
+#include <algorithm>
+
+namespace
+{
+    const D3D12_RESOURCE_STATES READ_ONLY_STATES =
+        D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER
+        | D3D12_RESOURCE_STATE_INDEX_BUFFER
+        | D3D12_RESOURCE_STATE_DEPTH_READ
+        | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE
+        | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE
+        | D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT
+        | D3D12_RESOURCE_STATE_COPY_SOURCE;
+
+    // The use of a resource by a pass, in the state the pass needs it in.
+    struct Use
+    {
+        UINT position;
+        D3D12_RESOURCE_STATES state;
+        BOOL isWrite;
+    };
+
+    BOOL IsReadOnly(const Use& use)
+    {
+        return use.isWrite == FALSE && (use.state & ~READ_ONLY_STATES) == 0;
+    }
+}
+
+RenderGraph::RenderGraph() :
+    transientSize(0),
+    aliasedSize(0)
+{
+
+}
+
+void RenderGraph::Reset()
+{
+    passes.clear();
+    resources.clear();
+    order.clear();
+    finalBarriers.clear();
+    transientSize = 0;
+    aliasedSize = 0;
+}
+
+UINT RenderGraph::ImportResource(D3D12_RESOURCE_STATES state)
+{
+    Resource resource = {};
+    resource.isTransient = FALSE;
+    resource.state = state;
+    resources.push_back(resource);
+
+    return static_cast<UINT>(resources.size() - 1);
+}
+
+UINT RenderGraph::CreateTransientResource(UINT64 size, UINT64 alignment)
+{
+    Resource resource = {};
+    resource.isTransient = TRUE;
+    resource.state = D3D12_RESOURCE_STATE_COMMON;
+    resource.size = size;
+    resource.alignment = max(alignment, 1ull);
+    resources.push_back(resource);
+
+    return static_cast<UINT>(resources.size() - 1);
+}
+
+UINT RenderGraph::AddPass(BOOL hasSideEffects)
+{
+    Pass pass = {};
+    pass.hasSideEffects = hasSideEffects;
+    passes.push_back(pass);
+
+    return static_cast<UINT>(passes.size() - 1);
+}
+
+void RenderGraph::Read(UINT pass, UINT resource, D3D12_RESOURCE_STATES state)
+{
+    Access& access = FindAccess(pass, resource);
+    access.isRead = TRUE;
+    access.state |= state;
+}
+
+void RenderGraph::Write(UINT pass, UINT resource, D3D12_RESOURCE_STATES state)
+{
+    Access& access = FindAccess(pass, resource);
+    access.isWrite = TRUE;
+    access.state |= state;
+}
+
+BOOL RenderGraph::Compile()
+{
+    // Bind every read to the pass that wrote the resource last, which was declared before the reader.
+    std::vector<UINT> lastWriters(resources.size(), UINT_MAX);
+    for (UINT i = 0; i < passes.size(); i++)
+    {
+        passes[i].isCulled = TRUE;
+        for (Access& access : passes[i].accesses)
+        {
+            access.producer = access.isRead ? lastWriters[access.resource] : UINT_MAX;
+            if (access.isWrite)
+            {
+                lastWriters[access.resource] = i;
+            }
+        }
+    }
+
+    // Keep the passes with side effects, the ones that write imported resources, and the ones that write
+    // what a kept pass reads. Readers come after their writers, so one walk back over the passes does.
+    for (UINT i = static_cast<UINT>(passes.size()); i-- > 0;)
+    {
+        Pass& pass = passes[i];
+        BOOL isLive = pass.hasSideEffects || pass.isCulled == FALSE;
+        for (const Access& access : pass.accesses)
+        {
+            isLive = isLive || (access.isWrite && resources[access.resource].isTransient == FALSE);
+        }
+        pass.isCulled = !isLive;
+        if (pass.isCulled)
+        {
+            continue;
+        }
+
+        for (const Access& access : pass.accesses)
+        {
+            if (access.producer != UINT_MAX)
+            {
+                passes[access.producer].isCulled = FALSE;
+            }
+        }
+    }
+
+    order.clear();
+    for (UINT i = 0; i < passes.size(); i++)
+    {
+        if (passes[i].isCulled == FALSE)
+        {
+            order.push_back(i);
+        }
+    }
+
+    if (CompileBarriers() == FALSE)
+    {
+        return FALSE;
+    }
+    AliasTransientResources();
+
+    return TRUE;
+}
+
+BOOL RenderGraph::IsAliasingValid(const UINT64* pOffsets) const
+{
+    for (UINT i = 0; i < resources.size(); i++)
+    {
+        const Resource& a = resources[i];
+        if (a.isTransient == FALSE || a.firstPosition == UINT_MAX)
+        {
+            continue;
+        }
+
+        for (UINT j = i + 1; j < resources.size(); j++)
+        {
+            const Resource& b = resources[j];
+            if (b.isTransient == FALSE || b.firstPosition == UINT_MAX)
+            {
+                continue;
+            }
+
+            const BOOL isAliveTogether = a.firstPosition <= b.lastPosition && b.firstPosition <= a.lastPosition;
+            const BOOL isOverlapping = pOffsets[i] < pOffsets[j] + b.size && pOffsets[j] < pOffsets[i] + a.size;
+            if (isAliveTogether && isOverlapping)
+            {
+                return FALSE;
+            }
+        }
+    }
+
+    return TRUE;
+}
+
+// Helper functions.
+RenderGraph::Access& RenderGraph::FindAccess(UINT pass, UINT resource)
+{
+    std::vector<Access>& accesses = passes[pass].accesses;
+    for (Access& access : accesses)
+    {
+        if (access.resource == resource)
+        {
+            return access;
+        }
+    }
+
+    Access access = {};
+    access.resource = resource;
+    access.state = D3D12_RESOURCE_STATE_COMMON;
+    access.producer = UINT_MAX;
+    accesses.push_back(access);
+
+    return accesses.back();
+}
+
+BOOL RenderGraph::CompileBarriers()
+{
+    std::vector<std::vector<Use>> uses(resources.size());
+    for (UINT i = 0; i < order.size(); i++)
+    {
+        Pass& pass = passes[order[i]];
+        pass.barriers.clear();
+        for (const Access& access : pass.accesses)
+        {
+            // Nothing can be written in a read-only state.
+            if (access.isWrite && (access.state & READ_ONLY_STATES) != 0)
+            {
+                return FALSE;
+            }
+
+            Use use = { i, access.state, access.isWrite };
+            uses[access.resource].push_back(use);
+        }
+    }
+
+    finalBarriers.clear();
+    const UINT lastPosition = static_cast<UINT>(order.size()) - 1;
+    for (UINT r = 0; r < resources.size(); r++)
+    {
+        Resource& resource = resources[r];
+        std::vector<Use>& resourceUses = uses[r];
+        resource.firstPosition = UINT_MAX;
+        resource.lastPosition = UINT_MAX;
+        if (resourceUses.empty())
+        {
+            continue;
+        }
+        resource.firstPosition = resourceUses.front().position;
+        resource.lastPosition = resourceUses.back().position;
+
+        // What a transient resource holds before it is written is undefined.
+        if (resource.isTransient && FindAccess(order[resource.firstPosition], r).isRead)
+        {
+            return FALSE;
+        }
+
+        // Reads in a row share one state that covers all of them, so they need no barriers between them.
+        for (UINT i = 0; i < resourceUses.size();)
+        {
+            UINT j = i;
+            D3D12_RESOURCE_STATES state = D3D12_RESOURCE_STATE_COMMON;
+            for (; j < resourceUses.size() && IsReadOnly(resourceUses[j]); j++)
+            {
+                state |= resourceUses[j].state;
+            }
+            for (UINT k = i; k < j; k++)
+            {
+                resourceUses[k].state = state;
+            }
+            i = max(j, i + 1);
+        }
+
+        // A transient resource is left from the last frame in the state of its last use. An imported one is
+        // in its own state, since the start of the frame.
+        D3D12_RESOURCE_STATES state = resource.isTransient ? resourceUses.back().state : resource.state;
+        UINT position = UINT_MAX;
+        BOOL isWrite = FALSE;
+        for (UINT i = 0; i < resourceUses.size(); i++)
+        {
+            const Use& use = resourceUses[i];
+            std::vector<RenderGraphBarrier>& barriers = passes[order[use.position]].barriers;
+            const BOOL isFirstTransientUse = resource.isTransient && i == 0;
+            if (isFirstTransientUse)
+            {
+                RenderGraphBarrier barrier = { RenderGraphBarrierType::Aliasing, r, state, use.state };
+                barriers.push_back(barrier);
+            }
+
+            if (use.state != state)
+            {
+                // Begin the transition right after the last use when there are passes in between to hide
+                // it behind. Nothing can be begun on a transient resource before it takes over its memory.
+                const UINT beginPosition = position == UINT_MAX ? 0 : position + 1;
+                if (isFirstTransientUse == FALSE && beginPosition < use.position)
+                {
+                    RenderGraphBarrier barrier = { RenderGraphBarrierType::BeginTransition, r, state, use.state };
+                    passes[order[beginPosition]].barriers.push_back(barrier);
+                }
+
+                RenderGraphBarrier barrier = { RenderGraphBarrierType::Transition, r, state, use.state };
+                barriers.push_back(barrier);
+            }
+            else if (i > 0 && (use.state & D3D12_RESOURCE_STATE_UNORDERED_ACCESS) && (use.isWrite || isWrite))
+            {
+                RenderGraphBarrier barrier = { RenderGraphBarrierType::UnorderedAccess, r, state, state };
+                barriers.push_back(barrier);
+            }
+
+            state = use.state;
+            position = use.position;
+            isWrite = use.isWrite;
+        }
+
+        if (resource.isTransient == FALSE && state != resource.state)
+        {
+            if (position < lastPosition)
+            {
+                RenderGraphBarrier barrier = { RenderGraphBarrierType::BeginTransition, r, state, resource.state };
+                passes[order[position + 1]].barriers.push_back(barrier);
+            }
+
+            RenderGraphBarrier barrier = { RenderGraphBarrierType::Transition, r, state, resource.state };
+            finalBarriers.push_back(barrier);
+        }
+    }
+
+    return TRUE;
+}
+
+void RenderGraph::AliasTransientResources()
+{
+    std::vector<UINT> transients;
+    transientSize = 0;
+    aliasedSize = 0;
+    for (UINT r = 0; r < resources.size(); r++)
+    {
+        resources[r].offset = 0;
+        if (resources[r].isTransient && resources[r].firstPosition != UINT_MAX)
+        {
+            transients.push_back(r);
+            transientSize += resources[r].size;
+        }
+    }
+
+    // Place the largest resources first, each at the lowest offset clear of the ones placed that it is
+    // alive together with.
+    std::stable_sort(transients.begin(), transients.end(), [this](UINT a, UINT b)
+    {
+        return resources[a].size > resources[b].size;
+    });
+
+    std::vector<UINT> placed;
+    for (UINT r : transients)
+    {
+        Resource& resource = resources[r];
+        UINT64 offset = 0;
+        BOOL isMoved = TRUE;
+        while (isMoved)
+        {
+            isMoved = FALSE;
+            for (UINT p : placed)
+            {
+                const Resource& other = resources[p];
+                const BOOL isAliveTogether = resource.firstPosition <= other.lastPosition
+                    && other.firstPosition <= resource.lastPosition;
+                if (isAliveTogether && offset < other.offset + other.size && other.offset < offset + resource.size)
+                {
+                    offset = (other.offset + other.size + resource.alignment - 1) / resource.alignment * resource.alignment;
+                    isMoved = TRUE;
+                }
+            }
+        }
+
+        resource.offset = offset;
+        aliasedSize = max(aliasedSize, offset + resource.size);
+        placed.push_back(r);
+    }
+}
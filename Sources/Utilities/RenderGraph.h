@@ -0,0 +1,105 @@
+#pragma once
+#include <vector>
+
+enum class RenderGraphBarrierType
+{
+    Transition = 0,
+    // The first half of a split transition, which the next transition of the resource ends.
+    BeginTransition = 1,
+    // A transient resource takes over the memory it is aliased in, in the state after.
+    Aliasing = 2,
+    UnorderedAccess = 3,
+};
+
+struct RenderGraphBarrier
+{
+    RenderGraphBarrierType type;
+    UINT resource;
+    D3D12_RESOURCE_STATES stateBefore;
+    D3D12_RESOURCE_STATES stateAfter;
+};
+
+// A frame described by its passes and the states they need their resources in. Compiling it drops the
+// passes nothing uses, finds the barriers each pass needs, and aliases the transient resources whose
+// lifetimes do not overlap in the same memory. Imported resources live outside the frame, and start and
+// end it in the state they are imported in. The graph is declared again every frame.
+// It only deals in indices and states, so it records no GPU work and can be used without a device.
+class RenderGraph
+{
+private:
+    struct Access
+    {
+        UINT resource;
+        D3D12_RESOURCE_STATES state;
+        BOOL isRead;
+        BOOL isWrite;
+        // The pass that wrote what is read, or UINT_MAX.
+        UINT producer;
+    };
+
+    struct Pass
+    {
+        BOOL hasSideEffects;
+        std::vector<Access> accesses;
+        BOOL isCulled;
+        std::vector<RenderGraphBarrier> barriers;
+    };
+
+    struct Resource
+    {
+        BOOL isTransient;
+        D3D12_RESOURCE_STATES state;
+        UINT64 size;
+        UINT64 alignment;
+        // The first and the last position in the order that use the resource, UINT_MAX while unused.
+        UINT firstPosition;
+        UINT lastPosition;
+        UINT64 offset;
+    };
+
+    std::vector<Pass> passes;
+    std::vector<Resource> resources;
+    std::vector<UINT> order;
+    std::vector<RenderGraphBarrier> finalBarriers;
+    UINT64 transientSize;
+    UINT64 aliasedSize;
+
+    Access& FindAccess(UINT pass, UINT resource);
+    BOOL CompileBarriers();
+    void AliasTransientResources();
+
+public:
+    RenderGraph();
+
+    // Clear the passes and the resources, to declare the next frame.
+    void Reset();
+    UINT ImportResource(D3D12_RESOURCE_STATES state);
+    UINT CreateTransientResource(UINT64 size, UINT64 alignment);
+    // Passes with side effects, such as a readback, are kept even if nothing reads what they write.
+    UINT AddPass(BOOL hasSideEffects = FALSE);
+    // A pass uses each resource in one state, which covers all it declares. A pass that reads and writes
+    // a resource reads what was written before it.
+    void Read(UINT pass, UINT resource, D3D12_RESOURCE_STATES state);
+    void Write(UINT pass, UINT resource, D3D12_RESOURCE_STATES state);
+
+    // Returns FALSE if a pass writes in a read-only state, or reads a transient resource nothing wrote.
+    BOOL Compile();
+    // Whether transient resources placed at these offsets keep the ones that are alive together apart.
+    BOOL IsAliasingValid(const UINT64* pOffsets) const;
+
+    // The passes to record, in order. Passes run in the order they are declared, which already follows
+    // what they read, so compiling only drops passes.
+    inline const std::vector<UINT>& GetOrder() const { return order; }
+    inline const BOOL IsCulled(UINT pass) const { return passes[pass].isCulled; }
+    // The barriers to record before a pass, and the ones that end the frame.
+    inline const std::vector<RenderGraphBarrier>& GetBarriers(UINT pass) const { return passes[pass].barriers; }
+    inline const std::vector<RenderGraphBarrier>& GetFinalBarriers() const { return finalBarriers; }
+
+    inline const UINT GetPassesNum() const { return static_cast<UINT>(passes.size()); }
+    inline const UINT GetResourcesNum() const { return static_cast<UINT>(resources.size()); }
+    inline const BOOL IsTransient(UINT resource) const { return resources[resource].isTransient; }
+    inline const UINT64 GetOffset(UINT resource) const { return resources[resource].offset; }
+    // The memory of the transient resources used, apart and aliased.
+    inline const UINT64 GetTransientSize() const { return transientSize; }
+    inline const UINT64 GetAliasedSize() const { return aliasedSize; }
+};
@@ -0,0 +1,218 @@
+#include "stdafx.h"
+#include "ResourceStateTracker.h"
+
+ResourceStateTracker::ResourceStateTracker() :
+    requestsNum(0),
+    barriersNum(0)
+{
+
+}
+
+void ResourceStateTracker::Register(ID3D12Resource* pResource, D3D12_RESOURCE_STATES state, UINT subresourcesNum)
+{
+    // An address can be reused by a new resource, which starts with nothing left of the old one.
+    Unregister(pResource);
+
+    TrackedResource& resource = resources[pResource];
+    resource.states.assign(max(subresourcesNum, 1u), state);
+    resource.isPending = FALSE;
+    resource.isPendingSplit = FALSE;
+}
+
+void ResourceStateTracker::Unregister(ID3D12Resource* pResource)
+{
+    if (resources.erase(pResource) == 0)
+    {
+        return;
+    }
+
+    pendingResources.erase(std::remove(pendingResources.begin(), pendingResources.end(), pResource),
+        pendingResources.end());
+    splitResources.erase(std::remove(splitResources.begin(), splitResources.end(), pResource),
+        splitResources.end());
+}
+
+BOOL ResourceStateTracker::IsRegistered(ID3D12Resource* pResource) const
+{
+    return resources.find(pResource) != resources.end();
+}
+
+BOOL ResourceStateTracker::Transition(ID3D12Resource* pResource, D3D12_RESOURCE_STATES state, UINT subresource)
+{
+    TrackedResource* pTrackedResource = Request(pResource);
+    if (pTrackedResource == nullptr)
+    {
+        return FALSE;
+    }
+
+    // The work that needs it comes with the next batch, which is too soon to split.
+    pTrackedResource->isPendingSplit = FALSE;
+    if (subresource == D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES)
+    {
+        std::fill(pTrackedResource->pendingStates.begin(), pTrackedResource->pendingStates.end(), state);
+        return TRUE;
+    }
+
+    if (subresource >= pTrackedResource->pendingStates.size())
+    {
+        return FALSE;
+    }
+    pTrackedResource->pendingStates[subresource] = state;
+
+    return TRUE;
+}
+
+BOOL ResourceStateTracker::BeginTransition(ID3D12Resource* pResource, D3D12_RESOURCE_STATES state)
+{
+    auto it = resources.find(pResource);
+    const BOOL isPending = it != resources.end() && it->second.isPending;
+    TrackedResource* pTrackedResource = Request(pResource);
+    if (pTrackedResource == nullptr)
+    {
+        return FALSE;
+    }
+
+    // A split that has not been ended yet is ended by this request, which then has to complete with it.
+    pTrackedResource->isPendingSplit = (isPending ? pTrackedResource->isPendingSplit : TRUE)
+        && pTrackedResource->splitStates.empty();
+    std::fill(pTrackedResource->pendingStates.begin(), pTrackedResource->pendingStates.end(), state);
+
+    return TRUE;
+}
+
+void ResourceStateTracker::Flush(std::vector<D3D12_RESOURCE_BARRIER>& barriers)
+{
+    for (ID3D12Resource* pResource : pendingResources)
+    {
+        FlushResource(pResource, resources[pResource], barriers);
+    }
+    pendingResources.clear();
+}
+
+void ResourceStateTracker::Flush(
+    std::vector<D3D12_RESOURCE_BARRIER>& barriers,
+    ID3D12Resource* const* ppResources,
+    UINT resourcesNum)
+{
+    for (UINT i = 0; i < resourcesNum; i++)
+    {
+        auto it = resources.find(ppResources[i]);
+        if (it == resources.end() || it->second.isPending == FALSE)
+        {
+            continue;
+        }
+
+        FlushResource(ppResources[i], it->second, barriers);
+        pendingResources.erase(std::find(pendingResources.begin(), pendingResources.end(), ppResources[i]));
+    }
+}
+
+void ResourceStateTracker::Finish(std::vector<D3D12_RESOURCE_BARRIER>& barriers)
+{
+    Flush(barriers);
+
+    std::vector<ID3D12Resource*> splits;
+    splits.swap(splitResources);
+    for (ID3D12Resource* pResource : splits)
+    {
+        EndSplit(pResource, resources[pResource], barriers);
+    }
+}
+
+// Helper functions.
+ResourceStateTracker::TrackedResource* ResourceStateTracker::Request(ID3D12Resource* pResource)
+{
+    auto it = resources.find(pResource);
+    if (it == resources.end())
+    {
+        return nullptr;
+    }
+
+    requestsNum++;
+    TrackedResource& resource = it->second;
+    if (resource.isPending == FALSE)
+    {
+        resource.isPending = TRUE;
+        resource.isPendingSplit = FALSE;
+        resource.pendingStates = resource.states;
+        pendingResources.push_back(pResource);
+    }
+
+    return &resource;
+}
+
+void ResourceStateTracker::FlushResource(
+    ID3D12Resource* pResource,
+    TrackedResource& resource,
+    std::vector<D3D12_RESOURCE_BARRIER>& barriers)
+{
+    // The resource is needed again, so a split begun before has to end first.
+    if (resource.splitStates.empty() == FALSE)
+    {
+        EndSplit(pResource, resource, barriers);
+        splitResources.erase(std::find(splitResources.begin(), splitResources.end(), pResource));
+    }
+
+    D3D12_RESOURCE_BARRIER_FLAGS flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+    if (resource.isPendingSplit && resource.pendingStates != resource.states)
+    {
+        flags = D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY;
+        resource.splitStates = resource.states;
+        splitResources.push_back(pResource);
+    }
+
+    AppendBarriers(pResource, resource.states, resource.pendingStates, flags, barriers);
+    resource.states.swap(resource.pendingStates);
+    resource.isPending = FALSE;
+    resource.isPendingSplit = FALSE;
+}
+
+void ResourceStateTracker::EndSplit(
+    ID3D12Resource* pResource,
+    TrackedResource& resource,
+    std::vector<D3D12_RESOURCE_BARRIER>& barriers)
+{
+    AppendBarriers(pResource, resource.splitStates, resource.states, D3D12_RESOURCE_BARRIER_FLAG_END_ONLY, barriers);
+    resource.splitStates.clear();
+}
+
+void ResourceStateTracker::AppendBarriers(
+    ID3D12Resource* pResource,
+    const std::vector<D3D12_RESOURCE_STATES>& before,
+    const std::vector<D3D12_RESOURCE_STATES>& after,
+    D3D12_RESOURCE_BARRIER_FLAGS flags,
+    std::vector<D3D12_RESOURCE_BARRIER>& barriers)
+{
+    D3D12_RESOURCE_BARRIER barrier = {};
+    barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+    barrier.Flags = flags;
+    barrier.Transition.pResource = pResource;
+
+    const BOOL isUniform =
+        std::count(before.begin(), before.end(), before[0]) == static_cast<INT64>(before.size())
+        && std::count(after.begin(), after.end(), after[0]) == static_cast<INT64>(after.size());
+    if (isUniform)
+    {
+        if (before[0] != after[0])
+        {
+            barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+            barrier.Transition.StateBefore = before[0];
+            barrier.Transition.StateAfter = after[0];
+            barriers.push_back(barrier);
+            barriersNum++;
+        }
+        return;
+    }
+
+    for (UINT i = 0; i < before.size(); i++)
+    {
+        if (before[i] != after[i])
+        {
+            barrier.Transition.Subresource = i;
+            barrier.Transition.StateBefore = before[i];
+            barrier.Transition.StateAfter = after[i];
+            barriers.push_back(barrier);
+            barriersNum++;
+        }
+    }
+}
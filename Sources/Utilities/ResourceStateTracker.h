@@ -0,0 +1,82 @@
+#pragma once
+#include <unordered_map>
+#include <vector>
+
+// Tracks the state of each subresource of the resources recorded in a command list, and turns the states
+// they are needed in into the transition barriers that get them there. Requests are batched until the
+// work that needs them is recorded, so a resource asked for twice in a batch only moves once, and a
+// resource asked back into the state it is in does not move at all.
+// It only deals in barrier descriptions, so it records no GPU work and can be used without a device.
+class ResourceStateTracker
+{
+private:
+    struct TrackedResource
+    {
+        // The state of each subresource after the barriers handed out so far.
+        std::vector<D3D12_RESOURCE_STATES> states;
+        // The states requested for the next batch, while the resource is pending.
+        std::vector<D3D12_RESOURCE_STATES> pendingStates;
+        // The states a split transition was begun from, while it has not been ended.
+        std::vector<D3D12_RESOURCE_STATES> splitStates;
+        BOOL isPending;
+        BOOL isPendingSplit;
+    };
+
+    std::unordered_map<ID3D12Resource*, TrackedResource> resources;
+    // Resources with requests in the order they were first requested, and the ones with a split begun.
+    std::vector<ID3D12Resource*> pendingResources;
+    std::vector<ID3D12Resource*> splitResources;
+
+    UINT64 requestsNum;
+    UINT64 barriersNum;
+
+    TrackedResource* Request(ID3D12Resource* pResource);
+    void FlushResource(ID3D12Resource* pResource, TrackedResource& resource,
+        std::vector<D3D12_RESOURCE_BARRIER>& barriers);
+    void EndSplit(ID3D12Resource* pResource, TrackedResource& resource,
+        std::vector<D3D12_RESOURCE_BARRIER>& barriers);
+    // Append the barriers from the before to the after states of the subresources, one for the whole
+    // resource when every subresource moves from and to the same state.
+    void AppendBarriers(
+        ID3D12Resource* pResource,
+        const std::vector<D3D12_RESOURCE_STATES>& before,
+        const std::vector<D3D12_RESOURCE_STATES>& after,
+        D3D12_RESOURCE_BARRIER_FLAGS flags,
+        std::vector<D3D12_RESOURCE_BARRIER>& barriers);
+
+public:
+    ResourceStateTracker();
+
+    // Track a resource created in a state, textures with a state for each of their subresources.
+    void Register(ID3D12Resource* pResource, D3D12_RESOURCE_STATES state, UINT subresourcesNum = 1);
+    // Stop tracking a resource, which must not have work left to record.
+    void Unregister(ID3D12Resource* pResource);
+    BOOL IsRegistered(ID3D12Resource* pResource) const;
+
+    // Request a subresource, or all of them, in a state for the next work. Returns FALSE if the resource is not tracked.
+    BOOL Transition(
+        ID3D12Resource* pResource,
+        D3D12_RESOURCE_STATES state,
+        UINT subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES);
+    // Request a resource in a state it is not used in until it is requested again, or the command list ends.
+    // The transition is split, begun with the next batch and ended with the one that needs the resource.
+    BOOL BeginTransition(ID3D12Resource* pResource, D3D12_RESOURCE_STATES state);
+
+    // Append the barriers requested since the last batch.
+    void Flush(std::vector<D3D12_RESOURCE_BARRIER>& barriers);
+    // Append the barriers requested for some of the resources, such as the ones of a copy. The requests for the
+    // other resources stay in the batch, where later requests can still cancel them.
+    void Flush(std::vector<D3D12_RESOURCE_BARRIER>& barriers, ID3D12Resource* const* ppResources, UINT resourcesNum);
+    // Append the barriers that leave every resource in its requested state, before the command list is closed.
+    void Finish(std::vector<D3D12_RESOURCE_BARRIER>& barriers);
+
+    inline const UINT GetSize() const { return static_cast<UINT>(resources.size()); }
+    // Transitions requested and barriers handed out, since the counters were last reset.
+    inline const UINT64 GetRequestsNum() const { return requestsNum; }
+    inline const UINT64 GetBarriersNum() const { return barriersNum; }
+    inline void ResetCounters()
+    {
+        requestsNum = 0;
+        barriersNum = 0;
+    }
+};
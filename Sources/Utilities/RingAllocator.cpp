@@ -0,0 +1,77 @@
+#include "stdafx.h"
+#include "RingAllocator.h"
+
+RingAllocator::RingAllocator(UINT64 inCapacity) :
+    capacity(inCapacity),
+    head(0),
+    tail(0),
+    usedSize(0),
+    pendingSize(0)
+{
+
+}
+
+BOOL RingAllocator::Allocate(UINT64 size, UINT64 alignment, UINT64& offset)
+{
+    const UINT64 start = (head + alignment - 1) & ~(alignment - 1);
+    UINT64 end = start + size;
+
+    if (usedSize == 0 || head > tail)
+    {
+        // The free room is from the head to the end of the block, and from its start to the tail.
+        if (end > capacity)
+        {
+            if (size > tail)
+            {
+                return FALSE;
+            }
+
+            // Skip the end of the block, it is freed with this batch.
+            offset = 0;
+            end = size;
+            pendingSize += capacity - head + size;
+            usedSize += capacity - head + size;
+            head = end;
+            return TRUE;
+        }
+    }
+    else if (end > tail)
+    {
+        // The free room is from the head to the tail.
+        return FALSE;
+    }
+
+    offset = start;
+    pendingSize += end - head;
+    usedSize += end - head;
+    head = end;
+    return TRUE;
+}
+
+void RingAllocator::Retire(UINT64 fenceValue)
+{
+    if (pendingSize == 0)
+    {
+        return;
+    }
+
+    retiredBatches.push_back({ fenceValue, head, pendingSize });
+    pendingSize = 0;
+}
+
+void RingAllocator::Release(UINT64 completedFenceValue)
+{
+    while (!retiredBatches.empty() && retiredBatches.front().fenceValue <= completedFenceValue)
+    {
+        tail = retiredBatches.front().end;
+        usedSize -= retiredBatches.front().size;
+        retiredBatches.pop_front();
+    }
+
+    // Start over from the beginning of the block once it is empty, so large allocations do not wrap.
+    if (usedSize == 0)
+    {
+        head = 0;
+        tail = 0;
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <deque>
+
+// Sub-allocates aligned ranges of a block of memory in order, wrapping around at its end. It only
+// deals in offsets, so it does not own the memory and does no GPU work.
+// The allocations made since the last retirement are retired together with the fence value the GPU
+// signals after it has read them, and their room is reused once that fence value has completed.
+class RingAllocator
+{
+private:
+    struct Batch
+    {
+        UINT64 fenceValue;
+        // The end of the last allocation of the batch, the oldest allocation in use once it is released.
+        UINT64 end;
+        // Bytes of the batch, with the padding and the end of the block skipped when it wrapped.
+        UINT64 size;
+    };
+
+    UINT64 capacity;
+    UINT64 head;
+    UINT64 tail;
+    UINT64 usedSize;
+    UINT64 pendingSize;
+    std::deque<Batch> retiredBatches;
+
+public:
+    RingAllocator(UINT64 inCapacity);
+
+    // Allocate size bytes at an offset that is a multiple of alignment, a power of two.
+    // Returns FALSE if there is no room until more batches are released.
+    BOOL Allocate(UINT64 size, UINT64 alignment, UINT64& offset);
+    // Close the batch of the allocations since the last retirement, which the GPU is done with at fenceValue.
+    void Retire(UINT64 fenceValue);
+    // Free the batches whose fence value has completed.
+    void Release(UINT64 completedFenceValue);
+
+    inline const UINT64 GetCapacity() const { return capacity; }
+    inline const UINT64 GetUsedSize() const { return usedSize; }
+};
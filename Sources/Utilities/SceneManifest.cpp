@@ -0,0 +1,271 @@
+#include "stdafx.h"
+#include "SceneManifest.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <sstream>
+
+SceneManifest::SceneManifest() :
+    pHeader(nullptr),
+    rehashedAssetsNum(0)
+{
+
+}
+
+SceneManifest::~SceneManifest()
+{
+
+}
+
+std::wstring SceneManifest::GetManifestPath(const std::wstring& scenePath)
+{
+    return scenePath + L".bin";
+}
+
+UINT64 SceneManifest::HashFile(const std::wstring& path)
+{
+    MappedFile file;
+    if (!file.Open(path))
+    {
+        return MappedFile::Exists(path) ? HashData(nullptr, 0) : 0;
+    }
+
+    return HashData(file.GetData(), file.GetSize());
+}
+
+UINT64 SceneManifest::HashData(const BYTE* pData, UINT64 size)
+{
+    // FNV-1a.
+    UINT64 hash = 14695981039346656037ULL;
+    for (UINT64 i = 0; i < size; i++)
+    {
+        hash = (hash ^ pData[i]) * 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+BOOL SceneManifest::Convert(const std::wstring& scenePath, const std::wstring& manifestPath, UINT64 sourceTimestamp)
+{
+    // The text scene is read as bytes widened to characters, the same as a wide file stream in the C locale.
+    MappedFile sceneFile;
+    if (!sceneFile.Open(scenePath))
+    {
+        return FALSE;
+    }
+    std::wistringstream inFile(std::wstring(sceneFile.GetData(), sceneFile.GetData() + sceneFile.GetSize()));
+    sceneFile.Close();
+
+    std::wstring directory = scenePath.substr(0, scenePath.find_last_of(L"\\/") + 1);
+    std::vector<WCHAR> names;
+    auto addAsset = [&names, &directory](std::vector<SceneManifestAsset>& assets, const std::wstring& name)
+    {
+        SceneManifestAsset asset = {};
+        asset.nameOffset = static_cast<UINT>(names.size() * sizeof(WCHAR));
+        // The source is looked at before it is hashed, so a change while it is hashed is seen on the next load.
+        MappedFile::GetStatus(directory + name, asset.sourceSize, asset.sourceTimestamp);
+        asset.contentHash = HashFile(directory + name);
+        names.insert(names.end(), name.c_str(), name.c_str() + name.size() + 1);
+        assets.push_back(asset);
+    };
+
+    std::vector<SceneManifestAsset> materials;
+    std::vector<std::wstring> materialNames;
+    UINT materialsNum = 0;
+    inFile >> materialsNum;
+    for (UINT i = 0; i < materialsNum && inFile; i++)
+    {
+        std::wstring name;
+        inFile >> name;
+        addAsset(materials, name);
+        materialNames.push_back(EraseSuffix(name.c_str()));
+    }
+
+    std::vector<SceneManifestAsset> meshes;
+    std::vector<std::wstring> meshNames;
+    UINT meshesNum = 0;
+    inFile >> meshesNum;
+    for (UINT i = 0; i < meshesNum && inFile; i++)
+    {
+        std::wstring name;
+        inFile >> name;
+        addAsset(meshes, name);
+        meshNames.push_back(EraseSuffix(name.c_str()));
+    }
+
+    if (!inFile || materials.empty())
+    {
+        return FALSE;
+    }
+
+    std::vector<SceneManifestObject> objects;
+    UINT objectsNum = 0;
+    if (inFile >> objectsNum)
+    {
+        for (UINT i = 0; i < objectsNum; i++)
+        {
+            SceneManifestObject object = {};
+            XMFLOAT3 angles = {};
+            inFile >> object.meshIndex >> object.materialIndex
+                >> object.position.x >> object.position.y >> object.position.z
+                >> angles.x >> angles.y >> angles.z
+                >> object.scale.x >> object.scale.y >> object.scale.z;
+            if (!inFile || object.meshIndex >= meshes.size() || object.materialIndex >= materials.size())
+            {
+                return FALSE;
+            }
+
+            XMStoreFloat4(&object.rotation, XMQuaternionRotationRollPitchYaw(
+                XMConvertToRadians(angles.x), XMConvertToRadians(angles.y), XMConvertToRadians(angles.z)));
+            objects.push_back(object);
+        }
+    }
+    else
+    {
+        // Bind each mesh to the material of the same name as the text scene used to.
+        for (UINT i = 0; i < meshes.size(); i++)
+        {
+            auto it = std::find(materialNames.begin(), materialNames.end(), meshNames[i]);
+            SceneManifestObject object = {};
+            object.meshIndex = i;
+            object.materialIndex = it != materialNames.end() ? static_cast<UINT>(it - materialNames.begin()) : 0;
+            object.position = XMFLOAT3(0.0f, 0.0f, 0.0f);
+            object.rotation = XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f);
+            object.scale = XMFLOAT3(1.0f, 1.0f, 1.0f);
+            objects.push_back(object);
+        }
+    }
+
+    SceneManifestHeader header = {};
+    header.magic = SCENE_MANIFEST_MAGIC;
+    header.version = SCENE_MANIFEST_VERSION;
+    header.materialsNum = static_cast<UINT>(materials.size());
+    header.materialsOffset = Align(sizeof(SceneManifestHeader), SCENE_MANIFEST_SECTION_ALIGNMENT);
+    header.meshesNum = static_cast<UINT>(meshes.size());
+    header.meshesOffset = Align(header.materialsOffset + header.materialsNum * sizeof(SceneManifestAsset),
+        SCENE_MANIFEST_SECTION_ALIGNMENT);
+    header.objectsNum = static_cast<UINT>(objects.size());
+    header.objectsOffset = Align(header.meshesOffset + header.meshesNum * sizeof(SceneManifestAsset),
+        SCENE_MANIFEST_SECTION_ALIGNMENT);
+    header.namesSize = static_cast<UINT>(names.size() * sizeof(WCHAR));
+    header.namesOffset = Align(header.objectsOffset + header.objectsNum * sizeof(SceneManifestObject),
+        SCENE_MANIFEST_SECTION_ALIGNMENT);
+    header.sourceTimestamp = sourceTimestamp;
+
+    std::vector<BYTE> manifest(header.namesOffset + header.namesSize, 0);
+    memcpy(manifest.data(), &header, sizeof(SceneManifestHeader));
+    memcpy(manifest.data() + header.materialsOffset, materials.data(), materials.size() * sizeof(SceneManifestAsset));
+    if (meshes.size() > 0)
+    {
+        memcpy(manifest.data() + header.meshesOffset, meshes.data(), meshes.size() * sizeof(SceneManifestAsset));
+    }
+    if (objects.size() > 0)
+    {
+        memcpy(manifest.data() + header.objectsOffset, objects.data(), objects.size() * sizeof(SceneManifestObject));
+    }
+    memcpy(manifest.data() + header.namesOffset, names.data(), header.namesSize);
+
+    return MappedFile::Write(manifestPath, manifest.data(), manifest.size());
+}
+
+BOOL SceneManifest::Load(const std::wstring& manifestPath, UINT64 sourceTimestamp)
+{
+    pHeader = nullptr;
+    rehashedAssetsNum = 0;
+
+    MappedFile file;
+    if (!file.Open(manifestPath))
+    {
+        return FALSE;
+    }
+
+    const UINT64 size = file.GetSize();
+    if (size < sizeof(SceneManifestHeader) || size > UINT_MAX)
+    {
+        return FALSE;
+    }
+
+    data.assign(file.GetData(), file.GetData() + size);
+    file.Close();
+
+    const SceneManifestHeader* pData = reinterpret_cast<const SceneManifestHeader*>(data.data());
+    const UINT64 materialsSize = static_cast<UINT64>(pData->materialsNum) * sizeof(SceneManifestAsset);
+    const UINT64 meshesSize = static_cast<UINT64>(pData->meshesNum) * sizeof(SceneManifestAsset);
+    const UINT64 objectsSize = static_cast<UINT64>(pData->objectsNum) * sizeof(SceneManifestObject);
+
+    // A stale or foreign file is treated as missing so the caller converts the text scene again.
+    if (pData->magic != SCENE_MANIFEST_MAGIC
+        || pData->version != SCENE_MANIFEST_VERSION
+        || (sourceTimestamp != 0 && pData->sourceTimestamp != sourceTimestamp)
+        || pData->materialsOffset + materialsSize > size
+        || pData->meshesOffset + meshesSize > size
+        || pData->objectsOffset + objectsSize > size
+        || static_cast<UINT64>(pData->namesOffset) + pData->namesSize > size
+        || pData->namesSize < sizeof(WCHAR))
+    {
+        return FALSE;
+    }
+
+    // References are checked once here so the accessors can index without checks.
+    const LPCWSTR pNames = reinterpret_cast<LPCWSTR>(data.data() + pData->namesOffset);
+    if (pNames[pData->namesSize / sizeof(WCHAR) - 1] != L'\0')
+    {
+        return FALSE;
+    }
+
+    const SceneManifestAsset* pAssets = reinterpret_cast<const SceneManifestAsset*>(data.data() + pData->materialsOffset);
+    for (UINT i = 0; i < pData->materialsNum; i++)
+    {
+        if (pAssets[i].nameOffset >= pData->namesSize)
+        {
+            return FALSE;
+        }
+    }
+    pAssets = reinterpret_cast<const SceneManifestAsset*>(data.data() + pData->meshesOffset);
+    for (UINT i = 0; i < pData->meshesNum; i++)
+    {
+        if (pAssets[i].nameOffset >= pData->namesSize)
+        {
+            return FALSE;
+        }
+    }
+    const SceneManifestObject* pObjects = reinterpret_cast<const SceneManifestObject*>(data.data() + pData->objectsOffset);
+    for (UINT i = 0; i < pData->objectsNum; i++)
+    {
+        if (pObjects[i].meshIndex >= pData->meshesNum || pObjects[i].materialIndex >= pData->materialsNum)
+        {
+            return FALSE;
+        }
+    }
+
+    pHeader = pData;
+    ValidateAssets(manifestPath,
+        reinterpret_cast<SceneManifestAsset*>(data.data() + pData->materialsOffset), pData->materialsNum);
+    ValidateAssets(manifestPath,
+        reinterpret_cast<SceneManifestAsset*>(data.data() + pData->meshesOffset), pData->meshesNum);
+    if (rehashedAssetsNum > 0)
+    {
+        MappedFile::Write(manifestPath, data.data(), data.size());
+    }
+
+    return TRUE;
+}
+
+void SceneManifest::ValidateAssets(const std::wstring& manifestPath, SceneManifestAsset* pAssets, UINT assetsNum)
+{
+    const std::wstring directory = manifestPath.substr(0, manifestPath.find_last_of(L"\\/") + 1);
+    for (UINT i = 0; i < assetsNum; i++)
+    {
+        SceneManifestAsset& asset = pAssets[i];
+        const std::wstring path = directory + GetName(asset);
+        UINT64 size = 0;
+        UINT64 timestamp = 0;
+        MappedFile::GetStatus(path, size, timestamp);
+        if (size != asset.sourceSize || timestamp != asset.sourceTimestamp)
+        {
+            asset.sourceSize = size;
+            asset.sourceTimestamp = timestamp;
+            asset.contentHash = HashFile(path);
+            rehashedAssetsNum++;
+        }
+    }
+}
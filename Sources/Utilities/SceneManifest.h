@@ -0,0 +1,98 @@
+#pragma once
+
+// Binary scene manifest layout:
+// SceneManifestHeader | SceneManifestAsset[materialsNum] | SceneManifestAsset[meshesNum]
+//     | SceneManifestObject[objectsNum] | names
+// Names are null terminated wide strings that assets reference by their offset in the names section.
+// Sections are 16 bytes aligned so they can be read in place.
+#define SCENE_MANIFEST_MAGIC 0x454E4353 // "SCNE"
+#define SCENE_MANIFEST_VERSION 2
+#define SCENE_MANIFEST_SECTION_ALIGNMENT 16
+
+struct SceneManifestHeader
+{
+    UINT magic;
+    UINT version;
+    UINT materialsNum;
+    UINT materialsOffset;
+    UINT meshesNum;
+    UINT meshesOffset;
+    UINT objectsNum;
+    UINT objectsOffset;
+    UINT namesSize;
+    UINT namesOffset;
+    UINT64 sourceTimestamp;
+};
+
+// A source asset and the hash of its content, which keys the data cooked from it. The size and the last
+// write time are the ones the source had when it was hashed, it is hashed again when either changes.
+struct SceneManifestAsset
+{
+    UINT nameOffset;
+    UINT padding;
+    UINT64 contentHash;
+    UINT64 sourceSize;
+    UINT64 sourceTimestamp;
+};
+
+struct SceneManifestObject
+{
+    UINT meshIndex;
+    UINT materialIndex;
+    XMFLOAT3 position;
+    XMFLOAT4 rotation;
+    XMFLOAT3 scale;
+};
+
+class SceneManifest
+{
+private:
+    std::vector<BYTE> data;
+    const SceneManifestHeader* pHeader;
+    UINT rehashedAssetsNum;
+
+    // Hash the assets again whose source changed since they were hashed, and write the manifest back
+    // when any did. Assets are found next to the manifest.
+    void ValidateAssets(const std::wstring& manifestPath, SceneManifestAsset* pAssets, UINT assetsNum);
+
+public:
+    SceneManifest();
+    ~SceneManifest();
+
+    static std::wstring GetManifestPath(const std::wstring& scenePath);
+    // FNV-1a hash of the content of a file, or 0 when it can not be read.
+    static UINT64 HashFile(const std::wstring& path);
+    static UINT64 HashData(const BYTE* pData, UINT64 size);
+
+    // Convert the text scene into a binary manifest. The text scene lists the materials and the meshes
+    // by count and file name, then optionally the objects by count and one line per object:
+    // meshIndex materialIndex positionX positionY positionZ pitch yaw roll scaleX scaleY scaleZ
+    // with the angles in degrees. Without objects every mesh is placed once at the origin and bound
+    // to the material of the same name.
+    static BOOL Convert(const std::wstring& scenePath, const std::wstring& manifestPath, UINT64 sourceTimestamp);
+
+    // Read the manifest with one read, and hash the assets again that changed since. Fails if the file is
+    // missing, corrupted or older than the text scene.
+    BOOL Load(const std::wstring& manifestPath, UINT64 sourceTimestamp);
+
+    inline const UINT GetMaterialsNum() const { return pHeader->materialsNum; }
+    inline const UINT GetMeshesNum() const { return pHeader->meshesNum; }
+    inline const UINT GetObjectsNum() const { return pHeader->objectsNum; }
+    inline const UINT GetRehashedAssetsNum() const { return rehashedAssetsNum; }
+    inline const SceneManifestAsset& GetMaterial(UINT index) const
+    {
+        return reinterpret_cast<const SceneManifestAsset*>(data.data() + pHeader->materialsOffset)[index];
+    }
+    inline const SceneManifestAsset& GetMesh(UINT index) const
+    {
+        return reinterpret_cast<const SceneManifestAsset*>(data.data() + pHeader->meshesOffset)[index];
+    }
+    inline const SceneManifestObject& GetSceneObject(UINT index) const
+    {
+        return reinterpret_cast<const SceneManifestObject*>(data.data() + pHeader->objectsOffset)[index];
+    }
+    inline LPCWSTR GetName(const SceneManifestAsset& asset) const
+    {
+        return reinterpret_cast<LPCWSTR>(data.data() + pHeader->namesOffset + asset.nameOffset);
+    }
+};
@@ -0,0 +1,278 @@
+#include "stdafx.h"
+#include "TLSFAllocator.h"
+#include <intrin.h>
+
+// The callers only scan non-zero maps and sizes, a zero value gives bit 0 rather than an unset index.
+static inline UINT GetHighestBit(UINT64 value)
+{
+    unsigned long index = 0;
+    if (!_BitScanReverse64(&index, value))
+    {
+        return 0;
+    }
+    return index;
+}
+
+static inline UINT GetLowestBit(UINT64 value)
+{
+    unsigned long index = 0;
+    if (!_BitScanForward64(&index, value))
+    {
+        return 0;
+    }
+    return index;
+}
+
+TLSFAllocator::TLSFAllocator(UINT64 inCapacity, UINT64 inGranularity) :
+    capacity(inCapacity / inGranularity * inGranularity),
+    granularity(inGranularity),
+    usedSize(0),
+    allocationsNum(0),
+    firstLevelMap(0)
+{
+    for (UINT i = 0; i < TLSF_FIRST_LEVEL_COUNT; i++)
+    {
+        secondLevelMaps[i] = 0;
+        for (UINT j = 0; j < TLSF_SECOND_LEVEL_COUNT; j++)
+        {
+            freeLists[i][j] = TLSF_INVALID_BLOCK;
+        }
+    }
+
+    if (capacity > 0)
+    {
+        InsertFreeBlock(CreateBlock(0, capacity));
+    }
+}
+
+BOOL TLSFAllocator::Allocate(UINT64 size, UINT64 alignment, TLSFAllocation& allocation)
+{
+    size = max((size + granularity - 1) / granularity * granularity, granularity);
+    alignment = max(alignment, granularity);
+
+    // Blocks that are not aligned need room for the padding in front of the allocation.
+    UINT block = FindFreeBlock(size + alignment - granularity);
+    if (block == TLSF_INVALID_BLOCK)
+    {
+        return FALSE;
+    }
+    RemoveFreeBlock(block);
+
+    const UINT64 offset = (blocks[block].offset + alignment - 1) & ~(alignment - 1);
+    if (offset > blocks[block].offset)
+    {
+        InsertFreeBlock(SplitBlock(block, offset - blocks[block].offset));
+    }
+    if (blocks[block].size > size)
+    {
+        const UINT used = SplitBlock(block, size);
+        InsertFreeBlock(block);
+        block = used;
+    }
+
+    blocks[block].isFree = FALSE;
+    usedSize += size;
+    allocationsNum++;
+    allocation = { offset, size, block };
+    return TRUE;
+}
+
+void TLSFAllocator::Free(const TLSFAllocation& allocation)
+{
+    UINT block = allocation.block;
+    usedSize -= blocks[block].size;
+    allocationsNum--;
+
+    // Merge with the free neighbours, so free ranges never touch.
+    const UINT previous = blocks[block].previousPhysical;
+    if (previous != TLSF_INVALID_BLOCK && blocks[previous].isFree)
+    {
+        RemoveFreeBlock(previous);
+        blocks[block].offset = blocks[previous].offset;
+        blocks[block].size += blocks[previous].size;
+        blocks[block].previousPhysical = blocks[previous].previousPhysical;
+        if (blocks[block].previousPhysical != TLSF_INVALID_BLOCK)
+        {
+            blocks[blocks[block].previousPhysical].nextPhysical = block;
+        }
+        unusedBlocks.push_back(previous);
+    }
+
+    const UINT next = blocks[block].nextPhysical;
+    if (next != TLSF_INVALID_BLOCK && blocks[next].isFree)
+    {
+        RemoveFreeBlock(next);
+        blocks[block].size += blocks[next].size;
+        blocks[block].nextPhysical = blocks[next].nextPhysical;
+        if (blocks[block].nextPhysical != TLSF_INVALID_BLOCK)
+        {
+            blocks[blocks[block].nextPhysical].previousPhysical = block;
+        }
+        unusedBlocks.push_back(next);
+    }
+
+    InsertFreeBlock(block);
+}
+
+UINT64 TLSFAllocator::GetLargestFreeSize() const
+{
+    if (firstLevelMap == 0)
+    {
+        return 0;
+    }
+
+    // The largest block is in the highest class that has any.
+    const UINT firstLevel = GetHighestBit(firstLevelMap);
+    const UINT secondLevel = GetHighestBit(secondLevelMaps[firstLevel]);
+    UINT64 size = 0;
+    for (UINT block = freeLists[firstLevel][secondLevel]; block != TLSF_INVALID_BLOCK; block = blocks[block].nextFree)
+    {
+        size = max(size, blocks[block].size);
+    }
+
+    return size;
+}
+
+// Helper functions.
+void TLSFAllocator::GetClass(UINT64 size, UINT& firstLevel, UINT& secondLevel)
+{
+    if (size < TLSF_SECOND_LEVEL_COUNT)
+    {
+        firstLevel = 0;
+        secondLevel = static_cast<UINT>(size);
+        return;
+    }
+
+    const UINT highestBit = GetHighestBit(size);
+    firstLevel = highestBit - TLSF_SECOND_LEVEL_BITS + 1;
+    secondLevel = static_cast<UINT>(size >> (highestBit - TLSF_SECOND_LEVEL_BITS)) - TLSF_SECOND_LEVEL_COUNT;
+}
+
+UINT TLSFAllocator::CreateBlock(UINT64 offset, UINT64 size)
+{
+    UINT block = static_cast<UINT>(blocks.size());
+    if (!unusedBlocks.empty())
+    {
+        block = unusedBlocks.back();
+        unusedBlocks.pop_back();
+    }
+    else
+    {
+        blocks.emplace_back();
+    }
+
+    blocks[block] = { offset, size, TLSF_INVALID_BLOCK, TLSF_INVALID_BLOCK, TLSF_INVALID_BLOCK, TLSF_INVALID_BLOCK, FALSE };
+    return block;
+}
+
+void TLSFAllocator::InsertFreeBlock(UINT block)
+{
+    UINT firstLevel, secondLevel;
+    GetClass(blocks[block].size / granularity, firstLevel, secondLevel);
+
+    const UINT head = freeLists[firstLevel][secondLevel];
+    blocks[block].isFree = TRUE;
+    blocks[block].previousFree = TLSF_INVALID_BLOCK;
+    blocks[block].nextFree = head;
+    if (head != TLSF_INVALID_BLOCK)
+    {
+        blocks[head].previousFree = block;
+    }
+
+    freeLists[firstLevel][secondLevel] = block;
+    firstLevelMap |= 1ull << firstLevel;
+    secondLevelMaps[firstLevel] |= 1u << secondLevel;
+}
+
+void TLSFAllocator::RemoveFreeBlock(UINT block)
+{
+    UINT firstLevel, secondLevel;
+    GetClass(blocks[block].size / granularity, firstLevel, secondLevel);
+
+    const UINT previous = blocks[block].previousFree;
+    const UINT next = blocks[block].nextFree;
+    if (previous != TLSF_INVALID_BLOCK)
+    {
+        blocks[previous].nextFree = next;
+    }
+    else
+    {
+        freeLists[firstLevel][secondLevel] = next;
+    }
+    if (next != TLSF_INVALID_BLOCK)
+    {
+        blocks[next].previousFree = previous;
+    }
+
+    if (freeLists[firstLevel][secondLevel] == TLSF_INVALID_BLOCK)
+    {
+        secondLevelMaps[firstLevel] &= ~(1u << secondLevel);
+        if (secondLevelMaps[firstLevel] == 0)
+        {
+            firstLevelMap &= ~(1ull << firstLevel);
+        }
+    }
+    blocks[block].isFree = FALSE;
+}
+
+UINT TLSFAllocator::FindFreeBlock(UINT64 size) const
+{
+    const UINT64 units = size / granularity;
+    UINT firstLevel, secondLevel;
+
+    // Round the size up to the next class, where every block is large enough.
+    UINT64 roundedUnits = units;
+    if (units >= TLSF_SECOND_LEVEL_COUNT)
+    {
+        roundedUnits += (1ull << (GetHighestBit(units) - TLSF_SECOND_LEVEL_BITS)) - 1;
+    }
+    GetClass(roundedUnits, firstLevel, secondLevel);
+
+    if (firstLevel < TLSF_FIRST_LEVEL_COUNT)
+    {
+        UINT secondLevelMap = secondLevelMaps[firstLevel] & (~0u << secondLevel);
+        if (secondLevelMap == 0)
+        {
+            const UINT64 firstLevelMapAbove = firstLevel + 1 < TLSF_FIRST_LEVEL_COUNT
+                ? firstLevelMap & (~0ull << (firstLevel + 1))
+                : 0;
+            if (firstLevelMapAbove != 0)
+            {
+                firstLevel = GetLowestBit(firstLevelMapAbove);
+                secondLevelMap = secondLevelMaps[firstLevel];
+            }
+        }
+        if (secondLevelMap != 0)
+        {
+            return freeLists[firstLevel][GetLowestBit(secondLevelMap)];
+        }
+    }
+
+    // The blocks of the class of the size itself may still fit, which matters when memory is short.
+    GetClass(units, firstLevel, secondLevel);
+    for (UINT block = freeLists[firstLevel][secondLevel]; block != TLSF_INVALID_BLOCK; block = blocks[block].nextFree)
+    {
+        if (blocks[block].size >= size)
+        {
+            return block;
+        }
+    }
+
+    return TLSF_INVALID_BLOCK;
+}
+
+UINT TLSFAllocator::SplitBlock(UINT block, UINT64 size)
+{
+    const UINT front = CreateBlock(blocks[block].offset, size);
+    blocks[front].previousPhysical = blocks[block].previousPhysical;
+    blocks[front].nextPhysical = block;
+    if (blocks[front].previousPhysical != TLSF_INVALID_BLOCK)
+    {
+        blocks[blocks[front].previousPhysical].nextPhysical = front;
+    }
+
+    blocks[block].offset += size;
+    blocks[block].size -= size;
+    blocks[block].previousPhysical = front;
+    return front;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+// Free blocks are sorted by the power of two of their size, and each power of two is split into
+// 2^TLSF_SECOND_LEVEL_BITS linear classes.
+#define TLSF_SECOND_LEVEL_BITS 4
+#define TLSF_SECOND_LEVEL_COUNT (1 << TLSF_SECOND_LEVEL_BITS)
+#define TLSF_FIRST_LEVEL_COUNT 64
+#define TLSF_INVALID_BLOCK UINT_MAX
+
+// A range handed out by TLSFAllocator, which it needs back to free it.
+struct TLSFAllocation
+{
+    UINT64 offset;
+    UINT64 size;
+    UINT block;
+};
+
+// Sub-allocates aligned ranges of a block of memory with a two-level segregated fit, in constant time.
+// It only deals in offsets, so it does not own the memory and does no GPU work. Sizes and offsets
+// are multiples of a granularity, and freed ranges merge with their free neighbours right away.
+class TLSFAllocator
+{
+private:
+    struct Block
+    {
+        UINT64 offset;
+        UINT64 size;
+        // Neighbours in the memory, and in the free list of the class of the block when it is free.
+        UINT previousPhysical;
+        UINT nextPhysical;
+        UINT previousFree;
+        UINT nextFree;
+        BOOL isFree;
+    };
+
+    UINT64 capacity;
+    UINT64 granularity;
+    UINT64 usedSize;
+    UINT allocationsNum;
+    std::vector<Block> blocks;
+    std::vector<UINT> unusedBlocks;
+    UINT freeLists[TLSF_FIRST_LEVEL_COUNT][TLSF_SECOND_LEVEL_COUNT];
+    UINT64 firstLevelMap;
+    UINT secondLevelMaps[TLSF_FIRST_LEVEL_COUNT];
+
+    static void GetClass(UINT64 size, UINT& firstLevel, UINT& secondLevel);
+    UINT CreateBlock(UINT64 offset, UINT64 size);
+    void InsertFreeBlock(UINT block);
+    void RemoveFreeBlock(UINT block);
+    // A free block of at least size bytes, TLSF_INVALID_BLOCK if there is none.
+    UINT FindFreeBlock(UINT64 size) const;
+    // Cut the start of a block into a block of its own, and return it.
+    UINT SplitBlock(UINT block, UINT64 size);
+
+public:
+    TLSFAllocator(UINT64 inCapacity, UINT64 inGranularity);
+
+    // Allocate size bytes at an offset that is a multiple of alignment, a power of two.
+    // Returns FALSE if no free range is large enough.
+    BOOL Allocate(UINT64 size, UINT64 alignment, TLSFAllocation& allocation);
+    void Free(const TLSFAllocation& allocation);
+
+    // The largest range that can be allocated at the granularity.
+    UINT64 GetLargestFreeSize() const;
+
+    inline const UINT64 GetCapacity() const { return capacity; }
+    inline const UINT64 GetUsedSize() const { return usedSize; }
+    inline const UINT GetAllocationsNum() const { return allocationsNum; }
+    inline const BOOL IsEmpty() const { return allocationsNum == 0; }
+};
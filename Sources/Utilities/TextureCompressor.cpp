@@ -0,0 +1,507 @@
+#include "stdafx.h"
+#include "TextureCompressor.h"
+#include <atomic>
+#include <thread>
+
+// Interpolation weights of 4-bit BC7 indices, out of 64.
+static const UINT kBC7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+UINT TextureCompressor::GetBlockSize(TextureBlockFormat format)
+{
+    return format == TextureBlockFormat::BC1 || format == TextureBlockFormat::BC4 ? 8 : 16;
+}
+
+UINT TextureCompressor::GetDXGIFormat(TextureBlockFormat format)
+{
+    switch (format)
+    {
+    case TextureBlockFormat::BC1:
+        return DXGI_FORMAT_BC1_UNORM;
+    case TextureBlockFormat::BC4:
+        return DXGI_FORMAT_BC4_UNORM;
+    case TextureBlockFormat::BC5:
+        return DXGI_FORMAT_BC5_UNORM;
+    default:
+        return DXGI_FORMAT_BC7_UNORM;
+    }
+}
+
+UINT64 TextureCompressor::GetCompressedSize(UINT width, UINT height, TextureBlockFormat format)
+{
+    return static_cast<UINT64>((width + 3) / 4) * ((height + 3) / 4) * GetBlockSize(format);
+}
+
+void TextureCompressor::Compress(const BYTE* pPixels, UINT width, UINT height, TextureBlockFormat format,
+    BYTE* pDestination, UINT threadCount)
+{
+    const UINT blocksWidth = (width + 3) / 4;
+    const UINT blocksHeight = (height + 3) / 4;
+    const UINT blockSize = GetBlockSize(format);
+
+    std::atomic<UINT> nextRow(0);
+    auto worker = [&]()
+    {
+        BYTE block[64];
+        for (UINT y = nextRow++; y < blocksHeight; y = nextRow++)
+        {
+            for (UINT x = 0; x < blocksWidth; x++)
+            {
+                // Gather the 4x4 pixels, repeating the last row and column past the edges.
+                for (UINT i = 0; i < 16; i++)
+                {
+                    UINT pixelX = min(x * 4 + (i & 3), width - 1);
+                    UINT pixelY = min(y * 4 + (i >> 2), height - 1);
+                    memcpy(block + i * 4, pPixels + (static_cast<UINT64>(pixelY) * width + pixelX) * 4, 4);
+                }
+
+                CompressBlock(block, format, pDestination + (static_cast<UINT64>(y) * blocksWidth + x) * blockSize);
+            }
+        }
+    };
+
+    if (threadCount == 0)
+    {
+        threadCount = max(std::thread::hardware_concurrency(), 1u);
+    }
+    threadCount = min(threadCount, blocksHeight);
+
+    std::vector<std::thread> workers;
+    for (UINT i = 1; i < threadCount; i++)
+    {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : workers)
+    {
+        thread.join();
+    }
+}
+
+// Helper functions.
+void TextureCompressor::CompressBlock(const BYTE* pPixels, TextureBlockFormat format, BYTE* pBlock)
+{
+    switch (format)
+    {
+    case TextureBlockFormat::BC1:
+        CompressBlockBC1(pPixels, pBlock);
+        break;
+    case TextureBlockFormat::BC4:
+        CompressBlockBC4(pPixels, 0, pBlock);
+        break;
+    case TextureBlockFormat::BC5:
+        CompressBlockBC4(pPixels, 0, pBlock);
+        CompressBlockBC4(pPixels, 1, pBlock + 8);
+        break;
+    case TextureBlockFormat::BC7:
+        CompressBlockBC7(pPixels, pBlock);
+        break;
+    }
+}
+
+void TextureCompressor::GetPrincipalAxis(const FLOAT* pColors, UINT componentsNum, FLOAT* pMean, FLOAT* pAxis)
+{
+    for (UINT c = 0; c < componentsNum; c++)
+    {
+        pMean[c] = 0.0f;
+        for (UINT i = 0; i < 16; i++)
+        {
+            pMean[c] += pColors[i * 4 + c];
+        }
+        pMean[c] /= 16.0f;
+    }
+
+    FLOAT covariance[4][4] = {};
+    for (UINT i = 0; i < 16; i++)
+    {
+        for (UINT a = 0; a < componentsNum; a++)
+        {
+            for (UINT b = a; b < componentsNum; b++)
+            {
+                covariance[a][b] += (pColors[i * 4 + a] - pMean[a]) * (pColors[i * 4 + b] - pMean[b]);
+            }
+        }
+    }
+
+    // Start from the channel that varies the most, and keep the axis when the block is flat.
+    UINT start = 0;
+    for (UINT a = 0; a < componentsNum; a++)
+    {
+        for (UINT b = 0; b < a; b++)
+        {
+            covariance[a][b] = covariance[b][a];
+        }
+        pAxis[a] = 1.0f;
+        start = covariance[a][a] > covariance[start][start] ? a : start;
+    }
+    if (covariance[start][start] <= 0.0f)
+    {
+        return;
+    }
+
+    for (UINT a = 0; a < componentsNum; a++)
+    {
+        pAxis[a] = covariance[start][a];
+    }
+    for (UINT iteration = 0; iteration < TEXTURE_COMPRESSOR_PCA_ITERATIONS; iteration++)
+    {
+        FLOAT axis[4] = {};
+        FLOAT length = 0.0f;
+        for (UINT a = 0; a < componentsNum; a++)
+        {
+            for (UINT b = 0; b < componentsNum; b++)
+            {
+                axis[a] += covariance[a][b] * pAxis[b];
+            }
+            length = max(length, fabsf(axis[a]));
+        }
+        if (length <= 0.0f)
+        {
+            break;
+        }
+        for (UINT a = 0; a < componentsNum; a++)
+        {
+            pAxis[a] = axis[a] / length;
+        }
+    }
+}
+
+void TextureCompressor::CompressBlockBC1(const BYTE* pPixels, BYTE* pBlock)
+{
+    FLOAT colors[64];
+    for (UINT i = 0; i < 64; i++)
+    {
+        colors[i] = pPixels[i];
+    }
+
+    FLOAT mean[4], axis[4];
+    GetPrincipalAxis(colors, 3, mean, axis);
+
+    // Bound the colors along the principal axis.
+    FLOAT minT = FLT_MAX, maxT = -FLT_MAX;
+    for (UINT i = 0; i < 16; i++)
+    {
+        FLOAT t = 0.0f;
+        for (UINT c = 0; c < 3; c++)
+        {
+            t += (colors[i * 4 + c] - mean[c]) * axis[c];
+        }
+        minT = min(minT, t);
+        maxT = max(maxT, t);
+    }
+
+    auto encode = [](const FLOAT* pColor) -> UINT16
+    {
+        UINT r = static_cast<UINT>(min(max(pColor[0], 0.0f), 255.0f) * 31.0f / 255.0f + 0.5f);
+        UINT g = static_cast<UINT>(min(max(pColor[1], 0.0f), 255.0f) * 63.0f / 255.0f + 0.5f);
+        UINT b = static_cast<UINT>(min(max(pColor[2], 0.0f), 255.0f) * 31.0f / 255.0f + 0.5f);
+        return static_cast<UINT16>((r << 11) | (g << 5) | b);
+    };
+    auto decode = [](UINT16 color, FLOAT* pColor)
+    {
+        UINT r = color >> 11, g = (color >> 5) & 63, b = color & 31;
+        pColor[0] = static_cast<FLOAT>((r << 3) | (r >> 2));
+        pColor[1] = static_cast<FLOAT>((g << 2) | (g >> 4));
+        pColor[2] = static_cast<FLOAT>((b << 3) | (b >> 2));
+    };
+
+    // Pick the indices of the 4-color palette for a pair of endpoints, and return the squared error.
+    auto fit = [&](UINT16& color0, UINT16& color1, UINT& indices) -> FLOAT
+    {
+        if (color0 < color1)
+        {
+            std::swap(color0, color1);
+        }
+
+        FLOAT palette[4][3];
+        decode(color0, palette[0]);
+        decode(color1, palette[1]);
+        for (UINT c = 0; c < 3; c++)
+        {
+            palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+            palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+        }
+
+        indices = 0;
+        FLOAT error = 0.0f;
+        for (UINT i = 0; i < 16; i++)
+        {
+            UINT best = 0;
+            FLOAT bestError = FLT_MAX;
+            // Equal endpoints select the 3-color mode, where only index 0 is safe.
+            for (UINT j = 0; j < (color0 == color1 ? 1u : 4u); j++)
+            {
+                FLOAT e = 0.0f;
+                for (UINT c = 0; c < 3; c++)
+                {
+                    FLOAT d = colors[i * 4 + c] - palette[j][c];
+                    e += d * d;
+                }
+                if (e < bestError)
+                {
+                    bestError = e;
+                    best = j;
+                }
+            }
+            indices |= best << (i * 2);
+            error += bestError;
+        }
+        return error;
+    };
+
+    FLOAT endpoint0[3], endpoint1[3];
+    for (UINT c = 0; c < 3; c++)
+    {
+        endpoint0[c] = mean[c] + axis[c] * maxT;
+        endpoint1[c] = mean[c] + axis[c] * minT;
+    }
+
+    UINT16 color0 = encode(endpoint0);
+    UINT16 color1 = encode(endpoint1);
+    UINT indices = 0;
+    FLOAT error = fit(color0, color1, indices);
+
+    // Refine the endpoints once by least squares over the chosen indices.
+    static const FLOAT kWeights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+    FLOAT aa = 0.0f, ab = 0.0f, bb = 0.0f;
+    FLOAT ax[3] = {}, bx[3] = {};
+    for (UINT i = 0; i < 16; i++)
+    {
+        FLOAT w = kWeights[(indices >> (i * 2)) & 3];
+        aa += (1.0f - w) * (1.0f - w);
+        ab += (1.0f - w) * w;
+        bb += w * w;
+        for (UINT c = 0; c < 3; c++)
+        {
+            ax[c] += (1.0f - w) * colors[i * 4 + c];
+            bx[c] += w * colors[i * 4 + c];
+        }
+    }
+    FLOAT determinant = aa * bb - ab * ab;
+    if (fabsf(determinant) > 1e-6f)
+    {
+        for (UINT c = 0; c < 3; c++)
+        {
+            endpoint0[c] = (ax[c] * bb - bx[c] * ab) / determinant;
+            endpoint1[c] = (bx[c] * aa - ax[c] * ab) / determinant;
+        }
+
+        UINT16 refinedColor0 = encode(endpoint0);
+        UINT16 refinedColor1 = encode(endpoint1);
+        UINT refinedIndices = 0;
+        FLOAT refinedError = fit(refinedColor0, refinedColor1, refinedIndices);
+        if (refinedError < error)
+        {
+            color0 = refinedColor0;
+            color1 = refinedColor1;
+            indices = refinedIndices;
+        }
+    }
+
+    memcpy(pBlock, &color0, 2);
+    memcpy(pBlock + 2, &color1, 2);
+    memcpy(pBlock + 4, &indices, 4);
+}
+
+void TextureCompressor::CompressBlockBC4(const BYTE* pPixels, UINT channel, BYTE* pBlock)
+{
+    UINT minValue = 255, maxValue = 0;
+    for (UINT i = 0; i < 16; i++)
+    {
+        minValue = min(minValue, static_cast<UINT>(pPixels[i * 4 + channel]));
+        maxValue = max(maxValue, static_cast<UINT>(pPixels[i * 4 + channel]));
+    }
+
+    // The first endpoint is the larger one, which selects the 8-value palette.
+    INT palette[8];
+    palette[0] = maxValue;
+    palette[1] = minValue;
+    for (UINT i = 2; i < 8; i++)
+    {
+        palette[i] = ((8 - i) * maxValue + (i - 1) * minValue) / 7;
+    }
+
+    UINT64 bits = 0;
+    for (UINT i = 0; i < 16 && maxValue > minValue; i++)
+    {
+        INT value = pPixels[i * 4 + channel];
+        UINT64 best = 0;
+        for (UINT j = 1; j < 8; j++)
+        {
+            best = abs(palette[j] - value) < abs(palette[best] - value) ? j : best;
+        }
+        bits |= best << (i * 3);
+    }
+
+    pBlock[0] = static_cast<BYTE>(maxValue);
+    pBlock[1] = static_cast<BYTE>(minValue);
+    for (UINT i = 0; i < 6; i++)
+    {
+        pBlock[2 + i] = static_cast<BYTE>(bits >> (i * 8));
+    }
+}
+
+void TextureCompressor::CompressBlockBC7(const BYTE* pPixels, BYTE* pBlock)
+{
+    FLOAT colors[64];
+    for (UINT i = 0; i < 64; i++)
+    {
+        colors[i] = pPixels[i];
+    }
+
+    FLOAT mean[4], axis[4];
+    GetPrincipalAxis(colors, 4, mean, axis);
+
+    FLOAT minT = FLT_MAX, maxT = -FLT_MAX;
+    for (UINT i = 0; i < 16; i++)
+    {
+        FLOAT t = 0.0f;
+        for (UINT c = 0; c < 4; c++)
+        {
+            t += (colors[i * 4 + c] - mean[c]) * axis[c];
+        }
+        minT = min(minT, t);
+        maxT = max(maxT, t);
+    }
+
+    FLOAT endpoints[2][4];
+    for (UINT c = 0; c < 4; c++)
+    {
+        endpoints[0][c] = mean[c] + axis[c] * minT;
+        endpoints[1][c] = mean[c] + axis[c] * maxT;
+    }
+
+    // Mode 6 endpoints are 7 bits per channel plus a shared low bit per endpoint.
+    // Try every pair of low bits, and return the squared error of the best one.
+    auto fit = [&](const FLOAT (*pEndpoints)[4], UINT (*pQuantized)[4], UINT* pPBits, BYTE* pIndices) -> FLOAT
+    {
+        FLOAT bestError = FLT_MAX;
+        for (UINT pBits = 0; pBits < 4; pBits++)
+        {
+            UINT quantized[2][4];
+            INT palette[16][4];
+            for (UINT e = 0; e < 2; e++)
+            {
+                UINT p = (pBits >> e) & 1;
+                for (UINT c = 0; c < 4; c++)
+                {
+                    FLOAT value = (min(max(pEndpoints[e][c], 0.0f), 255.0f) - p) * 0.5f;
+                    quantized[e][c] = min(static_cast<UINT>(max(value + 0.5f, 0.0f)), 127u);
+                }
+            }
+            for (UINT j = 0; j < 16; j++)
+            {
+                for (UINT c = 0; c < 4; c++)
+                {
+                    INT value0 = (quantized[0][c] << 1) | (pBits & 1);
+                    INT value1 = (quantized[1][c] << 1) | (pBits >> 1);
+                    palette[j][c] = ((64 - kBC7Weights[j]) * value0 + kBC7Weights[j] * value1 + 32) >> 6;
+                }
+            }
+
+            FLOAT error = 0.0f;
+            BYTE indices[16];
+            for (UINT i = 0; i < 16 && error < bestError; i++)
+            {
+                INT bestPixelError = INT_MAX;
+                for (UINT j = 0; j < 16; j++)
+                {
+                    INT pixelError = 0;
+                    for (UINT c = 0; c < 4; c++)
+                    {
+                        INT d = pPixels[i * 4 + c] - palette[j][c];
+                        pixelError += d * d;
+                    }
+                    if (pixelError < bestPixelError)
+                    {
+                        bestPixelError = pixelError;
+                        indices[i] = static_cast<BYTE>(j);
+                    }
+                }
+                error += bestPixelError;
+            }
+
+            if (error < bestError)
+            {
+                bestError = error;
+                memcpy(pQuantized, quantized, sizeof(quantized));
+                *pPBits = pBits;
+                memcpy(pIndices, indices, sizeof(indices));
+            }
+        }
+        return bestError;
+    };
+
+    UINT quantized[2][4];
+    UINT pBits = 0;
+    BYTE indices[16];
+    FLOAT error = fit(endpoints, quantized, &pBits, indices);
+
+    // Refine the endpoints once by least squares over the chosen indices.
+    FLOAT aa = 0.0f, ab = 0.0f, bb = 0.0f;
+    FLOAT ax[4] = {}, bx[4] = {};
+    for (UINT i = 0; i < 16; i++)
+    {
+        FLOAT w = kBC7Weights[indices[i]] / 64.0f;
+        aa += (1.0f - w) * (1.0f - w);
+        ab += (1.0f - w) * w;
+        bb += w * w;
+        for (UINT c = 0; c < 4; c++)
+        {
+            ax[c] += (1.0f - w) * colors[i * 4 + c];
+            bx[c] += w * colors[i * 4 + c];
+        }
+    }
+    FLOAT determinant = aa * bb - ab * ab;
+    if (fabsf(determinant) > 1e-6f)
+    {
+        for (UINT c = 0; c < 4; c++)
+        {
+            endpoints[0][c] = (ax[c] * bb - bx[c] * ab) / determinant;
+            endpoints[1][c] = (bx[c] * aa - ax[c] * ab) / determinant;
+        }
+
+        UINT refinedQuantized[2][4] = {};
+        UINT refinedPBits = 0;
+        BYTE refinedIndices[16] = {};
+        if (fit(endpoints, refinedQuantized, &refinedPBits, refinedIndices) < error)
+        {
+            memcpy(quantized, refinedQuantized, sizeof(quantized));
+            pBits = refinedPBits;
+            memcpy(indices, refinedIndices, sizeof(indices));
+        }
+    }
+
+    // The top bit of the first index is implied to be 0, so swap the endpoints when it is set.
+    if (indices[0] >= 8)
+    {
+        std::swap(quantized[0], quantized[1]);
+        pBits = ((pBits & 1) << 1) | (pBits >> 1);
+        for (UINT i = 0; i < 16; i++)
+        {
+            indices[i] = 15 - indices[i];
+        }
+    }
+
+    memset(pBlock, 0, 16);
+    UINT offset = 0;
+    auto write = [&](UINT value, UINT bitsNum)
+    {
+        for (UINT i = 0; i < bitsNum; i++, offset++)
+        {
+            pBlock[offset >> 3] |= ((value >> i) & 1) << (offset & 7);
+        }
+    };
+
+    write(1 << 6, 7);
+    for (UINT c = 0; c < 4; c++)
+    {
+        write(quantized[0][c], 7);
+        write(quantized[1][c], 7);
+    }
+    write(pBits & 1, 1);
+    write(pBits >> 1, 1);
+    for (UINT i = 0; i < 16; i++)
+    {
+        write(indices[i], i == 0 ? 3 : 4);
+    }
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+// Number of compression threads, 0 uses one per hardware thread.
+#define TEXTURE_COMPRESSOR_THREAD_COUNT 0
+// Power iterations used to find the principal axis of the colors of a block.
+#define TEXTURE_COMPRESSOR_PCA_ITERATIONS 4
+
+enum class TextureBlockFormat
+{
+    // RGB with a 1-bit alpha, 8 bytes per block.
+    BC1 = 0,
+    // A single channel, 8 bytes per block.
+    BC4 = 1,
+    // Two channels, 16 bytes per block.
+    BC5 = 2,
+    // RGBA, 16 bytes per block. Only mode 6 is used, which keeps every block a single subset.
+    BC7 = 3,
+};
+
+// Encodes 32bpp RGBA images into 4x4 blocks. It only depends on the C++ runtime,
+// so the same code cooks textures on Windows and on Linux build machines.
+class TextureCompressor
+{
+private:
+    static void CompressBlockBC1(const BYTE* pPixels, BYTE* pBlock);
+    static void CompressBlockBC4(const BYTE* pPixels, UINT channel, BYTE* pBlock);
+    static void CompressBlockBC7(const BYTE* pPixels, BYTE* pBlock);
+    static void CompressBlock(const BYTE* pPixels, TextureBlockFormat format, BYTE* pBlock);
+
+    // Find the axis the colors of a block spread along the most, over the first componentsNum channels.
+    static void GetPrincipalAxis(const FLOAT* pColors, UINT componentsNum, FLOAT* pMean, FLOAT* pAxis);
+
+public:
+    static UINT GetBlockSize(TextureBlockFormat format);
+    static UINT GetDXGIFormat(TextureBlockFormat format);
+    static UINT64 GetCompressedSize(UINT width, UINT height, TextureBlockFormat format);
+
+    // Compress an image into rows of blocks. Blocks on the right and bottom edges repeat the last
+    // pixels, so any size works, and the rows of blocks are spread over the threads.
+    static void Compress(const BYTE* pPixels, UINT width, UINT height, TextureBlockFormat format,
+        BYTE* pDestination, UINT threadCount = TEXTURE_COMPRESSOR_THREAD_COUNT);
+};
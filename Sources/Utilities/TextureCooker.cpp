@@ -0,0 +1,211 @@
+#include "stdafx.h"
+#include "TextureCooker.h"
+
+// DDS header flags of a mip mapped 2D texture with the DX10 header.
+#define DDSD_CAPS 0x1
+#define DDSD_HEIGHT 0x2
+#define DDSD_WIDTH 0x4
+#define DDSD_PIXELFORMAT 0x1000
+#define DDSD_MIPMAPCOUNT 0x20000
+#define DDSD_LINEARSIZE 0x80000
+#define DDPF_FOURCC 0x4
+#define DDSCAPS_COMPLEX 0x8
+#define DDSCAPS_TEXTURE 0x1000
+#define DDSCAPS_MIPMAP 0x400000
+#define DDS_FOURCC_DX10 0x30315844 // "DX10"
+#define DDS_DIMENSION_TEXTURE2D 3
+
+std::wstring TextureCooker::GetCachePath(const std::wstring& sourcePath)
+{
+    std::wstring path = sourcePath;
+    size_t start = path.find_last_of(L'.');
+    if (start != std::wstring::npos)
+    {
+        path.erase(start, path.size() - start);
+    }
+
+    return path + L".dds";
+}
+
+TextureBlockFormat TextureCooker::GetBlockFormat(const std::wstring& sourcePath)
+{
+    std::wstring name = sourcePath.substr(sourcePath.find_last_of(L"\\/") + 1);
+    name = name.substr(0, name.find_last_of(L'.'));
+
+    // The default textures end with the size of their top level, as in "default_n_mip64", which is not
+    // part of the suffix.
+    const size_t mipStart = name.rfind(L"_mip");
+    if (mipStart != std::wstring::npos && mipStart + 4 < name.size()
+        && name.find_first_not_of(L"0123456789", mipStart + 4) == std::wstring::npos)
+    {
+        name.erase(mipStart);
+    }
+
+    // Match the suffix only at the end of the name, so "wall_normal_detail" is not a normal map.
+    auto hasSuffix = [&name](const std::wstring& suffix)
+    {
+        return name.size() >= suffix.size() && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0;
+    };
+
+    if (hasSuffix(L"_n"))
+    {
+        return TextureBlockFormat::BC5;
+    }
+    if (hasSuffix(L"_mra"))
+    {
+        return TextureBlockFormat::BC1;
+    }
+    return TextureBlockFormat::BC7;
+}
+
+MipFilterMode TextureCooker::GetMipFilterMode(TextureBlockFormat format)
+{
+    switch (format)
+    {
+    case TextureBlockFormat::BC5:
+        return MipFilterMode::Normal;
+    case TextureBlockFormat::BC7:
+        return MipFilterMode::Color;
+    default:
+        return MipFilterMode::Linear;
+    }
+}
+
+BOOL TextureCooker::CanCook(UINT width, UINT height)
+{
+    return width != 0 && height != 0 && width % 4 == 0 && height % 4 == 0;
+}
+
+BOOL TextureCooker::Cook(const std::wstring& cachePath, UINT64 sourceStamp,
+    const BYTE* pPixels, UINT width, UINT height, TextureBlockFormat format)
+{
+    if (!CanCook(width, height))
+    {
+        return FALSE;
+    }
+
+    const UINT levelsNum = MipGenerator::GetMipLevelsNum(width, height);
+    UINT64 dataSize = 0;
+    for (UINT i = 0; i < levelsNum; i++)
+    {
+        dataSize += TextureCompressor::GetCompressedSize(max(width >> i, 1u), max(height >> i, 1u), format);
+    }
+
+    DDSHeader header = {};
+    header.size = sizeof(DDSHeader);
+    header.flags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT | DDSD_LINEARSIZE;
+    header.height = height;
+    header.width = width;
+    header.pitchOrLinearSize = static_cast<UINT>(TextureCompressor::GetCompressedSize(width, height, format));
+    header.mipMapCount = levelsNum;
+    header.reserved1[0] = TEXTURE_CACHE_MAGIC;
+    header.reserved1[1] = TEXTURE_CACHE_VERSION;
+    header.reserved1[2] = static_cast<UINT>(sourceStamp);
+    header.reserved1[3] = static_cast<UINT>(sourceStamp >> 32);
+    header.ddsPixelFormat.size = sizeof(DDSPixelFormat);
+    header.ddsPixelFormat.flags = DDPF_FOURCC;
+    header.ddsPixelFormat.fourCC = DDS_FOURCC_DX10;
+    header.caps = DDSCAPS_COMPLEX | DDSCAPS_TEXTURE | DDSCAPS_MIPMAP;
+
+    DDSHeaderDXT10 headerDXT10 = {};
+    headerDXT10.dxgiFormat = TextureCompressor::GetDXGIFormat(format);
+    headerDXT10.resourceDimension = DDS_DIMENSION_TEXTURE2D;
+    headerDXT10.arraySize = 1;
+
+    const UINT headersSize = sizeof(UINT) + sizeof(DDSHeader) + sizeof(DDSHeaderDXT10);
+    std::vector<BYTE> data(headersSize + dataSize);
+    const UINT magic = TEXTURE_CACHE_DDS_MAGIC;
+    memcpy(data.data(), &magic, sizeof(UINT));
+    memcpy(data.data() + sizeof(UINT), &header, sizeof(DDSHeader));
+    memcpy(data.data() + sizeof(UINT) + sizeof(DDSHeader), &headerDXT10, sizeof(DDSHeaderDXT10));
+
+    // Build the whole chain first, the generator filters its levels on all the threads.
+    std::vector<std::vector<BYTE>> levels(levelsNum);
+    std::vector<BYTE*> pLevels(levelsNum);
+    for (UINT i = 0; i < levelsNum; i++)
+    {
+        levels[i].resize(MipGenerator::GetLevelSize(width, height, i));
+        pLevels[i] = levels[i].data();
+    }
+    memcpy(pLevels[0], pPixels, levels[0].size());
+    MipGenerator::Generate(pLevels.data(), 1, levelsNum, width, height, GetMipFilterMode(format));
+
+    BYTE* pDestination = data.data() + headersSize;
+    for (UINT i = 0; i < levelsNum; i++)
+    {
+        UINT levelWidth = max(width >> i, 1u);
+        UINT levelHeight = max(height >> i, 1u);
+        TextureCompressor::Compress(pLevels[i], levelWidth, levelHeight, format, pDestination);
+        pDestination += TextureCompressor::GetCompressedSize(levelWidth, levelHeight, format);
+    }
+
+    // Written next to the cache first, so textures that share a source and are cooked on different
+    // threads never leave a mix of both writes behind.
+    return MappedFile::Write(cachePath, data.data(), data.size());
+}
+
+BOOL TextureCooker::Map(const std::wstring& cachePath, UINT64 sourceStamp, CookedTexture& texture)
+{
+    texture = {};
+    texture.file = std::make_unique<MappedFile>();
+    const UINT headersSize = sizeof(UINT) + sizeof(DDSHeader) + sizeof(DDSHeaderDXT10);
+    if (!texture.file->Open(cachePath) || texture.file->GetSize() < headersSize || texture.file->GetSize() > UINT_MAX)
+    {
+        Unmap(texture);
+        return FALSE;
+    }
+    texture.pView = texture.file->GetData();
+
+    const DDSHeader* pHeader = reinterpret_cast<const DDSHeader*>(texture.pView + sizeof(UINT));
+    const DDSHeaderDXT10* pHeaderDXT10 = reinterpret_cast<const DDSHeaderDXT10*>(
+        texture.pView + sizeof(UINT) + sizeof(DDSHeader));
+    const UINT64 stamp = pHeader->reserved1[2] | (static_cast<UINT64>(pHeader->reserved1[3]) << 32);
+
+    TextureBlockFormat format = TextureBlockFormat::BC7;
+    BOOL isKnownFormat = FALSE;
+    for (UINT i = 0; i <= static_cast<UINT>(TextureBlockFormat::BC7); i++)
+    {
+        if (TextureCompressor::GetDXGIFormat(static_cast<TextureBlockFormat>(i)) == pHeaderDXT10->dxgiFormat)
+        {
+            format = static_cast<TextureBlockFormat>(i);
+            isKnownFormat = TRUE;
+        }
+    }
+
+    if (*reinterpret_cast<const UINT*>(texture.pView) != TEXTURE_CACHE_DDS_MAGIC
+        || pHeader->size != sizeof(DDSHeader)
+        || pHeader->reserved1[0] != TEXTURE_CACHE_MAGIC
+        || pHeader->reserved1[1] != TEXTURE_CACHE_VERSION
+        || (sourceStamp != 0 && stamp != sourceStamp)
+        || pHeader->ddsPixelFormat.fourCC != DDS_FOURCC_DX10
+        || pHeader->mipMapCount != MipGenerator::GetMipLevelsNum(pHeader->width, pHeader->height)
+        || !isKnownFormat)
+    {
+        Unmap(texture);
+        return FALSE;
+    }
+
+    UINT64 offset = headersSize;
+    for (UINT i = 0; i < pHeader->mipMapCount; i++)
+    {
+        texture.levels.push_back(texture.pView + offset);
+        offset += TextureCompressor::GetCompressedSize(
+            max(pHeader->width >> i, 1u), max(pHeader->height >> i, 1u), format);
+    }
+    if (offset > texture.file->GetSize())
+    {
+        Unmap(texture);
+        return FALSE;
+    }
+
+    texture.width = pHeader->width;
+    texture.height = pHeader->height;
+    texture.dxgiFormat = pHeaderDXT10->dxgiFormat;
+
+    return TRUE;
+}
+
+void TextureCooker::Unmap(CookedTexture& texture)
+{
+    texture = {};
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include "MappedFile.h"
+#include "MipGenerator.h"
+#include "TextureCompressor.h"
+
+// Cooked texture file layout:
+// DDS magic | DDSHeader | DDSHeaderDXT10 | mip 0 | mip 1 | ... | mip N
+// It is a plain DDS file, and the cooker keeps its tag, version and the source stamp
+// in the reserved words of the header. Levels are tightly packed rows of blocks.
+#define TEXTURE_CACHE_DDS_MAGIC 0x20534444 // "DDS "
+#define TEXTURE_CACHE_MAGIC 0x4B4F4F43 // "COOK"
+#define TEXTURE_CACHE_VERSION 2
+
+struct DDSPixelFormat
+{
+    UINT size;
+    UINT flags;
+    UINT fourCC;
+    UINT rgbBitCount;
+    UINT rBitMask;
+    UINT gBitMask;
+    UINT bBitMask;
+    UINT aBitMask;
+};
+
+struct DDSHeader
+{
+    UINT size;
+    UINT flags;
+    UINT height;
+    UINT width;
+    UINT pitchOrLinearSize;
+    UINT depth;
+    UINT mipMapCount;
+    // The cooker tag, the cooker version and the source stamp split in two words.
+    UINT reserved1[11];
+    DDSPixelFormat ddsPixelFormat;
+    UINT caps;
+    UINT caps2;
+    UINT caps3;
+    UINT caps4;
+    UINT reserved2;
+};
+
+struct DDSHeaderDXT10
+{
+    UINT dxgiFormat;
+    UINT resourceDimension;
+    UINT miscFlag;
+    UINT arraySize;
+    UINT miscFlags2;
+};
+
+// A cooked texture mapped into memory. The levels point straight into the view,
+// so they can be copied to upload memory without another copy on the heap.
+struct CookedTexture
+{
+    UINT width;
+    UINT height;
+    UINT dxgiFormat;
+    std::vector<const BYTE*> levels;
+
+    unique_ptr<MappedFile> file;
+    const BYTE* pView;
+};
+
+class TextureCooker
+{
+public:
+    static std::wstring GetCachePath(const std::wstring& sourcePath);
+    // Normal maps keep their two tangent space channels, MRA maps their three and the rest four.
+    static TextureBlockFormat GetBlockFormat(const std::wstring& sourcePath);
+    static MipFilterMode GetMipFilterMode(TextureBlockFormat format);
+
+    // Block compressed textures need a top level that is a multiple of 4, other sizes are not cooked.
+    static BOOL CanCook(UINT width, UINT height);
+    // Build the whole mip chain of a 32bpp RGBA image, compress every level and write them to a DDS file.
+    static BOOL Cook(const std::wstring& cachePath, UINT64 sourceStamp,
+        const BYTE* pPixels, UINT width, UINT height, TextureBlockFormat format);
+
+    // A stale or foreign file is treated as a cache miss so the caller re-cooks it.
+    static BOOL Map(const std::wstring& cachePath, UINT64 sourceStamp, CookedTexture& texture);
+    static void Unmap(CookedTexture& texture);
+};
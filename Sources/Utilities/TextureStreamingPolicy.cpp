@@ -0,0 +1,192 @@
+#include "stdafx.h"
+#include "TextureStreamingPolicy.h"
+#include <algorithm>
+
+TextureStreamingPolicy::TextureStreamingPolicy(UINT64 inBudget, UINT inLoadsPerUpdate) :
+    budget(inBudget),
+    residentBytes(0),
+    loadsPerUpdate(inLoadsPerUpdate)
+{
+
+}
+
+UINT TextureStreamingPolicy::Register(const UINT64* pMipSizes, UINT mipsNum, UINT tailMip)
+{
+    UINT texture = static_cast<UINT>(textures.size());
+    if (!freeTextures.empty())
+    {
+        texture = freeTextures.back();
+        freeTextures.pop_back();
+    }
+    else
+    {
+        textures.emplace_back();
+    }
+
+    Texture& entry = textures[texture];
+    entry.mipSizes.assign(pMipSizes, pMipSizes + mipsNum);
+    entry.tailMip = min(tailMip, mipsNum);
+    entry.residentMip = entry.tailMip;
+    entry.requestedMip = entry.tailMip;
+    entry.requestedFrame = -1;
+    entry.isRegistered = TRUE;
+
+    for (UINT i = entry.tailMip; i < mipsNum; i++)
+    {
+        residentBytes += entry.mipSizes[i];
+    }
+
+    return texture;
+}
+
+void TextureStreamingPolicy::Unregister(UINT texture)
+{
+    Texture& entry = textures[texture];
+    for (UINT i = entry.residentMip; i < entry.mipSizes.size(); i++)
+    {
+        residentBytes -= entry.mipSizes[i];
+    }
+
+    entry = {};
+    freeTextures.push_back(texture);
+}
+
+void TextureStreamingPolicy::Request(UINT texture, UINT mip, UINT64 frame)
+{
+    Texture& entry = textures[texture];
+    if (entry.requestedFrame != static_cast<INT64>(frame))
+    {
+        entry.requestedFrame = static_cast<INT64>(frame);
+        entry.requestedMip = mip;
+    }
+    else
+    {
+        entry.requestedMip = min(entry.requestedMip, mip);
+    }
+}
+
+void TextureStreamingPolicy::SetBudget(UINT64 inBudget)
+{
+    budget = inBudget;
+}
+
+void TextureStreamingPolicy::Update(UINT64 frame, std::vector<TextureStreamingAction>& actions)
+{
+    actions.clear();
+
+    // Only a lower budget leaves too much resident, and then even wanted levels are dropped.
+    while (residentBytes > budget)
+    {
+        INT texture = PickEviction(frame, TRUE, UINT_MAX);
+        if (texture < 0)
+        {
+            break;
+        }
+        Evict(texture, actions);
+    }
+
+    // Load a level of the textures missing the most levels first, the lower handle first on a tie.
+    std::vector<UINT> loads;
+    for (UINT i = 0; i < textures.size(); i++)
+    {
+        if (textures[i].isRegistered && GetWantedMip(textures[i], frame) < textures[i].residentMip)
+        {
+            loads.push_back(i);
+        }
+    }
+    std::sort(loads.begin(), loads.end(), [this, frame](UINT a, UINT b)
+    {
+        UINT missingA = textures[a].residentMip - GetWantedMip(textures[a], frame);
+        UINT missingB = textures[b].residentMip - GetWantedMip(textures[b], frame);
+        return missingA != missingB ? missingA > missingB : a < b;
+    });
+
+    UINT loadsNum = 0;
+    for (UINT i = 0; i < loads.size() && loadsNum < loadsPerUpdate; i++)
+    {
+        Texture& entry = textures[loads[i]];
+        UINT mip = entry.residentMip - 1;
+        UINT64 size = entry.mipSizes[mip];
+
+        // Make room from the levels no longer wanted, a smaller level of the next texture may still fit.
+        while (residentBytes + size > budget)
+        {
+            INT texture = PickEviction(frame, FALSE, loads[i]);
+            if (texture < 0)
+            {
+                break;
+            }
+            Evict(texture, actions);
+        }
+        if (residentBytes + size > budget)
+        {
+            continue;
+        }
+
+        entry.residentMip = mip;
+        residentBytes += size;
+        actions.push_back({ TextureStreamingActionType::Load, loads[i], mip });
+        loadsNum++;
+    }
+}
+
+// Helper functions.
+UINT TextureStreamingPolicy::GetWantedMip(const Texture& texture, UINT64 frame) const
+{
+    return texture.requestedFrame == static_cast<INT64>(frame) ? min(texture.requestedMip, texture.tailMip) : texture.tailMip;
+}
+
+INT TextureStreamingPolicy::PickEviction(UINT64 frame, BOOL isWantedEvictable, UINT skippedTexture) const
+{
+    INT victim = -1;
+    for (UINT i = 0; i < textures.size(); i++)
+    {
+        const Texture& entry = textures[i];
+        if (!entry.isRegistered || i == skippedTexture || entry.residentMip >= entry.tailMip)
+        {
+            continue;
+        }
+
+        BOOL isWanted = entry.residentMip >= GetWantedMip(entry, frame);
+        if (isWanted && !isWantedEvictable)
+        {
+            continue;
+        }
+
+        // Prefer levels that are not wanted, then the least recently requested texture, then its finest level.
+        if (victim >= 0)
+        {
+            const Texture& other = textures[victim];
+            BOOL isOtherWanted = other.residentMip >= GetWantedMip(other, frame);
+            if (isWanted != isOtherWanted)
+            {
+                if (isWanted)
+                {
+                    continue;
+                }
+            }
+            else if (entry.requestedFrame != other.requestedFrame)
+            {
+                if (entry.requestedFrame > other.requestedFrame)
+                {
+                    continue;
+                }
+            }
+            else if (entry.residentMip >= other.residentMip)
+            {
+                continue;
+            }
+        }
+        victim = static_cast<INT>(i);
+    }
+
+    return victim;
+}
+
+void TextureStreamingPolicy::Evict(UINT texture, std::vector<TextureStreamingAction>& actions)
+{
+    Texture& entry = textures[texture];
+    residentBytes -= entry.mipSizes[entry.residentMip];
+    actions.push_back({ TextureStreamingActionType::Evict, texture, entry.residentMip });
+    entry.residentMip++;
+}
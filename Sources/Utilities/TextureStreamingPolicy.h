@@ -0,0 +1,69 @@
+#pragma once
+
+// Mip levels loaded by an update, which bounds the upload work of a frame.
+#define TEXTURE_STREAMING_LOADS_PER_UPDATE 4
+
+enum class TextureStreamingActionType
+{
+    Load = 0,
+    Evict = 1,
+};
+
+// A mip level of a texture to make resident or to drop, applied in the order of the actions.
+struct TextureStreamingAction
+{
+    TextureStreamingActionType type;
+    UINT texture;
+    UINT mip;
+};
+
+// Decides which mip levels of the streamed textures are resident under a memory budget. It does no
+// GPU work, so the renderer and a simulation drive it the same way, and it is deterministic: the same
+// requests and updates give the same actions.
+// The levels from the tail mip of a texture on are always resident. Finer levels are loaded one at a time
+// towards the mip the texture was requested at, the textures missing the most levels first. Levels that
+// are not needed stay resident until their room is needed, and the ones needed least recently go first.
+class TextureStreamingPolicy
+{
+private:
+    struct Texture
+    {
+        std::vector<UINT64> mipSizes;
+        UINT tailMip;
+        UINT residentMip;
+        UINT requestedMip;
+        // The last frame the texture was requested in, -1 if it never was.
+        INT64 requestedFrame;
+        BOOL isRegistered;
+    };
+
+    std::vector<Texture> textures;
+    std::vector<UINT> freeTextures;
+    UINT64 budget;
+    UINT64 residentBytes;
+    UINT loadsPerUpdate;
+
+    UINT GetWantedMip(const Texture& texture, UINT64 frame) const;
+    // The texture to evict a level of, the least recently needed one first. Levels that are still wanted
+    // are only picked when isWantedEvictable is set. Returns -1 if no texture has a level to evict.
+    INT PickEviction(UINT64 frame, BOOL isWantedEvictable, UINT skippedTexture) const;
+    void Evict(UINT texture, std::vector<TextureStreamingAction>& actions);
+
+public:
+    TextureStreamingPolicy(UINT64 inBudget, UINT inLoadsPerUpdate = TEXTURE_STREAMING_LOADS_PER_UPDATE);
+
+    // Add a texture whose levels from tailMip on are resident, and return its handle.
+    UINT Register(const UINT64* pMipSizes, UINT mipsNum, UINT tailMip);
+    // Drop a texture, the caller frees the levels it still has.
+    void Unregister(UINT texture);
+    // Ask for the levels down to mip in a frame, the finest request of the frame is kept.
+    void Request(UINT texture, UINT mip, UINT64 frame);
+    void SetBudget(UINT64 inBudget);
+
+    // Replace actions with the evictions and loads for the requests of a frame.
+    void Update(UINT64 frame, std::vector<TextureStreamingAction>& actions);
+
+    inline const UINT GetResidentMip(UINT texture) const { return textures[texture].residentMip; }
+    inline const UINT64 GetResidentBytes() const { return residentBytes; }
+    inline const UINT64 GetBudget() const { return budget; }
+};
@@ -0,0 +1,132 @@
+#include "stdafx.h"
+#include "VertexPacker.h"
+#include <DirectXPackedVector.h>
+
+using namespace DirectX::PackedVector;
+
+UINT VertexPacker::PackSnorm16x2(FLOAT x, FLOAT y)
+{
+    x = min(max(x, -1.0f), 1.0f);
+    y = min(max(y, -1.0f), 1.0f);
+    INT16 packedX = static_cast<INT16>(roundf(x * 32767.0f));
+    INT16 packedY = static_cast<INT16>(roundf(y * 32767.0f));
+
+    return static_cast<UINT16>(packedX) | (static_cast<UINT>(static_cast<UINT16>(packedY)) << 16);
+}
+
+XMFLOAT2 VertexPacker::UnpackSnorm16x2(UINT value)
+{
+    INT16 x = static_cast<INT16>(value & 0xFFFF);
+    INT16 y = static_cast<INT16>(value >> 16);
+
+    // Both -32768 and -32767 map to -1 as D3D does for snorm formats.
+    return XMFLOAT2
+    {
+        max(x / 32767.0f, -1.0f),
+        max(y / 32767.0f, -1.0f),
+    };
+}
+
+XMFLOAT2 VertexPacker::EncodeOctahedral(const XMFLOAT3& direction)
+{
+    FLOAT length = fabsf(direction.x) + fabsf(direction.y) + fabsf(direction.z);
+    if (length <= 0.0f)
+    {
+        return XMFLOAT2{ 0.0f, 0.0f };
+    }
+
+    FLOAT x = direction.x / length;
+    FLOAT y = direction.y / length;
+
+    // Fold the lower hemisphere over the diagonals.
+    if (direction.z < 0.0f)
+    {
+        FLOAT foldedX = (1.0f - fabsf(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        FLOAT foldedY = (1.0f - fabsf(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = foldedX;
+        y = foldedY;
+    }
+
+    return XMFLOAT2{ x, y };
+}
+
+XMFLOAT3 VertexPacker::DecodeOctahedral(const XMFLOAT2& encoded)
+{
+    XMFLOAT3 direction = { encoded.x, encoded.y, 1.0f - fabsf(encoded.x) - fabsf(encoded.y) };
+    FLOAT t = max(-direction.z, 0.0f);
+    direction.x += direction.x >= 0.0f ? -t : t;
+    direction.y += direction.y >= 0.0f ? -t : t;
+
+    FLOAT length = sqrtf(direction.x * direction.x + direction.y * direction.y + direction.z * direction.z);
+    return XMFLOAT3{ direction.x / length, direction.y / length, direction.z / length };
+}
+
+void VertexPacker::GetPositionDequantization(const D3D12_RAYTRACING_AABB& aabb, XMFLOAT4& scale, XMFLOAT4& offset)
+{
+    offset = XMFLOAT4
+    {
+        (aabb.MaxX + aabb.MinX) * 0.5f,
+        (aabb.MaxY + aabb.MinY) * 0.5f,
+        (aabb.MaxZ + aabb.MinZ) * 0.5f,
+        0.0f,
+    };
+
+    // Keep flat bounds decodable.
+    scale = XMFLOAT4
+    {
+        max((aabb.MaxX - aabb.MinX) * 0.5f, 1e-6f),
+        max((aabb.MaxY - aabb.MinY) * 0.5f, 1e-6f),
+        max((aabb.MaxZ - aabb.MinZ) * 0.5f, 1e-6f),
+        1.0f,
+    };
+}
+
+PackedVertex VertexPacker::PackVertex(const Vertex& vertex, const XMFLOAT4& scale, const XMFLOAT4& offset)
+{
+    PackedVertex packedVertex = {};
+
+    FLOAT bitangentSign = vertex.tangentOS.w < 0.0f ? -1.0f : 1.0f;
+    packedVertex.positionOS[0] = PackSnorm16x2(
+        (vertex.positionOS.x - offset.x) / scale.x,
+        (vertex.positionOS.y - offset.y) / scale.y);
+    packedVertex.positionOS[1] = PackSnorm16x2(
+        (vertex.positionOS.z - offset.z) / scale.z,
+        bitangentSign);
+
+    XMFLOAT2 normal = EncodeOctahedral(vertex.normalOS);
+    XMFLOAT2 tangent = EncodeOctahedral(XMFLOAT3{ vertex.tangentOS.x, vertex.tangentOS.y, vertex.tangentOS.z });
+    packedVertex.normalTangentOS[0] = PackSnorm16x2(normal.x, normal.y);
+    packedVertex.normalTangentOS[1] = PackSnorm16x2(tangent.x, tangent.y);
+
+    packedVertex.texCoord = XMConvertFloatToHalf(vertex.texCoord.x)
+        | (static_cast<UINT>(XMConvertFloatToHalf(vertex.texCoord.y)) << 16);
+
+    return packedVertex;
+}
+
+Vertex VertexPacker::UnpackVertex(const PackedVertex& packedVertex, const XMFLOAT4& scale, const XMFLOAT4& offset)
+{
+    Vertex vertex = {};
+
+    XMFLOAT2 xy = UnpackSnorm16x2(packedVertex.positionOS[0]);
+    XMFLOAT2 zw = UnpackSnorm16x2(packedVertex.positionOS[1]);
+    vertex.positionOS = XMFLOAT3
+    {
+        xy.x * scale.x + offset.x,
+        xy.y * scale.y + offset.y,
+        zw.x * scale.z + offset.z,
+    };
+
+    vertex.normalOS = DecodeOctahedral(UnpackSnorm16x2(packedVertex.normalTangentOS[0]));
+    XMFLOAT3 tangent = DecodeOctahedral(UnpackSnorm16x2(packedVertex.normalTangentOS[1]));
+    vertex.tangentOS = XMFLOAT4{ tangent.x, tangent.y, tangent.z, zw.y < 0.0f ? -1.0f : 1.0f };
+
+    vertex.texCoord = XMFLOAT2
+    {
+        XMConvertHalfToFloat(static_cast<HALF>(packedVertex.texCoord & 0xFFFF)),
+        XMConvertHalfToFloat(static_cast<HALF>(packedVertex.texCoord >> 16)),
+    };
+    vertex.color = XMFLOAT4{ 1.0f, 1.0f, 1.0f, 1.0f };
+
+    return vertex;
+}
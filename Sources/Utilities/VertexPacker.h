@@ -0,0 +1,18 @@
+#pragma once
+
+// Encodes Vertex into PackedVertex, see SharedTypes.h for the layout.
+class VertexPacker
+{
+private:
+    static UINT PackSnorm16x2(FLOAT x, FLOAT y);
+    static XMFLOAT2 UnpackSnorm16x2(UINT value);
+    static XMFLOAT2 EncodeOctahedral(const XMFLOAT3& direction);
+    static XMFLOAT3 DecodeOctahedral(const XMFLOAT2& encoded);
+
+public:
+    // Positions are stored as offset + scale * snorm, so the scale is the half extent of the bounds.
+    static void GetPositionDequantization(const D3D12_RAYTRACING_AABB& aabb, XMFLOAT4& scale, XMFLOAT4& offset);
+
+    static PackedVertex PackVertex(const Vertex& vertex, const XMFLOAT4& scale, const XMFLOAT4& offset);
+    static Vertex UnpackVertex(const PackedVertex& packedVertex, const XMFLOAT4& scale, const XMFLOAT4& offset);
+};
@@ -0,0 +1,178 @@
+#include "stdafx.h"
+#include "AsyncLoader.h"
+#include "TestHelper.h"
+#include <stdexcept>
+#include <thread>
+
+namespace
+{
+    // Poll until a ticket comes back, the tasks finish on the workers in their own time.
+    UINT PollOne(AsyncLoader& loader)
+    {
+        std::vector<UINT> completed;
+        while (loader.Poll(completed, 1) == 0)
+        {
+            std::this_thread::yield();
+        }
+        CHECK(completed.size() == 1);
+        return completed[0];
+    }
+
+    void TestCompletionOrder()
+    {
+        // The tickets come back in the order the tasks finish, not the order they were submitted in, and every
+        // task runs on a worker of the job system.
+        JobSystem jobSystem(3);
+        AsyncLoader loader(&jobSystem);
+        std::atomic<UINT> releasedMask(0);
+        std::atomic<BOOL> isThreadValid(TRUE);
+        for (UINT i = 0; i < 3; i++)
+        {
+            CHECK(loader.Submit([i, &releasedMask, &isThreadValid, &jobSystem](UINT thread)
+            {
+                if (thread == 0 || thread >= jobSystem.GetThreadCount())
+                {
+                    isThreadValid = FALSE;
+                }
+                while ((releasedMask & (1u << i)) == 0)
+                {
+                    std::this_thread::yield();
+                }
+            }) == i);
+        }
+        CHECK(loader.GetPendingNum() == 3);
+
+        const UINT finishOrder[] = { 2, 0, 1 };
+        for (UINT ticket : finishOrder)
+        {
+            releasedMask |= 1u << ticket;
+            CHECK(PollOne(loader) == ticket);
+        }
+        CHECK(loader.GetPendingNum() == 0);
+        CHECK(isThreadValid);
+
+        std::vector<UINT> completed;
+        CHECK(loader.Poll(completed, 8) == 0 && completed.empty());
+    }
+
+    void TestPollLimit()
+    {
+        // A poll moves at most maxCount tickets, and Wait leaves the tickets for the polls.
+        JobSystem jobSystem(3);
+        AsyncLoader loader(&jobSystem);
+        for (UINT i = 0; i < 10; i++)
+        {
+            loader.Submit([](UINT) {});
+        }
+        loader.Wait();
+        CHECK(loader.GetPendingNum() == 10);
+
+        std::vector<UINT> completed;
+        CHECK(loader.Poll(completed, 4) == 4);
+        CHECK(loader.Poll(completed, 4) == 4);
+        CHECK(loader.Poll(completed, 4) == 2);
+        CHECK(loader.GetPendingNum() == 0);
+        std::sort(completed.begin(), completed.end());
+        for (UINT i = 0; i < 10; i++)
+        {
+            CHECK(completed[i] == i);
+        }
+    }
+
+    void TestRetirement()
+    {
+        // The tickets polled by a frame are released once the fence value it was retired with has completed,
+        // in the order they were polled. A frame that polls nothing retires nothing.
+        JobSystem jobSystem(2);
+        AsyncLoader loader(&jobSystem);
+        for (UINT i = 0; i < 5; i++)
+        {
+            loader.Submit([](UINT) {});
+        }
+        loader.Wait();
+
+        std::vector<UINT> polled;
+        std::vector<UINT> released;
+        loader.Poll(polled, 2);
+        loader.Retire(1);
+        loader.Poll(polled, 2);
+        loader.Retire(2);
+        loader.Retire(3);
+        loader.Poll(polled, 2);
+        CHECK(polled.size() == 5);
+
+        // Tickets polled but not retired yet are not released, whatever the completed fence value.
+        CHECK(loader.Release(0, released) == 0);
+        CHECK(loader.Release(1, released) == 2);
+        CHECK(released[0] == polled[0] && released[1] == polled[1]);
+        CHECK(loader.Release(1, released) == 0);
+        CHECK(loader.Release(UINT64_MAX, released) == 2);
+        CHECK(released[2] == polled[2] && released[3] == polled[3]);
+
+        loader.Retire(4);
+        CHECK(loader.Release(3, released) == 0);
+        CHECK(loader.Release(5, released) == 1);
+        CHECK(released.size() == 5 && released[4] == polled[4]);
+        CHECK(loader.Release(UINT64_MAX, released) == 0);
+    }
+
+    void TestException()
+    {
+        // The first exception of a task is rethrown by the next poll, and the tasks after it are skipped.
+        JobSystem jobSystem(2);
+        AsyncLoader loader(&jobSystem);
+        loader.Submit([](UINT) { throw std::runtime_error("load failed"); });
+        loader.Wait();
+
+        std::atomic<UINT> runsNum(0);
+        loader.Submit([&runsNum](UINT) { runsNum++; });
+        loader.Wait();
+        CHECK(runsNum == 0);
+
+        BOOL isThrown = FALSE;
+        try
+        {
+            std::vector<UINT> completed;
+            loader.Poll(completed, 8);
+        }
+        catch (const std::runtime_error& e)
+        {
+            isThrown = strcmp(e.what(), "load failed") == 0;
+        }
+        CHECK(isThrown);
+    }
+
+    void TestStop()
+    {
+        // Destroying the loader waits for the running tasks and skips the rest, so nothing runs after it.
+        JobSystem jobSystem(2);
+        std::atomic<UINT> runsNum(0);
+        {
+            AsyncLoader loader(&jobSystem);
+            for (UINT i = 0; i < 200; i++)
+            {
+                loader.Submit([&runsNum](UINT)
+                {
+                    std::this_thread::sleep_for(std::chrono::microseconds(100));
+                    runsNum++;
+                });
+            }
+        }
+        const UINT stoppedRunsNum = runsNum;
+        CHECK(stoppedRunsNum < 200);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        CHECK(runsNum == stoppedRunsNum);
+    }
+}
+
+int main()
+{
+    TestCompletionOrder();
+    TestPollLimit();
+    TestRetirement();
+    TestException();
+    TestStop();
+
+    printf("AsyncLoaderTest passed.\n");
+    return 0;
+}
@@ -0,0 +1,184 @@
+#include "stdafx.h"
+#include "DescriptorAllocator.h"
+#include "TestHelper.h"
+#include <set>
+
+namespace
+{
+    struct Range
+    {
+        UINT index;
+        UINT count;
+    };
+
+    void TestRetirement()
+    {
+        DescriptorAllocator allocator(10);
+        UINT index = 0;
+        CHECK(allocator.Allocate(3, index) && index == 0);
+        CHECK(allocator.Allocate(3, index) && index == 3);
+        CHECK(allocator.Allocate(4, index) && index == 6);
+        CHECK(!allocator.Allocate(1, index));
+
+        // A freed range is not reused before the fence value it is retired with has completed.
+        allocator.Free(3, 3);
+        CHECK(!allocator.Allocate(1, index));
+        allocator.Retire(5);
+        allocator.Release(4);
+        CHECK(!allocator.Allocate(1, index));
+        allocator.Release(5);
+        CHECK(allocator.GetUsedNum() == 7);
+        CHECK(allocator.Allocate(3, index) && index == 3);
+
+        // The freed ranges merge back into one.
+        allocator.Free(0, 3);
+        allocator.Free(3, 3);
+        allocator.Free(6, 4);
+        allocator.Retire(6);
+        allocator.Release(6);
+        CHECK(allocator.GetUsedNum() == 0);
+        CHECK(allocator.Allocate(10, index) && index == 0);
+    }
+
+    void TestRandom()
+    {
+        // Random allocations, frees, retirements and releases checked against the owner of each descriptor:
+        // an allocation fails only when there is no free run long enough, and never takes a used descriptor.
+        const UINT capacity = 2048;
+        std::mt19937 random(1);
+        DescriptorAllocator allocator(capacity);
+        std::vector<BOOL> isUsed(capacity, FALSE);
+        std::vector<Range> allocations;
+        std::vector<Range> freedRanges;
+        std::deque<std::pair<UINT64, std::vector<Range>>> retiredRanges;
+        UINT64 fenceValue = 1;
+        UINT64 completedFenceValue = 0;
+        for (UINT i = 0; i < 200000; i++)
+        {
+            const UINT operation = random() % 10;
+            if (operation < 5)
+            {
+                const UINT count = 1 + random() % (random() % 4 == 0 ? 16 : 3);
+                BOOL isFreeRun = FALSE;
+                UINT run = 0;
+                for (UINT j = 0; j < capacity && !isFreeRun; j++)
+                {
+                    run = isUsed[j] ? 0 : run + 1;
+                    isFreeRun = run >= count;
+                }
+
+                UINT index = 0;
+                const BOOL isAllocated = allocator.Allocate(count, index);
+                CHECK(isAllocated == isFreeRun);
+                if (isAllocated)
+                {
+                    for (UINT j = index; j < index + count; j++)
+                    {
+                        CHECK(!isUsed[j]);
+                        isUsed[j] = TRUE;
+                    }
+                    allocations.push_back({ index, count });
+                }
+            }
+            else if (operation < 8 && !allocations.empty())
+            {
+                const UINT j = random() % allocations.size();
+                const Range range = allocations[j];
+                allocations[j] = allocations.back();
+                allocations.pop_back();
+                allocator.Free(range.index, range.count);
+                freedRanges.push_back(range);
+            }
+            else if (operation == 8)
+            {
+                retiredRanges.push_back({ fenceValue, freedRanges });
+                freedRanges.clear();
+                allocator.Retire(fenceValue++);
+            }
+            else
+            {
+                if (completedFenceValue + 1 < fenceValue && random() % 2 == 0)
+                {
+                    completedFenceValue++;
+                }
+                allocator.Release(completedFenceValue);
+                while (!retiredRanges.empty() && retiredRanges.front().first <= completedFenceValue)
+                {
+                    for (const Range& range : retiredRanges.front().second)
+                    {
+                        std::fill(isUsed.begin() + range.index, isUsed.begin() + range.index + range.count, FALSE);
+                    }
+                    retiredRanges.pop_front();
+                }
+            }
+
+            CHECK(allocator.GetUsedNum() == static_cast<UINT>(std::count(isUsed.begin(), isUsed.end(), TRUE)));
+        }
+    }
+
+    void TestThreads()
+    {
+        // The loader threads allocate and free while the render thread retires and releases.
+        const UINT threadsNum = 8;
+        DescriptorAllocator allocator(1 << 16);
+        std::vector<std::vector<UINT>> allocations(threadsNum);
+        std::atomic<UINT> runningThreadsNum(threadsNum);
+        std::vector<std::thread> threads;
+        for (UINT i = 0; i < threadsNum; i++)
+        {
+            threads.emplace_back([&allocator, &allocations, &runningThreadsNum, i]()
+            {
+                for (UINT j = 0; j < 2000; j++)
+                {
+                    UINT index = 0;
+                    if (allocator.Allocate(3, index))
+                    {
+                        allocations[i].push_back(index);
+                    }
+                    if (j % 2 == 1 && !allocations[i].empty())
+                    {
+                        allocator.Free(allocations[i].back(), 3);
+                        allocations[i].pop_back();
+                    }
+                }
+                runningThreadsNum--;
+            });
+        }
+
+        UINT64 fenceValue = 0;
+        while (runningThreadsNum > 0)
+        {
+            allocator.Retire(++fenceValue);
+            allocator.Release(fenceValue > 2 ? fenceValue - 2 : 0);
+        }
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+        allocator.Retire(++fenceValue);
+        allocator.Release(fenceValue);
+
+        std::set<UINT> indices;
+        for (const std::vector<UINT>& threadAllocations : allocations)
+        {
+            for (UINT index : threadAllocations)
+            {
+                for (UINT j = index; j < index + 3; j++)
+                {
+                    CHECK(indices.insert(j).second);
+                }
+            }
+        }
+        CHECK(allocator.GetUsedNum() == indices.size());
+    }
+}
+
+int main()
+{
+    TestRetirement();
+    TestRandom();
+    TestThreads();
+
+    printf("DescriptorAllocatorTest passed.\n");
+    return 0;
+}
@@ -0,0 +1,117 @@
+#include "stdafx.h"
+#include "DescriptorCache.h"
+#include "MappedFile.h"
+#include "MeshCache.h"
+#include "SceneManifest.h"
+#include "TestHelper.h"
+
+namespace
+{
+    const UINT kTexturesPerMaterial = 3;
+    const UINT kPlaceholderTexturesNum = 3;
+
+    void RemoveFile(const std::wstring& path)
+    {
+#ifdef _WIN32
+        _wremove(path.c_str());
+#else
+        remove(MappedFile::ToUTF8(path).c_str());
+#endif
+    }
+
+    // The description D3D12Texture::CreateSampler gives every texture, over whatever the sampler held.
+    D3D12_SAMPLER_DESC GetTextureSamplerDesc(BYTE garbage)
+    {
+        D3D12_SAMPLER_DESC desc;
+        memset(&desc, garbage, sizeof(desc));
+        desc = {};
+        desc.Filter = D3D12_FILTER_ANISOTROPIC;
+        desc.AddressU = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
+        desc.AddressV = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
+        desc.AddressW = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
+        desc.MipLODBias = 0;
+        desc.MaxAnisotropy = 16;
+        desc.ComparisonFunc = D3D12_COMPARISON_FUNC_NEVER;
+        desc.MinLOD = 0.0f;
+        desc.MaxLOD = D3D12_FLOAT32_MAX;
+        return desc;
+    }
+
+    // As D3D12DescriptorHeapManager::CreateSampler, with the next free index for a new sampler.
+    UINT CreateSampler(DescriptorCache& cache, const D3D12_SAMPLER_DESC& desc)
+    {
+        std::string key;
+        DescriptorCache::AppendKey(key, desc);
+        UINT index = 0;
+        if (!cache.Find(key, index))
+        {
+            index = cache.GetSize();
+            cache.Insert(key, index);
+        }
+
+        return index;
+    }
+
+    void TestSampleSceneSamplers()
+    {
+        // The placeholders, the textures of every material of the sample scene and the skybox share one sampler.
+        const std::wstring scenePath = GetAssetPath(L"scene");
+        const UINT64 sceneTimestamp = MeshCache::GetSourceTimestamp(scenePath);
+        UINT materialsNum = 0;
+        {
+            SceneManifest manifest;
+            CHECK(SceneManifest::Convert(scenePath, L"DescriptorCacheTest.manifest", sceneTimestamp));
+            CHECK(manifest.Load(L"DescriptorCacheTest.manifest", sceneTimestamp));
+            materialsNum = manifest.GetMaterialsNum();
+        }
+        RemoveFile(L"DescriptorCacheTest.manifest");
+        CHECK(materialsNum > 0);
+
+        DescriptorCache samplers;
+        const UINT texturesNum = kPlaceholderTexturesNum + materialsNum * kTexturesPerMaterial + 1;
+        for (UINT i = 0; i < texturesNum; i++)
+        {
+            CHECK(CreateSampler(samplers, GetTextureSamplerDesc(static_cast<BYTE>(i))) == 0);
+        }
+        CHECK(samplers.GetSize() == 1);
+        CHECK(samplers.GetMissesNum() == 1 && samplers.GetHitsNum() == texturesNum - 1);
+
+        D3D12_SAMPLER_DESC clampDesc = GetTextureSamplerDesc(0);
+        clampDesc.AddressU = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
+        CHECK(CreateSampler(samplers, clampDesc) == 1);
+        CHECK(samplers.GetSize() == 2);
+    }
+
+    void TestViews()
+    {
+        DescriptorCache views;
+        const std::string a = "A";
+        const std::string b = "B";
+        CHECK(!views.Contains(a, 0));
+        views.Insert(a, 0);
+        CHECK(views.Contains(a, 0) && !views.Contains(a, 1));
+
+        // A key written to a second descriptor is found there, and the first one still holds it.
+        views.Insert(a, 1);
+        CHECK(views.Contains(a, 0) && views.Contains(a, 1));
+        UINT index = 0;
+        CHECK(views.Find(a, index) && index == 1);
+
+        // Writing another key over a descriptor forgets what it held.
+        views.Insert(b, 0);
+        CHECK(!views.Contains(a, 0) && views.Contains(a, 1) && views.Contains(b, 0));
+        views.Remove(1);
+        CHECK(!views.Find(a, index) && !views.Contains(a, 1));
+        views.Remove(7);
+        CHECK(views.GetSize() == 1);
+    }
+}
+
+int main()
+{
+    TestSampleSceneSamplers();
+    TestViews();
+
+    printf("DescriptorCacheTest passed.\n");
+    return 0;
+}
@@ -0,0 +1,145 @@
+#include "stdafx.h"
+#include "DrawChunkScheduler.h"
+#include "TestHelper.h"
+#include <stdexcept>
+
+namespace
+{
+    // The chunks cover the draws in order, one after another, with no more chunks than allowed.
+    void CheckSplit(const std::vector<UINT>& costs, UINT maxChunksNum, UINT64 minChunkCost)
+    {
+        std::vector<DrawChunk> chunks;
+        DrawChunkScheduler::Split(costs.data(), static_cast<UINT>(costs.size()), maxChunksNum, minChunkCost, chunks);
+        if (costs.empty())
+        {
+            CHECK(chunks.empty());
+            return;
+        }
+
+        CHECK(!chunks.empty() && chunks.size() <= max(maxChunksNum, 1u) && chunks.size() <= costs.size());
+        CHECK(chunks.front().begin == 0 && chunks.back().end == costs.size());
+        UINT64 totalCost = 0;
+        for (UINT cost : costs)
+        {
+            totalCost += cost;
+        }
+        for (UINT i = 0; i < chunks.size(); i++)
+        {
+            CHECK(chunks[i].begin < chunks[i].end);
+            CHECK(i == 0 || chunks[i].begin == chunks[i - 1].end);
+        }
+        CHECK(minChunkCost == 0 || chunks.size() == 1 || chunks.size() <= totalCost / minChunkCost);
+    }
+
+    void TestSplit()
+    {
+        CheckSplit({}, 8, 4);
+        CheckSplit({ 5 }, 8, 4);
+        CheckSplit({ 1, 1, 1 }, 8, 100);
+        CheckSplit(std::vector<UINT>(10, 0), 4, 1);
+        CheckSplit(std::vector<UINT>(10, 3), 4, 0);
+
+        // Even costs split evenly, into as many chunks as the minimum cost allows.
+        std::vector<UINT> costs(1000, 1);
+        std::vector<DrawChunk> chunks;
+        DrawChunkScheduler::Split(costs.data(), 1000, 16, 64, chunks);
+        CHECK(chunks.size() == 15);
+        for (const DrawChunk& chunk : chunks)
+        {
+            CHECK(chunk.end - chunk.begin >= 66 && chunk.end - chunk.begin <= 67);
+        }
+        DrawChunkScheduler::Split(costs.data(), 1000, 4, 64, chunks);
+        CHECK(chunks.size() == 4);
+        for (const DrawChunk& chunk : chunks)
+        {
+            CHECK(chunk.end - chunk.begin == 250);
+        }
+        DrawChunkScheduler::Split(costs.data(), 50, 4, 64, chunks);
+        CHECK(chunks.size() == 1 && chunks[0].end == 50);
+
+        // A draw that costs more than a share of the total is a chunk of its own, and the rest still leaves
+        // a draw for each of the chunks after it.
+        costs.assign(100, 1);
+        costs[0] = 1000;
+        DrawChunkScheduler::Split(costs.data(), 100, 4, 1, chunks);
+        CHECK(chunks.size() == 4 && chunks[0].end == 1);
+
+        std::mt19937 random(1);
+        for (UINT i = 0; i < 500; i++)
+        {
+            costs.resize(random() % 300);
+            for (UINT& cost : costs)
+            {
+                cost = random() % 50;
+            }
+            CheckSplit(costs, 1 + random() % 32, random() % 200);
+        }
+    }
+
+    void TestRun()
+    {
+        // Every chunk runs once on one of the threads of the job system, and an exception is rethrown once the
+        // others are done.
+        for (UINT workerCount : { 1u, 3u, 7u })
+        {
+            JobSystem jobSystem(workerCount);
+            DrawChunkScheduler scheduler(&jobSystem);
+            const UINT threadCount = workerCount + 1;
+            CHECK(scheduler.GetThreadCount() == threadCount);
+            for (UINT i = 0; i < 200; i++)
+            {
+                const UINT chunksNum = i % 37;
+                std::vector<std::atomic<UINT>> runsNum(chunksNum);
+                std::atomic<BOOL> isThreadValid(TRUE);
+                for (std::atomic<UINT>& chunkRunsNum : runsNum)
+                {
+                    chunkRunsNum = 0;
+                }
+                scheduler.Run(chunksNum, [&runsNum, &isThreadValid, threadCount](UINT thread, UINT chunk)
+                {
+                    if (thread >= threadCount)
+                    {
+                        isThreadValid = FALSE;
+                    }
+                    runsNum[chunk]++;
+                });
+                CHECK(isThreadValid);
+                for (const std::atomic<UINT>& chunkRunsNum : runsNum)
+                {
+                    CHECK(chunkRunsNum == 1);
+                }
+            }
+
+            BOOL isThrown = FALSE;
+            try
+            {
+                scheduler.Run(20, [](UINT, UINT chunk)
+                {
+                    if (chunk == 7)
+                    {
+                        throw std::runtime_error("chunk");
+                    }
+                });
+            }
+            catch (const std::runtime_error&)
+            {
+                isThrown = TRUE;
+            }
+            CHECK(isThrown);
+
+            // The scheduler runs again after a failed run.
+            std::atomic<UINT> chunksNum(0);
+            scheduler.Run(20, [&chunksNum](UINT, UINT) { chunksNum++; });
+            CHECK(chunksNum == 20);
+        }
+    }
+}
+
+int main()
+{
+    TestSplit();
+    TestRun();
+
+    printf("DrawChunkSchedulerTest passed.\n");
+    return 0;
+}
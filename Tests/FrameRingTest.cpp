@@ -0,0 +1,121 @@
+#include "stdafx.h"
+#include "FrameRing.h"
+#include "RingAllocator.h"
+#include "TestHelper.h"
+#include <tuple>
+
+namespace
+{
+    // A queue that finishes the frames submitted to it in order, and signals the fence value of each.
+    struct SimulatedGPU
+    {
+        UINT64 completedFenceValue;
+        // The fence value and the slot of the frames submitted and not finished.
+        std::deque<std::pair<UINT64, UINT>> frames;
+        // The frames of each slot the GPU has not finished.
+        std::vector<UINT> slotFramesNum;
+
+        SimulatedGPU(UINT framesNum) : completedFenceValue(0), slotFramesNum(framesNum, 0) {}
+
+        void Submit(UINT64 fenceValue, UINT slot)
+        {
+            frames.push_back({ fenceValue, slot });
+            slotFramesNum[slot]++;
+        }
+
+        void Finish(UINT framesNum)
+        {
+            for (UINT i = 0; i < framesNum && !frames.empty(); i++)
+            {
+                completedFenceValue = frames.front().first;
+                slotFramesNum[frames.front().second]--;
+                frames.pop_front();
+            }
+        }
+    };
+
+    void TestSlots()
+    {
+        FrameRing ring(3);
+        CHECK(ring.GetFramesNum() == 3 && ring.GetFrameIndex() == 0 && ring.GetWaitFenceValue() == 0);
+        CHECK(ring.IsFrameReady(0));
+
+        // Fence values only go up.
+        CHECK(ring.EndFrame(5) && ring.GetFrameIndex() == 1);
+        CHECK(!ring.EndFrame(5) && !ring.EndFrame(4));
+        CHECK(ring.EndFrame(6) && ring.EndFrame(9));
+
+        // The first slot comes round again, and waits for the frame that used it.
+        CHECK(ring.GetFrameIndex() == 0 && ring.GetWaitFenceValue() == 5);
+        CHECK(!ring.IsFrameReady(4) && ring.IsFrameReady(5));
+        CHECK(ring.GetFramesInFlight(0) == 3 && ring.GetFramesInFlight(5) == 2 && ring.GetFramesInFlight(9) == 0);
+
+        FrameRing emptyRing(0);
+        CHECK(emptyRing.GetFramesNum() == 1);
+    }
+
+    void TestSimulatedFence()
+    {
+        // Frames record while the GPU finishes the earlier ones at its own pace: a frame only writes the
+        // resources of its slot once the GPU is done with them, and the upload memory of a frame is only
+        // reused once the GPU has finished it.
+        for (UINT framesNum = 1; framesNum <= 4; framesNum++)
+        {
+            std::mt19937 random(framesNum);
+            FrameRing ring(framesNum);
+            SimulatedGPU gpu(framesNum);
+            RingAllocator uploadRing(1 << 20);
+            // The fence value, the offset and the size of the uploads of the frames the GPU may still read.
+            std::deque<std::tuple<UINT64, UINT64, UINT64>> uploads;
+            UINT64 fenceValue = 1;
+            UINT maxFramesInFlight = 0;
+            for (UINT i = 0; i < 5000; i++)
+            {
+                while (!ring.IsFrameReady(gpu.completedFenceValue))
+                {
+                    gpu.Finish(1);
+                }
+                CHECK(gpu.slotFramesNum[ring.GetFrameIndex()] == 0);
+                CHECK(ring.GetFramesInFlight(gpu.completedFenceValue) < framesNum);
+                maxFramesInFlight = max(maxFramesInFlight, ring.GetFramesInFlight(gpu.completedFenceValue));
+
+                uploadRing.Release(gpu.completedFenceValue);
+                while (!uploads.empty() && std::get<0>(uploads.front()) <= gpu.completedFenceValue)
+                {
+                    uploads.pop_front();
+                }
+
+                UINT64 offset = 0;
+                const UINT64 size = 1000 + random() % 50000;
+                CHECK(uploadRing.Allocate(size, 256, offset));
+                for (const auto& upload : uploads)
+                {
+                    CHECK(offset + size <= std::get<1>(upload) || std::get<1>(upload) + std::get<2>(upload) <= offset);
+                }
+                const UINT64 frameFenceValue = fenceValue++;
+                uploads.push_back(std::make_tuple(frameFenceValue, offset, size));
+                uploadRing.Retire(frameFenceValue);
+                gpu.Submit(frameFenceValue, ring.GetFrameIndex());
+                CHECK(ring.EndFrame(frameFenceValue));
+
+                gpu.Finish(random() % 3);
+            }
+
+            // The CPU runs ahead by all the slots but the one it records.
+            CHECK(maxFramesInFlight == framesNum - 1);
+            gpu.Finish(UINT_MAX);
+            uploadRing.Release(gpu.completedFenceValue);
+            CHECK(uploadRing.GetUsedSize() == 0);
+            CHECK(ring.GetFramesInFlight(gpu.completedFenceValue) == 0);
+        }
+    }
+}
+
+int main()
+{
+    TestSlots();
+    TestSimulatedFence();
+
+    printf("FrameRingTest passed.\n");
+    return 0;
+}
@@ -0,0 +1,125 @@
+#include "stdafx.h"
+#include "JobSystem.h"
+#include "TestHelper.h"
+#include <stdexcept>
+
+namespace
+{
+    void TestParallelFor()
+    {
+        // Every index is covered once, on one of the threads of the job system.
+        JobSystem jobSystem(3);
+        for (UINT i = 0; i < 2000; i++)
+        {
+            std::vector<std::atomic<UINT>> runsNum(1000);
+            std::atomic<BOOL> isThreadValid(TRUE);
+            for (std::atomic<UINT>& indexRunsNum : runsNum)
+            {
+                indexRunsNum = 0;
+            }
+            jobSystem.ParallelFor(1000, 8, [&jobSystem, &runsNum, &isThreadValid](UINT thread, UINT begin, UINT end)
+            {
+                if (thread >= jobSystem.GetThreadCount())
+                {
+                    isThreadValid = FALSE;
+                }
+                for (UINT j = begin; j < end; j++)
+                {
+                    runsNum[j]++;
+                }
+            });
+            CHECK(isThreadValid);
+            for (const std::atomic<UINT>& indexRunsNum : runsNum)
+            {
+                CHECK(indexRunsNum == 1);
+            }
+        }
+
+        // A range can run a ParallelFor of its own.
+        std::atomic<UINT> count(0);
+        jobSystem.ParallelFor(64, 1, [&jobSystem, &count](UINT, UINT begin, UINT end)
+        {
+            for (UINT i = begin; i < end; i++)
+            {
+                jobSystem.ParallelFor(100, 4, [&count](UINT, UINT innerBegin, UINT innerEnd)
+                {
+                    count += innerEnd - innerBegin;
+                });
+            }
+        });
+        CHECK(count == 6400);
+
+        BOOL isThrown = FALSE;
+        try
+        {
+            jobSystem.ParallelFor(1000, 1, [](UINT, UINT begin, UINT)
+            {
+                if (begin > 500)
+                {
+                    throw std::runtime_error("range");
+                }
+            });
+        }
+        catch (const std::runtime_error&)
+        {
+            isThrown = TRUE;
+        }
+        CHECK(isThrown);
+    }
+
+    void TestChildJobs()
+    {
+        // A job is finished once it and all its children have run.
+        JobSystem jobSystem(3);
+        std::atomic<UINT> count(0);
+        Job* pRoot = jobSystem.CreateJob([&count](UINT) { count += 100; });
+        for (UINT i = 0; i < 50; i++)
+        {
+            jobSystem.Run(jobSystem.CreateChildJob(pRoot, [&count](UINT) { count++; }));
+        }
+        jobSystem.Run(pRoot);
+        jobSystem.Wait(pRoot);
+        CHECK(jobSystem.IsFinished(pRoot) && count == 150);
+    }
+
+    void TestBackground()
+    {
+        // Background tasks do not take jobs of the pools, so more of them than a pool holds can wait at once,
+        // from the thread that created the job system as from any other, while the frames keep using jobs.
+        JobSystem jobSystem(2);
+        const UINT tasksNum = JOB_POOL_SIZE * 3;
+        std::atomic<UINT> runTasksNum(0);
+        for (UINT i = 0; i < tasksNum; i++)
+        {
+            jobSystem.RunBackground([&runTasksNum](UINT) { runTasksNum++; });
+        }
+        std::thread thread([&jobSystem, &runTasksNum]()
+        {
+            CHECK(jobSystem.GetThreadIndex() == UINT_MAX);
+            for (UINT i = 0; i < tasksNum; i++)
+            {
+                jobSystem.RunBackground([&runTasksNum](UINT) { runTasksNum++; });
+            }
+        });
+
+        while (runTasksNum < tasksNum * 2)
+        {
+            std::atomic<UINT> count(0);
+            jobSystem.ParallelFor(4096, 64, [&count](UINT, UINT begin, UINT end) { count += end - begin; });
+            CHECK(count == 4096);
+            std::this_thread::yield();
+        }
+        thread.join();
+        CHECK(runTasksNum == tasksNum * 2);
+    }
+}
+
+int main()
+{
+    TestParallelFor();
+    TestChildJobs();
+    TestBackground();
+
+    printf("JobSystemTest passed.\n");
+    return 0;
+}
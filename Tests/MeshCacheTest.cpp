@@ -0,0 +1,217 @@
+#include "stdafx.h"
+#include "MappedFile.h"
+#include "MeshCache.h"
+#include "MeshletBuilder.h"
+#include "TestHelper.h"
+
+namespace
+{
+    const D3D12_RAYTRACING_AABB kBoundingBox = { -1.0f, -1.0f, 0.0f, 1.0f, 1.0f, 0.0f };
+
+    BOOL RemoveFile(const std::wstring& path)
+    {
+#ifdef _WIN32
+        return _wremove(path.c_str()) == 0;
+#else
+        return remove(MappedFile::ToUTF8(path).c_str()) == 0;
+#endif
+    }
+
+    void CreateMesh(MeshData& mesh)
+    {
+        std::vector<Vertex> vertices;
+        std::vector<UINT> indices;
+        CreateGrid(64, vertices, indices);
+
+        mesh.SetVertices(vertices.data(), static_cast<UINT>(vertices.size() * sizeof(Vertex)));
+        mesh.SetIndices(indices.data(), static_cast<UINT>(indices.size() * sizeof(UINT)));
+        mesh.AddSubmesh({ 0, static_cast<UINT>(indices.size()), 0, static_cast<UINT>(vertices.size()) });
+        const D3D12MeshLod lods[] =
+        {
+            { 0, static_cast<UINT>(indices.size()), 0.0f },
+            { 0, static_cast<UINT>(indices.size()) / 2, 0.01f },
+        };
+        mesh.SetLods(lods, _countof(lods));
+        mesh.SetUVDensity(0.5f);
+        MeshletBuilder::BuildMeshlets(&mesh);
+    }
+
+    template <typename T>
+    BOOL IsEqual(const std::vector<T>& a, const std::vector<T>& b)
+    {
+        return a.size() == b.size() && (a.empty() || memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0);
+    }
+
+    void TestRoundTrip(const std::wstring& path)
+    {
+        MeshData mesh;
+        CreateMesh(mesh);
+        CHECK(mesh.GetMeshlets().size() > 1);
+        CHECK(MeshCache::SaveMesh(path, 42, &mesh, kBoundingBox));
+
+        MeshData loaded;
+        D3D12_RAYTRACING_AABB boundingBox = {};
+        CHECK(MeshCache::LoadMesh(path, 42, &loaded, boundingBox));
+        CHECK(memcmp(&boundingBox, &kBoundingBox, sizeof(boundingBox)) == 0);
+        CHECK(loaded.GetVerticesSize() == mesh.GetVerticesSize());
+        CHECK(memcmp(loaded.GetVerticesData(), mesh.GetVerticesData(), mesh.GetVerticesSize()) == 0);
+        CHECK(loaded.GetIndexStride() == sizeof(UINT));
+        CHECK(loaded.GetIndicesSize() == mesh.GetIndicesSize());
+        CHECK(memcmp(loaded.GetIndicesData(), mesh.GetIndicesData(), mesh.GetIndicesSize()) == 0);
+        CHECK(IsEqual(loaded.GetSubmeshes(), mesh.GetSubmeshes()));
+        CHECK(IsEqual(loaded.GetLods(), mesh.GetLods()));
+        CHECK(IsEqual(loaded.GetMeshlets(), mesh.GetMeshlets()));
+        CHECK(IsEqual(loaded.GetMeshletVertices(), mesh.GetMeshletVertices()));
+        CHECK(IsEqual(loaded.GetMeshletTriangles(), mesh.GetMeshletTriangles()));
+        CHECK(loaded.GetUVDensity() == mesh.GetUVDensity());
+    }
+
+    void TestSourceStamps(const std::wstring& path)
+    {
+        MeshData mesh;
+        D3D12_RAYTRACING_AABB boundingBox = {};
+        CHECK(!MeshCache::LoadMesh(path, 43, &mesh, boundingBox));
+
+        // An unknown stamp never matches, the source has to be known to be absent to take any file.
+        CHECK(!MeshCache::LoadMesh(path, 0, &mesh, boundingBox));
+        CHECK(MeshCache::LoadMesh(path, MESH_CACHE_ANY_SOURCE_STAMP, &mesh, boundingBox));
+
+        MeshData source;
+        CreateMesh(source);
+        CHECK(!MeshCache::SaveMesh(path + L".unknown", 0, &source, kBoundingBox));
+        CHECK(!MappedFile::Exists(path + L".unknown"));
+    }
+
+    void TestCorruptFiles(const std::wstring& path)
+    {
+        MappedFile file;
+        CHECK(file.Open(path));
+        std::vector<BYTE> data(file.GetData(), file.GetData() + file.GetSize());
+        file.Close();
+
+        // Every section is bounds checked against the size of the file.
+        const std::wstring truncatedPath = path + L".truncated";
+        CHECK(MappedFile::Write(truncatedPath, data.data(), data.size() - 1));
+        MeshData mesh;
+        D3D12_RAYTRACING_AABB boundingBox = {};
+        CHECK(!MeshCache::LoadMesh(truncatedPath, 42, &mesh, boundingBox));
+        CHECK(MappedFile::Write(truncatedPath, data.data(), sizeof(MeshCacheHeader) - 1));
+        CHECK(!MeshCache::LoadMesh(truncatedPath, 42, &mesh, boundingBox));
+
+        MeshCacheHeader* pHeader = reinterpret_cast<MeshCacheHeader*>(data.data());
+        pHeader->version++;
+        CHECK(MappedFile::Write(truncatedPath, data.data(), data.size()));
+        CHECK(!MeshCache::LoadMesh(truncatedPath, 42, &mesh, boundingBox));
+        CHECK(!MeshCache::LoadMesh(path + L".missing", 42, &mesh, boundingBox));
+
+        RemoveFile(truncatedPath);
+    }
+
+    // Write the file with one change to its data, and check that it is rejected without touching the mesh.
+    template <typename T>
+    void CheckRejected(const std::wstring& path, std::vector<BYTE> data, UINT offset, T value)
+    {
+        memcpy(data.data() + offset, &value, sizeof(T));
+        CHECK(MappedFile::Write(path, data.data(), data.size()));
+        MeshData mesh;
+        D3D12_RAYTRACING_AABB boundingBox = {};
+        CHECK(!MeshCache::LoadMesh(path, 42, &mesh, boundingBox));
+        CHECK(mesh.GetVerticesNum() == 0 && mesh.GetIndicesNum() == 0 && mesh.GetSubmeshes().empty());
+    }
+
+    void TestCorruptContents(const std::wstring& path)
+    {
+        // Indices and ranges past the vertices or the indices of the file would be drawn out of bounds, so
+        // they fail the load like a truncated file, and the model imports the FBX again.
+        MappedFile file;
+        CHECK(file.Open(path));
+        const std::vector<BYTE> data(file.GetData(), file.GetData() + file.GetSize());
+        file.Close();
+
+        const MeshCacheHeader header = *reinterpret_cast<const MeshCacheHeader*>(data.data());
+        const std::wstring corruptPath = path + L".corrupt";
+        CHECK(MappedFile::Write(corruptPath, data.data(), data.size()));
+        MeshData mesh;
+        D3D12_RAYTRACING_AABB boundingBox = {};
+        CHECK(MeshCache::LoadMesh(corruptPath, 42, &mesh, boundingBox));
+
+        const UINT lastIndex = header.indicesOffset + (header.indicesNum - 1) * sizeof(UINT);
+        CheckRejected(corruptPath, data, lastIndex, header.verticesNum);
+        CheckRejected(corruptPath, data, header.meshletVerticesOffset + 5 * sizeof(UINT), header.verticesNum + 100);
+
+        // The third corner of the first triangle of the first meshlet points past its vertices.
+        const D3D12Meshlet meshlet = *reinterpret_cast<const D3D12Meshlet*>(data.data() + header.meshletsOffset);
+        const UINT triangle = *reinterpret_cast<const UINT*>(data.data() + header.meshletTrianglesOffset);
+        CheckRejected(corruptPath, data, header.meshletTrianglesOffset,
+            MeshletBuilder::PackTriangle(triangle & 0x3FF, (triangle >> 10) & 0x3FF, meshlet.verticesNum));
+
+        const UINT lastMeshlet = header.meshletsOffset + (header.meshletsNum - 1) * sizeof(D3D12Meshlet);
+        CheckRejected(corruptPath, data, lastMeshlet + offsetof(D3D12Meshlet, vertexOffset), header.meshletVerticesNum);
+        CheckRejected(corruptPath, data, lastMeshlet + offsetof(D3D12Meshlet, triangleOffset), header.meshletTrianglesNum);
+        CheckRejected(corruptPath, data, lastMeshlet + offsetof(D3D12Meshlet, indexStart), header.indicesNum);
+        CheckRejected(corruptPath, data, lastMeshlet + offsetof(D3D12Meshlet, verticesNum), MESHLET_MAX_VERTICES + 1);
+
+        const UINT lastLod = header.lodsOffset + (header.lodsNum - 1) * sizeof(D3D12MeshLod);
+        CheckRejected(corruptPath, data, lastLod + offsetof(D3D12MeshLod, indexStart), header.indicesNum / 2 + 3);
+        CheckRejected(corruptPath, data, lastLod + offsetof(D3D12MeshLod, indicesNum), header.indicesNum + 3);
+        CheckRejected(corruptPath, data, header.submeshesOffset + offsetof(D3D12Submesh, verticesNum), header.verticesNum + 1);
+        CheckRejected(corruptPath, data, header.submeshesOffset + offsetof(D3D12Submesh, indicesNum), header.indicesNum + 3);
+
+        // 16-bit indices are checked the same way.
+        std::vector<Vertex> vertices;
+        std::vector<UINT> indices;
+        CreateGrid(8, vertices, indices);
+        const std::vector<UINT16> shortIndices(indices.begin(), indices.end());
+        MeshData shortMesh;
+        shortMesh.SetVertices(vertices.data(), static_cast<UINT>(vertices.size() * sizeof(Vertex)));
+        shortMesh.SetIndices(shortIndices.data(), static_cast<UINT>(shortIndices.size() * sizeof(UINT16)));
+        CHECK(MeshCache::SaveMesh(corruptPath, 42, &shortMesh, kBoundingBox));
+        CHECK(file.Open(corruptPath));
+        const std::vector<BYTE> shortData(file.GetData(), file.GetData() + file.GetSize());
+        file.Close();
+        CHECK(MeshCache::LoadMesh(corruptPath, 42, &mesh, boundingBox));
+        const MeshCacheHeader shortHeader = *reinterpret_cast<const MeshCacheHeader*>(shortData.data());
+        CHECK(shortHeader.indexStride == sizeof(UINT16));
+        CheckRejected(corruptPath, shortData, shortHeader.indicesOffset + 7 * sizeof(UINT16),
+            static_cast<UINT16>(vertices.size()));
+
+        RemoveFile(corruptPath);
+    }
+
+    void TestMappedFile()
+    {
+        // A path outside of ASCII, which is UTF-8 on the file APIs outside of Windows.
+        const std::wstring path = L"MappedFile\u00E9\u6F22\U0001F600.bin";
+        const BYTE data[] = { 1, 2, 3, 4, 5 };
+        CHECK(MappedFile::Write(path, data, sizeof(data)));
+        CHECK(MappedFile::Exists(path));
+        CHECK(MappedFile::GetLastWriteTime(path) != 0);
+
+        MappedFile file;
+        CHECK(file.Open(path));
+        CHECK(file.GetSize() == sizeof(data));
+        CHECK(memcmp(file.GetData(), data, sizeof(data)) == 0);
+        file.Close();
+        CHECK(file.GetData() == nullptr);
+
+        CHECK(MappedFile::ToUTF8(L"a\u00E9") == "a\xC3\xA9");
+        CHECK(RemoveFile(path));
+        CHECK(!MappedFile::Exists(path));
+        CHECK(MappedFile::GetLastWriteTime(path) == 0);
+        CHECK(!file.Open(path));
+    }
+}
+
+int main()
+{
+    const std::wstring path = L"MeshCacheTest.mesh";
+    TestRoundTrip(path);
+    TestSourceStamps(path);
+    TestCorruptFiles(path);
+    TestCorruptContents(path);
+    TestMappedFile();
+    RemoveFile(path);
+
+    printf("MeshCacheTest passed.\n");
+    return 0;
+}
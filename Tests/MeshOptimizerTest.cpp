@@ -0,0 +1,217 @@
+#include "stdafx.h"
+#include "MeshOptimizer.h"
+#include "TestHelper.h"
+#include <tuple>
+
+namespace
+{
+    typedef std::tuple<FLOAT, FLOAT, FLOAT> Position;
+    typedef std::tuple<Position, Position, Position> Triangle;
+
+    Position GetPosition(const Vertex& vertex)
+    {
+        return Position(vertex.positionOS.x, vertex.positionOS.y, vertex.positionOS.z);
+    }
+
+    // The triangles by the positions of their corners, each rotated to start at its smallest corner so the
+    // winding is kept, sorted.
+    std::vector<Triangle> GetTriangles(const std::vector<Vertex>& vertices, const std::vector<UINT>& indices)
+    {
+        std::vector<Triangle> triangles;
+        for (UINT i = 0; i + 2 < indices.size(); i += 3)
+        {
+            Position corners[3] =
+            {
+                GetPosition(vertices[indices[i + 0]]),
+                GetPosition(vertices[indices[i + 1]]),
+                GetPosition(vertices[indices[i + 2]]),
+            };
+            const UINT first = static_cast<UINT>(std::min_element(corners, corners + 3) - corners);
+            triangles.push_back(Triangle(corners[first], corners[(first + 1) % 3], corners[(first + 2) % 3]));
+        }
+        std::sort(triangles.begin(), triangles.end());
+
+        return triangles;
+    }
+
+    // The triangles of a grid in a random order, as the FBX importer may give them.
+    void CreateShuffledGrid(UINT size, std::vector<Vertex>& vertices, std::vector<UINT>& indices, UINT seed)
+    {
+        CreateGrid(size, vertices, indices);
+        std::vector<UINT> triangles(indices.size() / 3);
+        std::iota(triangles.begin(), triangles.end(), 0);
+        std::shuffle(triangles.begin(), triangles.end(), std::mt19937(seed));
+
+        std::vector<UINT> shuffled;
+        for (UINT triangle : triangles)
+        {
+            shuffled.insert(shuffled.end(), indices.begin() + triangle * 3, indices.begin() + triangle * 3 + 3);
+        }
+        indices.swap(shuffled);
+    }
+
+    FLOAT GetACMR(const std::vector<UINT>& indices, UINT verticesNum)
+    {
+        return MeshOptimizer::AnalyzeVertexCache(indices.data(), static_cast<UINT>(indices.size()), verticesNum).acmr;
+    }
+
+    void TestVertexCache()
+    {
+        // The same triangles come out, with fewer vertices transformed per triangle than the row order of the
+        // grid and far fewer than a random order.
+        for (UINT size : { 1u, 8u, 64u })
+        {
+            std::vector<Vertex> vertices;
+            std::vector<UINT> rowIndices;
+            CreateGrid(size, vertices, rowIndices);
+            std::vector<UINT> indices;
+            CreateShuffledGrid(size, vertices, indices, size);
+            const UINT verticesNum = static_cast<UINT>(vertices.size());
+            const std::vector<Triangle> triangles = GetTriangles(vertices, indices);
+            const FLOAT rowACMR = GetACMR(rowIndices, verticesNum);
+            const FLOAT shuffledACMR = GetACMR(indices, verticesNum);
+
+            MeshOptimizer::OptimizeVertexCache(indices.data(), static_cast<UINT>(indices.size()), verticesNum);
+            CHECK(GetTriangles(vertices, indices) == triangles);
+            const VertexCacheStatistics statistics =
+                MeshOptimizer::AnalyzeVertexCache(indices.data(), static_cast<UINT>(indices.size()), verticesNum);
+            CHECK(statistics.atvr >= 1.0f);
+            if (size > 1)
+            {
+                CHECK(statistics.acmr < rowACMR && statistics.acmr < shuffledACMR);
+            }
+            if (size == 64)
+            {
+                CHECK(statistics.acmr < 0.8f && shuffledACMR > 2.0f);
+            }
+
+            // Optimizing an optimized order keeps it about as good.
+            MeshOptimizer::OptimizeVertexCache(indices.data(), static_cast<UINT>(indices.size()), verticesNum);
+            CHECK(GetACMR(indices, verticesNum) <= statistics.acmr * 1.05f);
+        }
+
+        std::vector<UINT> indices;
+        MeshOptimizer::OptimizeVertexCache(indices.data(), 0, 0);
+        CHECK(MeshOptimizer::AnalyzeVertexCache(indices.data(), 0, 0).acmr == 0.0f);
+    }
+
+    void TestOverdraw()
+    {
+        // Two grids facing +z, one at z = 1 facing away from the middle of the mesh and one at z = -1 facing
+        // into it. The triangles of the outer grid are drawn first, and each grid keeps the order of its
+        // triangles, as the clusters are only reordered as a whole.
+        std::vector<Vertex> vertices;
+        std::vector<UINT> indices;
+        CreateGrid(32, vertices, indices);
+        MeshOptimizer::OptimizeVertexCache(indices.data(), static_cast<UINT>(indices.size()),
+            static_cast<UINT>(vertices.size()));
+        const UINT gridVerticesNum = static_cast<UINT>(vertices.size());
+        const UINT gridIndicesNum = static_cast<UINT>(indices.size());
+        for (UINT i = 0; i < gridVerticesNum; i++)
+        {
+            Vertex vertex = vertices[i];
+            vertices[i].positionOS.z = -1.0f;
+            vertex.positionOS.z = 1.0f;
+            vertices.push_back(vertex);
+        }
+        for (UINT i = 0; i < gridIndicesNum; i++)
+        {
+            indices.push_back(indices[i] + gridVerticesNum);
+        }
+        const UINT verticesNum = static_cast<UINT>(vertices.size());
+        const std::vector<UINT> inner(indices.begin(), indices.begin() + gridIndicesNum);
+        const std::vector<UINT> outer(indices.begin() + gridIndicesNum, indices.end());
+        const FLOAT acmr = GetACMR(indices, verticesNum);
+
+        MeshOptimizer::OptimizeOverdraw(indices.data(), static_cast<UINT>(indices.size()), vertices.data(),
+            verticesNum, OVERDRAW_THRESHOLD);
+        CHECK(std::equal(outer.begin(), outer.end(), indices.begin()));
+        CHECK(std::equal(inner.begin(), inner.end(), indices.begin() + gridIndicesNum));
+        CHECK(GetACMR(indices, verticesNum) <= acmr * OVERDRAW_THRESHOLD);
+
+        // Any order of clusters keeps every triangle, with the order of the triangles in each cluster: the
+        // triangles that follow each other in the output follow each other in the input, but where a
+        // cluster starts.
+        CreateShuffledGrid(48, vertices, indices, 7);
+        MeshOptimizer::OptimizeVertexCache(indices.data(), static_cast<UINT>(indices.size()),
+            static_cast<UINT>(vertices.size()));
+        for (Vertex& vertex : vertices)
+        {
+            vertex.positionOS.z = vertex.positionOS.x * vertex.positionOS.x + vertex.positionOS.y * vertex.positionOS.y;
+        }
+        const std::vector<UINT> input = indices;
+        const std::vector<Triangle> triangles = GetTriangles(vertices, indices);
+        MeshOptimizer::OptimizeOverdraw(indices.data(), static_cast<UINT>(indices.size()), vertices.data(),
+            static_cast<UINT>(vertices.size()), OVERDRAW_THRESHOLD);
+        CHECK(GetTriangles(vertices, indices) == triangles);
+
+        std::map<std::tuple<UINT, UINT, UINT>, UINT> inputTriangles;
+        for (UINT i = 0; i < input.size(); i += 3)
+        {
+            inputTriangles[std::make_tuple(input[i], input[i + 1], input[i + 2])] = i / 3;
+        }
+        UINT clustersNum = 0;
+        UINT previous = UINT_MAX;
+        for (UINT i = 0; i < indices.size(); i += 3)
+        {
+            const UINT triangle = inputTriangles[std::make_tuple(indices[i], indices[i + 1], indices[i + 2])];
+            if (previous == UINT_MAX || triangle != previous + 1)
+            {
+                clustersNum++;
+            }
+            previous = triangle;
+        }
+        CHECK(clustersNum > 1 && clustersNum < input.size() / 3 / 4);
+    }
+
+    void TestVertexFetch()
+    {
+        // The vertices are renumbered by the order they are first used and the unused ones are dropped,
+        // without changing the triangles.
+        std::vector<Vertex> vertices;
+        std::vector<UINT> indices;
+        CreateShuffledGrid(16, vertices, indices, 3);
+        Vertex unused = vertices[0];
+        unused.positionOS = XMFLOAT3(5.0f, 5.0f, 5.0f);
+        vertices.insert(vertices.begin() + 10, unused);
+        for (UINT& index : indices)
+        {
+            index += index >= 10 ? 1 : 0;
+        }
+        MeshOptimizer::OptimizeVertexCache(indices.data(), static_cast<UINT>(indices.size()),
+            static_cast<UINT>(vertices.size()));
+        const std::vector<Triangle> triangles = GetTriangles(vertices, indices);
+        const UINT verticesNum = static_cast<UINT>(vertices.size());
+
+        const UINT newVerticesNum = MeshOptimizer::OptimizeVertexFetch(vertices.data(), indices.data(),
+            static_cast<UINT>(indices.size()), verticesNum);
+        CHECK(newVerticesNum == verticesNum - 1);
+        vertices.resize(newVerticesNum);
+        CHECK(GetTriangles(vertices, indices) == triangles);
+
+        UINT nextIndex = 0;
+        for (UINT index : indices)
+        {
+            CHECK(index <= nextIndex);
+            if (index == nextIndex)
+            {
+                nextIndex++;
+            }
+        }
+        CHECK(nextIndex == newVerticesNum);
+        for (const Vertex& vertex : vertices)
+        {
+            CHECK(vertex.positionOS.x != unused.positionOS.x);
+        }
+    }
+}
+
+int main()
+{
+    TestVertexCache();
+    TestOverdraw();
+    TestVertexFetch();
+
+    printf("MeshOptimizerTest passed.\n");
+    return 0;
+}
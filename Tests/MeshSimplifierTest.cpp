@@ -0,0 +1,169 @@
+#include "stdafx.h"
+#include "MeshSimplifier.h"
+#include "TestHelper.h"
+
+namespace
+{
+    const UINT kGridSize = 64;
+
+    // A grid with gentle bumps so the collapses have an error, and a UV seam down the middle: the triangles
+    // right of it use copies of the vertices on it with other UVs.
+    void CreateBumpyGrid(FLOAT scale, std::vector<Vertex>& vertices, std::vector<UINT>& indices)
+    {
+        CreateGrid(kGridSize, vertices, indices);
+        for (Vertex& vertex : vertices)
+        {
+            XMFLOAT3& position = vertex.positionOS;
+            position.z = 0.05f * sinf(position.x * 3.0f) * cosf(position.y * 2.0f);
+            position = XMFLOAT3(position.x * scale, position.y * scale, position.z * scale);
+        }
+
+        const UINT seamX = kGridSize / 2;
+        const UINT gridVerticesNum = static_cast<UINT>(vertices.size());
+        for (UINT y = 0; y <= kGridSize; y++)
+        {
+            Vertex vertex = vertices[y * (kGridSize + 1) + seamX];
+            vertex.texCoord.x += 0.5f;
+            vertices.push_back(vertex);
+        }
+        for (UINT i = 0; i < indices.size(); i += 3)
+        {
+            const UINT triangleX = (i / 6) % kGridSize;
+            for (UINT j = 0; j < 3 && triangleX >= seamX; j++)
+            {
+                UINT& index = indices[i + j];
+                if (index < gridVerticesNum && index % (kGridSize + 1) == seamX)
+                {
+                    index = gridVerticesNum + index / (kGridSize + 1);
+                }
+            }
+        }
+    }
+
+    // The vertices on the border of the grid and on the seam.
+    std::vector<BOOL> GetLockedVertices(const std::vector<Vertex>& vertices)
+    {
+        const UINT gridVerticesNum = (kGridSize + 1) * (kGridSize + 1);
+        std::vector<BOOL> isLocked(vertices.size(), TRUE);
+        for (UINT i = 0; i < gridVerticesNum; i++)
+        {
+            const UINT x = i % (kGridSize + 1);
+            const UINT y = i / (kGridSize + 1);
+            isLocked[i] = x == 0 || y == 0 || x == kGridSize || y == kGridSize || x == kGridSize / 2;
+        }
+
+        return isLocked;
+    }
+
+    XMVECTOR GetNormal(const std::vector<Vertex>& vertices, const UINT* pTriangle)
+    {
+        const XMVECTOR p0 = XMLoadFloat3(&vertices[pTriangle[0]].positionOS);
+        const XMVECTOR p1 = XMLoadFloat3(&vertices[pTriangle[1]].positionOS);
+        const XMVECTOR p2 = XMLoadFloat3(&vertices[pTriangle[2]].positionOS);
+        return XMVector3Cross(p1 - p0, p2 - p0);
+    }
+
+    // Simplify each LOD from the one before, as FBXImporter::GenerateLods does, to a ratio of the
+    // triangles of LOD 0.
+    void SimplifyChain(const std::vector<Vertex>& vertices, const std::vector<UINT>& indices,
+        std::vector<std::vector<UINT>>& lods, std::vector<FLOAT>& errors)
+    {
+        const FLOAT ratios[] = MESH_LOD_RATIOS;
+        lods.assign(1, indices);
+        errors.assign(1, 0.0f);
+        for (FLOAT ratio : ratios)
+        {
+            const std::vector<UINT>& previous = lods.back();
+            const UINT targetNum = static_cast<UINT>(indices.size() * ratio) / 3 * 3;
+            std::vector<UINT> result;
+            const FLOAT error = MeshSimplifier::Simplify(vertices.data(), static_cast<UINT>(vertices.size()),
+                previous.data(), static_cast<UINT>(previous.size()), targetNum, result);
+            lods.push_back(result);
+            errors.push_back(error);
+        }
+    }
+
+    void TestChain()
+    {
+        // Every LOD reaches its target, is coarser than the one before with a larger error, and keeps the
+        // border, the seam and the facing of every triangle.
+        std::vector<Vertex> vertices;
+        std::vector<UINT> indices;
+        CreateBumpyGrid(1.0f, vertices, indices);
+        std::vector<std::vector<UINT>> lods;
+        std::vector<FLOAT> errors;
+        SimplifyChain(vertices, indices, lods, errors);
+
+        const FLOAT ratios[] = MESH_LOD_RATIOS;
+        const std::vector<BOOL> isLocked = GetLockedVertices(vertices);
+        for (UINT lod = 1; lod < lods.size(); lod++)
+        {
+            const std::vector<UINT>& result = lods[lod];
+            const UINT targetNum = static_cast<UINT>(indices.size() * ratios[lod - 1]) / 3 * 3;
+            printf("LOD %u: %6u triangles, %5.1f%% of LOD 0, error %.5f\n", lod,
+                static_cast<UINT>(result.size() / 3), 100.0f * result.size() / indices.size(), errors[lod]);
+            CHECK(result.size() % 3 == 0);
+            CHECK(result.size() <= targetNum && result.size() >= targetNum * 9 / 10);
+            CHECK(errors[lod] > 0.0f && errors[lod] >= errors[lod - 1] && errors[lod] < 0.1f);
+
+            std::vector<BOOL> isUsed(vertices.size(), FALSE);
+            for (UINT i = 0; i < result.size(); i += 3)
+            {
+                for (UINT j = 0; j < 3; j++)
+                {
+                    CHECK(result[i + j] < vertices.size());
+                    isUsed[result[i + j]] = TRUE;
+                }
+                CHECK(result[i] != result[i + 1] && result[i + 1] != result[i + 2] && result[i] != result[i + 2]);
+
+                // The grid faces +z and its bumps are gentle, so a triangle that faces down has flipped.
+                const XMVECTOR normal = GetNormal(vertices, &result[i]);
+                CHECK(XMVectorGetZ(normal) > 0.5f * XMVectorGetX(XMVector3Length(normal)));
+            }
+            for (UINT i = 0; i < vertices.size(); i++)
+            {
+                CHECK(!isLocked[i] || isUsed[i]);
+            }
+        }
+    }
+
+    void TestObjectUnits()
+    {
+        // The simplification works in the unit cube of the mesh, so a copy scaled by a power of two, which
+        // has the same unit cube positions to the bit, collapses the same edges, and the error is returned at
+        // the scale of the mesh.
+        std::vector<Vertex> vertices;
+        std::vector<UINT> indices;
+        std::vector<std::vector<UINT>> lods;
+        std::vector<FLOAT> errors;
+        CreateBumpyGrid(1.0f, vertices, indices);
+        SimplifyChain(vertices, indices, lods, errors);
+
+        std::vector<Vertex> scaledVertices;
+        std::vector<std::vector<UINT>> scaledLods;
+        std::vector<FLOAT> scaledErrors;
+        CreateBumpyGrid(8.0f, scaledVertices, indices);
+        SimplifyChain(scaledVertices, indices, scaledLods, scaledErrors);
+
+        for (UINT lod = 1; lod < lods.size(); lod++)
+        {
+            CHECK(scaledLods[lod] == lods[lod]);
+            CHECK(fabsf(scaledErrors[lod] - errors[lod] * 8.0f) <= errors[lod] * 8.0f * 1e-5f);
+        }
+
+        // Nothing to remove gives no error.
+        std::vector<UINT> result;
+        CHECK(MeshSimplifier::Simplify(vertices.data(), static_cast<UINT>(vertices.size()), indices.data(),
+            static_cast<UINT>(indices.size()), static_cast<UINT>(indices.size()), result) == 0.0f);
+        CHECK(result == indices);
+    }
+}
+
+int main()
+{
+    TestChain();
+    TestObjectUnits();
+
+    printf("MeshSimplifierTest passed.\n");
+    return 0;
+}
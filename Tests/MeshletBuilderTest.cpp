@@ -0,0 +1,175 @@
+#include "stdafx.h"
+#include "MeshletBuilder.h"
+#include "TestHelper.h"
+
+namespace
+{
+    // The planes of a box of the given half size around the origin, facing inwards.
+    void GetBoxPlanes(FLOAT halfSize, XMFLOAT4 planes[6])
+    {
+        const XMFLOAT4 boxPlanes[6] =
+        {
+            XMFLOAT4(1.0f, 0.0f, 0.0f, halfSize), XMFLOAT4(-1.0f, 0.0f, 0.0f, halfSize),
+            XMFLOAT4(0.0f, 1.0f, 0.0f, halfSize), XMFLOAT4(0.0f, -1.0f, 0.0f, halfSize),
+            XMFLOAT4(0.0f, 0.0f, 1.0f, halfSize), XMFLOAT4(0.0f, 0.0f, -1.0f, halfSize),
+        };
+        std::copy(boxPlanes, boxPlanes + 6, planes);
+    }
+
+    void BuildMeshlets(MeshData& mesh, const std::vector<Vertex>& vertices, const std::vector<UINT>& indices)
+    {
+        mesh.SetVertices(vertices.data(), static_cast<UINT>(vertices.size() * sizeof(Vertex)));
+        mesh.SetIndices(indices.data(), static_cast<UINT>(indices.size() * sizeof(UINT)));
+        mesh.AddSubmesh({ 0, static_cast<UINT>(indices.size()), 0, static_cast<UINT>(vertices.size()) });
+        const D3D12MeshLod lod = { 0, static_cast<UINT>(indices.size()), 0.0f };
+        mesh.SetLods(&lod, 1);
+        MeshletBuilder::BuildMeshlets(&mesh);
+    }
+
+    BOOL IsVisible(const D3D12Meshlet& meshlet, const XMFLOAT4* pPlanes, FXMVECTOR cameraPosition)
+    {
+        return MeshletBuilder::IsMeshletVisible(pPlanes, XMVectorSetW(XMLoadFloat3(&meshlet.center), 1.0f),
+            meshlet.radius, XMLoadFloat3(&meshlet.coneAxis), meshlet.coneCutoff, cameraPosition);
+    }
+
+    void TestPackTriangle()
+    {
+        for (UINT i = 0; i < 1024; i += 7)
+        {
+            const UINT triangle = MeshletBuilder::PackTriangle(i, 1023 - i, (i * 5) & 1023);
+            CHECK(MeshletBuilder::UnpackTriangleIndex(triangle, 0) == i);
+            CHECK(MeshletBuilder::UnpackTriangleIndex(triangle, 1) == 1023 - i);
+            CHECK(MeshletBuilder::UnpackTriangleIndex(triangle, 2) == ((i * 5) & 1023));
+        }
+    }
+
+    void TestLimitsAndBounds()
+    {
+        // The meshlets of a grid in its own order and in a random one, which fills the vertices first, cover
+        // the index buffer in order, within the limits, and their bounds hold every vertex.
+        for (UINT seed = 0; seed < 2; seed++)
+        {
+            std::vector<Vertex> vertices;
+            std::vector<UINT> indices;
+            CreateGrid(64, vertices, indices);
+            if (seed > 0)
+            {
+                std::mt19937 random(seed);
+                for (Vertex& vertex : vertices)
+                {
+                    vertex.positionOS.z = static_cast<FLOAT>(random() % 1000) / 1000.0f;
+                }
+                std::vector<UINT> triangles(indices.size() / 3);
+                std::iota(triangles.begin(), triangles.end(), 0);
+                std::shuffle(triangles.begin(), triangles.end(), random);
+                std::vector<UINT> shuffled;
+                for (UINT triangle : triangles)
+                {
+                    shuffled.insert(shuffled.end(), indices.begin() + triangle * 3, indices.begin() + triangle * 3 + 3);
+                }
+                indices.swap(shuffled);
+            }
+
+            MeshData mesh;
+            BuildMeshlets(mesh, vertices, indices);
+            const std::vector<D3D12Meshlet>& meshlets = mesh.GetMeshlets();
+            const std::vector<UINT>& meshletVertices = mesh.GetMeshletVertices();
+            const std::vector<UINT>& meshletTriangles = mesh.GetMeshletTriangles();
+            CHECK(!meshlets.empty());
+
+            UINT indexStart = 0;
+            UINT maxVerticesNum = 0;
+            for (const D3D12Meshlet& meshlet : meshlets)
+            {
+                CHECK(meshlet.verticesNum > 0 && meshlet.verticesNum <= MESHLET_MAX_VERTICES);
+                CHECK(meshlet.trianglesNum > 0 && meshlet.trianglesNum <= MESHLET_MAX_TRIANGLES);
+                CHECK(meshlet.vertexOffset + meshlet.verticesNum <= meshletVertices.size());
+                CHECK(meshlet.triangleOffset + meshlet.trianglesNum <= meshletTriangles.size());
+                CHECK(meshlet.indexStart == indexStart);
+                indexStart += meshlet.trianglesNum * 3;
+                maxVerticesNum = max(maxVerticesNum, meshlet.verticesNum);
+
+                for (UINT i = 0; i < meshlet.trianglesNum; i++)
+                {
+                    const UINT triangle = meshletTriangles[meshlet.triangleOffset + i];
+                    for (UINT j = 0; j < 3; j++)
+                    {
+                        const UINT localIndex = MeshletBuilder::UnpackTriangleIndex(triangle, j);
+                        CHECK(localIndex < meshlet.verticesNum);
+                        CHECK(meshletVertices[meshlet.vertexOffset + localIndex] == indices[meshlet.indexStart + i * 3 + j]);
+                    }
+                }
+
+                const FLOAT epsilon = 1e-5f;
+                for (UINT i = 0; i < meshlet.verticesNum; i++)
+                {
+                    const XMFLOAT3& position = vertices[meshletVertices[meshlet.vertexOffset + i]].positionOS;
+                    CHECK(position.x >= meshlet.aabb.MinX && position.x <= meshlet.aabb.MaxX);
+                    CHECK(position.y >= meshlet.aabb.MinY && position.y <= meshlet.aabb.MaxY);
+                    CHECK(position.z >= meshlet.aabb.MinZ && position.z <= meshlet.aabb.MaxZ);
+                    const FLOAT distance = XMVectorGetX(XMVector3Length(XMLoadFloat3(&position) - XMLoadFloat3(&meshlet.center)));
+                    CHECK(distance <= meshlet.radius + epsilon);
+                }
+            }
+            CHECK(indexStart == indices.size());
+            CHECK(seed == 0 || maxVerticesNum > MESHLET_MAX_VERTICES - 3);
+        }
+    }
+
+    void TestCulling()
+    {
+        // The meshlets of a flat patch facing +z have a cone of no spread, so they are culled from behind and
+        // kept from the front, and outside the frustum.
+        std::vector<Vertex> vertices;
+        std::vector<UINT> indices;
+        CreateGrid(32, vertices, indices);
+        MeshData mesh;
+        BuildMeshlets(mesh, vertices, indices);
+
+        XMFLOAT4 planes[6];
+        GetBoxPlanes(100.0f, planes);
+        for (const D3D12Meshlet& meshlet : mesh.GetMeshlets())
+        {
+            CHECK(meshlet.coneCutoff < 1e-3f);
+            CHECK(fabsf(meshlet.coneAxis.z - 1.0f) < 1e-5f);
+            CHECK(IsVisible(meshlet, planes, XMVectorSet(0.0f, 0.0f, 5.0f, 1.0f)));
+            CHECK(IsVisible(meshlet, planes, XMVectorSet(30.0f, 0.0f, 1.0f, 1.0f)));
+            CHECK(!IsVisible(meshlet, planes, XMVectorSet(0.0f, 0.0f, -5.0f, 1.0f)));
+            CHECK(!IsVisible(meshlet, planes, XMVectorSet(30.0f, 10.0f, -3.0f, 1.0f)));
+        }
+
+        // A box that ends before the patch culls all of it, from any side.
+        GetBoxPlanes(100.0f, planes);
+        planes[0].w = -2.0f;
+        for (const D3D12Meshlet& meshlet : mesh.GetMeshlets())
+        {
+            CHECK(!IsVisible(meshlet, planes, XMVectorSet(0.0f, 0.0f, 5.0f, 1.0f)));
+        }
+
+        // Folding the patch into a half tube spreads the normals of each meshlet, which spans the width of
+        // the patch, over half a circle, so none of them is culled from behind.
+        for (Vertex& vertex : vertices)
+        {
+            const FLOAT angle = vertex.positionOS.x * XM_PI * 0.5f;
+            vertex.positionOS = XMFLOAT3(sinf(angle), vertex.positionOS.y, cosf(angle));
+        }
+        MeshData tube;
+        BuildMeshlets(tube, vertices, indices);
+        GetBoxPlanes(100.0f, planes);
+        for (const D3D12Meshlet& meshlet : tube.GetMeshlets())
+        {
+            CHECK(meshlet.coneCutoff > 0.9f);
+            CHECK(IsVisible(meshlet, planes, XMVectorSet(0.0f, 0.0f, -5.0f, 1.0f)));
+        }
+    }
+}
+
+int main()
+{
+    TestPackTriangle();
+    TestLimitsAndBounds();
+    TestCulling();
+
+    printf("MeshletBuilderTest passed.\n");
+    return 0;
+}
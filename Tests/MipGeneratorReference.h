@@ -0,0 +1,95 @@
+#pragma once
+#include <cmath>
+#include "MipGenerator.h"
+
+// The 2x2 box filter of MipGenerator computed per pixel in double precision, to check the vectorized
+// filters against and to time them against.
+namespace MipGeneratorReference
+{
+    inline double ToLinear(double value)
+    {
+        value /= 255.0;
+        return value <= 0.04045 ? value / 12.92 : pow((value + 0.055) / 1.055, 2.4);
+    }
+
+    inline double ToSRGB(double value)
+    {
+        return value <= 0.0031308 ? value * 12.92 : 1.055 * pow(value, 1.0 / 2.4) - 0.055;
+    }
+
+    // Filter the level below a tightly packed sourceWidth x sourceHeight level.
+    inline void FilterLevel(const BYTE* pSource, UINT sourceWidth, UINT sourceHeight, BYTE* pDestination,
+        MipFilterMode mode)
+    {
+        const UINT width = max(sourceWidth >> 1, 1u);
+        const UINT height = max(sourceHeight >> 1, 1u);
+        for (UINT y = 0; y < height; y++)
+        {
+            for (UINT x = 0; x < width; x++)
+            {
+                // Odd sizes repeat their last row and column.
+                const UINT rows[2] = { min(2 * y, sourceHeight - 1), min(2 * y + 1, sourceHeight - 1) };
+                const UINT columns[2] = { min(2 * x, sourceWidth - 1), min(2 * x + 1, sourceWidth - 1) };
+                const BYTE* pPixels[4];
+                for (UINT i = 0; i < 4; i++)
+                {
+                    pPixels[i] = pSource + (static_cast<UINT64>(rows[i >> 1]) * sourceWidth + columns[i & 1]) * 4;
+                }
+
+                BYTE* pPixel = pDestination + (static_cast<UINT64>(y) * width + x) * 4;
+                const UINT alpha = pPixels[0][3] + pPixels[1][3] + pPixels[2][3] + pPixels[3][3];
+                if (mode == MipFilterMode::Linear)
+                {
+                    for (UINT c = 0; c < 4; c++)
+                    {
+                        pPixel[c] = static_cast<BYTE>((pPixels[0][c] + pPixels[1][c] + pPixels[2][c] + pPixels[3][c] + 2) / 4);
+                    }
+                }
+                else if (mode == MipFilterMode::Color)
+                {
+                    for (UINT c = 0; c < 3; c++)
+                    {
+                        double sum = 0.0;
+                        for (UINT i = 0; i < 4; i++)
+                        {
+                            sum += ToLinear(pPixels[i][c]);
+                        }
+                        pPixel[c] = static_cast<BYTE>(lround(ToSRGB(sum / 4.0) * 255.0));
+                    }
+                    pPixel[3] = static_cast<BYTE>(nearbyint(alpha / 4.0));
+                }
+                else
+                {
+                    double normal[3] = {};
+                    for (UINT c = 0; c < 3; c++)
+                    {
+                        for (UINT i = 0; i < 4; i++)
+                        {
+                            normal[c] += pPixels[i][c];
+                        }
+                        normal[c] = normal[c] / 510.0 - 1.0;
+                    }
+                    const double length = sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+                    if (length > 1e-4)
+                    {
+                        for (UINT c = 0; c < 3; c++)
+                        {
+                            normal[c] /= length;
+                        }
+                    }
+                    else
+                    {
+                        normal[0] = 0.0;
+                        normal[1] = 0.0;
+                        normal[2] = 1.0;
+                    }
+                    for (UINT c = 0; c < 3; c++)
+                    {
+                        pPixel[c] = static_cast<BYTE>(nearbyint(normal[c] * 127.5 + 127.5));
+                    }
+                    pPixel[3] = static_cast<BYTE>(nearbyint(alpha / 4.0));
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,151 @@
+#include "stdafx.h"
+#include "MipGenerator.h"
+#include "MipGeneratorReference.h"
+#include "TestHelper.h"
+
+namespace
+{
+    // Chains of random images, with levels tightly packed or rows padded to rowPitchPadding more bytes.
+    struct MipChains
+    {
+        std::vector<std::vector<BYTE>> levels;
+        std::vector<BYTE*> pLevels;
+        std::vector<UINT64> rowPitches;
+    };
+
+    void CreateChains(UINT width, UINT height, UINT chainsNum, UINT rowPitchPadding, std::mt19937& random,
+        MipChains& chains)
+    {
+        const UINT levelsNum = MipGenerator::GetMipLevelsNum(width, height);
+        chains.levels.assign(chainsNum * levelsNum, std::vector<BYTE>());
+        chains.pLevels.resize(chainsNum * levelsNum);
+        chains.rowPitches.resize(levelsNum);
+        for (UINT level = 0; level < levelsNum; level++)
+        {
+            chains.rowPitches[level] = max(width >> level, 1u) * 4 + rowPitchPadding;
+        }
+        for (UINT chain = 0; chain < chainsNum; chain++)
+        {
+            for (UINT level = 0; level < levelsNum; level++)
+            {
+                std::vector<BYTE>& data = chains.levels[chain * levelsNum + level];
+                data.resize(chains.rowPitches[level] * max(height >> level, 1u));
+                if (level == 0)
+                {
+                    for (BYTE& value : data)
+                    {
+                        value = static_cast<BYTE>(random());
+                    }
+                }
+                chains.pLevels[chain * levelsNum + level] = data.data();
+            }
+        }
+    }
+
+    // The largest difference of a channel between the levels generated and the reference filter applied
+    // to the level above each of them.
+    INT GetMaxDifference(const MipChains& chains, UINT width, UINT height, UINT chainsNum, MipFilterMode mode)
+    {
+        const UINT levelsNum = MipGenerator::GetMipLevelsNum(width, height);
+        INT maxDifference = 0;
+        for (UINT chain = 0; chain < chainsNum; chain++)
+        {
+            for (UINT level = 1; level < levelsNum; level++)
+            {
+                const UINT sourceWidth = max(width >> (level - 1), 1u);
+                const UINT sourceHeight = max(height >> (level - 1), 1u);
+                const UINT levelWidth = max(width >> level, 1u);
+                const UINT levelHeight = max(height >> level, 1u);
+
+                std::vector<BYTE> source(static_cast<UINT64>(sourceWidth) * sourceHeight * 4);
+                for (UINT y = 0; y < sourceHeight; y++)
+                {
+                    memcpy(source.data() + static_cast<UINT64>(y) * sourceWidth * 4,
+                        chains.pLevels[chain * levelsNum + level - 1] + y * chains.rowPitches[level - 1], sourceWidth * 4);
+                }
+                std::vector<BYTE> expected(static_cast<UINT64>(levelWidth) * levelHeight * 4);
+                MipGeneratorReference::FilterLevel(source.data(), sourceWidth, sourceHeight, expected.data(), mode);
+
+                for (UINT y = 0; y < levelHeight; y++)
+                {
+                    const BYTE* pRow = chains.pLevels[chain * levelsNum + level] + y * chains.rowPitches[level];
+                    for (UINT x = 0; x < levelWidth * 4; x++)
+                    {
+                        maxDifference = max(maxDifference, abs(pRow[x] - expected[y * levelWidth * 4 + x]));
+                    }
+                }
+            }
+        }
+
+        return maxDifference;
+    }
+
+    void TestLevels()
+    {
+        CHECK(MipGenerator::GetMipLevelsNum(1, 1) == 1);
+        CHECK(MipGenerator::GetMipLevelsNum(37, 13) == 6);
+        CHECK(MipGenerator::GetMipLevelsNum(1024, 256) == 11);
+        CHECK(MipGenerator::GetLevelSize(37, 13, 0) == 37 * 13 * 4);
+        CHECK(MipGenerator::GetLevelSize(37, 13, 2) == 9 * 3 * 4);
+        CHECK(MipGenerator::GetLevelSize(37, 13, 5) == 4);
+    }
+
+    void TestFilters()
+    {
+        // Odd, thin and single pixel sizes, and rows shorter and longer than the vectors.
+        const UINT sizes[][2] = { { 37, 13 }, { 1, 9 }, { 9, 1 }, { 64, 64 }, { 5, 5 }, { 2, 1 }, { 130, 66 } };
+        const MipFilterMode modes[] = { MipFilterMode::Color, MipFilterMode::Linear, MipFilterMode::Normal };
+        std::mt19937 random(1);
+        for (const UINT* size : sizes)
+        {
+            for (MipFilterMode mode : modes)
+            {
+                // Color and normals round once in a while where the reference lands on a half.
+                const INT tolerance = mode == MipFilterMode::Linear ? 0 : 1;
+                const UINT levelsNum = MipGenerator::GetMipLevelsNum(size[0], size[1]);
+
+                MipChains chains;
+                CreateChains(size[0], size[1], 4, 0, random, chains);
+                MipGenerator::Generate(chains.pLevels.data(), 4, levelsNum, size[0], size[1], mode, nullptr, 3);
+                CHECK(GetMaxDifference(chains, size[0], size[1], 4, mode) <= tolerance);
+
+                // Padded rows give the same pixels.
+                MipChains paddedChains;
+                CreateChains(size[0], size[1], 1, 12, random, paddedChains);
+                MipGenerator::Generate(paddedChains.pLevels.data(), 1, levelsNum, size[0], size[1], mode,
+                    paddedChains.rowPitches.data(), 1);
+                CHECK(GetMaxDifference(paddedChains, size[0], size[1], 1, mode) <= tolerance);
+            }
+        }
+    }
+
+    void TestThreads()
+    {
+        // The rows split over the threads differently, the levels come out the same.
+        const UINT width = 200;
+        const UINT height = 120;
+        const UINT levelsNum = MipGenerator::GetMipLevelsNum(width, height);
+        std::mt19937 random(2);
+        MipChains chains;
+        CreateChains(width, height, 6, 0, random, chains);
+        MipChains singleChains = chains;
+        for (UINT i = 0; i < singleChains.pLevels.size(); i++)
+        {
+            singleChains.pLevels[i] = singleChains.levels[i].data();
+        }
+
+        MipGenerator::Generate(chains.pLevels.data(), 6, levelsNum, width, height, MipFilterMode::Color, nullptr, 8);
+        MipGenerator::Generate(singleChains.pLevels.data(), 6, levelsNum, width, height, MipFilterMode::Color, nullptr, 1);
+        CHECK(chains.levels == singleChains.levels);
+    }
+}
+
+int main()
+{
+    TestLevels();
+    TestFilters();
+    TestThreads();
+
+    printf("MipGeneratorTest passed.\n");
+    return 0;
+}
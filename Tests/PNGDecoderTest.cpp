@@ -0,0 +1,186 @@
+#include "stdafx.h"
+#include "PNGDecoder.h"
+#include "MappedFile.h"
+#include "TestHelper.h"
+
+namespace
+{
+    typedef void (*GetPixelFunction)(UINT x, UINT y, BYTE pixel[4]);
+
+    // The images in Tests/Data, written with every filter type in turn by row. The RGBA ones split their
+    // stream over IDAT chunks of 100 bytes and use fixed Huffman codes, the color key one stored blocks.
+    void GetRGBAPixel(UINT x, UINT y, BYTE pixel[4])
+    {
+        pixel[0] = static_cast<BYTE>(x * 7 + y * 3);
+        pixel[1] = static_cast<BYTE>(x * x + y);
+        pixel[2] = static_cast<BYTE>((y * 11) ^ x);
+        pixel[3] = static_cast<BYTE>(x + y * 5);
+    }
+
+    // RGB with the color key (10, 20, 30) on every fourth diagonal.
+    void GetColorKeyPixel(UINT x, UINT y, BYTE pixel[4])
+    {
+        GetRGBAPixel(x, y, pixel);
+        if ((x + y) % 4 == 0)
+        {
+            pixel[0] = 10;
+            pixel[1] = 20;
+            pixel[2] = 30;
+            pixel[3] = 0;
+        }
+        else
+        {
+            pixel[3] = 255;
+        }
+    }
+
+    void GetGray16Pixel(UINT x, UINT y, BYTE pixel[4])
+    {
+        pixel[0] = pixel[1] = pixel[2] = static_cast<BYTE>(((x * 3000 + y * 1000) & 0xFFFF) >> 8);
+        pixel[3] = 255;
+    }
+
+    // 16 entries of 4 bits, the first 8 with the alpha of the tRNS chunk.
+    void GetPalettePixel(UINT x, UINT y, BYTE pixel[4])
+    {
+        const UINT index = (x + y * 3) % 16;
+        pixel[0] = static_cast<BYTE>(index * 16);
+        pixel[1] = static_cast<BYTE>(255 - index * 16);
+        pixel[2] = static_cast<BYTE>(index * 5);
+        pixel[3] = static_cast<BYTE>(index < 8 ? index * 30 : 255);
+    }
+
+    void GetGray2Pixel(UINT x, UINT y, BYTE pixel[4])
+    {
+        pixel[0] = pixel[1] = pixel[2] = static_cast<BYTE>((x + y) % 4 * 85);
+        pixel[3] = 255;
+    }
+
+    void GetGrayAlphaPixel(UINT x, UINT y, BYTE pixel[4])
+    {
+        pixel[0] = pixel[1] = pixel[2] = static_cast<BYTE>(x * 28);
+        pixel[3] = static_cast<BYTE>(y * 28);
+    }
+
+    struct TestImage
+    {
+        LPCWSTR name;
+        UINT width;
+        UINT height;
+        GetPixelFunction getPixel;
+    };
+
+    const TestImage kTestImages[] =
+    {
+        { L"rgba8.png", 37, 23, GetRGBAPixel },
+        { L"rgba8_adam7.png", 37, 23, GetRGBAPixel },
+        { L"rgb8_key.png", 19, 17, GetColorKeyPixel },
+        { L"gray16.png", 21, 13, GetGray16Pixel },
+        { L"palette4_adam7.png", 13, 11, GetPalettePixel },
+        { L"gray2.png", 11, 7, GetGray2Pixel },
+        { L"grayalpha8.png", 9, 9, GetGrayAlphaPixel },
+    };
+
+    // Rows with room after the pixels, which the decoder must leave alone.
+    const UINT kRowPadding = 12;
+    const BYTE kPaddingByte = 0xCD;
+
+    void TestImages()
+    {
+        for (const TestImage& testImage : kTestImages)
+        {
+            MappedFile file;
+            CHECK(file.Open(TEST_DATA_PATH + std::wstring(testImage.name)));
+            const ImageDecoder* pDecoder = ImageDecoder::GetDecoder(file.GetData(), file.GetSize());
+            CHECK(pDecoder != nullptr);
+
+            ImageInfo info = {};
+            CHECK(pDecoder->ReadInfo(file.GetData(), file.GetSize(), info));
+            CHECK(info.width == testImage.width && info.height == testImage.height);
+
+            const UINT64 rowPitch = info.width * 4 + kRowPadding;
+            std::vector<BYTE> pixels(static_cast<size_t>(rowPitch * info.height), kPaddingByte);
+            CHECK(pDecoder->Decode(file.GetData(), file.GetSize(), pixels.data(), rowPitch));
+            for (UINT y = 0; y < info.height; y++)
+            {
+                const BYTE* pRow = pixels.data() + y * rowPitch;
+                for (UINT x = 0; x < info.width; x++)
+                {
+                    BYTE expected[4];
+                    testImage.getPixel(x, y, expected);
+                    CHECK(memcmp(pRow + x * 4, expected, 4) == 0);
+                }
+                for (UINT i = info.width * 4; i < rowPitch; i++)
+                {
+                    CHECK(pRow[i] == kPaddingByte);
+                }
+            }
+        }
+    }
+
+    void TestCorruptImages()
+    {
+        // A stream cut short and a header that is not a PNG one are rejected rather than read past.
+        MappedFile file;
+        CHECK(file.Open(TEST_DATA_PATH + std::wstring(L"rgba8.png")));
+        const PNGDecoder decoder;
+        std::vector<BYTE> pixels(37 * 23 * 4);
+        for (UINT64 size = 0; size < file.GetSize() - 12; size += 37)
+        {
+            CHECK(!decoder.Decode(file.GetData(), size, pixels.data(), 37 * 4));
+        }
+
+        std::vector<BYTE> data(file.GetData(), file.GetData() + file.GetSize());
+        data[1] = 'J';
+        CHECK(!decoder.CanDecode(data.data(), data.size()));
+        CHECK(ImageDecoder::GetDecoder(data.data(), data.size()) == nullptr);
+    }
+
+    void TestDecodeAll()
+    {
+        // The test images and a texture of the sample scene decoded on many threads at once, as the texture
+        // loader does, give the same pixels as decoding them one by one.
+        std::vector<std::wstring> paths;
+        for (const TestImage& testImage : kTestImages)
+        {
+            paths.push_back(TEST_DATA_PATH + std::wstring(testImage.name));
+        }
+        paths.push_back(GetAssetPath(L"test.png"));
+
+        std::vector<MappedFile> files(paths.size());
+        std::vector<std::vector<BYTE>> pixels(paths.size());
+        std::vector<std::vector<BYTE>> expectedPixels(paths.size());
+        std::vector<ImageDecodeJob> jobs;
+        for (UINT i = 0; i < paths.size(); i++)
+        {
+            CHECK(files[i].Open(paths[i]));
+            const ImageDecoder* pDecoder = ImageDecoder::GetDecoder(files[i].GetData(), files[i].GetSize());
+            ImageInfo info = {};
+            CHECK(pDecoder != nullptr && pDecoder->ReadInfo(files[i].GetData(), files[i].GetSize(), info));
+            pixels[i].resize(static_cast<size_t>(info.width) * info.height * 4);
+            expectedPixels[i].resize(pixels[i].size());
+            CHECK(pDecoder->Decode(files[i].GetData(), files[i].GetSize(), expectedPixels[i].data(), info.width * 4));
+            jobs.push_back({ files[i].GetData(), files[i].GetSize(), pixels[i].data(), info.width * 4 });
+        }
+
+        CHECK(ImageDecoder::DecodeAll(jobs.data(), static_cast<UINT>(jobs.size()), 3));
+        for (UINT i = 0; i < paths.size(); i++)
+        {
+            CHECK(pixels[i] == expectedPixels[i]);
+        }
+
+        // One corrupt image fails the batch.
+        jobs[0].size /= 2;
+        CHECK(!ImageDecoder::DecodeAll(jobs.data(), static_cast<UINT>(jobs.size()), 3));
+    }
+}
+
+int main()
+{
+    TestImages();
+    TestCorruptImages();
+    TestDecodeAll();
+
+    printf("PNGDecoderTest passed.\n");
+    return 0;
+}
@@ -0,0 +1,281 @@
+#include "stdafx.h"
+#include "RenderGraph.h"
+#include "TestHelper.h"
+
+namespace
+{
+    // The resources of a deferred frame, in the order they are declared: the targets ViewManager imports, then
+    // the transient G-buffer, the copy of the lighting and the TAA target.
+    enum FrameResource
+    {
+        DEPTH,
+        UAV_COLOR,
+        HISTORY,
+        BACK_BUFFER,
+        GBUFFER0,
+        GBUFFER1,
+        GBUFFER2,
+        GBUFFER3,
+        COLOR,
+        TAA,
+        FRAME_RESOURCES_NUM
+    };
+
+    const char* kResourceNames[FRAME_RESOURCES_NUM] =
+        { "depth", "uav", "history", "back", "gb0", "gb1", "gb2", "gb3", "color", "taa" };
+    const UINT64 kTargetSize = 1920 * 1080 * 8;
+    const UINT64 kTargetAlignment = 64 << 10;
+
+    std::string GetStateName(D3D12_RESOURCE_STATES state)
+    {
+        const D3D12_RESOURCE_STATES shaderResource =
+            D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+        const D3D12_RESOURCE_STATES copiedShaderResource =
+            D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_COPY_SOURCE;
+        const std::pair<D3D12_RESOURCE_STATES, const char*> names[] =
+        {
+            { D3D12_RESOURCE_STATE_COMMON, "COMMON" },
+            { D3D12_RESOURCE_STATE_RENDER_TARGET, "RT" },
+            { D3D12_RESOURCE_STATE_UNORDERED_ACCESS, "UA" },
+            { D3D12_RESOURCE_STATE_DEPTH_WRITE, "DW" },
+            { D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, "NPSR" },
+            { D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, "PSR" },
+            { shaderResource, "SR" },
+            { copiedShaderResource, "PSR|CS" },
+            { D3D12_RESOURCE_STATE_COPY_DEST, "CD" },
+            { D3D12_RESOURCE_STATE_COPY_SOURCE, "CS" },
+        };
+        for (const auto& name : names)
+        {
+            if (name.first == state)
+            {
+                return name.second;
+            }
+        }
+
+        return std::to_string(static_cast<UINT>(state));
+    }
+
+    // The barriers as "type:resource:before>after" separated by spaces, T for a transition, B for the
+    // beginning of a split one, A for aliasing and U for unordered access.
+    std::string Dump(const std::vector<RenderGraphBarrier>& barriers)
+    {
+        const char* typeNames[] = { "T", "B", "A", "U" };
+        std::string dump;
+        for (const RenderGraphBarrier& barrier : barriers)
+        {
+            if (!dump.empty())
+            {
+                dump += " ";
+            }
+            dump += std::string(typeNames[static_cast<UINT>(barrier.type)]) + ":" + kResourceNames[barrier.resource] +
+                ":" + GetStateName(barrier.stateBefore) + ">" + GetStateName(barrier.stateAfter);
+        }
+
+        return dump;
+    }
+
+    void CheckGolden(const std::string& dump, const char* golden)
+    {
+        if (dump != golden)
+        {
+            fprintf(stderr, "expected: %s\nactual:   %s\n", golden, dump.c_str());
+        }
+        CHECK(dump == golden);
+    }
+
+    // The G-buffer, the lighting into the UAV, the copy out of it, TAA, the history copy and the blit to the
+    // back buffer. Ray tracing adds a pass that writes the UAV first and one that reads the depth after the
+    // lighting.
+    void DeclareFrame(RenderGraph& graph, BOOL isRayTracing)
+    {
+        graph.Reset();
+        CHECK(graph.ImportResource(D3D12_RESOURCE_STATE_DEPTH_WRITE) == DEPTH);
+        CHECK(graph.ImportResource(D3D12_RESOURCE_STATE_UNORDERED_ACCESS) == UAV_COLOR);
+        CHECK(graph.ImportResource(D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE) == HISTORY);
+        CHECK(graph.ImportResource(D3D12_RESOURCE_STATE_PRESENT) == BACK_BUFFER);
+        for (UINT i = GBUFFER0; i < FRAME_RESOURCES_NUM; i++)
+        {
+            CHECK(graph.CreateTransientResource(kTargetSize, kTargetAlignment) == i);
+        }
+
+        if (isRayTracing)
+        {
+            const UINT rayTracing = graph.AddPass(TRUE);
+            graph.Write(rayTracing, UAV_COLOR, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+        }
+
+        const UINT gBuffer = graph.AddPass();
+        for (UINT i = GBUFFER0; i <= GBUFFER3; i++)
+        {
+            graph.Write(gBuffer, i, D3D12_RESOURCE_STATE_RENDER_TARGET);
+        }
+        graph.Write(gBuffer, DEPTH, D3D12_RESOURCE_STATE_DEPTH_WRITE);
+
+        const UINT lighting = graph.AddPass();
+        for (UINT i = GBUFFER0; i <= GBUFFER3; i++)
+        {
+            graph.Read(lighting, i, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+        }
+        graph.Write(lighting, UAV_COLOR, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+
+        if (isRayTracing)
+        {
+            const UINT composite = graph.AddPass();
+            graph.Read(composite, DEPTH, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+            graph.Read(composite, UAV_COLOR, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+            graph.Write(composite, UAV_COLOR, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+        }
+
+        const UINT copy = graph.AddPass();
+        graph.Read(copy, UAV_COLOR, D3D12_RESOURCE_STATE_COPY_SOURCE);
+        graph.Write(copy, COLOR, D3D12_RESOURCE_STATE_COPY_DEST);
+
+        const UINT taa = graph.AddPass();
+        graph.Read(taa, COLOR, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+        graph.Read(taa, HISTORY, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+        graph.Read(taa, DEPTH, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+        graph.Write(taa, TAA, D3D12_RESOURCE_STATE_RENDER_TARGET);
+
+        const UINT history = graph.AddPass();
+        graph.Read(history, TAA, D3D12_RESOURCE_STATE_COPY_SOURCE);
+        graph.Write(history, HISTORY, D3D12_RESOURCE_STATE_COPY_DEST);
+
+        const UINT blit = graph.AddPass();
+        graph.Read(blit, TAA, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+        graph.Write(blit, BACK_BUFFER, D3D12_RESOURCE_STATE_RENDER_TARGET);
+    }
+
+    void CheckFrame(BOOL isRayTracing, const std::vector<const char*>& goldenBarriers, const char* goldenFinalBarriers)
+    {
+        RenderGraph graph;
+        DeclareFrame(graph, isRayTracing);
+        CHECK(graph.Compile());
+
+        // Every pass is kept, in the order it is declared.
+        const std::vector<UINT>& order = graph.GetOrder();
+        CHECK(order.size() == goldenBarriers.size());
+        for (UINT i = 0; i < order.size(); i++)
+        {
+            CHECK(order[i] == i && !graph.IsCulled(i));
+            CheckGolden(Dump(graph.GetBarriers(i)), goldenBarriers[i]);
+        }
+        CheckGolden(Dump(graph.GetFinalBarriers()), goldenFinalBarriers);
+
+        // The four G-buffer targets are alive together, then the copy of the lighting and the TAA target take
+        // the memory of the first two of them.
+        const UINT64 slotSize = Align(kTargetSize, kTargetAlignment);
+        const UINT64 goldenOffsets[FRAME_RESOURCES_NUM] =
+            { 0, 0, 0, 0, 0, slotSize, slotSize * 2, slotSize * 3, 0, slotSize };
+        std::vector<UINT64> offsets(graph.GetResourcesNum());
+        for (UINT i = 0; i < graph.GetResourcesNum(); i++)
+        {
+            offsets[i] = graph.GetOffset(i);
+            CHECK(offsets[i] == goldenOffsets[i] || !graph.IsTransient(i));
+        }
+        CHECK(graph.GetTransientSize() == kTargetSize * 6);
+        CHECK(graph.GetAliasedSize() == slotSize * 3 + kTargetSize);
+        CHECK(graph.IsAliasingValid(offsets.data()));
+
+        // Placing every target at the start of the memory overlaps targets that are alive together.
+        std::vector<UINT64> overlappingOffsets(offsets.size(), 0);
+        CHECK(!graph.IsAliasingValid(overlappingOffsets.data()));
+    }
+
+    void TestRayTracingFrame()
+    {
+        CheckFrame(TRUE,
+            {
+                "B:back:COMMON>RT",
+                "A:gb0:NPSR>RT T:gb0:NPSR>RT A:gb1:NPSR>RT T:gb1:NPSR>RT "
+                    "A:gb2:NPSR>RT T:gb2:NPSR>RT A:gb3:NPSR>RT T:gb3:NPSR>RT",
+                "B:depth:DW>SR U:uav:UA>UA T:gb0:RT>NPSR T:gb1:RT>NPSR T:gb2:RT>NPSR T:gb3:RT>NPSR",
+                "T:depth:DW>SR U:uav:UA>UA",
+                "T:uav:UA>CS A:color:PSR>CD T:color:PSR>CD",
+                "B:uav:CS>UA T:color:CD>PSR A:taa:PSR|CS>RT T:taa:PSR|CS>RT",
+                "B:depth:SR>DW T:history:PSR>CD T:taa:RT>PSR|CS",
+                "B:history:CD>PSR T:back:COMMON>RT",
+            },
+            "T:depth:SR>DW T:uav:CS>UA T:history:CD>PSR T:back:RT>COMMON");
+    }
+
+    void TestRasterFrame()
+    {
+        CheckFrame(FALSE,
+            {
+                "B:back:COMMON>RT A:gb0:NPSR>RT T:gb0:NPSR>RT A:gb1:NPSR>RT T:gb1:NPSR>RT "
+                    "A:gb2:NPSR>RT T:gb2:NPSR>RT A:gb3:NPSR>RT T:gb3:NPSR>RT",
+                "B:depth:DW>PSR T:gb0:RT>NPSR T:gb1:RT>NPSR T:gb2:RT>NPSR T:gb3:RT>NPSR",
+                "T:uav:UA>CS A:color:PSR>CD T:color:PSR>CD",
+                "T:depth:DW>PSR B:uav:CS>UA T:color:CD>PSR A:taa:PSR|CS>RT T:taa:PSR|CS>RT",
+                "B:depth:PSR>DW T:history:PSR>CD T:taa:RT>PSR|CS",
+                "B:history:CD>PSR T:back:COMMON>RT",
+            },
+            "T:depth:PSR>DW T:uav:CS>UA T:history:CD>PSR T:back:RT>COMMON");
+    }
+
+    void TestCulling()
+    {
+        // A pass whose output nothing reads is dropped, and so is the pass that only feeds it.
+        RenderGraph graph;
+        const UINT first = graph.CreateTransientResource(16, 16);
+        const UINT second = graph.CreateTransientResource(16, 16);
+        const UINT backBuffer = graph.ImportResource(D3D12_RESOURCE_STATE_PRESENT);
+        const UINT producer = graph.AddPass();
+        graph.Write(producer, first, D3D12_RESOURCE_STATE_RENDER_TARGET);
+        const UINT consumer = graph.AddPass();
+        graph.Read(consumer, first, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+        graph.Write(consumer, second, D3D12_RESOURCE_STATE_RENDER_TARGET);
+        const UINT present = graph.AddPass();
+        graph.Write(present, backBuffer, D3D12_RESOURCE_STATE_RENDER_TARGET);
+
+        CHECK(graph.Compile());
+        CHECK(graph.IsCulled(producer) && graph.IsCulled(consumer) && !graph.IsCulled(present));
+        CHECK(graph.GetOrder().size() == 1 && graph.GetOrder()[0] == present);
+        CHECK(graph.GetTransientSize() == 0 && graph.GetAliasedSize() == 0);
+    }
+
+    void TestInvalidGraphs()
+    {
+        // Reading a transient resource nothing wrote.
+        RenderGraph graph;
+        const UINT transient = graph.CreateTransientResource(16, 16);
+        UINT pass = graph.AddPass(TRUE);
+        graph.Read(pass, transient, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+        CHECK(!graph.Compile());
+
+        // Writing in a read-only state.
+        graph.Reset();
+        const UINT imported = graph.ImportResource(D3D12_RESOURCE_STATE_COMMON);
+        pass = graph.AddPass();
+        graph.Write(pass, imported, D3D12_RESOURCE_STATE_COPY_SOURCE);
+        CHECK(!graph.Compile());
+    }
+
+    void TestMergedReads()
+    {
+        // Reads in a row merge into one transition to a state that covers all of them.
+        RenderGraph graph;
+        CHECK(graph.ImportResource(D3D12_RESOURCE_STATE_COMMON) == DEPTH);
+        const UINT first = graph.AddPass(TRUE);
+        graph.Read(first, DEPTH, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+        const UINT second = graph.AddPass(TRUE);
+        graph.Read(second, DEPTH, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+        CHECK(graph.Compile());
+        CheckGolden(Dump(graph.GetBarriers(first)), "T:depth:COMMON>SR");
+        CheckGolden(Dump(graph.GetBarriers(second)), "");
+        CheckGolden(Dump(graph.GetFinalBarriers()), "T:depth:SR>COMMON");
+    }
+}
+
+int main()
+{
+    TestRayTracingFrame();
+    TestRasterFrame();
+    TestCulling();
+    TestInvalidGraphs();
+    TestMergedReads();
+
+    printf("RenderGraphTest passed.\n");
+    return 0;
+}
@@ -0,0 +1,330 @@
+#include "stdafx.h"
+#include "ResourceStateTracker.h"
+#include "TestHelper.h"
+#include <map>
+
+namespace
+{
+    // The states the barriers handed out leave each subresource of a resource in, as the GPU would see them,
+    // with the split transitions begun and not ended yet.
+    struct SimulatedResource
+    {
+        std::vector<D3D12_RESOURCE_STATES> states;
+        std::vector<BOOL> isSplit;
+        std::vector<D3D12_RESOURCE_STATES> splitStates;
+        // The states requested last, and whether they are needed by the work of the next batch.
+        std::vector<D3D12_RESOURCE_STATES> requestedStates;
+        BOOL isNeeded;
+    };
+
+    BOOL IsBarrier(const D3D12_RESOURCE_BARRIER& barrier, ID3D12Resource* pResource, UINT subresource,
+        D3D12_RESOURCE_STATES before, D3D12_RESOURCE_STATES after, D3D12_RESOURCE_BARRIER_FLAGS flags)
+    {
+        return barrier.Type == D3D12_RESOURCE_BARRIER_TYPE_TRANSITION && barrier.Flags == flags
+            && barrier.Transition.pResource == pResource && barrier.Transition.Subresource == subresource
+            && barrier.Transition.StateBefore == before && barrier.Transition.StateAfter == after;
+    }
+
+    // Apply barriers to the simulated resources, checking each starts from the state the subresource is in.
+    void Apply(const std::vector<D3D12_RESOURCE_BARRIER>& barriers, std::map<ID3D12Resource*, SimulatedResource>& resources)
+    {
+        for (const D3D12_RESOURCE_BARRIER& barrier : barriers)
+        {
+            CHECK(barrier.Transition.StateBefore != barrier.Transition.StateAfter);
+            SimulatedResource& resource = resources.at(barrier.Transition.pResource);
+            UINT first = 0;
+            UINT end = static_cast<UINT>(resource.states.size());
+            if (barrier.Transition.Subresource != D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES)
+            {
+                CHECK(barrier.Transition.Subresource < end);
+                first = barrier.Transition.Subresource;
+                end = first + 1;
+            }
+
+            for (UINT i = first; i < end; i++)
+            {
+                if (barrier.Flags == D3D12_RESOURCE_BARRIER_FLAG_END_ONLY)
+                {
+                    CHECK(resource.isSplit[i] && resource.states[i] == barrier.Transition.StateBefore);
+                    CHECK(resource.splitStates[i] == barrier.Transition.StateAfter);
+                    resource.isSplit[i] = FALSE;
+                    resource.states[i] = barrier.Transition.StateAfter;
+                    continue;
+                }
+
+                CHECK(!resource.isSplit[i] && resource.states[i] == barrier.Transition.StateBefore);
+                if (barrier.Flags == D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY)
+                {
+                    resource.isSplit[i] = TRUE;
+                    resource.splitStates[i] = barrier.Transition.StateAfter;
+                }
+                else
+                {
+                    resource.states[i] = barrier.Transition.StateAfter;
+                }
+            }
+        }
+    }
+
+    // After a batch, the resources its work needs are in the states requested for them. The ones begun
+    // with a split are on their way there, and all of them are there once the command list is finished.
+    void CheckRequestedStates(SimulatedResource& resource, BOOL isFinished)
+    {
+        for (UINT i = 0; i < resource.states.size(); i++)
+        {
+            if (resource.isNeeded || isFinished)
+            {
+                CHECK(!resource.isSplit[i] && resource.states[i] == resource.requestedStates[i]);
+            }
+            else if (resource.isSplit[i])
+            {
+                CHECK(resource.splitStates[i] == resource.requestedStates[i]);
+            }
+        }
+        resource.isNeeded = FALSE;
+    }
+
+    void TestRoundTrip()
+    {
+        // A resource moved and moved back within a batch does not move at all.
+        ID3D12Resource resources[2];
+        ResourceStateTracker tracker;
+        tracker.Register(&resources[0], D3D12_RESOURCE_STATE_RENDER_TARGET);
+        tracker.Register(&resources[1], D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+
+        std::vector<D3D12_RESOURCE_BARRIER> barriers;
+        tracker.Transition(&resources[0], D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+        tracker.Transition(&resources[1], D3D12_RESOURCE_STATE_COPY_SOURCE);
+        tracker.Transition(&resources[0], D3D12_RESOURCE_STATE_RENDER_TARGET);
+        tracker.Transition(&resources[1], D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+        tracker.Flush(barriers);
+        CHECK(barriers.empty());
+        CHECK(tracker.GetRequestsNum() == 4 && tracker.GetBarriersNum() == 0);
+
+        // Asked twice in a batch, a resource only moves to the last state.
+        tracker.Transition(&resources[0], D3D12_RESOURCE_STATE_COPY_DEST);
+        tracker.Transition(&resources[0], D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+        tracker.Flush(barriers);
+        CHECK(barriers.size() == 1);
+        CHECK(IsBarrier(barriers[0], &resources[0], D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES,
+            D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_BARRIER_FLAG_NONE));
+
+        CHECK(!tracker.Transition(nullptr, D3D12_RESOURCE_STATE_COPY_DEST));
+    }
+
+    void TestSplitBarriers()
+    {
+        ID3D12Resource resources[2];
+        ResourceStateTracker tracker;
+        tracker.Register(&resources[0], D3D12_RESOURCE_STATE_PRESENT);
+        tracker.Register(&resources[1], D3D12_RESOURCE_STATE_RENDER_TARGET);
+
+        // A split is begun with the next batch, and ended when the command list finishes.
+        std::vector<D3D12_RESOURCE_BARRIER> barriers;
+        tracker.BeginTransition(&resources[0], D3D12_RESOURCE_STATE_RENDER_TARGET);
+        tracker.Flush(barriers);
+        CHECK(barriers.size() == 1);
+        CHECK(IsBarrier(barriers[0], &resources[0], D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES,
+            D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY));
+        barriers.clear();
+        tracker.Finish(barriers);
+        CHECK(barriers.size() == 1);
+        CHECK(IsBarrier(barriers[0], &resources[0], D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES,
+            D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_BARRIER_FLAG_END_ONLY));
+
+        // Requested again, the resource ends its split early, in the batch of the work that needs it, and
+        // before the transition of that request.
+        barriers.clear();
+        tracker.BeginTransition(&resources[0], D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+        tracker.Transition(&resources[1], D3D12_RESOURCE_STATE_COPY_SOURCE);
+        tracker.Flush(barriers);
+        CHECK(barriers.size() == 2);
+        CHECK(barriers[0].Flags == D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY);
+        barriers.clear();
+        tracker.Transition(&resources[0], D3D12_RESOURCE_STATE_COPY_DEST);
+        tracker.Flush(barriers);
+        CHECK(barriers.size() == 2);
+        CHECK(IsBarrier(barriers[0], &resources[0], D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES,
+            D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_BARRIER_FLAG_END_ONLY));
+        CHECK(IsBarrier(barriers[1], &resources[0], D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES,
+            D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_BARRIER_FLAG_NONE));
+        barriers.clear();
+        tracker.Finish(barriers);
+        CHECK(barriers.empty());
+
+        // A split requested in the same batch as the work that needs it is not split.
+        tracker.BeginTransition(&resources[1], D3D12_RESOURCE_STATE_RENDER_TARGET);
+        tracker.Transition(&resources[1], D3D12_RESOURCE_STATE_RENDER_TARGET);
+        tracker.Flush(barriers);
+        CHECK(barriers.size() == 1 && barriers[0].Flags == D3D12_RESOURCE_BARRIER_FLAG_NONE);
+    }
+
+    void TestSubresources()
+    {
+        ID3D12Resource texture;
+        ResourceStateTracker tracker;
+        tracker.Register(&texture, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, 4);
+
+        // Mips written one after another each get a barrier of their own.
+        std::vector<D3D12_RESOURCE_BARRIER> barriers;
+        tracker.Transition(&texture, D3D12_RESOURCE_STATE_COPY_DEST, 1);
+        tracker.Transition(&texture, D3D12_RESOURCE_STATE_COPY_DEST, 3);
+        tracker.Flush(barriers);
+        CHECK(barriers.size() == 2);
+        CHECK(IsBarrier(barriers[0], &texture, 1,
+            D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_BARRIER_FLAG_NONE));
+        CHECK(IsBarrier(barriers[1], &texture, 3,
+            D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_BARRIER_FLAG_NONE));
+
+        // The whole resource from mixed states moves one subresource at a time, and from one state at once.
+        barriers.clear();
+        tracker.Transition(&texture, D3D12_RESOURCE_STATE_COPY_SOURCE);
+        tracker.Flush(barriers);
+        CHECK(barriers.size() == 4);
+        for (UINT i = 0; i < 4; i++)
+        {
+            CHECK(barriers[i].Transition.Subresource == i);
+            CHECK(barriers[i].Transition.StateAfter == D3D12_RESOURCE_STATE_COPY_SOURCE);
+        }
+        barriers.clear();
+        tracker.Transition(&texture, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+        tracker.Flush(barriers);
+        CHECK(barriers.size() == 1 && barriers[0].Transition.Subresource == D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES);
+
+        CHECK(!tracker.Transition(&texture, D3D12_RESOURCE_STATE_COPY_DEST, 4));
+    }
+
+    void TestRandom()
+    {
+        // Random requests, batches and registrations over a few resources, checked against the states the
+        // barriers leave the resources in.
+        const D3D12_RESOURCE_STATES states[] =
+        {
+            D3D12_RESOURCE_STATE_COMMON,
+            D3D12_RESOURCE_STATE_RENDER_TARGET,
+            D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
+            D3D12_RESOURCE_STATE_COPY_DEST,
+            D3D12_RESOURCE_STATE_COPY_SOURCE,
+            D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+        };
+        ID3D12Resource resources[8];
+        for (UINT seed = 1; seed <= 300; seed++)
+        {
+            std::mt19937 random(seed);
+            ResourceStateTracker tracker;
+            std::map<ID3D12Resource*, SimulatedResource> simulatedResources;
+            std::vector<D3D12_RESOURCE_BARRIER> barriers;
+            for (UINT i = 0; i < 4000; i++)
+            {
+                ID3D12Resource* pResource = &resources[random() % _countof(resources)];
+                auto it = simulatedResources.find(pResource);
+                const UINT operation = random() % 100;
+                const D3D12_RESOURCE_STATES state = states[random() % _countof(states)];
+                barriers.clear();
+                if (operation < 4)
+                {
+                    const UINT subresourcesNum = 1 + random() % 4;
+                    tracker.Register(pResource, state, subresourcesNum);
+                    SimulatedResource& resource = simulatedResources[pResource];
+                    resource.states.assign(subresourcesNum, state);
+                    resource.isSplit.assign(subresourcesNum, FALSE);
+                    resource.splitStates.assign(subresourcesNum, state);
+                    resource.requestedStates.assign(subresourcesNum, state);
+                    resource.isNeeded = FALSE;
+                }
+                else if (operation < 6)
+                {
+                    tracker.Unregister(pResource);
+                    simulatedResources.erase(pResource);
+                    CHECK(!tracker.IsRegistered(pResource));
+                }
+                else if (operation < 50)
+                {
+                    const BOOL isWhole = random() % 2 == 0;
+                    const UINT subresource = isWhole ? D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES : random() % 5;
+                    const BOOL isRequested = tracker.Transition(pResource, state, subresource);
+                    if (it == simulatedResources.end() || (!isWhole && subresource >= it->second.states.size()))
+                    {
+                        CHECK(!isRequested || it != simulatedResources.end());
+                        if (it != simulatedResources.end())
+                        {
+                            it->second.isNeeded = TRUE;
+                        }
+                        continue;
+                    }
+
+                    CHECK(isRequested);
+                    if (isWhole)
+                    {
+                        std::fill(it->second.requestedStates.begin(), it->second.requestedStates.end(), state);
+                    }
+                    else
+                    {
+                        it->second.requestedStates[subresource] = state;
+                    }
+                    it->second.isNeeded = TRUE;
+                }
+                else if (operation < 62)
+                {
+                    CHECK(tracker.BeginTransition(pResource, state) == (it != simulatedResources.end()));
+                    if (it != simulatedResources.end())
+                    {
+                        std::fill(it->second.requestedStates.begin(), it->second.requestedStates.end(), state);
+                    }
+                }
+                else if (operation < 80)
+                {
+                    tracker.Flush(barriers);
+                    Apply(barriers, simulatedResources);
+                    for (auto& resource : simulatedResources)
+                    {
+                        CheckRequestedStates(resource.second, FALSE);
+                    }
+                }
+                else if (operation < 95)
+                {
+                    // The batch of a copy only flushes its resources.
+                    ID3D12Resource* pResources[] = { pResource, &resources[random() % _countof(resources)] };
+                    tracker.Flush(barriers, pResources, _countof(pResources));
+                    Apply(barriers, simulatedResources);
+                    for (ID3D12Resource* pCopyResource : pResources)
+                    {
+                        auto copyIt = simulatedResources.find(pCopyResource);
+                        if (copyIt != simulatedResources.end())
+                        {
+                            CheckRequestedStates(copyIt->second, FALSE);
+                        }
+                    }
+                }
+                else
+                {
+                    tracker.Finish(barriers);
+                    Apply(barriers, simulatedResources);
+                    for (auto& resource : simulatedResources)
+                    {
+                        CheckRequestedStates(resource.second, TRUE);
+                    }
+                }
+            }
+
+            barriers.clear();
+            tracker.Finish(barriers);
+            Apply(barriers, simulatedResources);
+            for (auto& resource : simulatedResources)
+            {
+                CheckRequestedStates(resource.second, TRUE);
+            }
+        }
+    }
+}
+
+int main()
+{
+    TestRoundTrip();
+    TestSplitBarriers();
+    TestSubresources();
+    TestRandom();
+
+    printf("ResourceStateTrackerTest passed.\n");
+    return 0;
+}
@@ -0,0 +1,126 @@
+#include "stdafx.h"
+#include "RingAllocator.h"
+#include "TestHelper.h"
+
+namespace
+{
+    struct Allocation
+    {
+        UINT64 offset;
+        UINT64 size;
+        UINT64 fenceValue;
+    };
+
+    BOOL IsOverlapping(const Allocation& a, const Allocation& b)
+    {
+        return a.size > 0 && b.size > 0 && a.offset < b.offset + b.size && b.offset < a.offset + a.size;
+    }
+
+    void TestWrap()
+    {
+        RingAllocator ring(1000);
+        UINT64 offset = 0;
+        CHECK(ring.Allocate(600, 1, offset) && offset == 0);
+        ring.Retire(1);
+        CHECK(!ring.Allocate(600, 1, offset));
+        CHECK(ring.Allocate(300, 1, offset) && offset == 600);
+        ring.Retire(2);
+
+        // Once the first batch is released the ring wraps, and skips the 100 bytes left at its end.
+        ring.Release(1);
+        CHECK(ring.Allocate(500, 1, offset) && offset == 0);
+        CHECK(ring.GetUsedSize() == 300 + 100 + 500);
+        ring.Retire(3);
+        ring.Release(2);
+        CHECK(ring.GetUsedSize() == 600);
+        ring.Release(3);
+        CHECK(ring.GetUsedSize() == 0);
+    }
+
+    void TestAlignment()
+    {
+        RingAllocator ring(4096);
+        UINT64 offset = 0;
+        CHECK(ring.Allocate(10, 1, offset) && offset == 0);
+        CHECK(ring.Allocate(10, 256, offset) && offset == 256);
+        CHECK(ring.GetUsedSize() == 266);
+        CHECK(!ring.Allocate(4096, 1, offset));
+        CHECK(ring.Allocate(0, 16, offset) && offset == 272);
+
+        // An empty ring takes a whole capacity allocation.
+        ring.Retire(1);
+        ring.Release(1);
+        CHECK(ring.GetUsedSize() == 0);
+        CHECK(ring.Allocate(4096, 256, offset) && offset == 0);
+    }
+
+    void TestRandom()
+    {
+        // Frames allocate, retire, and are released by a GPU that lags 0 to 3 frames behind. Allocations in
+        // use never overlap, and the ring is empty once the GPU has caught up.
+        std::mt19937 random(1);
+        for (UINT trial = 0; trial < 200; trial++)
+        {
+            const UINT64 capacity = 1024 + random() % 100000;
+            RingAllocator ring(capacity);
+            std::vector<Allocation> allocations;
+            UINT64 fenceValue = 0;
+            UINT64 completedFenceValue = 0;
+            for (UINT frame = 0; frame < 2000; frame++)
+            {
+                const UINT allocationsNum = random() % 6;
+                for (UINT i = 0; i < allocationsNum; i++)
+                {
+                    const UINT64 size = random() % (capacity / 3 + 1);
+                    const UINT64 alignment = 1ull << (random() % 10);
+                    UINT64 offset = 0;
+                    if (!ring.Allocate(size, alignment, offset))
+                    {
+                        continue;
+                    }
+
+                    const Allocation allocation = { offset, size, UINT64_MAX };
+                    CHECK(offset % alignment == 0 && offset + size <= capacity);
+                    for (const Allocation& other : allocations)
+                    {
+                        CHECK(!IsOverlapping(allocation, other));
+                    }
+                    allocations.push_back(allocation);
+                }
+
+                ring.Retire(++fenceValue);
+                for (Allocation& allocation : allocations)
+                {
+                    allocation.fenceValue = min(allocation.fenceValue, fenceValue);
+                }
+
+                const UINT64 lag = random() % 4;
+                if (fenceValue > lag)
+                {
+                    completedFenceValue = max(completedFenceValue, fenceValue - lag);
+                }
+                ring.Release(completedFenceValue);
+                allocations.erase(std::remove_if(allocations.begin(), allocations.end(),
+                    [completedFenceValue](const Allocation& allocation) { return allocation.fenceValue <= completedFenceValue; }),
+                    allocations.end());
+                CHECK(ring.GetUsedSize() <= capacity);
+                CHECK(!allocations.empty() || ring.GetUsedSize() == 0);
+            }
+
+            ring.Release(fenceValue);
+            CHECK(ring.GetUsedSize() == 0);
+            UINT64 offset = 0;
+            CHECK(ring.Allocate(capacity, 256, offset) && offset == 0);
+        }
+    }
+}
+
+int main()
+{
+    TestWrap();
+    TestAlignment();
+    TestRandom();
+
+    printf("RingAllocatorTest passed.\n");
+    return 0;
+}
@@ -0,0 +1,98 @@
+#include "stdafx.h"
+#include "MappedFile.h"
+#include "SceneManifest.h"
+#include "TestHelper.h"
+
+namespace
+{
+    void WriteText(const std::wstring& path, const std::string& text)
+    {
+        CHECK(MappedFile::Write(path, text.data(), text.size()));
+    }
+
+    void RemoveFile(const std::wstring& path)
+    {
+#ifdef _WIN32
+        _wremove(path.c_str());
+#else
+        remove(MappedFile::ToUTF8(path).c_str());
+#endif
+    }
+
+    void TestObjects()
+    {
+        WriteText(L"SceneManifestTest.png", "png");
+        WriteText(L"SceneManifestTest.fbx", "fbx");
+        WriteText(L"SceneManifestTest",
+            "1\nSceneManifestTest.png\n1\nSceneManifestTest.fbx\n2\n"
+            "0 0 1 2 3 0 90 0 1 1 1\n"
+            "0 0 -1 0 0 0 0 0 2 2 2\n");
+
+        SceneManifest manifest;
+        CHECK(SceneManifest::Convert(L"SceneManifestTest", L"SceneManifestTest.bin", 7));
+        CHECK(manifest.Load(L"SceneManifestTest.bin", 7));
+        CHECK(manifest.GetRehashedAssetsNum() == 0);
+        CHECK(manifest.GetMaterialsNum() == 1);
+        CHECK(manifest.GetMeshesNum() == 1);
+        CHECK(manifest.GetObjectsNum() == 2);
+        CHECK(std::wstring(manifest.GetName(manifest.GetMesh(0))) == L"SceneManifestTest.fbx");
+        CHECK(manifest.GetMesh(0).contentHash == SceneManifest::HashFile(L"SceneManifestTest.fbx"));
+
+        // A yaw of 90 degrees turns around y.
+        const SceneManifestObject& object = manifest.GetSceneObject(0);
+        CHECK(object.position.x == 1.0f && object.position.y == 2.0f && object.position.z == 3.0f);
+        CHECK(fabsf(object.rotation.y - sqrtf(0.5f)) < 1e-6f && fabsf(object.rotation.w - sqrtf(0.5f)) < 1e-6f);
+        CHECK(manifest.GetSceneObject(1).scale.y == 2.0f);
+
+        // A manifest converted from another text scene is stale.
+        SceneManifest stale;
+        CHECK(!stale.Load(L"SceneManifestTest.bin", 8));
+    }
+
+    void TestChangedAssets()
+    {
+        // The content of an asset that changed is hashed again on load, and the manifest is written back.
+        WriteText(L"SceneManifestTest.fbx", "fbx, edited");
+        SceneManifest manifest;
+        CHECK(manifest.Load(L"SceneManifestTest.bin", 7));
+        CHECK(manifest.GetRehashedAssetsNum() == 1);
+        CHECK(manifest.GetMesh(0).contentHash == SceneManifest::HashFile(L"SceneManifestTest.fbx"));
+        CHECK(manifest.Load(L"SceneManifestTest.bin", 7));
+        CHECK(manifest.GetRehashedAssetsNum() == 0);
+        CHECK(manifest.GetMesh(0).contentHash == SceneManifest::HashFile(L"SceneManifestTest.fbx"));
+
+        // A missing asset has no hash.
+        RemoveFile(L"SceneManifestTest.png");
+        CHECK(manifest.Load(L"SceneManifestTest.bin", 7));
+        CHECK(manifest.GetRehashedAssetsNum() == 1);
+        CHECK(manifest.GetMaterial(0).contentHash == 0);
+    }
+
+    void TestDefaultObjects()
+    {
+        // Without objects every mesh is placed once, with the material of the same name.
+        WriteText(L"SceneManifestTest", "2\nwall.png\nground.png\n2\nground.fbx\nother.fbx\n");
+        SceneManifest manifest;
+        CHECK(SceneManifest::Convert(L"SceneManifestTest", L"SceneManifestTest.bin", 9));
+        CHECK(manifest.Load(L"SceneManifestTest.bin", 9));
+        CHECK(manifest.GetObjectsNum() == 2);
+        CHECK(manifest.GetSceneObject(0).meshIndex == 0 && manifest.GetSceneObject(0).materialIndex == 1);
+        CHECK(manifest.GetSceneObject(1).meshIndex == 1 && manifest.GetSceneObject(1).materialIndex == 0);
+        CHECK(manifest.GetSceneObject(1).rotation.w == 1.0f);
+    }
+}
+
+int main()
+{
+    TestObjects();
+    TestChangedAssets();
+    TestDefaultObjects();
+
+    RemoveFile(L"SceneManifestTest");
+    RemoveFile(L"SceneManifestTest.bin");
+    RemoveFile(L"SceneManifestTest.png");
+    RemoveFile(L"SceneManifestTest.fbx");
+
+    printf("SceneManifestTest passed.\n");
+    return 0;
+}
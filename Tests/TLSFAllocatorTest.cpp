@@ -0,0 +1,128 @@
+#include "stdafx.h"
+#include "TLSFAllocator.h"
+#include "TestHelper.h"
+#include <map>
+
+namespace
+{
+    void TestMerge()
+    {
+        TLSFAllocator allocator(1000, 64);
+        TLSFAllocation a, b, c;
+        CHECK(allocator.GetCapacity() == 960);
+        CHECK(allocator.Allocate(100, 1, a) && a.offset == 0 && a.size == 128);
+        CHECK(allocator.Allocate(128, 1, b) && b.offset == 128);
+        CHECK(allocator.Allocate(128, 1, c) && c.offset == 256);
+        CHECK(allocator.GetUsedSize() == 384 && allocator.GetAllocationsNum() == 3);
+        CHECK(allocator.GetLargestFreeSize() == 576);
+
+        // A freed range merges with the free ranges on both of its sides.
+        allocator.Free(a);
+        CHECK(allocator.GetLargestFreeSize() == 576);
+        allocator.Free(c);
+        CHECK(allocator.GetLargestFreeSize() == 704);
+        allocator.Free(b);
+        CHECK(allocator.IsEmpty() && allocator.GetUsedSize() == 0);
+        CHECK(allocator.GetLargestFreeSize() == 960);
+
+        CHECK(allocator.Allocate(960, 1, a) && a.offset == 0);
+        CHECK(!allocator.Allocate(1, 1, b));
+    }
+
+    void TestAlignment()
+    {
+        TLSFAllocator allocator(1 << 20, 1 << 10);
+        TLSFAllocation a, b;
+        CHECK(allocator.Allocate(1, 1, a) && a.offset == 0 && a.size == 1 << 10);
+        CHECK(allocator.Allocate(1, 1 << 16, b) && b.offset == 1 << 16);
+
+        // The padding in front of the aligned range stays free, and is found once the rest is taken even
+        // though its class is not above the size.
+        TLSFAllocation c, d;
+        CHECK(allocator.Allocate((1 << 20) - (65 << 10), 1, c) && c.offset == 65 << 10);
+        CHECK(allocator.GetLargestFreeSize() == 63 << 10);
+        CHECK(allocator.Allocate(63 << 10, 1, d) && d.offset == 1 << 10);
+        CHECK(allocator.GetUsedSize() == 1 << 20 && allocator.GetLargestFreeSize() == 0);
+    }
+
+    void TestRandom()
+    {
+        // Random allocations and frees checked against a map of the live ranges: they are aligned, never
+        // overlap, and an allocation without alignment only fails when no free range is large enough.
+        std::mt19937_64 random(7);
+        for (UINT trial = 0; trial < 300; trial++)
+        {
+            const UINT64 granularity = 1ull << (random() % 17);
+            const UINT64 capacity = granularity * (1 + random() % 5000);
+            TLSFAllocator allocator(capacity, granularity);
+            std::map<UINT64, TLSFAllocation> allocations;
+            UINT64 usedSize = 0;
+            for (UINT i = 0; i < 3000; i++)
+            {
+                if (!allocations.empty() && random() % 100 >= 55)
+                {
+                    auto it = allocations.begin();
+                    std::advance(it, random() % allocations.size());
+                    usedSize -= it->second.size;
+                    allocator.Free(it->second);
+                    allocations.erase(it);
+                    CHECK(allocator.GetUsedSize() == usedSize);
+                    continue;
+                }
+
+                const UINT64 size = 1 + random() % (capacity / (1 + random() % 50) + 1);
+                const UINT64 alignment = 1ull << (random() % 20);
+                TLSFAllocation allocation;
+                if (allocator.Allocate(size, alignment, allocation))
+                {
+                    CHECK(allocation.offset % max(alignment, granularity) == 0);
+                    CHECK(allocation.size >= size && allocation.size % granularity == 0);
+                    CHECK(allocation.offset + allocation.size <= capacity);
+                    auto it = allocations.lower_bound(allocation.offset);
+                    if (it != allocations.end())
+                    {
+                        CHECK(allocation.offset + allocation.size <= it->first);
+                    }
+                    if (it != allocations.begin())
+                    {
+                        it--;
+                        CHECK(it->second.offset + it->second.size <= allocation.offset);
+                    }
+                    allocations[allocation.offset] = allocation;
+                    usedSize += allocation.size;
+                }
+                else if (alignment <= granularity)
+                {
+                    UINT64 end = 0;
+                    UINT64 largestFreeSize = 0;
+                    for (const auto& live : allocations)
+                    {
+                        largestFreeSize = max(largestFreeSize, live.first - end);
+                        end = live.first + live.second.size;
+                    }
+                    largestFreeSize = max(largestFreeSize, capacity - end);
+                    CHECK(allocator.GetLargestFreeSize() == largestFreeSize);
+                    CHECK(largestFreeSize < max((size + granularity - 1) / granularity * granularity, granularity));
+                }
+                CHECK(allocator.GetUsedSize() == usedSize);
+            }
+
+            for (const auto& live : allocations)
+            {
+                allocator.Free(live.second);
+            }
+            CHECK(allocator.IsEmpty() && allocator.GetUsedSize() == 0);
+            CHECK(allocator.GetLargestFreeSize() == allocator.GetCapacity());
+        }
+    }
+}
+
+int main()
+{
+    TestMerge();
+    TestAlignment();
+    TestRandom();
+
+    printf("TLSFAllocatorTest passed.\n");
+    return 0;
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <cstdio>
+#include <cstdlib>
+
+// Fail the test with the file, line and condition when the condition does not hold.
+#define CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            fprintf(stderr, "%s(%d): CHECK(%s) failed.\n", __FILE__, __LINE__, #condition); \
+            exit(1); \
+        } \
+    } while (0)
+
+// A grid of size x size quads in the xy plane with UVs over the whole grid, as two triangles per quad.
+inline void CreateGrid(UINT size, std::vector<Vertex>& vertices, std::vector<UINT>& indices)
+{
+    vertices.clear();
+    indices.clear();
+    for (UINT y = 0; y <= size; y++)
+    {
+        for (UINT x = 0; x <= size; x++)
+        {
+            const FLOAT u = static_cast<FLOAT>(x) / size;
+            const FLOAT v = static_cast<FLOAT>(y) / size;
+            vertices.push_back({ XMFLOAT3(u * 2.0f - 1.0f, v * 2.0f - 1.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 1.0f),
+                XMFLOAT4(1.0f, 0.0f, 0.0f, 1.0f), XMFLOAT2(u, v), XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f) });
+        }
+    }
+
+    for (UINT y = 0; y < size; y++)
+    {
+        for (UINT x = 0; x < size; x++)
+        {
+            const UINT i = y * (size + 1) + x;
+            indices.insert(indices.end(), { i, i + 1, i + size + 2, i, i + size + 2, i + size + 1 });
+        }
+    }
+}
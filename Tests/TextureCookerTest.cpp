@@ -0,0 +1,87 @@
+#include "stdafx.h"
+#include "TextureCooker.h"
+#include "TestHelper.h"
+
+namespace
+{
+    void RemoveFile(const std::wstring& path)
+    {
+#ifdef _WIN32
+        _wremove(path.c_str());
+#else
+        remove(MappedFile::ToUTF8(path).c_str());
+#endif
+    }
+
+    void TestBlockFormat()
+    {
+        CHECK(TextureCooker::GetBlockFormat(L"Textures\\wall_n.png") == TextureBlockFormat::BC5);
+        CHECK(TextureCooker::GetBlockFormat(L"Textures/wall_mra.png") == TextureBlockFormat::BC1);
+        CHECK(TextureCooker::GetBlockFormat(L"wall.png") == TextureBlockFormat::BC7);
+        CHECK(TextureCooker::GetBlockFormat(L"default_n_mip64.png") == TextureBlockFormat::BC5);
+        CHECK(TextureCooker::GetBlockFormat(L"default_mra_mip64.png") == TextureBlockFormat::BC1);
+
+        // The suffix only counts at the end of the name.
+        CHECK(TextureCooker::GetBlockFormat(L"wall_n_detail.png") == TextureBlockFormat::BC7);
+        CHECK(TextureCooker::GetBlockFormat(L"my_normal_n_old.png") == TextureBlockFormat::BC7);
+        CHECK(TextureCooker::GetBlockFormat(L"terrain_mra_blend.png") == TextureBlockFormat::BC7);
+        CHECK(TextureCooker::GetBlockFormat(L"wall_n_mipmap.png") == TextureBlockFormat::BC7);
+        CHECK(TextureCooker::GetBlockFormat(L"wall_n\\albedo.png") == TextureBlockFormat::BC7);
+        CHECK(TextureCooker::GetBlockFormat(L"_mip8.png") == TextureBlockFormat::BC7);
+    }
+
+    void TestCook()
+    {
+        const UINT width = 16;
+        const UINT height = 8;
+        std::vector<BYTE> pixels(width * height * 4);
+        for (UINT i = 0; i < pixels.size(); i++)
+        {
+            pixels[i] = static_cast<BYTE>(i * 7);
+        }
+
+        const std::wstring cachePath = TextureCooker::GetCachePath(L"TextureCookerTest.png");
+        CHECK(cachePath == L"TextureCookerTest.dds");
+        CHECK(!TextureCooker::CanCook(6, 8));
+        CHECK(!TextureCooker::Cook(cachePath, 5, pixels.data(), 6, 8, TextureBlockFormat::BC1));
+        CHECK(TextureCooker::Cook(cachePath, 5, pixels.data(), width, height, TextureBlockFormat::BC1));
+
+        CookedTexture texture = {};
+        CHECK(TextureCooker::Map(cachePath, 5, texture));
+        CHECK(texture.width == width && texture.height == height);
+        CHECK(texture.dxgiFormat == TextureCompressor::GetDXGIFormat(TextureBlockFormat::BC1));
+        CHECK(texture.levels.size() == MipGenerator::GetMipLevelsNum(width, height));
+        CHECK(static_cast<UINT64>(texture.levels[1] - texture.levels[0])
+            == TextureCompressor::GetCompressedSize(width, height, TextureBlockFormat::BC1));
+        TextureCooker::Unmap(texture);
+        CHECK(texture.pView == nullptr && texture.levels.empty());
+
+        // A cache of another source is a miss, any source accepts it.
+        CHECK(!TextureCooker::Map(cachePath, 6, texture));
+        CHECK(texture.pView == nullptr);
+        CHECK(TextureCooker::Map(cachePath, 0, texture));
+        TextureCooker::Unmap(texture);
+
+        // So is a truncated one.
+        std::vector<BYTE> data;
+        {
+            MappedFile file;
+            CHECK(file.Open(cachePath));
+            data.assign(file.GetData(), file.GetData() + file.GetSize() - 1);
+        }
+        CHECK(MappedFile::Write(cachePath, data.data(), data.size()));
+        CHECK(!TextureCooker::Map(cachePath, 5, texture));
+
+        RemoveFile(cachePath);
+        CHECK(!TextureCooker::Map(cachePath, 5, texture));
+    }
+}
+
+int main()
+{
+    TestBlockFormat();
+    TestCook();
+
+    printf("TextureCookerTest passed.\n");
+    return 0;
+}
@@ -0,0 +1,257 @@
+#include "stdafx.h"
+#include "TextureStreamingPolicy.h"
+#include "TestHelper.h"
+
+namespace
+{
+    const UINT64 kTileSize = 65536;
+
+    BOOL IsAction(const TextureStreamingAction& action, TextureStreamingActionType type, UINT texture, UINT mip)
+    {
+        return action.type == type && action.texture == texture && action.mip == mip;
+    }
+
+    void TestLoadOrder()
+    {
+        // Textures missing the most levels load first, the lower handle first on a tie, one level at a time.
+        const UINT64 mipSizes[] = { 16 * kTileSize, 4 * kTileSize, kTileSize, kTileSize };
+        TextureStreamingPolicy policy(UINT64_MAX, 2);
+        for (UINT i = 0; i < 3; i++)
+        {
+            CHECK(policy.Register(mipSizes, _countof(mipSizes), 3) == i);
+        }
+        CHECK(policy.GetResidentBytes() == 3 * kTileSize);
+
+        std::vector<TextureStreamingAction> actions;
+        for (UINT64 frame = 0; frame < 2; frame++)
+        {
+            policy.Request(0, 2, frame);
+            policy.Request(1, 1, frame);
+            policy.Request(1, 0, frame);
+            policy.Request(2, 0, frame);
+            policy.Update(frame, actions);
+            CHECK(actions.size() == 2);
+            CHECK(IsAction(actions[0], TextureStreamingActionType::Load, 1, static_cast<UINT>(2 - frame)));
+            CHECK(IsAction(actions[1], TextureStreamingActionType::Load, 2, static_cast<UINT>(2 - frame)));
+        }
+
+        // Texture 0 misses as many levels as the others now, and comes first.
+        policy.Request(0, 2, 2);
+        policy.Request(1, 0, 2);
+        policy.Request(2, 0, 2);
+        policy.Update(2, actions);
+        CHECK(actions.size() == 2);
+        CHECK(IsAction(actions[0], TextureStreamingActionType::Load, 0, 2));
+        CHECK(IsAction(actions[1], TextureStreamingActionType::Load, 1, 0));
+        CHECK(policy.GetResidentMip(0) == 2 && policy.GetResidentMip(1) == 0 && policy.GetResidentMip(2) == 1);
+
+        // Levels that are no longer requested stay resident while there is room.
+        policy.Update(3, actions);
+        CHECK(actions.empty());
+        CHECK(policy.GetResidentMip(1) == 0);
+    }
+
+    void TestEvictionOrder()
+    {
+        // The least recently requested texture gives up its levels first.
+        const UINT64 mipSizes[] = { 2 * kTileSize, kTileSize };
+        TextureStreamingPolicy policy(7 * kTileSize);
+        for (UINT i = 0; i < 3; i++)
+        {
+            policy.Register(mipSizes, _countof(mipSizes), 1);
+        }
+
+        std::vector<TextureStreamingAction> actions;
+        policy.Request(0, 0, 0);
+        policy.Update(0, actions);
+        policy.Request(1, 0, 1);
+        policy.Update(1, actions);
+        CHECK(policy.GetResidentBytes() == 7 * kTileSize);
+
+        policy.Request(2, 0, 2);
+        policy.Update(2, actions);
+        CHECK(actions.size() == 2);
+        CHECK(IsAction(actions[0], TextureStreamingActionType::Evict, 0, 0));
+        CHECK(IsAction(actions[1], TextureStreamingActionType::Load, 2, 0));
+
+        // Wanted levels are not evicted for a load.
+        policy.Request(1, 0, 3);
+        policy.Request(2, 0, 3);
+        policy.Request(0, 0, 3);
+        policy.Update(3, actions);
+        CHECK(actions.empty());
+        CHECK(policy.GetResidentMip(0) == 1);
+    }
+
+    void TestBudget()
+    {
+        const UINT64 mipSizes[] = { 4 * kTileSize, 2 * kTileSize, kTileSize };
+        TextureStreamingPolicy policy(8 * kTileSize);
+        policy.Register(mipSizes, _countof(mipSizes), 2);
+        policy.Register(mipSizes, _countof(mipSizes), 2);
+
+        std::vector<TextureStreamingAction> actions;
+        policy.Request(0, 0, 0);
+        policy.Update(0, actions);
+        policy.Request(0, 0, 1);
+        policy.Update(1, actions);
+        CHECK(policy.GetResidentMip(0) == 0 && policy.GetResidentBytes() == 8 * kTileSize);
+
+        // Room for a load is made from levels that are no longer requested.
+        policy.Request(1, 1, 2);
+        policy.Update(2, actions);
+        CHECK(actions.size() == 2);
+        CHECK(IsAction(actions[0], TextureStreamingActionType::Evict, 0, 0));
+        CHECK(IsAction(actions[1], TextureStreamingActionType::Load, 1, 1));
+
+        // A lower budget drops the levels that are not wanted first, then the wanted ones, never the tail.
+        policy.SetBudget(3 * kTileSize);
+        policy.Request(1, 1, 3);
+        policy.Update(3, actions);
+        CHECK(actions.size() == 2);
+        CHECK(IsAction(actions[0], TextureStreamingActionType::Evict, 0, 1));
+        CHECK(IsAction(actions[1], TextureStreamingActionType::Evict, 1, 1));
+        CHECK(policy.GetResidentBytes() == 2 * kTileSize);
+
+        policy.SetBudget(kTileSize);
+        policy.Update(4, actions);
+        CHECK(actions.empty());
+        CHECK(policy.GetResidentBytes() == 2 * kTileSize);
+    }
+
+    void TestUnregister()
+    {
+        const UINT64 mipSizes[] = { 2 * kTileSize, kTileSize };
+        TextureStreamingPolicy policy(UINT64_MAX);
+        const UINT texture = policy.Register(mipSizes, _countof(mipSizes), 1);
+        std::vector<TextureStreamingAction> actions;
+        policy.Request(texture, 0, 0);
+        policy.Update(0, actions);
+        CHECK(policy.GetResidentBytes() == 3 * kTileSize);
+
+        policy.Unregister(texture);
+        CHECK(policy.GetResidentBytes() == 0);
+        policy.Update(1, actions);
+        CHECK(actions.empty());
+        CHECK(policy.Register(mipSizes, _countof(mipSizes), 1) == texture);
+    }
+
+    // A camera sweeping past textures of 256 to 2048 texels, which ask for finer mips the closer they are.
+    // Checks every action against a model of the resident levels, and returns all of them.
+    std::vector<TextureStreamingAction> Simulate(UINT64 budget, UINT seed, UINT framesNum)
+    {
+        const UINT texturesNum = 40;
+        std::mt19937 random(seed);
+        TextureStreamingPolicy policy(budget);
+        std::vector<std::vector<UINT64>> mipSizes(texturesNum);
+        std::vector<UINT> tailMips(texturesNum);
+        std::vector<UINT> residentMips(texturesNum);
+        for (UINT i = 0; i < texturesNum; i++)
+        {
+            // Mips of 128 texels and less fit in the packed tail.
+            const UINT mipsNum = 9 + random() % 4;
+            for (UINT mip = 0; mip < mipsNum; mip++)
+            {
+                mipSizes[i].push_back(mip < mipsNum - 8 ? (1ull << (2 * (mipsNum - 9 - mip))) * kTileSize : 0);
+            }
+            tailMips[i] = mipsNum - 8;
+            residentMips[i] = tailMips[i];
+            CHECK(policy.Register(mipSizes[i].data(), mipsNum, tailMips[i]) == i);
+        }
+
+        std::vector<TextureStreamingAction> allActions;
+        std::vector<TextureStreamingAction> actions;
+        FLOAT camera = 0.0f;
+        for (UINT frame = 0; frame < framesNum; frame++)
+        {
+            camera += 0.37f;
+            for (UINT i = 0; i < texturesNum; i++)
+            {
+                const FLOAT distance = fabsf(fmodf(camera + i * 1.7f, 40.0f) - 20.0f);
+                if (distance > 15.0f)
+                {
+                    continue;
+                }
+                const UINT mip = static_cast<UINT>(distance / 2.0f);
+                policy.Request(i, mip, frame);
+                if (random() % 3 == 0)
+                {
+                    policy.Request(i, mip + 1, frame);
+                }
+            }
+            if (frame == framesNum / 2)
+            {
+                policy.SetBudget(budget / 2);
+            }
+
+            policy.Update(frame, actions);
+            UINT loadsNum = 0;
+            for (const TextureStreamingAction& action : actions)
+            {
+                // Loads go one level finer, evictions drop the finest level.
+                if (action.type == TextureStreamingActionType::Load)
+                {
+                    CHECK(action.mip + 1 == residentMips[action.texture]);
+                    residentMips[action.texture] = action.mip;
+                    loadsNum++;
+                }
+                else
+                {
+                    CHECK(action.mip == residentMips[action.texture]);
+                    residentMips[action.texture] = action.mip + 1;
+                }
+                allActions.push_back(action);
+            }
+            CHECK(loadsNum <= TEXTURE_STREAMING_LOADS_PER_UPDATE);
+
+            UINT64 residentBytes = 0;
+            for (UINT i = 0; i < texturesNum; i++)
+            {
+                CHECK(residentMips[i] <= tailMips[i] && policy.GetResidentMip(i) == residentMips[i]);
+                for (UINT mip = residentMips[i]; mip < mipSizes[i].size(); mip++)
+                {
+                    residentBytes += mipSizes[i][mip];
+                }
+            }
+            CHECK(residentBytes == policy.GetResidentBytes() && residentBytes <= policy.GetBudget());
+        }
+
+        return allActions;
+    }
+
+    void TestSimulation()
+    {
+        const UINT64 budgets[] = { 16ull << 20, 64ull << 20, 1ull << 30 };
+        for (UINT64 budget : budgets)
+        {
+            // The same requests give the same actions.
+            const std::vector<TextureStreamingAction> actions = Simulate(budget, 7, 2000);
+            const std::vector<TextureStreamingAction> otherActions = Simulate(budget, 7, 2000);
+            CHECK(actions.size() == otherActions.size());
+            for (UINT i = 0; i < actions.size(); i++)
+            {
+                CHECK(IsAction(otherActions[i], actions[i].type, actions[i].texture, actions[i].mip));
+            }
+
+            // A budget that holds every level never evicts.
+            BOOL isEvicted = FALSE;
+            for (const TextureStreamingAction& action : actions)
+            {
+                isEvicted |= action.type == TextureStreamingActionType::Evict;
+            }
+            CHECK(budget < (1ull << 30) ? isEvicted : !isEvicted);
+        }
+    }
+}
+
+int main()
+{
+    TestLoadOrder();
+    TestEvictionOrder();
+    TestBudget();
+    TestUnregister();
+    TestSimulation();
+
+    printf("TextureStreamingPolicyTest passed.\n");
+    return 0;
+}
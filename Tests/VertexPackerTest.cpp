@@ -0,0 +1,164 @@
+#include "stdafx.h"
+#include "VertexPacker.h"
+#include "TestHelper.h"
+
+namespace
+{
+    // The angle of 16-bit octahedral directions is within a few thousandths of a degree.
+    const FLOAT kMaxDirectionErrorDegrees = 0.01f;
+
+    // From the sine and the cosine, as the arc cosine of a float loses small angles.
+    FLOAT GetAngleDegrees(const XMFLOAT3& a, const XMFLOAT3& b)
+    {
+        const XMVECTOR unitA = XMVector3Normalize(XMLoadFloat3(&a));
+        const XMVECTOR unitB = XMVector3Normalize(XMLoadFloat3(&b));
+        return XMConvertToDegrees(atan2f(XMVectorGetX(XMVector3Length(XMVector3Cross(unitA, unitB))),
+            XMVectorGetX(XMVector3Dot(unitA, unitB))));
+    }
+
+    XMFLOAT3 GetRandomDirection(std::mt19937& random)
+    {
+        std::uniform_real_distribution<FLOAT> distribution(-1.0f, 1.0f);
+        XMVECTOR direction;
+        do
+        {
+            direction = XMVectorSet(distribution(random), distribution(random), distribution(random), 0.0f);
+        } while (XMVectorGetX(XMVector3LengthSq(direction)) < 0.01f || XMVectorGetX(XMVector3LengthSq(direction)) > 1.0f);
+
+        XMFLOAT3 result;
+        XMStoreFloat3(&result, XMVector3Normalize(direction));
+        return result;
+    }
+
+    // Pack and unpack vertices in the bounds, and check every attribute against the precision of its format.
+    void CheckRoundTrip(const std::vector<Vertex>& vertices, const D3D12_RAYTRACING_AABB& aabb)
+    {
+        XMFLOAT4 scale, offset;
+        VertexPacker::GetPositionDequantization(aabb, scale, offset);
+        const FLOAT halfExtents[3] = { scale.x, scale.y, scale.z };
+        for (const Vertex& vertex : vertices)
+        {
+            const Vertex unpacked = VertexPacker::UnpackVertex(VertexPacker::PackVertex(vertex, scale, offset), scale, offset);
+
+            const FLOAT positions[3] = { vertex.positionOS.x, vertex.positionOS.y, vertex.positionOS.z };
+            const FLOAT unpackedPositions[3] = { unpacked.positionOS.x, unpacked.positionOS.y, unpacked.positionOS.z };
+            for (UINT i = 0; i < 3; i++)
+            {
+                // Half a step of the snorm, with room for the rounding of the offset and the scale.
+                const FLOAT maxError = halfExtents[i] / 32767.0f + fabsf(positions[i]) * 1e-6f;
+                CHECK(fabsf(unpackedPositions[i] - positions[i]) <= maxError);
+            }
+
+            CHECK(GetAngleDegrees(unpacked.normalOS, vertex.normalOS) <= kMaxDirectionErrorDegrees);
+            const XMFLOAT3 tangent = { vertex.tangentOS.x, vertex.tangentOS.y, vertex.tangentOS.z };
+            const XMFLOAT3 unpackedTangent = { unpacked.tangentOS.x, unpacked.tangentOS.y, unpacked.tangentOS.z };
+            CHECK(GetAngleDegrees(unpackedTangent, tangent) <= kMaxDirectionErrorDegrees);
+            CHECK(fabsf(XMVectorGetX(XMVector3Length(XMLoadFloat3(&unpacked.normalOS))) - 1.0f) < 1e-5f);
+            CHECK(unpacked.tangentOS.w == (vertex.tangentOS.w < 0.0f ? -1.0f : 1.0f));
+
+            // Half floats keep 11 significant bits, and are evenly spaced below the smallest normal value.
+            const FLOAT texCoords[2] = { vertex.texCoord.x, vertex.texCoord.y };
+            const FLOAT unpackedTexCoords[2] = { unpacked.texCoord.x, unpacked.texCoord.y };
+            for (UINT i = 0; i < 2; i++)
+            {
+                const FLOAT maxError = max(fabsf(texCoords[i]), 1.0f / 16384.0f) / 2048.0f;
+                CHECK(fabsf(unpackedTexCoords[i] - texCoords[i]) <= maxError);
+            }
+
+            CHECK(unpacked.color.x == 1.0f && unpacked.color.w == 1.0f);
+        }
+    }
+
+    void TestRandomVertices()
+    {
+        std::mt19937 random(1);
+        std::uniform_real_distribution<FLOAT> unit(0.0f, 1.0f);
+        for (UINT i = 0; i < 20; i++)
+        {
+            // Bounds from a millimeter to a kilometer, away from the origin.
+            const FLOAT extent = powf(10.0f, unit(random) * 6.0f - 3.0f);
+            const XMFLOAT3 center = { (unit(random) - 0.5f) * 100.0f, (unit(random) - 0.5f) * 100.0f, unit(random) * 10.0f };
+            const D3D12_RAYTRACING_AABB aabb =
+            {
+                center.x - extent, center.y - extent * 0.5f, center.z - extent * 0.25f,
+                center.x + extent, center.y + extent * 0.5f, center.z + extent * 0.25f,
+            };
+
+            std::vector<Vertex> vertices(2000);
+            for (Vertex& vertex : vertices)
+            {
+                vertex.positionOS = XMFLOAT3(
+                    aabb.MinX + (aabb.MaxX - aabb.MinX) * unit(random),
+                    aabb.MinY + (aabb.MaxY - aabb.MinY) * unit(random),
+                    aabb.MinZ + (aabb.MaxZ - aabb.MinZ) * unit(random));
+                vertex.normalOS = GetRandomDirection(random);
+                const XMFLOAT3 tangent = GetRandomDirection(random);
+                vertex.tangentOS = XMFLOAT4(tangent.x, tangent.y, tangent.z, random() % 2 == 0 ? 1.0f : -1.0f);
+                vertex.texCoord = XMFLOAT2(unit(random) * 4.0f - 2.0f, unit(random));
+                vertex.color = XMFLOAT4(unit(random), unit(random), unit(random), 1.0f);
+            }
+
+            // The corners of the bounds, and the axes and diagonals the octahedral folds are sensitive to.
+            for (UINT corner = 0; corner < 8; corner++)
+            {
+                Vertex vertex = vertices[corner];
+                vertex.positionOS = XMFLOAT3(corner & 1 ? aabb.MaxX : aabb.MinX,
+                    corner & 2 ? aabb.MaxY : aabb.MinY, corner & 4 ? aabb.MaxZ : aabb.MinZ);
+                vertex.normalOS = XMFLOAT3(corner & 1 ? 1.0f : -1.0f, corner & 2 ? 1.0f : -1.0f, corner & 4 ? 1.0f : -1.0f);
+                vertices.push_back(vertex);
+            }
+            const XMFLOAT3 axes[] =
+            {
+                XMFLOAT3(1.0f, 0.0f, 0.0f), XMFLOAT3(-1.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 1.0f, 0.0f),
+                XMFLOAT3(0.0f, -1.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 1.0f), XMFLOAT3(0.0f, 0.0f, -1.0f),
+            };
+            for (const XMFLOAT3& axis : axes)
+            {
+                Vertex vertex = vertices[0];
+                vertex.normalOS = axis;
+                vertex.tangentOS = XMFLOAT4(axis.z, axis.x, axis.y, -1.0f);
+                vertices.push_back(vertex);
+            }
+
+            CheckRoundTrip(vertices, aabb);
+        }
+    }
+
+    void TestFlatBounds()
+    {
+        // A quad in the z = 2 plane and a line along x have bounds without depth, which still decode.
+        std::vector<Vertex> vertices;
+        std::mt19937 random(2);
+        std::uniform_real_distribution<FLOAT> unit(0.0f, 1.0f);
+        for (UINT i = 0; i < 500; i++)
+        {
+            Vertex vertex = {};
+            vertex.positionOS = XMFLOAT3(unit(random) * 2.0f - 1.0f, unit(random) * 2.0f - 1.0f, 2.0f);
+            vertex.normalOS = XMFLOAT3(0.0f, 0.0f, 1.0f);
+            vertex.tangentOS = XMFLOAT4(1.0f, 0.0f, 0.0f, 1.0f);
+            vertex.texCoord = XMFLOAT2(unit(random), unit(random));
+            vertices.push_back(vertex);
+        }
+        CheckRoundTrip(vertices, { -1.0f, -1.0f, 2.0f, 1.0f, 1.0f, 2.0f });
+
+        for (Vertex& vertex : vertices)
+        {
+            vertex.positionOS.y = 0.0f;
+        }
+        CheckRoundTrip(vertices, { -1.0f, 0.0f, 2.0f, 1.0f, 0.0f, 2.0f });
+
+        XMFLOAT4 scale, offset;
+        VertexPacker::GetPositionDequantization({ 3.0f, 3.0f, 3.0f, 3.0f, 3.0f, 3.0f }, scale, offset);
+        CHECK(scale.x > 0.0f && scale.y > 0.0f && scale.z > 0.0f);
+        CHECK(offset.x == 3.0f && offset.y == 3.0f && offset.z == 3.0f);
+    }
+}
+
+int main()
+{
+    TestRandomVertices();
+    TestFlatBounds();
+
+    printf("VertexPackerTest passed.\n");
+    return 0;
+}
@@ -0,0 +1,113 @@
+#include "stdafx.h"
+#include "FBXImporter.h"
+#include "MappedFile.h"
+#include "MeshCache.h"
+#include "SceneManifest.h"
+#include <clocale>
+
+// Cook FBX meshes into the mesh cache ahead of time, keyed the same way the engine keys them, so the engine
+// starts from the cooked files.
+// Usage: MeshCook [-benchmark] <source.fbx>...
+// With -benchmark each mesh is also imported from FBX, loaded from the cache with cold file pages and
+// loaded again with warm ones, and the times are printed.
+namespace
+{
+    typedef std::chrono::high_resolution_clock Clock;
+
+    double GetMilliseconds(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    setlocale(LC_ALL, "");
+
+    BOOL isBenchmark = FALSE;
+    std::vector<std::wstring> sourcePaths;
+    for (INT i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-benchmark") == 0)
+        {
+            isBenchmark = TRUE;
+        }
+        else
+        {
+            // Arguments are in the encoding of the locale.
+            std::wstring path(strlen(argv[i]) + 1, L'\0');
+            const size_t length = mbstowcs(&path[0], argv[i], path.size());
+            path.resize(length != static_cast<size_t>(-1) ? length : 0);
+            sourcePaths.push_back(path);
+        }
+    }
+
+    if (sourcePaths.empty())
+    {
+        printf("Usage: MeshCook [-benchmark] <source.fbx>...\n");
+        return 1;
+    }
+
+    unique_ptr<FBXImporter> importer = std::make_unique<FBXImporter>();
+    importer->InitializeSdkObjects();
+
+    INT result = 0;
+    double importTime = 0.0;
+    std::vector<std::wstring> cachePaths;
+    for (const std::wstring& sourcePath : sourcePaths)
+    {
+        const UINT64 sourceStamp = SceneManifest::HashFile(sourcePath);
+        const std::wstring cachePath = MeshCache::GetCachePath(sourcePath);
+
+        Clock::time_point start = Clock::now();
+        MeshData mesh;
+        if (sourceStamp == 0 || !importer->ImportFBX(sourcePath))
+        {
+            printf("Failed to import %s.\n", MappedFile::ToUTF8(sourcePath).c_str());
+            result = 1;
+            continue;
+        }
+        importer->LoadFBX(&mesh);
+        importTime += GetMilliseconds(start);
+
+        if (!MeshCache::SaveMesh(cachePath, sourceStamp, &mesh, mesh.ComputeBoundingBox()))
+        {
+            printf("Failed to write %s.\n", MappedFile::ToUTF8(cachePath).c_str());
+            result = 1;
+            continue;
+        }
+        cachePaths.push_back(cachePath);
+        printf("Cooked %s.\n", MappedFile::ToUTF8(cachePath).c_str());
+    }
+
+    if (!isBenchmark || cachePaths.empty())
+    {
+        return result;
+    }
+
+    // Cold pages only drop where the platform allows it, see MappedFile::Evict.
+    for (const std::wstring& cachePath : cachePaths)
+    {
+        MappedFile::Evict(cachePath);
+    }
+
+    double loadTimes[2] = {};
+    for (double& loadTime : loadTimes)
+    {
+        Clock::time_point start = Clock::now();
+        for (const std::wstring& cachePath : cachePaths)
+        {
+            MeshData mesh;
+            D3D12_RAYTRACING_AABB boundingBox = {};
+            MeshCache::LoadMesh(cachePath, MESH_CACHE_ANY_SOURCE_STAMP, &mesh, boundingBox);
+        }
+        loadTime = GetMilliseconds(start);
+    }
+
+    printf("%u meshes\n", static_cast<UINT>(cachePaths.size()));
+    printf("import and cook: %9.2f ms\n", importTime);
+    printf("load, cold:     %10.2f ms\n", loadTimes[0]);
+    printf("load, warm:     %10.2f ms\n", loadTimes[1]);
+
+    return result;
+}